@@ -0,0 +1,150 @@
+"""Leitor do anel de frames em memória compartilhada escrito pelo RSXManager.
+
+O layout é o de src/modules/rsx/src/rsx_frame_ring_c.h: um cabeçalho seguido
+de três slots de pixels. Os pixels são usados diretamente no mapeamento,
+sem cópias; a sequência do slot é conferida depois do blit para descartar
+frames sobrescritos durante a leitura.
+"""
+import mmap
+import os
+import struct
+from typing import Optional
+
+from PySide6.QtCore import Qt, QTimer
+from PySide6.QtGui import QImage, QPainter
+from PySide6.QtWidgets import QWidget
+
+FRAME_RING_MAGIC = 0x52465347  # "GSFR"
+FRAME_RING_VERSION = 1
+FRAME_RING_SLOTS = 3
+
+FRAME_FORMAT_RAW = 0
+FRAME_FORMAT_BGRA8 = 1
+
+# magic, version, slot_count, header_size, slot_offset, slot_stride, slot_capacity, latest_sequence
+_HEADER = struct.Struct('<IIIIQQQQ')
+# sequence, width, height, pitch, format, source_format, reserved, size, present_time_ns
+_SLOT = struct.Struct('<QIIIIIIQQ')
+
+
+def _map_shared(name: str, size: Optional[int] = None) -> mmap.mmap:
+    if os.name == 'nt':
+        # Precisa do tamanho: o cabeçalho é mapeado primeiro para descobri-lo
+        return mmap.mmap(-1, size or _HEADER.size, tagname='Local\\' + name, access=mmap.ACCESS_READ)
+    import _posixshmem
+    fd = _posixshmem.shm_open('/' + name, os.O_RDONLY, 0)
+    try:
+        return mmap.mmap(fd, 0, access=mmap.ACCESS_READ)
+    finally:
+        os.close(fd)
+
+
+class FrameView:
+    """Frame mapeado em um slot; `pixels` aponta para a memória compartilhada."""
+
+    def __init__(self, pixels: memoryview, sequence: int, width: int, height: int,
+                 pitch: int, fmt: int):
+        self.pixels = pixels
+        self.sequence = sequence
+        self.width = width
+        self.height = height
+        self.pitch = pitch
+        self.format = fmt
+
+    def to_qimage(self) -> Optional[QImage]:
+        if self.format != FRAME_FORMAT_BGRA8:
+            return None
+        # QImage referencia o buffer; nenhum byte é copiado
+        return QImage(self.pixels, self.width, self.height, self.pitch, QImage.Format_ARGB32)
+
+
+class FrameRingReader:
+    def __init__(self, name: str):
+        self.name = name
+        self._map = _map_shared(name)
+        magic, version, slots, _, slot_offset, slot_stride, _, _ = _HEADER.unpack_from(self._map, 0)
+        if magic != FRAME_RING_MAGIC or version != FRAME_RING_VERSION or slots != FRAME_RING_SLOTS:
+            self._map.close()
+            raise ValueError(f'anel de frames inválido: {name}')
+        total = slot_offset + slot_stride * FRAME_RING_SLOTS
+        if len(self._map) < total:
+            self._map.close()
+            self._map = _map_shared(name, total)
+        self._view = memoryview(self._map)
+        self.slot_offset = slot_offset
+        self.slot_stride = slot_stride
+
+    def close(self):
+        if self._map is not None:
+            self._view.release()
+            self._map.close()
+            self._map = None
+
+    def _slot_sequence(self, index: int) -> int:
+        return struct.unpack_from('<Q', self._map, _HEADER.size + index * _SLOT.size)[0]
+
+    def acquire(self, after_sequence: int = 0) -> Optional[FrameView]:
+        """Frame mais novo que `after_sequence`, ou None."""
+        latest = _HEADER.unpack_from(self._map, 0)[7]
+        if latest == 0 or latest <= after_sequence:
+            return None
+        index = latest % FRAME_RING_SLOTS
+        slot_offset = _HEADER.size + index * _SLOT.size
+        sequence, width, height, pitch, fmt, _, _, size, _ = _SLOT.unpack_from(self._map, slot_offset)
+        if sequence != latest:
+            return None
+        start = self.slot_offset + index * self.slot_stride
+        size = min(size, self.slot_stride)
+        view = FrameView(self._view[start:start + size], sequence, width, height, pitch, fmt)
+        return view if self.validate(view) else None
+
+    def validate(self, view: FrameView) -> bool:
+        """Se os pixels do frame continuaram intactos; chamar depois do blit."""
+        return self._slot_sequence(view.sequence % FRAME_RING_SLOTS) == view.sequence
+
+
+class FrameRingView(QWidget):
+    """Exibe o anel de frames, consultando o frame mais novo a cada tick."""
+
+    def __init__(self, name: str, interval_ms: int = 8, parent=None):
+        super().__init__(parent)
+        self.reader: Optional[FrameRingReader] = None
+        self.name = name
+        self.last_sequence = 0
+        self._frame: Optional[FrameView] = None
+        self.setMinimumSize(320, 180)
+        self._timer = QTimer(self)
+        self._timer.timeout.connect(self._poll)
+        self._timer.start(interval_ms)
+
+    def _poll(self):
+        if self.reader is None:
+            try:
+                self.reader = FrameRingReader(self.name)
+            except (OSError, ValueError):
+                return
+        frame = self.reader.acquire(self.last_sequence)
+        if frame is not None:
+            self._frame = frame
+            self.update()
+
+    def paintEvent(self, event):
+        painter = QPainter(self)
+        painter.fillRect(self.rect(), Qt.black)
+        frame = self._frame
+        image = frame.to_qimage() if frame is not None else None
+        if image is None:
+            return
+        painter.drawImage(self.rect(), image)
+        painter.end()
+        # Frame sobrescrito durante o blit: o próximo tick redesenha
+        if self.reader.validate(frame):
+            self.last_sequence = frame.sequence
+
+    def closeEvent(self, event):
+        self._timer.stop()
+        self._frame = None
+        if self.reader is not None:
+            self.reader.close()
+            self.reader = None
+        super().closeEvent(event)
@@ -0,0 +1,91 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Executable Memory Header
+ *
+ * Page-granular buffers for JIT-generated host code. Code is written
+ * while the pages are read/write and then flipped to read/execute,
+ * so no mapping is ever writable and executable at once.
+ */
+
+#ifndef GSCX_CORE_EXEC_MEMORY_H
+#define GSCX_CORE_EXEC_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GSCX {
+namespace Core {
+
+/**
+ * Executable Code Block
+ *
+ * Owns one mapping holding a finished piece of generated code.
+ */
+class ExecutableBlock {
+public:
+    ExecutableBlock() = default;
+    ~ExecutableBlock();
+
+    ExecutableBlock(const ExecutableBlock&) = delete;
+    ExecutableBlock& operator=(const ExecutableBlock&) = delete;
+    ExecutableBlock(ExecutableBlock&& other) noexcept;
+    ExecutableBlock& operator=(ExecutableBlock&& other) noexcept;
+
+    // Copy `code` into fresh pages and make them executable
+    bool assign(const std::vector<uint8_t>& code);
+    void release();
+
+    const void* entry() const { return memory; }
+    size_t size() const { return code_size; }
+    bool valid() const { return memory != nullptr; }
+
+    template <typename Fn>
+    Fn as() const { return reinterpret_cast<Fn>(const_cast<void*>(memory)); }
+
+private:
+    void* memory = nullptr;
+    size_t mapped_size = 0;
+    size_t code_size = 0;
+};
+
+/**
+ * Executable Code Arena
+ *
+ * One reserved mapping that small pieces of code are appended to, for
+ * JITs producing thousands of blocks. The pages being written are
+ * flipped to read/write for the copy and back to read/execute.
+ */
+class ExecutableArena {
+public:
+    ExecutableArena() = default;
+    ~ExecutableArena();
+
+    ExecutableArena(const ExecutableArena&) = delete;
+    ExecutableArena& operator=(const ExecutableArena&) = delete;
+
+    bool reserve(size_t capacity);
+    void release();
+
+    // Address the next append lands at, for code with relative branches
+    // into the arena; appends are 16-byte aligned
+    const uint8_t* next() const { return memory ? memory + used_size : nullptr; }
+    // Copies `code` in and returns its address; null when full
+    const void* append(const std::vector<uint8_t>& code);
+    // Drops everything appended; none of it may be running
+    void reset() { used_size = 0; }
+
+    size_t used() const { return used_size; }
+    size_t capacity() const { return mapped_size; }
+    bool valid() const { return memory != nullptr; }
+
+private:
+    uint8_t* memory = nullptr;
+    size_t mapped_size = 0;
+    size_t used_size = 0;
+};
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_EXEC_MEMORY_H
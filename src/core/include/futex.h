@@ -0,0 +1,32 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Futex Header
+ *
+ * Address-based wait/wake on a 32-bit word: futex(2) on Linux,
+ * WaitOnAddress on Windows. Unlike std::atomic::wait these take a
+ * timeout, which guest sync primitives need.
+ */
+
+#ifndef GSCX_CORE_FUTEX_H
+#define GSCX_CORE_FUTEX_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace GSCX {
+namespace Core {
+
+static constexpr uint64_t FUTEX_INFINITE = UINT64_MAX;
+
+// Sleep while `word` holds `expected`, for at most `timeout_ns`.
+// Returns false on timeout; may also return spuriously, so callers
+// re-check their condition.
+bool futex_wait(const std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeout_ns = FUTEX_INFINITE);
+
+void futex_wake_one(std::atomic<uint32_t>& word);
+void futex_wake_all(std::atomic<uint32_t>& word);
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_FUTEX_H
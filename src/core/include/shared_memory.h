@@ -0,0 +1,60 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Shared Memory Header
+ *
+ * Named memory mappings visible to other processes: POSIX shared memory
+ * objects, or named file mappings on Windows.
+ */
+
+#ifndef GSCX_CORE_SHARED_MEMORY_H
+#define GSCX_CORE_SHARED_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace GSCX {
+namespace Core {
+
+/**
+ * Shared Memory Region
+ *
+ * The creating side owns the name and removes it on release; openers
+ * only map an existing object.
+ */
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion(SharedMemoryRegion&& other) noexcept;
+    SharedMemoryRegion& operator=(SharedMemoryRegion&& other) noexcept;
+
+    // Create (or replace) the object `name` with `size` zero-filled bytes
+    bool create(const std::string& name, size_t size);
+    // Map an existing object in full
+    bool open(const std::string& name, bool writable);
+    void release();
+
+    uint8_t* data() { return memory; }
+    const uint8_t* data() const { return memory; }
+    size_t size() const { return region_size; }
+    bool valid() const { return memory != nullptr; }
+    const std::string& name() const { return object_name; }
+
+private:
+    uint8_t* memory = nullptr;
+    size_t region_size = 0;
+    std::string object_name;
+    bool owner = false;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_SHARED_MEMORY_H
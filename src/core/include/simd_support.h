@@ -0,0 +1,115 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Host SIMD Support Header
+ *
+ * Host CPU feature detection and per-function target attributes for the
+ * SIMD fast paths. Baseline is x86-64 (SSE2); anything above that must be
+ * checked at runtime through get_host_cpu_features() before being called.
+ */
+
+#ifndef GSCX_CORE_SIMD_SUPPORT_H
+#define GSCX_CORE_SIMD_SUPPORT_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// MSVC allows any intrinsic in any function; GCC/Clang need the ISA
+// extension enabled per function so the rest of the binary stays baseline.
+#if defined(_MSC_VER)
+#define GSCX_TARGET_SSSE3
+#define GSCX_TARGET_SSE41
+#define GSCX_TARGET_AVX2
+#else
+#define GSCX_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define GSCX_TARGET_SSE41 __attribute__((target("ssse3,sse4.1")))
+#define GSCX_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
+
+namespace GSCX {
+namespace Core {
+
+/**
+ * Host CPU Features
+ *
+ * Instruction set extensions available on the host, detected once.
+ */
+struct HostCPUFeatures {
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+};
+
+namespace detail {
+
+inline void host_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) {
+        regs[i] = static_cast<uint32_t>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t host_xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+inline HostCPUFeatures detect_host_cpu_features() {
+    HostCPUFeatures features;
+    uint32_t regs[4] = {};
+
+    host_cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return features;
+    }
+
+    host_cpuid(1, 0, regs);
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    features.fma = (regs[2] & (1u << 12)) != 0;
+    features.f16c = (regs[2] & (1u << 29)) != 0;
+
+    // AVX state must be enabled by the OS (OSXSAVE + XCR0 bits 1 and 2)
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx_cpu = (regs[2] & (1u << 28)) != 0;
+    features.avx = osxsave && avx_cpu && (host_xgetbv0() & 0x6) == 0x6;
+
+    if (max_leaf >= 7) {
+        host_cpuid(7, 0, regs);
+        features.avx2 = features.avx && (regs[1] & (1u << 5)) != 0;
+    }
+
+    features.fma = features.fma && features.avx;
+    features.f16c = features.f16c && features.avx;
+    return features;
+}
+
+} // namespace detail
+
+inline const HostCPUFeatures& get_host_cpu_features() {
+    static const HostCPUFeatures features = detail::detect_host_cpu_features();
+    return features;
+}
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_SIMD_SUPPORT_H
@@ -0,0 +1,59 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Virtual Memory Header
+ *
+ * Large guest memories backed by anonymous mappings. Pages are committed
+ * by the host on first touch and read as zero until written, so a region
+ * costs address space up front and physical memory only as it is used.
+ */
+
+#ifndef GSCX_CORE_VIRTUAL_MEMORY_H
+#define GSCX_CORE_VIRTUAL_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GSCX {
+namespace Core {
+
+/**
+ * Virtual Memory Region
+ *
+ * One zero-filled, read/write mapping, committed lazily by the host.
+ */
+class VirtualMemoryRegion {
+public:
+    VirtualMemoryRegion() = default;
+    ~VirtualMemoryRegion();
+
+    VirtualMemoryRegion(const VirtualMemoryRegion&) = delete;
+    VirtualMemoryRegion& operator=(const VirtualMemoryRegion&) = delete;
+    VirtualMemoryRegion(VirtualMemoryRegion&& other) noexcept;
+    VirtualMemoryRegion& operator=(VirtualMemoryRegion&& other) noexcept;
+
+    // Map `size` bytes (rounded up to whole pages); nothing is touched
+    bool allocate(size_t size);
+    void release();
+
+    // Return the pages overlapping [offset, offset + size) to the host;
+    // they read as zero again afterwards
+    void discard(size_t offset, size_t size);
+
+    // Bytes currently backed by physical memory
+    size_t get_resident_bytes() const;
+
+    uint8_t* data() { return memory; }
+    const uint8_t* data() const { return memory; }
+    size_t size() const { return region_size; }
+    bool valid() const { return memory != nullptr; }
+
+private:
+    uint8_t* memory = nullptr;
+    size_t mapped_size = 0;
+    size_t region_size = 0;
+};
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_VIRTUAL_MEMORY_H
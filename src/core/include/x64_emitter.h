@@ -0,0 +1,569 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * x86-64 Code Emitter Header
+ *
+ * Minimal machine code emitter shared by the JIT backends. Vector
+ * instructions are VEX-encoded and take memory operands of the form
+ * [base + disp]; integer loads also take [base + index * scale + disp].
+ * The caller owns register allocation.
+ */
+
+#ifndef GSCX_CORE_X64_EMITTER_H
+#define GSCX_CORE_X64_EMITTER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace GSCX {
+namespace Core {
+
+enum class X64Reg : uint8_t {
+    RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+enum class VecWidth : uint8_t {
+    XMM = 0,
+    YMM = 1
+};
+
+// VCMPPS predicates
+enum X64CmpPredicate : uint8_t {
+    X64_CMP_EQ_OQ = 0x00,
+    X64_CMP_NEQ_UQ = 0x04,
+    X64_CMP_TRUE_UQ = 0x0F,
+    X64_CMP_LT_OQ = 0x11,
+    X64_CMP_LE_OQ = 0x12,
+    X64_CMP_GE_OQ = 0x1D,
+    X64_CMP_GT_OQ = 0x1E
+};
+
+// VROUNDPS modes (precision exception suppressed)
+enum X64RoundMode : uint8_t {
+    X64_ROUND_NEAREST = 0x08,
+    X64_ROUND_FLOOR = 0x09,
+    X64_ROUND_CEIL = 0x0A,
+    X64_ROUND_TRUNC = 0x0B
+};
+
+// Condition codes (Jcc/SETcc/CMOVcc)
+enum class X64Cond : uint8_t {
+    O = 0, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G
+};
+
+/**
+ * x86-64 Emitter
+ *
+ * Appends encoded instructions to a byte buffer. Vector registers are
+ * numbered 0-15; on Win64 only 0-5 are volatile, so backends that want
+ * to stay prologue-free should stick to those.
+ *
+ * Integer operations are 64-bit unless `w64` is false; 32-bit forms
+ * zero the upper half of the destination. Branches are rel32 and
+ * returned as a label to bind() once the target is emitted.
+ */
+class X64Emitter {
+public:
+    const std::vector<uint8_t>& get_code() const { return code; }
+    size_t size() const { return code.size(); }
+    void clear() { code.clear(); }
+
+    // Integer argument registers of the host calling convention
+    static X64Reg arg_reg(int index) {
+#ifdef _WIN32
+        static constexpr X64Reg regs[] = { X64Reg::RCX, X64Reg::RDX, X64Reg::R8, X64Reg::R9 };
+#else
+        static constexpr X64Reg regs[] = { X64Reg::RDI, X64Reg::RSI, X64Reg::RDX, X64Reg::RCX };
+#endif
+        return regs[index];
+    }
+
+    void emit8(uint8_t value) { code.push_back(value); }
+
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    // Vector moves
+    void vmovups_load(int dst, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) {
+        vex_mem(MAP_0F, PP_NONE, 0x10, dst, 0, base, disp, w);
+    }
+    void vmovups_store(X64Reg base, int32_t disp, int src, VecWidth w = VecWidth::YMM) {
+        vex_mem(MAP_0F, PP_NONE, 0x11, src, 0, base, disp, w);
+    }
+    void vmovaps(int dst, int src, VecWidth w = VecWidth::YMM) {
+        vex_reg(MAP_0F, PP_NONE, 0x28, dst, 0, src, w);
+    }
+    void vbroadcastss(int dst, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) {
+        vex_mem(MAP_0F38, PP_66, 0x18, dst, 0, base, disp, w);
+    }
+
+    void vmovdqu_load(int dst, X64Reg base, int32_t disp, VecWidth w = VecWidth::XMM) {
+        vex_mem(MAP_0F, PP_F3, 0x6F, dst, 0, base, disp, w);
+    }
+    void vmovdqu_store(X64Reg base, int32_t disp, int src, VecWidth w = VecWidth::XMM) {
+        vex_mem(MAP_0F, PP_F3, 0x7F, src, 0, base, disp, w);
+    }
+
+    // Packed single arithmetic: dst = a op b
+    void vaddps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x58, dst, a, b, w); }
+    void vmulps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x59, dst, a, b, w); }
+    void vsubps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x5C, dst, a, b, w); }
+    void vminps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x5D, dst, a, b, w); }
+    void vdivps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x5E, dst, a, b, w); }
+    void vmaxps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x5F, dst, a, b, w); }
+    void vandps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x54, dst, a, b, w); }
+    void vandnps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x55, dst, a, b, w); }
+    void vorps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x56, dst, a, b, w); }
+    void vxorps(int dst, int a, int b, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x57, dst, a, b, w); }
+
+    // Same with the second operand in memory
+    void vaddps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x58, dst, a, base, disp, w); }
+    void vmulps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x59, dst, a, base, disp, w); }
+    void vminps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x5D, dst, a, base, disp, w); }
+    void vdivps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x5E, dst, a, base, disp, w); }
+    void vmaxps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x5F, dst, a, base, disp, w); }
+    void vandps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x54, dst, a, base, disp, w); }
+    void vxorps(int dst, int a, X64Reg base, int32_t disp, VecWidth w = VecWidth::YMM) { vex_mem(MAP_0F, PP_NONE, 0x57, dst, a, base, disp, w); }
+
+    void vcmpps(int dst, int a, int b, uint8_t predicate, VecWidth w = VecWidth::YMM) {
+        vex_reg(MAP_0F, PP_NONE, 0xC2, dst, a, b, w);
+        emit8(predicate);
+    }
+    void vroundps(int dst, int src, uint8_t mode, VecWidth w = VecWidth::YMM) {
+        vex_reg(MAP_0F3A, PP_66, 0x08, dst, 0, src, w);
+        emit8(mode);
+    }
+    void vsqrtps(int dst, int src, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x51, dst, 0, src, w); }
+    void vrsqrtps(int dst, int src, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x52, dst, 0, src, w); }
+    void vrcpps(int dst, int src, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x53, dst, 0, src, w); }
+
+    // Conversions (truncating for float -> int) and sign masks
+    void vcvtdq2ps(int dst, int src, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_NONE, 0x5B, dst, 0, src, w); }
+    void vcvttps2dq(int dst, int src, VecWidth w = VecWidth::YMM) { vex_reg(MAP_0F, PP_F3, 0x5B, dst, 0, src, w); }
+    void vmovmskps(X64Reg dst, int src, VecWidth w = VecWidth::XMM) {
+        vex_reg(MAP_0F, PP_NONE, 0x50, static_cast<int>(dst), 0, src, w);
+    }
+
+    // Packed integer: dst = a op b. Default to 128 bits, the 256-bit
+    // forms need AVX2
+    void vpaddb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xFC, dst, a, b, w); }
+    void vpaddw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xFD, dst, a, b, w); }
+    void vpaddd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xFE, dst, a, b, w); }
+    void vpsubb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xF8, dst, a, b, w); }
+    void vpsubw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xF9, dst, a, b, w); }
+    void vpsubd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xFA, dst, a, b, w); }
+    void vpaddsb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xEC, dst, a, b, w); }
+    void vpaddsw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xED, dst, a, b, w); }
+    void vpsubsb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xE8, dst, a, b, w); }
+    void vpsubsw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xE9, dst, a, b, w); }
+    void vpaddusb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xDC, dst, a, b, w); }
+    void vpaddusw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xDD, dst, a, b, w); }
+    void vpsubusb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xD8, dst, a, b, w); }
+    void vpsubusw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xD9, dst, a, b, w); }
+    void vpcmpeqb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x74, dst, a, b, w); }
+    void vpcmpeqw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x75, dst, a, b, w); }
+    void vpcmpeqd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x76, dst, a, b, w); }
+    void vpcmpgtb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x64, dst, a, b, w); }
+    void vpcmpgtw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x65, dst, a, b, w); }
+    void vpcmpgtd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x66, dst, a, b, w); }
+    void vpmaxsw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xEE, dst, a, b, w); }
+    void vpminsw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xEA, dst, a, b, w); }
+    void vpmaxsd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F38, PP_66, 0x3D, dst, a, b, w); }
+    void vpminsd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F38, PP_66, 0x39, dst, a, b, w); }
+    void vpand(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xDB, dst, a, b, w); }
+    void vpor(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xEB, dst, a, b, w); }
+    void vpxor(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0xEF, dst, a, b, w); }
+    void vpackssdw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x6B, dst, a, b, w); }
+    void vpacksswb(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x63, dst, a, b, w); }
+    void vpunpcklbw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x60, dst, a, b, w); }
+    void vpunpcklwd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x61, dst, a, b, w); }
+    void vpunpckldq(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x62, dst, a, b, w); }
+    void vpunpcklqdq(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x6C, dst, a, b, w); }
+    void vpunpckhbw(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x68, dst, a, b, w); }
+    void vpunpckhwd(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x69, dst, a, b, w); }
+    void vpunpckhdq(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x6A, dst, a, b, w); }
+    void vpunpckhqdq(int dst, int a, int b, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F, PP_66, 0x6D, dst, a, b, w); }
+    void vpabsw(int dst, int src, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F38, PP_66, 0x1D, dst, 0, src, w); }
+    void vpabsd(int dst, int src, VecWidth w = VecWidth::XMM) { vex_reg(MAP_0F38, PP_66, 0x1E, dst, 0, src, w); }
+
+    // Packed integer shifts by an immediate count
+    void vpsllw(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x71, 6, dst, src, count, w); }
+    void vpsrlw(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x71, 2, dst, src, count, w); }
+    void vpsraw(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x71, 4, dst, src, count, w); }
+    void vpslld(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x72, 6, dst, src, count, w); }
+    void vpsrld(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x72, 2, dst, src, count, w); }
+    void vpsrad(int dst, int src, uint8_t count, VecWidth w = VecWidth::XMM) { vex_shift(0x72, 4, dst, src, count, w); }
+
+    // Integer shuffles and blends with an immediate selector
+    void vpshufd(int dst, int src, uint8_t selector, VecWidth w = VecWidth::XMM) {
+        vex_reg(MAP_0F, PP_66, 0x70, dst, 0, src, w);
+        emit8(selector);
+    }
+    void vpshuflw(int dst, int src, uint8_t selector, VecWidth w = VecWidth::XMM) {
+        vex_reg(MAP_0F, PP_F2, 0x70, dst, 0, src, w);
+        emit8(selector);
+    }
+    void vpshufhw(int dst, int src, uint8_t selector, VecWidth w = VecWidth::XMM) {
+        vex_reg(MAP_0F, PP_F3, 0x70, dst, 0, src, w);
+        emit8(selector);
+    }
+    void vpblendw(int dst, int a, int b, uint8_t mask, VecWidth w = VecWidth::XMM) {
+        vex_reg(MAP_0F3A, PP_66, 0x0E, dst, a, b, w);
+        emit8(mask);
+    }
+    void vshufps(int dst, int a, int b, uint8_t selector, VecWidth w = VecWidth::YMM) {
+        vex_reg(MAP_0F, PP_NONE, 0xC6, dst, a, b, w);
+        emit8(selector);
+    }
+
+    // In-lane permute (within each 128-bit half)
+    void vpermilps(int dst, int src, uint8_t selector, VecWidth w = VecWidth::YMM) {
+        vex_reg(MAP_0F3A, PP_66, 0x04, dst, 0, src, w);
+        emit8(selector);
+    }
+
+    // General purpose registers
+    void push(X64Reg reg) {
+        rex(false, 0, static_cast<int>(reg));
+        emit8(static_cast<uint8_t>(0x50 | (static_cast<int>(reg) & 7)));
+    }
+    void pop(X64Reg reg) {
+        rex(false, 0, static_cast<int>(reg));
+        emit8(static_cast<uint8_t>(0x58 | (static_cast<int>(reg) & 7)));
+    }
+    void mov(X64Reg dst, X64Reg src) {
+        rex(true, static_cast<int>(src), static_cast<int>(dst));
+        emit8(0x89);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(src) & 7) << 3) | (static_cast<int>(dst) & 7)));
+    }
+    void mov(X64Reg dst, X64Reg base, int32_t disp) {
+        rex(true, static_cast<int>(dst), static_cast<int>(base));
+        emit8(0x8B);
+        modrm_mem(static_cast<int>(dst), base, disp);
+    }
+    void mov_imm32(X64Reg dst, uint32_t imm) {
+        rex(false, 0, static_cast<int>(dst));
+        emit8(static_cast<uint8_t>(0xB8 | (static_cast<int>(dst) & 7)));
+        emit32(imm);
+    }
+    void mov_imm64(X64Reg dst, uint64_t imm) {
+        rex(true, 0, static_cast<int>(dst));
+        emit8(static_cast<uint8_t>(0xB8 | (static_cast<int>(dst) & 7)));
+        emit32(static_cast<uint32_t>(imm));
+        emit32(static_cast<uint32_t>(imm >> 32));
+    }
+    void lea(X64Reg dst, X64Reg base, int32_t disp) {
+        rex(true, static_cast<int>(dst), static_cast<int>(base));
+        emit8(0x8D);
+        modrm_mem(static_cast<int>(dst), base, disp);
+    }
+    void add_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(0, dst, imm, w64); }
+    void sub_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(5, dst, imm, w64); }
+    void or_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(1, dst, imm, w64); }
+    void and_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(4, dst, imm, w64); }
+    void xor_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(6, dst, imm, w64); }
+    void cmp_imm32(X64Reg dst, int32_t imm, bool w64 = true) { alu_imm(7, dst, imm, w64); }
+    void test_imm32(X64Reg dst, uint32_t imm, bool w64 = true) {
+        rex(w64, 0, static_cast<int>(dst));
+        emit8(0xF7);
+        emit8(static_cast<uint8_t>(0xC0 | (static_cast<int>(dst) & 7)));
+        emit32(imm);
+    }
+
+    // dst = dst op src
+    void add(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x01, dst, src, w64); }
+    void or_(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x09, dst, src, w64); }
+    void and_(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x21, dst, src, w64); }
+    void sub(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x29, dst, src, w64); }
+    void xor_(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x31, dst, src, w64); }
+    void cmp(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x39, dst, src, w64); }
+    void test(X64Reg dst, X64Reg src, bool w64 = true) { alu_reg(0x85, dst, src, w64); }
+    void imul(X64Reg dst, X64Reg src, bool w64 = true) {
+        rex(w64, static_cast<int>(dst), static_cast<int>(src));
+        emit8(0x0F);
+        emit8(0xAF);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(dst) & 7) << 3) | (static_cast<int>(src) & 7)));
+    }
+    void not_(X64Reg dst, bool w64 = true) { unary(2, dst, w64); }
+    void neg(X64Reg dst, bool w64 = true) { unary(3, dst, w64); }
+
+    // Shifts by an immediate or by CL
+    void shl_imm(X64Reg dst, uint8_t count, bool w64 = true) { shift(4, dst, count, w64); }
+    void shr_imm(X64Reg dst, uint8_t count, bool w64 = true) { shift(5, dst, count, w64); }
+    void sar_imm(X64Reg dst, uint8_t count, bool w64 = true) { shift(7, dst, count, w64); }
+    void shl_cl(X64Reg dst, bool w64 = true) { shift_cl(4, dst, w64); }
+    void shr_cl(X64Reg dst, bool w64 = true) { shift_cl(5, dst, w64); }
+    void sar_cl(X64Reg dst, bool w64 = true) { shift_cl(7, dst, w64); }
+
+    // Register moves and extensions
+    void mov32(X64Reg dst, X64Reg src) {
+        rex(false, static_cast<int>(src), static_cast<int>(dst));
+        emit8(0x89);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(src) & 7) << 3) | (static_cast<int>(dst) & 7)));
+    }
+    // Sign-extended 32-bit immediate
+    void mov_simm32(X64Reg dst, int32_t imm) {
+        rex(true, 0, static_cast<int>(dst));
+        emit8(0xC7);
+        emit8(static_cast<uint8_t>(0xC0 | (static_cast<int>(dst) & 7)));
+        emit32(static_cast<uint32_t>(imm));
+    }
+    void movsxd(X64Reg dst, X64Reg src) {
+        rex(true, static_cast<int>(dst), static_cast<int>(src));
+        emit8(0x63);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(dst) & 7) << 3) | (static_cast<int>(src) & 7)));
+    }
+    void movzx8(X64Reg dst, X64Reg src) {
+        rex(false, static_cast<int>(dst), 0, static_cast<int>(src), is_byte_rex(src));
+        emit8(0x0F);
+        emit8(0xB6);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(dst) & 7) << 3) | (static_cast<int>(src) & 7)));
+    }
+    void setcc(X64Cond cond, X64Reg dst) {
+        rex(false, 0, 0, static_cast<int>(dst), is_byte_rex(dst));
+        emit8(0x0F);
+        emit8(static_cast<uint8_t>(0x90 | static_cast<uint8_t>(cond)));
+        emit8(static_cast<uint8_t>(0xC0 | (static_cast<int>(dst) & 7)));
+    }
+    void cmovcc(X64Cond cond, X64Reg dst, X64Reg src, bool w64 = true) {
+        rex(w64, static_cast<int>(dst), static_cast<int>(src));
+        emit8(0x0F);
+        emit8(static_cast<uint8_t>(0x40 | static_cast<uint8_t>(cond)));
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(dst) & 7) << 3) | (static_cast<int>(src) & 7)));
+    }
+
+    // Integer loads of 1, 2, 4 or 8 bytes, zero- or sign-extended to 64 bits
+    void load(X64Reg dst, X64Reg base, int32_t disp, int size, bool sign = false) {
+        load_opcode(dst, base, X64Reg::RSP, size, sign);
+        modrm_mem(static_cast<int>(dst), base, disp);
+    }
+    void load(X64Reg dst, X64Reg base, X64Reg index, int scale, int32_t disp, int size, bool sign = false) {
+        load_opcode(dst, base, index, size, sign);
+        modrm_sib(static_cast<int>(dst), base, index, scale, disp);
+    }
+    // Stores the low `size` bytes of src
+    void store(X64Reg base, int32_t disp, X64Reg src, int size) {
+        if (size == 2) {
+            emit8(0x66);
+        }
+        rex(size == 8, static_cast<int>(src), 0, static_cast<int>(base), size == 1 && is_byte_rex(src));
+        emit8(size == 1 ? 0x88 : 0x89);
+        modrm_mem(static_cast<int>(src), base, disp);
+    }
+    // Sign-extended immediate into a qword
+    void store_simm32(X64Reg base, int32_t disp, int32_t imm) {
+        rex(true, 0, static_cast<int>(base));
+        emit8(0xC7);
+        modrm_mem(0, base, disp);
+        emit32(static_cast<uint32_t>(imm));
+    }
+    void add_mem_imm32(X64Reg base, int32_t disp, int32_t imm) {
+        rex(true, 0, static_cast<int>(base));
+        emit8(0x81);
+        modrm_mem(0, base, disp);
+        emit32(static_cast<uint32_t>(imm));
+    }
+    void cmp_mem_imm8(X64Reg base, int32_t disp, int8_t imm, int size = 8) {
+        rex(size == 8, 0, static_cast<int>(base));
+        emit8(size == 1 ? 0x80 : 0x83);
+        modrm_mem(7, base, disp);
+        emit8(static_cast<uint8_t>(imm));
+    }
+
+    // Control flow; a label is the offset of a rel32 field
+    size_t jcc(X64Cond cond) {
+        emit8(0x0F);
+        emit8(static_cast<uint8_t>(0x80 | static_cast<uint8_t>(cond)));
+        emit32(0);
+        return code.size() - 4;
+    }
+    size_t jmp() {
+        emit8(0xE9);
+        emit32(0);
+        return code.size() - 4;
+    }
+    // Points a label at the current position
+    void bind(size_t label) {
+        uint32_t rel = static_cast<uint32_t>(code.size() - (label + 4));
+        for (int i = 0; i < 4; i++) {
+            code[label + i] = static_cast<uint8_t>(rel >> (i * 8));
+        }
+    }
+    void jmp(X64Reg target) {
+        rex(false, 0, static_cast<int>(target));
+        emit8(0xFF);
+        emit8(static_cast<uint8_t>(0xE0 | (static_cast<int>(target) & 7)));
+    }
+    void jmp(X64Reg base, int32_t disp) {
+        rex(false, 0, static_cast<int>(base));
+        emit8(0xFF);
+        modrm_mem(4, base, disp);
+    }
+
+    void call(X64Reg target) {
+        rex(false, 0, static_cast<int>(target));
+        emit8(0xFF);
+        emit8(static_cast<uint8_t>(0xD0 | (static_cast<int>(target) & 7)));
+    }
+
+    // Call an absolute address through RAX
+    void call(const void* target) {
+        mov_imm64(X64Reg::RAX, reinterpret_cast<uint64_t>(target));
+        call(X64Reg::RAX);
+    }
+
+    void vzeroupper() {
+        emit8(0xC5);
+        emit8(0xF8);
+        emit8(0x77);
+    }
+
+    void ret() { emit8(0xC3); }
+
+protected:
+    enum OpcodeMap : uint8_t { MAP_0F = 1, MAP_0F38 = 2, MAP_0F3A = 3 };
+    enum Prefix : uint8_t { PP_NONE = 0, PP_66 = 1, PP_F3 = 2, PP_F2 = 3 };
+
+    // REX prefix, omitted when it would carry no bits unless `force`d
+    // (byte access to SPL/BPL/SIL/DIL)
+    void rex(bool w64, int reg, int index, int base, bool force = false) {
+        uint8_t value = static_cast<uint8_t>(0x40 | (w64 ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) |
+                                             ((index & 8) ? 0x02 : 0) | ((base & 8) ? 0x01 : 0));
+        if (value != 0x40 || force) {
+            emit8(value);
+        }
+    }
+    void rex(bool w64, int reg, int base) { rex(w64, reg, 0, base); }
+
+    static bool is_byte_rex(X64Reg reg) {
+        return reg >= X64Reg::RSP && reg <= X64Reg::RDI;
+    }
+
+    void alu_reg(uint8_t opcode, X64Reg dst, X64Reg src, bool w64) {
+        rex(w64, static_cast<int>(src), static_cast<int>(dst));
+        emit8(opcode);
+        emit8(static_cast<uint8_t>(0xC0 | ((static_cast<int>(src) & 7) << 3) | (static_cast<int>(dst) & 7)));
+    }
+
+    void alu_imm(int ext, X64Reg dst, int32_t imm, bool w64) {
+        rex(w64, 0, static_cast<int>(dst));
+        bool short_imm = imm >= -128 && imm <= 127;
+        emit8(short_imm ? 0x83 : 0x81);
+        emit8(static_cast<uint8_t>(0xC0 | (ext << 3) | (static_cast<int>(dst) & 7)));
+        if (short_imm) {
+            emit8(static_cast<uint8_t>(imm));
+        } else {
+            emit32(static_cast<uint32_t>(imm));
+        }
+    }
+
+    void unary(int ext, X64Reg dst, bool w64) {
+        rex(w64, 0, static_cast<int>(dst));
+        emit8(0xF7);
+        emit8(static_cast<uint8_t>(0xC0 | (ext << 3) | (static_cast<int>(dst) & 7)));
+    }
+
+    void shift(int ext, X64Reg dst, uint8_t count, bool w64) {
+        rex(w64, 0, static_cast<int>(dst));
+        emit8(0xC1);
+        emit8(static_cast<uint8_t>(0xC0 | (ext << 3) | (static_cast<int>(dst) & 7)));
+        emit8(count);
+    }
+
+    void shift_cl(int ext, X64Reg dst, bool w64) {
+        rex(w64, 0, static_cast<int>(dst));
+        emit8(0xD3);
+        emit8(static_cast<uint8_t>(0xC0 | (ext << 3) | (static_cast<int>(dst) & 7)));
+    }
+
+    // Opcode bytes of an integer load; the ModRM follows
+    void load_opcode(X64Reg dst, X64Reg base, X64Reg index, int size, bool sign) {
+        int index_bits = index == X64Reg::RSP ? 0 : static_cast<int>(index);
+        switch (size) {
+            case 1:
+            case 2:
+                rex(sign, static_cast<int>(dst), index_bits, static_cast<int>(base));
+                emit8(0x0F);
+                emit8(static_cast<uint8_t>((sign ? 0xBE : 0xB6) | (size == 2 ? 1 : 0)));
+                break;
+            case 4:
+                rex(sign, static_cast<int>(dst), index_bits, static_cast<int>(base));
+                emit8(sign ? 0x63 : 0x8B);
+                break;
+            default:
+                rex(true, static_cast<int>(dst), index_bits, static_cast<int>(base));
+                emit8(0x8B);
+                break;
+        }
+    }
+
+    // Three-byte VEX prefix; register extension bits are stored inverted
+    void vex(int reg, int index, int base, OpcodeMap map, bool w64, int vvvv, VecWidth w, Prefix pp) {
+        emit8(0xC4);
+        emit8(static_cast<uint8_t>(((reg & 8) ? 0 : 0x80) | ((index & 8) ? 0 : 0x40) |
+                                   ((base & 8) ? 0 : 0x20) | map));
+        emit8(static_cast<uint8_t>((w64 ? 0x80 : 0) | ((~vvvv & 0xF) << 3) |
+                                   (w == VecWidth::YMM ? 0x04 : 0) | pp));
+    }
+
+    void modrm_mem(int reg, X64Reg base, int32_t disp) {
+        int rm = static_cast<int>(base) & 7;
+        bool short_disp = disp >= -128 && disp <= 127;
+        emit8(static_cast<uint8_t>((short_disp ? 0x40 : 0x80) | ((reg & 7) << 3) | rm));
+        if (rm == 4) {
+            emit8(0x24);  // SIB: base only (RSP/R12)
+        }
+        if (short_disp) {
+            emit8(static_cast<uint8_t>(disp));
+        } else {
+            emit32(static_cast<uint32_t>(disp));
+        }
+    }
+
+    // [base + index * scale + disp]; index cannot be RSP
+    void modrm_sib(int reg, X64Reg base, X64Reg index, int scale, int32_t disp) {
+        int scale_bits = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+        bool no_disp = disp == 0 && (static_cast<int>(base) & 7) != 5;
+        bool short_disp = disp >= -128 && disp <= 127;
+        emit8(static_cast<uint8_t>((no_disp ? 0x00 : short_disp ? 0x40 : 0x80) | ((reg & 7) << 3) | 4));
+        emit8(static_cast<uint8_t>((scale_bits << 6) | ((static_cast<int>(index) & 7) << 3) |
+                                   (static_cast<int>(base) & 7)));
+        if (no_disp) {
+            return;
+        }
+        if (short_disp) {
+            emit8(static_cast<uint8_t>(disp));
+        } else {
+            emit32(static_cast<uint32_t>(disp));
+        }
+    }
+
+    void vex_reg(OpcodeMap map, Prefix pp, uint8_t opcode, int reg, int vvvv, int rm, VecWidth w) {
+        vex(reg, 0, rm, map, false, vvvv, w, pp);
+        emit8(opcode);
+        emit8(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+    }
+
+    // Shift group: the destination goes in VEX.vvvv, the ModRM reg
+    // field holds the operation
+    void vex_shift(uint8_t opcode, int ext, int dst, int src, uint8_t count, VecWidth w) {
+        vex_reg(MAP_0F, PP_66, opcode, ext, dst, src, w);
+        emit8(count);
+    }
+
+    void vex_mem(OpcodeMap map, Prefix pp, uint8_t opcode, int reg, int vvvv, X64Reg base, int32_t disp, VecWidth w) {
+        vex(reg, 0, static_cast<int>(base), map, false, vvvv, w, pp);
+        emit8(opcode);
+        modrm_mem(reg, base, disp);
+    }
+
+    std::vector<uint8_t> code;
+};
+
+} // namespace Core
+} // namespace GSCX
+
+#endif // GSCX_CORE_X64_EMITTER_H
@@ -0,0 +1,179 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Executable Memory Implementation
+ */
+
+#include "../include/exec_memory.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace GSCX {
+namespace Core {
+
+static size_t host_page_size() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+ExecutableBlock::~ExecutableBlock() {
+    release();
+}
+
+ExecutableBlock::ExecutableBlock(ExecutableBlock&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr))
+    , mapped_size(std::exchange(other.mapped_size, 0))
+    , code_size(std::exchange(other.code_size, 0)) {
+}
+
+ExecutableBlock& ExecutableBlock::operator=(ExecutableBlock&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory = std::exchange(other.memory, nullptr);
+        mapped_size = std::exchange(other.mapped_size, 0);
+        code_size = std::exchange(other.code_size, 0);
+    }
+    return *this;
+}
+
+bool ExecutableBlock::assign(const std::vector<uint8_t>& code) {
+    release();
+    if (code.empty()) {
+        return false;
+    }
+
+    size_t page = host_page_size();
+    size_t size = (code.size() + page - 1) & ~(page - 1);
+
+#ifdef _WIN32
+    void* pages = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!pages) {
+        return false;
+    }
+    std::memcpy(pages, code.data(), code.size());
+    DWORD old_protect;
+    if (!VirtualProtect(pages, size, PAGE_EXECUTE_READ, &old_protect)) {
+        VirtualFree(pages, 0, MEM_RELEASE);
+        return false;
+    }
+    FlushInstructionCache(GetCurrentProcess(), pages, code.size());
+#else
+    void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        return false;
+    }
+    std::memcpy(pages, code.data(), code.size());
+    if (mprotect(pages, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(pages, size);
+        return false;
+    }
+#endif
+
+    memory = pages;
+    mapped_size = size;
+    code_size = code.size();
+    return true;
+}
+
+void ExecutableBlock::release() {
+    if (!memory) {
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, mapped_size);
+#endif
+    memory = nullptr;
+    mapped_size = 0;
+    code_size = 0;
+}
+
+ExecutableArena::~ExecutableArena() {
+    release();
+}
+
+bool ExecutableArena::reserve(size_t capacity) {
+    release();
+    size_t page = host_page_size();
+    size_t size = (capacity + page - 1) & ~(page - 1);
+
+#ifdef _WIN32
+    void* pages = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READ);
+    if (!pages) {
+        return false;
+    }
+#else
+    void* pages = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    memory = static_cast<uint8_t*>(pages);
+    mapped_size = size;
+    used_size = 0;
+    return true;
+}
+
+const void* ExecutableArena::append(const std::vector<uint8_t>& code) {
+    size_t size = code.size();
+    if (!memory || size == 0 || size > mapped_size - used_size) {
+        return nullptr;
+    }
+
+    uint8_t* target = memory + used_size;
+    size_t page = host_page_size();
+    uintptr_t first = reinterpret_cast<uintptr_t>(target) & ~(page - 1);
+    uintptr_t last = (reinterpret_cast<uintptr_t>(target) + size + page - 1) & ~(page - 1);
+    void* pages = reinterpret_cast<void*>(first);
+    size_t span = last - first;
+
+#ifdef _WIN32
+    DWORD old_protect;
+    if (!VirtualProtect(pages, span, PAGE_READWRITE, &old_protect)) {
+        return nullptr;
+    }
+    std::memcpy(target, code.data(), size);
+    VirtualProtect(pages, span, PAGE_EXECUTE_READ, &old_protect);
+    FlushInstructionCache(GetCurrentProcess(), target, size);
+#else
+    if (mprotect(pages, span, PROT_READ | PROT_WRITE) != 0) {
+        return nullptr;
+    }
+    std::memcpy(target, code.data(), size);
+    mprotect(pages, span, PROT_READ | PROT_EXEC);
+#endif
+
+    used_size = std::min(mapped_size, (used_size + size + 15) & ~static_cast<size_t>(15));
+    return target;
+}
+
+void ExecutableArena::release() {
+    if (!memory) {
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, mapped_size);
+#endif
+    memory = nullptr;
+    mapped_size = 0;
+    used_size = 0;
+}
+
+} // namespace Core
+} // namespace GSCX
@@ -0,0 +1,98 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Futex Implementation
+ */
+
+#include "../include/futex.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace GSCX {
+namespace Core {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit word");
+
+#if defined(_WIN32)
+
+bool futex_wait(const std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeout_ns) {
+    DWORD timeout_ms = INFINITE;
+    if (timeout_ns != FUTEX_INFINITE) {
+        // Round up so short waits still sleep
+        timeout_ms = static_cast<DWORD>(std::min<uint64_t>((timeout_ns + 999999) / 1000000, INFINITE - 1));
+    }
+    volatile void* address = const_cast<std::atomic<uint32_t>*>(&word);
+    if (WaitOnAddress(address, &expected, sizeof(expected), timeout_ms)) {
+        return true;
+    }
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+void futex_wake_one(std::atomic<uint32_t>& word) {
+    WakeByAddressSingle(&word);
+}
+
+void futex_wake_all(std::atomic<uint32_t>& word) {
+    WakeByAddressAll(&word);
+}
+
+#elif defined(__linux__)
+
+bool futex_wait(const std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeout_ns) {
+    timespec timeout;
+    timespec* timeout_ptr = nullptr;
+    if (timeout_ns != FUTEX_INFINITE) {
+        timeout.tv_sec = static_cast<time_t>(timeout_ns / 1000000000ull);
+        timeout.tv_nsec = static_cast<long>(timeout_ns % 1000000000ull);
+        timeout_ptr = &timeout;
+    }
+    // Private futex: every waiter and waker is in this process
+    long result = syscall(SYS_futex, const_cast<std::atomic<uint32_t>*>(&word), FUTEX_WAIT_PRIVATE,
+                          expected, timeout_ptr, nullptr, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+void futex_wake_one(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+// No address wait primitive: poll with a short sleep
+bool futex_wait(const std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeout_ns) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(
+        timeout_ns == FUTEX_INFINITE ? INT64_MAX / 2 : static_cast<int64_t>(timeout_ns));
+    while (word.load(std::memory_order_acquire) == expected) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+void futex_wake_one(std::atomic<uint32_t>&) {
+}
+
+void futex_wake_all(std::atomic<uint32_t>&) {
+}
+
+#endif
+
+} // namespace Core
+} // namespace GSCX
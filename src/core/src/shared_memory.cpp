@@ -0,0 +1,181 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Shared Memory Implementation
+ */
+
+#include "../include/shared_memory.h"
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace GSCX {
+namespace Core {
+
+#ifdef _WIN32
+static std::string object_path(const std::string& name) {
+    // Session-local namespace needs no extra privileges
+    return "Local\\" + name;
+}
+#else
+static std::string object_path(const std::string& name) {
+    return "/" + name;
+}
+#endif
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    release();
+}
+
+SharedMemoryRegion::SharedMemoryRegion(SharedMemoryRegion&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr))
+    , region_size(std::exchange(other.region_size, 0))
+    , object_name(std::move(other.object_name))
+    , owner(std::exchange(other.owner, false))
+#ifdef _WIN32
+    , mapping(std::exchange(other.mapping, nullptr))
+#endif
+{
+}
+
+SharedMemoryRegion& SharedMemoryRegion::operator=(SharedMemoryRegion&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory = std::exchange(other.memory, nullptr);
+        region_size = std::exchange(other.region_size, 0);
+        object_name = std::move(other.object_name);
+        owner = std::exchange(other.owner, false);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+bool SharedMemoryRegion::create(const std::string& name, size_t size) {
+    release();
+    if (name.empty() || size == 0) {
+        return false;
+    }
+    std::string path = object_path(name);
+
+#ifdef _WIN32
+    // Pagefile-backed sections are zero-filled
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                       static_cast<DWORD>(size), path.c_str());
+    if (!handle) {
+        return false;
+    }
+    void* pages = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!pages) {
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+#else
+    // Drop a stale object left by a previous run so the size is exact
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pages == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return false;
+    }
+#endif
+
+    memory = static_cast<uint8_t*>(pages);
+    region_size = size;
+    object_name = name;
+    owner = true;
+    return true;
+}
+
+bool SharedMemoryRegion::open(const std::string& name, bool writable) {
+    release();
+    if (name.empty()) {
+        return false;
+    }
+    std::string path = object_path(name);
+
+#ifdef _WIN32
+    DWORD access = writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+    HANDLE handle = OpenFileMappingA(access, FALSE, path.c_str());
+    if (!handle) {
+        return false;
+    }
+    void* pages = MapViewOfFile(handle, access, 0, 0, 0);
+    if (!pages) {
+        CloseHandle(handle);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(pages, &info, sizeof(info)) == 0) {
+        UnmapViewOfFile(pages);
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+    region_size = info.RegionSize;
+#else
+    int fd = shm_open(path.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* pages = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pages == MAP_FAILED) {
+        return false;
+    }
+    region_size = size;
+#endif
+
+    memory = static_cast<uint8_t*>(pages);
+    object_name = name;
+    owner = false;
+    return true;
+}
+
+void SharedMemoryRegion::release() {
+    if (!memory) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(memory);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+#else
+    munmap(memory, region_size);
+    if (owner) {
+        shm_unlink(object_path(object_name).c_str());
+    }
+#endif
+    memory = nullptr;
+    region_size = 0;
+    object_name.clear();
+    owner = false;
+}
+
+} // namespace Core
+} // namespace GSCX
@@ -0,0 +1,165 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * Virtual Memory Implementation
+ */
+
+#include "../include/virtual_memory.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace GSCX {
+namespace Core {
+
+static size_t host_page_size() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+VirtualMemoryRegion::~VirtualMemoryRegion() {
+    release();
+}
+
+VirtualMemoryRegion::VirtualMemoryRegion(VirtualMemoryRegion&& other) noexcept
+    : memory(std::exchange(other.memory, nullptr))
+    , mapped_size(std::exchange(other.mapped_size, 0))
+    , region_size(std::exchange(other.region_size, 0)) {
+}
+
+VirtualMemoryRegion& VirtualMemoryRegion::operator=(VirtualMemoryRegion&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory = std::exchange(other.memory, nullptr);
+        mapped_size = std::exchange(other.mapped_size, 0);
+        region_size = std::exchange(other.region_size, 0);
+    }
+    return *this;
+}
+
+bool VirtualMemoryRegion::allocate(size_t size) {
+    release();
+    if (size == 0) {
+        return false;
+    }
+
+    size_t page = host_page_size();
+    size_t mapped = (size + page - 1) & ~(page - 1);
+
+#ifdef _WIN32
+    // Committed pages are demand-zero: they join the working set on first touch
+    void* pages = VirtualAlloc(nullptr, mapped, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!pages) {
+        return false;
+    }
+#else
+    void* pages = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pages == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    memory = static_cast<uint8_t*>(pages);
+    mapped_size = mapped;
+    region_size = size;
+    return true;
+}
+
+void VirtualMemoryRegion::release() {
+    if (!memory) {
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, mapped_size);
+#endif
+    memory = nullptr;
+    mapped_size = 0;
+    region_size = 0;
+}
+
+void VirtualMemoryRegion::discard(size_t offset, size_t size) {
+    if (!memory || offset >= mapped_size || size == 0) {
+        return;
+    }
+
+    // Only whole pages can be dropped; partial edges are zeroed in place
+    size_t page = host_page_size();
+    size_t end = std::min(mapped_size, offset + std::min(size, mapped_size - offset));
+    size_t first = (offset + page - 1) & ~(page - 1);
+    size_t last = end & ~(page - 1);
+    if (first >= last) {
+        std::fill(memory + offset, memory + end, uint8_t(0));
+        return;
+    }
+    std::fill(memory + offset, memory + first, uint8_t(0));
+    std::fill(memory + last, memory + end, uint8_t(0));
+
+#ifdef _WIN32
+    VirtualFree(memory + first, last - first, MEM_DECOMMIT);
+    VirtualAlloc(memory + first, last - first, MEM_COMMIT, PAGE_READWRITE);
+#else
+    madvise(memory + first, last - first, MADV_DONTNEED);
+#endif
+}
+
+size_t VirtualMemoryRegion::get_resident_bytes() const {
+    if (!memory) {
+        return 0;
+    }
+
+    size_t page = host_page_size();
+    size_t pages = mapped_size / page;
+    size_t resident = 0;
+
+    // Query in chunks to bound the scratch buffer
+    constexpr size_t CHUNK_PAGES = 16384;
+#ifdef _WIN32
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> info(std::min(pages, CHUNK_PAGES));
+    for (size_t first = 0; first < pages; first += CHUNK_PAGES) {
+        size_t count = std::min(CHUNK_PAGES, pages - first);
+        for (size_t i = 0; i < count; i++) {
+            info[i].VirtualAddress = memory + (first + i) * page;
+        }
+        if (!QueryWorkingSetEx(GetCurrentProcess(), info.data(),
+                               static_cast<DWORD>(count * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+            return mapped_size;
+        }
+        for (size_t i = 0; i < count; i++) {
+            resident += info[i].VirtualAttributes.Valid ? page : 0;
+        }
+    }
+#else
+#ifdef __APPLE__
+    std::vector<char> residency(std::min(pages, CHUNK_PAGES));
+#else
+    std::vector<unsigned char> residency(std::min(pages, CHUNK_PAGES));
+#endif
+    for (size_t first = 0; first < pages; first += CHUNK_PAGES) {
+        size_t count = std::min(CHUNK_PAGES, pages - first);
+        if (mincore(memory + first * page, count * page, residency.data()) != 0) {
+            return mapped_size;
+        }
+        for (size_t i = 0; i < count; i++) {
+            resident += (residency[i] & 1) ? page : 0;
+        }
+    }
+#endif
+    return resident;
+}
+
+} // namespace Core
+} // namespace GSCX
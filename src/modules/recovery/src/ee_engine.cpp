@@ -1,4 +1,8 @@
 #include "ee_engine.h"
+#include "ee_recompiler.h"
+#include "vu_recompiler.h"
+#include "vu1_thread.h"
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
@@ -9,17 +13,32 @@ namespace recovery {
 // EmotionEngine Implementation
 EmotionEngine::EmotionEngine(HostServicesC* host)
     : host_(host)
+    , main_ram_(nullptr)
+    , bios_(nullptr)
+    , scratch_pad_(nullptr)
+    , unmapped_warnings_(0)
     , initialized_(false)
     , running_(false)
     , cycle_count_(0)
     , instruction_count_(0)
     , pending_exception_(EEException::NONE)
-    , exception_data_(0) {
+    , exception_data_(0)
+    , current_pc_(0)
+    , executing_(false)
+    , in_delay_slot_(false)
+    , branch_pending_(false)
+    , fetch_page_(nullptr)
+    , fetch_page_base_(0)
+    , execution_mode_(EEExecutionMode::INTERPRETER) {
     
     // Initialize memory
-    main_ram_.resize(EEMemoryMap::MAIN_RAM_SIZE);
-    scratch_pad_.resize(EEMemoryMap::SCRATCH_PAD_SIZE);
-    bios_.resize(EEMemoryMap::BIOS_SIZE);
+    memory_.resize(EEMemoryMap::MAIN_RAM_SIZE + EEMemoryMap::BIOS_SIZE + EEMemoryMap::SCRATCH_PAD_SIZE);
+    main_ram_ = memory_.data();
+    bios_ = main_ram_ + EEMemoryMap::MAIN_RAM_SIZE;
+    scratch_pad_ = bios_ + EEMemoryMap::BIOS_SIZE;
+    code_pages_.resize(memory_.size() / EEDecodedPage::PAGE_SIZE);
+    code_page_flags_.resize(code_pages_.size());
+    build_page_table();
     
     // Initialize subsystems
     vu0_ = std::make_unique<VectorUnit>(0, host);
@@ -60,9 +79,15 @@ bool EmotionEngine::initialize() {
     }
     
     // Clear memory
-    std::memset(main_ram_.data(), 0, main_ram_.size());
-    std::memset(scratch_pad_.data(), 0, scratch_pad_.size());
-    std::memset(bios_.data(), 0, bios_.size());
+    std::memset(memory_.data(), 0, memory_.size());
+    for (auto& page : code_pages_) {
+        page.reset();
+    }
+    std::fill(code_page_flags_.begin(), code_page_flags_.end(), 0);
+    fetch_page_ = nullptr;
+    if (recompiler_) {
+        recompiler_->clear();
+    }
     
     initialized_ = true;
     log_info("Emotion Engine initialized successfully");
@@ -77,6 +102,7 @@ void EmotionEngine::shutdown() {
     running_ = false;
     
     // Shutdown subsystems
+    vu1_thread_.reset();
     if (vu0_) vu0_->shutdown();
     if (vu1_) vu1_->shutdown();
     if (iop_) iop_->shutdown();
@@ -91,9 +117,13 @@ void EmotionEngine::reset() {
     
     // Set initial PC to BIOS entry point
     registers_.pc = EEMemoryMap::BIOS_BASE;
+    registers_.npc = registers_.pc + 4;
     
-    // Initialize status register
-    registers_.status = 0x10000000;  // Set BEV bit
+    // Initialize status register: CU0-2, BEV and ERL
+    registers_.status = 0x70400004;
+    registers_.cop0[15] = 0x00002E20;  // PRId
+    registers_.fcr[0] = 0x00002E30;    // FPU implementation/revision
+    registers_.fcr[31] = 0x01000001;
     
     // Reset performance counters
     cycle_count_ = 0;
@@ -103,6 +133,10 @@ void EmotionEngine::reset() {
     pending_exception_ = EEException::NONE;
     exception_data_ = 0;
     
+    executing_ = false;
+    in_delay_slot_ = false;
+    branch_pending_ = false;
+    
     running_ = false;
     
     log_info("Emotion Engine reset");
@@ -119,24 +153,8 @@ void EmotionEngine::execute_cycle() {
         pending_exception_ = EEException::NONE;
     }
     
-    // Fetch instruction
-    uint32_t raw_instruction = read_memory32(static_cast<uint32_t>(registers_.pc));
-    
-    // Decode instruction
-    EEInstruction instruction = decode_instruction(raw_instruction);
-    
-    // Execute instruction
-    execute_instruction(instruction);
-    
-    // Update counters
-    cycle_count_++;
-    instruction_count_++;
-    
-    // Advance PC (unless modified by instruction)
-    if (instruction.type != EEInstructionType::BRANCH && 
-        instruction.type != EEInstructionType::JUMP) {
-        registers_.pc += 4;
-    }
+    // Fetch from the predecoded page, execute and advance pc/npc
+    step();
 }
 
 void EmotionEngine::execute_instruction(const EEInstruction& instr) {
@@ -162,61 +180,113 @@ void EmotionEngine::execute_instruction(const EEInstruction& instr) {
         case EEInstructionType::MULTIPLY_DIVIDE:
             execute_multiply_divide(instr);
             break;
+        case EEInstructionType::FLOATING_POINT:
+            execute_floating_point(instr);
+            break;
         case EEInstructionType::VECTOR:
             execute_vector(instr);
             break;
+        case EEInstructionType::PARALLEL:
+            execute_parallel(instr);
+            break;
         case EEInstructionType::SYSTEM:
             execute_system(instr);
             break;
         default:
-            log_warn("Unknown instruction type");
+            trigger_exception(EEException::RESERVED_INSTRUCTION);
             break;
     }
 }
 
 // Memory operations
-uint32_t EmotionEngine::read_memory32(uint32_t address) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        return *reinterpret_cast<uint32_t*>(ptr);
+void EmotionEngine::read_memory128(uint32_t address, uint64_t value[2]) {
+    value[0] = read_memory64(address);
+    value[1] = read_memory64(address + 8);
+}
+
+void EmotionEngine::write_memory128(uint32_t address, const uint64_t value[2]) {
+    write_memory64(address, value[0]);
+    write_memory64(address + 8, value[1]);
+}
+
+uint64_t EmotionEngine::read_mmio(uint32_t address, uint32_t size) {
+    if (mmio_handler_.read) {
+        return mmio_handler_.read(address, size);
+    }
+    if (unmapped_warnings_ < 16) {
+        unmapped_warnings_++;
+        std::stringstream ss;
+        ss << "Unmapped " << size * 8 << "-bit read at 0x" << std::hex << address;
+        log_warn(ss.str());
     }
     return 0;
 }
 
-uint16_t EmotionEngine::read_memory16(uint32_t address) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        return *reinterpret_cast<uint16_t*>(ptr);
+void EmotionEngine::write_mmio(uint32_t address, uint64_t value, uint32_t size) {
+    if (mmio_handler_.write) {
+        mmio_handler_.write(address, value, size);
+        return;
+    }
+    if (unmapped_warnings_ < 16) {
+        unmapped_warnings_++;
+        std::stringstream ss;
+        ss << "Unmapped " << size * 8 << "-bit write of 0x" << std::hex << value << " at 0x" << address;
+        log_warn(ss.str());
     }
-    return 0;
 }
 
-uint8_t EmotionEngine::read_memory8(uint32_t address) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        return *ptr;
+void EmotionEngine::invalidate_code(uint32_t address, uint32_t size) {
+    if (size == 0) {
+        return;
     }
-    return 0;
+    uint64_t end = std::min<uint64_t>(static_cast<uint64_t>(address) + size, 0x100000000ull);
+    for (uint64_t page = address & ~(EEDecodedPage::PAGE_SIZE - 1); page < end; page += EEDecodedPage::PAGE_SIZE) {
+        uint8_t* ptr = get_memory_pointer(static_cast<uint32_t>(page));
+        if (ptr) {
+            invalidate_code_page(ptr);
+        }
+    }
+}
+
+void EmotionEngine::drop_compiled_code(size_t code_page) {
+    recompiler_->invalidate_page(code_page);
 }
 
-void EmotionEngine::write_memory32(uint32_t address, uint32_t value) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        *reinterpret_cast<uint32_t*>(ptr) = value;
+bool EmotionEngine::set_execution_mode(EEExecutionMode mode) {
+    if (mode == EEExecutionMode::RECOMPILER && !recompiler_) {
+        auto recompiler = std::make_unique<EERecompiler>(this);
+        if (!recompiler->initialize()) {
+            return false;
+        }
+        recompiler_ = std::move(recompiler);
+        log_info("EE recompiler enabled");
     }
+    execution_mode_ = mode;
+    return true;
 }
 
-void EmotionEngine::write_memory16(uint32_t address, uint16_t value) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        *reinterpret_cast<uint16_t*>(ptr) = value;
+void EmotionEngine::set_vu1_threaded(bool threaded) {
+    if (threaded && !vu1_thread_) {
+        vu1_thread_ = std::make_unique<VU1Thread>(vu1_.get());
+        vu1_thread_->start();
+        log_info("VU1 thread started");
+    } else if (!threaded && vu1_thread_) {
+        vu1_thread_.reset();
+        log_info("VU1 thread stopped");
     }
 }
 
-void EmotionEngine::write_memory8(uint32_t address, uint8_t value) {
-    uint8_t* ptr = get_memory_pointer(address);
-    if (ptr) {
-        *ptr = value;
+void EmotionEngine::write_vif1(const uint32_t* data, size_t words) {
+    if (vu1_thread_) {
+        vu1_thread_->write_vif(data, words);
+    } else {
+        vu1_->write_vif(data, words);
+    }
+}
+
+void EmotionEngine::sync_vu1() {
+    if (vu1_thread_) {
+        vu1_thread_->sync();
     }
 }
 
@@ -239,28 +309,62 @@ void EmotionEngine::set_gpr(int reg, uint64_t value) {
 void EmotionEngine::trigger_exception(EEException exception) {
     pending_exception_ = exception;
     
-    // Set cause register
+    // Cause ExcCode
+    uint32_t code = 0;
     switch (exception) {
-        case EEException::SYSCALL:
-            registers_.cause = 8 << 2;
-            break;
-        case EEException::BREAKPOINT:
-            registers_.cause = 9 << 2;
-            break;
-        default:
-            registers_.cause = 0;
-            break;
+        case EEException::INTERRUPT:            code = 0; break;
+        case EEException::TLB_MISS:             code = exception_data_ ? 3 : 2; break;
+        case EEException::ADDRESS_ERROR:        code = exception_data_ ? 5 : 4; break;
+        case EEException::BUS_ERROR:            code = 7; break;
+        case EEException::SYSCALL:              code = 8; break;
+        case EEException::BREAKPOINT:           code = 9; break;
+        case EEException::RESERVED_INSTRUCTION: code = 10; break;
+        case EEException::COPROCESSOR_UNUSABLE: code = 11; break;
+        case EEException::OVERFLOW:             code = 12; break;
+        case EEException::TRAP:                 code = 13; break;
+        default: break;
+    }
+    
+    // Inside an instruction the faulting one is restarted; between
+    // instructions (interrupts) the next one is
+    uint32_t pc = executing_ ? current_pc_ : static_cast<uint32_t>(registers_.pc);
+    bool delay_slot = executing_ ? in_delay_slot_ : branch_pending_;
+    bool nested = (registers_.status & 0x2) != 0;  // EXL
+    
+    registers_.cause = (registers_.cause & ~0xB000007Cu) | (code << 2);
+    if (exception == EEException::COPROCESSOR_UNUSABLE) {
+        registers_.cause |= (exception_data_ & 3) << 28;
+    }
+    if (!nested) {
+        // Save current PC; a delay slot restarts at its branch
+        registers_.epc = delay_slot ? pc - 4 : pc;
+        if (delay_slot) {
+            registers_.cause |= 0x80000000;  // BD
+        }
     }
-    
-    // Save current PC
-    registers_.epc = static_cast<uint32_t>(registers_.pc);
+    registers_.status |= 0x2;
+    exception_data_ = 0;
     
     // Jump to exception handler
-    registers_.pc = 0x80000180;  // General exception vector
+    uint32_t base = (registers_.status & 0x00400000) ? 0xBFC00200 : 0x80000000;  // BEV
+    uint32_t offset = 0x180;
+    if (exception == EEException::INTERRUPT) {
+        offset = 0x200;
+    } else if (exception == EEException::TLB_MISS && !nested) {
+        offset = 0x000;
+    }
+    registers_.pc = base + offset;
+    registers_.npc = registers_.pc + 4;
+    branch_pending_ = false;
 }
 
 void EmotionEngine::handle_interrupt(uint32_t interrupt_mask) {
-    if (interrupt_mask != 0) {
+    // Latch the lines into Cause.IP; taken when IE, EIE and the IM bit
+    // are set and no exception is being handled
+    registers_.cause |= (interrupt_mask & 0xFF) << 8;
+    uint32_t status = registers_.status;
+    bool enabled = (status & 0x1) && (status & 0x10000) && !(status & 0x6);
+    if (enabled && (registers_.cause & status & 0xFF00)) {
         trigger_exception(EEException::INTERRUPT);
     }
 }
@@ -286,7 +390,8 @@ void EmotionEngine::dump_memory(uint32_t start, uint32_t size) const {
         ss << std::hex << std::setfill('0') << std::setw(8) << (start + i) << ": ";
         
         for (int j = 0; j < 16 && (i + j) < size; j++) {
-            uint8_t byte = read_memory8(start + i + j);
+            const uint8_t* ptr = get_memory_pointer(start + i + j);
+            uint8_t byte = ptr ? *ptr : 0;
             ss << std::setw(2) << static_cast<int>(byte) << " ";
         }
         ss << "\n";
@@ -296,177 +401,79 @@ void EmotionEngine::dump_memory(uint32_t start, uint32_t size) const {
 }
 
 // Private helper functions
-void EmotionEngine::log_info(const std::string& message) {
+void EmotionEngine::log_info(const std::string& message) const {
     if (host_ && host_->log_info) {
         host_->log_info(("[EE] " + message).c_str());
     }
 }
 
-void EmotionEngine::log_warn(const std::string& message) {
+void EmotionEngine::log_warn(const std::string& message) const {
     if (host_ && host_->log_warn) {
         host_->log_warn(("[EE] " + message).c_str());
     }
 }
 
-void EmotionEngine::log_error(const std::string& message) {
+void EmotionEngine::log_error(const std::string& message) const {
     if (host_ && host_->log_error) {
         host_->log_error(("[EE] " + message).c_str());
     }
 }
 
-EEInstruction EmotionEngine::decode_instruction(uint32_t raw) {
-    EEInstruction instr;
-    instr.raw = raw;
-    
-    // Extract fields
-    instr.opcode = (raw >> 26) & 0x3F;
-    instr.rs = (raw >> 21) & 0x1F;
-    instr.rt = (raw >> 16) & 0x1F;
-    instr.rd = (raw >> 11) & 0x1F;
-    instr.shamt = (raw >> 6) & 0x1F;
-    instr.function = raw & 0x3F;
-    instr.immediate = raw & 0xFFFF;
-    instr.target = raw & 0x3FFFFFF;
-    
-    // Determine instruction type based on opcode
-    switch (instr.opcode) {
-        case 0x00:  // SPECIAL
-            switch (instr.function) {
-                case 0x20: case 0x21: case 0x22: case 0x23:  // ADD, ADDU, SUB, SUBU
-                    instr.type = EEInstructionType::ARITHMETIC;
-                    break;
-                case 0x24: case 0x25: case 0x26: case 0x27:  // AND, OR, XOR, NOR
-                    instr.type = EEInstructionType::LOGICAL;
-                    break;
-                default:
-                    instr.type = EEInstructionType::UNKNOWN;
-                    break;
-            }
-            break;
-        case 0x08: case 0x09:  // ADDI, ADDIU
-            instr.type = EEInstructionType::ARITHMETIC;
-            break;
-        case 0x0C: case 0x0D: case 0x0E:  // ANDI, ORI, XORI
-            instr.type = EEInstructionType::LOGICAL;
-            break;
-        case 0x23: case 0x2B:  // LW, SW
-            instr.type = EEInstructionType::LOAD_STORE;
-            break;
-        case 0x02: case 0x03:  // J, JAL
-            instr.type = EEInstructionType::JUMP;
-            break;
-        case 0x04: case 0x05:  // BEQ, BNE
-            instr.type = EEInstructionType::BRANCH;
-            break;
-        default:
-            instr.type = EEInstructionType::UNKNOWN;
-            break;
-    }
-    
-    return instr;
-}
-
-// Simplified instruction execution (basic implementations)
-void EmotionEngine::execute_arithmetic(const EEInstruction& instr) {
-    // Basic arithmetic operations
-    switch (instr.function) {
-        case 0x20:  // ADD
-            set_gpr(instr.rd, get_gpr(instr.rs) + get_gpr(instr.rt));
-            break;
-        case 0x22:  // SUB
-            set_gpr(instr.rd, get_gpr(instr.rs) - get_gpr(instr.rt));
-            break;
+void EmotionEngine::map_pages(uint32_t address, uint8_t* host, uint32_t size) {
+    for (uint32_t offset = 0; offset < size; offset += EEMemoryMap::PAGE_SIZE) {
+        page_table_[(address + offset) >> EEMemoryMap::PAGE_SHIFT] = host + offset;
     }
 }
 
-void EmotionEngine::execute_logical(const EEInstruction& instr) {
-    // Basic logical operations
-    switch (instr.function) {
-        case 0x24:  // AND
-            set_gpr(instr.rd, get_gpr(instr.rs) & get_gpr(instr.rt));
-            break;
-        case 0x25:  // OR
-            set_gpr(instr.rd, get_gpr(instr.rs) | get_gpr(instr.rt));
-            break;
+void EmotionEngine::build_page_table() {
+    page_table_.assign(EEMemoryMap::PAGE_COUNT, nullptr);
+    
+    // Physical RAM and BIOS, seen through KUSEG, KSEG0 and KSEG1
+    const uint32_t segments[] = { 0, EEMemoryMap::KSEG0_BASE, EEMemoryMap::KSEG1_BASE };
+    for (uint32_t segment : segments) {
+        map_pages(segment + EEMemoryMap::MAIN_RAM_BASE, main_ram_, EEMemoryMap::MAIN_RAM_SIZE);
+        map_pages(segment + EEMemoryMap::BIOS_BASE, bios_, EEMemoryMap::BIOS_SIZE);
     }
+    
+    // Fixed KUSEG mappings the BIOS installs in the TLB
+    map_pages(EEMemoryMap::RAM_UNCACHED_BASE, main_ram_, EEMemoryMap::MAIN_RAM_SIZE);
+    map_pages(EEMemoryMap::RAM_UNCACHED_ACCEL_BASE, main_ram_, EEMemoryMap::MAIN_RAM_SIZE);
+    map_pages(EEMemoryMap::SCRATCH_PAD_BASE, scratch_pad_, EEMemoryMap::SCRATCH_PAD_SIZE);
 }
 
-void EmotionEngine::execute_shift(const EEInstruction& instr) {
-    // Shift operations would be implemented here
-}
-
-void EmotionEngine::execute_branch(const EEInstruction& instr) {
-    // Branch operations would be implemented here
-}
-
-void EmotionEngine::execute_jump(const EEInstruction& instr) {
-    // Jump operations would be implemented here
-}
-
-void EmotionEngine::execute_load_store(const EEInstruction& instr) {
-    // Load/store operations would be implemented here
-}
-
-void EmotionEngine::execute_multiply_divide(const EEInstruction& instr) {
-    // Multiply/divide operations would be implemented here
-}
-
-void EmotionEngine::execute_vector(const EEInstruction& instr) {
-    // Vector operations would be implemented here
-}
-
-void EmotionEngine::execute_system(const EEInstruction& instr) {
-    // System operations (syscalls, etc.) would be implemented here
-}
+// VectorUnit Implementation. Execution lives in vu_interpreter.cpp and
+// vu_recompiler.cpp.
+namespace {
 
-bool EmotionEngine::is_valid_address(uint32_t address) const {
-    // Check if address is in valid memory range
-    if (address >= EEMemoryMap::MAIN_RAM_BASE && 
-        address < EEMemoryMap::MAIN_RAM_BASE + EEMemoryMap::MAIN_RAM_SIZE) {
-        return true;
-    }
-    if (address >= EEMemoryMap::SCRATCH_PAD_BASE && 
-        address < EEMemoryMap::SCRATCH_PAD_BASE + EEMemoryMap::SCRATCH_PAD_SIZE) {
-        return true;
-    }
-    if (address >= EEMemoryMap::BIOS_BASE && 
-        address < EEMemoryMap::BIOS_BASE + EEMemoryMap::BIOS_SIZE) {
-        return true;
-    }
-    return false;
+// Position-dependent word hash (splitmix64 finalizer)
+uint64_t hash_micro_word(uint32_t index, uint32_t value) {
+    uint64_t x = (static_cast<uint64_t>(index) << 32) | value;
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
 }
 
-uint8_t* EmotionEngine::get_memory_pointer(uint32_t address) {
-    if (address >= EEMemoryMap::MAIN_RAM_BASE && 
-        address < EEMemoryMap::MAIN_RAM_BASE + EEMemoryMap::MAIN_RAM_SIZE) {
-        return &main_ram_[address - EEMemoryMap::MAIN_RAM_BASE];
-    }
-    if (address >= EEMemoryMap::SCRATCH_PAD_BASE && 
-        address < EEMemoryMap::SCRATCH_PAD_BASE + EEMemoryMap::SCRATCH_PAD_SIZE) {
-        return &scratch_pad_[address - EEMemoryMap::SCRATCH_PAD_BASE];
-    }
-    if (address >= EEMemoryMap::BIOS_BASE && 
-        address < EEMemoryMap::BIOS_BASE + EEMemoryMap::BIOS_SIZE) {
-        return &bios_[address - EEMemoryMap::BIOS_BASE];
-    }
-    return nullptr;
-}
+} // namespace
 
-// VectorUnit Implementation (simplified)
 VectorUnit::VectorUnit(int unit_id, HostServicesC* host)
     : unit_id_(unit_id)
     , host_(host)
+    , micro_writes_(0)
     , initialized_(false)
-    , pc_(0) {
+    , running_(false)
+    , ending_(false)
+    , pc_(0)
+    , next_pc_(8)
+    , clamp_mode_(VUClampMode::FAST)
+    , execution_mode_(VUExecutionMode::INTERPRETER) {
     
     // Initialize memory
-    if (unit_id == 0) {
-        micro_memory_.resize(4096);   // VU0: 4KB micro memory
-        data_memory_.resize(4096);    // VU0: 4KB data memory
-    } else {
-        micro_memory_.resize(16384);  // VU1: 16KB micro memory
-        data_memory_.resize(16384);   // VU1: 16KB data memory
-    }
+    uint32_t size = unit_id == 0 ? VU0_MEMORY_SIZE : VU1_MEMORY_SIZE;
+    micro_memory_.resize(size / 4);
+    data_memory_.resize(size);
+    micro_mask_ = size - 1;
+    data_mask_ = size - 1;
 }
 
 VectorUnit::~VectorUnit() {
@@ -489,29 +496,33 @@ bool VectorUnit::initialize() {
 
 void VectorUnit::shutdown() {
     initialized_ = false;
+    running_ = false;
     log_info("VU" + std::to_string(unit_id_) + " shutdown");
 }
 
 void VectorUnit::reset() {
-    // Clear all registers
-    std::memset(vf_registers_, 0, sizeof(vf_registers_));
-    std::memset(vi_registers_, 0, sizeof(vi_registers_));
+    // Clear all registers; VF0 is the constant (0, 0, 0, 1)
+    std::memset(&registers_, 0, sizeof(registers_));
+    registers_.vf[0][3] = 1.0f;
+    registers_.r = 0x3F800000;
+    cmsar0_ = 0;
+    vif_top_ = vif_itop_ = 0;
+    std::memset(&vif_, 0, sizeof(vif_));
+    std::memset(&upper_, 0, sizeof(upper_));
     
     // Clear memory
     std::fill(micro_memory_.begin(), micro_memory_.end(), 0);
     std::fill(data_memory_.begin(), data_memory_.end(), 0);
+    program_hash_ = 0;
+    for (uint32_t i = 0; i < micro_memory_.size(); i++) {
+        program_hash_ += hash_micro_word(i, 0);
+    }
+    micro_writes_++;
     
+    running_ = false;
+    ending_ = false;
     pc_ = 0;
-}
-
-void VectorUnit::execute_micro_program(uint32_t start_address) {
-    pc_ = start_address;
-    log_info("VU" + std::to_string(unit_id_) + " executing micro program at 0x" + 
-             std::to_string(start_address));
-}
-
-void VectorUnit::execute_vector_instruction(uint32_t instruction) {
-    // Vector instruction execution would be implemented here
+    next_pc_ = 8;
 }
 
 uint32_t VectorUnit::read_micro_mem(uint32_t address) {
@@ -523,33 +534,56 @@ uint32_t VectorUnit::read_micro_mem(uint32_t address) {
 
 void VectorUnit::write_micro_mem(uint32_t address, uint32_t value) {
     if (address < micro_memory_.size()) {
+        // The hash is a sum over words, so a write swaps one term
+        program_hash_ += hash_micro_word(address, value) - hash_micro_word(address, micro_memory_[address]);
         micro_memory_[address] = value;
+        micro_writes_++;
+    }
+}
+
+bool VectorUnit::set_execution_mode(VUExecutionMode mode) {
+    if (mode == VUExecutionMode::RECOMPILER && !recompiler_) {
+        auto recompiler = std::make_unique<VURecompiler>(this);
+        if (!recompiler->initialize()) {
+            return false;
+        }
+        recompiler_ = std::move(recompiler);
+        log_info("VU" + std::to_string(unit_id_) + " recompiler enabled");
+    }
+    execution_mode_ = mode;
+    return true;
+}
+
+void VectorUnit::set_clamp_mode(VUClampMode mode) {
+    if (mode != clamp_mode_ && recompiler_) {
+        recompiler_->clear();
     }
+    clamp_mode_ = mode;
 }
 
 float VectorUnit::get_vf_register(int reg, int component) const {
     if (reg >= 0 && reg < 32 && component >= 0 && component < 4) {
-        return vf_registers_[reg][component];
+        return registers_.vf[reg][component];
     }
     return 0.0f;
 }
 
 void VectorUnit::set_vf_register(int reg, int component, float value) {
-    if (reg >= 0 && reg < 32 && component >= 0 && component < 4) {
-        vf_registers_[reg][component] = value;
+    if (reg > 0 && reg < 32 && component >= 0 && component < 4) {
+        registers_.vf[reg][component] = value;
     }
 }
 
 uint16_t VectorUnit::get_vi_register(int reg) const {
     if (reg >= 0 && reg < 16) {
-        return vi_registers_[reg];
+        return registers_.vi[reg];
     }
     return 0;
 }
 
 void VectorUnit::set_vi_register(int reg, uint16_t value) {
-    if (reg >= 0 && reg < 16) {
-        vi_registers_[reg] = value;
+    if (reg > 0 && reg < 16) {
+        registers_.vi[reg] = value;
     }
 }
 
@@ -559,6 +593,12 @@ void VectorUnit::log_info(const std::string& message) {
     }
 }
 
+void VectorUnit::log_warn(const std::string& message) {
+    if (host_ && host_->log_warn) {
+        host_->log_warn(("[VU" + std::to_string(unit_id_) + "] " + message).c_str());
+    }
+}
+
 // IOProcessor Implementation (simplified)
 IOProcessor::IOProcessor(HostServicesC* host)
     : host_(host)
@@ -2,6 +2,8 @@
 #include "recovery_i18n.h"
 #include "host_services_c.h"
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -16,12 +18,15 @@ struct EERegisters {
     
     // Special Registers
     uint64_t pc;          // Program Counter
+    uint64_t npc;         // Next PC (branch target while a delay slot executes)
     uint64_t hi, lo;      // Multiply/Divide results
     uint64_t hi1, lo1;    // Additional hi/lo for parallel operations
+    uint64_t sa;          // Shift amount register (bytes) for QFSRV
     
     // Floating Point Registers
     float fpr[32];        // 32 floating point registers
     uint32_t fcr[32];     // Floating point control registers
+    float fpu_acc;        // FPU accumulator (ADDA, MADD, ...)
     
     // Vector Unit Registers (VU0/VU1)
     float vf[32][4];      // Vector float registers (x,y,z,w)
@@ -32,6 +37,7 @@ struct EERegisters {
     uint32_t cause;       // Cause register
     uint32_t epc;         // Exception PC
     uint32_t badvaddr;    // Bad virtual address
+    uint32_t cop0[32];    // Remaining COP0 registers, by number
 };
 
 // EE Memory Management
@@ -44,6 +50,28 @@ struct EEMemoryMap {
     static constexpr uint32_t SCRATCH_PAD_BASE = 0x70000000;
     static constexpr uint32_t BIOS_BASE = 0x1FC00000;
     static constexpr uint32_t IOP_RAM_BASE = 0x1C000000;
+    
+    // Segments: KSEG0 (cached) and KSEG1 (uncached) mirror the low 512MB
+    // of the physical space. KUSEG goes through the TLB; the BIOS maps RAM
+    // at 0 plus uncached and uncached-accelerated mirrors, and the
+    // scratchpad, which the page table fixes in place.
+    static constexpr uint32_t KSEG0_BASE = 0x80000000;
+    static constexpr uint32_t KSEG1_BASE = 0xA0000000;
+    static constexpr uint32_t RAM_UNCACHED_BASE = 0x20000000;
+    static constexpr uint32_t RAM_UNCACHED_ACCEL_BASE = 0x30000000;
+    
+    // Page table granularity
+    static constexpr uint32_t PAGE_SHIFT = 12;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_SHIFT;
+    static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+    static constexpr uint32_t PAGE_COUNT = 1u << (32 - PAGE_SHIFT);
+};
+
+// Slow path for addresses without a page table entry (hardware
+// registers, GS, IOP space). Unset callbacks read 0 and drop writes.
+struct EEMMIOHandler {
+    std::function<uint64_t(uint32_t address, uint32_t size)> read;
+    std::function<void(uint32_t address, uint64_t value, uint32_t size)> write;
 };
 
 // EE Instruction Types
@@ -55,15 +83,65 @@ enum class EEInstructionType {
     JUMP,
     LOAD_STORE,
     MULTIPLY_DIVIDE,
+    FLOATING_POINT,
     VECTOR,
+    PARALLEL,
     SYSTEM,
     UNKNOWN
 };
 
+// EE Operations, resolved once by the decoder
+enum class EEOp : uint16_t {
+    INVALID,
+    // Arithmetic
+    ADD, ADDU, SUB, SUBU, ADDI, ADDIU, DADD, DADDU, DSUB, DSUBU, DADDI, DADDIU,
+    SLT, SLTU, SLTI, SLTIU, LUI, MOVZ, MOVN,
+    // Logical
+    AND, OR, XOR, NOR, ANDI, ORI, XORI,
+    // Shift
+    SLL, SRL, SRA, SLLV, SRLV, SRAV, DSLL, DSRL, DSRA, DSLLV, DSRLV, DSRAV,
+    DSLL32, DSRL32, DSRA32, MFSA, MTSA, MTSAB, MTSAH,
+    // Branch
+    BEQ, BNE, BLEZ, BGTZ, BEQL, BNEL, BLEZL, BGTZL,
+    BLTZ, BGEZ, BLTZL, BGEZL, BLTZAL, BGEZAL, BLTZALL, BGEZALL,
+    BC0F, BC0T, BC0FL, BC0TL, BC1F, BC1T, BC1FL, BC1TL,
+    // Jump
+    J, JAL, JR, JALR,
+    // Load/store
+    LB, LBU, LH, LHU, LW, LWU, LWL, LWR, LD, LDL, LDR, LQ,
+    SB, SH, SW, SWL, SWR, SD, SDL, SDR, SQ, LWC1, SWC1,
+    // Multiply/divide
+    MULT, MULTU, DIV, DIVU, MADD, MADDU, MULT1, MULTU1, DIV1, DIVU1, MADD1, MADDU1,
+    MFHI, MTHI, MFLO, MTLO, MFHI1, MTHI1, MFLO1, MTLO1,
+    // Floating point (COP1)
+    MFC1, MTC1, CFC1, CTC1,
+    ADD_S, SUB_S, MUL_S, DIV_S, SQRT_S, ABS_S, MOV_S, NEG_S, RSQRT_S,
+    ADDA_S, SUBA_S, MULA_S, MADD_S, MSUB_S, MADDA_S, MSUBA_S,
+    CVT_W_S, CVT_S_W, MAX_S, MIN_S, C_F_S, C_EQ_S, C_LT_S, C_LE_S,
+    // Parallel (MMI), on the full 128-bit GPRs and HI/LO
+    PADDW, PSUBW, PCGTW, PMAXW, PADDH, PSUBH, PCGTH, PMAXH, PADDB, PSUBB, PCGTB,
+    PADDSW, PSUBSW, PEXTLW, PPACW, PADDSH, PSUBSH, PEXTLH, PPACH,
+    PADDSB, PSUBSB, PEXTLB, PPACB, PEXT5, PPAC5,
+    PABSW, PCEQW, PMINW, PADSBH, PABSH, PCEQH, PMINH, PCEQB,
+    PADDUW, PSUBUW, PEXTUW, PADDUH, PSUBUH, PEXTUH, PADDUB, PSUBUB, PEXTUB, QFSRV,
+    PMADDW, PSLLVW, PSRLVW, PMSUBW, PMFHI, PMFLO, PINTH, PMULTW, PDIVW, PCPYLD,
+    PMADDH, PHMADH, PAND, PXOR, PMSUBH, PHMSBH, PEXEH, PREVH, PMULTH, PDIVBW, PEXEW, PROT3W,
+    PMADDUW, PSRAVW, PMTHI, PMTLO, PINTEH, PMULTUW, PDIVUW, PCPYUD, POR, PNOR,
+    PEXCH, PCPYH, PEXCW,
+    PLZCW, PMFHL, PMTHL, PSLLH, PSRLH, PSRAH, PSLLW, PSRLW, PSRAW,
+    // Vector (COP2 / VU0 macro mode)
+    COP2, LQC2, SQC2,
+    // System
+    SYSCALL, BREAK, SYNC, CACHE, PREF,
+    TGE, TGEU, TLT, TLTU, TEQ, TNE, TGEI, TGEIU, TLTI, TLTIU, TEQI, TNEI,
+    MFC0, MTC0, TLBR, TLBWI, TLBWR, TLBP, ERET, EI, DI
+};
+
 // EE Instruction Structure
 struct EEInstruction {
     uint32_t raw;                    // Raw 32-bit instruction
     EEInstructionType type;
+    EEOp op;
     uint8_t opcode;                  // Primary opcode
     uint8_t rs, rt, rd;             // Register fields
     uint16_t immediate;              // Immediate value
@@ -72,6 +150,16 @@ struct EEInstruction {
     uint8_t shamt;                   // Shift amount
 };
 
+// Predecoded instructions of one 4KB page. Decoded on first execution and
+// marked invalid by any write into the page.
+struct EEDecodedPage {
+    static constexpr uint32_t PAGE_SIZE = EEMemoryMap::PAGE_SIZE;
+    static constexpr uint32_t INSTRUCTIONS = PAGE_SIZE / 4;
+    
+    bool valid;
+    EEInstruction instructions[INSTRUCTIONS];
+};
+
 // EE Exception Types
 enum class EEException {
     NONE,
@@ -87,9 +175,18 @@ enum class EEException {
     TRAP
 };
 
+// How execute() runs guest code
+enum class EEExecutionMode {
+    INTERPRETER,
+    RECOMPILER
+};
+
 // Forward declarations
 class VectorUnit;
 class IOProcessor;
+class EERecompiler;
+class VURecompiler;
+class VU1Thread;
 
 // Main EE (Emotion Engine) Class
 class EmotionEngine {
@@ -103,32 +200,62 @@ public:
     void reset();
     
     // Execution
+    void start() { running_ = initialized_; }
+    void stop() { running_ = false; }
+    bool is_running() const { return running_; }
+    
     void execute_cycle();
+    // Runs up to `max_instructions` while running; returns the count executed
+    uint64_t execute(uint64_t max_instructions);
+    // False if the recompiler cannot run on this host
+    bool set_execution_mode(EEExecutionMode mode);
+    EEExecutionMode get_execution_mode() const { return execution_mode_; }
     void execute_instruction(const EEInstruction& instr);
     
-    // Memory operations
-    uint32_t read_memory32(uint32_t address);
-    uint16_t read_memory16(uint32_t address);
-    uint8_t read_memory8(uint32_t address);
+    // Memory operations: one page table lookup, MMIO on a null entry
+    uint64_t read_memory64(uint32_t address) { return read_memory<uint64_t>(address); }
+    uint32_t read_memory32(uint32_t address) { return read_memory<uint32_t>(address); }
+    uint16_t read_memory16(uint32_t address) { return read_memory<uint16_t>(address); }
+    uint8_t read_memory8(uint32_t address) { return read_memory<uint8_t>(address); }
+    void read_memory128(uint32_t address, uint64_t value[2]);
     
-    void write_memory32(uint32_t address, uint32_t value);
-    void write_memory16(uint32_t address, uint16_t value);
-    void write_memory8(uint32_t address, uint8_t value);
+    void write_memory64(uint32_t address, uint64_t value) { write_memory<uint64_t>(address, value); }
+    void write_memory32(uint32_t address, uint32_t value) { write_memory<uint32_t>(address, value); }
+    void write_memory16(uint32_t address, uint16_t value) { write_memory<uint16_t>(address, value); }
+    void write_memory8(uint32_t address, uint8_t value) { write_memory<uint8_t>(address, value); }
+    void write_memory128(uint32_t address, const uint64_t value[2]);
+    
+    void set_mmio_handler(EEMMIOHandler handler) { mmio_handler_ = std::move(handler); }
+    
+    // Host pointer of a mapped page, null for MMIO; indexed by address >> PAGE_SHIFT
+    uint8_t* const* get_page_table() const { return page_table_.data(); }
+    
+    // Drops predecoded code in a range written behind the EE's back (DMA, loaders)
+    void invalidate_code(uint32_t address, uint32_t size);
     
     // Register access
     uint64_t get_gpr(int reg) const;
     void set_gpr(int reg, uint64_t value);
     
     uint64_t get_pc() const { return registers_.pc; }
-    void set_pc(uint64_t pc) { registers_.pc = pc; }
+    void set_pc(uint64_t pc) { registers_.pc = pc; registers_.npc = pc + 4; branch_pending_ = false; }
     
     // Exception handling
     void trigger_exception(EEException exception);
     void handle_interrupt(uint32_t interrupt_mask);
     
-    // Vector Units
+    // Vector Units. With VU1 threaded, get_vu1() first waits for the work
+    // queued for it; the pointer is safe to use until more is queued.
     VectorUnit* get_vu0() { return vu0_.get(); }
-    VectorUnit* get_vu1() { return vu1_.get(); }
+    VectorUnit* get_vu1() { sync_vu1(); return vu1_.get(); }
+    
+    // Runs VU1 on its own host thread (see VU1Thread)
+    void set_vu1_threaded(bool threaded);
+    bool is_vu1_threaded() const { return vu1_thread_ != nullptr; }
+    // VIF1 data as DMA channel 1 delivers it; queued when VU1 is threaded
+    void write_vif1(const uint32_t* data, size_t words);
+    // Waits for queued VU1 work; returns at once unless VU1 is threaded
+    void sync_vu1();
     
     // IOP interface
     IOProcessor* get_iop() { return iop_.get(); }
@@ -142,12 +269,66 @@ public:
     uint64_t get_instruction_count() const { return instruction_count_; }
     
 private:
+    friend class EERecompiler;
+    
     // Internal functions
-    void log_info(const std::string& message);
-    void log_warn(const std::string& message);
-    void log_error(const std::string& message);
+    void log_info(const std::string& message) const;
+    void log_warn(const std::string& message) const;
+    void log_error(const std::string& message) const;
     
     EEInstruction decode_instruction(uint32_t raw);
+    void step();
+    const EEInstruction* fetch_instruction(uint32_t pc);
+    EEDecodedPage* get_decoded_page(uint32_t address);
+    size_t get_code_page_index(const uint8_t* ptr) const {
+        return static_cast<size_t>(ptr - memory_.data()) >> EEMemoryMap::PAGE_SHIFT;
+    }
+    void invalidate_code_page(const uint8_t* ptr) {
+        // Only marked: the page may hold the instruction being executed
+        size_t index = get_code_page_index(ptr);
+        if (code_page_flags_[index]) {
+            code_page_flags_[index] = 0;
+            code_pages_[index]->valid = false;
+            if (recompiler_) {
+                drop_compiled_code(index);
+            }
+        }
+    }
+    void drop_compiled_code(size_t code_page);
+    
+    template <typename T>
+    T read_memory(uint32_t address) {
+        const uint8_t* page = page_table_[address >> EEMemoryMap::PAGE_SHIFT];
+        if (page) {
+            T value;
+            std::memcpy(&value, page + (address & EEMemoryMap::PAGE_MASK), sizeof(T));
+            return value;
+        }
+        return static_cast<T>(read_mmio(address, sizeof(T)));
+    }
+    
+    // Writes drop any predecoded code in the page they touch
+    template <typename T>
+    void write_memory(uint32_t address, T value) {
+        uint8_t* page = page_table_[address >> EEMemoryMap::PAGE_SHIFT];
+        if (page) {
+            std::memcpy(page + (address & EEMemoryMap::PAGE_MASK), &value, sizeof(T));
+            invalidate_code_page(page);
+            return;
+        }
+        write_mmio(address, value, sizeof(T));
+    }
+    
+    uint64_t read_mmio(uint32_t address, uint32_t size);
+    void write_mmio(uint32_t address, uint64_t value, uint32_t size);
+    
+    // Delay slot handling: a taken branch redirects npc so the slot runs
+    // first; a not-taken branch-likely skips the slot
+    void branch(bool taken, uint32_t target, bool likely);
+    void raise_address_error(uint32_t address, bool store);
+    bool check_cop1_usable();
+    bool check_cop2_usable();
+    void set_fpu_flags(uint32_t flags);
     
     // Instruction execution
     void execute_arithmetic(const EEInstruction& instr);
@@ -157,25 +338,48 @@ private:
     void execute_jump(const EEInstruction& instr);
     void execute_load_store(const EEInstruction& instr);
     void execute_multiply_divide(const EEInstruction& instr);
+    void execute_floating_point(const EEInstruction& instr);
     void execute_vector(const EEInstruction& instr);
+    void execute_parallel(const EEInstruction& instr);
     void execute_system(const EEInstruction& instr);
     
+    // COP0 register access by number
+    uint32_t read_cop0(uint32_t reg) const;
+    void write_cop0(uint32_t reg, uint32_t value);
+    
     // Memory management
-    bool is_valid_address(uint32_t address) const;
-    uint8_t* get_memory_pointer(uint32_t address);
+    void map_pages(uint32_t address, uint8_t* host, uint32_t size);
+    void build_page_table();
+    bool is_valid_address(uint32_t address) const {
+        return page_table_[address >> EEMemoryMap::PAGE_SHIFT] != nullptr;
+    }
+    uint8_t* get_memory_pointer(uint32_t address) {
+        uint8_t* page = page_table_[address >> EEMemoryMap::PAGE_SHIFT];
+        return page ? page + (address & EEMemoryMap::PAGE_MASK) : nullptr;
+    }
+    const uint8_t* get_memory_pointer(uint32_t address) const {
+        const uint8_t* page = page_table_[address >> EEMemoryMap::PAGE_SHIFT];
+        return page ? page + (address & EEMemoryMap::PAGE_MASK) : nullptr;
+    }
     
     // Member variables
     HostServicesC* host_;
     EERegisters registers_;
     
-    // Memory
-    std::vector<uint8_t> main_ram_;
-    std::vector<uint8_t> scratch_pad_;
-    std::vector<uint8_t> bios_;
+    // Memory: RAM, BIOS and scratchpad share one allocation so a host
+    // pointer converts to a code page index with a subtraction
+    std::vector<uint8_t> memory_;
+    uint8_t* main_ram_;
+    uint8_t* bios_;
+    uint8_t* scratch_pad_;
+    std::vector<uint8_t*> page_table_;
+    EEMMIOHandler mmio_handler_;
+    uint32_t unmapped_warnings_;
     
     // Subsystems
     std::unique_ptr<VectorUnit> vu0_;
     std::unique_ptr<VectorUnit> vu1_;
+    std::unique_ptr<VU1Thread> vu1_thread_;     // Declared after vu1_: stops first
     std::unique_ptr<IOProcessor> iop_;
     
     // State
@@ -189,11 +393,113 @@ private:
     // Exception state
     EEException pending_exception_;
     uint32_t exception_data_;
+    
+    // Delay slot state
+    uint32_t current_pc_;           // Address of the executing instruction
+    bool executing_;
+    bool in_delay_slot_;            // The executing instruction is a delay slot
+    bool branch_pending_;           // The next instruction is a delay slot
+    
+    // Predecoded code, one entry per 4KB page of RAM, BIOS and scratchpad;
+    // the flag is set while a page holds valid decoded or compiled code
+    std::vector<std::unique_ptr<EEDecodedPage>> code_pages_;
+    std::vector<uint8_t> code_page_flags_;
+    EEDecodedPage* fetch_page_;
+    uint32_t fetch_page_base_;
+    
+    EEExecutionMode execution_mode_;
+    std::unique_ptr<EERecompiler> recompiler_;
+};
+
+// How VU floats map onto host floats. The VU has no infinities, NaNs or
+// denormals and rounds toward zero. FAST clamps results to the largest
+// finite value; ACCURATE also clamps operands, flushes denormal operands
+// to zero and rounds toward zero.
+enum class VUClampMode {
+    FAST,
+    ACCURATE
+};
+
+// VU register file; a standard-layout struct so generated code can
+// address it
+struct VURegisters {
+    alignas(16) float vf[32][4];    // Vector float registers, VF0 = (0, 0, 0, 1)
+    alignas(16) float acc[4];
+    uint16_t vi[16];                // Vector integer registers
+    float i;
+    float q;
+    float p;
+    uint32_t r;
+    uint32_t status_flag;
+    uint32_t mac_flag;
+    uint32_t clip_flag;
+};
+
+enum class VUExecutionMode {
+    INTERPRETER,
+    RECOMPILER
+};
+
+// VIF command stream state. A command and its data may arrive split
+// across write_vif calls, as DMA delivers them.
+struct VIFState {
+    uint32_t command;               // Command whose data is pending; UNPACK keeps its USN bit
+    uint32_t remaining;             // Data words still to come for it
+    uint32_t address;               // MPG: micro memory word; UNPACK: first quadword; STROW/STCOL: index
+    uint32_t element;               // UNPACK: elements written
+    uint32_t elements_left;
+    uint32_t element_size;          // Bytes
+    uint8_t staged[16];             // Bytes of a partial element
+    uint32_t staged_count;
+    uint32_t cycle_length;          // STCYCL CL/WL: WL of every CL quadwords are written
+    uint32_t write_length;
+    uint32_t mode;                  // STMOD: 0 none, 1 add ROW, 2 add ROW and update it
+    uint32_t mask;                  // STMASK (not applied)
+    uint32_t row[4];
+    uint32_t col[4];
+    uint32_t base;                  // Double buffering: TOPS alternates between BASE
+    uint32_t offset;                // and BASE + OFFSET on every program start
+    uint32_t tops;
+    bool dbf;
+};
+
+// Result of an upper (FMAC) instruction, held until the lower instruction
+// of the same pair has read its operands
+struct VUUpperResult {
+    alignas(16) float value[4];
+    float* target;                  // VF register or ACC; null if nothing is written
+    uint32_t dest;                  // xyzw field, x in bit 3
+    bool write_mac;                 // MAC and status flags
+    uint32_t mac;
+    bool write_clip;
+    uint32_t clip;
 };
 
 // Vector Unit Class (VU0/VU1)
 class VectorUnit {
 public:
+    // Micro memory: VU0 4KB, VU1 16KB. Data memory: VU0 4KB, VU1 16KB.
+    static constexpr uint32_t VU0_MEMORY_SIZE = 4 * 1024;
+    static constexpr uint32_t VU1_MEMORY_SIZE = 16 * 1024;
+    // Upper limit for execute_micro_program before it gives up on a program
+    static constexpr uint64_t MAX_PROGRAM_INSTRUCTIONS = 1ull << 24;
+
+    // CFC2/CTC2 register numbers past the 16 integer registers
+    enum ControlRegister {
+        STATUS_FLAG = 16,
+        MAC_FLAG = 17,
+        CLIPPING_FLAG = 18,
+        R_REGISTER = 20,
+        I_REGISTER = 21,
+        Q_REGISTER = 22,
+        P_REGISTER = 23,
+        TPC = 26,
+        CMSAR0 = 27,
+        FBRST = 28,
+        VPU_STAT = 29,
+        CMSAR1 = 31
+    };
+
     VectorUnit(int unit_id, HostServicesC* host);
     ~VectorUnit();
     
@@ -201,13 +507,41 @@ public:
     void shutdown();
     void reset();
     
-    // Execution
+    // Execution. Micro memory addresses are in bytes, 8-byte aligned.
+    // execute_micro_program runs to the end of the program (E bit);
+    // start_micro_program/run let the caller interleave it with other work.
     void execute_micro_program(uint32_t start_address);
+    void start_micro_program(uint32_t start_address);
+    // Runs up to `max_instructions` instruction pairs; returns the count executed
+    uint64_t run(uint64_t max_instructions);
+    bool is_running() const { return running_; }
+    // VU0 macro mode: one COP2 instruction (CO bit set) issued by the EE
     void execute_vector_instruction(uint32_t instruction);
+    // False if the recompiler cannot run on this host (it needs AVX)
+    bool set_execution_mode(VUExecutionMode mode);
+    VUExecutionMode get_execution_mode() const { return execution_mode_; }
+
+    // Drops recompiled code, which is specialized for the mode
+    void set_clamp_mode(VUClampMode mode);
+    VUClampMode get_clamp_mode() const { return clamp_mode_; }
     
-    // Memory
+    // Memory. Micro memory is addressed in 32-bit words.
     uint32_t read_micro_mem(uint32_t address);
     void write_micro_mem(uint32_t address, uint32_t value);
+    // Hash of the whole micro memory, updated on every write; the
+    // recompiler keys its code cache by it
+    uint64_t get_program_hash() const { return program_hash_; }
+    uint8_t* get_data_memory() { return data_memory_.data(); }
+    size_t get_data_memory_size() const { return data_memory_.size(); }
+
+    // XGKICK hands the GIF packet at a data memory byte offset to the GS path
+    void set_xgkick_handler(std::function<void(uint32_t address)> handler) { xgkick_handler_ = std::move(handler); }
+    // VIF TOP/ITOP, read by XTOP/XITOP
+    void set_vif_tops(uint16_t top, uint16_t itop) { vif_top_ = top; vif_itop_ = itop; }
+    // VIF command stream: MPG, UNPACK, MSCAL/MSCNT and the state commands.
+    // Micro programs started by it run to their end before it returns.
+    // DIRECT data is dropped and masked UNPACKs ignore the mask.
+    void write_vif(const uint32_t* data, size_t words);
     
     // Registers
     float get_vf_register(int reg, int component) const;
@@ -215,6 +549,12 @@ public:
     
     uint16_t get_vi_register(int reg) const;
     void set_vi_register(int reg, uint16_t value);
+
+    // Raw transfers for QMFC2/QMTC2 and CFC2/CTC2
+    void read_vf(int reg, uint32_t value[4]) const;
+    void write_vf(int reg, const uint32_t value[4]);
+    uint32_t read_control(int reg) const;
+    void write_control(int reg, uint32_t value);
     
 private:
     int unit_id_;
@@ -223,16 +563,47 @@ private:
     // VU Memory
     std::vector<uint32_t> micro_memory_;
     std::vector<uint8_t> data_memory_;
+    uint64_t program_hash_;
+    uint64_t micro_writes_;         // Bumped by every write, so readers can tell a collision from no change
+    uint32_t micro_mask_;           // Byte address masks (sizes are powers of two)
+    uint32_t data_mask_;
     
     // VU Registers
-    float vf_registers_[32][4];  // Vector float registers
-    uint16_t vi_registers_[16];  // Vector integer registers
+    VURegisters registers_;
+    uint32_t cmsar0_;
+    uint16_t vif_top_;
+    uint16_t vif_itop_;
+    VIFState vif_;
     
     // State
     bool initialized_;
+    bool running_;
+    bool ending_;                   // E bit seen: the next pair is the last
     uint32_t pc_;
+    uint32_t next_pc_;
+    VUClampMode clamp_mode_;
+    VUUpperResult upper_;
+    std::function<void(uint32_t address)> xgkick_handler_;
+
+    VUExecutionMode execution_mode_;
+    std::unique_ptr<VURecompiler> recompiler_;
+
+    friend class VURecompiler;
+
+    // Interpreter loop behind run(); the recompiler falls back to it
+    uint64_t interpret(uint64_t max_instructions);
+    void execute_upper(uint32_t instruction);
+    void execute_lower(uint32_t instruction, uint32_t pc);
+    void commit_upper();
+    void set_vi(int reg, uint32_t value) { if (reg != 0) registers_.vi[reg] = static_cast<uint16_t>(value); }
+    void set_status_id(uint32_t flags);
+    void vif_command(uint32_t word);
+    void vif_data(uint32_t word);
+    void vif_unpack_element();
+    void vif_start_program(uint32_t address);
     
     void log_info(const std::string& message);
+    void log_warn(const std::string& message);
 };
 
 // I/O Processor Class (simplified)
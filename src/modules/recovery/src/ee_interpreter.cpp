@@ -0,0 +1,1301 @@
+#include "ee_engine.h"
+#include "ee_recompiler.h"
+#include "vu1_thread.h"
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+namespace gscx {
+namespace recovery {
+
+// R5900 interpreter. Instructions are decoded once per 4KB page into an
+// EEDecodedPage; execution dispatches on the predecoded type and op.
+
+namespace {
+
+// COP0 Status bits
+constexpr uint32_t STATUS_CU1 = 1u << 29;
+constexpr uint32_t STATUS_CU2 = 1u << 30;
+constexpr uint32_t STATUS_EIE = 1u << 16;
+constexpr uint32_t STATUS_ERL = 1u << 2;
+constexpr uint32_t STATUS_EXL = 1u << 1;
+
+// FCR31 flags: cause bits and their sticky copies
+constexpr uint32_t FCR31_C = 1u << 23;
+constexpr uint32_t FCR31_I = 1u << 17;
+constexpr uint32_t FCR31_D = 1u << 16;
+constexpr uint32_t FCR31_O = 1u << 15;
+constexpr uint32_t FCR31_U = 1u << 14;
+constexpr uint32_t FCR31_SI = 1u << 6;
+constexpr uint32_t FCR31_SD = 1u << 5;
+constexpr uint32_t FCR31_SO = 1u << 4;
+constexpr uint32_t FCR31_SU = 1u << 3;
+constexpr uint32_t FCR31_WRITABLE = 0x0083C078;
+
+inline uint64_t sext32(uint64_t value) {
+    return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(value)));
+}
+
+inline uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// The EE FPU has no infinities, NaNs or denormals: exponent 255 is an
+// ordinary (huge) exponent and denormals read as zero. Operands are
+// clamped to the largest finite float, which is what the hardware
+// produces on overflow.
+inline float fpu_operand(float value) {
+    uint32_t bits = float_bits(value);
+    uint32_t exponent = bits & 0x7F800000;
+    if (exponent == 0x7F800000) {
+        return bits_float((bits & 0x80000000) | 0x7F7FFFFF);
+    }
+    if (exponent == 0) {
+        return bits_float(bits & 0x80000000);
+    }
+    return value;
+}
+
+} // namespace
+
+// Decoding
+EEInstruction EmotionEngine::decode_instruction(uint32_t raw) {
+    EEInstruction instr;
+    instr.raw = raw;
+
+    // Extract fields
+    instr.opcode = (raw >> 26) & 0x3F;
+    instr.rs = (raw >> 21) & 0x1F;
+    instr.rt = (raw >> 16) & 0x1F;
+    instr.rd = (raw >> 11) & 0x1F;
+    instr.shamt = (raw >> 6) & 0x1F;
+    instr.function = raw & 0x3F;
+    instr.immediate = raw & 0xFFFF;
+    instr.target = raw & 0x3FFFFFF;
+
+    EEInstructionType type = EEInstructionType::UNKNOWN;
+    EEOp op = EEOp::INVALID;
+    auto set = [&](EEInstructionType t, EEOp o) { type = t; op = o; };
+
+    using T = EEInstructionType;
+    switch (instr.opcode) {
+        case 0x00:  // SPECIAL
+            switch (instr.function) {
+                case 0x00: set(T::SHIFT, EEOp::SLL); break;
+                case 0x02: set(T::SHIFT, EEOp::SRL); break;
+                case 0x03: set(T::SHIFT, EEOp::SRA); break;
+                case 0x04: set(T::SHIFT, EEOp::SLLV); break;
+                case 0x06: set(T::SHIFT, EEOp::SRLV); break;
+                case 0x07: set(T::SHIFT, EEOp::SRAV); break;
+                case 0x08: set(T::JUMP, EEOp::JR); break;
+                case 0x09: set(T::JUMP, EEOp::JALR); break;
+                case 0x0A: set(T::ARITHMETIC, EEOp::MOVZ); break;
+                case 0x0B: set(T::ARITHMETIC, EEOp::MOVN); break;
+                case 0x0C: set(T::SYSTEM, EEOp::SYSCALL); break;
+                case 0x0D: set(T::SYSTEM, EEOp::BREAK); break;
+                case 0x0F: set(T::SYSTEM, EEOp::SYNC); break;
+                case 0x10: set(T::MULTIPLY_DIVIDE, EEOp::MFHI); break;
+                case 0x11: set(T::MULTIPLY_DIVIDE, EEOp::MTHI); break;
+                case 0x12: set(T::MULTIPLY_DIVIDE, EEOp::MFLO); break;
+                case 0x13: set(T::MULTIPLY_DIVIDE, EEOp::MTLO); break;
+                case 0x14: set(T::SHIFT, EEOp::DSLLV); break;
+                case 0x16: set(T::SHIFT, EEOp::DSRLV); break;
+                case 0x17: set(T::SHIFT, EEOp::DSRAV); break;
+                case 0x18: set(T::MULTIPLY_DIVIDE, EEOp::MULT); break;
+                case 0x19: set(T::MULTIPLY_DIVIDE, EEOp::MULTU); break;
+                case 0x1A: set(T::MULTIPLY_DIVIDE, EEOp::DIV); break;
+                case 0x1B: set(T::MULTIPLY_DIVIDE, EEOp::DIVU); break;
+                case 0x20: set(T::ARITHMETIC, EEOp::ADD); break;
+                case 0x21: set(T::ARITHMETIC, EEOp::ADDU); break;
+                case 0x22: set(T::ARITHMETIC, EEOp::SUB); break;
+                case 0x23: set(T::ARITHMETIC, EEOp::SUBU); break;
+                case 0x24: set(T::LOGICAL, EEOp::AND); break;
+                case 0x25: set(T::LOGICAL, EEOp::OR); break;
+                case 0x26: set(T::LOGICAL, EEOp::XOR); break;
+                case 0x27: set(T::LOGICAL, EEOp::NOR); break;
+                case 0x28: set(T::SHIFT, EEOp::MFSA); break;
+                case 0x29: set(T::SHIFT, EEOp::MTSA); break;
+                case 0x2A: set(T::ARITHMETIC, EEOp::SLT); break;
+                case 0x2B: set(T::ARITHMETIC, EEOp::SLTU); break;
+                case 0x2C: set(T::ARITHMETIC, EEOp::DADD); break;
+                case 0x2D: set(T::ARITHMETIC, EEOp::DADDU); break;
+                case 0x2E: set(T::ARITHMETIC, EEOp::DSUB); break;
+                case 0x2F: set(T::ARITHMETIC, EEOp::DSUBU); break;
+                case 0x30: set(T::SYSTEM, EEOp::TGE); break;
+                case 0x31: set(T::SYSTEM, EEOp::TGEU); break;
+                case 0x32: set(T::SYSTEM, EEOp::TLT); break;
+                case 0x33: set(T::SYSTEM, EEOp::TLTU); break;
+                case 0x34: set(T::SYSTEM, EEOp::TEQ); break;
+                case 0x36: set(T::SYSTEM, EEOp::TNE); break;
+                case 0x38: set(T::SHIFT, EEOp::DSLL); break;
+                case 0x3A: set(T::SHIFT, EEOp::DSRL); break;
+                case 0x3B: set(T::SHIFT, EEOp::DSRA); break;
+                case 0x3C: set(T::SHIFT, EEOp::DSLL32); break;
+                case 0x3E: set(T::SHIFT, EEOp::DSRL32); break;
+                case 0x3F: set(T::SHIFT, EEOp::DSRA32); break;
+            }
+            break;
+        case 0x01:  // REGIMM
+            switch (instr.rt) {
+                case 0x00: set(T::BRANCH, EEOp::BLTZ); break;
+                case 0x01: set(T::BRANCH, EEOp::BGEZ); break;
+                case 0x02: set(T::BRANCH, EEOp::BLTZL); break;
+                case 0x03: set(T::BRANCH, EEOp::BGEZL); break;
+                case 0x08: set(T::SYSTEM, EEOp::TGEI); break;
+                case 0x09: set(T::SYSTEM, EEOp::TGEIU); break;
+                case 0x0A: set(T::SYSTEM, EEOp::TLTI); break;
+                case 0x0B: set(T::SYSTEM, EEOp::TLTIU); break;
+                case 0x0C: set(T::SYSTEM, EEOp::TEQI); break;
+                case 0x0E: set(T::SYSTEM, EEOp::TNEI); break;
+                case 0x10: set(T::BRANCH, EEOp::BLTZAL); break;
+                case 0x11: set(T::BRANCH, EEOp::BGEZAL); break;
+                case 0x12: set(T::BRANCH, EEOp::BLTZALL); break;
+                case 0x13: set(T::BRANCH, EEOp::BGEZALL); break;
+                case 0x18: set(T::SHIFT, EEOp::MTSAB); break;
+                case 0x19: set(T::SHIFT, EEOp::MTSAH); break;
+            }
+            break;
+        case 0x02: set(T::JUMP, EEOp::J); break;
+        case 0x03: set(T::JUMP, EEOp::JAL); break;
+        case 0x04: set(T::BRANCH, EEOp::BEQ); break;
+        case 0x05: set(T::BRANCH, EEOp::BNE); break;
+        case 0x06: set(T::BRANCH, EEOp::BLEZ); break;
+        case 0x07: set(T::BRANCH, EEOp::BGTZ); break;
+        case 0x08: set(T::ARITHMETIC, EEOp::ADDI); break;
+        case 0x09: set(T::ARITHMETIC, EEOp::ADDIU); break;
+        case 0x0A: set(T::ARITHMETIC, EEOp::SLTI); break;
+        case 0x0B: set(T::ARITHMETIC, EEOp::SLTIU); break;
+        case 0x0C: set(T::LOGICAL, EEOp::ANDI); break;
+        case 0x0D: set(T::LOGICAL, EEOp::ORI); break;
+        case 0x0E: set(T::LOGICAL, EEOp::XORI); break;
+        case 0x0F: set(T::ARITHMETIC, EEOp::LUI); break;
+        case 0x10:  // COP0
+            switch (instr.rs) {
+                case 0x00: set(T::SYSTEM, EEOp::MFC0); break;
+                case 0x04: set(T::SYSTEM, EEOp::MTC0); break;
+                case 0x08:
+                    switch (instr.rt) {
+                        case 0x00: set(T::BRANCH, EEOp::BC0F); break;
+                        case 0x01: set(T::BRANCH, EEOp::BC0T); break;
+                        case 0x02: set(T::BRANCH, EEOp::BC0FL); break;
+                        case 0x03: set(T::BRANCH, EEOp::BC0TL); break;
+                    }
+                    break;
+                case 0x10:
+                    switch (instr.function) {
+                        case 0x01: set(T::SYSTEM, EEOp::TLBR); break;
+                        case 0x02: set(T::SYSTEM, EEOp::TLBWI); break;
+                        case 0x06: set(T::SYSTEM, EEOp::TLBWR); break;
+                        case 0x08: set(T::SYSTEM, EEOp::TLBP); break;
+                        case 0x18: set(T::SYSTEM, EEOp::ERET); break;
+                        case 0x38: set(T::SYSTEM, EEOp::EI); break;
+                        case 0x39: set(T::SYSTEM, EEOp::DI); break;
+                    }
+                    break;
+            }
+            break;
+        case 0x11:  // COP1
+            switch (instr.rs) {
+                case 0x00: set(T::FLOATING_POINT, EEOp::MFC1); break;
+                case 0x02: set(T::FLOATING_POINT, EEOp::CFC1); break;
+                case 0x04: set(T::FLOATING_POINT, EEOp::MTC1); break;
+                case 0x06: set(T::FLOATING_POINT, EEOp::CTC1); break;
+                case 0x08:
+                    switch (instr.rt) {
+                        case 0x00: set(T::BRANCH, EEOp::BC1F); break;
+                        case 0x01: set(T::BRANCH, EEOp::BC1T); break;
+                        case 0x02: set(T::BRANCH, EEOp::BC1FL); break;
+                        case 0x03: set(T::BRANCH, EEOp::BC1TL); break;
+                    }
+                    break;
+                case 0x10:  // S format
+                    switch (instr.function) {
+                        case 0x00: set(T::FLOATING_POINT, EEOp::ADD_S); break;
+                        case 0x01: set(T::FLOATING_POINT, EEOp::SUB_S); break;
+                        case 0x02: set(T::FLOATING_POINT, EEOp::MUL_S); break;
+                        case 0x03: set(T::FLOATING_POINT, EEOp::DIV_S); break;
+                        case 0x04: set(T::FLOATING_POINT, EEOp::SQRT_S); break;
+                        case 0x05: set(T::FLOATING_POINT, EEOp::ABS_S); break;
+                        case 0x06: set(T::FLOATING_POINT, EEOp::MOV_S); break;
+                        case 0x07: set(T::FLOATING_POINT, EEOp::NEG_S); break;
+                        case 0x16: set(T::FLOATING_POINT, EEOp::RSQRT_S); break;
+                        case 0x18: set(T::FLOATING_POINT, EEOp::ADDA_S); break;
+                        case 0x19: set(T::FLOATING_POINT, EEOp::SUBA_S); break;
+                        case 0x1A: set(T::FLOATING_POINT, EEOp::MULA_S); break;
+                        case 0x1C: set(T::FLOATING_POINT, EEOp::MADD_S); break;
+                        case 0x1D: set(T::FLOATING_POINT, EEOp::MSUB_S); break;
+                        case 0x1E: set(T::FLOATING_POINT, EEOp::MADDA_S); break;
+                        case 0x1F: set(T::FLOATING_POINT, EEOp::MSUBA_S); break;
+                        case 0x24: set(T::FLOATING_POINT, EEOp::CVT_W_S); break;
+                        case 0x28: set(T::FLOATING_POINT, EEOp::MAX_S); break;
+                        case 0x29: set(T::FLOATING_POINT, EEOp::MIN_S); break;
+                        case 0x30: set(T::FLOATING_POINT, EEOp::C_F_S); break;
+                        case 0x32: set(T::FLOATING_POINT, EEOp::C_EQ_S); break;
+                        case 0x34: set(T::FLOATING_POINT, EEOp::C_LT_S); break;
+                        case 0x36: set(T::FLOATING_POINT, EEOp::C_LE_S); break;
+                    }
+                    break;
+                case 0x14:  // W format
+                    if (instr.function == 0x20) {
+                        set(T::FLOATING_POINT, EEOp::CVT_S_W);
+                    }
+                    break;
+            }
+            break;
+        case 0x12: set(T::VECTOR, EEOp::COP2); break;
+        case 0x14: set(T::BRANCH, EEOp::BEQL); break;
+        case 0x15: set(T::BRANCH, EEOp::BNEL); break;
+        case 0x16: set(T::BRANCH, EEOp::BLEZL); break;
+        case 0x17: set(T::BRANCH, EEOp::BGTZL); break;
+        case 0x18: set(T::ARITHMETIC, EEOp::DADDI); break;
+        case 0x19: set(T::ARITHMETIC, EEOp::DADDIU); break;
+        case 0x1A: set(T::LOAD_STORE, EEOp::LDL); break;
+        case 0x1B: set(T::LOAD_STORE, EEOp::LDR); break;
+        case 0x1C:  // MMI
+            switch (instr.function) {
+                case 0x00: set(T::MULTIPLY_DIVIDE, EEOp::MADD); break;
+                case 0x01: set(T::MULTIPLY_DIVIDE, EEOp::MADDU); break;
+                case 0x04: set(T::PARALLEL, EEOp::PLZCW); break;
+                case 0x08:  // MMI0, selected by the sa field
+                    switch (instr.shamt) {
+                        case 0x00: set(T::PARALLEL, EEOp::PADDW); break;
+                        case 0x01: set(T::PARALLEL, EEOp::PSUBW); break;
+                        case 0x02: set(T::PARALLEL, EEOp::PCGTW); break;
+                        case 0x03: set(T::PARALLEL, EEOp::PMAXW); break;
+                        case 0x04: set(T::PARALLEL, EEOp::PADDH); break;
+                        case 0x05: set(T::PARALLEL, EEOp::PSUBH); break;
+                        case 0x06: set(T::PARALLEL, EEOp::PCGTH); break;
+                        case 0x07: set(T::PARALLEL, EEOp::PMAXH); break;
+                        case 0x08: set(T::PARALLEL, EEOp::PADDB); break;
+                        case 0x09: set(T::PARALLEL, EEOp::PSUBB); break;
+                        case 0x0A: set(T::PARALLEL, EEOp::PCGTB); break;
+                        case 0x10: set(T::PARALLEL, EEOp::PADDSW); break;
+                        case 0x11: set(T::PARALLEL, EEOp::PSUBSW); break;
+                        case 0x12: set(T::PARALLEL, EEOp::PEXTLW); break;
+                        case 0x13: set(T::PARALLEL, EEOp::PPACW); break;
+                        case 0x14: set(T::PARALLEL, EEOp::PADDSH); break;
+                        case 0x15: set(T::PARALLEL, EEOp::PSUBSH); break;
+                        case 0x16: set(T::PARALLEL, EEOp::PEXTLH); break;
+                        case 0x17: set(T::PARALLEL, EEOp::PPACH); break;
+                        case 0x18: set(T::PARALLEL, EEOp::PADDSB); break;
+                        case 0x19: set(T::PARALLEL, EEOp::PSUBSB); break;
+                        case 0x1A: set(T::PARALLEL, EEOp::PEXTLB); break;
+                        case 0x1B: set(T::PARALLEL, EEOp::PPACB); break;
+                        case 0x1E: set(T::PARALLEL, EEOp::PEXT5); break;
+                        case 0x1F: set(T::PARALLEL, EEOp::PPAC5); break;
+                    }
+                    break;
+                case 0x09:  // MMI2
+                    switch (instr.shamt) {
+                        case 0x00: set(T::PARALLEL, EEOp::PMADDW); break;
+                        case 0x02: set(T::PARALLEL, EEOp::PSLLVW); break;
+                        case 0x03: set(T::PARALLEL, EEOp::PSRLVW); break;
+                        case 0x04: set(T::PARALLEL, EEOp::PMSUBW); break;
+                        case 0x08: set(T::PARALLEL, EEOp::PMFHI); break;
+                        case 0x09: set(T::PARALLEL, EEOp::PMFLO); break;
+                        case 0x0A: set(T::PARALLEL, EEOp::PINTH); break;
+                        case 0x0C: set(T::PARALLEL, EEOp::PMULTW); break;
+                        case 0x0D: set(T::PARALLEL, EEOp::PDIVW); break;
+                        case 0x0E: set(T::PARALLEL, EEOp::PCPYLD); break;
+                        case 0x10: set(T::PARALLEL, EEOp::PMADDH); break;
+                        case 0x11: set(T::PARALLEL, EEOp::PHMADH); break;
+                        case 0x12: set(T::PARALLEL, EEOp::PAND); break;
+                        case 0x13: set(T::PARALLEL, EEOp::PXOR); break;
+                        case 0x14: set(T::PARALLEL, EEOp::PMSUBH); break;
+                        case 0x15: set(T::PARALLEL, EEOp::PHMSBH); break;
+                        case 0x1A: set(T::PARALLEL, EEOp::PEXEH); break;
+                        case 0x1B: set(T::PARALLEL, EEOp::PREVH); break;
+                        case 0x1C: set(T::PARALLEL, EEOp::PMULTH); break;
+                        case 0x1D: set(T::PARALLEL, EEOp::PDIVBW); break;
+                        case 0x1E: set(T::PARALLEL, EEOp::PEXEW); break;
+                        case 0x1F: set(T::PARALLEL, EEOp::PROT3W); break;
+                    }
+                    break;
+                case 0x10: set(T::MULTIPLY_DIVIDE, EEOp::MFHI1); break;
+                case 0x11: set(T::MULTIPLY_DIVIDE, EEOp::MTHI1); break;
+                case 0x12: set(T::MULTIPLY_DIVIDE, EEOp::MFLO1); break;
+                case 0x13: set(T::MULTIPLY_DIVIDE, EEOp::MTLO1); break;
+                case 0x18: set(T::MULTIPLY_DIVIDE, EEOp::MULT1); break;
+                case 0x19: set(T::MULTIPLY_DIVIDE, EEOp::MULTU1); break;
+                case 0x1A: set(T::MULTIPLY_DIVIDE, EEOp::DIV1); break;
+                case 0x1B: set(T::MULTIPLY_DIVIDE, EEOp::DIVU1); break;
+                case 0x20: set(T::MULTIPLY_DIVIDE, EEOp::MADD1); break;
+                case 0x21: set(T::MULTIPLY_DIVIDE, EEOp::MADDU1); break;
+                case 0x28:  // MMI1
+                    switch (instr.shamt) {
+                        case 0x01: set(T::PARALLEL, EEOp::PABSW); break;
+                        case 0x02: set(T::PARALLEL, EEOp::PCEQW); break;
+                        case 0x03: set(T::PARALLEL, EEOp::PMINW); break;
+                        case 0x04: set(T::PARALLEL, EEOp::PADSBH); break;
+                        case 0x05: set(T::PARALLEL, EEOp::PABSH); break;
+                        case 0x06: set(T::PARALLEL, EEOp::PCEQH); break;
+                        case 0x07: set(T::PARALLEL, EEOp::PMINH); break;
+                        case 0x0A: set(T::PARALLEL, EEOp::PCEQB); break;
+                        case 0x10: set(T::PARALLEL, EEOp::PADDUW); break;
+                        case 0x11: set(T::PARALLEL, EEOp::PSUBUW); break;
+                        case 0x12: set(T::PARALLEL, EEOp::PEXTUW); break;
+                        case 0x14: set(T::PARALLEL, EEOp::PADDUH); break;
+                        case 0x15: set(T::PARALLEL, EEOp::PSUBUH); break;
+                        case 0x16: set(T::PARALLEL, EEOp::PEXTUH); break;
+                        case 0x18: set(T::PARALLEL, EEOp::PADDUB); break;
+                        case 0x19: set(T::PARALLEL, EEOp::PSUBUB); break;
+                        case 0x1A: set(T::PARALLEL, EEOp::PEXTUB); break;
+                        case 0x1B: set(T::PARALLEL, EEOp::QFSRV); break;
+                    }
+                    break;
+                case 0x29:  // MMI3
+                    switch (instr.shamt) {
+                        case 0x00: set(T::PARALLEL, EEOp::PMADDUW); break;
+                        case 0x03: set(T::PARALLEL, EEOp::PSRAVW); break;
+                        case 0x08: set(T::PARALLEL, EEOp::PMTHI); break;
+                        case 0x09: set(T::PARALLEL, EEOp::PMTLO); break;
+                        case 0x0A: set(T::PARALLEL, EEOp::PINTEH); break;
+                        case 0x0C: set(T::PARALLEL, EEOp::PMULTUW); break;
+                        case 0x0D: set(T::PARALLEL, EEOp::PDIVUW); break;
+                        case 0x0E: set(T::PARALLEL, EEOp::PCPYUD); break;
+                        case 0x12: set(T::PARALLEL, EEOp::POR); break;
+                        case 0x13: set(T::PARALLEL, EEOp::PNOR); break;
+                        case 0x1A: set(T::PARALLEL, EEOp::PEXCH); break;
+                        case 0x1B: set(T::PARALLEL, EEOp::PCPYH); break;
+                        case 0x1E: set(T::PARALLEL, EEOp::PEXCW); break;
+                    }
+                    break;
+                case 0x30: set(T::PARALLEL, EEOp::PMFHL); break;
+                case 0x31: set(T::PARALLEL, EEOp::PMTHL); break;
+                case 0x34: set(T::PARALLEL, EEOp::PSLLH); break;
+                case 0x36: set(T::PARALLEL, EEOp::PSRLH); break;
+                case 0x37: set(T::PARALLEL, EEOp::PSRAH); break;
+                case 0x3C: set(T::PARALLEL, EEOp::PSLLW); break;
+                case 0x3E: set(T::PARALLEL, EEOp::PSRLW); break;
+                case 0x3F: set(T::PARALLEL, EEOp::PSRAW); break;
+            }
+            break;
+        case 0x1E: set(T::LOAD_STORE, EEOp::LQ); break;
+        case 0x1F: set(T::LOAD_STORE, EEOp::SQ); break;
+        case 0x20: set(T::LOAD_STORE, EEOp::LB); break;
+        case 0x21: set(T::LOAD_STORE, EEOp::LH); break;
+        case 0x22: set(T::LOAD_STORE, EEOp::LWL); break;
+        case 0x23: set(T::LOAD_STORE, EEOp::LW); break;
+        case 0x24: set(T::LOAD_STORE, EEOp::LBU); break;
+        case 0x25: set(T::LOAD_STORE, EEOp::LHU); break;
+        case 0x26: set(T::LOAD_STORE, EEOp::LWR); break;
+        case 0x27: set(T::LOAD_STORE, EEOp::LWU); break;
+        case 0x28: set(T::LOAD_STORE, EEOp::SB); break;
+        case 0x29: set(T::LOAD_STORE, EEOp::SH); break;
+        case 0x2A: set(T::LOAD_STORE, EEOp::SWL); break;
+        case 0x2B: set(T::LOAD_STORE, EEOp::SW); break;
+        case 0x2C: set(T::LOAD_STORE, EEOp::SDL); break;
+        case 0x2D: set(T::LOAD_STORE, EEOp::SDR); break;
+        case 0x2E: set(T::LOAD_STORE, EEOp::SWR); break;
+        case 0x2F: set(T::SYSTEM, EEOp::CACHE); break;
+        case 0x31: set(T::LOAD_STORE, EEOp::LWC1); break;
+        case 0x33: set(T::SYSTEM, EEOp::PREF); break;
+        case 0x36: set(T::VECTOR, EEOp::LQC2); break;
+        case 0x37: set(T::LOAD_STORE, EEOp::LD); break;
+        case 0x39: set(T::LOAD_STORE, EEOp::SWC1); break;
+        case 0x3E: set(T::VECTOR, EEOp::SQC2); break;
+        case 0x3F: set(T::LOAD_STORE, EEOp::SD); break;
+    }
+
+    instr.type = type;
+    instr.op = op;
+    return instr;
+}
+
+// Predecoded page cache
+EEDecodedPage* EmotionEngine::get_decoded_page(uint32_t address) {
+    uint32_t base = address & ~(EEDecodedPage::PAGE_SIZE - 1);
+    const uint8_t* ptr = get_memory_pointer(base);
+    if (!ptr) {
+        return nullptr;
+    }
+
+    std::unique_ptr<EEDecodedPage>& page = code_pages_[get_code_page_index(ptr)];
+    if (!page) {
+        page = std::make_unique<EEDecodedPage>();
+        page->valid = false;
+    }
+    if (!page->valid) {
+        for (uint32_t i = 0; i < EEDecodedPage::INSTRUCTIONS; i++) {
+            uint32_t raw;
+            std::memcpy(&raw, ptr + i * 4, sizeof(raw));
+            page->instructions[i] = decode_instruction(raw);
+        }
+        page->valid = true;
+        code_page_flags_[get_code_page_index(ptr)] = 1;
+    }
+    return page.get();
+}
+
+const EEInstruction* EmotionEngine::fetch_instruction(uint32_t pc) {
+    uint32_t base = pc & ~(EEDecodedPage::PAGE_SIZE - 1);
+    if (!fetch_page_ || base != fetch_page_base_ || !fetch_page_->valid) {
+        fetch_page_ = get_decoded_page(pc);
+        fetch_page_base_ = base;
+        if (!fetch_page_) {
+            return nullptr;
+        }
+    }
+    return &fetch_page_->instructions[(pc & (EEDecodedPage::PAGE_SIZE - 1)) >> 2];
+}
+
+void EmotionEngine::step() {
+    uint32_t pc = static_cast<uint32_t>(registers_.pc);
+    if (pc & 3) {
+        current_pc_ = pc;
+        in_delay_slot_ = branch_pending_;
+        raise_address_error(pc, false);
+        return;
+    }
+
+    const EEInstruction* instr = fetch_instruction(pc);
+    if (!instr) {
+        std::stringstream ss;
+        ss << "Instruction fetch from unmapped address 0x" << std::hex << pc << ", stopping";
+        log_error(ss.str());
+        running_ = false;
+        return;
+    }
+
+    current_pc_ = pc;
+    in_delay_slot_ = branch_pending_;
+    branch_pending_ = false;
+    registers_.pc = registers_.npc;
+    registers_.npc = registers_.pc + 4;
+
+    executing_ = true;
+    execute_instruction(*instr);
+    executing_ = false;
+
+    // r0 is hardwired to zero; cheaper to restore than to test every write
+    registers_.gpr[0][0] = 0;
+    registers_.gpr[0][1] = 0;
+
+    cycle_count_++;
+    instruction_count_++;
+}
+
+uint64_t EmotionEngine::execute(uint64_t max_instructions) {
+    if (execution_mode_ == EEExecutionMode::RECOMPILER && recompiler_) {
+        return recompiler_->execute(max_instructions);
+    }
+    uint64_t executed = 0;
+    while (running_ && executed < max_instructions) {
+        step();
+        executed++;
+    }
+    return executed;
+}
+
+void EmotionEngine::branch(bool taken, uint32_t target, bool likely) {
+    if (taken) {
+        registers_.npc = target;
+        branch_pending_ = true;
+    } else if (likely) {
+        // Nullify the delay slot
+        registers_.pc = registers_.npc;
+        registers_.npc = registers_.pc + 4;
+    } else {
+        branch_pending_ = true;
+    }
+}
+
+void EmotionEngine::raise_address_error(uint32_t address, bool store) {
+    registers_.badvaddr = address;
+    exception_data_ = store ? 1 : 0;
+    trigger_exception(EEException::ADDRESS_ERROR);
+}
+
+bool EmotionEngine::check_cop1_usable() {
+    if (registers_.status & STATUS_CU1) {
+        return true;
+    }
+    exception_data_ = 1;
+    trigger_exception(EEException::COPROCESSOR_UNUSABLE);
+    return false;
+}
+
+bool EmotionEngine::check_cop2_usable() {
+    if (registers_.status & STATUS_CU2) {
+        return true;
+    }
+    exception_data_ = 2;
+    trigger_exception(EEException::COPROCESSOR_UNUSABLE);
+    return false;
+}
+
+void EmotionEngine::set_fpu_flags(uint32_t flags) {
+    uint32_t& fcr31 = registers_.fcr[31];
+    fcr31 |= flags;
+    if (flags & FCR31_I) fcr31 |= FCR31_SI;
+    if (flags & FCR31_D) fcr31 |= FCR31_SD;
+    if (flags & FCR31_O) fcr31 |= FCR31_SO;
+    if (flags & FCR31_U) fcr31 |= FCR31_SU;
+}
+
+// Instruction execution. 32-bit results are sign-extended to 64 bits;
+// only the lower 64 bits of a GPR are written outside MMI.
+void EmotionEngine::execute_arithmetic(const EEInstruction& instr) {
+    uint64_t* gpr = &registers_.gpr[0][0];
+    auto reg = [gpr](uint8_t index) -> uint64_t& { return gpr[index * 2]; };
+    uint64_t rs = reg(instr.rs);
+    uint64_t rt = reg(instr.rt);
+    uint64_t imm = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(instr.immediate)));
+
+    switch (instr.op) {
+        case EEOp::ADD:
+        case EEOp::ADDI: {
+            uint64_t operand = instr.op == EEOp::ADD ? rt : imm;
+            int64_t sum = static_cast<int64_t>(static_cast<int32_t>(rs)) + static_cast<int32_t>(operand);
+            if (sum != static_cast<int32_t>(sum)) {
+                trigger_exception(EEException::OVERFLOW);
+                return;
+            }
+            reg(instr.op == EEOp::ADD ? instr.rd : instr.rt) = static_cast<uint64_t>(sum);
+            break;
+        }
+        case EEOp::ADDU:
+            reg(instr.rd) = sext32(rs + rt);
+            break;
+        case EEOp::ADDIU:
+            reg(instr.rt) = sext32(rs + imm);
+            break;
+        case EEOp::SUB: {
+            int64_t difference = static_cast<int64_t>(static_cast<int32_t>(rs)) - static_cast<int32_t>(rt);
+            if (difference != static_cast<int32_t>(difference)) {
+                trigger_exception(EEException::OVERFLOW);
+                return;
+            }
+            reg(instr.rd) = static_cast<uint64_t>(difference);
+            break;
+        }
+        case EEOp::SUBU:
+            reg(instr.rd) = sext32(rs - rt);
+            break;
+        case EEOp::DADD:
+        case EEOp::DADDI: {
+            uint64_t operand = instr.op == EEOp::DADD ? rt : imm;
+            uint64_t sum = rs + operand;
+            if (((rs ^ sum) & (operand ^ sum)) >> 63) {
+                trigger_exception(EEException::OVERFLOW);
+                return;
+            }
+            reg(instr.op == EEOp::DADD ? instr.rd : instr.rt) = sum;
+            break;
+        }
+        case EEOp::DADDU:
+            reg(instr.rd) = rs + rt;
+            break;
+        case EEOp::DADDIU:
+            reg(instr.rt) = rs + imm;
+            break;
+        case EEOp::DSUB: {
+            uint64_t difference = rs - rt;
+            if (((rs ^ rt) & (rs ^ difference)) >> 63) {
+                trigger_exception(EEException::OVERFLOW);
+                return;
+            }
+            reg(instr.rd) = difference;
+            break;
+        }
+        case EEOp::DSUBU:
+            reg(instr.rd) = rs - rt;
+            break;
+        case EEOp::SLT:
+            reg(instr.rd) = static_cast<int64_t>(rs) < static_cast<int64_t>(rt) ? 1 : 0;
+            break;
+        case EEOp::SLTU:
+            reg(instr.rd) = rs < rt ? 1 : 0;
+            break;
+        case EEOp::SLTI:
+            reg(instr.rt) = static_cast<int64_t>(rs) < static_cast<int64_t>(imm) ? 1 : 0;
+            break;
+        case EEOp::SLTIU:
+            reg(instr.rt) = rs < imm ? 1 : 0;
+            break;
+        case EEOp::LUI:
+            reg(instr.rt) = sext32(static_cast<uint64_t>(instr.immediate) << 16);
+            break;
+        case EEOp::MOVZ:
+            if (rt == 0) {
+                reg(instr.rd) = rs;
+            }
+            break;
+        case EEOp::MOVN:
+            if (rt != 0) {
+                reg(instr.rd) = rs;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void EmotionEngine::execute_logical(const EEInstruction& instr) {
+    uint64_t rs = registers_.gpr[instr.rs][0];
+    uint64_t rt = registers_.gpr[instr.rt][0];
+
+    switch (instr.op) {
+        case EEOp::AND:  registers_.gpr[instr.rd][0] = rs & rt; break;
+        case EEOp::OR:   registers_.gpr[instr.rd][0] = rs | rt; break;
+        case EEOp::XOR:  registers_.gpr[instr.rd][0] = rs ^ rt; break;
+        case EEOp::NOR:  registers_.gpr[instr.rd][0] = ~(rs | rt); break;
+        case EEOp::ANDI: registers_.gpr[instr.rt][0] = rs & instr.immediate; break;
+        case EEOp::ORI:  registers_.gpr[instr.rt][0] = rs | instr.immediate; break;
+        case EEOp::XORI: registers_.gpr[instr.rt][0] = rs ^ instr.immediate; break;
+        default: break;
+    }
+}
+
+void EmotionEngine::execute_shift(const EEInstruction& instr) {
+    uint64_t rs = registers_.gpr[instr.rs][0];
+    uint64_t rt = registers_.gpr[instr.rt][0];
+    uint64_t& rd = registers_.gpr[instr.rd][0];
+    uint32_t sa = instr.shamt;
+
+    switch (instr.op) {
+        case EEOp::SLL:    rd = sext32(static_cast<uint32_t>(rt) << sa); break;
+        case EEOp::SRL:    rd = sext32(static_cast<uint32_t>(rt) >> sa); break;
+        case EEOp::SRA:    rd = sext32(static_cast<uint32_t>(static_cast<int32_t>(rt) >> sa)); break;
+        case EEOp::SLLV:   rd = sext32(static_cast<uint32_t>(rt) << (rs & 31)); break;
+        case EEOp::SRLV:   rd = sext32(static_cast<uint32_t>(rt) >> (rs & 31)); break;
+        case EEOp::SRAV:   rd = sext32(static_cast<uint32_t>(static_cast<int32_t>(rt) >> (rs & 31))); break;
+        case EEOp::DSLL:   rd = rt << sa; break;
+        case EEOp::DSRL:   rd = rt >> sa; break;
+        case EEOp::DSRA:   rd = static_cast<uint64_t>(static_cast<int64_t>(rt) >> sa); break;
+        case EEOp::DSLL32: rd = rt << (sa + 32); break;
+        case EEOp::DSRL32: rd = rt >> (sa + 32); break;
+        case EEOp::DSRA32: rd = static_cast<uint64_t>(static_cast<int64_t>(rt) >> (sa + 32)); break;
+        case EEOp::DSLLV:  rd = rt << (rs & 63); break;
+        case EEOp::DSRLV:  rd = rt >> (rs & 63); break;
+        case EEOp::DSRAV:  rd = static_cast<uint64_t>(static_cast<int64_t>(rt) >> (rs & 63)); break;
+        case EEOp::MFSA:   rd = registers_.sa; break;
+        case EEOp::MTSA:   registers_.sa = rs & 0xF; break;
+        case EEOp::MTSAB:  registers_.sa = (rs & 0xF) ^ (instr.immediate & 0xF); break;
+        case EEOp::MTSAH:  registers_.sa = ((rs & 0x7) ^ (instr.immediate & 0x7)) * 2; break;
+        default: break;
+    }
+}
+
+void EmotionEngine::execute_branch(const EEInstruction& instr) {
+    int64_t rs = static_cast<int64_t>(registers_.gpr[instr.rs][0]);
+    int64_t rt = static_cast<int64_t>(registers_.gpr[instr.rt][0]);
+    // pc already points at the delay slot
+    uint32_t target = static_cast<uint32_t>(registers_.pc) +
+                      (static_cast<uint32_t>(static_cast<int16_t>(instr.immediate)) << 2);
+    bool fpu_condition = (registers_.fcr[31] & FCR31_C) != 0;
+    // CPCOND0 reports DMA completion; no DMAC is modeled, so it always holds
+    bool cop0_condition = true;
+
+    switch (instr.op) {
+        case EEOp::BEQ:   branch(rs == rt, target, false); break;
+        case EEOp::BNE:   branch(rs != rt, target, false); break;
+        case EEOp::BLEZ:  branch(rs <= 0, target, false); break;
+        case EEOp::BGTZ:  branch(rs > 0, target, false); break;
+        case EEOp::BLTZ:  branch(rs < 0, target, false); break;
+        case EEOp::BGEZ:  branch(rs >= 0, target, false); break;
+        case EEOp::BEQL:  branch(rs == rt, target, true); break;
+        case EEOp::BNEL:  branch(rs != rt, target, true); break;
+        case EEOp::BLEZL: branch(rs <= 0, target, true); break;
+        case EEOp::BGTZL: branch(rs > 0, target, true); break;
+        case EEOp::BLTZL: branch(rs < 0, target, true); break;
+        case EEOp::BGEZL: branch(rs >= 0, target, true); break;
+        case EEOp::BLTZAL:
+        case EEOp::BGEZAL:
+        case EEOp::BLTZALL:
+        case EEOp::BGEZALL: {
+            // The link is written whether or not the branch is taken
+            bool taken = (instr.op == EEOp::BLTZAL || instr.op == EEOp::BLTZALL) ? rs < 0 : rs >= 0;
+            registers_.gpr[31][0] = sext32(current_pc_ + 8);
+            branch(taken, target, instr.op == EEOp::BLTZALL || instr.op == EEOp::BGEZALL);
+            break;
+        }
+        case EEOp::BC0F:  branch(!cop0_condition, target, false); break;
+        case EEOp::BC0T:  branch(cop0_condition, target, false); break;
+        case EEOp::BC0FL: branch(!cop0_condition, target, true); break;
+        case EEOp::BC0TL: branch(cop0_condition, target, true); break;
+        case EEOp::BC1F:
+        case EEOp::BC1T:
+        case EEOp::BC1FL:
+        case EEOp::BC1TL:
+            if (!check_cop1_usable()) {
+                return;
+            }
+            branch(instr.op == EEOp::BC1T || instr.op == EEOp::BC1TL ? fpu_condition : !fpu_condition,
+                   target, instr.op == EEOp::BC1FL || instr.op == EEOp::BC1TL);
+            break;
+        default:
+            break;
+    }
+}
+
+void EmotionEngine::execute_jump(const EEInstruction& instr) {
+    switch (instr.op) {
+        case EEOp::J:
+        case EEOp::JAL: {
+            uint32_t target = (static_cast<uint32_t>(registers_.pc) & 0xF0000000) | (instr.target << 2);
+            if (instr.op == EEOp::JAL) {
+                registers_.gpr[31][0] = sext32(current_pc_ + 8);
+            }
+            branch(true, target, false);
+            break;
+        }
+        case EEOp::JR:
+        case EEOp::JALR: {
+            // Read before the link: JALR may name the same register twice
+            uint32_t target = static_cast<uint32_t>(registers_.gpr[instr.rs][0]);
+            if (instr.op == EEOp::JALR) {
+                registers_.gpr[instr.rd][0] = sext32(current_pc_ + 8);
+            }
+            branch(true, target, false);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void EmotionEngine::execute_load_store(const EEInstruction& instr) {
+    uint64_t& rt = registers_.gpr[instr.rt][0];
+    uint32_t address = static_cast<uint32_t>(registers_.gpr[instr.rs][0]) +
+                       static_cast<uint32_t>(static_cast<int16_t>(instr.immediate));
+
+    switch (instr.op) {
+        case EEOp::LB:
+            rt = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(read_memory8(address))));
+            break;
+        case EEOp::LBU:
+            rt = read_memory8(address);
+            break;
+        case EEOp::LH:
+        case EEOp::LHU: {
+            if (address & 1) {
+                raise_address_error(address, false);
+                return;
+            }
+            uint16_t value = read_memory16(address);
+            rt = instr.op == EEOp::LH ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(value)))
+                                      : value;
+            break;
+        }
+        case EEOp::LW:
+        case EEOp::LWU: {
+            if (address & 3) {
+                raise_address_error(address, false);
+                return;
+            }
+            uint32_t value = read_memory32(address);
+            rt = instr.op == EEOp::LW ? sext32(value) : value;
+            break;
+        }
+        case EEOp::LD:
+            if (address & 7) {
+                raise_address_error(address, false);
+                return;
+            }
+            rt = read_memory64(address);
+            break;
+        case EEOp::LQ:
+            // The low four address bits are ignored, not faulted
+            read_memory128(address & ~0xFu, registers_.gpr[instr.rt]);
+            break;
+
+        // Unaligned word/doubleword accesses (little-endian)
+        case EEOp::LWL: {
+            uint32_t shift = (address & 3) * 8;
+            uint32_t memory = read_memory32(address & ~3u);
+            uint32_t mask = 0x00FFFFFFu >> shift;
+            rt = sext32((static_cast<uint32_t>(rt) & mask) | (memory << (24 - shift)));
+            break;
+        }
+        case EEOp::LWR: {
+            uint32_t shift = (address & 3) * 8;
+            uint32_t memory = read_memory32(address & ~3u);
+            if (shift == 0) {
+                rt = sext32(memory);
+            } else {
+                uint32_t value = (static_cast<uint32_t>(rt) & (0xFFFFFFFFu << (32 - shift))) | (memory >> shift);
+                rt = (rt & 0xFFFFFFFF00000000ull) | value;
+            }
+            break;
+        }
+        case EEOp::LDL: {
+            uint32_t shift = (address & 7) * 8;
+            uint64_t memory = read_memory64(address & ~7u);
+            rt = (rt & (0x00FFFFFFFFFFFFFFull >> shift)) | (memory << (56 - shift));
+            break;
+        }
+        case EEOp::LDR: {
+            uint32_t shift = (address & 7) * 8;
+            uint64_t memory = read_memory64(address & ~7u);
+            uint64_t mask = shift ? ~0ull << (64 - shift) : 0;
+            rt = (rt & mask) | (memory >> shift);
+            break;
+        }
+
+        case EEOp::SB:
+            write_memory8(address, static_cast<uint8_t>(rt));
+            break;
+        case EEOp::SH:
+            if (address & 1) {
+                raise_address_error(address, true);
+                return;
+            }
+            write_memory16(address, static_cast<uint16_t>(rt));
+            break;
+        case EEOp::SW:
+            if (address & 3) {
+                raise_address_error(address, true);
+                return;
+            }
+            write_memory32(address, static_cast<uint32_t>(rt));
+            break;
+        case EEOp::SD:
+            if (address & 7) {
+                raise_address_error(address, true);
+                return;
+            }
+            write_memory64(address, rt);
+            break;
+        case EEOp::SQ:
+            write_memory128(address & ~0xFu, registers_.gpr[instr.rt]);
+            break;
+        case EEOp::SWL: {
+            uint32_t shift = (address & 3) * 8;
+            uint32_t memory = read_memory32(address & ~3u);
+            uint32_t mask = static_cast<uint32_t>(0xFFFFFFFFull << (shift + 8));
+            write_memory32(address & ~3u, (static_cast<uint32_t>(rt) >> (24 - shift)) | (memory & mask));
+            break;
+        }
+        case EEOp::SWR: {
+            uint32_t shift = (address & 3) * 8;
+            uint32_t memory = read_memory32(address & ~3u);
+            uint32_t mask = (1u << shift) - 1;
+            write_memory32(address & ~3u, (static_cast<uint32_t>(rt) << shift) | (memory & mask));
+            break;
+        }
+        case EEOp::SDL: {
+            uint32_t shift = (address & 7) * 8;
+            uint64_t memory = read_memory64(address & ~7u);
+            uint64_t mask = shift < 56 ? ~0ull << (shift + 8) : 0;
+            write_memory64(address & ~7u, (rt >> (56 - shift)) | (memory & mask));
+            break;
+        }
+        case EEOp::SDR: {
+            uint32_t shift = (address & 7) * 8;
+            uint64_t memory = read_memory64(address & ~7u);
+            uint64_t mask = (1ull << shift) - 1;
+            write_memory64(address & ~7u, (rt << shift) | (memory & mask));
+            break;
+        }
+
+        case EEOp::LWC1:
+        case EEOp::SWC1:
+            if (!check_cop1_usable()) {
+                return;
+            }
+            if (address & 3) {
+                raise_address_error(address, instr.op == EEOp::SWC1);
+                return;
+            }
+            if (instr.op == EEOp::LWC1) {
+                registers_.fpr[instr.rt] = bits_float(read_memory32(address));
+            } else {
+                write_memory32(address, float_bits(registers_.fpr[instr.rt]));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void EmotionEngine::execute_multiply_divide(const EEInstruction& instr) {
+    uint64_t rs = registers_.gpr[instr.rs][0];
+    uint64_t rt = registers_.gpr[instr.rt][0];
+    bool pipeline1 = false;
+
+    switch (instr.op) {
+        case EEOp::MFHI:  registers_.gpr[instr.rd][0] = registers_.hi; return;
+        case EEOp::MFLO:  registers_.gpr[instr.rd][0] = registers_.lo; return;
+        case EEOp::MTHI:  registers_.hi = rs; return;
+        case EEOp::MTLO:  registers_.lo = rs; return;
+        case EEOp::MFHI1: registers_.gpr[instr.rd][0] = registers_.hi1; return;
+        case EEOp::MFLO1: registers_.gpr[instr.rd][0] = registers_.lo1; return;
+        case EEOp::MTHI1: registers_.hi1 = rs; return;
+        case EEOp::MTLO1: registers_.lo1 = rs; return;
+        case EEOp::MULT1: case EEOp::MULTU1: case EEOp::DIV1: case EEOp::DIVU1:
+        case EEOp::MADD1: case EEOp::MADDU1:
+            pipeline1 = true;
+            break;
+        default:
+            break;
+    }
+
+    // The second pipeline (the ...1 forms) uses HI1/LO1
+    uint64_t& hi = pipeline1 ? registers_.hi1 : registers_.hi;
+    uint64_t& lo = pipeline1 ? registers_.lo1 : registers_.lo;
+    int32_t srs = static_cast<int32_t>(rs);
+    int32_t srt = static_cast<int32_t>(rt);
+    uint64_t product;
+
+    switch (instr.op) {
+        case EEOp::MULT:
+        case EEOp::MULT1:
+            product = static_cast<uint64_t>(static_cast<int64_t>(srs) * srt);
+            break;
+        case EEOp::MULTU:
+        case EEOp::MULTU1:
+            product = static_cast<uint64_t>(static_cast<uint32_t>(rs)) * static_cast<uint32_t>(rt);
+            break;
+        case EEOp::MADD:
+        case EEOp::MADD1:
+            product = ((hi << 32) | (lo & 0xFFFFFFFF)) + static_cast<uint64_t>(static_cast<int64_t>(srs) * srt);
+            break;
+        case EEOp::MADDU:
+        case EEOp::MADDU1:
+            product = ((hi << 32) | (lo & 0xFFFFFFFF)) +
+                      static_cast<uint64_t>(static_cast<uint32_t>(rs)) * static_cast<uint32_t>(rt);
+            break;
+        case EEOp::DIV:
+        case EEOp::DIV1:
+            // Division never traps; these are the hardware's results for
+            // a zero divisor and for INT_MIN / -1
+            if (srt == 0) {
+                lo = srs < 0 ? 1 : sext32(0xFFFFFFFF);
+                hi = sext32(static_cast<uint32_t>(srs));
+            } else if (srs == INT32_MIN && srt == -1) {
+                lo = sext32(0x80000000);
+                hi = 0;
+            } else {
+                lo = sext32(static_cast<uint32_t>(srs / srt));
+                hi = sext32(static_cast<uint32_t>(srs % srt));
+            }
+            return;
+        case EEOp::DIVU:
+        case EEOp::DIVU1: {
+            uint32_t urs = static_cast<uint32_t>(rs);
+            uint32_t urt = static_cast<uint32_t>(rt);
+            if (urt == 0) {
+                lo = sext32(0xFFFFFFFF);
+                hi = sext32(urs);
+            } else {
+                lo = sext32(urs / urt);
+                hi = sext32(urs % urt);
+            }
+            return;
+        }
+        default:
+            return;
+    }
+
+    // The R5900 multiplies also write LO to rd
+    lo = sext32(product);
+    hi = sext32(product >> 32);
+    registers_.gpr[instr.rd][0] = lo;
+}
+
+void EmotionEngine::execute_floating_point(const EEInstruction& instr) {
+    if (!check_cop1_usable()) {
+        return;
+    }
+
+    float* fpr = registers_.fpr;
+    uint32_t& fcr31 = registers_.fcr[31];
+    uint8_t ft = instr.rt;
+    uint8_t fs = instr.rd;
+    uint8_t fd = instr.shamt;
+    float s = fpu_operand(fpr[fs]);
+    float t = fpu_operand(fpr[ft]);
+
+    // Rounds a result to the EE's range, raising O/U like the hardware
+    auto result = [this](float value) {
+        uint32_t bits = float_bits(value);
+        uint32_t exponent = bits & 0x7F800000;
+        if (exponent == 0x7F800000) {
+            set_fpu_flags(FCR31_O);
+            return bits_float((bits & 0x80000000) | 0x7F7FFFFF);
+        }
+        if (exponent == 0 && (bits & 0x007FFFFF)) {
+            set_fpu_flags(FCR31_U);
+            return bits_float(bits & 0x80000000);
+        }
+        return value;
+    };
+
+    switch (instr.op) {
+        case EEOp::MFC1:
+            registers_.gpr[instr.rt][0] = sext32(float_bits(fpr[fs]));
+            return;
+        case EEOp::MTC1:
+            fpr[fs] = bits_float(static_cast<uint32_t>(registers_.gpr[instr.rt][0]));
+            return;
+        case EEOp::CFC1:
+            registers_.gpr[instr.rt][0] = sext32(fs == 0 ? registers_.fcr[0] : fs == 31 ? fcr31 : 0);
+            return;
+        case EEOp::CTC1:
+            if (fs == 31) {
+                fcr31 = (static_cast<uint32_t>(registers_.gpr[instr.rt][0]) & FCR31_WRITABLE) | 0x01000001;
+            }
+            return;
+        default:
+            break;
+    }
+
+    // O/U/I/D describe the last operation only
+    if (instr.op != EEOp::C_F_S && instr.op != EEOp::C_EQ_S && instr.op != EEOp::C_LT_S &&
+        instr.op != EEOp::C_LE_S) {
+        fcr31 &= ~(FCR31_I | FCR31_D | FCR31_O | FCR31_U);
+    }
+    float& acc = registers_.fpu_acc;
+
+    switch (instr.op) {
+        case EEOp::ADD_S:   fpr[fd] = result(s + t); break;
+        case EEOp::SUB_S:   fpr[fd] = result(s - t); break;
+        case EEOp::MUL_S:   fpr[fd] = result(s * t); break;
+        case EEOp::DIV_S:
+            if (t == 0.0f) {
+                // 0/0 is invalid, x/0 a divide by zero; both give signed max
+                set_fpu_flags(s == 0.0f ? FCR31_I : FCR31_D);
+                fpr[fd] = bits_float(((float_bits(s) ^ float_bits(t)) & 0x80000000) | 0x7F7FFFFF);
+            } else {
+                fpr[fd] = result(s / t);
+            }
+            break;
+        case EEOp::SQRT_S:
+            if (t < 0.0f) {
+                set_fpu_flags(FCR31_I);
+            }
+            fpr[fd] = std::sqrt(std::fabs(t));
+            break;
+        case EEOp::RSQRT_S: {
+            float root = std::sqrt(std::fabs(t));
+            if (t < 0.0f) {
+                set_fpu_flags(FCR31_I);
+            }
+            if (root == 0.0f) {
+                set_fpu_flags(FCR31_D);
+                fpr[fd] = bits_float(((float_bits(s) ^ float_bits(t)) & 0x80000000) | 0x7F7FFFFF);
+            } else {
+                fpr[fd] = result(s / root);
+            }
+            break;
+        }
+        case EEOp::ABS_S:   fpr[fd] = std::fabs(fpr[fs]); break;
+        case EEOp::MOV_S:   fpr[fd] = fpr[fs]; break;
+        case EEOp::NEG_S:   fpr[fd] = -fpr[fs]; break;
+        case EEOp::ADDA_S:  acc = result(s + t); break;
+        case EEOp::SUBA_S:  acc = result(s - t); break;
+        case EEOp::MULA_S:  acc = result(s * t); break;
+        case EEOp::MADD_S:  fpr[fd] = result(fpu_operand(acc) + s * t); break;
+        case EEOp::MSUB_S:  fpr[fd] = result(fpu_operand(acc) - s * t); break;
+        case EEOp::MADDA_S: acc = result(fpu_operand(acc) + s * t); break;
+        case EEOp::MSUBA_S: acc = result(fpu_operand(acc) - s * t); break;
+        case EEOp::MAX_S:   fpr[fd] = s > t ? s : t; break;
+        case EEOp::MIN_S:   fpr[fd] = s < t ? s : t; break;
+        case EEOp::CVT_W_S: {
+            // Truncates and saturates; there is no invalid-operation result
+            float value = fpr[fs];
+            int32_t converted;
+            if (value >= 2147483648.0f) {
+                converted = INT32_MAX;
+            } else if (value <= -2147483648.0f) {
+                converted = INT32_MIN;
+            } else {
+                converted = static_cast<int32_t>(fpu_operand(value));
+            }
+            fpr[fd] = bits_float(static_cast<uint32_t>(converted));
+            break;
+        }
+        case EEOp::CVT_S_W:
+            fpr[fd] = static_cast<float>(static_cast<int32_t>(float_bits(fpr[fs])));
+            break;
+        case EEOp::C_F_S:   fcr31 &= ~FCR31_C; break;
+        case EEOp::C_EQ_S:  fcr31 = s == t ? fcr31 | FCR31_C : fcr31 & ~FCR31_C; break;
+        case EEOp::C_LT_S:  fcr31 = s < t ? fcr31 | FCR31_C : fcr31 & ~FCR31_C; break;
+        case EEOp::C_LE_S:  fcr31 = s <= t ? fcr31 | FCR31_C : fcr31 & ~FCR31_C; break;
+        default:
+            break;
+    }
+}
+
+// COP2: VU0 macro mode and register transfers. BC2x is not emulated;
+// micro programs started from the EE run to completion, so VU0 is
+// never busy when the EE looks at it.
+void EmotionEngine::execute_vector(const EEInstruction& instr) {
+    if (!check_cop2_usable()) {
+        return;
+    }
+    uint32_t vf[4];
+    switch (instr.op) {
+        case EEOp::LQC2:
+        case EEOp::SQC2: {
+            uint32_t address = static_cast<uint32_t>(registers_.gpr[instr.rs][0]) +
+                               static_cast<int16_t>(instr.immediate);
+            if (address & 0xF) {
+                raise_address_error(address, instr.op == EEOp::SQC2);
+                return;
+            }
+            uint64_t value[2];
+            if (instr.op == EEOp::LQC2) {
+                read_memory128(address, value);
+                std::memcpy(vf, value, sizeof(vf));
+                vu0_->write_vf(instr.rt, vf);
+            } else {
+                vu0_->read_vf(instr.rt, vf);
+                std::memcpy(value, vf, sizeof(value));
+                write_memory128(address, value);
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    if (instr.raw & (1u << 25)) {
+        vu0_->execute_vector_instruction(instr.raw);
+        return;
+    }
+    switch (instr.rs) {
+        case 0x01:  // QMFC2
+            if (instr.rt != 0) {
+                vu0_->read_vf(instr.rd, vf);
+                std::memcpy(registers_.gpr[instr.rt], vf, sizeof(vf));
+            }
+            break;
+        case 0x02:  // CFC2
+            if (instr.rt != 0) {
+                registers_.gpr[instr.rt][0] = sext32(vu0_->read_control(instr.rd));
+            }
+            break;
+        case 0x05:  // QMTC2
+            std::memcpy(vf, registers_.gpr[instr.rt], sizeof(vf));
+            vu0_->write_vf(instr.rd, vf);
+            break;
+        case 0x06: {    // CTC2
+            uint32_t value = static_cast<uint32_t>(registers_.gpr[instr.rt][0]);
+            if (instr.rd == VectorUnit::CMSAR1) {
+                if (vu1_thread_) {
+                    vu1_thread_->start_micro_program((value & 0xFFFF) * 8);
+                } else {
+                    vu1_->execute_micro_program((value & 0xFFFF) * 8);
+                }
+            } else if (instr.rd == VectorUnit::FBRST) {
+                sync_vu1();
+                vu0_->write_control(VectorUnit::FBRST, value & 0xF);
+                vu1_->write_control(VectorUnit::FBRST, (value >> 8) & 0xF);
+            } else {
+                vu0_->write_control(instr.rd, value);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void EmotionEngine::execute_system(const EEInstruction& instr) {
+    int64_t rs = static_cast<int64_t>(registers_.gpr[instr.rs][0]);
+    int64_t rt = static_cast<int64_t>(registers_.gpr[instr.rt][0]);
+    int64_t imm = static_cast<int16_t>(instr.immediate);
+    bool trap = false;
+
+    switch (instr.op) {
+        case EEOp::SYSCALL:
+            trigger_exception(EEException::SYSCALL);
+            return;
+        case EEOp::BREAK:
+            trigger_exception(EEException::BREAKPOINT);
+            return;
+        case EEOp::SYNC:
+        case EEOp::CACHE:
+        case EEOp::PREF:
+            return;
+
+        case EEOp::TGE:   trap = rs >= rt; break;
+        case EEOp::TGEU:  trap = static_cast<uint64_t>(rs) >= static_cast<uint64_t>(rt); break;
+        case EEOp::TLT:   trap = rs < rt; break;
+        case EEOp::TLTU:  trap = static_cast<uint64_t>(rs) < static_cast<uint64_t>(rt); break;
+        case EEOp::TEQ:   trap = rs == rt; break;
+        case EEOp::TNE:   trap = rs != rt; break;
+        case EEOp::TGEI:  trap = rs >= imm; break;
+        case EEOp::TGEIU: trap = static_cast<uint64_t>(rs) >= static_cast<uint64_t>(imm); break;
+        case EEOp::TLTI:  trap = rs < imm; break;
+        case EEOp::TLTIU: trap = static_cast<uint64_t>(rs) < static_cast<uint64_t>(imm); break;
+        case EEOp::TEQI:  trap = rs == imm; break;
+        case EEOp::TNEI:  trap = rs != imm; break;
+
+        case EEOp::MFC0:
+            registers_.gpr[instr.rt][0] = sext32(read_cop0(instr.rd));
+            return;
+        case EEOp::MTC0:
+            write_cop0(instr.rd, static_cast<uint32_t>(registers_.gpr[instr.rt][0]));
+            return;
+        case EEOp::ERET: {
+            // No delay slot
+            uint32_t target;
+            if (registers_.status & STATUS_ERL) {
+                target = registers_.cop0[30];
+                registers_.status &= ~STATUS_ERL;
+            } else {
+                target = registers_.epc;
+                registers_.status &= ~STATUS_EXL;
+            }
+            registers_.pc = target;
+            registers_.npc = target + 4;
+            return;
+        }
+        case EEOp::EI:
+            registers_.status |= STATUS_EIE;
+            return;
+        case EEOp::DI:
+            registers_.status &= ~STATUS_EIE;
+            return;
+        case EEOp::TLBR:
+        case EEOp::TLBWI:
+        case EEOp::TLBWR:
+        case EEOp::TLBP:
+            // Address translation uses the fixed segment mapping; TLB
+            // contents are not modeled
+            return;
+        default:
+            return;
+    }
+
+    if (trap) {
+        trigger_exception(EEException::TRAP);
+    }
+}
+
+uint32_t EmotionEngine::read_cop0(uint32_t reg) const {
+    switch (reg) {
+        case 8:  return registers_.badvaddr;
+        case 9:  return registers_.cop0[9] + static_cast<uint32_t>(cycle_count_);  // Count
+        case 12: return registers_.status;
+        case 13: return registers_.cause;
+        case 14: return registers_.epc;
+        default: return registers_.cop0[reg & 31];
+    }
+}
+
+void EmotionEngine::write_cop0(uint32_t reg, uint32_t value) {
+    switch (reg) {
+        case 8:  break;  // BadVAddr is read-only
+        case 9:  registers_.cop0[9] = value - static_cast<uint32_t>(cycle_count_); break;
+        case 12: registers_.status = value; break;
+        case 13: registers_.cause = (registers_.cause & ~0x300u) | (value & 0x300u); break;  // Only IP0/IP1
+        case 14: registers_.epc = value; break;
+        case 15: break;  // PRId is read-only
+        default: registers_.cop0[reg & 31] = value; break;
+    }
+}
+
+} // namespace recovery
+} // namespace gscx
@@ -0,0 +1,485 @@
+#include "ee_engine.h"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <emmintrin.h>
+
+namespace gscx {
+namespace recovery {
+
+// R5900 parallel (MMI) instructions. GPRs are 128 bits wide; HI and LO
+// are too, with their upper halves in hi1/lo1 (the pipeline 1 registers
+// of MULT1/DIV1 and friends). Everything here is SSE2, the x86-64
+// baseline; the recompiler emits the common ops inline with AVX forms.
+
+namespace {
+
+inline __m128i load_gpr(const uint64_t (&reg)[2]) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(reg));
+}
+
+inline void store_gpr(uint64_t (&reg)[2], __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(reg), value);
+}
+
+inline __m128i load_pair(uint64_t low, uint64_t high) {
+    return _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+}
+
+inline void store_pair(uint64_t& low, uint64_t& high, __m128i value) {
+    low = static_cast<uint64_t>(_mm_cvtsi128_si64(value));
+    high = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(value, value)));
+}
+
+inline uint64_t sext32(uint64_t value) {
+    return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(value)));
+}
+
+// mask ? a : b
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Word operations SSE2 only has for bytes and halfwords
+inline __m128i adds_epi32(__m128i a, __m128i b) {
+    __m128i sum = _mm_add_epi32(a, b);
+    __m128i overflow = _mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, sum)), 31);
+    __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT32_MAX));
+    return select(overflow, saturated, sum);
+}
+
+inline __m128i subs_epi32(__m128i a, __m128i b) {
+    __m128i difference = _mm_sub_epi32(a, b);
+    __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, difference)), 31);
+    __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT32_MAX));
+    return select(overflow, saturated, difference);
+}
+
+// Unsigned compare through the sign-flipped signed compare
+inline __m128i cmpgt_epu32(__m128i a, __m128i b) {
+    __m128i bias = _mm_set1_epi32(INT32_MIN);
+    return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+inline __m128i adds_epu32(__m128i a, __m128i b) {
+    __m128i sum = _mm_add_epi32(a, b);
+    return _mm_or_si128(sum, cmpgt_epu32(a, sum));
+}
+
+inline __m128i subs_epu32(__m128i a, __m128i b) {
+    return _mm_and_si128(_mm_sub_epi32(a, b), cmpgt_epu32(a, b));
+}
+
+inline __m128i max_epi32(__m128i a, __m128i b) {
+    return select(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+inline __m128i min_epi32(__m128i a, __m128i b) {
+    return select(_mm_cmpgt_epi32(a, b), b, a);
+}
+
+// |x| with the most negative value saturating to the most positive
+inline __m128i abs_epi32(__m128i x) {
+    __m128i sign = _mm_srai_epi32(x, 31);
+    __m128i magnitude = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+    return _mm_add_epi32(magnitude, _mm_srai_epi32(magnitude, 31));
+}
+
+inline __m128i abs_epi16(__m128i x) {
+    __m128i sign = _mm_srai_epi16(x, 15);
+    __m128i magnitude = _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+    return _mm_add_epi16(magnitude, _mm_srai_epi16(magnitude, 15));
+}
+
+// Packs keeping the low half of each element (PPACH/PPACB); sign
+// extending first makes the saturating pack exact
+inline __m128i pack_low_epi32(__m128i low, __m128i high) {
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+    return _mm_packs_epi32(low, high);
+}
+
+inline __m128i pack_low_epi16(__m128i low, __m128i high) {
+    low = _mm_srai_epi16(_mm_slli_epi16(low, 8), 8);
+    high = _mm_srai_epi16(_mm_slli_epi16(high, 8), 8);
+    return _mm_packs_epi16(low, high);
+}
+
+// Words 0 and 2 of a, interleaved with words 0 and 2 of b
+inline __m128i even_words(__m128i a, __m128i b) {
+    __m128 packed = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0));
+    return _mm_shuffle_epi32(_mm_castps_si128(packed), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+inline __m128i odd_words(__m128i a, __m128i b) {
+    __m128 packed = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1));
+    return _mm_shuffle_epi32(_mm_castps_si128(packed), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// Signed halfword products as words: p0-p3 in low, p4-p7 in high
+inline void multiply_halves(__m128i a, __m128i b, __m128i& low, __m128i& high) {
+    __m128i product_low = _mm_mullo_epi16(a, b);
+    __m128i product_high = _mm_mulhi_epi16(a, b);
+    low = _mm_unpacklo_epi16(product_low, product_high);
+    high = _mm_unpackhi_epi16(product_low, product_high);
+}
+
+// Same results as DIV/DIVU for a zero divisor and INT_MIN / -1
+inline void divide(int32_t dividend, int32_t divisor, int32_t& quotient, int32_t& remainder) {
+    if (divisor == 0) {
+        quotient = dividend < 0 ? 1 : -1;
+        remainder = dividend;
+    } else if (dividend == INT32_MIN && divisor == -1) {
+        quotient = INT32_MIN;
+        remainder = 0;
+    } else {
+        quotient = dividend / divisor;
+        remainder = dividend % divisor;
+    }
+}
+
+inline void divide_unsigned(uint32_t dividend, uint32_t divisor, uint32_t& quotient, uint32_t& remainder) {
+    if (divisor == 0) {
+        quotient = 0xFFFFFFFF;
+        remainder = dividend;
+    } else {
+        quotient = dividend / divisor;
+        remainder = dividend % divisor;
+    }
+}
+
+} // namespace
+
+void EmotionEngine::execute_parallel(const EEInstruction& instr) {
+    uint64_t (&rd)[2] = registers_.gpr[instr.rd];
+    __m128i rs = load_gpr(registers_.gpr[instr.rs]);
+    __m128i rt = load_gpr(registers_.gpr[instr.rt]);
+    uint32_t sa = instr.shamt;
+
+    switch (instr.op) {
+        // Wrapping and saturating arithmetic
+        case EEOp::PADDW:  store_gpr(rd, _mm_add_epi32(rs, rt)); return;
+        case EEOp::PADDH:  store_gpr(rd, _mm_add_epi16(rs, rt)); return;
+        case EEOp::PADDB:  store_gpr(rd, _mm_add_epi8(rs, rt)); return;
+        case EEOp::PSUBW:  store_gpr(rd, _mm_sub_epi32(rs, rt)); return;
+        case EEOp::PSUBH:  store_gpr(rd, _mm_sub_epi16(rs, rt)); return;
+        case EEOp::PSUBB:  store_gpr(rd, _mm_sub_epi8(rs, rt)); return;
+        case EEOp::PADDSW: store_gpr(rd, adds_epi32(rs, rt)); return;
+        case EEOp::PADDSH: store_gpr(rd, _mm_adds_epi16(rs, rt)); return;
+        case EEOp::PADDSB: store_gpr(rd, _mm_adds_epi8(rs, rt)); return;
+        case EEOp::PSUBSW: store_gpr(rd, subs_epi32(rs, rt)); return;
+        case EEOp::PSUBSH: store_gpr(rd, _mm_subs_epi16(rs, rt)); return;
+        case EEOp::PSUBSB: store_gpr(rd, _mm_subs_epi8(rs, rt)); return;
+        case EEOp::PADDUW: store_gpr(rd, adds_epu32(rs, rt)); return;
+        case EEOp::PADDUH: store_gpr(rd, _mm_adds_epu16(rs, rt)); return;
+        case EEOp::PADDUB: store_gpr(rd, _mm_adds_epu8(rs, rt)); return;
+        case EEOp::PSUBUW: store_gpr(rd, subs_epu32(rs, rt)); return;
+        case EEOp::PSUBUH: store_gpr(rd, _mm_subs_epu16(rs, rt)); return;
+        case EEOp::PSUBUB: store_gpr(rd, _mm_subs_epu8(rs, rt)); return;
+        case EEOp::PADSBH:
+            // Lower four halfwords subtract, upper four add
+            store_gpr(rd, _mm_unpacklo_epi64(_mm_sub_epi16(rs, rt), _mm_srli_si128(_mm_add_epi16(rs, rt), 8)));
+            return;
+        case EEOp::PABSW:  store_gpr(rd, abs_epi32(rt)); return;
+        case EEOp::PABSH:  store_gpr(rd, abs_epi16(rt)); return;
+
+        // Compare and min/max (signed)
+        case EEOp::PCGTW:  store_gpr(rd, _mm_cmpgt_epi32(rs, rt)); return;
+        case EEOp::PCGTH:  store_gpr(rd, _mm_cmpgt_epi16(rs, rt)); return;
+        case EEOp::PCGTB:  store_gpr(rd, _mm_cmpgt_epi8(rs, rt)); return;
+        case EEOp::PCEQW:  store_gpr(rd, _mm_cmpeq_epi32(rs, rt)); return;
+        case EEOp::PCEQH:  store_gpr(rd, _mm_cmpeq_epi16(rs, rt)); return;
+        case EEOp::PCEQB:  store_gpr(rd, _mm_cmpeq_epi8(rs, rt)); return;
+        case EEOp::PMAXW:  store_gpr(rd, max_epi32(rs, rt)); return;
+        case EEOp::PMAXH:  store_gpr(rd, _mm_max_epi16(rs, rt)); return;
+        case EEOp::PMINW:  store_gpr(rd, min_epi32(rs, rt)); return;
+        case EEOp::PMINH:  store_gpr(rd, _mm_min_epi16(rs, rt)); return;
+
+        // Logical
+        case EEOp::PAND:   store_gpr(rd, _mm_and_si128(rs, rt)); return;
+        case EEOp::POR:    store_gpr(rd, _mm_or_si128(rs, rt)); return;
+        case EEOp::PXOR:   store_gpr(rd, _mm_xor_si128(rs, rt)); return;
+        case EEOp::PNOR:   store_gpr(rd, _mm_xor_si128(_mm_or_si128(rs, rt), _mm_set1_epi32(-1))); return;
+
+        // Shifts: by sa, or per word by rs for the low word of each doubleword
+        case EEOp::PSLLH:  store_gpr(rd, _mm_sll_epi16(rt, _mm_cvtsi32_si128(static_cast<int>(sa & 15)))); return;
+        case EEOp::PSRLH:  store_gpr(rd, _mm_srl_epi16(rt, _mm_cvtsi32_si128(static_cast<int>(sa & 15)))); return;
+        case EEOp::PSRAH:  store_gpr(rd, _mm_sra_epi16(rt, _mm_cvtsi32_si128(static_cast<int>(sa & 15)))); return;
+        case EEOp::PSLLW:  store_gpr(rd, _mm_sll_epi32(rt, _mm_cvtsi32_si128(static_cast<int>(sa)))); return;
+        case EEOp::PSRLW:  store_gpr(rd, _mm_srl_epi32(rt, _mm_cvtsi32_si128(static_cast<int>(sa)))); return;
+        case EEOp::PSRAW:  store_gpr(rd, _mm_sra_epi32(rt, _mm_cvtsi32_si128(static_cast<int>(sa)))); return;
+        case EEOp::PSLLVW:
+        case EEOp::PSRLVW:
+        case EEOp::PSRAVW: {
+            const uint64_t (&s)[2] = registers_.gpr[instr.rs];
+            const uint64_t (&t)[2] = registers_.gpr[instr.rt];
+            uint64_t result[2];
+            for (int i = 0; i < 2; i++) {
+                uint32_t value = static_cast<uint32_t>(t[i]);
+                uint32_t shift = static_cast<uint32_t>(s[i]) & 31;
+                if (instr.op == EEOp::PSLLVW) {
+                    value <<= shift;
+                } else if (instr.op == EEOp::PSRLVW) {
+                    value >>= shift;
+                } else {
+                    value = static_cast<uint32_t>(static_cast<int32_t>(value) >> shift);
+                }
+                result[i] = sext32(value);
+            }
+            rd[0] = result[0];
+            rd[1] = result[1];
+            return;
+        }
+        case EEOp::QFSRV: {
+            // rs:rt shifted right by SA bytes
+            uint8_t bytes[32];
+            std::memcpy(bytes, registers_.gpr[instr.rt], 16);
+            std::memcpy(bytes + 16, registers_.gpr[instr.rs], 16);
+            std::memcpy(rd, bytes + (registers_.sa & 15), 16);
+            return;
+        }
+        case EEOp::PLZCW: {
+            // Leading bits equal to the sign bit, not counting the sign
+            const uint64_t& s = registers_.gpr[instr.rs][0];
+            uint32_t counts[2];
+            for (int i = 0; i < 2; i++) {
+                uint32_t word = static_cast<uint32_t>(s >> (i * 32));
+                if (word & 0x80000000) {
+                    word = ~word;
+                }
+                counts[i] = static_cast<uint32_t>(std::countl_zero(word)) - 1;
+            }
+            rd[0] = (static_cast<uint64_t>(counts[1]) << 32) | counts[0];
+            return;
+        }
+
+        // Interleave, pack and permute
+        case EEOp::PEXTLW: store_gpr(rd, _mm_unpacklo_epi32(rt, rs)); return;
+        case EEOp::PEXTLH: store_gpr(rd, _mm_unpacklo_epi16(rt, rs)); return;
+        case EEOp::PEXTLB: store_gpr(rd, _mm_unpacklo_epi8(rt, rs)); return;
+        case EEOp::PEXTUW: store_gpr(rd, _mm_unpackhi_epi32(rt, rs)); return;
+        case EEOp::PEXTUH: store_gpr(rd, _mm_unpackhi_epi16(rt, rs)); return;
+        case EEOp::PEXTUB: store_gpr(rd, _mm_unpackhi_epi8(rt, rs)); return;
+        case EEOp::PPACW:
+            store_gpr(rd, _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(rt), _mm_castsi128_ps(rs), _MM_SHUFFLE(2, 0, 2, 0))));
+            return;
+        case EEOp::PPACH:  store_gpr(rd, pack_low_epi32(rt, rs)); return;
+        case EEOp::PPACB:  store_gpr(rd, pack_low_epi16(rt, rs)); return;
+        case EEOp::PCPYLD: store_gpr(rd, _mm_unpacklo_epi64(rt, rs)); return;
+        case EEOp::PCPYUD: store_gpr(rd, _mm_unpackhi_epi64(rs, rt)); return;
+        case EEOp::PCPYH:
+            store_gpr(rd, _mm_shufflehi_epi16(_mm_shufflelo_epi16(rt, 0), 0));
+            return;
+        case EEOp::PINTH:  store_gpr(rd, _mm_unpacklo_epi16(rt, _mm_srli_si128(rs, 8))); return;
+        case EEOp::PINTEH:
+            store_gpr(rd, _mm_or_si128(_mm_srli_epi32(_mm_slli_epi32(rt, 16), 16), _mm_slli_epi32(rs, 16)));
+            return;
+        case EEOp::PEXEH:
+            store_gpr(rd, _mm_shufflehi_epi16(_mm_shufflelo_epi16(rt, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2)));
+            return;
+        case EEOp::PREVH:
+            store_gpr(rd, _mm_shufflehi_epi16(_mm_shufflelo_epi16(rt, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3)));
+            return;
+        case EEOp::PEXCH:
+            store_gpr(rd, _mm_shufflehi_epi16(_mm_shufflelo_epi16(rt, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0)));
+            return;
+        case EEOp::PEXEW:  store_gpr(rd, _mm_shuffle_epi32(rt, _MM_SHUFFLE(3, 0, 1, 2))); return;
+        case EEOp::PEXCW:  store_gpr(rd, _mm_shuffle_epi32(rt, _MM_SHUFFLE(3, 1, 2, 0))); return;
+        case EEOp::PROT3W: store_gpr(rd, _mm_shuffle_epi32(rt, _MM_SHUFFLE(3, 0, 2, 1))); return;
+        case EEOp::PEXT5: {
+            // 1:5:5:5 halfwords to 8:8:8:8 words
+            __m128i mask = _mm_set1_epi32(0x1F);
+            __m128i red = _mm_slli_epi32(_mm_and_si128(rt, mask), 3);
+            __m128i green = _mm_slli_epi32(_mm_and_si128(rt, _mm_slli_epi32(mask, 5)), 6);
+            __m128i blue = _mm_slli_epi32(_mm_and_si128(rt, _mm_slli_epi32(mask, 10)), 9);
+            __m128i alpha = _mm_slli_epi32(_mm_and_si128(rt, _mm_set1_epi32(0x8000)), 16);
+            store_gpr(rd, _mm_or_si128(_mm_or_si128(red, green), _mm_or_si128(blue, alpha)));
+            return;
+        }
+        case EEOp::PPAC5: {
+            __m128i mask = _mm_set1_epi32(0x1F);
+            __m128i red = _mm_and_si128(_mm_srli_epi32(rt, 3), mask);
+            __m128i green = _mm_and_si128(_mm_srli_epi32(rt, 6), _mm_slli_epi32(mask, 5));
+            __m128i blue = _mm_and_si128(_mm_srli_epi32(rt, 9), _mm_slli_epi32(mask, 10));
+            __m128i alpha = _mm_and_si128(_mm_srli_epi32(rt, 16), _mm_set1_epi32(0x8000));
+            store_gpr(rd, _mm_or_si128(_mm_or_si128(red, green), _mm_or_si128(blue, alpha)));
+            return;
+        }
+        default:
+            break;
+    }
+
+    // HI/LO group
+    __m128i hi = load_pair(registers_.hi, registers_.hi1);
+    __m128i lo = load_pair(registers_.lo, registers_.lo1);
+
+    switch (instr.op) {
+        case EEOp::PMFHI: store_gpr(rd, hi); return;
+        case EEOp::PMFLO: store_gpr(rd, lo); return;
+        case EEOp::PMTHI: store_pair(registers_.hi, registers_.hi1, rs); return;
+        case EEOp::PMTLO: store_pair(registers_.lo, registers_.lo1, rs); return;
+        case EEOp::PMFHL:
+            switch (sa) {
+                case 0:  // LW
+                    store_gpr(rd, even_words(lo, hi));
+                    return;
+                case 1:  // UW
+                    store_gpr(rd, odd_words(lo, hi));
+                    return;
+                case 2: {  // SLW: HI:LO doublewords saturated to 32 bits
+                    uint64_t result[2];
+                    uint64_t his[2] = { registers_.hi, registers_.hi1 };
+                    uint64_t los[2] = { registers_.lo, registers_.lo1 };
+                    for (int i = 0; i < 2; i++) {
+                        int64_t value = static_cast<int64_t>((his[i] << 32) | (los[i] & 0xFFFFFFFF));
+                        result[i] = static_cast<uint64_t>(std::clamp<int64_t>(value, INT32_MIN, INT32_MAX));
+                    }
+                    rd[0] = result[0];
+                    rd[1] = result[1];
+                    return;
+                }
+                case 3:  // LH
+                    store_gpr(rd, pack_low_epi32(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)));
+                    return;
+                case 4:  // SH
+                    store_gpr(rd, _mm_packs_epi32(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)));
+                    return;
+                default:
+                    trigger_exception(EEException::RESERVED_INSTRUCTION);
+                    return;
+            }
+        case EEOp::PMTHL: {
+            if (sa != 0) {
+                trigger_exception(EEException::RESERVED_INSTRUCTION);
+                return;
+            }
+            // Words 0/2 of LO and HI from alternating words of rs
+            __m128i keep = _mm_set_epi32(-1, 0, -1, 0);
+            __m128i low_words = _mm_shuffle_epi32(rs, _MM_SHUFFLE(2, 2, 0, 0));
+            __m128i high_words = _mm_shuffle_epi32(rs, _MM_SHUFFLE(3, 3, 1, 1));
+            store_pair(registers_.lo, registers_.lo1, select(keep, lo, low_words));
+            store_pair(registers_.hi, registers_.hi1, select(keep, hi, high_words));
+            return;
+        }
+
+        // Halfword multiplies: products 0,1,4,5 go to LO and 2,3,6,7 to HI
+        case EEOp::PMULTH:
+        case EEOp::PMADDH:
+        case EEOp::PMSUBH: {
+            __m128i low, high;
+            multiply_halves(rs, rt, low, high);
+            __m128i lo_products = _mm_unpacklo_epi64(low, high);
+            __m128i hi_products = _mm_unpackhi_epi64(low, high);
+            if (instr.op == EEOp::PMADDH) {
+                lo = _mm_add_epi32(lo, lo_products);
+                hi = _mm_add_epi32(hi, hi_products);
+            } else if (instr.op == EEOp::PMSUBH) {
+                lo = _mm_sub_epi32(lo, lo_products);
+                hi = _mm_sub_epi32(hi, hi_products);
+            } else {
+                lo = lo_products;
+                hi = hi_products;
+            }
+            store_pair(registers_.lo, registers_.lo1, lo);
+            store_pair(registers_.hi, registers_.hi1, hi);
+            store_gpr(rd, even_words(lo, hi));
+            return;
+        }
+        case EEOp::PHMADH:
+        case EEOp::PHMSBH: {
+            // Pairwise sum (difference) of adjacent products; the odd
+            // words of HI/LO keep the odd product (inverted for PHMSBH)
+            __m128i low, high;
+            multiply_halves(rs, rt, low, high);
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128i result;
+            if (instr.op == EEOp::PHMADH) {
+                result = _mm_add_epi32(odd, even);
+            } else {
+                result = _mm_sub_epi32(odd, even);
+                odd = _mm_xor_si128(odd, _mm_set1_epi32(-1));
+            }
+            __m128i sums = _mm_shuffle_epi32(result, _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i products = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+            store_pair(registers_.lo, registers_.lo1, _mm_unpacklo_epi32(sums, products));
+            store_pair(registers_.hi, registers_.hi1, _mm_unpackhi_epi32(sums, products));
+            store_gpr(rd, result);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // Word multiply/divide on words 0 and 2, one per HI/LO doubleword
+    uint64_t* his[2] = { &registers_.hi, &registers_.hi1 };
+    uint64_t* los[2] = { &registers_.lo, &registers_.lo1 };
+    const uint64_t (&s)[2] = registers_.gpr[instr.rs];
+    const uint64_t (&t)[2] = registers_.gpr[instr.rt];
+
+    switch (instr.op) {
+        case EEOp::PMULTW:
+        case EEOp::PMULTUW:
+        case EEOp::PMADDW:
+        case EEOp::PMADDUW:
+        case EEOp::PMSUBW: {
+            bool is_signed = instr.op != EEOp::PMULTUW && instr.op != EEOp::PMADDUW;
+            uint64_t result[2];
+            for (int i = 0; i < 2; i++) {
+                uint64_t product = is_signed
+                    ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(s[i])) * static_cast<int32_t>(t[i]))
+                    : static_cast<uint64_t>(static_cast<uint32_t>(s[i])) * static_cast<uint32_t>(t[i]);
+                uint64_t accumulator = (*his[i] << 32) | (*los[i] & 0xFFFFFFFF);
+                if (instr.op == EEOp::PMADDW || instr.op == EEOp::PMADDUW) {
+                    product = accumulator + product;
+                } else if (instr.op == EEOp::PMSUBW) {
+                    product = accumulator - product;
+                }
+                *los[i] = sext32(product);
+                *his[i] = sext32(product >> 32);
+                result[i] = product;
+            }
+            rd[0] = result[0];
+            rd[1] = result[1];
+            return;
+        }
+        case EEOp::PDIVW:
+            for (int i = 0; i < 2; i++) {
+                int32_t quotient, remainder;
+                divide(static_cast<int32_t>(s[i]), static_cast<int32_t>(t[i]), quotient, remainder);
+                *los[i] = sext32(static_cast<uint32_t>(quotient));
+                *his[i] = sext32(static_cast<uint32_t>(remainder));
+            }
+            return;
+        case EEOp::PDIVUW:
+            for (int i = 0; i < 2; i++) {
+                uint32_t quotient, remainder;
+                divide_unsigned(static_cast<uint32_t>(s[i]), static_cast<uint32_t>(t[i]), quotient, remainder);
+                *los[i] = sext32(quotient);
+                *his[i] = sext32(remainder);
+            }
+            return;
+        case EEOp::PDIVBW: {
+            // Four words of rs by halfword 0 of rt
+            int32_t divisor = static_cast<int16_t>(t[0]);
+            uint32_t quotients[4], remainders[4];
+            for (int i = 0; i < 4; i++) {
+                int32_t quotient, remainder;
+                divide(static_cast<int32_t>(s[i / 2] >> ((i & 1) * 32)), divisor, quotient, remainder);
+                quotients[i] = static_cast<uint32_t>(quotient);
+                remainders[i] = static_cast<uint32_t>(remainder);
+            }
+            registers_.lo = (static_cast<uint64_t>(quotients[1]) << 32) | quotients[0];
+            registers_.lo1 = (static_cast<uint64_t>(quotients[3]) << 32) | quotients[2];
+            registers_.hi = (static_cast<uint64_t>(remainders[1]) << 32) | remainders[0];
+            registers_.hi1 = (static_cast<uint64_t>(remainders[3]) << 32) | remainders[2];
+            return;
+        }
+        default:
+            trigger_exception(EEException::RESERVED_INSTRUCTION);
+            return;
+    }
+}
+
+} // namespace recovery
+} // namespace gscx
@@ -0,0 +1,1159 @@
+#include "ee_recompiler.h"
+#include "simd_support.h"
+#include "x64_emitter.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+
+namespace gscx {
+namespace recovery {
+
+using GSCX::Core::VecWidth;
+using GSCX::Core::X64Cond;
+using GSCX::Core::X64Emitter;
+using GSCX::Core::X64Reg;
+
+namespace {
+
+// Host register roles: R15 points at the EE registers, R14 at the JIT
+// context, RAX/RCX/RDX are scratch and the rest hold guest GPRs
+constexpr X64Reg REGS = X64Reg::R15;
+constexpr X64Reg CONTEXT = X64Reg::R14;
+constexpr X64Reg ALLOCATABLE[] = {
+    X64Reg::RBX, X64Reg::RBP, X64Reg::R12, X64Reg::R13, X64Reg::RSI,
+    X64Reg::RDI, X64Reg::R8, X64Reg::R9, X64Reg::R10, X64Reg::R11
+};
+constexpr size_t ALLOCATABLE_COUNT = sizeof(ALLOCATABLE) / sizeof(ALLOCATABLE[0]);
+
+// Saved by the entry stub: callee-saved on SysV and Win64 together
+constexpr X64Reg SAVED[] = {
+    X64Reg::RBX, X64Reg::RBP, X64Reg::RSI, X64Reg::RDI,
+    X64Reg::R12, X64Reg::R13, X64Reg::R14, X64Reg::R15
+};
+// Realigns RSP to 16 bytes after the pushes, with Win64 shadow space
+constexpr int32_t FRAME_SIZE = 40;
+
+constexpr int32_t gpr_offset(int reg) {
+    return static_cast<int32_t>(offsetof(EERegisters, gpr) + reg * 16);
+}
+
+constexpr int32_t reg_offset(size_t offset) { return static_cast<int32_t>(offset); }
+
+constexpr int32_t context_offset(size_t offset) { return static_cast<int32_t>(offset); }
+
+constexpr X64Reg NO_REG = X64Reg::RSP;
+
+int32_t simm16(const EEInstruction& instr) {
+    return static_cast<int16_t>(instr.immediate);
+}
+
+int32_t sext32(uint32_t value) {
+    return static_cast<int32_t>(value);
+}
+
+bool is_branch(const EEInstruction& instr) {
+    return instr.type == EEInstructionType::BRANCH || instr.type == EEInstructionType::JUMP;
+}
+
+// Instructions that leave a block's control flow to the interpreter
+bool ends_block(const EEInstruction& instr) {
+    switch (instr.op) {
+        case EEOp::ERET:
+        case EEOp::BC0F: case EEOp::BC0T: case EEOp::BC0FL: case EEOp::BC0TL:
+        case EEOp::BC1F: case EEOp::BC1T: case EEOp::BC1FL: case EEOp::BC1TL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool is_likely(EEOp op) {
+    switch (op) {
+        case EEOp::BEQL: case EEOp::BNEL: case EEOp::BLEZL: case EEOp::BGTZL:
+        case EEOp::BLTZL: case EEOp::BGEZL: case EEOp::BLTZALL: case EEOp::BGEZALL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Load/store width, or 0 for instructions that are not plain accesses
+int access_size(EEOp op) {
+    switch (op) {
+        case EEOp::LB: case EEOp::LBU: case EEOp::SB: return 1;
+        case EEOp::LH: case EEOp::LHU: case EEOp::SH: return 2;
+        case EEOp::LW: case EEOp::LWU: case EEOp::SW: return 4;
+        case EEOp::LD: case EEOp::SD: return 8;
+        case EEOp::LQ: case EEOp::SQ: return 16;
+        default: return 0;
+    }
+}
+
+bool is_store(EEOp op) {
+    return op == EEOp::SB || op == EEOp::SH || op == EEOp::SW || op == EEOp::SD || op == EEOp::SQ;
+}
+
+// Parallel ops emitted inline: the ones without HI/LO or SA that map
+// to a few AVX instructions
+bool is_native_parallel(EEOp op) {
+    switch (op) {
+        case EEOp::PADDW: case EEOp::PADDH: case EEOp::PADDB:
+        case EEOp::PSUBW: case EEOp::PSUBH: case EEOp::PSUBB:
+        case EEOp::PADDSH: case EEOp::PADDSB: case EEOp::PSUBSH: case EEOp::PSUBSB:
+        case EEOp::PADDUH: case EEOp::PADDUB: case EEOp::PSUBUH: case EEOp::PSUBUB:
+        case EEOp::PADSBH: case EEOp::PABSW: case EEOp::PABSH:
+        case EEOp::PCGTW: case EEOp::PCGTH: case EEOp::PCGTB:
+        case EEOp::PCEQW: case EEOp::PCEQH: case EEOp::PCEQB:
+        case EEOp::PMAXW: case EEOp::PMAXH: case EEOp::PMINW: case EEOp::PMINH:
+        case EEOp::PAND: case EEOp::POR: case EEOp::PXOR: case EEOp::PNOR:
+        case EEOp::PSLLH: case EEOp::PSRLH: case EEOp::PSRAH:
+        case EEOp::PSLLW: case EEOp::PSRLW: case EEOp::PSRAW:
+        case EEOp::PEXTLW: case EEOp::PEXTLH: case EEOp::PEXTLB:
+        case EEOp::PEXTUW: case EEOp::PEXTUH: case EEOp::PEXTUB:
+        case EEOp::PPACW: case EEOp::PPACH: case EEOp::PPACB:
+        case EEOp::PCPYLD: case EEOp::PCPYUD: case EEOp::PCPYH:
+        case EEOp::PINTH: case EEOp::PINTEH:
+        case EEOp::PEXEH: case EEOp::PREVH: case EEOp::PEXCH:
+        case EEOp::PEXEW: case EEOp::PEXCW: case EEOp::PROT3W:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Instructions emitted inline; everything else calls the interpreter
+bool is_native(const EEInstruction& instr, bool vector_ops) {
+    switch (instr.op) {
+        case EEOp::ADDU: case EEOp::SUBU: case EEOp::ADDIU:
+        case EEOp::DADDU: case EEOp::DSUBU: case EEOp::DADDIU:
+        case EEOp::SLT: case EEOp::SLTU: case EEOp::SLTI: case EEOp::SLTIU:
+        case EEOp::LUI: case EEOp::MOVZ: case EEOp::MOVN:
+        case EEOp::AND: case EEOp::OR: case EEOp::XOR: case EEOp::NOR:
+        case EEOp::ANDI: case EEOp::ORI: case EEOp::XORI:
+        case EEOp::SLL: case EEOp::SRL: case EEOp::SRA:
+        case EEOp::SLLV: case EEOp::SRLV: case EEOp::SRAV:
+        case EEOp::DSLL: case EEOp::DSRL: case EEOp::DSRA:
+        case EEOp::DSLL32: case EEOp::DSRL32: case EEOp::DSRA32:
+        case EEOp::DSLLV: case EEOp::DSRLV: case EEOp::DSRAV:
+        case EEOp::MFHI: case EEOp::MFLO: case EEOp::MTHI: case EEOp::MTLO:
+        case EEOp::MFHI1: case EEOp::MFLO1: case EEOp::MTHI1: case EEOp::MTLO1:
+        case EEOp::MULT: case EEOp::MULTU: case EEOp::MULT1: case EEOp::MULTU1:
+        case EEOp::LB: case EEOp::LBU: case EEOp::LH: case EEOp::LHU:
+        case EEOp::LW: case EEOp::LWU: case EEOp::LD:
+        case EEOp::SB: case EEOp::SH: case EEOp::SW: case EEOp::SD:
+        case EEOp::SYNC: case EEOp::CACHE: case EEOp::PREF:
+            return true;
+        case EEOp::LQ: case EEOp::SQ:
+            return vector_ops;
+        default:
+            if (instr.type == EEInstructionType::PARALLEL) {
+                return vector_ops && is_native_parallel(instr.op);
+            }
+            return is_branch(instr) && !ends_block(instr);
+    }
+}
+
+// GPR a native instruction writes, or 0
+int native_dest(const EEInstruction& instr) {
+    switch (instr.op) {
+        case EEOp::ADDIU: case EEOp::DADDIU: case EEOp::SLTI: case EEOp::SLTIU: case EEOp::LUI:
+        case EEOp::ANDI: case EEOp::ORI: case EEOp::XORI:
+        case EEOp::LB: case EEOp::LBU: case EEOp::LH: case EEOp::LHU:
+        case EEOp::LW: case EEOp::LWU: case EEOp::LD: case EEOp::LQ:
+            return instr.rt;
+        case EEOp::BLTZAL: case EEOp::BGEZAL: case EEOp::BLTZALL: case EEOp::BGEZALL: case EEOp::JAL:
+            return 31;
+        case EEOp::MTHI: case EEOp::MTLO: case EEOp::MTHI1: case EEOp::MTLO1:
+        case EEOp::SB: case EEOp::SH: case EEOp::SW: case EEOp::SD: case EEOp::SQ:
+        case EEOp::SYNC: case EEOp::CACHE: case EEOp::PREF:
+        case EEOp::J: case EEOp::JR:
+            return 0;
+        default:
+            // SPECIAL-format results and JALR
+            return is_branch(instr) ? (instr.op == EEOp::JALR ? instr.rd : 0) : instr.rd;
+    }
+}
+
+// Addresses baked into generated code
+struct BlockTargets {
+    const void* recompiler;
+    const void* interpret;
+    const void* exit_stub;
+    uint8_t* const* page_table;
+    const uint8_t* memory_base;
+    const uint8_t* code_page_flags;
+    const EEJumpCacheEntry* jump_cache;
+    uint32_t jump_cache_mask;
+    bool vector_ops;
+};
+
+class BlockCompiler : public X64Emitter {
+public:
+    BlockCompiler(EEBlock* block, const BlockTargets& targets)
+        : block_(block)
+        , targets_(targets) {
+        std::fill(std::begin(host_), std::end(host_), NO_REG);
+        std::fill(std::begin(dirty_), std::end(dirty_), false);
+    }
+
+    void compile() {
+        allocate();
+        uint32_t count = block_->instruction_count;
+
+        // The budget is checked before anything is loaded; pc already
+        // holds the block's address
+        cmp_mem_imm8(CONTEXT, context_offset(offsetof(EEJitContext, budget)), 0);
+        leave_.push_back(jcc(X64Cond::LE));
+        add_mem_imm32(CONTEXT, context_offset(offsetof(EEJitContext, budget)), -static_cast<int32_t>(count));
+        reload();
+
+        bool ended = false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (is_branch(block_->instructions[i])) {
+                emit_branch(i);
+                ended = true;
+                break;
+            }
+            emit_instruction(i, false);
+        }
+        if (!ended) {
+            emit_exit(1, block_->pc + count * 4);
+        }
+
+        for (size_t label : leave_) {
+            bind(label);
+        }
+        mov_imm64(X64Reg::RAX, reinterpret_cast<uint64_t>(targets_.exit_stub));
+        jmp(X64Reg::RAX);
+    }
+
+private:
+    // The most referenced GPRs of the block get host registers
+    void allocate() {
+        uint32_t uses[32] = {};
+        bool written[32] = {};
+        for (const EEInstruction& instr : block_->instructions) {
+            // Parallel ops work on EERegisters directly
+            if (!is_native(instr, targets_.vector_ops) || instr.type == EEInstructionType::PARALLEL) {
+                continue;
+            }
+            uses[instr.rs]++;
+            uses[instr.rt]++;
+            int dest = native_dest(instr);
+            uses[dest]++;
+            written[dest] = true;
+        }
+
+        int order[31];
+        for (int i = 0; i < 31; i++) {
+            order[i] = i + 1;
+        }
+        std::stable_sort(std::begin(order), std::end(order), [&](int a, int b) { return uses[a] > uses[b]; });
+        for (size_t i = 0; i < ALLOCATABLE_COUNT && uses[order[i]] >= 2; i++) {
+            host_[order[i]] = ALLOCATABLE[i];
+            dirty_[order[i]] = written[order[i]];
+        }
+    }
+
+    // Guest GPR access (low 64 bits)
+    void get(X64Reg dst, int reg) {
+        if (reg == 0) {
+            xor_(dst, dst, false);
+        } else if (host_[reg] != NO_REG) {
+            mov(dst, host_[reg]);
+        } else {
+            mov(dst, REGS, gpr_offset(reg));
+        }
+    }
+
+    void set(int reg, X64Reg src) {
+        if (reg == 0) {
+            return;
+        }
+        if (host_[reg] != NO_REG) {
+            mov(host_[reg], src);
+        } else {
+            store(REGS, gpr_offset(reg), src, 8);
+        }
+    }
+
+    void set_imm(int reg, int32_t value) {
+        if (reg == 0) {
+            return;
+        }
+        if (host_[reg] != NO_REG) {
+            mov_simm32(host_[reg], value);
+        } else {
+            store_simm32(REGS, gpr_offset(reg), value);
+        }
+    }
+
+    // Host registers <-> EERegisters, around calls and at exits
+    void flush() {
+        for (int reg = 1; reg < 32; reg++) {
+            if (dirty_[reg]) {
+                store(REGS, gpr_offset(reg), host_[reg], 8);
+            }
+        }
+    }
+
+    void reload() {
+        for (int reg = 1; reg < 32; reg++) {
+            if (host_[reg] != NO_REG) {
+                mov(host_[reg], REGS, gpr_offset(reg));
+            }
+        }
+    }
+
+    uint32_t pc_of(uint32_t index) const { return block_->pc + index * 4; }
+
+    // Leaves the block after instruction `index` with pc already set
+    // (exception or dropped code); the rest is given back to the budget
+    void emit_early_exit(uint32_t index) {
+        int32_t unused = static_cast<int32_t>(block_->instruction_count - index - 1);
+        if (unused) {
+            add_mem_imm32(CONTEXT, context_offset(offsetof(EEJitContext, budget)), unused);
+        }
+        store_simm32(CONTEXT, context_offset(offsetof(EEJitContext, last_exit)), 0);
+        leave_.push_back(jmp());
+    }
+
+    void emit_interpret(uint32_t index, bool delay_slot) {
+        flush();
+        mov_imm64(arg_reg(0), reinterpret_cast<uint64_t>(targets_.recompiler));
+        mov_imm64(arg_reg(1), reinterpret_cast<uint64_t>(&block_->instructions[index]));
+        mov_imm32(arg_reg(2), pc_of(index));
+        mov_imm32(arg_reg(3), delay_slot ? 1 : 0);
+        call(targets_.interpret);
+        reload();
+        test(X64Reg::RAX, X64Reg::RAX, false);
+        size_t resume = jcc(X64Cond::E);
+        emit_early_exit(index);
+        bind(resume);
+    }
+
+    // Exit to a fixed address through a link slot
+    void emit_exit(int link_index, uint32_t target) {
+        EEBlockLink& link = block_->links[link_index];
+        link.target_pc = target;
+        flush();
+        mov_imm32(X64Reg::RAX, target);
+        store(REGS, reg_offset(offsetof(EERegisters, pc)), X64Reg::RAX, 8);
+        mov_imm32(X64Reg::RAX, target + 4);
+        store(REGS, reg_offset(offsetof(EERegisters, npc)), X64Reg::RAX, 8);
+        mov_imm64(X64Reg::RAX, reinterpret_cast<uint64_t>(&link));
+        store(CONTEXT, context_offset(offsetof(EEJitContext, last_exit)), X64Reg::RAX, 8);
+        jmp(X64Reg::RAX, 0);
+    }
+
+    // Exit to the address saved in branch_target, chaining through the
+    // jump cache when it holds the target
+    void emit_dynamic_exit() {
+        flush();
+        load(X64Reg::RAX, CONTEXT, context_offset(offsetof(EEJitContext, branch_target)), 4);
+        store(REGS, reg_offset(offsetof(EERegisters, pc)), X64Reg::RAX, 8);
+        lea(X64Reg::RCX, X64Reg::RAX, 4);
+        store(REGS, reg_offset(offsetof(EERegisters, npc)), X64Reg::RCX, 8);
+        store_simm32(CONTEXT, context_offset(offsetof(EEJitContext, last_exit)), 0);
+
+        mov32(X64Reg::RDX, X64Reg::RAX);
+        shr_imm(X64Reg::RDX, 2, false);
+        and_imm32(X64Reg::RDX, static_cast<int32_t>(targets_.jump_cache_mask), false);
+        shl_imm(X64Reg::RDX, 4, false);
+        mov_imm64(X64Reg::RCX, reinterpret_cast<uint64_t>(targets_.jump_cache));
+        add(X64Reg::RCX, X64Reg::RDX);
+        load(X64Reg::RDX, X64Reg::RCX, static_cast<int32_t>(offsetof(EEJumpCacheEntry, pc)), 8);
+        cmp(X64Reg::RDX, X64Reg::RAX);
+        leave_.push_back(jcc(X64Cond::NE));
+        jmp(X64Reg::RCX, static_cast<int32_t>(offsetof(EEJumpCacheEntry, code)));
+    }
+
+    void emit_branch(uint32_t index) {
+        const EEInstruction& instr = block_->instructions[index];
+        uint32_t slot_pc = pc_of(index + 1);
+        uint32_t target = slot_pc + (static_cast<uint32_t>(simm16(instr)) << 2);
+        bool conditional = true;
+        bool dynamic = false;
+
+        // Condition into RDX (0/1), evaluated before the delay slot
+        switch (instr.op) {
+            case EEOp::BEQ: case EEOp::BNE: case EEOp::BEQL: case EEOp::BNEL:
+                get(X64Reg::RAX, instr.rs);
+                get(X64Reg::RCX, instr.rt);
+                xor_(X64Reg::RDX, X64Reg::RDX, false);
+                cmp(X64Reg::RAX, X64Reg::RCX);
+                setcc(instr.op == EEOp::BEQ || instr.op == EEOp::BEQL ? X64Cond::E : X64Cond::NE, X64Reg::RDX);
+                break;
+            case EEOp::BLEZ: case EEOp::BGTZ: case EEOp::BLEZL: case EEOp::BGTZL:
+            case EEOp::BLTZ: case EEOp::BGEZ: case EEOp::BLTZL: case EEOp::BGEZL:
+            case EEOp::BLTZAL: case EEOp::BGEZAL: case EEOp::BLTZALL: case EEOp::BGEZALL: {
+                X64Cond cond;
+                switch (instr.op) {
+                    case EEOp::BLEZ: case EEOp::BLEZL: cond = X64Cond::LE; break;
+                    case EEOp::BGTZ: case EEOp::BGTZL: cond = X64Cond::G; break;
+                    case EEOp::BLTZ: case EEOp::BLTZL: case EEOp::BLTZAL: case EEOp::BLTZALL: cond = X64Cond::L; break;
+                    default: cond = X64Cond::GE; break;
+                }
+                get(X64Reg::RAX, instr.rs);
+                xor_(X64Reg::RDX, X64Reg::RDX, false);
+                test(X64Reg::RAX, X64Reg::RAX);
+                setcc(cond, X64Reg::RDX);
+                break;
+            }
+            case EEOp::J:
+            case EEOp::JAL:
+                target = (slot_pc & 0xF0000000) | (instr.target << 2);
+                conditional = false;
+                break;
+            default:  // JR, JALR: the target is read before the link is written
+                get(X64Reg::RAX, instr.rs);
+                store(CONTEXT, context_offset(offsetof(EEJitContext, branch_target)), X64Reg::RAX, 8);
+                conditional = false;
+                dynamic = true;
+                break;
+        }
+
+        // Links are written whether or not the branch is taken
+        int link = native_dest(instr);
+        if (link) {
+            set_imm(link, sext32(pc_of(index) + 8));
+        }
+
+        bool likely = is_likely(instr.op);
+        size_t not_taken = 0;
+        if (likely) {
+            // A likely branch that is not taken skips its delay slot
+            test(X64Reg::RDX, X64Reg::RDX, false);
+            not_taken = jcc(X64Cond::E);
+        } else if (conditional) {
+            store(CONTEXT, context_offset(offsetof(EEJitContext, branch_condition)), X64Reg::RDX, 8);
+        }
+
+        emit_instruction(index + 1, true);
+
+        if (dynamic) {
+            emit_dynamic_exit();
+            return;
+        }
+        if (!conditional) {
+            emit_exit(0, target);
+            return;
+        }
+        if (!likely) {
+            cmp_mem_imm8(CONTEXT, context_offset(offsetof(EEJitContext, branch_condition)), 0);
+            not_taken = jcc(X64Cond::E);
+        }
+        emit_exit(0, target);
+        bind(not_taken);
+        if (likely) {
+            add_mem_imm32(CONTEXT, context_offset(offsetof(EEJitContext, budget)), 1);
+        }
+        emit_exit(1, slot_pc + 4);
+    }
+
+    void emit_memory(uint32_t index, bool delay_slot) {
+        const EEInstruction& instr = block_->instructions[index];
+        int size = access_size(instr.op);
+        bool store_op = is_store(instr.op);
+        bool sign = instr.op == EEOp::LB || instr.op == EEOp::LH || instr.op == EEOp::LW;
+        std::vector<size_t> slow;
+
+        // Address (32-bit) in ECX; LQ/SQ ignore the low four bits
+        get(X64Reg::RCX, instr.rs);
+        if (simm16(instr)) {
+            add_imm32(X64Reg::RCX, simm16(instr), false);
+        } else {
+            mov32(X64Reg::RCX, X64Reg::RCX);
+        }
+        if (size == 16) {
+            and_imm32(X64Reg::RCX, -16, false);
+        } else if (size > 1) {
+            test_imm32(X64Reg::RCX, static_cast<uint32_t>(size - 1), false);
+            slow.push_back(jcc(X64Cond::NE));
+        }
+
+        // Page table lookup; MMIO takes the slow path
+        mov32(X64Reg::RAX, X64Reg::RCX);
+        shr_imm(X64Reg::RAX, EEMemoryMap::PAGE_SHIFT, false);
+        mov_imm64(X64Reg::RDX, reinterpret_cast<uint64_t>(targets_.page_table));
+        load(X64Reg::RAX, X64Reg::RDX, X64Reg::RAX, 8, 0, 8);
+        test(X64Reg::RAX, X64Reg::RAX);
+        slow.push_back(jcc(X64Cond::E));
+        and_imm32(X64Reg::RCX, static_cast<int32_t>(EEMemoryMap::PAGE_MASK), false);
+        add(X64Reg::RAX, X64Reg::RCX);
+
+        if (store_op) {
+            // Stores into pages holding code go through the interpreter,
+            // which drops the stale code
+            mov(X64Reg::RDX, X64Reg::RAX);
+            mov_imm64(X64Reg::RCX, reinterpret_cast<uint64_t>(targets_.memory_base));
+            sub(X64Reg::RDX, X64Reg::RCX);
+            shr_imm(X64Reg::RDX, EEMemoryMap::PAGE_SHIFT);
+            mov_imm64(X64Reg::RCX, reinterpret_cast<uint64_t>(targets_.code_page_flags));
+            load(X64Reg::RCX, X64Reg::RCX, X64Reg::RDX, 1, 0, 1);
+            test(X64Reg::RCX, X64Reg::RCX, false);
+            slow.push_back(jcc(X64Cond::NE));
+            if (size == 16) {
+                if (host_[instr.rt] != NO_REG) {
+                    store(REGS, gpr_offset(instr.rt), host_[instr.rt], 8);
+                }
+                vmovups_load(0, REGS, gpr_offset(instr.rt), VecWidth::XMM);
+                vmovups_store(X64Reg::RAX, 0, 0, VecWidth::XMM);
+            } else {
+                get(X64Reg::RDX, instr.rt);
+                store(X64Reg::RAX, 0, X64Reg::RDX, size);
+            }
+        } else if (instr.rt != 0) {
+            if (size == 16) {
+                vmovups_load(0, X64Reg::RAX, 0, VecWidth::XMM);
+                vmovups_store(REGS, gpr_offset(instr.rt), 0, VecWidth::XMM);
+                if (host_[instr.rt] != NO_REG) {
+                    mov(host_[instr.rt], REGS, gpr_offset(instr.rt));
+                }
+            } else {
+                load(X64Reg::RDX, X64Reg::RAX, 0, size, sign);
+                set(instr.rt, X64Reg::RDX);
+            }
+        }
+        size_t done = jmp();
+
+        for (size_t label : slow) {
+            bind(label);
+        }
+        emit_interpret(index, delay_slot);
+        bind(done);
+    }
+
+    void emit_multiply(const EEInstruction& instr) {
+        bool pipeline1 = instr.op == EEOp::MULT1 || instr.op == EEOp::MULTU1;
+        get(X64Reg::RAX, instr.rs);
+        get(X64Reg::RCX, instr.rt);
+        if (instr.op == EEOp::MULT || instr.op == EEOp::MULT1) {
+            movsxd(X64Reg::RAX, X64Reg::RAX);
+            movsxd(X64Reg::RCX, X64Reg::RCX);
+        } else {
+            mov32(X64Reg::RAX, X64Reg::RAX);
+            mov32(X64Reg::RCX, X64Reg::RCX);
+        }
+        imul(X64Reg::RAX, X64Reg::RCX);
+
+        // LO and rd get the sign-extended low word, HI the high word
+        movsxd(X64Reg::RDX, X64Reg::RAX);
+        store(REGS, reg_offset(pipeline1 ? offsetof(EERegisters, lo1) : offsetof(EERegisters, lo)), X64Reg::RDX, 8);
+        set(instr.rd, X64Reg::RDX);
+        sar_imm(X64Reg::RAX, 32);
+        store(REGS, reg_offset(pipeline1 ? offsetof(EERegisters, hi1) : offsetof(EERegisters, hi)), X64Reg::RAX, 8);
+    }
+
+    // Parallel ops read and write the full 128-bit registers in
+    // EERegisters: host copies of the sources are written back first and
+    // rd's is reloaded after. Sources in XMM0/XMM1, result in XMM0.
+    void emit_parallel(const EEInstruction& instr) {
+        for (int reg : { static_cast<int>(instr.rs), static_cast<int>(instr.rt) }) {
+            if (dirty_[reg]) {
+                store(REGS, gpr_offset(reg), host_[reg], 8);
+            }
+        }
+        vmovdqu_load(0, REGS, gpr_offset(instr.rs));
+        vmovdqu_load(1, REGS, gpr_offset(instr.rt));
+        uint8_t sa = instr.shamt;
+
+        switch (instr.op) {
+            case EEOp::PADDW:  vpaddd(0, 0, 1); break;
+            case EEOp::PADDH:  vpaddw(0, 0, 1); break;
+            case EEOp::PADDB:  vpaddb(0, 0, 1); break;
+            case EEOp::PSUBW:  vpsubd(0, 0, 1); break;
+            case EEOp::PSUBH:  vpsubw(0, 0, 1); break;
+            case EEOp::PSUBB:  vpsubb(0, 0, 1); break;
+            case EEOp::PADDSH: vpaddsw(0, 0, 1); break;
+            case EEOp::PADDSB: vpaddsb(0, 0, 1); break;
+            case EEOp::PSUBSH: vpsubsw(0, 0, 1); break;
+            case EEOp::PSUBSB: vpsubsb(0, 0, 1); break;
+            case EEOp::PADDUH: vpaddusw(0, 0, 1); break;
+            case EEOp::PADDUB: vpaddusb(0, 0, 1); break;
+            case EEOp::PSUBUH: vpsubusw(0, 0, 1); break;
+            case EEOp::PSUBUB: vpsubusb(0, 0, 1); break;
+            case EEOp::PADSBH:
+                vpsubw(2, 0, 1);
+                vpaddw(0, 0, 1);
+                vpblendw(0, 2, 0, 0xF0);
+                break;
+            case EEOp::PABSW:
+                // The most negative value saturates
+                vpabsd(0, 1);
+                vpsrad(1, 0, 31);
+                vpaddd(0, 0, 1);
+                break;
+            case EEOp::PABSH:
+                vpabsw(0, 1);
+                vpsraw(1, 0, 15);
+                vpaddw(0, 0, 1);
+                break;
+            case EEOp::PCGTW:  vpcmpgtd(0, 0, 1); break;
+            case EEOp::PCGTH:  vpcmpgtw(0, 0, 1); break;
+            case EEOp::PCGTB:  vpcmpgtb(0, 0, 1); break;
+            case EEOp::PCEQW:  vpcmpeqd(0, 0, 1); break;
+            case EEOp::PCEQH:  vpcmpeqw(0, 0, 1); break;
+            case EEOp::PCEQB:  vpcmpeqb(0, 0, 1); break;
+            case EEOp::PMAXW:  vpmaxsd(0, 0, 1); break;
+            case EEOp::PMAXH:  vpmaxsw(0, 0, 1); break;
+            case EEOp::PMINW:  vpminsd(0, 0, 1); break;
+            case EEOp::PMINH:  vpminsw(0, 0, 1); break;
+            case EEOp::PAND:   vpand(0, 0, 1); break;
+            case EEOp::POR:    vpor(0, 0, 1); break;
+            case EEOp::PXOR:   vpxor(0, 0, 1); break;
+            case EEOp::PNOR:
+                vpor(0, 0, 1);
+                vpcmpeqd(1, 1, 1);
+                vpxor(0, 0, 1);
+                break;
+            case EEOp::PSLLH:  vpsllw(0, 1, sa & 15); break;
+            case EEOp::PSRLH:  vpsrlw(0, 1, sa & 15); break;
+            case EEOp::PSRAH:  vpsraw(0, 1, sa & 15); break;
+            case EEOp::PSLLW:  vpslld(0, 1, sa); break;
+            case EEOp::PSRLW:  vpsrld(0, 1, sa); break;
+            case EEOp::PSRAW:  vpsrad(0, 1, sa); break;
+            case EEOp::PEXTLW: vpunpckldq(0, 1, 0); break;
+            case EEOp::PEXTLH: vpunpcklwd(0, 1, 0); break;
+            case EEOp::PEXTLB: vpunpcklbw(0, 1, 0); break;
+            case EEOp::PEXTUW: vpunpckhdq(0, 1, 0); break;
+            case EEOp::PEXTUH: vpunpckhwd(0, 1, 0); break;
+            case EEOp::PEXTUB: vpunpckhbw(0, 1, 0); break;
+            case EEOp::PPACW:  vshufps(0, 1, 0, 0x88, VecWidth::XMM); break;
+            case EEOp::PPACH:
+                // Sign-extended low halves pack without saturating
+                vpslld(1, 1, 16);
+                vpsrad(1, 1, 16);
+                vpslld(0, 0, 16);
+                vpsrad(0, 0, 16);
+                vpackssdw(0, 1, 0);
+                break;
+            case EEOp::PPACB:
+                vpsllw(1, 1, 8);
+                vpsraw(1, 1, 8);
+                vpsllw(0, 0, 8);
+                vpsraw(0, 0, 8);
+                vpacksswb(0, 1, 0);
+                break;
+            case EEOp::PCPYLD: vpunpcklqdq(0, 1, 0); break;
+            case EEOp::PCPYUD: vpunpckhqdq(0, 0, 1); break;
+            case EEOp::PCPYH:
+                vpshuflw(0, 1, 0x00);
+                vpshufhw(0, 0, 0x00);
+                break;
+            case EEOp::PINTH:
+                vpunpckhqdq(0, 0, 0);
+                vpunpcklwd(0, 1, 0);
+                break;
+            case EEOp::PINTEH:
+                vpslld(0, 0, 16);
+                vpblendw(0, 1, 0, 0xAA);
+                break;
+            case EEOp::PEXEH:
+                vpshuflw(0, 1, 0xC6);
+                vpshufhw(0, 0, 0xC6);
+                break;
+            case EEOp::PREVH:
+                vpshuflw(0, 1, 0x1B);
+                vpshufhw(0, 0, 0x1B);
+                break;
+            case EEOp::PEXCH:
+                vpshuflw(0, 1, 0xD8);
+                vpshufhw(0, 0, 0xD8);
+                break;
+            case EEOp::PEXEW:  vpshufd(0, 1, 0xC6); break;
+            case EEOp::PEXCW:  vpshufd(0, 1, 0xD8); break;
+            case EEOp::PROT3W: vpshufd(0, 1, 0xC9); break;
+            default:
+                break;
+        }
+
+        if (instr.rd != 0) {
+            vmovdqu_store(REGS, gpr_offset(instr.rd), 0);
+            if (host_[instr.rd] != NO_REG) {
+                mov(host_[instr.rd], REGS, gpr_offset(instr.rd));
+            }
+        }
+    }
+
+    void emit_instruction(uint32_t index, bool delay_slot) {
+        const EEInstruction& instr = block_->instructions[index];
+        if (!is_native(instr, targets_.vector_ops)) {
+            emit_interpret(index, delay_slot);
+            return;
+        }
+        if (access_size(instr.op)) {
+            emit_memory(index, delay_slot);
+            return;
+        }
+        if (instr.type == EEInstructionType::PARALLEL) {
+            emit_parallel(instr);
+            return;
+        }
+
+        X64Reg rax = X64Reg::RAX;
+        X64Reg rcx = X64Reg::RCX;
+        X64Reg rdx = X64Reg::RDX;
+        int32_t imm = simm16(instr);
+
+        switch (instr.op) {
+            // 32-bit results are sign-extended
+            case EEOp::ADDU:
+            case EEOp::SUBU:
+                get(rax, instr.rs);
+                get(rcx, instr.rt);
+                if (instr.op == EEOp::ADDU) {
+                    add(rax, rcx, false);
+                } else {
+                    sub(rax, rcx, false);
+                }
+                movsxd(rax, rax);
+                set(instr.rd, rax);
+                break;
+            case EEOp::ADDIU:
+                get(rax, instr.rs);
+                add_imm32(rax, imm, false);
+                movsxd(rax, rax);
+                set(instr.rt, rax);
+                break;
+            case EEOp::DADDU:
+            case EEOp::DSUBU:
+                get(rax, instr.rs);
+                get(rcx, instr.rt);
+                if (instr.op == EEOp::DADDU) {
+                    add(rax, rcx);
+                } else {
+                    sub(rax, rcx);
+                }
+                set(instr.rd, rax);
+                break;
+            case EEOp::DADDIU:
+                get(rax, instr.rs);
+                add_imm32(rax, imm);
+                set(instr.rt, rax);
+                break;
+            case EEOp::SLT:
+            case EEOp::SLTU:
+                get(rax, instr.rs);
+                get(rcx, instr.rt);
+                xor_(rdx, rdx, false);
+                cmp(rax, rcx);
+                setcc(instr.op == EEOp::SLT ? X64Cond::L : X64Cond::B, rdx);
+                set(instr.rd, rdx);
+                break;
+            case EEOp::SLTI:
+            case EEOp::SLTIU:
+                get(rax, instr.rs);
+                xor_(rdx, rdx, false);
+                cmp_imm32(rax, imm);
+                setcc(instr.op == EEOp::SLTI ? X64Cond::L : X64Cond::B, rdx);
+                set(instr.rt, rdx);
+                break;
+            case EEOp::LUI:
+                set_imm(instr.rt, sext32(static_cast<uint32_t>(instr.immediate) << 16));
+                break;
+            case EEOp::MOVZ:
+            case EEOp::MOVN:
+                get(rax, instr.rd);
+                get(rcx, instr.rs);
+                get(rdx, instr.rt);
+                test(rdx, rdx);
+                cmovcc(instr.op == EEOp::MOVZ ? X64Cond::E : X64Cond::NE, rax, rcx);
+                set(instr.rd, rax);
+                break;
+
+            case EEOp::AND:
+            case EEOp::OR:
+            case EEOp::XOR:
+            case EEOp::NOR:
+                get(rax, instr.rs);
+                get(rcx, instr.rt);
+                if (instr.op == EEOp::AND) {
+                    and_(rax, rcx);
+                } else if (instr.op == EEOp::XOR) {
+                    xor_(rax, rcx);
+                } else {
+                    or_(rax, rcx);
+                }
+                if (instr.op == EEOp::NOR) {
+                    not_(rax);
+                }
+                set(instr.rd, rax);
+                break;
+            case EEOp::ANDI:
+            case EEOp::ORI:
+            case EEOp::XORI:
+                // Zero-extended immediates
+                get(rax, instr.rs);
+                if (instr.op == EEOp::ANDI) {
+                    and_imm32(rax, instr.immediate);
+                } else if (instr.op == EEOp::ORI) {
+                    or_imm32(rax, instr.immediate);
+                } else {
+                    xor_imm32(rax, instr.immediate);
+                }
+                set(instr.rt, rax);
+                break;
+
+            case EEOp::SLL:
+            case EEOp::SRL:
+            case EEOp::SRA:
+                get(rax, instr.rt);
+                if (instr.op == EEOp::SLL) {
+                    shl_imm(rax, instr.shamt, false);
+                } else if (instr.op == EEOp::SRL) {
+                    shr_imm(rax, instr.shamt, false);
+                } else {
+                    sar_imm(rax, instr.shamt, false);
+                }
+                movsxd(rax, rax);
+                set(instr.rd, rax);
+                break;
+            case EEOp::SLLV:
+            case EEOp::SRLV:
+            case EEOp::SRAV:
+                // x86 masks CL to five bits for 32-bit shifts, like the EE
+                get(rax, instr.rt);
+                get(rcx, instr.rs);
+                if (instr.op == EEOp::SLLV) {
+                    shl_cl(rax, false);
+                } else if (instr.op == EEOp::SRLV) {
+                    shr_cl(rax, false);
+                } else {
+                    sar_cl(rax, false);
+                }
+                movsxd(rax, rax);
+                set(instr.rd, rax);
+                break;
+            case EEOp::DSLL: case EEOp::DSLL32:
+            case EEOp::DSRL: case EEOp::DSRL32:
+            case EEOp::DSRA: case EEOp::DSRA32: {
+                uint8_t sa = static_cast<uint8_t>(instr.shamt + (instr.op == EEOp::DSLL32 || instr.op == EEOp::DSRL32 ||
+                                                                 instr.op == EEOp::DSRA32 ? 32 : 0));
+                get(rax, instr.rt);
+                if (instr.op == EEOp::DSLL || instr.op == EEOp::DSLL32) {
+                    shl_imm(rax, sa);
+                } else if (instr.op == EEOp::DSRL || instr.op == EEOp::DSRL32) {
+                    shr_imm(rax, sa);
+                } else {
+                    sar_imm(rax, sa);
+                }
+                set(instr.rd, rax);
+                break;
+            }
+            case EEOp::DSLLV:
+            case EEOp::DSRLV:
+            case EEOp::DSRAV:
+                get(rax, instr.rt);
+                get(rcx, instr.rs);
+                if (instr.op == EEOp::DSLLV) {
+                    shl_cl(rax);
+                } else if (instr.op == EEOp::DSRLV) {
+                    shr_cl(rax);
+                } else {
+                    sar_cl(rax);
+                }
+                set(instr.rd, rax);
+                break;
+
+            case EEOp::MFHI: case EEOp::MFLO: case EEOp::MFHI1: case EEOp::MFLO1:
+            case EEOp::MTHI: case EEOp::MTLO: case EEOp::MTHI1: case EEOp::MTLO1: {
+                size_t offset;
+                switch (instr.op) {
+                    case EEOp::MFHI: case EEOp::MTHI: offset = offsetof(EERegisters, hi); break;
+                    case EEOp::MFLO: case EEOp::MTLO: offset = offsetof(EERegisters, lo); break;
+                    case EEOp::MFHI1: case EEOp::MTHI1: offset = offsetof(EERegisters, hi1); break;
+                    default: offset = offsetof(EERegisters, lo1); break;
+                }
+                bool move_from = instr.op == EEOp::MFHI || instr.op == EEOp::MFLO ||
+                                 instr.op == EEOp::MFHI1 || instr.op == EEOp::MFLO1;
+                if (move_from) {
+                    mov(rax, REGS, reg_offset(offset));
+                    set(instr.rd, rax);
+                } else {
+                    get(rax, instr.rs);
+                    store(REGS, reg_offset(offset), rax, 8);
+                }
+                break;
+            }
+            case EEOp::MULT: case EEOp::MULTU: case EEOp::MULT1: case EEOp::MULTU1:
+                emit_multiply(instr);
+                break;
+
+            default:  // SYNC, CACHE, PREF
+                break;
+        }
+    }
+
+    EEBlock* block_;
+    BlockTargets targets_;
+    X64Reg host_[32];
+    bool dirty_[32];
+    std::vector<size_t> leave_;     // Jumps to the exit stub
+};
+
+} // namespace
+
+EERecompiler::EERecompiler(EmotionEngine* ee)
+    : ee_(ee)
+    , context_()
+    , enter_(nullptr)
+    , exit_stub_(nullptr)
+    , vector_ops_(GSCX::Core::get_host_cpu_features().avx)
+    , jump_cache_(JUMP_CACHE_SIZE)
+    , pending_link_(nullptr)
+    , code_invalidated_(false) {
+    context_.registers = &ee->registers_;
+    page_blocks_.resize(ee->code_pages_.size());
+    clear();
+}
+
+EERecompiler::~EERecompiler() = default;
+
+bool EERecompiler::initialize() {
+    // Entry: save the callee-saved registers, set up R14/R15 and jump to
+    // the block. Blocks leave through the exit stub, which unwinds this.
+    X64Emitter e;
+    for (X64Reg reg : SAVED) {
+        e.push(reg);
+    }
+    e.sub_imm32(X64Reg::RSP, FRAME_SIZE);
+    e.mov(CONTEXT, X64Emitter::arg_reg(0));
+    e.mov(REGS, CONTEXT, context_offset(offsetof(EEJitContext, registers)));
+    e.jmp(X64Emitter::arg_reg(1));
+
+    size_t exit_offset = e.size();
+    e.add_imm32(X64Reg::RSP, FRAME_SIZE);
+    for (size_t i = sizeof(SAVED) / sizeof(SAVED[0]); i-- > 0;) {
+        e.pop(SAVED[i]);
+    }
+    e.ret();
+
+    if (!stubs_.assign(e.get_code()) || !arena_.reserve(ARENA_SIZE)) {
+        ee_->log_error("Failed to allocate executable memory for the EE recompiler");
+        return false;
+    }
+    enter_ = stubs_.as<EnterFn>();
+    exit_stub_ = static_cast<const uint8_t*>(stubs_.entry()) + exit_offset;
+    return true;
+}
+
+uint32_t EERecompiler::interpret(EERecompiler* self, const EEInstruction* instr, uint32_t pc, uint32_t delay_slot) {
+    EmotionEngine* ee = self->ee_;
+    ee->current_pc_ = pc;
+    ee->in_delay_slot_ = delay_slot != 0;
+    ee->registers_.pc = pc + 4;
+    ee->registers_.npc = pc + 8;
+    ee->pending_exception_ = EEException::NONE;
+    self->code_invalidated_ = false;
+
+    ee->executing_ = true;
+    ee->execute_instruction(*instr);
+    ee->executing_ = false;
+
+    ee->registers_.gpr[0][0] = 0;
+    ee->registers_.gpr[0][1] = 0;
+
+    // stop() from a callback: end at the next block boundary
+    if (!ee->running_ && self->context_.budget > 0) {
+        self->context_.parked += self->context_.budget;
+        self->context_.budget = 0;
+    }
+    if (ee->pending_exception_ != EEException::NONE) {
+        return 1;
+    }
+    // The instruction may have rewritten the running block; pc and npc
+    // already point past it. A delay slot finishes the block instead.
+    return self->code_invalidated_ && !delay_slot;
+}
+
+uint64_t EERecompiler::execute(uint64_t max_instructions) {
+    EmotionEngine* ee = ee_;
+    uint64_t executed = 0;
+
+    while (ee->running_ && executed < max_instructions) {
+        uint32_t pc = static_cast<uint32_t>(ee->registers_.pc);
+        EEBlock* block = nullptr;
+        // A branch run by the interpreter leaves its delay slot pending
+        if (!ee->branch_pending_) {
+            auto it = block_map_.find(pc);
+            block = it != block_map_.end() ? it->second : compile(pc);
+        }
+        if (!block) {
+            pending_link_ = nullptr;
+            ee->step();
+            executed++;
+            continue;
+        }
+
+        if (pending_link_ && pending_link_->target_pc == pc) {
+            link(pending_link_, block);
+        }
+        pending_link_ = nullptr;
+        EEJumpCacheEntry& cached = jump_cache_[(pc >> 2) & (JUMP_CACHE_SIZE - 1)];
+        cached.pc = pc;
+        cached.code = block->entry;
+
+        int64_t budget = static_cast<int64_t>(
+            std::min<uint64_t>(max_instructions - executed, std::numeric_limits<int64_t>::max()));
+        context_.budget = budget;
+        context_.parked = 0;
+        context_.last_exit = nullptr;
+        enter_(&context_, block->entry);
+
+        uint64_t ran = static_cast<uint64_t>(budget - (context_.budget + context_.parked));
+        executed += ran;
+        ee->cycle_count_ += ran;
+        ee->instruction_count_ += ran;
+
+        // Link the exit taken once its target has been looked up
+        EEBlockLink* exit = context_.last_exit;
+        if (exit && exit->owner->valid && exit->code == exit_stub_) {
+            pending_link_ = exit;
+        }
+    }
+    return executed;
+}
+
+EEBlock* EERecompiler::compile(uint32_t pc) {
+    if (pc & 3) {
+        return nullptr;
+    }
+    EEDecodedPage* page = ee_->get_decoded_page(pc);
+    if (!page) {
+        return nullptr;
+    }
+
+    auto block = std::make_unique<EEBlock>();
+    block->pc = pc;
+    block->code_page = ee_->get_code_page_index(ee_->get_memory_pointer(pc));
+    block->valid = true;
+
+    uint32_t first = (pc & EEMemoryMap::PAGE_MASK) >> 2;
+    for (uint32_t i = first; i < EEDecodedPage::INSTRUCTIONS && block->instructions.size() < MAX_BLOCK_INSTRUCTIONS; i++) {
+        const EEInstruction& instr = page->instructions[i];
+        if (ends_block(instr)) {
+            break;
+        }
+        if (is_branch(instr)) {
+            // The delay slot has to be on the same page and plain
+            if (i + 1 < EEDecodedPage::INSTRUCTIONS) {
+                const EEInstruction& slot = page->instructions[i + 1];
+                if (!is_branch(slot) && !ends_block(slot)) {
+                    block->instructions.push_back(instr);
+                    block->instructions.push_back(slot);
+                }
+            }
+            break;
+        }
+        block->instructions.push_back(instr);
+    }
+    if (block->instructions.empty()) {
+        return nullptr;
+    }
+    block->instruction_count = static_cast<uint32_t>(block->instructions.size());
+    for (EEBlockLink& link : block->links) {
+        link.code = exit_stub_;
+        link.target_pc = 0;
+        link.owner = block.get();
+    }
+
+    std::vector<uint8_t> code = emit_block(block.get());
+    block->entry = arena_.append(code);
+    if (!block->entry) {
+        // Arena full: start over. Generated code holds no pointers into
+        // the arena, so the new block can go in as emitted.
+        log_arena_reset();
+        clear();
+        block->entry = arena_.append(code);
+        if (!block->entry) {
+            return nullptr;
+        }
+    }
+
+    EEBlock* result = block.get();
+    block_map_[pc] = result;
+    page_blocks_[result->code_page].push_back(result);
+    blocks_.push_back(std::move(block));
+    return result;
+}
+
+std::vector<uint8_t> EERecompiler::emit_block(EEBlock* block) {
+    BlockTargets targets;
+    targets.recompiler = this;
+    targets.interpret = reinterpret_cast<const void*>(&EERecompiler::interpret);
+    targets.exit_stub = exit_stub_;
+    targets.page_table = ee_->get_page_table();
+    targets.memory_base = ee_->memory_.data();
+    targets.code_page_flags = ee_->code_page_flags_.data();
+    targets.jump_cache = jump_cache_.data();
+    targets.jump_cache_mask = JUMP_CACHE_SIZE - 1;
+    targets.vector_ops = vector_ops_;
+
+    BlockCompiler compiler(block, targets);
+    compiler.compile();
+    return compiler.get_code();
+}
+
+void EERecompiler::link(EEBlockLink* exit, EEBlock* target) {
+    if (!exit->owner->valid || !target->valid || exit->code != exit_stub_) {
+        return;
+    }
+    exit->code = target->entry;
+    target->incoming.push_back(exit);
+}
+
+void EERecompiler::unlink(EEBlock* block) {
+    for (EEBlockLink* link : block->incoming) {
+        if (link->code == block->entry) {
+            link->code = exit_stub_;
+        }
+    }
+    block->incoming.clear();
+}
+
+void EERecompiler::invalidate_page(size_t code_page) {
+    if (code_page >= page_blocks_.size()) {
+        return;
+    }
+    for (EEBlock* block : page_blocks_[code_page]) {
+        if (!block->valid) {
+            continue;
+        }
+        block->valid = false;
+        code_invalidated_ = true;
+        auto it = block_map_.find(block->pc);
+        if (it != block_map_.end() && it->second == block) {
+            block_map_.erase(it);
+        }
+        EEJumpCacheEntry& cached = jump_cache_[(block->pc >> 2) & (JUMP_CACHE_SIZE - 1)];
+        if (cached.code == block->entry) {
+            cached.pc = 1;
+            cached.code = nullptr;
+        }
+        unlink(block);
+    }
+    page_blocks_[code_page].clear();
+}
+
+void EERecompiler::clear() {
+    block_map_.clear();
+    for (auto& list : page_blocks_) {
+        list.clear();
+    }
+    blocks_.clear();
+    pending_link_ = nullptr;
+    // pc 1 never matches: block addresses are word-aligned
+    std::fill(jump_cache_.begin(), jump_cache_.end(), EEJumpCacheEntry{ 1, nullptr });
+    arena_.reset();
+}
+
+void EERecompiler::log_arena_reset() {
+    std::stringstream ss;
+    ss << "EE recompiler: code arena full (" << blocks_.size() << " blocks), flushing";
+    ee_->log_info(ss.str());
+}
+
+} // namespace recovery
+} // namespace gscx
@@ -0,0 +1,130 @@
+#pragma once
+#include "ee_engine.h"
+#include "exec_memory.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gscx {
+namespace recovery {
+
+struct EEBlock;
+
+// A block exit to a fixed guest address. Generated code leaves through
+// `jmp [code]`, which starts out at the exit stub; the dispatcher points
+// it at the target block once that is compiled (block linking).
+struct EEBlockLink {
+    const void* code;               // Must stay first: jumped through directly
+    uint32_t target_pc;
+    EEBlock* owner;
+};
+
+// One compiled run of guest code: straight-line instructions up to and
+// including a branch and its delay slot, all within one 4KB page
+struct EEBlock {
+    uint32_t pc;
+    uint32_t instruction_count;
+    size_t code_page;               // EmotionEngine code page the block was decoded from
+    const void* entry;
+    bool valid;
+    std::vector<EEInstruction> instructions;    // Interpreter fallbacks point into this
+    EEBlockLink links[2];           // Taken branch / fall-through
+    std::vector<EEBlockLink*> incoming;
+};
+
+// Direct-mapped pc -> code cache used by indirect jumps (JR/JALR) to
+// chain without returning to the dispatcher
+struct EEJumpCacheEntry {
+    uint64_t pc;
+    const void* code;
+};
+
+// State shared with generated code, which keeps its address in R14
+struct EEJitContext {
+    EERegisters* registers;         // Kept in R15
+    int64_t budget;                 // Instructions left; blocks subtract their length on entry
+    int64_t parked;                 // Budget withdrawn to stop at the next block boundary
+    EEBlockLink* last_exit;         // Link the last block left through, null for dynamic exits
+    uint64_t branch_condition;      // Saved across the delay slot
+    uint64_t branch_target;
+};
+
+/**
+ * EE Recompiler
+ *
+ * Translates R5900 code to x86-64 one block at a time. Blocks are found
+ * by walking the predecoded page from the entry pc and end after a
+ * branch's delay slot, at the page end or before an instruction that
+ * leaves the block's control flow to the interpreter (ERET, COP0/COP1
+ * branches, a branch whose delay slot is on the next page).
+ *
+ * The most used GPRs of a block live in host registers (their low 64
+ * bits), loaded on entry and written back at every exit and around calls.
+ * Integer ALU, shift, multiply, HI/LO, branch and aligned load/store
+ * instructions are emitted inline, LQ/SQ and the common parallel (MMI)
+ * instructions through XMM registers on the in-memory copies; the rest
+ * call back into the interpreter, which also handles MMIO, misaligned
+ * accesses and stores into pages holding code. An exception raised in a
+ * block leaves it with the EE already at the handler; a store that drops
+ * compiled code leaves it at the next instruction, so a block rewriting
+ * itself runs the new code (except from a delay slot).
+ *
+ * execute() may run past `max_instructions` by up to one block.
+ */
+class EERecompiler {
+public:
+    explicit EERecompiler(EmotionEngine* ee);
+    ~EERecompiler();
+
+    EERecompiler(const EERecompiler&) = delete;
+    EERecompiler& operator=(const EERecompiler&) = delete;
+
+    // Reserves the code arena and builds the entry/exit stubs
+    bool initialize();
+
+    uint64_t execute(uint64_t max_instructions);
+
+    // Drops every block decoded from a code page; safe to call from
+    // inside a block (the running block finishes on its old code)
+    void invalidate_page(size_t code_page);
+    void clear();
+
+    size_t get_block_count() const { return block_map_.size(); }
+    size_t get_code_size() const { return arena_.used(); }
+
+private:
+    static constexpr size_t ARENA_SIZE = 32 * 1024 * 1024;
+    static constexpr uint32_t MAX_BLOCK_INSTRUCTIONS = 128;
+    static constexpr uint32_t JUMP_CACHE_SIZE = 4096;
+
+    EEBlock* compile(uint32_t pc);
+    std::vector<uint8_t> emit_block(EEBlock* block);
+    void link(EEBlockLink* exit, EEBlock* target);
+    void unlink(EEBlock* block);
+    void log_arena_reset();
+
+    // Runs one instruction the recompiler does not emit; true if the
+    // block has to be left (an exception was taken or code was dropped)
+    static uint32_t interpret(EERecompiler* self, const EEInstruction* instr, uint32_t pc, uint32_t delay_slot);
+
+    using EnterFn = void (*)(EEJitContext* context, const void* code);
+
+    EmotionEngine* ee_;
+    EEJitContext context_;
+    GSCX::Core::ExecutableBlock stubs_;
+    GSCX::Core::ExecutableArena arena_;
+    EnterFn enter_;
+    const void* exit_stub_;
+    bool vector_ops_;               // LQ/SQ and parallel ops inline (VEX encodings need AVX)
+
+    std::vector<std::unique_ptr<EEBlock>> blocks_;     // Live and invalidated, until the arena resets
+    std::unordered_map<uint32_t, EEBlock*> block_map_;
+    std::vector<std::vector<EEBlock*>> page_blocks_;
+    std::vector<EEJumpCacheEntry> jump_cache_;
+    EEBlockLink* pending_link_;
+    bool code_invalidated_;         // Set when invalidate_page drops a block
+};
+
+} // namespace recovery
+} // namespace gscx
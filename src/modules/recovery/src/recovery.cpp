@@ -136,6 +136,25 @@ extern "C" __declspec(dllexport) void GSCX_EE_ExecuteCycle() {
     }
 }
 
+extern "C" __declspec(dllexport) void GSCX_EE_Start() {
+    if (g_emotion_engine) {
+        g_emotion_engine->start();
+    }
+}
+
+extern "C" __declspec(dllexport) void GSCX_EE_Stop() {
+    if (g_emotion_engine) {
+        g_emotion_engine->stop();
+    }
+}
+
+extern "C" __declspec(dllexport) uint64_t GSCX_EE_Execute(uint64_t max_instructions) {
+    if (g_emotion_engine) {
+        return g_emotion_engine->execute(max_instructions);
+    }
+    return 0;
+}
+
 extern "C" __declspec(dllexport) void GSCX_EE_Reset() {
     if (g_emotion_engine) {
         g_emotion_engine->reset();
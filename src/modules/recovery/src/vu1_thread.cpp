@@ -0,0 +1,111 @@
+#include "vu1_thread.h"
+#include <algorithm>
+
+namespace gscx {
+namespace recovery {
+
+VU1Thread::VU1Thread(VectorUnit* vu)
+    : vu_(vu)
+    , ring_(RING_WORDS)
+    , put_(0)
+    , get_(0) {
+}
+
+VU1Thread::~VU1Thread() {
+    stop();
+}
+
+void VU1Thread::start() {
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&VU1Thread::thread_loop, this);
+    }
+}
+
+void VU1Thread::stop() {
+    if (thread_.joinable()) {
+        push(STOP, nullptr, 0);
+        thread_.join();
+    }
+}
+
+void VU1Thread::write_vif(const uint32_t* data, size_t words) {
+    // The VIF decoder keeps its state across calls, so chunks can split
+    // a command anywhere
+    while (words > 0) {
+        uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(words, MAX_PAYLOAD));
+        push(VIF_DATA, data, chunk);
+        data += chunk;
+        words -= chunk;
+    }
+}
+
+void VU1Thread::start_micro_program(uint32_t address) {
+    push(MICRO_PROGRAM, &address, 1);
+}
+
+void VU1Thread::sync() {
+    uint32_t put = put_.load(std::memory_order_relaxed);
+    for (uint32_t get = get_.load(std::memory_order_acquire); get != put;
+         get = get_.load(std::memory_order_acquire)) {
+        get_.wait(get, std::memory_order_acquire);
+    }
+}
+
+void VU1Thread::push(Command command, const uint32_t* data, uint32_t words) {
+    uint32_t put = put_.load(std::memory_order_relaxed);
+    // Wait for room; the VU1 thread frees entries as they finish
+    for (uint32_t get = get_.load(std::memory_order_acquire); put + 1 + words - get > RING_WORDS;
+         get = get_.load(std::memory_order_acquire)) {
+        get_.wait(get, std::memory_order_acquire);
+    }
+
+    ring_[put & RING_MASK] = (static_cast<uint32_t>(command) << 24) | words;
+    uint32_t start = (put + 1) & RING_MASK;
+    uint32_t first = std::min(words, RING_WORDS - start);
+    std::copy(data, data + first, ring_.begin() + start);
+    std::copy(data + first, data + words, ring_.begin());
+
+    put_.store(put + 1 + words, std::memory_order_release);
+    put_.notify_one();
+}
+
+void VU1Thread::thread_loop() {
+    uint32_t get = get_.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t put = put_.load(std::memory_order_acquire);
+        for (int i = 0; i < SPIN_COUNT && get == put; i++) {
+            std::this_thread::yield();
+            put = put_.load(std::memory_order_acquire);
+        }
+        if (get == put) {
+            put_.wait(put, std::memory_order_acquire);
+            continue;
+        }
+
+        uint32_t header = ring_[get & RING_MASK];
+        uint32_t words = header & 0xFFFFFF;
+        uint32_t start = (get + 1) & RING_MASK;
+        switch (header >> 24) {
+            case VIF_DATA: {
+                uint32_t first = std::min(words, RING_WORDS - start);
+                vu_->write_vif(&ring_[start], first);
+                vu_->write_vif(ring_.data(), words - first);
+                break;
+            }
+            case MICRO_PROGRAM:
+                vu_->execute_micro_program(ring_[start]);
+                break;
+            default:    // STOP
+                get_.store(get + 1, std::memory_order_release);
+                get_.notify_all();
+                return;
+        }
+
+        get += 1 + words;
+        get_.store(get, std::memory_order_release);
+        get_.notify_all();
+    }
+}
+
+} // namespace recovery
+} // namespace gscx
@@ -0,0 +1,68 @@
+#pragma once
+#include "ee_engine.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace gscx {
+namespace recovery {
+
+/**
+ * VU1 Thread
+ *
+ * Runs VU1 on a dedicated host thread. The EE thread is the only
+ * producer: it queues VIF1 data and micro program starts in a lock-free
+ * single-producer/single-consumer ring of words, and the VU1 thread runs
+ * them in order. The EE never waits for VU1 except in sync(), which it
+ * calls before anything that reads or changes VU1 state from its side
+ * (get_vu1(), FBRST), and when the ring is full.
+ *
+ * The XGKICK handler and VU1 log messages run on the VU1 thread.
+ */
+class VU1Thread {
+public:
+    explicit VU1Thread(VectorUnit* vu);
+    ~VU1Thread();
+
+    VU1Thread(const VU1Thread&) = delete;
+    VU1Thread& operator=(const VU1Thread&) = delete;
+
+    void start();
+    // Runs everything queued, then joins the thread
+    void stop();
+
+    void write_vif(const uint32_t* data, size_t words);
+    void start_micro_program(uint32_t address);
+    // Waits until every queued command has run
+    void sync();
+
+private:
+    // A ring entry is a header word (command << 24 | payload words)
+    // followed by its payload, which may wrap around the end of the ring
+    enum Command : uint32_t {
+        VIF_DATA,
+        MICRO_PROGRAM,
+        STOP
+    };
+
+    static constexpr uint32_t RING_WORDS = 64 * 1024;
+    static constexpr uint32_t RING_MASK = RING_WORDS - 1;
+    static constexpr uint32_t MAX_PAYLOAD = RING_WORDS / 4;    // Longer VIF data is split
+    // Yields before sleeping on the ring: the EE tends to queue in bursts
+    static constexpr int SPIN_COUNT = 64;
+
+    void push(Command command, const uint32_t* data, uint32_t words);
+    void thread_loop();
+
+    VectorUnit* vu_;
+    std::vector<uint32_t> ring_;
+    // Free-running word counts. put_ is written by the EE thread only,
+    // get_ by the VU1 thread only, once an entry has run.
+    alignas(64) std::atomic<uint32_t> put_;
+    alignas(64) std::atomic<uint32_t> get_;
+    std::thread thread_;
+};
+
+} // namespace recovery
+} // namespace gscx
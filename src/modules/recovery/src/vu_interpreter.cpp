@@ -0,0 +1,735 @@
+#include "ee_engine.h"
+#include "vu_recompiler.h"
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <sstream>
+
+namespace gscx {
+namespace recovery {
+
+// VU0/VU1 micro mode and VU0 macro mode. A micro instruction is a pair
+// of 32-bit words: the upper word drives the FMAC pipe (4-wide float
+// arithmetic, done here with SSE2) and the lower word the integer,
+// load/store, branch, divider and EFU units. Both halves of a pair read
+// the registers as they were before the pair; the upper result is held
+// in upper_ until the lower instruction has run, and wins if both write
+// the same register.
+//
+// Pipeline timing is not modelled: Q and P are ready as soon as DIV or
+// an EFU op is issued, and WAITQ/WAITP do nothing. The D and T (debug
+// break/halt) bits are ignored.
+
+namespace {
+
+constexpr uint32_t UPPER_I = 1u << 31;
+constexpr uint32_t UPPER_E = 1u << 30;
+constexpr uint32_t VU_FLOAT_MAX = 0x7F7FFFFF;   // Largest host-finite magnitude
+
+// Status flag bits set by the divider
+constexpr uint32_t STATUS_I = 1u << 4;
+constexpr uint32_t STATUS_D = 1u << 5;
+
+// Lane masks of the xyzw dest field (x in bit 3, lane 0)
+struct DestMasks {
+    alignas(16) uint32_t lanes[16][4];
+};
+
+constexpr DestMasks make_dest_masks() {
+    DestMasks masks{};
+    for (uint32_t dest = 0; dest < 16; dest++) {
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            masks.lanes[dest][lane] = (dest & (8u >> lane)) ? ~0u : 0u;
+        }
+    }
+    return masks;
+}
+
+constexpr DestMasks DEST_MASKS = make_dest_masks();
+
+// movemask bit order (x in bit 0) to MAC flag order (x in bit 3)
+constexpr uint8_t LANE_REVERSE[16] = {
+    0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+inline __m128 dest_mask(uint32_t dest) {
+    return _mm_load_ps(reinterpret_cast<const float*>(DEST_MASKS.lanes[dest]));
+}
+
+// mask ? a : b
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Exponent-255 values (the VU's largest numbers, host Inf/NaN) become
+// the largest finite value, denormals become zero; signs are kept
+inline __m128 clamp_operand(__m128 value) {
+    __m128i bits = _mm_castps_si128(value);
+    __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x7F800000));
+    __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(INT32_MIN));
+    __m128i huge = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7F800000));
+    __m128i tiny = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+    __m128i clamped = _mm_or_si128(sign, _mm_set1_epi32(VU_FLOAT_MAX));
+    return _mm_castsi128_ps(select(huge, clamped, select(tiny, sign, bits)));
+}
+
+inline float clamp_scalar(float value) {
+    uint32_t bits = float_bits(value);
+    uint32_t exponent = bits & 0x7F800000;
+    if (exponent == 0x7F800000) return bits_float((bits & 0x80000000) | VU_FLOAT_MAX);
+    if (exponent == 0) return bits_float(bits & 0x80000000);
+    return value;
+}
+
+inline __m128 load_vector(const float* reg, VUClampMode mode) {
+    __m128 value = _mm_load_ps(reg);
+    return mode == VUClampMode::ACCURATE ? clamp_operand(value) : value;
+}
+
+inline __m128 broadcast(__m128 value, uint32_t component) {
+    switch (component) {
+        case 0: return _mm_shuffle_ps(value, value, _MM_SHUFFLE(0, 0, 0, 0));
+        case 1: return _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1));
+        case 2: return _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2));
+        default: return _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+// Clamps an FMAC result into the VU range and returns its MAC flags for
+// the dest lanes: Z (bits 0-3), S (4-7), U (8-11), O (12-15). Overflow
+// saturates to the largest value, underflow flushes to zero (and sets Z).
+inline __m128 finish_result(__m128 value, uint32_t dest, uint32_t& mac) {
+    __m128i bits = _mm_castps_si128(value);
+    __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x7F800000));
+    __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(INT32_MIN));
+    __m128i overflow = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7F800000));
+    __m128i tiny = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+    __m128i zero = _mm_cmpeq_epi32(_mm_and_si128(bits, _mm_set1_epi32(INT32_MAX)), _mm_setzero_si128());
+    __m128i underflow = _mm_andnot_si128(zero, tiny);
+    __m128i clamped = _mm_or_si128(sign, _mm_set1_epi32(VU_FLOAT_MAX));
+    bits = select(overflow, clamped, select(tiny, sign, bits));
+
+    uint32_t z = LANE_REVERSE[_mm_movemask_ps(_mm_castsi128_ps(tiny))];
+    uint32_t s = LANE_REVERSE[_mm_movemask_ps(_mm_castsi128_ps(sign))];
+    uint32_t u = LANE_REVERSE[_mm_movemask_ps(_mm_castsi128_ps(underflow))];
+    uint32_t o = LANE_REVERSE[_mm_movemask_ps(_mm_castsi128_ps(overflow))];
+    mac = (z | (s << 4) | (u << 8) | (o << 12)) & (dest * 0x1111u);
+    return _mm_castsi128_ps(bits);
+}
+
+// Float ordering on the raw bits: sign-magnitude mapped to two's
+// complement, so -0 < +0 and exponent-255 values compare as numbers
+inline __m128i ordered_bits(__m128 value) {
+    __m128i bits = _mm_castps_si128(value);
+    return _mm_xor_si128(bits, _mm_and_si128(_mm_srai_epi32(bits, 31), _mm_set1_epi32(INT32_MAX)));
+}
+
+inline __m128 vu_max(__m128 a, __m128 b) {
+    return select(_mm_castsi128_ps(_mm_cmpgt_epi32(ordered_bits(a), ordered_bits(b))), a, b);
+}
+
+inline __m128 vu_min(__m128 a, __m128 b) {
+    return select(_mm_castsi128_ps(_mm_cmpgt_epi32(ordered_bits(a), ordered_bits(b))), b, a);
+}
+
+// Fixed point scales of ITOF/FTOI 0, 4, 12 and 15
+constexpr float FIXED_SCALE[4] = { 1.0f, 16.0f, 4096.0f, 32768.0f };
+
+// ACCURATE mode rounds toward zero like the VU; MXCSR is restored on exit
+class RoundingScope {
+public:
+    explicit RoundingScope(bool toward_zero)
+        : saved_(_mm_getcsr())
+        , active_(toward_zero) {
+        if (active_) {
+            _mm_setcsr(saved_ | 0x6000);
+        }
+    }
+    ~RoundingScope() {
+        if (active_) {
+            _mm_setcsr(saved_);
+        }
+    }
+
+private:
+    uint32_t saved_;
+    bool active_;
+};
+
+enum class FmacOp { ADD, SUB, MUL, MADD, MSUB, MAX, MINI, OPMSUB };
+enum class FmacSource { VECTOR, BROADCAST, I, Q };
+
+constexpr FmacOp BROADCAST_OPS[7] = {
+    FmacOp::ADD, FmacOp::SUB, FmacOp::MADD, FmacOp::MSUB, FmacOp::MAX, FmacOp::MINI, FmacOp::MUL
+};
+
+} // namespace
+
+void VectorUnit::start_micro_program(uint32_t start_address) {
+    pc_ = start_address & micro_mask_ & ~7u;
+    next_pc_ = (pc_ + 8) & micro_mask_;
+    running_ = true;
+    ending_ = false;
+}
+
+void VectorUnit::execute_micro_program(uint32_t start_address) {
+    start_micro_program(start_address);
+    run(MAX_PROGRAM_INSTRUCTIONS);
+    if (running_) {
+        std::ostringstream ss;
+        ss << "Micro program at 0x" << std::hex << start_address << " did not end after "
+           << std::dec << MAX_PROGRAM_INSTRUCTIONS << " instructions, stopping";
+        log_warn(ss.str());
+        running_ = false;
+    }
+}
+
+uint64_t VectorUnit::run(uint64_t max_instructions) {
+    RoundingScope rounding(clamp_mode_ == VUClampMode::ACCURATE);
+    if (execution_mode_ == VUExecutionMode::RECOMPILER && recompiler_) {
+        return recompiler_->execute(max_instructions);
+    }
+    return interpret(max_instructions);
+}
+
+uint64_t VectorUnit::interpret(uint64_t max_instructions) {
+    uint64_t executed = 0;
+    while (running_ && executed < max_instructions) {
+        uint32_t pc = pc_;
+        uint32_t lower = micro_memory_[pc >> 2];
+        uint32_t upper = micro_memory_[(pc >> 2) + 1];
+        pc_ = next_pc_;
+        next_pc_ = (next_pc_ + 8) & micro_mask_;
+
+        // With the I bit the lower word is a float for the I register
+        if (upper & UPPER_I) {
+            registers_.i = bits_float(lower);
+        }
+        execute_upper(upper);
+        if (!(upper & UPPER_I)) {
+            execute_lower(lower, pc);
+        }
+        commit_upper();
+        executed++;
+
+        // The pair after the one with the E bit is the last
+        if (ending_) {
+            running_ = false;
+            ending_ = false;
+        } else if (upper & UPPER_E) {
+            ending_ = true;
+        }
+    }
+    return executed;
+}
+
+void VectorUnit::execute_vector_instruction(uint32_t instruction) {
+    RoundingScope rounding(clamp_mode_ == VUClampMode::ACCURATE);
+    uint32_t funct = instruction & 0x3F;
+
+    // VCALLMS/VCALLMSR run a VU0 micro program to completion
+    if (funct == 0x38 || funct == 0x39) {
+        uint32_t start = funct == 0x38 ? (instruction >> 6) & 0x7FFF : cmsar0_;
+        execute_micro_program(start * 8);
+        return;
+    }
+
+    // Macro instructions share the micro encodings: the integer ops and
+    // the lower half of the 0x3C-0x3F table go to the lower unit
+    uint32_t code = funct >= 0x3C ? (((instruction >> 6) & 0x1F) << 2) | (funct & 3) : funct;
+    if (code >= 0x30) {
+        execute_lower((instruction & 0x01FFFFFF) | 0x80000000, pc_);
+        return;
+    }
+    execute_upper(instruction);
+    commit_upper();
+}
+
+void VectorUnit::execute_upper(uint32_t instruction) {
+    VUUpperResult& result = upper_;
+    result.target = nullptr;
+    result.write_mac = false;
+    result.write_clip = false;
+
+    const VUClampMode mode = clamp_mode_;
+    uint32_t dest = (instruction >> 21) & 0xF;
+    int ft = (instruction >> 16) & 0x1F;
+    int fs = (instruction >> 11) & 0x1F;
+    int fd = (instruction >> 6) & 0x1F;
+    uint32_t funct = instruction & 0x3F;
+    uint32_t code = funct;
+    bool accumulate = false;
+
+    if (funct >= 0x3C) {
+        code = (static_cast<uint32_t>(fd) << 2) | (funct & 3);
+        switch (code) {
+            case 0x10: case 0x11: case 0x12: case 0x13: {   // ITOF0/4/12/15
+                __m128i fixed = _mm_castps_si128(_mm_load_ps(registers_.vf[fs]));
+                __m128 value = _mm_mul_ps(_mm_cvtepi32_ps(fixed), _mm_set1_ps(1.0f / FIXED_SCALE[code & 3]));
+                _mm_store_ps(result.value, value);
+                result.target = registers_.vf[ft];
+                result.dest = dest;
+                return;
+            }
+            case 0x14: case 0x15: case 0x16: case 0x17: {   // FTOI0/4/12/15
+                __m128 scaled = _mm_mul_ps(load_vector(registers_.vf[fs], mode), _mm_set1_ps(FIXED_SCALE[code & 3]));
+                // cvttps gives INT32_MIN out of range; positive overflow saturates
+                __m128i fixed = _mm_cvttps_epi32(scaled);
+                __m128 positive_overflow = _mm_cmpge_ps(scaled, _mm_set1_ps(2147483648.0f));
+                fixed = _mm_xor_si128(fixed, _mm_castps_si128(positive_overflow));
+                _mm_store_ps(result.value, _mm_castsi128_ps(fixed));
+                result.target = registers_.vf[ft];
+                result.dest = dest;
+                return;
+            }
+            case 0x1D: {    // ABS
+                __m128 value = _mm_and_ps(_mm_load_ps(registers_.vf[fs]), _mm_castsi128_ps(_mm_set1_epi32(INT32_MAX)));
+                _mm_store_ps(result.value, value);
+                result.target = registers_.vf[ft];
+                result.dest = dest;
+                return;
+            }
+            case 0x1F: {    // CLIP: fs.xyz against +-|ft.w|, six new judgement bits
+                __m128 value = load_vector(registers_.vf[fs], mode);
+                __m128 limit = broadcast(load_vector(registers_.vf[ft], mode), 3);
+                limit = _mm_and_ps(limit, _mm_castsi128_ps(_mm_set1_epi32(INT32_MAX)));
+                uint32_t above = _mm_movemask_ps(_mm_cmpgt_ps(value, limit));
+                uint32_t below = _mm_movemask_ps(_mm_cmplt_ps(value, _mm_sub_ps(_mm_setzero_ps(), limit)));
+                uint32_t judgement = 0;
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    judgement |= ((above >> axis) & 1) << (axis * 2);
+                    judgement |= ((below >> axis) & 1) << (axis * 2 + 1);
+                }
+                result.write_clip = true;
+                result.clip = ((registers_.clip_flag << 6) | judgement) & 0xFFFFFF;
+                return;
+            }
+            case 0x2E: {    // OPMULA: ACC.xyz = fs.yzx * ft.zxy
+                __m128 a = load_vector(registers_.vf[fs], mode);
+                __m128 b = load_vector(registers_.vf[ft], mode);
+                __m128 value = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)),
+                                          _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2)));
+                _mm_store_ps(result.value, finish_result(value, dest, result.mac));
+                result.target = registers_.acc;
+                result.dest = dest;
+                result.write_mac = true;
+                return;
+            }
+            case 0x2B:      // Reserved
+            case 0x2F:      // NOP
+                return;
+            default:
+                if (code >= 0x30) {
+                    return;
+                }
+                accumulate = true;
+                break;
+        }
+    } else if (funct >= 0x30) {
+        return;
+    }
+
+    FmacOp op;
+    FmacSource source;
+    if (code < 0x1C) {
+        op = BROADCAST_OPS[code >> 2];
+        source = FmacSource::BROADCAST;
+    } else if (code >= 0x20 && code < 0x28) {
+        // ADDq MADDq ADDi MADDi SUBq MSUBq SUBi MSUBi
+        op = (code & 4) ? ((code & 1) ? FmacOp::MSUB : FmacOp::SUB) : ((code & 1) ? FmacOp::MADD : FmacOp::ADD);
+        source = (code & 2) ? FmacSource::I : FmacSource::Q;
+    } else {
+        source = FmacSource::VECTOR;
+        switch (code) {
+            case 0x1C: op = FmacOp::MUL; source = FmacSource::Q; break;
+            case 0x1D: op = FmacOp::MAX; source = FmacSource::I; break;
+            case 0x1E: op = FmacOp::MUL; source = FmacSource::I; break;
+            case 0x1F: op = FmacOp::MINI; source = FmacSource::I; break;
+            case 0x28: op = FmacOp::ADD; break;
+            case 0x29: op = FmacOp::MADD; break;
+            case 0x2A: op = FmacOp::MUL; break;
+            case 0x2B: op = FmacOp::MAX; break;
+            case 0x2C: op = FmacOp::SUB; break;
+            case 0x2D: op = FmacOp::MSUB; break;
+            case 0x2E: op = FmacOp::OPMSUB; break;
+            default: op = FmacOp::MINI; break;     // 0x2F
+        }
+    }
+
+    __m128 a = load_vector(registers_.vf[fs], mode);
+    __m128 b;
+    switch (source) {
+        case FmacSource::VECTOR: b = load_vector(registers_.vf[ft], mode); break;
+        case FmacSource::BROADCAST: b = broadcast(load_vector(registers_.vf[ft], mode), code & 3); break;
+        case FmacSource::I: b = _mm_set1_ps(mode == VUClampMode::ACCURATE ? clamp_scalar(registers_.i) : registers_.i); break;
+        default: b = _mm_set1_ps(registers_.q); break;
+    }
+
+    result.target = accumulate ? registers_.acc : registers_.vf[fd];
+    result.dest = dest;
+    if (op == FmacOp::MAX || op == FmacOp::MINI) {
+        _mm_store_ps(result.value, op == FmacOp::MAX ? vu_max(a, b) : vu_min(a, b));
+        return;
+    }
+
+    __m128 value;
+    switch (op) {
+        case FmacOp::ADD: value = _mm_add_ps(a, b); break;
+        case FmacOp::SUB: value = _mm_sub_ps(a, b); break;
+        case FmacOp::MUL: value = _mm_mul_ps(a, b); break;
+        default: {
+            // Multiply-accumulate rounds the product before the add
+            __m128 product;
+            if (op == FmacOp::OPMSUB) {
+                product = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)),
+                                     _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2)));
+            } else {
+                product = _mm_mul_ps(a, b);
+            }
+            if (mode == VUClampMode::ACCURATE) {
+                product = clamp_operand(product);
+            }
+            __m128 acc = _mm_load_ps(registers_.acc);
+            value = op == FmacOp::MADD ? _mm_add_ps(acc, product) : _mm_sub_ps(acc, product);
+            break;
+        }
+    }
+    _mm_store_ps(result.value, finish_result(value, dest, result.mac));
+    result.write_mac = true;
+}
+
+void VectorUnit::commit_upper() {
+    VUUpperResult& result = upper_;
+    if (result.target && result.target != registers_.vf[0]) {
+        __m128 mask = dest_mask(result.dest);
+        __m128 value = select(mask, _mm_load_ps(result.value), _mm_load_ps(result.target));
+        _mm_store_ps(result.target, value);
+    }
+    if (result.write_mac) {
+        uint32_t mac = result.mac;
+        uint32_t flags = ((mac & 0x000F) ? 1u : 0u) | ((mac & 0x00F0) ? 2u : 0u) |
+                         ((mac & 0x0F00) ? 4u : 0u) | ((mac & 0xF000) ? 8u : 0u);
+        registers_.mac_flag = mac;
+        registers_.status_flag = (registers_.status_flag & ~0xFu) | flags | (flags << 6);
+    }
+    if (result.write_clip) {
+        registers_.clip_flag = result.clip;
+    }
+    result.target = nullptr;
+    result.write_mac = false;
+    result.write_clip = false;
+}
+
+void VectorUnit::set_status_id(uint32_t flags) {
+    registers_.status_flag = (registers_.status_flag & ~(STATUS_I | STATUS_D)) | flags | (flags << 6);
+}
+
+void VectorUnit::execute_lower(uint32_t instruction, uint32_t pc) {
+    const VUClampMode mode = clamp_mode_;
+    uint32_t dest = (instruction >> 21) & 0xF;
+    int ft = (instruction >> 16) & 0x1F;    // also it
+    int fs = (instruction >> 11) & 0x1F;    // also is
+    int fd = (instruction >> 6) & 0x1F;     // also id
+    int it = ft & 0xF;
+    int is = fs & 0xF;
+    int32_t imm11 = static_cast<int32_t>(instruction << 21) >> 21;
+    uint8_t* memory = data_memory_.data();
+    const uint32_t data_mask = data_mask_;
+
+    auto quad = [&](uint32_t address) { return memory + ((address << 4) & data_mask); };
+    auto write_vf_masked = [&](int reg, __m128 value) {
+        if (reg != 0) {
+            __m128 old = _mm_load_ps(registers_.vf[reg]);
+            _mm_store_ps(registers_.vf[reg], select(dest_mask(dest), value, old));
+        }
+    };
+    auto load_quad = [&](int reg, uint32_t address) {
+        write_vf_masked(reg, _mm_loadu_ps(reinterpret_cast<const float*>(quad(address))));
+    };
+    auto store_quad = [&](int reg, uint32_t address) {
+        float* target = reinterpret_cast<float*>(quad(address));
+        __m128 value = select(dest_mask(dest), _mm_load_ps(registers_.vf[reg]), _mm_loadu_ps(target));
+        _mm_storeu_ps(target, value);
+    };
+    auto field = [&](int reg, uint32_t component) {
+        float value = registers_.vf[reg][component];
+        return mode == VUClampMode::ACCURATE ? clamp_scalar(value) : value;
+    };
+    auto branch = [&](bool taken) {
+        if (taken) {
+            next_pc_ = (pc + 8 + static_cast<uint32_t>(imm11) * 8) & micro_mask_;
+        }
+    };
+    uint32_t fsf = (instruction >> 21) & 3;
+    uint32_t ftf = (instruction >> 23) & 3;
+
+    if (!(instruction & 0x80000000)) {
+        uint32_t imm15 = ((instruction >> 10) & 0x7800) | (instruction & 0x7FF);
+        uint32_t imm12 = ((instruction >> 10) & 0x800) | (instruction & 0x7FF);
+        uint32_t imm24 = instruction & 0xFFFFFF;
+        int16_t vs = static_cast<int16_t>(registers_.vi[is]);
+        switch (instruction >> 25) {
+            case 0x00: load_quad(ft, registers_.vi[is] + imm11); break;     // LQ
+            case 0x01: store_quad(fs, registers_.vi[it] + imm11); break;    // SQ
+            case 0x04: {    // ILW: the first selected field
+                uint32_t component = (dest & 8) ? 0 : (dest & 4) ? 1 : (dest & 2) ? 2 : 3;
+                uint32_t word;
+                std::memcpy(&word, quad(registers_.vi[is] + imm11) + component * 4, sizeof(word));
+                set_vi(it, word);
+                break;
+            }
+            case 0x05: {    // ISW
+                uint32_t word = registers_.vi[it];
+                uint8_t* target = quad(registers_.vi[is] + imm11);
+                for (uint32_t component = 0; component < 4; component++) {
+                    if (dest & (8u >> component)) {
+                        std::memcpy(target + component * 4, &word, sizeof(word));
+                    }
+                }
+                break;
+            }
+            case 0x08: set_vi(it, registers_.vi[is] + imm15); break;        // IADDIU
+            case 0x09: set_vi(it, registers_.vi[is] - imm15); break;        // ISUBIU
+            case 0x10: set_vi(1, (registers_.clip_flag & 0xFFFFFF) == imm24); break;  // FCEQ
+            case 0x11: registers_.clip_flag = imm24; break;                           // FCSET
+            case 0x12: set_vi(1, (registers_.clip_flag & imm24) != 0); break;         // FCAND
+            case 0x13: set_vi(1, ((registers_.clip_flag | imm24) & 0xFFFFFF) == 0xFFFFFF); break;  // FCOR
+            case 0x14: set_vi(it, (registers_.status_flag & 0xFFF) == imm12); break;  // FSEQ
+            case 0x15: registers_.status_flag = (registers_.status_flag & 0x3F) | (imm12 & 0xFC0); break;    // FSSET
+            case 0x16: set_vi(it, registers_.status_flag & imm12); break;             // FSAND
+            case 0x17: set_vi(it, (registers_.status_flag | imm12) & 0xFFF); break;   // FSOR
+            case 0x18: set_vi(it, registers_.mac_flag == registers_.vi[is]); break;   // FMEQ
+            case 0x1A: set_vi(it, registers_.mac_flag & registers_.vi[is]); break;    // FMAND
+            case 0x1B: set_vi(it, registers_.mac_flag | registers_.vi[is]); break;    // FMOR
+            case 0x1C: set_vi(it, registers_.clip_flag & 0xFFF); break;               // FCGET
+            case 0x20: branch(true); break;                                 // B
+            case 0x21: set_vi(it, (pc + 16) / 8); branch(true); break;      // BAL
+            case 0x24: next_pc_ = (registers_.vi[is] * 8u) & micro_mask_; break;    // JR
+            case 0x25: {    // JALR
+                uint32_t target = (registers_.vi[is] * 8u) & micro_mask_;
+                set_vi(it, (pc + 16) / 8);
+                next_pc_ = target;
+                break;
+            }
+            case 0x28: branch(registers_.vi[it] == registers_.vi[is]); break;   // IBEQ
+            case 0x29: branch(registers_.vi[it] != registers_.vi[is]); break;   // IBNE
+            case 0x2C: branch(vs < 0); break;       // IBLTZ
+            case 0x2D: branch(vs > 0); break;       // IBGTZ
+            case 0x2E: branch(vs <= 0); break;      // IBLEZ
+            case 0x2F: branch(vs >= 0); break;      // IBGEZ
+            default: break;     // Reserved encodings do nothing
+        }
+        return;
+    }
+
+    uint32_t funct = instruction & 0x3F;
+    if (funct < 0x3C) {
+        switch (funct) {
+            case 0x30: set_vi(fd & 0xF, registers_.vi[is] + registers_.vi[it]); break;    // IADD
+            case 0x31: set_vi(fd & 0xF, registers_.vi[is] - registers_.vi[it]); break;    // ISUB
+            case 0x32: set_vi(it, registers_.vi[is] + (static_cast<int32_t>(static_cast<uint32_t>(fd) << 27) >> 27)); break;  // IADDI
+            case 0x34: set_vi(fd & 0xF, registers_.vi[is] & registers_.vi[it]); break;    // IAND
+            case 0x35: set_vi(fd & 0xF, registers_.vi[is] | registers_.vi[it]); break;    // IOR
+            default: break;
+        }
+        return;
+    }
+
+    switch ((static_cast<uint32_t>(fd) << 2) | (funct & 3)) {
+        case 0x30: write_vf_masked(ft, _mm_load_ps(registers_.vf[fs])); break;    // MOVE
+        case 0x31: {    // MR32: rotate fields, x = y ... w = x
+            __m128 value = _mm_load_ps(registers_.vf[fs]);
+            write_vf_masked(ft, _mm_shuffle_ps(value, value, _MM_SHUFFLE(0, 3, 2, 1)));
+            break;
+        }
+        case 0x34:      // LQI
+            load_quad(ft, registers_.vi[is]);
+            set_vi(is, registers_.vi[is] + 1);
+            break;
+        case 0x35:      // SQI
+            store_quad(fs, registers_.vi[it]);
+            set_vi(it, registers_.vi[it] + 1);
+            break;
+        case 0x36:      // LQD
+            set_vi(is, registers_.vi[is] - 1);
+            load_quad(ft, registers_.vi[is]);
+            break;
+        case 0x37:      // SQD
+            set_vi(it, registers_.vi[it] - 1);
+            store_quad(fs, registers_.vi[it]);
+            break;
+        case 0x38: {    // DIV
+            float numerator = field(fs, fsf);
+            float denominator = field(ft, ftf);
+            if (denominator == 0.0f) {
+                set_status_id(numerator == 0.0f ? STATUS_I : STATUS_D);
+                uint32_t sign = (float_bits(numerator) ^ float_bits(denominator)) & 0x80000000;
+                registers_.q = bits_float(sign | VU_FLOAT_MAX);
+            } else {
+                set_status_id(0);
+                registers_.q = clamp_scalar(numerator / denominator);
+            }
+            break;
+        }
+        case 0x39: {    // SQRT
+            float value = field(ft, ftf);
+            set_status_id(value < 0.0f ? STATUS_I : 0);
+            registers_.q = std::sqrt(std::fabs(value));
+            break;
+        }
+        case 0x3A: {    // RSQRT
+            float numerator = field(fs, fsf);
+            float value = field(ft, ftf);
+            if (value == 0.0f) {
+                set_status_id(numerator == 0.0f ? STATUS_I : STATUS_D);
+                registers_.q = bits_float((float_bits(numerator) & 0x80000000) | VU_FLOAT_MAX);
+            } else {
+                set_status_id(value < 0.0f ? STATUS_I : 0);
+                registers_.q = clamp_scalar(numerator / std::sqrt(std::fabs(value)));
+            }
+            break;
+        }
+        case 0x3B: break;   // WAITQ
+        case 0x3C: set_vi(it, float_bits(registers_.vf[fs][fsf])); break;     // MTIR
+        case 0x3D: {    // MFIR: sign-extended
+            int32_t value = static_cast<int16_t>(registers_.vi[is]);
+            write_vf_masked(ft, _mm_castsi128_ps(_mm_set1_epi32(value)));
+            break;
+        }
+        case 0x3E: {    // ILWR
+            uint32_t component = (dest & 8) ? 0 : (dest & 4) ? 1 : (dest & 2) ? 2 : 3;
+            uint32_t word;
+            std::memcpy(&word, quad(registers_.vi[is]) + component * 4, sizeof(word));
+            set_vi(it, word);
+            break;
+        }
+        case 0x3F: {    // ISWR
+            uint32_t word = registers_.vi[it];
+            uint8_t* target = quad(registers_.vi[is]);
+            for (uint32_t component = 0; component < 4; component++) {
+                if (dest & (8u >> component)) {
+                    std::memcpy(target + component * 4, &word, sizeof(word));
+                }
+            }
+            break;
+        }
+        case 0x40: {    // RNEXT: 23-bit LFSR in the mantissa of a float in [1, 2)
+            uint32_t feedback = ((registers_.r >> 4) ^ (registers_.r >> 22)) & 1;
+            registers_.r = (((registers_.r << 1) ^ feedback) & 0x7FFFFF) | 0x3F800000;
+            [[fallthrough]];
+        }
+        case 0x41:      // RGET
+            write_vf_masked(ft, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(registers_.r))));
+            break;
+        case 0x42: registers_.r = 0x3F800000 | (float_bits(registers_.vf[fs][fsf]) & 0x7FFFFF); break;           // RINIT
+        case 0x43: registers_.r = 0x3F800000 | ((registers_.r ^ float_bits(registers_.vf[fs][fsf])) & 0x7FFFFF); break;   // RXOR
+        case 0x64: write_vf_masked(ft, _mm_set1_ps(registers_.p)); break;     // MFP
+        case 0x68: set_vi(it, vif_top_); break;                     // XTOP
+        case 0x69: set_vi(it, vif_itop_); break;                    // XITOP
+        case 0x6C:      // XGKICK
+            if (xgkick_handler_) {
+                xgkick_handler_((registers_.vi[is] * 16u) & data_mask);
+            }
+            break;
+
+        // EFU (VU1): results go to P
+        case 0x70: case 0x71: case 0x72: case 0x73: {   // ESADD ERSADD ELENG ERLENG
+            float x = field(fs, 0), y = field(fs, 1), z = field(fs, 2);
+            float sum = x * x + y * y + z * z;
+            switch (funct & 3) {
+                case 0: registers_.p = sum; break;
+                case 1: registers_.p = 1.0f / sum; break;
+                case 2: registers_.p = std::sqrt(sum); break;
+                default: registers_.p = 1.0f / std::sqrt(sum); break;
+            }
+            registers_.p = clamp_scalar(registers_.p);
+            break;
+        }
+        case 0x74: registers_.p = std::atan(field(fs, 1) / field(fs, 0)); break;   // EATANxy
+        case 0x75: registers_.p = std::atan(field(fs, 2) / field(fs, 0)); break;   // EATANxz
+        case 0x76: registers_.p = clamp_scalar(field(fs, 0) + field(fs, 1) + field(fs, 2) + field(fs, 3)); break;    // ESUM
+        case 0x78: registers_.p = std::sqrt(std::fabs(field(fs, fsf))); break;                        // ESQRT
+        case 0x79: registers_.p = clamp_scalar(1.0f / std::sqrt(std::fabs(field(fs, fsf)))); break;   // ERSQRT
+        case 0x7A: registers_.p = clamp_scalar(1.0f / field(fs, fsf)); break;                         // ERCPR
+        case 0x7B: break;   // WAITP
+        case 0x7C: registers_.p = std::sin(field(fs, fsf)); break;        // ESIN
+        case 0x7D: registers_.p = std::atan(field(fs, fsf)); break;       // EATAN
+        case 0x7E: registers_.p = clamp_scalar(std::exp(-field(fs, fsf))); break;    // EEXP
+        default: break;
+    }
+}
+
+// COP2 transfers
+void VectorUnit::read_vf(int reg, uint32_t value[4]) const {
+    std::memcpy(value, registers_.vf[reg & 31], sizeof(registers_.vf[0]));
+}
+
+void VectorUnit::write_vf(int reg, const uint32_t value[4]) {
+    if ((reg & 31) != 0) {
+        std::memcpy(registers_.vf[reg & 31], value, sizeof(registers_.vf[0]));
+    }
+}
+
+uint32_t VectorUnit::read_control(int reg) const {
+    if (reg < 16) {
+        return registers_.vi[reg];
+    }
+    switch (reg) {
+        case STATUS_FLAG: return registers_.status_flag;
+        case MAC_FLAG: return registers_.mac_flag;
+        case CLIPPING_FLAG: return registers_.clip_flag;
+        case R_REGISTER: return registers_.r;
+        case I_REGISTER: return float_bits(registers_.i);
+        case Q_REGISTER: return float_bits(registers_.q);
+        case P_REGISTER: return float_bits(registers_.p);
+        case TPC: return pc_ / 8;
+        case CMSAR0: return cmsar0_;
+        case VPU_STAT: return running_ ? 1 : 0;
+        default: return 0;
+    }
+}
+
+void VectorUnit::write_control(int reg, uint32_t value) {
+    if (reg < 16) {
+        set_vi(reg, value);
+        return;
+    }
+    switch (reg) {
+        case STATUS_FLAG: registers_.status_flag = (registers_.status_flag & 0x3F) | (value & 0xFC0); break;   // Sticky bits only
+        case CLIPPING_FLAG: registers_.clip_flag = value & 0xFFFFFF; break;
+        case R_REGISTER: registers_.r = 0x3F800000 | (value & 0x7FFFFF); break;
+        case I_REGISTER: registers_.i = bits_float(value); break;
+        case Q_REGISTER: registers_.q = bits_float(value); break;
+        case CMSAR0: cmsar0_ = value & 0xFFFF; break;
+        case FBRST:
+            // This unit's four bits: force break (0) and reset (1) stop it
+            if (value & 3) {
+                running_ = false;
+                ending_ = false;
+            }
+            if (value & 2) {
+                registers_.status_flag = registers_.mac_flag = registers_.clip_flag = 0;
+            }
+            break;
+        default: break;
+    }
+}
+
+} // namespace recovery
+} // namespace gscx
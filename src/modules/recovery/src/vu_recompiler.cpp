@@ -0,0 +1,1037 @@
+#include "vu_recompiler.h"
+#include "simd_support.h"
+#include "x64_emitter.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+
+namespace gscx {
+namespace recovery {
+
+using GSCX::Core::VecWidth;
+using GSCX::Core::X64Cond;
+using GSCX::Core::X64Emitter;
+using GSCX::Core::X64Reg;
+
+namespace {
+
+// Host register roles: R15 points at the VU registers, R14 at the JIT
+// context, RAX/RCX/RDX are scratch. Guest registers stay in memory.
+// XMM0-4 are scratch and XMM5 holds an upper result until the lower
+// half of its pair has run.
+constexpr X64Reg REGS = X64Reg::R15;
+constexpr X64Reg CONTEXT = X64Reg::R14;
+constexpr int PENDING = 5;
+
+// Saved by the entry stub: callee-saved on SysV and Win64 together
+constexpr X64Reg SAVED[] = {
+    X64Reg::RBX, X64Reg::RBP, X64Reg::RSI, X64Reg::RDI,
+    X64Reg::R12, X64Reg::R13, X64Reg::R14, X64Reg::R15
+};
+// Realigns RSP to 16 bytes after the pushes, with Win64 shadow space
+constexpr int32_t FRAME_SIZE = 40;
+
+constexpr uint32_t UPPER_I = 1u << 31;
+constexpr uint32_t UPPER_E = 1u << 30;
+constexpr VecWidth XMM = VecWidth::XMM;
+
+constexpr int32_t reg_offset(size_t offset) { return static_cast<int32_t>(offset); }
+
+constexpr int32_t context_offset(size_t offset) { return static_cast<int32_t>(offset); }
+
+constexpr int32_t vf_offset(int reg, uint32_t component = 0) {
+    return static_cast<int32_t>(offsetof(VURegisters, vf) + reg * 16 + component * 4);
+}
+
+constexpr int32_t vi_offset(int reg) {
+    return static_cast<int32_t>(offsetof(VURegisters, vi) + reg * 2);
+}
+
+// Lanes of an xyzw dest field (x in bit 3) as a movmskps mask (x in bit 0)
+constexpr uint32_t dest_lanes(uint32_t dest) {
+    return ((dest >> 3) & 1) | ((dest >> 1) & 2) | ((dest << 1) & 4) | ((dest << 3) & 8);
+}
+
+// vpblendw selector of a dest field
+constexpr uint8_t dest_words(uint32_t dest) {
+    uint32_t lanes = dest_lanes(dest);
+    uint32_t words = 0;
+    for (uint32_t lane = 0; lane < 4; lane++) {
+        if (lanes & (1u << lane)) {
+            words |= 3u << (lane * 2);
+        }
+    }
+    return static_cast<uint8_t>(words);
+}
+
+enum class UpperKind { NOP, FMAC, ITOF, FTOI, ABS, OPMULA, CLIP };
+enum class FmacOp { ADD, SUB, MUL, MADD, MSUB, MAX, MINI, OPMSUB };
+enum class FmacSource { VECTOR, BROADCAST, I, Q };
+
+struct UpperOp {
+    UpperKind kind;
+    FmacOp op;
+    FmacSource source;
+    bool accumulate;
+    uint32_t code;                  // funct, or the 0x3C-0x3F table index
+
+    bool sets_flags() const {
+        return kind == UpperKind::OPMULA ||
+               (kind == UpperKind::FMAC && op != FmacOp::MAX && op != FmacOp::MINI);
+    }
+};
+
+constexpr FmacOp BROADCAST_OPS[7] = {
+    FmacOp::ADD, FmacOp::SUB, FmacOp::MADD, FmacOp::MSUB, FmacOp::MAX, FmacOp::MINI, FmacOp::MUL
+};
+
+// Same decoding as VectorUnit::execute_upper
+UpperOp decode_upper(uint32_t instruction) {
+    UpperOp op{ UpperKind::NOP, FmacOp::ADD, FmacSource::VECTOR, false, 0 };
+    uint32_t funct = instruction & 0x3F;
+    uint32_t code = funct;
+    if (funct >= 0x3C) {
+        code = (((instruction >> 6) & 0x1F) << 2) | (funct & 3);
+        op.code = code;
+        switch (code) {
+            case 0x10: case 0x11: case 0x12: case 0x13: op.kind = UpperKind::ITOF; return op;
+            case 0x14: case 0x15: case 0x16: case 0x17: op.kind = UpperKind::FTOI; return op;
+            case 0x1D: op.kind = UpperKind::ABS; return op;
+            case 0x1F: op.kind = UpperKind::CLIP; return op;
+            case 0x2E: op.kind = UpperKind::OPMULA; return op;
+            case 0x2B: case 0x2F: return op;
+            default:
+                if (code >= 0x30) {
+                    return op;
+                }
+                op.accumulate = true;
+                break;
+        }
+    } else if (funct >= 0x30) {
+        return op;
+    }
+
+    op.kind = UpperKind::FMAC;
+    op.code = code;
+    if (code < 0x1C) {
+        op.op = BROADCAST_OPS[code >> 2];
+        op.source = FmacSource::BROADCAST;
+    } else if (code >= 0x20 && code < 0x28) {
+        op.op = (code & 4) ? ((code & 1) ? FmacOp::MSUB : FmacOp::SUB) : ((code & 1) ? FmacOp::MADD : FmacOp::ADD);
+        op.source = (code & 2) ? FmacSource::I : FmacSource::Q;
+    } else {
+        switch (code) {
+            case 0x1C: op.op = FmacOp::MUL; op.source = FmacSource::Q; break;
+            case 0x1D: op.op = FmacOp::MAX; op.source = FmacSource::I; break;
+            case 0x1E: op.op = FmacOp::MUL; op.source = FmacSource::I; break;
+            case 0x1F: op.op = FmacOp::MINI; op.source = FmacSource::I; break;
+            case 0x28: op.op = FmacOp::ADD; break;
+            case 0x29: op.op = FmacOp::MADD; break;
+            case 0x2A: op.op = FmacOp::MUL; break;
+            case 0x2B: op.op = FmacOp::MAX; break;
+            case 0x2C: op.op = FmacOp::SUB; break;
+            case 0x2D: op.op = FmacOp::MSUB; break;
+            case 0x2E: op.op = FmacOp::OPMSUB; break;
+            default: op.op = FmacOp::MINI; break;
+        }
+    }
+    return op;
+}
+
+enum class LowerKind { NOP, NATIVE, BRANCH, INTERPRETED };
+
+// Lower instructions emitted inline; flag tests, the divider, EFU and
+// the rest run the whole pair through the interpreter
+LowerKind classify_lower(uint32_t instruction) {
+    if (!(instruction & 0x80000000)) {
+        switch (instruction >> 25) {
+            case 0x00: case 0x01:               // LQ SQ
+            case 0x08: case 0x09:               // IADDIU ISUBIU
+                return LowerKind::NATIVE;
+            case 0x20: case 0x21: case 0x24: case 0x25:
+            case 0x28: case 0x29: case 0x2C: case 0x2D: case 0x2E: case 0x2F:
+                return LowerKind::BRANCH;
+            default:
+                return LowerKind::INTERPRETED;
+        }
+    }
+    uint32_t funct = instruction & 0x3F;
+    if (funct < 0x3C) {
+        switch (funct) {
+            case 0x30: case 0x31: case 0x32: case 0x34: case 0x35:     // IADD ISUB IADDI IAND IOR
+                return LowerKind::NATIVE;
+            default:
+                return LowerKind::NOP;
+        }
+    }
+    switch ((((instruction >> 6) & 0x1F) << 2) | (funct & 3)) {
+        case 0x30: case 0x31:                   // MOVE MR32
+        case 0x34: case 0x35: case 0x36: case 0x37:     // LQI SQI LQD SQD
+        case 0x3C:                              // MTIR
+            return LowerKind::NATIVE;
+        case 0x3B: case 0x7B:                   // WAITQ WAITP
+            return LowerKind::NOP;
+        default:
+            return LowerKind::INTERPRETED;
+    }
+}
+
+struct Pair {
+    uint32_t pc;
+    uint32_t lower;
+    uint32_t upper;
+
+    bool branches() const {
+        return !(upper & UPPER_I) && classify_lower(lower) == LowerKind::BRANCH;
+    }
+    // Pairs the interpreter runs whole
+    bool interpreted() const {
+        return !(upper & UPPER_I) && classify_lower(lower) == LowerKind::INTERPRETED;
+    }
+};
+
+enum class BlockEnd { FALLTHROUGH, BRANCH, STOP };
+
+// Addresses baked into generated code
+struct BlockTargets {
+    const void* vu;
+    const void* interpret_pair;
+    const void* interpret_upper;
+    const void* exit_stub;
+    uint8_t* data_memory;
+    uint32_t data_mask;
+    uint32_t micro_mask;
+    bool accurate;
+};
+
+class BlockCompiler : public X64Emitter {
+public:
+    BlockCompiler(VUBlock* block, const std::vector<Pair>& pairs, BlockEnd end, const BlockTargets& targets)
+        : block_(block)
+        , pairs_(pairs)
+        , end_(end)
+        , targets_(targets)
+        , pending_target_(-1)
+        , pending_dest_(0)
+        , branch_kind_(BranchKind::STATIC) {
+    }
+
+    void compile() {
+        size_t count = pairs_.size();
+
+        // Flags of an inline upper op are computed only if an
+        // interpreted pair or the end of the block comes before the
+        // next inline flag write
+        std::vector<bool> flags_live(count, false);
+        bool live = true;
+        for (size_t k = count; k-- > 0;) {
+            const Pair& pair = pairs_[k];
+            if (pair.interpreted()) {
+                live = true;
+                continue;
+            }
+            if (decode_upper(pair.upper).sets_flags()) {
+                flags_live[k] = live;
+                live = false;
+            }
+        }
+
+        // The budget is checked before anything runs; pc already holds
+        // the block's address
+        cmp_mem_imm8(CONTEXT, context_offset(offsetof(VUJitContext, budget)), 0);
+        leave_.push_back(jcc(X64Cond::LE));
+        add_mem_imm32(CONTEXT, context_offset(offsetof(VUJitContext, budget)), -static_cast<int32_t>(count));
+
+        for (size_t k = 0; k < count; k++) {
+            emit_pair(pairs_[k], flags_live[k]);
+        }
+
+        uint32_t next = (pairs_.back().pc + 8) & targets_.micro_mask;
+        switch (end_) {
+            case BlockEnd::BRANCH:
+                emit_branch_exits(next);
+                break;
+            case BlockEnd::STOP:
+                store_simm32(CONTEXT, context_offset(offsetof(VUJitContext, stopped)), 1);
+                store_simm32(CONTEXT, context_offset(offsetof(VUJitContext, pc)), static_cast<int32_t>(next));
+                store_simm32(CONTEXT, context_offset(offsetof(VUJitContext, last_exit)), 0);
+                break;
+            default:
+                emit_exit(1, next);
+                break;
+        }
+
+        for (size_t label : leave_) {
+            bind(label);
+        }
+        mov_imm64(X64Reg::RAX, reinterpret_cast<uint64_t>(targets_.exit_stub));
+        jmp(X64Reg::RAX);
+    }
+
+private:
+    enum class BranchKind { STATIC, CONDITIONAL, DYNAMIC };
+
+    void emit_pair(const Pair& pair, bool flags_live) {
+        if (pair.upper & UPPER_I) {
+            mov_imm32(X64Reg::RAX, pair.lower);
+            store(REGS, reg_offset(offsetof(VURegisters, i)), X64Reg::RAX, 4);
+            emit_upper_alone(pair.upper, flags_live);
+            return;
+        }
+        if (pair.interpreted()) {
+            call_helper(targets_.interpret_pair, pair.lower, pair.upper);
+            return;
+        }
+
+        // Native lower halves never read what the upper half writes
+        // except VF registers, which are committed after them
+        UpperOp upper = decode_upper(pair.upper);
+        if (upper.kind == UpperKind::CLIP) {
+            call_helper(targets_.interpret_upper, pair.upper, 0);
+            emit_lower(pair);
+            return;
+        }
+        bool pending = emit_upper(pair.upper, upper, flags_live);
+        emit_lower(pair);
+        if (pending) {
+            commit_upper();
+        }
+    }
+
+    void emit_upper_alone(uint32_t instruction, bool flags_live) {
+        UpperOp upper = decode_upper(instruction);
+        if (upper.kind == UpperKind::CLIP) {
+            call_helper(targets_.interpret_upper, instruction, 0);
+        } else if (emit_upper(instruction, upper, flags_live)) {
+            commit_upper();
+        }
+    }
+
+    void call_helper(const void* helper, uint32_t a, uint32_t b) {
+        mov_imm64(X64Emitter::arg_reg(0), reinterpret_cast<uint64_t>(targets_.vu));
+        mov_imm32(X64Emitter::arg_reg(1), a);
+        mov_imm32(X64Emitter::arg_reg(2), b);
+        call(helper);
+    }
+
+    // Operand load, clamped in ACCURATE mode
+    void load_operand(int dst, int32_t offset) {
+        vmovups_load(dst, REGS, offset, XMM);
+        if (targets_.accurate) {
+            clamp(dst);
+        }
+    }
+
+    // Exponent-255 lanes to +-max, denormals to +-0 (XMM2-4 scratch)
+    void clamp(int x) {
+        vandps(2, x, CONTEXT, context_offset(offsetof(VUJitContext, exponent_mask)), XMM);
+        vmovups_load(3, CONTEXT, context_offset(offsetof(VUJitContext, exponent_mask)), XMM);
+        vpcmpeqd(3, 2, 3);
+        vpxor(4, 4, 4);
+        vpcmpeqd(2, 2, 4);
+        vpor(4, 2, 3);
+        vandps(2, x, CONTEXT, context_offset(offsetof(VUJitContext, sign_mask)), XMM);
+        vandnps(x, 4, x, XMM);
+        vpand(4, 4, 2);
+        vorps(x, x, 4, XMM);
+        vandps(3, 3, CONTEXT, context_offset(offsetof(VUJitContext, float_max)), XMM);
+        vorps(x, x, 3, XMM);
+    }
+
+    // Clamps the FMAC result in XMM0 into XMM5 and, if live, stores the
+    // MAC and status flags for the dest lanes
+    void finish(uint32_t dest, bool flags_live) {
+        vandps(2, 0, CONTEXT, context_offset(offsetof(VUJitContext, exponent_mask)), XMM);
+        vmovups_load(3, CONTEXT, context_offset(offsetof(VUJitContext, exponent_mask)), XMM);
+        vpcmpeqd(3, 2, 3);          // overflow
+        vpxor(4, 4, 4);
+        vpcmpeqd(2, 2, 4);          // zero or denormal
+        if (flags_live) {
+            vandps(1, 0, CONTEXT, context_offset(offsetof(VUJitContext, abs_mask)), XMM);
+            vpcmpeqd(1, 1, 4);
+            vandnps(1, 1, 2, XMM);  // underflow
+            emit_flags(dest);
+        }
+        vpor(4, 2, 3);
+        vandps(2, 0, CONTEXT, context_offset(offsetof(VUJitContext, sign_mask)), XMM);
+        vandnps(PENDING, 4, 0, XMM);
+        vpand(4, 4, 2);
+        vorps(PENDING, PENDING, 4, XMM);
+        vandps(3, 3, CONTEXT, context_offset(offsetof(VUJitContext, float_max)), XMM);
+        vorps(PENDING, PENDING, 3, XMM);
+    }
+
+    // Z from XMM2, S from XMM0, U from XMM1, O from XMM3
+    void emit_flags(uint32_t dest) {
+        static constexpr int GROUP_MASKS[4] = { 2, 0, 1, 3 };
+        uint32_t lanes = dest_lanes(dest);
+        xor_(X64Reg::RDX, X64Reg::RDX, false);
+        for (int group = 0; group < 4; group++) {
+            vmovmskps(X64Reg::RAX, GROUP_MASKS[group]);
+            if (lanes != 0xF) {
+                and_imm32(X64Reg::RAX, static_cast<int32_t>(lanes), false);
+            }
+            load(X64Reg::RCX, CONTEXT, X64Reg::RAX, 4,
+                 context_offset(offsetof(VUJitContext, flag_tables) + group * sizeof(uint32_t) * 16), 4);
+            or_(X64Reg::RDX, X64Reg::RCX, false);
+        }
+        mov32(X64Reg::RCX, X64Reg::RDX);
+        and_imm32(X64Reg::RCX, 0xFFFF, false);
+        store(REGS, reg_offset(offsetof(VURegisters, mac_flag)), X64Reg::RCX, 4);
+
+        // Status: Z/S/U/O plus their sticky copies six bits up
+        shr_imm(X64Reg::RDX, 16, false);
+        mov32(X64Reg::RCX, X64Reg::RDX);
+        shl_imm(X64Reg::RCX, 6, false);
+        or_(X64Reg::RDX, X64Reg::RCX, false);
+        load(X64Reg::RAX, REGS, reg_offset(offsetof(VURegisters, status_flag)), 4);
+        and_imm32(X64Reg::RAX, ~0xF, false);
+        or_(X64Reg::RAX, X64Reg::RDX, false);
+        store(REGS, reg_offset(offsetof(VURegisters, status_flag)), X64Reg::RAX, 4);
+    }
+
+    // Leaves the result in XMM5 and its destination in pending_*;
+    // false if nothing is written
+    bool emit_upper(uint32_t instruction, const UpperOp& upper, bool flags_live) {
+        uint32_t dest = (instruction >> 21) & 0xF;
+        int ft = (instruction >> 16) & 0x1F;
+        int fs = (instruction >> 11) & 0x1F;
+        int fd = (instruction >> 6) & 0x1F;
+        uint32_t fixed = upper.code & 3;
+
+        switch (upper.kind) {
+            case UpperKind::ITOF:
+                vmovups_load(0, REGS, vf_offset(fs), XMM);
+                vcvtdq2ps(0, 0, XMM);
+                vbroadcastss(1, CONTEXT, context_offset(offsetof(VUJitContext, fixed_inverse) + fixed * 4), XMM);
+                vmulps(PENDING, 0, 1, XMM);
+                return set_pending(vf_offset(ft), ft != 0, dest);
+            case UpperKind::FTOI:
+                // cvttps gives INT32_MIN out of range; positive overflow saturates
+                load_operand(0, vf_offset(fs));
+                vbroadcastss(1, CONTEXT, context_offset(offsetof(VUJitContext, fixed_scale) + fixed * 4), XMM);
+                vmulps(0, 0, 1, XMM);
+                vcvttps2dq(2, 0, XMM);
+                vbroadcastss(1, CONTEXT, context_offset(offsetof(VUJitContext, int_limit)), XMM);
+                vcmpps(1, 0, 1, GSCX::Core::X64_CMP_GE_OQ, XMM);
+                vpxor(PENDING, 2, 1);
+                return set_pending(vf_offset(ft), ft != 0, dest);
+            case UpperKind::ABS:
+                vmovups_load(0, REGS, vf_offset(fs), XMM);
+                vandps(PENDING, 0, CONTEXT, context_offset(offsetof(VUJitContext, abs_mask)), XMM);
+                return set_pending(vf_offset(ft), ft != 0, dest);
+            case UpperKind::OPMULA:
+                load_operand(0, vf_offset(fs));
+                load_operand(1, vf_offset(ft));
+                vshufps(0, 0, 0, 0xC9, XMM);    // yzx
+                vshufps(1, 1, 1, 0xD2, XMM);    // zxy
+                vmulps(0, 0, 1, XMM);
+                finish(dest, flags_live);
+                return set_pending(reg_offset(offsetof(VURegisters, acc)), true, dest);
+            case UpperKind::FMAC:
+                break;
+            default:
+                return false;
+        }
+
+        load_operand(0, vf_offset(fs));
+        switch (upper.source) {
+            case FmacSource::VECTOR:
+                load_operand(1, vf_offset(ft));
+                break;
+            case FmacSource::BROADCAST:
+                vbroadcastss(1, REGS, vf_offset(ft, upper.code & 3), XMM);
+                if (targets_.accurate) {
+                    clamp(1);
+                }
+                break;
+            case FmacSource::I:
+                vbroadcastss(1, REGS, reg_offset(offsetof(VURegisters, i)), XMM);
+                if (targets_.accurate) {
+                    clamp(1);
+                }
+                break;
+            default:
+                vbroadcastss(1, REGS, reg_offset(offsetof(VURegisters, q)), XMM);
+                break;
+        }
+
+        int32_t target = upper.accumulate ? reg_offset(offsetof(VURegisters, acc)) : vf_offset(fd);
+        bool writes = upper.accumulate || fd != 0;
+        switch (upper.op) {
+            case FmacOp::MAX:
+            case FmacOp::MINI:
+                // Compare the raw bits as sign-magnitude integers
+                vpsrad(2, 0, 31);
+                vandps(2, 2, CONTEXT, context_offset(offsetof(VUJitContext, abs_mask)), XMM);
+                vpxor(2, 2, 0);
+                vpsrad(3, 1, 31);
+                vandps(3, 3, CONTEXT, context_offset(offsetof(VUJitContext, abs_mask)), XMM);
+                vpxor(3, 3, 1);
+                vpcmpgtd(4, 2, 3);
+                vpxor(2, 0, 1);
+                vpand(2, 2, 4);
+                vpxor(PENDING, upper.op == FmacOp::MAX ? 1 : 0, 2);
+                return set_pending(target, writes, dest);
+            case FmacOp::ADD: vaddps(0, 0, 1, XMM); break;
+            case FmacOp::SUB: vsubps(0, 0, 1, XMM); break;
+            case FmacOp::MUL: vmulps(0, 0, 1, XMM); break;
+            default:
+                // Multiply-accumulate rounds the product before the add
+                if (upper.op == FmacOp::OPMSUB) {
+                    vshufps(0, 0, 0, 0xC9, XMM);
+                    vshufps(1, 1, 1, 0xD2, XMM);
+                }
+                vmulps(1, 0, 1, XMM);
+                if (targets_.accurate) {
+                    clamp(1);
+                }
+                vmovups_load(0, REGS, reg_offset(offsetof(VURegisters, acc)), XMM);
+                if (upper.op == FmacOp::MADD) {
+                    vaddps(0, 0, 1, XMM);
+                } else {
+                    vsubps(0, 0, 1, XMM);
+                }
+                break;
+        }
+        finish(dest, flags_live);
+        return set_pending(target, writes, dest);
+    }
+
+    bool set_pending(int32_t target, bool writes, uint32_t dest) {
+        pending_target_ = target;
+        pending_dest_ = dest;
+        return writes && dest != 0;
+    }
+
+    void commit_upper() {
+        write_masked(pending_target_, PENDING, pending_dest_);
+    }
+
+    // Writes the dest fields of `src` to a register (XMM4 scratch)
+    void write_masked(int32_t offset, int src, uint32_t dest) {
+        if (dest == 0) {
+            return;
+        }
+        if (dest != 0xF) {
+            vmovups_load(4, REGS, offset, XMM);
+            vpblendw(src, 4, src, dest_words(dest));
+        }
+        vmovups_store(REGS, offset, src, XMM);
+    }
+
+    void get_vi(X64Reg dst, int reg, bool sign = false) {
+        load(dst, REGS, vi_offset(reg), 2, sign);
+    }
+
+    void set_vi(int reg, X64Reg src) {
+        if (reg != 0) {
+            store(REGS, vi_offset(reg), src, 2);
+        }
+    }
+
+    // RAX = host address of quadword (VI[base] + offset)
+    void quad_address(int base, int32_t offset) {
+        get_vi(X64Reg::RAX, base);
+        if (offset != 0) {
+            add_imm32(X64Reg::RAX, offset, false);
+        }
+        shl_imm(X64Reg::RAX, 4, false);
+        and_imm32(X64Reg::RAX, static_cast<int32_t>(targets_.data_mask), false);
+        mov_imm64(X64Reg::RCX, reinterpret_cast<uint64_t>(targets_.data_memory));
+        add(X64Reg::RAX, X64Reg::RCX);
+    }
+
+    void load_quad(int ft, uint32_t dest) {
+        if (ft == 0 || dest == 0) {
+            return;
+        }
+        vmovups_load(0, X64Reg::RAX, 0, XMM);
+        write_masked(vf_offset(ft), 0, dest);
+    }
+
+    void store_quad(int fs, uint32_t dest) {
+        if (dest == 0) {
+            return;
+        }
+        vmovups_load(0, REGS, vf_offset(fs), XMM);
+        if (dest != 0xF) {
+            vmovups_load(4, X64Reg::RAX, 0, XMM);
+            vpblendw(0, 4, 0, dest_words(dest));
+        }
+        vmovups_store(X64Reg::RAX, 0, 0, XMM);
+    }
+
+    void add_vi_imm(int dst, int src, int32_t imm) {
+        if (dst == 0) {
+            return;
+        }
+        get_vi(X64Reg::RAX, src);
+        add_imm32(X64Reg::RAX, imm, false);
+        set_vi(dst, X64Reg::RAX);
+    }
+
+    void emit_lower(const Pair& pair) {
+        uint32_t instruction = pair.lower;
+        LowerKind kind = classify_lower(instruction);
+        if (kind == LowerKind::NOP) {
+            return;
+        }
+        if (kind == LowerKind::BRANCH) {
+            emit_branch(pair);
+            return;
+        }
+
+        uint32_t dest = (instruction >> 21) & 0xF;
+        int ft = (instruction >> 16) & 0x1F;
+        int fs = (instruction >> 11) & 0x1F;
+        int fd = (instruction >> 6) & 0x1F;
+        int it = ft & 0xF;
+        int is = fs & 0xF;
+        int32_t imm11 = static_cast<int32_t>(instruction << 21) >> 21;
+
+        if (!(instruction & 0x80000000)) {
+            int32_t imm15 = static_cast<int32_t>(((instruction >> 10) & 0x7800) | (instruction & 0x7FF));
+            switch (instruction >> 25) {
+                case 0x00:  // LQ
+                    quad_address(is, imm11);
+                    load_quad(ft, dest);
+                    break;
+                case 0x01:  // SQ
+                    quad_address(it, imm11);
+                    store_quad(fs, dest);
+                    break;
+                case 0x08: add_vi_imm(it, is, imm15); break;    // IADDIU
+                default: add_vi_imm(it, is, -imm15); break;     // ISUBIU
+            }
+            return;
+        }
+
+        uint32_t funct = instruction & 0x3F;
+        if (funct < 0x3C) {
+            int id = fd & 0xF;
+            if (funct == 0x32) {    // IADDI
+                add_vi_imm(it, is, static_cast<int32_t>(static_cast<uint32_t>(fd) << 27) >> 27);
+                return;
+            }
+            if (id == 0) {
+                return;
+            }
+            get_vi(X64Reg::RAX, is);
+            get_vi(X64Reg::RCX, it);
+            switch (funct) {
+                case 0x30: add(X64Reg::RAX, X64Reg::RCX, false); break;
+                case 0x31: sub(X64Reg::RAX, X64Reg::RCX, false); break;
+                case 0x34: and_(X64Reg::RAX, X64Reg::RCX, false); break;
+                default: or_(X64Reg::RAX, X64Reg::RCX, false); break;
+            }
+            set_vi(id, X64Reg::RAX);
+            return;
+        }
+
+        uint32_t fsf = (instruction >> 21) & 3;
+        switch ((static_cast<uint32_t>(fd) << 2) | (funct & 3)) {
+            case 0x30:  // MOVE
+                if (ft != 0) {
+                    vmovups_load(0, REGS, vf_offset(fs), XMM);
+                    write_masked(vf_offset(ft), 0, dest);
+                }
+                break;
+            case 0x31:  // MR32
+                if (ft != 0) {
+                    vmovups_load(0, REGS, vf_offset(fs), XMM);
+                    vshufps(0, 0, 0, 0x39, XMM);
+                    write_masked(vf_offset(ft), 0, dest);
+                }
+                break;
+            case 0x34:  // LQI
+                quad_address(is, 0);
+                load_quad(ft, dest);
+                add_vi_imm(is, is, 1);
+                break;
+            case 0x35:  // SQI
+                quad_address(it, 0);
+                store_quad(fs, dest);
+                add_vi_imm(it, it, 1);
+                break;
+            case 0x36:  // LQD
+                add_vi_imm(is, is, -1);
+                quad_address(is, 0);
+                load_quad(ft, dest);
+                break;
+            case 0x37:  // SQD
+                add_vi_imm(it, it, -1);
+                quad_address(it, 0);
+                store_quad(fs, dest);
+                break;
+            default:    // MTIR
+                if (it != 0) {
+                    load(X64Reg::RAX, REGS, vf_offset(fs, fsf), 2);
+                    set_vi(it, X64Reg::RAX);
+                }
+                break;
+        }
+    }
+
+    // Evaluates the branch before its delay pair: the condition or the
+    // register target goes to the context, the link register is written
+    void emit_branch(const Pair& pair) {
+        uint32_t instruction = pair.lower;
+        int it = (instruction >> 16) & 0xF;
+        int is = (instruction >> 11) & 0xF;
+        int32_t imm11 = static_cast<int32_t>(instruction << 21) >> 21;
+        branch_target_ = (pair.pc + 8 + static_cast<uint32_t>(imm11) * 8) & targets_.micro_mask;
+        uint32_t link_value = (pair.pc + 16) / 8;
+
+        switch (instruction >> 25) {
+            case 0x20:  // B
+            case 0x21:  // BAL
+                branch_kind_ = BranchKind::STATIC;
+                if ((instruction >> 25) == 0x21 && it != 0) {
+                    mov_imm32(X64Reg::RAX, link_value);
+                    set_vi(it, X64Reg::RAX);
+                }
+                return;
+            case 0x24:  // JR
+            case 0x25:  // JALR
+                branch_kind_ = BranchKind::DYNAMIC;
+                get_vi(X64Reg::RAX, is);
+                shl_imm(X64Reg::RAX, 3, false);
+                and_imm32(X64Reg::RAX, static_cast<int32_t>(targets_.micro_mask), false);
+                store(CONTEXT, context_offset(offsetof(VUJitContext, branch_target)), X64Reg::RAX, 8);
+                if ((instruction >> 25) == 0x25 && it != 0) {
+                    mov_imm32(X64Reg::RAX, link_value);
+                    set_vi(it, X64Reg::RAX);
+                }
+                return;
+            default:
+                break;
+        }
+
+        branch_kind_ = BranchKind::CONDITIONAL;
+        X64Cond cond;
+        switch (instruction >> 25) {
+            case 0x28: case 0x29:   // IBEQ IBNE
+                get_vi(X64Reg::RAX, it);
+                get_vi(X64Reg::RCX, is);
+                xor_(X64Reg::RDX, X64Reg::RDX, false);
+                cmp(X64Reg::RAX, X64Reg::RCX, false);
+                setcc((instruction >> 25) == 0x28 ? X64Cond::E : X64Cond::NE, X64Reg::RDX);
+                store(CONTEXT, context_offset(offsetof(VUJitContext, branch_condition)), X64Reg::RDX, 8);
+                return;
+            case 0x2C: cond = X64Cond::L; break;    // IBLTZ
+            case 0x2D: cond = X64Cond::G; break;    // IBGTZ
+            case 0x2E: cond = X64Cond::LE; break;   // IBLEZ
+            default: cond = X64Cond::GE; break;     // IBGEZ
+        }
+        get_vi(X64Reg::RAX, is, true);
+        xor_(X64Reg::RDX, X64Reg::RDX, false);
+        test(X64Reg::RAX, X64Reg::RAX);
+        setcc(cond, X64Reg::RDX);
+        store(CONTEXT, context_offset(offsetof(VUJitContext, branch_condition)), X64Reg::RDX, 8);
+    }
+
+    void emit_branch_exits(uint32_t fallthrough) {
+        switch (branch_kind_) {
+            case BranchKind::STATIC:
+                emit_exit(0, branch_target_);
+                break;
+            case BranchKind::CONDITIONAL: {
+                cmp_mem_imm8(CONTEXT, context_offset(offsetof(VUJitContext, branch_condition)), 0);
+                size_t not_taken = jcc(X64Cond::E);
+                emit_exit(0, branch_target_);
+                bind(not_taken);
+                emit_exit(1, fallthrough);
+                break;
+            }
+            default:
+                load(X64Reg::RAX, CONTEXT, context_offset(offsetof(VUJitContext, branch_target)), 8);
+                store(CONTEXT, context_offset(offsetof(VUJitContext, pc)), X64Reg::RAX, 8);
+                store_simm32(CONTEXT, context_offset(offsetof(VUJitContext, last_exit)), 0);
+                leave_.push_back(jmp());
+                break;
+        }
+    }
+
+    void emit_exit(int link_index, uint32_t target) {
+        VUBlockLink& link = block_->links[link_index];
+        link.target_pc = target;
+        store_simm32(CONTEXT, context_offset(offsetof(VUJitContext, pc)), static_cast<int32_t>(target));
+        mov_imm64(X64Reg::RAX, reinterpret_cast<uint64_t>(&link));
+        store(CONTEXT, context_offset(offsetof(VUJitContext, last_exit)), X64Reg::RAX, 8);
+        jmp(X64Reg::RAX, 0);
+    }
+
+    VUBlock* block_;
+    const std::vector<Pair>& pairs_;
+    BlockEnd end_;
+    BlockTargets targets_;
+    int32_t pending_target_;
+    uint32_t pending_dest_;
+    BranchKind branch_kind_;
+    uint32_t branch_target_ = 0;
+    std::vector<size_t> leave_;     // Jumps to the exit stub
+};
+
+constexpr uint8_t LANE_REVERSE[16] = {
+    0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+} // namespace
+
+VURecompiler::VURecompiler(VectorUnit* vu)
+    : vu_(vu)
+    , context_()
+    , enter_(nullptr)
+    , exit_stub_(nullptr)
+    , program_(nullptr)
+    , micro_writes_(0)
+    , pending_link_(nullptr) {
+    context_.registers = &vu->registers_;
+    for (int i = 0; i < 4; i++) {
+        context_.exponent_mask[i] = 0x7F800000;
+        context_.sign_mask[i] = 0x80000000;
+        context_.abs_mask[i] = 0x7FFFFFFF;
+        context_.float_max[i] = 0x7F7FFFFF;
+    }
+    const float scales[4] = { 1.0f, 16.0f, 4096.0f, 32768.0f };
+    for (int i = 0; i < 4; i++) {
+        context_.fixed_scale[i] = scales[i];
+        context_.fixed_inverse[i] = 1.0f / scales[i];
+    }
+    context_.int_limit = 2147483648.0f;
+    for (uint32_t group = 0; group < 4; group++) {
+        for (uint32_t lanes = 0; lanes < 16; lanes++) {
+            context_.flag_tables[group][lanes] = (static_cast<uint32_t>(LANE_REVERSE[lanes]) << (group * 4)) |
+                                                 (lanes ? (1u << group) << 16 : 0);
+        }
+    }
+}
+
+VURecompiler::~VURecompiler() = default;
+
+bool VURecompiler::initialize() {
+    if (!GSCX::Core::get_host_cpu_features().avx) {
+        vu_->log_warn("VU recompiler needs AVX");
+        return false;
+    }
+
+    // Entry: save the callee-saved registers, set up R14/R15 and jump to
+    // the block. Blocks leave through the exit stub, which unwinds this.
+    X64Emitter e;
+    for (X64Reg reg : SAVED) {
+        e.push(reg);
+    }
+    e.sub_imm32(X64Reg::RSP, FRAME_SIZE);
+    e.mov(CONTEXT, X64Emitter::arg_reg(0));
+    e.mov(REGS, CONTEXT, context_offset(offsetof(VUJitContext, registers)));
+    e.jmp(X64Emitter::arg_reg(1));
+
+    size_t exit_offset = e.size();
+    e.add_imm32(X64Reg::RSP, FRAME_SIZE);
+    for (size_t i = sizeof(SAVED) / sizeof(SAVED[0]); i-- > 0;) {
+        e.pop(SAVED[i]);
+    }
+    e.ret();
+
+    if (!stubs_.assign(e.get_code()) || !arena_.reserve(ARENA_SIZE)) {
+        vu_->log_warn("Failed to allocate executable memory for the VU recompiler");
+        return false;
+    }
+    enter_ = stubs_.as<EnterFn>();
+    exit_stub_ = static_cast<const uint8_t*>(stubs_.entry()) + exit_offset;
+    return true;
+}
+
+void VURecompiler::interpret_pair(VectorUnit* vu, uint32_t lower, uint32_t upper) {
+    vu->execute_upper(upper);
+    vu->execute_lower(lower, 0);    // Never a branch
+    vu->commit_upper();
+}
+
+void VURecompiler::interpret_upper(VectorUnit* vu, uint32_t upper) {
+    vu->execute_upper(upper);
+    vu->commit_upper();
+}
+
+uint64_t VURecompiler::execute(uint64_t max_instructions) {
+    VectorUnit* vu = vu_;
+    uint64_t executed = 0;
+
+    while (vu->running_ && executed < max_instructions) {
+        uint32_t pc = vu->pc_;
+        VUBlock* block = nullptr;
+        // An E bit or branch taken by the interpreter finishes there
+        if (!vu->ending_ && vu->next_pc_ == ((pc + 8) & vu->micro_mask_)) {
+            block = lookup(pc);
+        }
+        if (!block) {
+            pending_link_ = nullptr;
+            executed += vu->interpret(1);
+            continue;
+        }
+
+        if (pending_link_ && pending_link_->target_pc == pc) {
+            link(pending_link_, block);
+        }
+        pending_link_ = nullptr;
+
+        int64_t budget = static_cast<int64_t>(
+            std::min<uint64_t>(max_instructions - executed, std::numeric_limits<int64_t>::max()));
+        context_.budget = budget;
+        context_.pc = pc;
+        context_.stopped = 0;
+        context_.last_exit = nullptr;
+        enter_(&context_, block->entry);
+
+        executed += static_cast<uint64_t>(budget - context_.budget);
+        vu->pc_ = static_cast<uint32_t>(context_.pc);
+        vu->next_pc_ = (vu->pc_ + 8) & vu->micro_mask_;
+        if (context_.stopped) {
+            vu->running_ = false;
+            break;
+        }
+
+        // Link the exit taken once its target has been looked up
+        VUBlockLink* exit = context_.last_exit;
+        if (exit && exit->code == exit_stub_) {
+            pending_link_ = exit;
+        }
+    }
+    return executed;
+}
+
+VUBlock* VURecompiler::lookup(uint32_t pc) {
+    // Micro memory only changes between runs, so the program is picked
+    // again only after a write
+    if (!program_ || micro_writes_ != vu_->micro_writes_) {
+        uint64_t hash = vu_->program_hash_;
+        if (programs_.size() >= MAX_PROGRAMS && !programs_.count(hash)) {
+            clear();
+        }
+        // The hash is only a key: a different image with the same hash
+        // replaces the cached program. Its blocks stay in the arena, unused,
+        // until the next clear().
+        std::unique_ptr<VUProgram>& program = programs_[hash];
+        if (!program || program->image != vu_->micro_memory_) {
+            program = std::make_unique<VUProgram>();
+            program->image = vu_->micro_memory_;
+            program->blocks.resize(vu_->micro_memory_.size() / 2, nullptr);
+        }
+        if (program.get() != program_) {
+            // The last exit belongs to another program's code
+            pending_link_ = nullptr;
+        }
+        program_ = program.get();
+        micro_writes_ = vu_->micro_writes_;
+    }
+
+    uint32_t index = pc >> 3;
+    if (!program_->blocks[index]) {
+        VUBlock* block = compile(pc);
+        if (!block) {
+            return nullptr;
+        }
+        // compile() empties the cache when the arena is full
+        if (!program_) {
+            return lookup(pc);
+        }
+        program_->blocks[index] = block;
+    }
+    return program_->blocks[index];
+}
+
+VUBlock* VURecompiler::compile(uint32_t pc) {
+    const uint32_t mask = vu_->micro_mask_;
+    auto fetch = [&](uint32_t address) {
+        Pair pair;
+        pair.pc = address;
+        pair.lower = vu_->micro_memory_[address >> 2];
+        pair.upper = vu_->micro_memory_[(address >> 2) + 1];
+        return pair;
+    };
+
+    std::vector<Pair> pairs;
+    BlockEnd end = BlockEnd::FALLTHROUGH;
+    uint32_t address = pc;
+    while (pairs.size() < MAX_BLOCK_PAIRS) {
+        Pair pair = fetch(address);
+        uint32_t next = (address + 8) & mask;
+        bool branches = pair.branches();
+        if (branches || (pair.upper & UPPER_E)) {
+            // The pair after a branch or E bit has to be a plain one;
+            // anything else is left to the interpreter
+            Pair slot = fetch(next);
+            if (slot.branches() || (slot.upper & UPPER_E) || (branches && (pair.upper & UPPER_E))) {
+                break;
+            }
+            pairs.push_back(pair);
+            pairs.push_back(slot);
+            end = branches ? BlockEnd::BRANCH : BlockEnd::STOP;
+            break;
+        }
+        pairs.push_back(pair);
+        address = next;
+    }
+    if (pairs.empty()) {
+        return nullptr;
+    }
+
+    auto block = std::make_unique<VUBlock>();
+    block->pc = pc;
+    block->pair_count = static_cast<uint32_t>(pairs.size());
+    for (VUBlockLink& link : block->links) {
+        link.code = exit_stub_;
+        link.target_pc = 0;
+        link.owner = block.get();
+    }
+
+    BlockTargets targets;
+    targets.vu = vu_;
+    targets.interpret_pair = reinterpret_cast<const void*>(&VURecompiler::interpret_pair);
+    targets.interpret_upper = reinterpret_cast<const void*>(&VURecompiler::interpret_upper);
+    targets.exit_stub = exit_stub_;
+    targets.data_memory = vu_->data_memory_.data();
+    targets.data_mask = vu_->data_mask_;
+    targets.micro_mask = mask;
+    targets.accurate = vu_->clamp_mode_ == VUClampMode::ACCURATE;
+
+    BlockCompiler compiler(block.get(), pairs, end, targets);
+    compiler.compile();
+    block->entry = arena_.append(compiler.get_code());
+    if (!block->entry) {
+        // Arena full: start over. Generated code holds no pointers into
+        // the arena, so the new block can go in as emitted.
+        std::stringstream ss;
+        ss << "VU recompiler: code arena full (" << blocks_.size() << " blocks), flushing";
+        vu_->log_info(ss.str());
+        clear();
+        block->entry = arena_.append(compiler.get_code());
+        if (!block->entry) {
+            return nullptr;
+        }
+    }
+
+    VUBlock* result = block.get();
+    blocks_.push_back(std::move(block));
+    return result;
+}
+
+void VURecompiler::link(VUBlockLink* exit, VUBlock* target) {
+    if (exit->code == exit_stub_) {
+        exit->code = target->entry;
+    }
+}
+
+void VURecompiler::clear() {
+    programs_.clear();
+    blocks_.clear();
+    program_ = nullptr;
+    micro_writes_ = 0;
+    pending_link_ = nullptr;
+    arena_.reset();
+}
+
+} // namespace recovery
+} // namespace gscx
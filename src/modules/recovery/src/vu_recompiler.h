@@ -0,0 +1,132 @@
+#pragma once
+#include "ee_engine.h"
+#include "exec_memory.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gscx {
+namespace recovery {
+
+struct VUBlock;
+
+// A block exit to a fixed micro address, jumped through like
+// EEBlockLink: it starts at the exit stub and is pointed at the target
+// block once that is compiled
+struct VUBlockLink {
+    const void* code;               // Must stay first: jumped through directly
+    uint32_t target_pc;
+    VUBlock* owner;
+};
+
+// One compiled run of instruction pairs, ending after a branch and its
+// delay pair, after an E bit and the pair following it, or at the length
+// limit
+struct VUBlock {
+    uint32_t pc;
+    uint32_t pair_count;
+    const void* entry;
+    VUBlockLink links[2];           // Taken branch / fall-through
+};
+
+// Blocks compiled from one micro memory image, indexed by pc / 8. The
+// image is kept to tell hash collisions apart.
+struct VUProgram {
+    std::vector<uint32_t> image;
+    std::vector<VUBlock*> blocks;
+};
+
+// State shared with generated code, which keeps its address in R14
+struct VUJitContext {
+    VURegisters* registers;         // Kept in R15
+    int64_t budget;                 // Pairs left; blocks subtract their length on entry
+    uint64_t pc;                    // Next pair when a block is left
+    uint64_t stopped;               // Set when the program ended (E bit)
+    VUBlockLink* last_exit;         // Link the last block left through, null for dynamic exits
+    uint64_t branch_condition;      // Saved across the delay pair
+    uint64_t branch_target;
+
+    // Constants for generated code
+    alignas(16) uint32_t exponent_mask[4];
+    alignas(16) uint32_t sign_mask[4];
+    alignas(16) uint32_t abs_mask[4];
+    alignas(16) uint32_t float_max[4];
+    float fixed_scale[4];           // FTOI 0/4/12/15
+    float fixed_inverse[4];         // ITOF 0/4/12/15
+    float int_limit;                // 2^31
+    // MAC flag bits for a lane mask, per Z/S/U/O group, with the group's
+    // status bit in bits 16-19
+    uint32_t flag_tables[4][16];
+};
+
+/**
+ * VU Recompiler
+ *
+ * Translates VU micro programs to x86-64 with AVX (VEX-encoded SSE on
+ * XMM registers), one block of instruction pairs at a time. The code
+ * cache is keyed by the micro memory hash VectorUnit keeps up to date
+ * in write_micro_mem, so microcode a game uploads again finds its old
+ * blocks instead of being recompiled; blocks of one image link to each
+ * other directly.
+ *
+ * FMAC (upper) instructions other than CLIP, integer ops, quadword
+ * loads/stores, moves and branches are emitted inline against the
+ * registers in memory; the remaining lower instructions run the pair
+ * through the interpreter. MAC/status flags are computed only where
+ * they can be observed: before an interpreted pair and for the last
+ * flag-setting instruction of a block. The sticky status bits therefore
+ * miss flags that are overwritten within a block.
+ *
+ * execute() may run past `max_instructions` by up to one block.
+ */
+class VURecompiler {
+public:
+    explicit VURecompiler(VectorUnit* vu);
+    ~VURecompiler();
+
+    VURecompiler(const VURecompiler&) = delete;
+    VURecompiler& operator=(const VURecompiler&) = delete;
+
+    // Reserves the code arena and builds the entry/exit stubs
+    bool initialize();
+
+    uint64_t execute(uint64_t max_instructions);
+
+    void clear();
+
+    size_t get_program_count() const { return programs_.size(); }
+    size_t get_block_count() const { return blocks_.size(); }
+    size_t get_code_size() const { return arena_.used(); }
+
+private:
+    static constexpr size_t ARENA_SIZE = 8 * 1024 * 1024;
+    static constexpr uint32_t MAX_BLOCK_PAIRS = 64;
+    static constexpr size_t MAX_PROGRAMS = 256;
+
+    VUBlock* lookup(uint32_t pc);
+    VUBlock* compile(uint32_t pc);
+    void link(VUBlockLink* exit, VUBlock* target);
+
+    // Pairs the generated code leaves to the interpreter
+    static void interpret_pair(VectorUnit* vu, uint32_t lower, uint32_t upper);
+    static void interpret_upper(VectorUnit* vu, uint32_t upper);
+
+    using EnterFn = void (*)(VUJitContext* context, const void* code);
+
+    VectorUnit* vu_;
+    VUJitContext context_;
+    GSCX::Core::ExecutableBlock stubs_;
+    GSCX::Core::ExecutableArena arena_;
+    EnterFn enter_;
+    const void* exit_stub_;
+
+    std::vector<std::unique_ptr<VUBlock>> blocks_;
+    std::unordered_map<uint64_t, std::unique_ptr<VUProgram>> programs_;
+    VUProgram* program_;            // Program matching micro memory as of micro_writes_
+    uint64_t micro_writes_;
+    VUBlockLink* pending_link_;
+};
+
+} // namespace recovery
+} // namespace gscx
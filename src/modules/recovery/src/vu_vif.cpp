@@ -0,0 +1,252 @@
+#include "ee_engine.h"
+#include <cstring>
+#include <sstream>
+
+namespace gscx {
+namespace recovery {
+
+// VIF: the interface that feeds a VU from DMA. Its stream is a sequence
+// of 32-bit command words (command in bits 30-24, NUM in 23-16, IMMEDIATE
+// in 15-0), some followed by data. The decoder is a state machine over
+// single words so that a command and its data may be split across calls.
+//
+// Stalls are not modelled: a micro program started by MSCAL runs to its
+// end within the call, so the FLUSH commands have nothing to wait for.
+
+namespace {
+
+enum VIFCommand : uint32_t {
+    VIF_NOP = 0x00,
+    VIF_STCYCL = 0x01,
+    VIF_OFFSET = 0x02,
+    VIF_BASE = 0x03,
+    VIF_ITOP = 0x04,
+    VIF_STMOD = 0x05,
+    VIF_MSKPATH3 = 0x06,
+    VIF_MARK = 0x07,
+    VIF_FLUSHE = 0x10,
+    VIF_FLUSH = 0x11,
+    VIF_FLUSHA = 0x13,
+    VIF_MSCAL = 0x14,
+    VIF_MSCALF = 0x15,
+    VIF_MSCNT = 0x17,
+    VIF_STMASK = 0x20,
+    VIF_STROW = 0x30,
+    VIF_STCOL = 0x31,
+    VIF_MPG = 0x4A,
+    VIF_DIRECT = 0x50,
+    VIF_DIRECTHL = 0x51,
+    VIF_UNPACK = 0x60               // 0x60-0x7F: bit 4 masks, bits 3-2 VN, 1-0 VL
+};
+
+// UNPACK immediate bits next to the 10-bit quadword address
+constexpr uint32_t UNPACK_USN = 1u << 14;   // 8/16-bit fields zero-extend
+constexpr uint32_t UNPACK_FLG = 1u << 15;   // Address is relative to TOPS
+
+// Bytes of one UNPACK element: VN + 1 fields of 32 >> VL bits, except
+// V4-5, a 16-bit RGBA5551 colour
+uint32_t unpack_element_size(uint32_t vn, uint32_t vl) {
+    return vl == 3 ? 2 : (vn + 1) * (4u >> vl);
+}
+
+} // namespace
+
+void VectorUnit::write_vif(const uint32_t* data, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        if (vif_.remaining != 0) {
+            vif_data(data[i]);
+        } else {
+            vif_command(data[i]);
+        }
+    }
+}
+
+void VectorUnit::vif_command(uint32_t word) {
+    uint32_t command = (word >> 24) & 0x7F;
+    uint32_t immediate = word & 0xFFFF;
+    uint32_t num = (word >> 16) & 0xFF;
+    vif_.command = command;
+
+    switch (command) {
+        case VIF_NOP:
+        case VIF_MSKPATH3:
+        case VIF_MARK:
+        case VIF_FLUSHE:
+        case VIF_FLUSH:
+        case VIF_FLUSHA:
+            break;
+        case VIF_STCYCL:
+            vif_.cycle_length = immediate & 0xFF;
+            vif_.write_length = immediate >> 8;
+            break;
+        case VIF_OFFSET:
+            vif_.offset = immediate & 0x3FF;
+            vif_.dbf = false;
+            vif_.tops = vif_.base;
+            break;
+        case VIF_BASE:
+            vif_.base = immediate & 0x3FF;
+            break;
+        case VIF_ITOP:
+            vif_itop_ = static_cast<uint16_t>(immediate & 0x3FF);
+            break;
+        case VIF_STMOD:
+            vif_.mode = immediate & 3;
+            break;
+        case VIF_MSCAL:
+        case VIF_MSCALF:
+            vif_start_program(immediate * 8);
+            break;
+        case VIF_MSCNT:
+            vif_start_program(pc_);
+            break;
+        case VIF_STMASK:
+            vif_.remaining = 1;
+            break;
+        case VIF_STROW:
+        case VIF_STCOL:
+            vif_.address = 0;
+            vif_.remaining = 4;
+            break;
+        case VIF_MPG:
+            // LOADADDR and NUM count instruction pairs
+            vif_.address = immediate * 2;
+            vif_.remaining = (num ? num : 256) * 2;
+            break;
+        case VIF_DIRECT:
+        case VIF_DIRECTHL:
+            vif_.remaining = (immediate ? immediate : 65536) * 4;
+            break;
+        default: {
+            if (command >= VIF_UNPACK) {
+                uint32_t vn = (command >> 2) & 3;
+                uint32_t vl = command & 3;
+                uint32_t elements = num ? num : 256;
+                if (vl == 3 && vn != 3) {
+                    std::ostringstream ss;
+                    ss << "VIF" << unit_id_ << ": invalid UNPACK format 0x" << std::hex << command;
+                    log_warn(ss.str());
+                    break;
+                }
+                vif_.element_size = unpack_element_size(vn, vl);
+                vif_.address = (immediate & 0x3FF) + ((immediate & UNPACK_FLG) ? vif_.tops : 0);
+                vif_.command = command | (immediate & UNPACK_USN);
+                vif_.element = 0;
+                vif_.elements_left = elements;
+                vif_.staged_count = 0;
+                vif_.remaining = (elements * vif_.element_size + 3) / 4;
+                break;
+            }
+            std::ostringstream ss;
+            ss << "VIF" << unit_id_ << ": unknown command 0x" << std::hex << word;
+            log_warn(ss.str());
+            break;
+        }
+    }
+}
+
+void VectorUnit::vif_data(uint32_t word) {
+    vif_.remaining--;
+    uint32_t command = vif_.command & 0x7F;
+    if (command >= VIF_UNPACK) {
+        // Element bytes in stream order; padding after the last is dropped
+        for (int i = 0; i < 4 && vif_.elements_left != 0; i++) {
+            vif_.staged[vif_.staged_count++] = static_cast<uint8_t>(word >> (i * 8));
+            if (vif_.staged_count == vif_.element_size) {
+                vif_unpack_element();
+                vif_.staged_count = 0;
+            }
+        }
+        return;
+    }
+
+    switch (command) {
+        case VIF_STMASK:
+            vif_.mask = word;
+            break;
+        case VIF_STROW:
+            vif_.row[vif_.address++] = word;
+            break;
+        case VIF_STCOL:
+            vif_.col[vif_.address++] = word;
+            break;
+        case VIF_MPG:
+            write_micro_mem(vif_.address++ & static_cast<uint32_t>(micro_memory_.size() - 1), word);
+            break;
+        default:    // DIRECT/DIRECTHL: GIF PATH2 data, not emulated
+            break;
+    }
+}
+
+void VectorUnit::vif_unpack_element() {
+    uint32_t command = vif_.command;
+    uint32_t vn = (command >> 2) & 3;
+    uint32_t vl = command & 3;
+    bool zero_extend = (command & UNPACK_USN) != 0;
+    const uint8_t* src = vif_.staged;
+
+    uint32_t value[4];
+    uint32_t fields = vn + 1;
+    if (vl == 3) {
+        uint16_t colour;
+        std::memcpy(&colour, src, sizeof(colour));
+        value[0] = (colour & 0x1F) << 3;
+        value[1] = ((colour >> 5) & 0x1F) << 3;
+        value[2] = ((colour >> 10) & 0x1F) << 3;
+        value[3] = (colour >> 15) << 7;
+        fields = 4;
+    } else {
+        for (uint32_t i = 0; i < fields; i++) {
+            switch (vl) {
+                case 0:
+                    std::memcpy(&value[i], src + i * 4, 4);
+                    break;
+                case 1: {
+                    uint16_t half;
+                    std::memcpy(&half, src + i * 2, 2);
+                    value[i] = zero_extend ? half : static_cast<uint32_t>(static_cast<int16_t>(half));
+                    break;
+                }
+                default:
+                    value[i] = zero_extend ? src[i] : static_cast<uint32_t>(static_cast<int8_t>(src[i]));
+                    break;
+            }
+        }
+        // S broadcasts its one field; V2/V3 leave the other fields alone
+        if (vn == 0) {
+            value[1] = value[2] = value[3] = value[0];
+            fields = 4;
+        }
+    }
+
+    if (vif_.mode != 0) {
+        for (uint32_t i = 0; i < fields; i++) {
+            value[i] += vif_.row[i];
+            if (vif_.mode == 2) {
+                vif_.row[i] = value[i];
+            }
+        }
+    }
+
+    // Skipping write: WL quadwords written out of every CL. Filling
+    // (WL > CL) is treated as a plain sequential write.
+    uint32_t element = vif_.element++;
+    uint32_t quad = vif_.address + element;
+    if (vif_.write_length != 0 && vif_.write_length < vif_.cycle_length) {
+        quad = vif_.address + (element / vif_.write_length) * vif_.cycle_length + element % vif_.write_length;
+    }
+    std::memcpy(data_memory_.data() + ((quad * 16) & data_mask_), value, fields * 4);
+    vif_.elements_left--;
+}
+
+void VectorUnit::vif_start_program(uint32_t address) {
+    // The program sees the current TOPS as TOP; the next one gets the
+    // other buffer
+    vif_top_ = static_cast<uint16_t>(vif_.tops);
+    vif_.dbf = !vif_.dbf;
+    vif_.tops = vif_.base + (vif_.dbf ? vif_.offset : 0);
+    execute_micro_program(address);
+}
+
+} // namespace recovery
+} // namespace gscx
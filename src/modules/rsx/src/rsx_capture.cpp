@@ -0,0 +1,266 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Capture Implementation
+ */
+
+#include "rsx_capture.h"
+#include "rsx_core.h"
+#include "rsx_program_hash.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+namespace {
+
+static constexpr size_t CAPTURE_FILE_BUFFER = 1 << 20;
+
+// Operand words per record type, indexed by RSXCaptureRecord
+static constexpr uint8_t RECORD_ARGS[] = {
+    0,      // (unused)
+    2,      // METHOD
+    3,      // DRAW_ARRAYS
+    5,      // DRAW_ELEMENTS
+    10,     // TEXTURE
+    8,      // VERTEX_ATTRIBUTE
+    8,      // RENDER_TARGET
+    5,      // VERTEX_PROGRAM
+    5,      // FRAGMENT_PROGRAM
+    3,      // MEMORY (address, size), followed by the bytes
+    2       // PRESENT
+};
+
+uint32_t low_word(uint64_t value) {
+    return static_cast<uint32_t>(value);
+}
+
+uint32_t high_word(uint64_t value) {
+    return static_cast<uint32_t>(value >> 32);
+}
+
+} // namespace
+
+RSXCaptureWriter::RSXCaptureWriter()
+    : bytes_written(0)
+    , memory_bytes(0) {
+}
+
+RSXCaptureWriter::~RSXCaptureWriter() {
+    close();
+}
+
+bool RSXCaptureWriter::open(const std::string& path, uint64_t vram_base, uint64_t ioif_base) {
+    close();
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    // Large buffer: method records are 9 bytes and arrive one at a time
+    file_buffer.resize(CAPTURE_FILE_BUFFER);
+    file.rdbuf()->pubsetbuf(file_buffer.data(), static_cast<std::streamsize>(file_buffer.size()));
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t header[6] = { RSX_CAPTURE_MAGIC, RSX_CAPTURE_VERSION,
+                           low_word(vram_base), high_word(vram_base),
+                           low_word(ioif_base), high_word(ioif_base) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    bytes_written = sizeof(header);
+    memory_bytes = 0;
+    memory_hashes.clear();
+    return static_cast<bool>(file);
+}
+
+void RSXCaptureWriter::close() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    memory_hashes.clear();
+}
+
+void RSXCaptureWriter::write_record(RSXCaptureRecord type, const uint32_t* args, size_t count) {
+    uint8_t tag = static_cast<uint8_t>(type);
+    file.put(static_cast<char>(tag));
+    file.write(reinterpret_cast<const char*>(args), static_cast<std::streamsize>(count * sizeof(uint32_t)));
+    bytes_written += 1 + count * sizeof(uint32_t);
+}
+
+void RSXCaptureWriter::write_method(uint32_t method, uint32_t arg) {
+    uint32_t args[2] = { method, arg };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::METHOD, args, 2);
+}
+
+void RSXCaptureWriter::write_draw_arrays(uint32_t mode, uint32_t first, uint32_t count) {
+    uint32_t args[3] = { mode, first, count };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::DRAW_ARRAYS, args, 3);
+}
+
+void RSXCaptureWriter::write_draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t address) {
+    uint32_t args[5] = { mode, count, type, low_word(address), high_word(address) };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::DRAW_ELEMENTS, args, 5);
+}
+
+void RSXCaptureWriter::write_texture(uint32_t unit, const RSXTexture& texture) {
+    uint32_t args[10] = { unit, low_word(texture.address), high_word(texture.address),
+                          texture.width, texture.height, texture.depth, texture.format,
+                          texture.mipmap_levels, texture.pitch, texture.enabled ? 1u : 0u };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::TEXTURE, args, 10);
+}
+
+void RSXCaptureWriter::write_vertex_attribute(uint32_t index, const RSXVertexAttribute& attribute) {
+    uint32_t args[8] = { index, low_word(attribute.address), high_word(attribute.address),
+                         attribute.size, attribute.type, attribute.stride,
+                         attribute.normalized ? 1u : 0u, attribute.enabled ? 1u : 0u };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::VERTEX_ATTRIBUTE, args, 8);
+}
+
+void RSXCaptureWriter::write_render_target(uint32_t index, const RSXRenderTarget& target) {
+    uint32_t args[8] = { index, low_word(target.address), high_word(target.address),
+                         target.width, target.height, target.format, target.pitch,
+                         target.enabled ? 1u : 0u };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::RENDER_TARGET, args, 8);
+}
+
+void RSXCaptureWriter::write_program(RSXCaptureRecord type, const RSXShaderProgram& program) {
+    uint32_t args[5] = { low_word(program.address), high_word(program.address),
+                         program.size, program.type, program.enabled ? 1u : 0u };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(type, args, 5);
+}
+
+void RSXCaptureWriter::write_memory(uint64_t address, const uint8_t* data, size_t size) {
+    if (!data || size == 0) {
+        return;
+    }
+
+    uint64_t hash = rsx_hash_bytes(data, size);
+    std::lock_guard<std::mutex> lock(write_mutex);
+    auto it = memory_hashes.find(address);
+    if (it != memory_hashes.end() && it->second.first == size && it->second.second == hash) {
+        return;
+    }
+    memory_hashes[address] = { size, hash };
+
+    uint32_t args[3] = { low_word(address), high_word(address), static_cast<uint32_t>(size) };
+    write_record(RSXCaptureRecord::MEMORY, args, 3);
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    bytes_written += size;
+    memory_bytes += size;
+}
+
+void RSXCaptureWriter::write_present() {
+    uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    uint32_t args[2] = { low_word(now), high_word(now) };
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_record(RSXCaptureRecord::PRESENT, args, 2);
+}
+
+bool RSXCaptureReader::open(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t header[6];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != RSX_CAPTURE_MAGIC || header[1] != RSX_CAPTURE_VERSION) {
+        file.close();
+        return false;
+    }
+    vram_base = static_cast<uint64_t>(header[2]) | (static_cast<uint64_t>(header[3]) << 32);
+    ioif_base = static_cast<uint64_t>(header[4]) | (static_cast<uint64_t>(header[5]) << 32);
+    truncated = false;
+    return true;
+}
+
+bool RSXCaptureReader::next(RSXCaptureEntry& entry) {
+    int tag = file.get();
+    if (tag == std::char_traits<char>::eof()) {
+        return false;
+    }
+    if (tag <= 0 || static_cast<size_t>(tag) >= sizeof(RECORD_ARGS)) {
+        truncated = true;
+        return false;
+    }
+
+    entry.type = static_cast<RSXCaptureRecord>(tag);
+    size_t count = RECORD_ARGS[tag];
+    if (!file.read(reinterpret_cast<char*>(entry.args), static_cast<std::streamsize>(count * sizeof(uint32_t)))) {
+        truncated = true;
+        return false;
+    }
+
+    entry.data.clear();
+    if (entry.type == RSXCaptureRecord::MEMORY) {
+        entry.data.resize(entry.args[2]);
+        if (!file.read(reinterpret_cast<char*>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()))) {
+            truncated = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+RSXTexture RSXCaptureReader::decode_texture(const RSXCaptureEntry& entry) {
+    RSXTexture texture;
+    texture.address = entry.get_u64(1);
+    texture.width = entry.args[3];
+    texture.height = entry.args[4];
+    texture.depth = entry.args[5];
+    texture.format = entry.args[6];
+    texture.mipmap_levels = entry.args[7];
+    texture.pitch = entry.args[8];
+    texture.enabled = entry.args[9] != 0;
+    return texture;
+}
+
+RSXVertexAttribute RSXCaptureReader::decode_vertex_attribute(const RSXCaptureEntry& entry) {
+    RSXVertexAttribute attribute;
+    attribute.address = entry.get_u64(1);
+    attribute.size = entry.args[3];
+    attribute.type = entry.args[4];
+    attribute.stride = entry.args[5];
+    attribute.normalized = entry.args[6] != 0;
+    attribute.enabled = entry.args[7] != 0;
+    return attribute;
+}
+
+RSXRenderTarget RSXCaptureReader::decode_render_target(const RSXCaptureEntry& entry) {
+    RSXRenderTarget target;
+    target.address = entry.get_u64(1);
+    target.width = entry.args[3];
+    target.height = entry.args[4];
+    target.format = entry.args[5];
+    target.pitch = entry.args[6];
+    target.enabled = entry.args[7] != 0;
+    return target;
+}
+
+RSXShaderProgram RSXCaptureReader::decode_program(const RSXCaptureEntry& entry) {
+    RSXShaderProgram program;
+    program.address = entry.get_u64(0);
+    program.size = entry.args[2];
+    program.type = entry.args[3];
+    program.enabled = entry.args[4] != 0;
+    return program;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,140 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Capture Header
+ *
+ * Binary capture of everything RSXCore consumes: the method stream, the
+ * resource and draw calls, the memory ranges draws read and the present
+ * points. A capture replays without the CPU side of the emulator.
+ */
+
+#ifndef GSCX_MODULES_RSX_CAPTURE_H
+#define GSCX_MODULES_RSX_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+struct RSXTexture;
+struct RSXVertexAttribute;
+struct RSXRenderTarget;
+struct RSXShaderProgram;
+
+// File identification: "RSXC", bumped whenever a record layout changes
+static constexpr uint32_t RSX_CAPTURE_MAGIC = 0x43585352;
+static constexpr uint32_t RSX_CAPTURE_VERSION = 1;
+
+/**
+ * Capture record types
+ *
+ * Every record is a type byte followed by a fixed payload, except MEMORY
+ * whose payload carries its own length.
+ */
+enum class RSXCaptureRecord : uint8_t {
+    METHOD = 1,             // method, arg
+    DRAW_ARRAYS = 2,        // mode, first, count
+    DRAW_ELEMENTS = 3,      // mode, count, type, address
+    TEXTURE = 4,            // unit + RSXTexture
+    VERTEX_ATTRIBUTE = 5,   // index + RSXVertexAttribute
+    RENDER_TARGET = 6,      // index + RSXRenderTarget
+    VERTEX_PROGRAM = 7,     // RSXShaderProgram
+    FRAGMENT_PROGRAM = 8,   // RSXShaderProgram
+    MEMORY = 9,             // address, size, bytes
+    PRESENT = 10            // host timestamp (ns)
+};
+
+/**
+ * Decoded capture record
+ *
+ * Operands are 32-bit words in the order listed above, 64-bit values
+ * split low word first. MEMORY bytes are in `data`.
+ */
+struct RSXCaptureEntry {
+    RSXCaptureRecord type;
+    uint32_t args[12];
+    std::vector<uint8_t> data;
+
+    uint64_t get_u64(size_t index) const {
+        return static_cast<uint64_t>(args[index]) | (static_cast<uint64_t>(args[index + 1]) << 32);
+    }
+};
+
+/**
+ * RSX Capture Writer
+ *
+ * Memory ranges are written only when their contents differ from what
+ * the capture last recorded at that address, so static vertex buffers and
+ * textures cost their size once.
+ */
+class RSXCaptureWriter {
+public:
+    RSXCaptureWriter();
+    ~RSXCaptureWriter();
+
+    bool open(const std::string& path, uint64_t vram_base, uint64_t ioif_base);
+    void close();
+    bool is_open() const { return file.is_open(); }
+
+    void write_method(uint32_t method, uint32_t arg);
+    void write_draw_arrays(uint32_t mode, uint32_t first, uint32_t count);
+    void write_draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t address);
+    void write_texture(uint32_t unit, const RSXTexture& texture);
+    void write_vertex_attribute(uint32_t index, const RSXVertexAttribute& attribute);
+    void write_render_target(uint32_t index, const RSXRenderTarget& target);
+    void write_program(RSXCaptureRecord type, const RSXShaderProgram& program);
+    void write_memory(uint64_t address, const uint8_t* data, size_t size);
+    void write_present();
+
+    uint64_t get_bytes_written() const { return bytes_written; }
+    uint64_t get_memory_bytes() const { return memory_bytes; }
+
+private:
+    std::ofstream file;
+    std::vector<char> file_buffer;
+    std::mutex write_mutex;
+    std::unordered_map<uint64_t, std::pair<size_t, uint64_t>> memory_hashes;
+    uint64_t bytes_written;
+    uint64_t memory_bytes;
+
+    void write_record(RSXCaptureRecord type, const uint32_t* args, size_t count);
+};
+
+/**
+ * RSX Capture Reader
+ */
+class RSXCaptureReader {
+public:
+    bool open(const std::string& path);
+    bool next(RSXCaptureEntry& entry);
+
+    uint64_t get_vram_base() const { return vram_base; }
+    uint64_t get_ioif_base() const { return ioif_base; }
+    // The stream ended inside a record
+    bool is_truncated() const { return truncated; }
+
+    // Operands of TEXTURE, VERTEX_ATTRIBUTE, RENDER_TARGET and *_PROGRAM
+    // records; the unit/index, where present, is args[0]
+    static RSXTexture decode_texture(const RSXCaptureEntry& entry);
+    static RSXVertexAttribute decode_vertex_attribute(const RSXCaptureEntry& entry);
+    static RSXRenderTarget decode_render_target(const RSXCaptureEntry& entry);
+    static RSXShaderProgram decode_program(const RSXCaptureEntry& entry);
+
+private:
+    std::ifstream file;
+    uint64_t vram_base = 0;
+    uint64_t ioif_base = 0;
+    bool truncated = false;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_CAPTURE_H
@@ -21,12 +21,20 @@ namespace RSX {
 // RSX Constants
 static constexpr uint32_t RSX_VRAM_SIZE = 256 * 1024 * 1024; // 256MB VRAM
 static constexpr uint32_t RSX_COMMAND_BUFFER_SIZE = 32 * 1024 * 1024; // 32MB command buffer
+static constexpr uint64_t RSX_LOCAL_MEMORY_BASE = 0xC0000000; // RSX local memory in the RSX address space
+static constexpr uint64_t RSX_IO_ADDRESS_BASE = 0x00000000; // IOIF-mapped main memory
 static constexpr uint32_t RSX_MAX_TEXTURES = 16;
 static constexpr uint32_t RSX_MAX_VERTEX_ATTRIBUTES = 16;
 static constexpr uint32_t RSX_MAX_RENDER_TARGETS = 4;
+static constexpr uint32_t RSX_REPORT_AREA_OFFSET = RSX_VRAM_SIZE - RSX_REPORT_AREA_SIZE;
 
 // RSX Method IDs (NV40 compatible)
 static constexpr uint32_t RSX_NV4097_SET_OBJECT = 0x0000;
+static constexpr uint32_t RSX_NV406E_SET_REFERENCE = 0x0050;
+static constexpr uint32_t RSX_NV406E_SET_CONTEXT_DMA_SEMAPHORE = 0x0060;
+static constexpr uint32_t RSX_NV406E_SEMAPHORE_OFFSET = 0x0064;
+static constexpr uint32_t RSX_NV406E_SEMAPHORE_ACQUIRE = 0x0068;
+static constexpr uint32_t RSX_NV406E_SEMAPHORE_RELEASE = 0x006C;
 static constexpr uint32_t RSX_NV4097_NO_OPERATION = 0x0100;
 static constexpr uint32_t RSX_NV4097_NOTIFY = 0x0104;
 static constexpr uint32_t RSX_NV4097_WAIT_FOR_IDLE = 0x0110;
@@ -56,6 +64,39 @@ static constexpr uint32_t RSX_NV4097_SET_DEPTH_RANGE_NEAR = 0x0A10;
 static constexpr uint32_t RSX_NV4097_SET_DEPTH_RANGE_FAR = 0x0A14;
 static constexpr uint32_t RSX_NV4097_SET_VIEWPORT_OFFSET = 0x1D78;
 static constexpr uint32_t RSX_NV4097_SET_VIEWPORT_SCALE = 0x1D7C;
+static constexpr uint32_t RSX_NV4097_SET_RESTART_INDEX_ENABLE = 0x1DAC;
+static constexpr uint32_t RSX_NV4097_SET_RESTART_INDEX = 0x1DB0;
+static constexpr uint32_t RSX_NV4097_CLEAR_REPORT_VALUE = 0x17C8;
+static constexpr uint32_t RSX_NV4097_GET_REPORT = 0x1800;
+static constexpr uint32_t RSX_NV4097_SET_SEMAPHORE_OFFSET = 0x1D6C;
+static constexpr uint32_t RSX_NV4097_BACK_END_WRITE_SEMAPHORE_RELEASE = 0x1D70;
+static constexpr uint32_t RSX_NV4097_TEXTURE_READ_SEMAPHORE_RELEASE = 0x1D74;
+static constexpr uint32_t RSX_NV4097_SET_ZPASS_PIXEL_COUNT_ENABLE = 0x1D84;
+static constexpr uint32_t RSX_NV4097_SET_BEGIN_END = 0x1808;
+static constexpr uint32_t RSX_NV4097_DRAW_ARRAYS = 0x1814;
+static constexpr uint32_t RSX_NV4097_SET_INDEX_ARRAY_ADDRESS = 0x181C;
+static constexpr uint32_t RSX_NV4097_SET_INDEX_ARRAY_DMA = 0x1820;
+static constexpr uint32_t RSX_NV4097_DRAW_INDEX_ARRAY = 0x1824;
+static constexpr uint32_t RSX_NV4097_SET_SHADER_PROGRAM = 0x08E4;
+static constexpr uint32_t RSX_NV4097_SET_TRANSFORM_PROGRAM = 0x0B80;
+static constexpr uint32_t RSX_NV4097_SET_TRANSFORM_PROGRAM_LOAD = 0x1E9C;
+static constexpr uint32_t RSX_NV4097_SET_TRANSFORM_PROGRAM_START = 0x1EA0;
+static constexpr uint32_t RSX_NV4097_SET_TRANSFORM_CONSTANT_LOAD = 0x1EFC;
+static constexpr uint32_t RSX_NV4097_SET_TRANSFORM_CONSTANT = 0x1F00;
+static constexpr uint32_t RSX_METHOD_BATCH_WORDS = 32;
+
+// FIFO command words
+static constexpr uint32_t RSX_FIFO_METHOD_MASK = 0x00001FFC;
+static constexpr uint32_t RSX_FIFO_NON_INCREMENT = 0x40000000;
+static constexpr uint32_t RSX_FIFO_OLD_JUMP_MASK = 0xE0000003;
+static constexpr uint32_t RSX_FIFO_OLD_JUMP = 0x20000000;
+static constexpr uint32_t RSX_FIFO_OLD_JUMP_OFFSET = 0x1FFFFFFC;
+static constexpr uint32_t RSX_FIFO_NEW_JUMP = 0x00000001;
+static constexpr uint32_t RSX_FIFO_CALL = 0x00000002;
+static constexpr uint32_t RSX_FIFO_RETURN = 0x00020000;
+
+// Method writes the state stage applies per state_mutex acquisition
+static constexpr size_t RSX_STATE_BATCH = 64;
 
 RSXCore::RSXCore() 
     : logger(std::make_unique<Core::Logger>("RSX"))
@@ -63,22 +104,57 @@ RSXCore::RSXCore()
     , command_processor_running(false)
     , vram_base(0)
     , ioif_base(0)
+    , tile_count(0)
+    , main_memory(nullptr)
+    , main_memory_size(0)
+    , fifo_get(0)
+    , fifo_put(0)
+    , fifo_doorbell(0)
+    , fifo_return(0)
+    , methods_parsed(0)
+    , methods_executed(0)
+    , draws_queued(0)
+    , draws_retired(0)
     , current_context_dma_color(0)
     , current_context_dma_zeta(0)
     , current_surface_format(0)
     , current_surface_pitch(0)
     , current_color_offset(0)
     , current_zeta_offset(0)
+    , surface_clip_horizontal(0)
+    , surface_clip_vertical(0)
+    , draw_mode(0)
+    , draw_indexed(false)
+    , index_array_offset(0)
+    , index_array_dma(0)
+    , context_dma_semaphore(RSX_CONTEXT_DMA_SEMAPHORE_RW)
+    , context_dma_report(RSX_CONTEXT_DMA_REPORT_LOCATION_LOCAL)
+    , context_dma_notifies(RSX_CONTEXT_DMA_NOTIFY_MAIN_0)
+    , semaphore_offset(0)
+    , back_end_semaphore_offset(0)
+    , zpass_enabled(false)
+    , zpass_pixels(0)
     , viewport_x(0), viewport_y(0)
     , viewport_width(0), viewport_height(0)
     , clip_min_z(0.0f), clip_max_z(1.0f)
-    , depth_range_near(0.0f), depth_range_far(1.0f) {
+    , depth_range_near(0.0f), depth_range_far(1.0f)
+    , restart_index_enabled(false)
+    , restart_index(0xFFFFFFFF)
+    , transform_program_word(0)
+    , transform_program_start(0)
+    , transform_constant_word(0)
+    , transform_branch_bits(0)
+    , transform_program_dirty(true)
+    , current_vertex_program(nullptr)
+    , current_fragment_program(nullptr) {
     
-    // Initialize VRAM
-    vram.resize(RSX_VRAM_SIZE, 0);
-    
-    // Initialize command buffer
-    command_buffer.resize(RSX_COMMAND_BUFFER_SIZE, 0);
+    // Reserve VRAM and command buffer; pages are zero-filled on first touch
+    if (!vram.allocate(RSX_VRAM_SIZE)) {
+        logger->error("Failed to map {}MB VRAM", RSX_VRAM_SIZE / (1024 * 1024));
+    }
+    if (!command_buffer.allocate(RSX_COMMAND_BUFFER_SIZE)) {
+        logger->error("Failed to map {}MB command buffer", RSX_COMMAND_BUFFER_SIZE / (1024 * 1024));
+    }
     
     // Initialize texture units
     texture_units.resize(RSX_MAX_TEXTURES);
@@ -89,7 +165,27 @@ RSXCore::RSXCore()
     // Initialize render targets
     render_targets.resize(RSX_MAX_RENDER_TARGETS);
     
-    logger->info("RSX Core initialized with {}MB VRAM", RSX_VRAM_SIZE / (1024 * 1024));
+    // Initialize vertex streams
+    vertex_streams.resize(RSX_MAX_VERTEX_ATTRIBUTES);
+    
+    // Initialize transform program memory and vertex outputs
+    transform_program.resize(RSX_VP_MAX_INSTRUCTIONS * 4, 0);
+    transform_constants.resize(RSX_VP_MAX_CONSTANTS * 4, 0.0f);
+    vertex_batch = std::make_unique<RSXVertexBatch>();
+    vertex_outputs.resize(RSX_VP_OUTPUTS);
+    
+    // Initialize fragment sampler states
+    fragment_samplers.resize(RSX_FP_MAX_TEXTURES);
+    
+    // Draw packet pool
+    for (size_t i = 0; i < RSX_DRAW_QUEUE_SIZE; i++) {
+        draw_packets.push_back(std::make_unique<RSXDrawPacket>());
+        draw_packets.back()->outputs.resize(RSX_VP_OUTPUTS);
+        free_packets.push(draw_packets.back().get());
+    }
+    
+    logger->info("RSX Core initialized with {}MB VRAM ({}KB resident)",
+                 vram.size() / (1024 * 1024), vram.get_resident_bytes() / 1024);
 }
 
 RSXCore::~RSXCore() {
@@ -113,17 +209,62 @@ bool RSXCore::initialize(uint64_t vram_addr, uint64_t ioif_addr) {
     return true;
 }
 
+void RSXCore::set_main_memory(uint8_t* base, uint64_t size) {
+    main_memory = base;
+    main_memory_size = size;
+    logger->debug("Main memory attached: {}MB", size / (1024 * 1024));
+}
+
 void RSXCore::shutdown() {
     if (running) {
         logger->info("Shutting down RSX Core...");
         
         running = false;
         stop_command_processor();
+        write_back_surfaces(0, vram.size(), false);
+        {
+            std::lock_guard<std::mutex> lock(surface_cache.get_mutex());
+            surface_cache.clear();
+        }
+        stop_capture();
+        stop_trace();
+        close_shader_cache();
         
         logger->info("RSX Core shutdown complete");
     }
 }
 
+bool RSXCore::open_shader_cache(const std::string& path) {
+    close_shader_cache();
+    
+    auto cache = std::make_unique<RSXShaderDiskCache>();
+    if (!cache->open(path)) {
+        logger->warn("Shader cache unavailable: {}", path);
+        return false;
+    }
+    
+    vertex_program_cache.set_disk_cache(cache.get());
+    fragment_program_cache.set_disk_cache(cache.get());
+    cache->start_warm_load(vertex_program_cache, fragment_program_cache);
+    logger->info("Shader cache opened: {} ({} programs warming up)", path, cache->get_record_count());
+    
+    shader_cache = std::move(cache);
+    return true;
+}
+
+void RSXCore::close_shader_cache() {
+    if (!shader_cache) {
+        return;
+    }
+    
+    vertex_program_cache.set_disk_cache(nullptr);
+    fragment_program_cache.set_disk_cache(nullptr);
+    shader_cache->wait_for_warm_load();
+    logger->debug("Shader cache closed: {} warmed, {} rejected",
+                  shader_cache->get_warm_loaded(), shader_cache->get_warm_failed());
+    shader_cache.reset();
+}
+
 void RSXCore::reset_graphics_state() {
     // Reset viewport
     viewport_x = 0;
@@ -137,11 +278,32 @@ void RSXCore::reset_graphics_state() {
     depth_range_near = 0.0f;
     depth_range_far = 1.0f;
     
+    // Reset primitive restart
+    restart_index_enabled = false;
+    restart_index = 0xFFFFFFFF;
+    
     // Reset surface state
     current_surface_format = 0;
     current_surface_pitch = 0;
     current_color_offset = 0;
     current_zeta_offset = 0;
+    surface_clip_horizontal = 0;
+    surface_clip_vertical = 0;
+    
+    // Reset draw method state
+    draw_mode = 0;
+    draw_indexed = false;
+    index_array_offset = 0;
+    index_array_dma = 0;
+    draw_ranges.clear();
+    
+    // Reset sync state; labels belong to the guest and survive
+    context_dma_semaphore = RSX_CONTEXT_DMA_SEMAPHORE_RW;
+    context_dma_report = RSX_CONTEXT_DMA_REPORT_LOCATION_LOCAL;
+    context_dma_notifies = RSX_CONTEXT_DMA_NOTIFY_MAIN_0;
+    semaphore_offset = 0;
+    back_end_semaphore_offset = 0;
+    zpass_enabled = false;
     
     // Clear texture units
     for (auto& texture : texture_units) {
@@ -163,7 +325,13 @@ void RSXCore::reset_graphics_state() {
 
 void RSXCore::start_command_processor() {
     if (!command_processor_running) {
+        fifo_get = 0;
+        fifo_put = 0;
+        fifo_return = 0;
+        sync.resume();
         command_processor_running = true;
+        raster_thread = std::thread(&RSXCore::raster_stage_loop, this);
+        state_thread = std::thread(&RSXCore::state_stage_loop, this);
         command_processor_thread = std::thread(&RSXCore::command_processor_loop, this);
         logger->debug("Command processor started");
     }
@@ -172,9 +340,21 @@ void RSXCore::start_command_processor() {
 void RSXCore::stop_command_processor() {
     if (command_processor_running) {
         command_processor_running = false;
+        fifo_doorbell.fetch_add(1, std::memory_order_release);
+        fifo_doorbell.notify_all();
+        // A semaphore acquire may be holding the state stage
+        sync.abort_waits();
+        
+        // Each stage forwards the stop to the next one as it exits
         if (command_processor_thread.joinable()) {
             command_processor_thread.join();
         }
+        if (state_thread.joinable()) {
+            state_thread.join();
+        }
+        if (raster_thread.joinable()) {
+            raster_thread.join();
+        }
         logger->debug("Command processor stopped");
     }
 }
@@ -182,34 +362,274 @@ void RSXCore::stop_command_processor() {
 void RSXCore::command_processor_loop() {
     logger->debug("Command processor loop started");
     
-    while (command_processor_running) {
-        // Process pending commands
-        process_command_buffer();
-        
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    while (command_processor_running.load(std::memory_order_acquire)) {
+        uint32_t doorbell = fifo_doorbell.load(std::memory_order_acquire);
+        if (fifo_get.load(std::memory_order_relaxed) == fifo_put.load(std::memory_order_acquire) ||
+            !process_command_buffer()) {
+            // Sleep until push_commands() or stop rings the doorbell
+            fifo_doorbell.wait(doorbell, std::memory_order_acquire);
+        }
     }
     
+    method_queue.push({ RSX_PIPELINE_STOP, 0 });
     logger->debug("Command processor loop ended");
 }
 
-void RSXCore::process_command_buffer() {
-    // This would normally process GPU commands from the command buffer
-    // For now, we'll implement basic command processing
+bool RSXCore::process_command_buffer() {
+    const uint32_t size = static_cast<uint32_t>(command_buffer.size());
+    const uint8_t* fifo = command_buffer.data();
+    const uint32_t start = fifo_get.load(std::memory_order_relaxed);
+    const uint64_t start_ns = RSXPerfMonitor::now_ns();
+    uint32_t get = start;
+    uint32_t put = fifo_put.load(std::memory_order_acquire);
+    uint64_t consumed = 0;
+    
+    auto read_word = [&](uint32_t offset) {
+        uint32_t word;
+        std::memcpy(&word, fifo + offset, sizeof(word));
+        return word;
+    };
+    
+    while (get != put) {
+        uint32_t cmd = read_word(get);
+        uint32_t cmd_bytes = 4;
+        
+        if ((cmd & RSX_FIFO_OLD_JUMP_MASK) == RSX_FIFO_OLD_JUMP) {
+            get = cmd & RSX_FIFO_OLD_JUMP_OFFSET;
+        } else if ((cmd & 0x3) == RSX_FIFO_NEW_JUMP) {
+            get = cmd & ~0x3u;
+        } else if ((cmd & 0x3) == RSX_FIFO_CALL) {
+            fifo_return = get + 4;
+            get = cmd & ~0x3u;
+        } else if (cmd == RSX_FIFO_RETURN) {
+            get = fifo_return;
+        } else {
+            uint32_t count = (cmd >> 18) & 0x7FF;
+            uint32_t method = cmd & RSX_FIFO_METHOD_MASK;
+            uint32_t step = (cmd & RSX_FIFO_NON_INCREMENT) ? 0 : 4;
+            uint64_t end = static_cast<uint64_t>(get) + 4 + static_cast<uint64_t>(count) * 4;
+            if (end > size) {
+                logger->error("FIFO command at 0x{:08X} runs past the command buffer", get);
+                end = put;
+                count = 0;
+            }
+            if (get < put && end > put) {
+                // Arguments not pushed yet
+                break;
+            }
+            
+            // Bounded queue: blocks while the state stage is behind
+            for (uint32_t i = 0; i < count; i++) {
+                method_queue.push({ method + i * step, read_word(get + 4 + i * 4) });
+            }
+            methods_parsed.fetch_add(count, std::memory_order_relaxed);
+            cmd_bytes = static_cast<uint32_t>(end - get);
+            get = static_cast<uint32_t>(end);
+        }
+        consumed += cmd_bytes;
+        
+        if (get >= size) {
+            logger->error("FIFO jump out of range: 0x{:08X}", get);
+            get = put;
+        }
+        // Publishing get also publishes methods_parsed to wait_for_idle()
+        fifo_get.store(get, std::memory_order_release);
+        fifo_get.notify_all();
+    }
+    
+    if (consumed != 0) {
+        perf.add(RSX_PERF_FIFO_BYTES, consumed);
+        perf.end_span(RSX_PERF_STAGE_PARSE, "fifo", start_ns, "bytes", consumed);
+    }
+    return get != start;
+}
+
+bool RSXCore::push_commands(const uint32_t* words, uint32_t count) {
+    if (count == 0) {
+        return true;
+    }
+    
+    const uint32_t size = static_cast<uint32_t>(command_buffer.size());
+    uint64_t bytes = static_cast<uint64_t>(count) * 4;
+    if (!command_buffer.data() || bytes + 4 > size / 2) {
+        logger->error("FIFO push of {} words does not fit the command buffer", count);
+        return false;
+    }
     
-    // Check for pending commands in the buffer
-    // In a real implementation, this would parse GPU command streams
-    // and execute graphics operations
+    auto wait_for_get = [&](auto ready) {
+        for (uint32_t get = fifo_get.load(std::memory_order_acquire); !ready(get);
+             get = fifo_get.load(std::memory_order_acquire)) {
+            fifo_get.wait(get, std::memory_order_acquire);
+        }
+    };
+    
+    uint32_t put = fifo_put.load(std::memory_order_relaxed);
+    if (put + bytes + 4 > size) {
+        // Wrap: once the parser has caught up, leave it a jump to the start.
+        // The old tail lies beyond anything written at the start before the
+        // parser takes the jump, since no push exceeds half the buffer.
+        wait_for_get([&](uint32_t get) { return get == put; });
+        uint32_t jump = RSX_FIFO_NEW_JUMP;
+        std::memcpy(command_buffer.data() + put, &jump, sizeof(jump));
+        put = 0;
+    } else {
+        // Never overwrite words the parser has not consumed
+        wait_for_get([&](uint32_t get) { return get <= put || put + bytes < get; });
+    }
+    
+    std::memcpy(command_buffer.data() + put, words, bytes);
+    fifo_put.store(put + static_cast<uint32_t>(bytes), std::memory_order_release);
+    fifo_doorbell.fetch_add(1, std::memory_order_release);
+    fifo_doorbell.notify_one();
+    return true;
+}
+
+void RSXCore::state_stage_loop() {
+    RSXMethodPacket packets[RSX_STATE_BATCH];
+    bool stopping = false;
+    
+    while (!stopping) {
+        size_t count = method_queue.pop_batch(packets, RSX_STATE_BATCH);
+        size_t executed = 0;
+        uint64_t start_ns = RSXPerfMonitor::now_ns();
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            for (; executed < count; executed++) {
+                if (packets[executed].method == RSX_PIPELINE_STOP) {
+                    stopping = true;
+                    break;
+                }
+                dispatch_method(packets[executed].method, packets[executed].arg);
+            }
+            perf.add(RSX_PERF_METHODS, executed);
+        }
+        if (executed != 0) {
+            perf.end_span(RSX_PERF_STAGE_STATE, "methods", start_ns, "count", executed);
+        }
+        methods_executed.fetch_add(executed, std::memory_order_release);
+        methods_executed.notify_all();
+    }
+    
+    draw_queue.push(nullptr);
+}
+
+void RSXCore::raster_stage_loop() {
+    for (RSXDrawPacket* packet = draw_queue.pop(); packet; packet = draw_queue.pop()) {
+        execute_packet(*packet);
+        free_packets.push(packet);
+        draws_retired.fetch_add(1, std::memory_order_release);
+        draws_retired.notify_all();
+    }
 }
 
 void RSXCore::execute_method(uint32_t method, uint32_t arg) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    perf.add(RSX_PERF_METHODS, 1);
+    dispatch_method(method, arg);
+}
+
+void RSXCore::dispatch_method(uint32_t method, uint32_t arg) {
+    // SET_BEGIN_END is recorded after the draws it ends, behind the memory they read
+    if (capture && method != RSX_NV4097_SET_BEGIN_END) {
+        capture->write_method(method, arg);
+    }
+    
+    // Method ranges that stream data words
+    if (method >= RSX_NV4097_SET_TRANSFORM_PROGRAM &&
+        method < RSX_NV4097_SET_TRANSFORM_PROGRAM + RSX_METHOD_BATCH_WORDS * 4) {
+        upload_transform_program_word(arg);
+        return;
+    }
+    if (method >= RSX_NV4097_SET_TRANSFORM_CONSTANT &&
+        method < RSX_NV4097_SET_TRANSFORM_CONSTANT + RSX_METHOD_BATCH_WORDS * 4) {
+        upload_transform_constant_word(arg);
+        return;
+    }
+    
     switch (method) {
         case RSX_NV4097_NO_OPERATION:
             // No operation - do nothing
             break;
             
         case RSX_NV4097_WAIT_FOR_IDLE:
-            wait_for_idle();
+            // Runs inside the pipeline, so only the stage behind it can drain
+            drain_rasterizer();
+            break;
+            
+        case RSX_NV4097_NOTIFY:
+            queue_back_end(RSXPacketType::NOTIFY, 0, 0, 0);
+            break;
+            
+        case RSX_NV4097_SET_CONTEXT_DMA_NOTIFIES:
+            context_dma_notifies = arg;
+            break;
+            
+        case RSX_NV406E_SET_CONTEXT_DMA_SEMAPHORE:
+        case RSX_NV4097_SET_CONTEXT_DMA_SEMAPHORE:
+            if (arg != RSX_CONTEXT_DMA_SEMAPHORE_RW && arg != RSX_CONTEXT_DMA_SEMAPHORE_R) {
+                logger->warn("Unknown semaphore context DMA: 0x{:08X}", arg);
+            }
+            context_dma_semaphore = arg;
+            break;
+            
+        case RSX_NV4097_SET_CONTEXT_DMA_REPORT:
+            if (arg != RSX_CONTEXT_DMA_REPORT_LOCATION_LOCAL && arg != RSX_CONTEXT_DMA_REPORT_LOCATION_MAIN) {
+                logger->warn("Unknown report context DMA: 0x{:08X}", arg);
+            }
+            context_dma_report = arg;
+            break;
+            
+        case RSX_NV406E_SET_REFERENCE:
+            // Front end: earlier methods have been applied, not necessarily rasterized
+            sync.set_reference(arg);
+            break;
+            
+        case RSX_NV406E_SEMAPHORE_OFFSET:
+            semaphore_offset = arg;
+            break;
+            
+        case RSX_NV406E_SEMAPHORE_ACQUIRE:
+            // Stalls the state stage, and direct calls behind state_mutex,
+            // until the PPU or a back-end release writes the value
+            if (!sync.wait_label(semaphore_offset / RSX_LABEL_STRIDE, arg)) {
+                logger->debug("Semaphore acquire at 0x{:X} abandoned on stop", semaphore_offset);
+            }
+            break;
+            
+        case RSX_NV406E_SEMAPHORE_RELEASE:
+            sync.write_label(semaphore_offset / RSX_LABEL_STRIDE, arg);
+            break;
+            
+        case RSX_NV4097_SET_SEMAPHORE_OFFSET:
+            back_end_semaphore_offset = arg;
+            break;
+            
+        case RSX_NV4097_BACK_END_WRITE_SEMAPHORE_RELEASE:
+        case RSX_NV4097_TEXTURE_READ_SEMAPHORE_RELEASE:
+            // Written once every earlier draw has been rasterized
+            queue_back_end(RSXPacketType::RELEASE, back_end_semaphore_offset / RSX_LABEL_STRIDE, arg, 0);
+            break;
+            
+        case RSX_NV4097_SET_ZPASS_PIXEL_COUNT_ENABLE:
+            zpass_enabled = arg != 0;
+            break;
+            
+        case RSX_NV4097_CLEAR_REPORT_VALUE:
+            queue_back_end(RSXPacketType::CLEAR_REPORT, arg, 0, 0);
+            break;
+            
+        case RSX_NV4097_GET_REPORT: {
+            // [31:24] RSXReportType, [23:0] offset in the report context DMA
+            queue_back_end(RSXPacketType::REPORT, arg >> 24, 0, arg & 0xFFFFFF);
+            break;
+        }
+            
+        case RSX_NV4097_SET_SURFACE_CLIP_HORIZONTAL:
+            surface_clip_horizontal = arg;
+            break;
+            
+        case RSX_NV4097_SET_SURFACE_CLIP_VERTICAL:
+            surface_clip_vertical = arg;
             break;
             
         case RSX_NV4097_SET_SURFACE_FORMAT:
@@ -256,19 +676,233 @@ void RSXCore::execute_method(uint32_t method, uint32_t arg) {
             set_depth_range_far(arg);
             break;
             
+        case RSX_NV4097_SET_RESTART_INDEX_ENABLE:
+            set_restart_index_enable(arg);
+            break;
+            
+        case RSX_NV4097_SET_RESTART_INDEX:
+            set_restart_index(arg);
+            break;
+            
+        case RSX_NV4097_SET_SHADER_PROGRAM:
+            set_shader_program(arg);
+            break;
+            
+        case RSX_NV4097_SET_TRANSFORM_PROGRAM_LOAD:
+            set_transform_program_load(arg);
+            break;
+            
+        case RSX_NV4097_SET_TRANSFORM_PROGRAM_START:
+            set_transform_program_start(arg);
+            break;
+            
+        case RSX_NV4097_SET_TRANSFORM_CONSTANT_LOAD:
+            set_transform_constant_load(arg);
+            break;
+            
+        case RSX_NV4097_SET_BEGIN_END:
+            if (arg != 0) {
+                draw_mode = arg;
+                draw_ranges.clear();
+            } else {
+                end_draw();
+            }
+            if (capture) {
+                capture->write_method(method, arg);
+            }
+            break;
+            
+        case RSX_NV4097_DRAW_ARRAYS:
+        case RSX_NV4097_DRAW_INDEX_ARRAY: {
+            // [23:0] first, [31:24] count - 1; adjacent ranges merge into one draw
+            uint32_t first = arg & 0xFFFFFF;
+            uint32_t count = (arg >> 24) + 1;
+            draw_indexed = method == RSX_NV4097_DRAW_INDEX_ARRAY;
+            if (!draw_ranges.empty() && draw_ranges.back().first + draw_ranges.back().second == first) {
+                draw_ranges.back().second += count;
+            } else {
+                draw_ranges.emplace_back(first, count);
+            }
+            break;
+        }
+            
+        case RSX_NV4097_SET_INDEX_ARRAY_ADDRESS:
+            index_array_offset = arg;
+            break;
+            
+        case RSX_NV4097_SET_INDEX_ARRAY_DMA:
+            index_array_dma = arg;
+            break;
+            
         default:
             logger->warn("Unknown RSX method: 0x{:04X} with arg 0x{:08X}", method, arg);
             break;
     }
 }
 
+void RSXCore::end_draw() {
+    // Index array DMA: [3:0] location (0 = local VRAM, 1 = main memory), [7:4] RSXIndexType
+    uint32_t index_type = (index_array_dma >> 4) & 0xF;
+    uint64_t index_base = ((index_array_dma & 0xF) == 0 ? vram_base : ioif_base) + index_array_offset;
+    
+    for (const auto& range : draw_ranges) {
+        if (draw_indexed) {
+            uint64_t address = index_base + static_cast<uint64_t>(range.first) * RSXIndexFetcher::get_index_size(index_type);
+            execute_draw_elements(draw_mode, range.second, index_type, address);
+        } else {
+            execute_draw_arrays(draw_mode, range.first, range.second);
+        }
+    }
+    draw_ranges.clear();
+}
+
+// Block until `counter` reaches `target`
+static void wait_for_count(std::atomic<uint64_t>& counter, uint64_t target) {
+    for (uint64_t value = counter.load(std::memory_order_acquire); value < target;
+         value = counter.load(std::memory_order_acquire)) {
+        counter.wait(value, std::memory_order_acquire);
+    }
+}
+
+void RSXCore::drain_rasterizer() {
+    wait_for_count(draws_retired, draws_queued.load(std::memory_order_acquire));
+}
+
+void RSXCore::queue_packet(RSXDrawPacket* packet) {
+    draws_queued.fetch_add(1, std::memory_order_release);
+    if (command_processor_running) {
+        draw_queue.push(packet);
+    } else {
+        // No pipeline threads: execute on the caller's thread
+        execute_packet(*packet);
+        free_packets.push(packet);
+        draws_retired.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void RSXCore::queue_back_end(RSXPacketType type, uint32_t label, uint32_t value, uint32_t report_offset) {
+    RSXDrawPacket* packet = free_packets.pop();
+    packet->type = type;
+    packet->label = label;
+    packet->value = value;
+    packet->report_dma = context_dma_report;
+    packet->report_offset = report_offset;
+    queue_packet(packet);
+}
+
+void RSXCore::execute_packet(RSXDrawPacket& packet) {
+    uint64_t start_ns = RSXPerfMonitor::now_ns();
+    switch (packet.type) {
+        case RSXPacketType::DRAW: {
+            uint64_t before = rasterizer.get_pixels();
+            rasterizer.draw(packet, fragment_program_cache);
+            packet.surface->dirty.store(true, std::memory_order_release);
+            uint64_t shaded = rasterizer.get_pixels() - before;
+            // No depth test yet: every shaded pixel passes
+            if (packet.count_zpass) {
+                zpass_pixels += shaded;
+            }
+            perf.add(RSX_PERF_FRAGMENTS, shaded);
+            perf.end_span(RSX_PERF_STAGE_RASTER, "draw", start_ns, "fragments", shaded);
+            break;
+        }
+        case RSXPacketType::RELEASE:
+            sync.write_label(packet.label, packet.value);
+            perf.end_span(RSX_PERF_STAGE_RASTER, "release", start_ns, "label", packet.label);
+            break;
+        case RSXPacketType::REPORT: {
+            // Translated now, so the record lands where the IO table maps it
+            // when written rather than when the report was requested
+            RSXIOTable::ReadSection io_section(io_table);
+            uint8_t* dst = resolve_report(packet.report_dma, packet.report_offset);
+            if (dst) {
+                write_report(dst, packet.label);
+            }
+            perf.end_span(RSX_PERF_STAGE_RASTER, "report", start_ns, "type", packet.label);
+            break;
+        }
+        case RSXPacketType::CLEAR_REPORT:
+            if (packet.label == RSX_REPORT_ZPASS_PIXEL_CNT) {
+                zpass_pixels = 0;
+            }
+            perf.end_span(RSX_PERF_STAGE_RASTER, "clear_report", start_ns, "type", packet.label);
+            break;
+        case RSXPacketType::NOTIFY:
+            sync.notify(0);
+            perf.end_span(RSX_PERF_STAGE_RASTER, "notify", start_ns);
+            break;
+    }
+    packet.io_pin.release();
+}
+
+uint8_t* RSXCore::resolve_report(uint32_t dma, uint32_t offset) {
+    // Main memory through the IO table; callers hold an io_table.ReadSection across the write
+    if (dma == RSX_CONTEXT_DMA_REPORT_LOCATION_MAIN) {
+        size_t available = 0;
+        const uint8_t* dst = resolve_address(ioif_base + offset, &available);
+        if (dst && available >= RSX_REPORT_SIZE) {
+            return const_cast<uint8_t*>(dst);
+        }
+    } else if (offset <= RSX_REPORT_AREA_SIZE - RSX_REPORT_SIZE) {
+        return get_vram_ptr(RSX_REPORT_AREA_OFFSET + offset);
+    }
+    logger->warn("Report offset out of range: 0x{:06X} (context DMA 0x{:08X})", offset, dma);
+    return nullptr;
+}
+
+void RSXCore::write_report(uint8_t* dst, uint32_t type) {
+    // Zcull is not emulated, so its statistics read as zero
+    uint32_t value = 0;
+    if (type == RSX_REPORT_ZPASS_PIXEL_CNT) {
+        value = static_cast<uint32_t>(std::min<uint64_t>(zpass_pixels, UINT32_MAX));
+    } else if (type < RSX_REPORT_ZCULL_STATS || type > RSX_REPORT_ZCULL_STATS3) {
+        logger->warn("Unknown report type {}", type);
+    }
+    
+    // Big-endian { u64 timestamp, u32 value, u32 padding }
+    uint64_t timestamp = sync.get_timestamp();
+    for (int i = 0; i < 8; i++) {
+        dst[i] = static_cast<uint8_t>(timestamp >> (56 - i * 8));
+    }
+    for (int i = 0; i < 4; i++) {
+        dst[8 + i] = static_cast<uint8_t>(value >> (24 - i * 8));
+        dst[12 + i] = 0;
+    }
+    sync.signal();
+}
+
+bool RSXCore::read_report(uint32_t offset, uint64_t& timestamp, uint32_t& value) const {
+    const uint8_t* src = offset <= RSX_REPORT_AREA_SIZE - RSX_REPORT_SIZE
+        ? get_vram_ptr(RSX_REPORT_AREA_OFFSET + offset) : nullptr;
+    if (!src) {
+        return false;
+    }
+    timestamp = 0;
+    value = 0;
+    for (int i = 0; i < 8; i++) {
+        timestamp = (timestamp << 8) | src[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | src[8 + i];
+    }
+    return true;
+}
+
 void RSXCore::wait_for_idle() {
-    // Wait for all pending GPU operations to complete
-    logger->debug("RSX wait for idle");
+    if (command_processor_running) {
+        // Parse stage: everything pushed so far has been consumed
+        uint32_t put = fifo_put.load(std::memory_order_acquire);
+        for (uint32_t get = fifo_get.load(std::memory_order_acquire); get != put;
+             get = fifo_get.load(std::memory_order_acquire)) {
+            fifo_get.wait(get, std::memory_order_acquire);
+        }
+        
+        // State stage: every parsed method applied
+        wait_for_count(methods_executed, methods_parsed.load(std::memory_order_acquire));
+    }
     
-    // In a real implementation, this would wait for the GPU pipeline to drain
-    // For now, we'll just add a small delay
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    // Raster stage: every queued draw shaded
+    drain_rasterizer();
 }
 
 void RSXCore::set_surface_format(uint32_t format) {
@@ -360,49 +994,408 @@ void RSXCore::set_depth_range_far(uint32_t value) {
     logger->debug("Set depth range far: {}", depth_range_far);
 }
 
+// Triangles produced by `count` vertices of a primitive; lines and points count none
+static uint64_t count_triangles(uint32_t mode, uint32_t count) {
+    switch (mode) {
+        case RSX_PRIMITIVE_TRIANGLES:
+            return count / 3;
+        case RSX_PRIMITIVE_TRIANGLE_STRIP:
+        case RSX_PRIMITIVE_TRIANGLE_FAN:
+        case RSX_PRIMITIVE_POLYGON:
+            return count >= 3 ? count - 2 : 0;
+        case RSX_PRIMITIVE_QUADS:
+            return (count / 4) * 2;
+        case RSX_PRIMITIVE_QUAD_STRIP:
+            return count >= 4 ? ((count - 2) / 2) * 2 : 0;
+        default:
+            return 0;
+    }
+}
+
 void RSXCore::draw_arrays(uint32_t mode, uint32_t first, uint32_t count) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    execute_draw_arrays(mode, first, count);
+    // Recorded after the memory the draw read
+    if (capture) {
+        capture->write_draw_arrays(mode, first, count);
+    }
+}
+
+void RSXCore::draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t indices_addr) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    execute_draw_elements(mode, count, type, indices_addr);
+    if (capture) {
+        capture->write_draw_elements(mode, count, type, indices_addr);
+    }
+}
+
+void RSXCore::execute_draw_arrays(uint32_t mode, uint32_t first, uint32_t count) {
     logger->debug("Draw arrays: mode={}, first={}, count={}", mode, first, count);
+    RSXIOTable::ReadSection io_section(io_table);
+    
+    draw_calls++;
+    perf.add(RSX_PERF_DRAWS, 1);
+    triangles_rendered += count_triangles(mode, count);
+    
+    if (!fetch_vertex_attributes(first, count)) {
+        return;
+    }
+    
+    if (!run_vertex_program(nullptr, count)) {
+        return;
+    }
     
-    // In a real implementation, this would:
-    // 1. Set up vertex processing pipeline
-    // 2. Process vertices through vertex shader
-    // 3. Perform primitive assembly
-    // 4. Run fragment shader
-    // 5. Perform depth/stencil testing
-    // 6. Write to framebuffer
+    prepare_fragment_program();
+    submit_draw(io_section, mode, count, nullptr);
 }
 
-void RSXCore::draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t indices_addr) {
+void RSXCore::execute_draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t indices_addr) {
     logger->debug("Draw elements: mode={}, count={}, type={}, indices=0x{:016X}",
                  mode, count, type, indices_addr);
+    RSXIOTable::ReadSection io_section(io_table);
+    
+    size_t available = 0;
+    size_t index_bytes = static_cast<size_t>(count) * (type == RSX_INDEX_TYPE_16 ? 2 : 4);
+    flush_surfaces_at(indices_addr, index_bytes);
+    const uint8_t* src = resolve_address(indices_addr, &available);
+    capture_memory(indices_addr, src, std::min(available, index_bytes));
+    
+    RSXIndexRange range;
+    if (!index_fetcher.fetch(src, available, count, type, restart_index_enabled, restart_index,
+                             index_buffer, range)) {
+        logger->error("Index fetch failed: type={}, count={}, indices=0x{:016X}", type, count, indices_addr);
+        return;
+    }
+    
+    draw_calls++;
+    perf.add(RSX_PERF_DRAWS, 1);
+    if (!range.valid()) {
+        // Every index was a restart; nothing to draw
+        return;
+    }
+    triangles_rendered += count_triangles(mode, count);
+    
+    // Fetch only the referenced vertex range
+    if (!fetch_vertex_attributes(range.min_index, range.vertex_count())) {
+        return;
+    }
     
-    // Similar to draw_arrays but with indexed rendering
+    // Each distinct index gets one post-transform slot
+    vertex_cache.build(index_buffer, range);
+    
+    logger->debug("Draw elements: range=[{}, {}], unique vertices={}",
+                 range.min_index, range.max_index, vertex_cache.get_unique_vertices().size());
+    
+    const std::vector<uint32_t>& unique = vertex_cache.get_unique_vertices();
+    if (!run_vertex_program(unique.data(), static_cast<uint32_t>(unique.size()))) {
+        return;
+    }
+    
+    prepare_fragment_program();
+    submit_draw(io_section, mode, static_cast<uint32_t>(unique.size()), &vertex_cache.get_remapped_indices());
+}
+
+void RSXCore::submit_draw(const RSXIOTable::ReadSection& io_section, uint32_t mode, uint32_t vertex_count,
+                          const std::vector<uint32_t>* indices) {
+    uint32_t color_pitch = current_surface_pitch & 0xFFFF;
+    uint32_t width = surface_clip_horizontal >> 16;
+    uint32_t height = surface_clip_vertical >> 16;
+    uint8_t* color = get_vram_ptr(current_color_offset);
+    if (!current_fragment_program || !color || color_pitch == 0 || width == 0 || height == 0) {
+        return;
+    }
+    // Keep every row inside VRAM
+    height = static_cast<uint32_t>(std::min<uint64_t>(height, (vram.size() - current_color_offset) / color_pitch));
+    uint32_t bpp = get_surface_bytes_per_pixel(current_surface_format & 0x1F);
+    RSXSurface* surface = bind_color_surface(current_color_offset, color_pitch, current_surface_format & 0x1F,
+                                             bpp, height);
+    
+    // Blocks while RSX_DRAW_QUEUE_SIZE packets are waiting to be rasterized
+    RSXDrawPacket* packet = free_packets.pop();
+    packet->type = RSXPacketType::DRAW;
+    packet->count_zpass = zpass_enabled;
+    packet->mode = mode;
+    packet->vertex_count = vertex_count;
+    packet->outputs.swap(vertex_outputs);
+    if (indices) {
+        packet->indices.assign(indices->begin(), indices->end());
+    } else {
+        packet->indices.clear();
+    }
+    
+    packet->fragment_program = current_fragment_program;
+    packet->fragment_constants.assign(fragment_microcode.begin(), fragment_microcode.end());
+    std::copy(fragment_samplers.begin(), fragment_samplers.end(), packet->samplers);
+    alias_textures(*packet);
+    
+    // Samplers left pointing into main memory were translated under this
+    // section; the raster stage reads them later, so unmap() must wait
+    for (const RSXSamplerState& state : packet->samplers) {
+        if (state.data && (state.data < vram.data() || state.data >= vram.data() + vram.size())) {
+            packet->io_pin.acquire(io_section);
+            break;
+        }
+    }
+    packet->surface = surface;
+    packet->color = surface->data.data();
+    packet->color_pitch = color_pitch;
+    packet->color_bpp = bpp;
+    packet->surface_width = std::min(width, color_pitch / bpp);
+    packet->surface_height = height;
+    
+    packet->viewport_x = static_cast<float>(viewport_x);
+    packet->viewport_y = static_cast<float>(viewport_y);
+    packet->viewport_width = static_cast<float>(viewport_width);
+    packet->viewport_height = static_cast<float>(viewport_height);
+    packet->depth_near = depth_range_near;
+    packet->depth_far = depth_range_far;
+    
+    queue_packet(packet);
+}
+
+void RSXCore::set_restart_index_enable(uint32_t enable) {
+    restart_index_enabled = enable != 0;
+    logger->debug("Set restart index enable: {}", restart_index_enabled);
+}
+
+void RSXCore::set_restart_index(uint32_t index) {
+    restart_index = index;
+    logger->debug("Set restart index: 0x{:08X}", index);
 }
 
 void RSXCore::set_texture(uint32_t unit, const RSXTexture& texture) {
+    std::lock_guard<std::mutex> lock(state_mutex);
     if (unit < RSX_MAX_TEXTURES) {
         texture_units[unit] = texture;
+        if (capture) {
+            capture->write_texture(unit, texture);
+        }
         logger->debug("Set texture unit {}: {}x{}, format={}",
                      unit, texture.width, texture.height, texture.format);
     }
 }
 
 void RSXCore::set_vertex_attribute(uint32_t index, const RSXVertexAttribute& attribute) {
+    std::lock_guard<std::mutex> lock(state_mutex);
     if (index < RSX_MAX_VERTEX_ATTRIBUTES) {
         vertex_attributes[index] = attribute;
+        if (capture) {
+            capture->write_vertex_attribute(index, attribute);
+        }
         logger->debug("Set vertex attribute {}: size={}, type={}, stride={}",
                      index, attribute.size, attribute.type, attribute.stride);
     }
 }
 
 void RSXCore::set_render_target(uint32_t index, const RSXRenderTarget& target) {
+    std::lock_guard<std::mutex> lock(state_mutex);
     if (index < RSX_MAX_RENDER_TARGETS) {
         render_targets[index] = target;
+        if (capture) {
+            capture->write_render_target(index, target);
+        }
         logger->debug("Set render target {}: {}x{}, format={}",
                      index, target.width, target.height, target.format);
     }
 }
 
+void RSXCore::set_vertex_program(const RSXShaderProgram& program) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    load_vertex_program(program);
+    if (capture) {
+        capture->write_program(RSXCaptureRecord::VERTEX_PROGRAM, program);
+    }
+}
+
+void RSXCore::load_vertex_program(const RSXShaderProgram& program) {
+    vertex_program = program;
+    if (!program.enabled) {
+        return;
+    }
+    
+    RSXIOTable::ReadSection io_section(io_table);
+    size_t available = 0;
+    const uint8_t* src = resolve_address(program.address, &available);
+    uint32_t words = std::min<uint32_t>(program.size / 4, RSX_VP_MAX_INSTRUCTIONS * 4);
+    if (!src || available < static_cast<size_t>(words) * 4) {
+        logger->error("Vertex program out of bounds: address=0x{:016X}, size={}", program.address, program.size);
+        return;
+    }
+    capture_memory(program.address, src, static_cast<size_t>(words) * 4);
+    
+    // Microcode in memory is big-endian
+    for (uint32_t i = 0; i < words; i++) {
+        const uint8_t* p = src + i * 4;
+        transform_program[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+    transform_program_start = 0;
+    transform_program_dirty = true;
+    
+    logger->debug("Set vertex program: address=0x{:016X}, {} instructions", program.address, words / 4);
+}
+
+void RSXCore::set_fragment_program(const RSXShaderProgram& program) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    fragment_program = program;
+    if (capture) {
+        capture->write_program(RSXCaptureRecord::FRAGMENT_PROGRAM, program);
+    }
+    logger->debug("Set fragment program: address=0x{:016X}, enabled={}", program.address, program.enabled);
+}
+
+void RSXCore::set_shader_program(uint32_t value) {
+    // Bits 0-1 select the location (1 = local VRAM, 2 = main memory)
+    uint32_t location = value & 0x3;
+    uint32_t offset = value & ~0x3u;
+    
+    RSXShaderProgram program;
+    program.address = (location == 1 ? vram_base : ioif_base) + offset;
+    program.type = 1;
+    program.enabled = true;
+    
+    // The method itself is captured; don't record the program twice
+    fragment_program = program;
+    logger->debug("Set fragment program: address=0x{:016X}, enabled={}", program.address, program.enabled);
+}
+
+const RSXFragmentProgram* RSXCore::prepare_fragment_program() {
+    current_fragment_program = nullptr;
+    if (!fragment_program.enabled) {
+        return nullptr;
+    }
+    
+    // Microcode is re-read every draw: programs patch their inline constants in place
+    RSXIOTable::ReadSection io_section(io_table);
+    size_t available = 0;
+    const uint8_t* src = resolve_address(fragment_program.address, &available);
+    if (!RSXFragmentProgramCache::load_microcode(src, available, fragment_microcode)) {
+        logger->error("Fragment program has no end instruction: address=0x{:016X}", fragment_program.address);
+        return nullptr;
+    }
+    capture_memory(fragment_program.address, src, fragment_microcode.size() * 4);
+    
+    uint32_t texture_formats[RSX_FP_MAX_TEXTURES] = {};
+    for (uint32_t unit = 0; unit < RSX_FP_MAX_TEXTURES; unit++) {
+        if (texture_units[unit].enabled) {
+            texture_formats[unit] = RSXTextureSampler::get_base_format(texture_units[unit].format);
+        }
+    }
+    
+    current_fragment_program = fragment_program_cache.get(fragment_microcode, texture_formats,
+                                                          current_surface_format & 0x1F);
+    if (!current_fragment_program) {
+        return nullptr;
+    }
+    
+    for (uint32_t unit = 0; unit < RSX_FP_MAX_TEXTURES; unit++) {
+        RSXSamplerState& state = fragment_samplers[unit];
+        state = RSXSamplerState();
+        
+        const RSXTexture& texture = texture_units[unit];
+        if (!(current_fragment_program->texture_mask & (1u << unit)) || !texture.enabled) {
+            continue;
+        }
+        
+        state.data = resolve_address(texture.address, &state.available);
+        if (capture) {
+            // Record rendered pixels, not the VRAM under a cached surface
+            flush_surfaces_at(texture.address, get_texture_span(texture));
+            capture_memory(texture.address, state.data, std::min(state.available, get_texture_span(texture)));
+        }
+        state.width = texture.width;
+        state.height = texture.height;
+        state.pitch = texture.pitch;
+        state.linear = (texture.format & RSX_TEXTURE_FORMAT_LN) != 0;
+        state.unnormalized = (texture.format & RSX_TEXTURE_FORMAT_UN) != 0;
+    }
+    
+    return current_fragment_program;
+}
+
+void RSXCore::shade_fragments(RSXFragmentBatch& batch) {
+    if (!current_fragment_program) {
+        return;
+    }
+    
+    batch.samplers = fragment_samplers.data();
+    fragment_program_cache.execute(*current_fragment_program, batch, fragment_microcode.data());
+}
+
+void RSXCore::set_transform_program_load(uint32_t slot) {
+    transform_program_word = (slot % RSX_VP_MAX_INSTRUCTIONS) * 4;
+}
+
+void RSXCore::set_transform_program_start(uint32_t slot) {
+    transform_program_start = slot % RSX_VP_MAX_INSTRUCTIONS;
+    transform_program_dirty = true;
+}
+
+void RSXCore::set_transform_constant_load(uint32_t index) {
+    transform_constant_word = (index % RSX_VP_MAX_CONSTANTS) * 4;
+}
+
+void RSXCore::upload_transform_program_word(uint32_t word) {
+    transform_program[transform_program_word] = word;
+    transform_program_word = (transform_program_word + 1) % transform_program.size();
+    transform_program_dirty = true;
+}
+
+void RSXCore::upload_transform_constant_word(uint32_t word) {
+    std::memcpy(&transform_constants[transform_constant_word], &word, sizeof(float));
+    transform_constant_word = (transform_constant_word + 1) % transform_constants.size();
+}
+
+bool RSXCore::run_vertex_program(const uint32_t* vertices, uint32_t count) {
+    if (transform_program_dirty) {
+        current_vertex_program = vertex_program_cache.get(transform_program.data(), transform_program_start);
+        transform_program_dirty = false;
+    }
+    if (!current_vertex_program) {
+        logger->error("No valid vertex program at slot {}", transform_program_start);
+        return false;
+    }
+    
+    for (auto& output : vertex_outputs) {
+        output.resize(count);
+    }
+    
+    RSXVertexBatch& batch = *vertex_batch;
+    for (uint32_t base = 0; base < count; base += RSX_VP_BATCH_SIZE) {
+        uint32_t lanes = std::min(RSX_VP_BATCH_SIZE, count - base);
+        
+        // Gather inputs; fetched streams are already SoA
+        for (uint32_t i = 0; i < RSX_VP_INPUTS; i++) {
+            const RSXVertexStream& stream = vertex_streams[i];
+            for (uint32_t c = 0; c < 4; c++) {
+                float* dst = batch.inputs[i][c];
+                if (stream.count == 0) {
+                    std::fill(dst, dst + RSX_VP_BATCH_SIZE, c == 3 ? 1.0f : 0.0f);
+                } else if (!vertices) {
+                    std::memcpy(dst, stream.components[c].data() + base, RSX_VP_BATCH_SIZE * sizeof(float));
+                } else {
+                    for (uint32_t lane = 0; lane < lanes; lane++) {
+                        dst[lane] = stream.components[c][vertices[base + lane]];
+                    }
+                }
+            }
+        }
+        
+        vertex_program_cache.execute(*current_vertex_program, batch, transform_constants.data(),
+                                     transform_branch_bits, lanes);
+        
+        for (uint32_t o = 0; o < RSX_VP_OUTPUTS; o++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                // Output planes are padded to the batch size
+                std::memcpy(vertex_outputs[o].components[c].data() + base, batch.outputs[o][c],
+                            RSX_VP_BATCH_SIZE * sizeof(float));
+            }
+        }
+    }
+    
+    return true;
+}
+
 uint8_t* RSXCore::get_vram_ptr(uint32_t offset) {
     if (offset < vram.size()) {
         return vram.data() + offset;
@@ -417,22 +1410,720 @@ const uint8_t* RSXCore::get_vram_ptr(uint32_t offset) const {
     return nullptr;
 }
 
+// Copy [offset, offset + size) between VRAM and a linear buffer, split
+// at tile region boundaries; regions never overlap
+template <bool ToVRAM>
+static void copy_vram_range(const RSXTileRegion* regions, uint8_t* vram, uint32_t offset, uint8_t* buffer, uint32_t size) {
+    while (size != 0) {
+        uint32_t chunk = size;
+        const RSXTileRegion* hit = nullptr;
+        for (uint32_t i = 0; i < RSX_MAX_TILES && !hit; i++) {
+            const RSXTileRegion& region = regions[i];
+            if (region.contains(offset)) {
+                hit = &region;
+                chunk = std::min(chunk, region.offset + region.size - offset);
+            } else if (region.enabled && region.offset > offset) {
+                chunk = std::min(chunk, region.offset - offset);
+            }
+        }
+        
+        if (!hit) {
+            ToVRAM ? std::memcpy(vram + offset, buffer, chunk) : std::memcpy(buffer, vram + offset, chunk);
+        } else if (ToVRAM) {
+            rsx_tile_range(*hit, vram + hit->offset, offset - hit->offset, buffer, chunk);
+        } else {
+            rsx_detile_range(*hit, vram + hit->offset, offset - hit->offset, buffer, chunk);
+        }
+        offset += chunk;
+        buffer += chunk;
+        size -= chunk;
+    }
+}
+
+void RSXCore::copy_to_vram(uint32_t offset, const uint8_t* src, uint32_t size) {
+    if (tile_count.load(std::memory_order_acquire) == 0) {
+        std::memcpy(vram.data() + offset, src, size);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(tile_mutex);
+    copy_vram_range<true>(tile_regions, vram.data(), offset, const_cast<uint8_t*>(src), size);
+}
+
+void RSXCore::copy_from_vram(uint32_t offset, uint8_t* dst, uint32_t size) const {
+    if (tile_count.load(std::memory_order_acquire) == 0) {
+        std::memcpy(dst, vram.data() + offset, size);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(tile_mutex);
+    copy_vram_range<false>(tile_regions, const_cast<uint8_t*>(vram.data()), offset, dst, size);
+}
+
 void RSXCore::write_vram(uint32_t offset, const void* data, uint32_t size) {
-    if (offset + size <= vram.size()) {
-        std::memcpy(vram.data() + offset, data, size);
-    } else {
+    if (static_cast<uint64_t>(offset) + size > vram.size()) {
         logger->error("VRAM write out of bounds: offset=0x{:08X}, size=0x{:08X}", offset, size);
+        return;
+    }
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    copy_to_vram(offset, src, size);
+    if (surface_cache.is_empty()) {
+        return;
+    }
+    
+    // Keep cached surfaces coherent with the CPU write
+    std::lock_guard<std::mutex> lock(surface_cache.get_mutex());
+    std::vector<RSXSurface*> overlapping;
+    surface_cache.for_each_overlap(offset, size, [&](RSXSurface& surface) { overlapping.push_back(&surface); });
+    if (overlapping.empty()) {
+        return;
+    }
+    // Queued draws may still render into them
+    drain_rasterizer();
+    for (RSXSurface* surface : overlapping) {
+        uint32_t start = std::max(offset, surface->offset);
+        uint32_t end = std::min(offset + size, surface->offset + surface->get_size());
+        std::memcpy(surface->data.data() + (start - surface->offset), src + (start - offset), end - start);
     }
 }
 
-void RSXCore::read_vram(uint32_t offset, void* data, uint32_t size) const {
-    if (offset + size <= vram.size()) {
-        std::memcpy(data, vram.data() + offset, size);
-    } else {
+void RSXCore::read_vram(uint32_t offset, void* data, uint32_t size) {
+    if (static_cast<uint64_t>(offset) + size > vram.size()) {
         logger->error("VRAM read out of bounds: offset=0x{:08X}, size=0x{:08X}", offset, size);
+        return;
+    }
+    write_back_surfaces(offset, size, true);
+    copy_from_vram(offset, static_cast<uint8_t*>(data), size);
+}
+
+bool RSXCore::set_tile_region(uint32_t index, const RSXTileRegion& region) {
+    if (index >= RSX_MAX_TILES || !region.is_valid() ||
+        static_cast<uint64_t>(region.offset) + region.size > vram.size()) {
+        logger->error("Invalid tile region {}: offset=0x{:08X}, size=0x{:X}, pitch={}, bank={}",
+                      index, region.offset, region.size, region.pitch, region.bank);
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(tile_mutex);
+    for (uint32_t i = 0; i < RSX_MAX_TILES; i++) {
+        const RSXTileRegion& other = tile_regions[i];
+        if (i != index && other.enabled && region.offset < other.offset + other.size &&
+            other.offset < region.offset + region.size) {
+            logger->error("Tile region {} overlaps region {}", index, i);
+            return false;
+        }
+    }
+    if (!tile_regions[index].enabled) {
+        tile_count.fetch_add(1, std::memory_order_release);
+    }
+    tile_regions[index] = region;
+    tile_regions[index].enabled = true;
+    logger->debug("Tile region {}: offset=0x{:08X}, size=0x{:X}, pitch={}, bank={}",
+                  index, region.offset, region.size, region.pitch, region.bank);
+    return true;
+}
+
+void RSXCore::clear_tile_region(uint32_t index) {
+    std::lock_guard<std::mutex> lock(tile_mutex);
+    if (index < RSX_MAX_TILES && tile_regions[index].enabled) {
+        tile_regions[index] = {};
+        tile_count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+RSXTileRegion RSXCore::get_tile_region(uint32_t index) const {
+    std::lock_guard<std::mutex> lock(tile_mutex);
+    return index < RSX_MAX_TILES ? tile_regions[index] : RSXTileRegion();
+}
+
+const uint8_t* RSXCore::read_surface(uint32_t offset, uint32_t pitch, uint32_t height,
+                                     std::vector<uint8_t>& scratch) {
+    uint64_t size = static_cast<uint64_t>(pitch) * height;
+    if (size == 0 || offset + size > vram.size()) {
+        return nullptr;
+    }
+    write_back_surfaces(offset, size, false);
+    bool tiled = false;
+    if (tile_count.load(std::memory_order_acquire) != 0) {
+        std::lock_guard<std::mutex> lock(tile_mutex);
+        for (const RSXTileRegion& region : tile_regions) {
+            tiled |= region.enabled && region.offset < offset + size && offset < region.offset + region.size;
+        }
+    }
+    if (!tiled) {
+        return vram.data() + offset;
+    }
+    // Whole rows go through one bulk detile
+    scratch.resize(static_cast<size_t>(size));
+    copy_from_vram(offset, scratch.data(), static_cast<uint32_t>(size));
+    return scratch.data();
+}
+
+RSXSurface* RSXCore::bind_color_surface(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t bpp, uint32_t height) {
+    std::lock_guard<std::mutex> lock(surface_cache.get_mutex());
+    if (RSXSurface* surface = surface_cache.find(offset, pitch, format, height)) {
+        return surface;
+    }
+    
+    // Anything else over this range holds older pixels, possibly in another
+    // format or pitch: write it back so the new surface starts from them
+    std::vector<RSXSurface*> stale;
+    surface_cache.for_each_overlap(offset, pitch * height, [&](RSXSurface& surface) { stale.push_back(&surface); });
+    RSXSurface* victim = surface_cache.get_eviction_candidate();
+    if (victim && std::find(stale.begin(), stale.end(), victim) == stale.end()) {
+        stale.push_back(victim);
+    }
+    if (!stale.empty()) {
+        // Queued draws may still render into them
+        drain_rasterizer();
+        for (RSXSurface* surface : stale) {
+            write_back_surface(*surface);
+            surface_cache.remove(surface);
+        }
+    }
+    
+    RSXSurface* surface = surface_cache.create(offset, pitch, format, bpp, height);
+    copy_from_vram(offset, surface->data.data(), surface->get_size());
+    logger->debug("Surface created: offset=0x{:08X}, pitch={}, format=0x{:02X}, height={}", offset, pitch, format, height);
+    return surface;
+}
+
+void RSXCore::write_back_surface(RSXSurface& surface) {
+    if (surface.dirty.exchange(false, std::memory_order_acq_rel)) {
+        copy_to_vram(surface.offset, surface.data.data(), surface.get_size());
+        surface_cache.count_writeback();
+    }
+}
+
+void RSXCore::write_back_surfaces(uint32_t offset, uint64_t size, bool drain) {
+    if (surface_cache.is_empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(surface_cache.get_mutex());
+    std::vector<RSXSurface*> dirty;
+    surface_cache.for_each_overlap(offset, static_cast<uint32_t>(std::min<uint64_t>(size, vram.size() - offset)),
+                                   [&](RSXSurface& surface) { dirty.push_back(&surface); });
+    if (dirty.empty()) {
+        return;
+    }
+    // Readers of VRAM contents need the draws queued before them to land
+    // first; present and shutdown have already waited for idle
+    if (drain) {
+        drain_rasterizer();
+    }
+    for (RSXSurface* surface : dirty) {
+        write_back_surface(*surface);
+    }
+}
+
+void RSXCore::flush_surfaces_at(uint64_t address, size_t size) {
+    if (address >= vram_base && address - vram_base < vram.size()) {
+        write_back_surfaces(static_cast<uint32_t>(address - vram_base), size, true);
+    }
+}
+
+void RSXCore::alias_textures(RSXDrawPacket& packet) {
+    const uint8_t* vram_begin = vram.data();
+    const uint8_t* vram_end = vram_begin + vram.size();
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    
+    for (uint32_t unit = 0; unit < RSX_FP_MAX_TEXTURES; unit++) {
+        RSXSamplerState& state = packet.samplers[unit];
+        if (!state.data) {
+            continue;
+        }
+        if (state.data < vram_begin || state.data >= vram_end || surface_cache.is_empty()) {
+            misses++;
+            continue;
+        }
+        const RSXTexture& texture = texture_units[unit];
+        uint32_t base_format = RSXTextureSampler::get_base_format(texture.format);
+        uint32_t offset = static_cast<uint32_t>(state.data - vram_begin);
+        uint32_t span = static_cast<uint32_t>(std::min(state.available, get_texture_span(texture)));
+        
+        // A linear texture laid out exactly like one surface reads its
+        // pixels in place; anything else reads VRAM after a writeback
+        std::unique_lock<std::mutex> lock(surface_cache.get_mutex());
+        RSXSurface* match = nullptr;
+        bool conflict = false;
+        surface_cache.for_each_overlap(offset, span, [&](RSXSurface& surface) {
+            bool compatible = state.linear && state.pitch == surface.pitch &&
+                              !RSXTextureSampler::is_compressed(base_format) &&
+                              RSXTextureSampler::get_texel_size(base_format) == surface.bpp &&
+                              offset >= surface.offset && offset + span <= surface.offset + surface.get_size();
+            if (compatible && !match) {
+                match = &surface;
+            } else {
+                conflict = true;
+            }
+        });
+        
+        if (match && !conflict) {
+            uint32_t delta = offset - match->offset;
+            state.data = match->data.data() + delta;
+            state.available = match->get_size() - delta;
+            surface_cache.count_alias();
+            hits++;
+            continue;
+        }
+        misses++;
+        if (conflict) {
+            lock.unlock();
+            write_back_surfaces(offset, span, true);
+        }
+    }
+    perf.add(RSX_PERF_TEXTURE_HITS, hits);
+    perf.add(RSX_PERF_TEXTURE_MISSES, misses);
+}
+
+const uint8_t* RSXCore::resolve_address(uint64_t address, size_t* available) const {
+    if (address >= vram_base && address - vram_base < vram.size()) {
+        uint64_t offset = address - vram_base;
+        *available = static_cast<size_t>(vram.size() - offset);
+        return vram.data() + offset;
+    }
+    
+    // Main memory through the IO offset table; callers hold an io_table.ReadSection
+    uint64_t ea = 0;
+    uint64_t contiguous = 0;
+    if (main_memory && address >= ioif_base &&
+        io_table.translate(address - ioif_base, ea, &contiguous) && ea < main_memory_size) {
+        *available = static_cast<size_t>(std::min(contiguous, main_memory_size - ea));
+        return main_memory + ea;
     }
+    
+    *available = 0;
+    return nullptr;
+}
+
+bool RSXCore::fetch_vertex_attributes(uint32_t first, uint32_t count) {
+    for (uint32_t i = 0; i < RSX_MAX_VERTEX_ATTRIBUTES; i++) {
+        const RSXVertexAttribute& attr = vertex_attributes[i];
+        if (!attr.enabled) {
+            vertex_streams[i].count = 0;
+            continue;
+        }
+        
+        size_t available = 0;
+        uint64_t address = attr.address + static_cast<uint64_t>(first) * attr.stride;
+        // Elements are at most 16 bytes
+        size_t span = static_cast<size_t>(count ? count - 1 : 0) * attr.stride + 16;
+        // Render-to-vertex-buffer reads what earlier draws wrote
+        flush_surfaces_at(address, span);
+        const uint8_t* src = resolve_address(address, &available);
+        capture_memory(address, src, std::min(available, span));
+        
+        if (!vertex_fetcher.fetch(attr, src, available, count, vertex_streams[i])) {
+            logger->error("Vertex fetch failed: attribute={}, address=0x{:016X}, type={}, size={}",
+                         i, address, attr.type, attr.size);
+            return false;
+        }
+    }
+    
+    perf.add(RSX_PERF_VERTICES, count);
+    return true;
+}
+
+size_t RSXCore::get_texture_span(const RSXTexture& texture) {
+    uint32_t base_format = RSXTextureSampler::get_base_format(texture.format);
+    size_t texel = RSXTextureSampler::get_texel_size(base_format);
+    size_t depth = std::max<uint32_t>(texture.depth, 1);
+    if (RSXTextureSampler::is_compressed(base_format)) {
+        return static_cast<size_t>((texture.width + 3) / 4) * ((texture.height + 3) / 4) * texel * depth;
+    }
+    if ((texture.format & RSX_TEXTURE_FORMAT_LN) && texture.pitch) {
+        return static_cast<size_t>(texture.pitch) * texture.height * depth;
+    }
+    return static_cast<size_t>(texture.width) * texture.height * texel * depth;
+}
+
+void RSXCore::capture_memory(uint64_t address, const uint8_t* src, size_t size) {
+    if (capture && src && size) {
+        capture->write_memory(address, src, size);
+    }
+}
+
+bool RSXCore::start_capture(const std::string& path) {
+    stop_capture();
+    std::lock_guard<std::mutex> lock(state_mutex);
+    
+    auto writer = std::make_unique<RSXCaptureWriter>();
+    if (!writer->open(path, vram_base, ioif_base)) {
+        logger->error("Cannot open RSX capture {}", path);
+        return false;
+    }
+    
+    // Snapshot the state set before capture started so replay begins from it
+    auto put_float = [&](uint32_t method, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writer->write_method(method, bits);
+    };
+    writer->write_method(RSX_NV4097_SET_SURFACE_CLIP_HORIZONTAL, surface_clip_horizontal);
+    writer->write_method(RSX_NV4097_SET_SURFACE_CLIP_VERTICAL, surface_clip_vertical);
+    writer->write_method(RSX_NV4097_SET_SURFACE_FORMAT, current_surface_format);
+    writer->write_method(RSX_NV4097_SET_SURFACE_PITCH_A, current_surface_pitch);
+    writer->write_method(RSX_NV4097_SET_SURFACE_COLOR_OFFSET_A, current_color_offset);
+    writer->write_method(RSX_NV4097_SET_SURFACE_ZETA_OFFSET, current_zeta_offset);
+    writer->write_method(RSX_NV4097_SET_VIEWPORT_HORIZONTAL, (viewport_width << 16) | viewport_x);
+    writer->write_method(RSX_NV4097_SET_VIEWPORT_VERTICAL, (viewport_height << 16) | viewport_y);
+    put_float(RSX_NV4097_SET_CLIP_MIN, clip_min_z);
+    put_float(RSX_NV4097_SET_CLIP_MAX, clip_max_z);
+    put_float(RSX_NV4097_SET_DEPTH_RANGE_NEAR, depth_range_near);
+    put_float(RSX_NV4097_SET_DEPTH_RANGE_FAR, depth_range_far);
+    writer->write_method(RSX_NV4097_SET_RESTART_INDEX_ENABLE, restart_index_enabled ? 1 : 0);
+    writer->write_method(RSX_NV4097_SET_RESTART_INDEX, restart_index);
+    writer->write_method(RSX_NV4097_SET_INDEX_ARRAY_ADDRESS, index_array_offset);
+    writer->write_method(RSX_NV4097_SET_INDEX_ARRAY_DMA, index_array_dma);
+    writer->write_method(RSX_NV4097_SET_CONTEXT_DMA_SEMAPHORE, context_dma_semaphore);
+    writer->write_method(RSX_NV4097_SET_CONTEXT_DMA_REPORT, context_dma_report);
+    writer->write_method(RSX_NV4097_SET_CONTEXT_DMA_NOTIFIES, context_dma_notifies);
+    writer->write_method(RSX_NV406E_SEMAPHORE_OFFSET, semaphore_offset);
+    writer->write_method(RSX_NV4097_SET_SEMAPHORE_OFFSET, back_end_semaphore_offset);
+    writer->write_method(RSX_NV4097_SET_ZPASS_PIXEL_COUNT_ENABLE, zpass_enabled ? 1 : 0);
+    
+    writer->write_method(RSX_NV4097_SET_TRANSFORM_PROGRAM_LOAD, 0);
+    for (uint32_t word : transform_program) {
+        writer->write_method(RSX_NV4097_SET_TRANSFORM_PROGRAM, word);
+    }
+    writer->write_method(RSX_NV4097_SET_TRANSFORM_PROGRAM_LOAD, transform_program_word / 4);
+    writer->write_method(RSX_NV4097_SET_TRANSFORM_PROGRAM_START, transform_program_start);
+    writer->write_method(RSX_NV4097_SET_TRANSFORM_CONSTANT_LOAD, 0);
+    for (float value : transform_constants) {
+        put_float(RSX_NV4097_SET_TRANSFORM_CONSTANT, value);
+    }
+    writer->write_method(RSX_NV4097_SET_TRANSFORM_CONSTANT_LOAD, transform_constant_word / 4);
+    
+    for (uint32_t i = 0; i < RSX_MAX_TEXTURES; i++) {
+        writer->write_texture(i, texture_units[i]);
+    }
+    for (uint32_t i = 0; i < RSX_MAX_VERTEX_ATTRIBUTES; i++) {
+        writer->write_vertex_attribute(i, vertex_attributes[i]);
+    }
+    for (uint32_t i = 0; i < RSX_MAX_RENDER_TARGETS; i++) {
+        writer->write_render_target(i, render_targets[i]);
+    }
+    writer->write_program(RSXCaptureRecord::FRAGMENT_PROGRAM, fragment_program);
+    
+    capture = std::move(writer);
+    logger->info("RSX capture started: {}", path);
+    return true;
+}
+
+void RSXCore::stop_capture() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (!capture) {
+        return;
+    }
+    capture->close();
+    logger->info("RSX capture stopped: {}KB written, {}KB memory",
+                 capture->get_bytes_written() / 1024, capture->get_memory_bytes() / 1024);
+    capture.reset();
+}
+
+void RSXCore::notify_present() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (capture) {
+        capture->write_present();
+    }
+    perf.end_frame();
+}
+
+void RSXCore::start_trace(const std::string& path) {
+    stop_trace();
+    trace_path = path;
+    perf.start_trace();
+    logger->info("RSX trace started: {}", path);
+}
+
+bool RSXCore::stop_trace() {
+    if (!perf.is_tracing()) {
+        return false;
+    }
+    if (!perf.stop_trace(trace_path)) {
+        logger->error("Cannot write RSX trace {}", trace_path);
+        return false;
+    }
+    logger->info("RSX trace written: {}", trace_path);
+    return true;
+}
+
+// RSXManager Implementation
+
+RSXManager::RSXManager()
+    : logger(std::make_unique<Core::Logger>("RSXManager"))
+    , initialized(false)
+    , display_width(0)
+    , display_height(0)
+    , display_format(0)
+    , display_pitch(0)
+    , display_address(0) {
+    // Runs on the vblank thread: a completed flip shows its staged frame
+    vblank.set_flip_handler([this](uint64_t frame) { frame_output.commit(frame); });
+}
+
+RSXManager::~RSXManager() {
+    shutdown();
+}
+
+bool RSXManager::initialize() {
+    if (initialized) {
+        return true;
+    }
+    
+    rsx_core = std::make_unique<RSXCore>();
+    if (!rsx_core->initialize(RSX_LOCAL_MEMORY_BASE, RSX_IO_ADDRESS_BASE)) {
+        logger->error("Failed to initialize RSX core");
+        rsx_core.reset();
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(vram_mutex);
+        // The local report area at the top of VRAM is not allocatable
+        vram_allocator.reset(RSX_REPORT_AREA_OFFSET);
+    }
+    vblank.start(vblank.get_config());
+    
+    initialized = true;
+    logger->info("RSX Manager initialized");
+    return true;
+}
+
+void RSXManager::shutdown() {
+    if (!initialized) {
+        return;
+    }
+    
+    log_frame_stats();
+    vblank.stop();
+    finish_headless();
+    close_frame_output();
+    rsx_core->shutdown();
+    rsx_core.reset();
+    
+    {
+        std::lock_guard<std::mutex> lock(vram_mutex);
+        vram_allocator.reset(0);
+    }
+    display_address = 0;
+    display_pitch = 0;
+    
+    initialized = false;
+    logger->info("RSX Manager shutdown complete");
+}
+
+uint32_t get_surface_bytes_per_pixel(uint32_t format) {
+    switch (format) {
+        case RSX_SURFACE_FORMAT_B8:
+        case RSX_SURFACE_FORMAT_R8:
+            return 1;
+        case RSX_SURFACE_FORMAT_G8B8:
+        case RSX_SURFACE_FORMAT_R5G6B5:
+        case RSX_SURFACE_FORMAT_X1R5G5B5:
+        case RSX_SURFACE_FORMAT_A1R5G5B5:
+        case RSX_SURFACE_FORMAT_A4R4G4B4:
+        case RSX_SURFACE_FORMAT_R16_FLOAT:
+        case RSX_SURFACE_FORMAT_G8R8:
+            return 2;
+        case RSX_SURFACE_FORMAT_B8G8R8:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+bool RSXManager::create_display_buffer(uint32_t width, uint32_t height, uint32_t format) {
+    if (width == 0 || height == 0 || !initialized) {
+        return false;
+    }
+    
+    // Pitch keeps the RSX's 64-byte row alignment
+    uint32_t pitch = (width * get_surface_bytes_per_pixel(format) + 63) & ~63u;
+    if (display_address != 0) {
+        free_vram(display_address);
+        display_address = 0;
+    }
+    uint64_t address = allocate_vram(pitch * height, 4096);
+    if (address == 0) {
+        logger->error("No VRAM for {}x{} display buffer", width, height);
+        return false;
+    }
+    
+    display_width = width;
+    display_height = height;
+    display_format = format;
+    display_pitch = pitch;
+    display_address = address;
+    logger->debug("Display buffer: {}x{} format 0x{:X} at 0x{:X}", width, height, format, address);
+    return true;
+}
+
+uint64_t RSXManager::capture_display_buffer() {
+    if (!rsx_core) {
+        return 0;
+    }
+    rsx_core->wait_for_idle();
+    rsx_core->notify_present();
+    
+    const uint8_t* surface = display_address != 0
+        ? rsx_core->read_surface(static_cast<uint32_t>(display_address - RSX_LOCAL_MEMORY_BASE),
+                                 display_pitch, display_height, present_scratch)
+        : nullptr;
+    
+    if (headless.is_active()) {
+        headless.on_present(surface, display_width, display_height, display_pitch, display_format,
+                            rsx_core->get_draw_calls(), rsx_core->get_triangles_rendered());
+    }
+    
+    uint64_t frame = 0;
+    if (frame_output.is_open() && surface) {
+        frame = frame_output.stage(surface, display_width, display_height, display_pitch, display_format);
+        if (frame == 0) {
+            logger->warn("Frame output rejected {}x{} frame", display_width, display_height);
+        }
+    }
+    return frame;
+}
+
+void RSXManager::present_display_buffer() {
+    // Queued flips go first so the frame output never steps back
+    vblank.flush_flips();
+    frame_output.commit(capture_display_buffer());
+}
+
+void RSXManager::swap_buffers() {
+    // Staging reuses the frame ring slot the oldest queued flip releases
+    vblank.wait_flip_slot();
+    vblank.queue_flip(capture_display_buffer());
+}
+
+void RSXManager::set_frame_pacing(const RSXFramePacingConfig& config) {
+    bool mode_changed = config.mode != vblank.get_config().mode;
+    if (mode_changed) {
+        log_frame_stats();
+    }
+    vblank.configure(config);
+    if (mode_changed) {
+        vblank.reset_stats();
+    }
+}
+
+void RSXManager::log_frame_stats() const {
+    RSXFrameStats stats = vblank.get_stats();
+    if (stats.flips < 2) {
+        return;
+    }
+    bool uncapped = vblank.get_config().mode == RSXFramePacing::UNCAPPED;
+    logger->info("{}: {} frames, {:.2f} fps, mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, "
+                 "max {:.3f} ms, {} late vblanks", uncapped ? "Uncapped" : "VSync", stats.flips, stats.fps,
+                 stats.mean_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms, stats.late_vblanks);
+}
+
+bool RSXManager::open_frame_output(const std::string& name, uint32_t max_width, uint32_t max_height) {
+    vblank.flush_flips();
+    if (!frame_output.create(name, max_width, max_height)) {
+        logger->error("Failed to create frame output '{}'", name);
+        return false;
+    }
+    logger->info("Frame output '{}' open for up to {}x{}", name, max_width, max_height);
+    return true;
+}
+
+bool RSXManager::set_tile_region(uint32_t index, uint64_t address, uint32_t size, uint32_t pitch,
+                                 uint32_t bank, uint32_t comp) {
+    // Main memory tiles are not supported: nothing renders into main memory
+    if (!rsx_core || address < RSX_LOCAL_MEMORY_BASE) {
+        logger->warn("Tile region {} at 0x{:X} is not in VRAM", index, address);
+        return false;
+    }
+    RSXTileRegion region;
+    region.offset = static_cast<uint32_t>(address - RSX_LOCAL_MEMORY_BASE);
+    region.size = size;
+    region.pitch = pitch;
+    region.bank = bank;
+    region.comp = comp;
+    return rsx_core->set_tile_region(index, region);
+}
+
+void RSXManager::clear_tile_region(uint32_t index) {
+    if (rsx_core) {
+        rsx_core->clear_tile_region(index);
+    }
+}
+
+void RSXManager::close_frame_output() {
+    vblank.flush_flips();
+    frame_output.close();
+}
+
+bool RSXManager::enable_headless(const RSXHeadlessConfig& config) {
+    if (!headless.begin(config)) {
+        return false;
+    }
+    // Per-frame statistics are deltas from here
+    if (rsx_core) {
+        rsx_core->reset_statistics();
+    }
+    return true;
+}
+
+bool RSXManager::finish_headless() {
+    return headless.finish();
+}
+
+uint64_t RSXManager::allocate_vram(uint32_t size, uint32_t alignment) {
+    uint64_t offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(vram_mutex);
+        if (!vram_allocator.allocate(size, alignment, offset)) {
+            logger->warn("VRAM allocation failed: size=0x{:X}, alignment=0x{:X}, free=0x{:X}",
+                         size, alignment, vram_allocator.get_free());
+            return 0;
+        }
+    }
+    return RSX_LOCAL_MEMORY_BASE + offset;
+}
+
+void RSXManager::free_vram(uint64_t address) {
+    std::lock_guard<std::mutex> lock(vram_mutex);
+    if (address < RSX_LOCAL_MEMORY_BASE || !vram_allocator.free(address - RSX_LOCAL_MEMORY_BASE)) {
+        logger->warn("Invalid VRAM free: 0x{:X}", address);
+    }
+}
+
+bool RSXManager::map_system_memory(uint64_t system_addr, uint64_t rsx_addr, uint32_t size) {
+    if (!rsx_core || rsx_addr < RSX_IO_ADDRESS_BASE) {
+        return false;
+    }
+    if (!rsx_core->get_io_table().map(rsx_addr - RSX_IO_ADDRESS_BASE, system_addr, size)) {
+        logger->warn("IO mapping failed: ea=0x{:X}, io=0x{:X}, size=0x{:X}", system_addr, rsx_addr, size);
+        return false;
+    }
+    return true;
+}
+
+void RSXManager::unmap_system_memory(uint64_t rsx_addr, uint32_t size) {
+    if (!rsx_core || rsx_addr < RSX_IO_ADDRESS_BASE ||
+        !rsx_core->get_io_table().unmap(rsx_addr - RSX_IO_ADDRESS_BASE, size)) {
+        logger->warn("Invalid IO unmap: io=0x{:X}, size=0x{:X}", rsx_addr, size);
+    }
+}
+
+uint32_t RSXManager::get_vram_usage() const {
+    std::lock_guard<std::mutex> lock(vram_mutex);
+    return static_cast<uint32_t>(vram_allocator.get_used());
+}
+
+uint32_t RSXManager::get_vram_free() const {
+    std::lock_guard<std::mutex> lock(vram_mutex);
+    return static_cast<uint32_t>(vram_allocator.get_free());
+}
+
+RSXVRAMStats RSXManager::get_vram_stats() const {
+    std::lock_guard<std::mutex> lock(vram_mutex);
+    return vram_allocator.get_stats();
 }
 
 } // namespace RSX
 } // namespace Modules
-} // namespace GSCX
\ No newline at end of file
+} // namespace GSCX
@@ -11,10 +11,30 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include "rsx_vertex_fetch.h"
+#include "rsx_index_buffer.h"
+#include "rsx_vertex_program.h"
+#include "rsx_fragment_program.h"
+#include "rsx_shader_cache.h"
+#include "rsx_vram_allocator.h"
+#include "rsx_io_table.h"
+#include "rsx_frame_ring.h"
+#include "rsx_headless.h"
+#include "rsx_vblank.h"
+#include "rsx_capture.h"
+#include "rsx_pipeline.h"
+#include "rsx_rasterizer.h"
+#include "rsx_sync.h"
+#include "rsx_tiling.h"
+#include "rsx_surface_cache.h"
+#include "rsx_perf.h"
+#include "../../../core/include/virtual_memory.h"
 
 namespace GSCX {
 namespace Core {
@@ -96,6 +116,12 @@ struct RSXShaderProgram {
  * 
  * Main RSX graphics processor emulation class.
  * Handles graphics commands, state management, and rendering.
+ * 
+ * Commands run through a three-stage pipeline, one thread per stage:
+ * the command processor parses the FIFO into method writes, the state
+ * stage applies them and builds draw packets, and the raster stage
+ * rasterizes and shades them. Direct calls (execute_method, draw_*,
+ * set_*) run on the caller's thread and serialize with the state stage.
  */
 class RSXCore {
 public:
@@ -105,6 +131,7 @@ public:
     // Core management
     bool initialize(uint64_t vram_addr, uint64_t ioif_addr);
     void shutdown();
+    void set_main_memory(uint8_t* base, uint64_t size);
     void reset_graphics_state();
     
     // State queries
@@ -112,10 +139,30 @@ public:
     uint64_t get_vram_base() const { return vram_base; }
     uint64_t get_ioif_base() const { return ioif_base; }
     
+    // Host memory actually backing VRAM and the command buffer; both are
+    // committed page by page as the guest touches them
+    size_t get_vram_resident() const { return vram.get_resident_bytes(); }
+    size_t get_command_buffer_resident() const { return command_buffer.get_resident_bytes(); }
+    
     // Command processing
     void execute_method(uint32_t method, uint32_t arg);
+    // Returns once every command pushed so far has been parsed, executed
+    // and rasterized
     void wait_for_idle();
     
+    // Command FIFO: host-order words appended at the put pointer, wrapping
+    // to the start of the command buffer with a jump. One pushing thread.
+    bool push_commands(const uint32_t* words, uint32_t count);
+    uint32_t get_fifo_get() const { return fifo_get.load(std::memory_order_acquire); }
+    uint32_t get_fifo_put() const { return fifo_put.load(std::memory_order_acquire); }
+    
+    // PPU/RSX synchronization: semaphore labels, the reference register and
+    // the notifier. Waits on either side sleep until the other writes.
+    RSXSyncUnit& get_sync() { return sync; }
+    const RSXSyncUnit& get_sync() const { return sync; }
+    // Report record at `offset` in the local report area
+    bool read_report(uint32_t offset, uint64_t& timestamp, uint32_t& value) const;
+    
     // Surface management
     void set_surface_format(uint32_t format);
     void set_surface_pitch(uint32_t pitch);
@@ -134,19 +181,95 @@ public:
     // Drawing commands
     void draw_arrays(uint32_t mode, uint32_t first, uint32_t count);
     void draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t indices_addr);
+    void set_restart_index_enable(uint32_t enable);
+    void set_restart_index(uint32_t index);
     
     // Resource management
     void set_texture(uint32_t unit, const RSXTexture& texture);
     void set_vertex_attribute(uint32_t index, const RSXVertexAttribute& attribute);
     void set_render_target(uint32_t index, const RSXRenderTarget& target);
-    
-    // VRAM access
+    void set_vertex_program(const RSXShaderProgram& program);
+    void set_fragment_program(const RSXShaderProgram& program);
+    void set_shader_program(uint32_t value);
+    
+    // Transform (vertex program) state
+    void set_transform_program_load(uint32_t slot);
+    void set_transform_program_start(uint32_t slot);
+    void set_transform_constant_load(uint32_t index);
+    void upload_transform_program_word(uint32_t word);
+    void upload_transform_constant_word(uint32_t word);
+    
+    // VRAM access. get_vram_ptr is the raw backing store, which lags
+    // rendered surfaces; read_vram writes them back first and write_vram
+    // updates them along with VRAM. When the range overlaps a cached
+    // surface both wait for queued draws, so neither may be called from
+    // the rasterizer.
     uint8_t* get_vram_ptr(uint32_t offset);
     const uint8_t* get_vram_ptr(uint32_t offset) const;
     void write_vram(uint32_t offset, const void* data, uint32_t size);
-    void read_vram(uint32_t offset, void* data, uint32_t size) const;
+    void read_vram(uint32_t offset, void* data, uint32_t size);
+    
+    // Tile regions: surfaces in them are stored tiled. read_vram/write_vram
+    // convert to and from linear; get_vram_ptr exposes the tiled bytes.
+    bool set_tile_region(uint32_t index, const RSXTileRegion& region);
+    void clear_tile_region(uint32_t index);
+    RSXTileRegion get_tile_region(uint32_t index) const;
+    // Linear view of a surface: VRAM itself when untiled, otherwise
+    // detiled into `scratch`
+    const uint8_t* read_surface(uint32_t offset, uint32_t pitch, uint32_t height, std::vector<uint8_t>& scratch);
+    
+    // Render targets live in the surface cache until read back
+    RSXSurfaceCacheStats get_surface_cache_stats() { return surface_cache.get_stats(); }
+    
+    // RSX address resolution (VRAM or IOIF-mapped main memory); main memory
+    // pointers stay valid while an io_table ReadSection is held
+    const uint8_t* resolve_address(uint64_t address, size_t* available) const;
+    
+    // IO offset table for main memory; written by RSXManager, read lock-free
+    RSXIOTable& get_io_table() { return io_table; }
+    const RSXIOTable& get_io_table() const { return io_table; }
+    
+    // Vertex fetch
+    bool fetch_vertex_attributes(uint32_t first, uint32_t count);
+    const RSXVertexStream& get_vertex_stream(uint32_t index) const { return vertex_streams[index]; }
+    
+    // Vertex processing; outputs belong to the draw being built and move to
+    // its draw packet when the draw is queued for rasterization
+    bool run_vertex_program(const uint32_t* vertices, uint32_t count);
+    const RSXVertexStream& get_vertex_output(uint32_t index) const { return vertex_outputs[index]; }
+    RSXVertexProgramCache& get_vertex_program_cache() { return vertex_program_cache; }
+    
+    // Fragment processing: bind the program specialized for the current
+    // textures and surface format, then shade rasterized batches with it
+    const RSXFragmentProgram* prepare_fragment_program();
+    void shade_fragments(RSXFragmentBatch& batch);
+    RSXFragmentProgramCache& get_fragment_program_cache() { return fragment_program_cache; }
+    
+    // Shader disk cache: programs are recorded to `path` as they are first
+    // used and rebuilt by a worker pool when the cache is opened
+    bool open_shader_cache(const std::string& path);
+    void close_shader_cache();
+    const RSXShaderDiskCache* get_shader_cache() const { return shader_cache.get(); }
+    
+    // Capture: record methods, resource and draw calls, the memory draws
+    // read and present points to `path` for replay with rsx_replay
+    bool start_capture(const std::string& path);
+    void stop_capture();
+    bool is_capturing() const { return capture != nullptr; }
+    // Ends the frame for the performance counters and the capture
+    void notify_present();
+    
+    // Performance counters: per-frame deltas for the last RSX_PERF_HISTORY
+    // presents. A trace records every stage's spans until stopped, then
+    // writes them to `path` as Chrome trace JSON.
+    RSXPerfMonitor& get_perf() { return perf; }
+    const RSXPerfMonitor& get_perf() const { return perf; }
+    void start_trace(const std::string& path);
+    bool stop_trace();
+    bool is_tracing() const { return perf.is_tracing(); }
     
     // Statistics
+    uint64_t get_pixels_shaded() const { return rasterizer.get_pixels(); }
     uint64_t get_draw_calls() const { return draw_calls; }
     uint64_t get_triangles_rendered() const { return triangles_rendered; }
     void reset_statistics() { draw_calls = 0; triangles_rendered = 0; }
@@ -159,13 +282,49 @@ private:
     uint64_t vram_base;
     uint64_t ioif_base;
     
-    // VRAM
-    std::vector<uint8_t> vram;
+    // VRAM (lazily committed)
+    Core::VirtualMemoryRegion vram;
+    
+    // Tile regions; tile_count lets untiled VRAM access skip the lock
+    RSXTileRegion tile_regions[RSX_MAX_TILES];
+    std::atomic<uint32_t> tile_count;
+    mutable std::mutex tile_mutex;
+    
+    // Render targets; lock order is surface cache mutex, then tile_mutex
+    RSXSurfaceCache surface_cache;
+    
+    // Main memory visible through IOIF
+    uint8_t* main_memory;
+    uint64_t main_memory_size;
+    RSXIOTable io_table;
     
     // Command processing
     std::atomic<bool> command_processor_running;
     std::thread command_processor_thread;
-    std::vector<uint8_t> command_buffer;
+    Core::VirtualMemoryRegion command_buffer;
+    
+    // FIFO registers; the doorbell changes on every put update and on stop
+    std::atomic<uint32_t> fifo_get;
+    std::atomic<uint32_t> fifo_put;
+    std::atomic<uint32_t> fifo_doorbell;
+    uint32_t fifo_return;
+    
+    // Pipeline stages after the command processor. Draw packets come from a
+    // fixed pool, so at most RSX_DRAW_QUEUE_SIZE draws are in flight.
+    std::thread state_thread;
+    std::thread raster_thread;
+    RSXRingQueue<RSXMethodPacket, RSX_METHOD_QUEUE_SIZE> method_queue;
+    RSXRingQueue<RSXDrawPacket*, RSX_DRAW_QUEUE_SIZE> draw_queue;
+    RSXRingQueue<RSXDrawPacket*, RSX_DRAW_QUEUE_SIZE> free_packets;
+    std::vector<std::unique_ptr<RSXDrawPacket>> draw_packets;
+    RSXRasterizer rasterizer;
+    
+    // Work counters for draining the pipeline; draws_* count every packet
+    // the raster stage retires, back-end operations included
+    std::atomic<uint64_t> methods_parsed;
+    std::atomic<uint64_t> methods_executed;
+    std::atomic<uint64_t> draws_queued;
+    std::atomic<uint64_t> draws_retired;
     
     // Graphics state
     uint32_t current_context_dma_color;
@@ -174,6 +333,25 @@ private:
     uint32_t current_surface_pitch;
     uint32_t current_color_offset;
     uint32_t current_zeta_offset;
+    uint32_t surface_clip_horizontal;
+    uint32_t surface_clip_vertical;
+    
+    // Draw methods between SET_BEGIN_END pairs: (first, count) ranges
+    uint32_t draw_mode;
+    bool draw_indexed;
+    uint32_t index_array_offset;
+    uint32_t index_array_dma;
+    std::vector<std::pair<uint32_t, uint32_t>> draw_ranges;
+    
+    // Semaphores, reports and notifiers
+    RSXSyncUnit sync;
+    uint32_t context_dma_semaphore;
+    uint32_t context_dma_report;
+    uint32_t context_dma_notifies;
+    uint32_t semaphore_offset;              // NV406E (front end) semaphore
+    uint32_t back_end_semaphore_offset;     // NV4097 (back end) semaphore
+    bool zpass_enabled;
+    uint64_t zpass_pixels;                  // Owned by the raster stage
     
     // Viewport state
     uint32_t viewport_x, viewport_y;
@@ -186,22 +364,86 @@ private:
     std::vector<RSXVertexAttribute> vertex_attributes;
     std::vector<RSXRenderTarget> render_targets;
     
+    // Vertex fetch
+    RSXVertexFetcher vertex_fetcher;
+    std::vector<RSXVertexStream> vertex_streams;
+    
+    // Index processing
+    RSXIndexFetcher index_fetcher;
+    RSXVertexCache vertex_cache;
+    std::vector<uint32_t> index_buffer;
+    bool restart_index_enabled;
+    uint32_t restart_index;
+    
     // Shader programs
     RSXShaderProgram vertex_program;
     RSXShaderProgram fragment_program;
     
+    // Transform program memory and constants
+    std::vector<uint32_t> transform_program;
+    std::vector<float> transform_constants;
+    uint32_t transform_program_word;
+    uint32_t transform_program_start;
+    uint32_t transform_constant_word;
+    uint32_t transform_branch_bits;
+    bool transform_program_dirty;
+    
+    // Vertex processing
+    RSXVertexProgramCache vertex_program_cache;
+    const RSXVertexProgram* current_vertex_program;
+    std::unique_ptr<RSXVertexBatch> vertex_batch;
+    std::vector<RSXVertexStream> vertex_outputs;
+    
+    // Fragment processing
+    RSXFragmentProgramCache fragment_program_cache;
+    const RSXFragmentProgram* current_fragment_program;
+    std::vector<uint32_t> fragment_microcode;
+    std::vector<RSXSamplerState> fragment_samplers;
+    
+    // Declared after the program caches: its warm-up workers fill them
+    std::unique_ptr<RSXShaderDiskCache> shader_cache;
+    
+    // Capture (null when not capturing)
+    std::unique_ptr<RSXCaptureWriter> capture;
+    
     // Statistics
     std::atomic<uint64_t> draw_calls;
     std::atomic<uint64_t> triangles_rendered;
+    RSXPerfMonitor perf;
+    std::string trace_path;
     
-    // Synchronization
+    // Synchronization: held by the state stage and by direct calls
     std::mutex state_mutex;
     
     // Internal methods
     void start_command_processor();
     void stop_command_processor();
     void command_processor_loop();
-    void process_command_buffer();
+    bool process_command_buffer();
+    void state_stage_loop();
+    void raster_stage_loop();
+    void dispatch_method(uint32_t method, uint32_t arg);
+    void end_draw();
+    void submit_draw(const RSXIOTable::ReadSection& io_section, uint32_t mode, uint32_t vertex_count,
+                     const std::vector<uint32_t>* indices);
+    void drain_rasterizer();
+    void queue_packet(RSXDrawPacket* packet);
+    void queue_back_end(RSXPacketType type, uint32_t label, uint32_t value, uint32_t report_offset);
+    void execute_packet(RSXDrawPacket& packet);
+    uint8_t* resolve_report(uint32_t dma, uint32_t offset);
+    void write_report(uint8_t* dst, uint32_t type);
+    void execute_draw_arrays(uint32_t mode, uint32_t first, uint32_t count);
+    void execute_draw_elements(uint32_t mode, uint32_t count, uint32_t type, uint64_t indices_addr);
+    void load_vertex_program(const RSXShaderProgram& program);
+    void capture_memory(uint64_t address, const uint8_t* src, size_t size);
+    void copy_to_vram(uint32_t offset, const uint8_t* src, uint32_t size);
+    void copy_from_vram(uint32_t offset, uint8_t* dst, uint32_t size) const;
+    RSXSurface* bind_color_surface(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t bpp, uint32_t height);
+    void write_back_surface(RSXSurface& surface);
+    void write_back_surfaces(uint32_t offset, uint64_t size, bool drain);
+    void flush_surfaces_at(uint64_t address, size_t size);
+    void alias_textures(RSXDrawPacket& packet);
+    static size_t get_texture_span(const RSXTexture& texture);
 };
 
 /**
@@ -223,14 +465,49 @@ public:
     RSXCore* get_core() { return rsx_core.get(); }
     const RSXCore* get_core() const { return rsx_core.get(); }
     
-    // Display management
+    // Display management: the display buffer lives in VRAM; presenting
+    // publishes it to the frame output when one is open. present shows the
+    // frame at once; swap queues a flip that shows it on a vblank
     bool create_display_buffer(uint32_t width, uint32_t height, uint32_t format);
     void present_display_buffer();
     void swap_buffers();
+    uint64_t get_display_buffer_address() const { return display_address; }
+    uint32_t get_display_buffer_pitch() const { return display_pitch; }
+    
+    // Tile regions over VRAM addresses (cellGcmSetTileInfo)
+    bool set_tile_region(uint32_t index, uint64_t address, uint32_t size, uint32_t pitch,
+                         uint32_t bank = 0, uint32_t comp = 0);
+    void clear_tile_region(uint32_t index);
+    
+    // Frame output: triple-buffered shared-memory ring named `name`
+    // (see rsx_frame_ring_c.h), sized for frames up to max_width x max_height
+    bool open_frame_output(const std::string& name, uint32_t max_width = 1920, uint32_t max_height = 1080);
+    void close_frame_output();
+    const RSXFrameRing& get_frame_output() const { return frame_output; }
+    
+    // Headless mode: presents feed a recorder that hashes/dumps the selected
+    // frames and reports per-frame timing and draw statistics as JSON
+    bool enable_headless(const RSXHeadlessConfig& config);
+    bool finish_headless();
+    bool is_headless() const { return headless.is_active(); }
+    bool is_headless_complete() const { return headless.is_complete(); }
+    
+    // Frame pacing: a virtual vblank clock completes queued flips, and swaps
+    // block while the flip queue is full. Changing the mode logs and resets
+    // the frame statistics of the previous one.
+    void set_frame_pacing(const RSXFramePacingConfig& config);
+    RSXFramePacingConfig get_frame_pacing() const { return vblank.get_config(); }
+    RSXFrameStats get_frame_stats() const { return vblank.get_stats(); }
+    void reset_frame_stats() { vblank.reset_stats(); }
+    uint64_t get_vblank_count() const { return vblank.get_vblank_count(); }
+    bool wait_vblank(uint64_t count, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) {
+        return vblank.wait_vblank(count, timeout);
+    }
     
     // Memory management
     uint64_t allocate_vram(uint32_t size, uint32_t alignment = 256);
     void free_vram(uint64_t address);
+    // System memory is mapped into the RSX IO space in 1MB pages
     bool map_system_memory(uint64_t system_addr, uint64_t rsx_addr, uint32_t size);
     void unmap_system_memory(uint64_t rsx_addr, uint32_t size);
     
@@ -238,6 +515,7 @@ public:
     bool is_initialized() const { return initialized; }
     uint32_t get_vram_usage() const;
     uint32_t get_vram_free() const;
+    RSXVRAMStats get_vram_stats() const;
     
 private:
     std::unique_ptr<Core::Logger> logger;
@@ -249,26 +527,21 @@ private:
     uint32_t display_width;
     uint32_t display_height;
     uint32_t display_format;
+    uint32_t display_pitch;
+    uint64_t display_address;
+    RSXFrameRing frame_output;
+    RSXHeadlessRecorder headless;
+    std::vector<uint8_t> present_scratch;   // Detiled display buffer
+    RSXVBlankClock vblank;
     
     // Memory management
-    struct VRAMBlock {
-        uint64_t address;
-        uint32_t size;
-        bool allocated;
-    };
-    
-    std::vector<VRAMBlock> vram_blocks;
-    std::mutex vram_mutex;
-    
-    // System memory mapping
-    struct MemoryMapping {
-        uint64_t system_addr;
-        uint64_t rsx_addr;
-        uint32_t size;
-    };
-    
-    std::vector<MemoryMapping> memory_mappings;
-    std::mutex mapping_mutex;
+    RSXVRAMAllocator vram_allocator;
+    mutable std::mutex vram_mutex;
+    
+    // Reads the display buffer and stages it in the frame output; returns
+    // the staged frame, 0 if there is none
+    uint64_t capture_display_buffer();
+    void log_frame_stats() const;
 };
 
 // RSX Surface Formats
@@ -292,6 +565,9 @@ enum RSXSurfaceFormat {
     RSX_SURFACE_FORMAT_R8 = 0x13
 };
 
+// Bytes per pixel of a color surface format
+uint32_t get_surface_bytes_per_pixel(uint32_t format);
+
 // RSX Depth Formats
 enum RSXDepthFormat {
     RSX_DEPTH_FORMAT_Z16 = 0x01,
@@ -339,6 +615,12 @@ enum RSXPrimitiveType {
     RSX_PRIMITIVE_POLYGON = 0x0A
 };
 
+// RSX Index Types
+enum RSXIndexType {
+    RSX_INDEX_TYPE_32 = 0x00,
+    RSX_INDEX_TYPE_16 = 0x01
+};
+
 // RSX Vertex Attribute Types
 enum RSXVertexAttributeType {
     RSX_VERTEX_ATTR_TYPE_FLOAT = 0x02,
@@ -0,0 +1,1412 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Fragment Program Implementation
+ *
+ * The interpreter defines the reference semantics; the JIT mirrors its
+ * operation order (no fused multiply-add, same min/max/saturate NaN
+ * behaviour) so both produce bit-identical results.
+ */
+
+#include "rsx_fragment_program.h"
+#include "rsx_core.h"
+#include "rsx_float16.h"
+#include "rsx_program_hash.h"
+#include "rsx_shader_cache.h"
+#include "rsx_surface_format.h"
+#include "../../../core/include/simd_support.h"
+#include "../../../core/include/x64_emitter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint32_t RSX_FP_MAX_STEPS = 1 << 20;
+static constexpr uint32_t RSX_FP_FLOW_DEPTH = 16;
+static constexpr uint32_t RSX_FP_ALL_LANES = (1u << RSX_FP_BATCH_SIZE) - 1;
+
+// Literal planes
+enum RSXFPLiteral : uint32_t {
+    RSX_FP_LIT_SIGN = 0,
+    RSX_FP_LIT_ABS = 1,
+    RSX_FP_LIT_ONE = 2,
+    RSX_FP_LIT_ZERO = 3,
+    RSX_FP_LIT_SCALE = 4   // x2, x4, x8, /2, /4, /8
+};
+
+static const float rsx_fp_scale_factors[6] = { 2.0f, 4.0f, 8.0f, 0.5f, 0.25f, 0.125f };
+
+// Literal plane holding the factor for an instruction's output scale, or 0 for none
+static inline uint32_t scale_literal(uint32_t scale) {
+    switch (scale) {
+        case 1: return RSX_FP_LIT_SCALE + 0;
+        case 2: return RSX_FP_LIT_SCALE + 1;
+        case 3: return RSX_FP_LIT_SCALE + 2;
+        case 5: return RSX_FP_LIT_SCALE + 3;
+        case 6: return RSX_FP_LIT_SCALE + 4;
+        case 7: return RSX_FP_LIT_SCALE + 5;
+        default: return 0;
+    }
+}
+
+RSXFragmentBatch::RSXFragmentBatch() {
+    std::memset(inputs, 0, sizeof(inputs));
+    std::memset(temps, 0, sizeof(temps));
+    std::memset(half_temps, 0, sizeof(half_temps));
+    std::memset(scratch, 0, sizeof(scratch));
+    samplers = nullptr;
+
+    const uint32_t sign_mask = 0x80000000u;
+    const uint32_t abs_mask = 0x7FFFFFFFu;
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        std::memcpy(&literals[RSX_FP_LIT_SIGN][lane], &sign_mask, sizeof(float));
+        std::memcpy(&literals[RSX_FP_LIT_ABS][lane], &abs_mask, sizeof(float));
+        literals[RSX_FP_LIT_ONE][lane] = 1.0f;
+        literals[RSX_FP_LIT_ZERO][lane] = 0.0f;
+        for (uint32_t i = 0; i < 6; i++) {
+            literals[RSX_FP_LIT_SCALE + i][lane] = rsx_fp_scale_factors[i];
+        }
+    }
+
+    reset_coverage();
+}
+
+void RSXFragmentBatch::reset_coverage() {
+    std::memset(killed, 0, sizeof(killed));
+    std::fill(std::begin(color_targets), std::end(color_targets), nullptr);
+}
+
+RSXFragmentProgram::RSXFragmentProgram()
+    : hash(0)
+    , texture_mask(0)
+    , surface_format(0)
+    , pack(nullptr)
+    , output_half(false)
+    , jit_entry(nullptr) {
+    std::fill(std::begin(texture_formats), std::end(texture_formats), 0u);
+    std::fill(std::begin(samplers), std::end(samplers), nullptr);
+}
+
+bool RSXFragmentInstruction::has_constant() const {
+    if (is_branch()) {
+        return false;
+    }
+    for (uint32_t n = 0; n < 3; n++) {
+        if (src_reg_type(src(n)) == RSX_FP_REG_CONSTANT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_texture_op(uint32_t opcode) {
+    switch (opcode) {
+        case RSX_FP_OP_TEX:
+        case RSX_FP_OP_TXP:
+        case RSX_FP_OP_TXD:
+        case RSX_FP_OP_TXL:
+        case RSX_FP_OP_TXB:
+        case RSX_FP_OP_TEXBEM:
+        case RSX_FP_OP_TXPBEM:
+        case RSX_FP_OP_TIMESWTEX:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_projective(uint32_t opcode) {
+    return opcode == RSX_FP_OP_TXP || opcode == RSX_FP_OP_TXPBEM;
+}
+
+// Colour packing
+//
+// Render targets are big-endian words like the rest of VRAM, so present,
+// texture sampling and readback see the same bytes the packer wrote.
+
+template <uint32_t Format>
+static void pack_color(RSXFragmentBatch* batch, const float (*color)[RSX_FP_BATCH_SIZE]) {
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        if (!batch->color_targets[lane] || batch->killed[lane]) {
+            continue;
+        }
+        const float rgba[4] = { color[0][lane], color[1][lane], color[2][lane], color[3][lane] };
+        rsx_encode_surface_pixel<Format>(rgba, batch->color_targets[lane]);
+    }
+}
+
+RSXFragmentPackFn RSXFragmentProgramCache::get_pack_function(uint32_t surface_format) {
+    switch (surface_format) {
+        case RSX_SURFACE_FORMAT_B8: return &pack_color<RSX_SURFACE_FORMAT_B8>;
+        case RSX_SURFACE_FORMAT_G8B8: return &pack_color<RSX_SURFACE_FORMAT_G8B8>;
+        case RSX_SURFACE_FORMAT_A8R8G8B8: return &pack_color<RSX_SURFACE_FORMAT_A8R8G8B8>;
+        case RSX_SURFACE_FORMAT_B8G8R8A8: return &pack_color<RSX_SURFACE_FORMAT_B8G8R8A8>;
+        case RSX_SURFACE_FORMAT_R5G6B5: return &pack_color<RSX_SURFACE_FORMAT_R5G6B5>;
+        case RSX_SURFACE_FORMAT_X8R8G8B8: return &pack_color<RSX_SURFACE_FORMAT_X8R8G8B8>;
+        case RSX_SURFACE_FORMAT_B8G8R8X8: return &pack_color<RSX_SURFACE_FORMAT_B8G8R8X8>;
+        case RSX_SURFACE_FORMAT_X1R5G5B5: return &pack_color<RSX_SURFACE_FORMAT_X1R5G5B5>;
+        case RSX_SURFACE_FORMAT_A1R5G5B5: return &pack_color<RSX_SURFACE_FORMAT_A1R5G5B5>;
+        case RSX_SURFACE_FORMAT_A4R4G4B4: return &pack_color<RSX_SURFACE_FORMAT_A4R4G4B4>;
+        case RSX_SURFACE_FORMAT_R32_FLOAT: return &pack_color<RSX_SURFACE_FORMAT_R32_FLOAT>;
+        case RSX_SURFACE_FORMAT_R16_FLOAT: return &pack_color<RSX_SURFACE_FORMAT_R16_FLOAT>;
+        case RSX_SURFACE_FORMAT_X8B8G8R8: return &pack_color<RSX_SURFACE_FORMAT_X8B8G8R8>;
+        case RSX_SURFACE_FORMAT_A8B8G8R8: return &pack_color<RSX_SURFACE_FORMAT_A8B8G8R8>;
+        case RSX_SURFACE_FORMAT_B8G8R8: return &pack_color<RSX_SURFACE_FORMAT_B8G8R8>;
+        case RSX_SURFACE_FORMAT_G8R8: return &pack_color<RSX_SURFACE_FORMAT_G8R8>;
+        case RSX_SURFACE_FORMAT_R8: return &pack_color<RSX_SURFACE_FORMAT_R8>;
+        default: return nullptr;
+    }
+}
+
+// Interpreter
+
+namespace {
+
+using Planes = float[4][RSX_FP_BATCH_SIZE];
+
+inline float saturate(float value) {
+    return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+}
+
+// Same operand order as MINPS/MAXPS
+inline float min_ps(float a, float b) { return a < b ? a : b; }
+inline float max_ps(float a, float b) { return a > b ? a : b; }
+
+float (*register_planes(RSXFragmentBatch& batch, bool half, uint32_t index))[RSX_FP_BATCH_SIZE] {
+    return half ? batch.half_temps[index] : batch.temps[index];
+}
+
+void read_source(const RSXFragmentProgram& program, const RSXFragmentBatch& batch, const uint32_t* constants,
+                 uint32_t slot, uint32_t n, Planes out) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+    uint32_t src = instr.src(n);
+
+    for (uint32_t c = 0; c < 4; c++) {
+        uint32_t swizzled = RSXFragmentInstruction::src_swizzle(src, c);
+        for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+            float value = 0.0f;
+            switch (RSXFragmentInstruction::src_reg_type(src)) {
+                case RSX_FP_REG_TEMP: {
+                    uint32_t index = RSXFragmentInstruction::src_tmp(src);
+                    value = RSXFragmentInstruction::src_half(src)
+                        ? batch.half_temps[index][swizzled][lane]
+                        : batch.temps[index][swizzled][lane];
+                    break;
+                }
+                case RSX_FP_REG_INPUT:
+                    if (instr.input_attr() < RSX_FP_INPUTS) {
+                        value = batch.inputs[instr.input_attr()][swizzled][lane];
+                    }
+                    break;
+                case RSX_FP_REG_CONSTANT:
+                    std::memcpy(&value, &constants[(slot + 1) * 4 + swizzled], sizeof(value));
+                    break;
+                default:
+                    break;
+            }
+
+            if (instr.src_abs(n)) {
+                value = std::fabs(value);
+            }
+            if (RSXFragmentInstruction::src_neg(src)) {
+                value = -value;
+            }
+            out[c][lane] = value;
+        }
+    }
+}
+
+struct FlowFrame {
+    bool loop;
+    bool in_else;
+    uint32_t saved_mask;   // Mask to restore on exit
+    uint32_t taken_mask;   // IF: lanes taking the then-branch; LOOP: lanes still iterating
+    uint32_t else_slot;
+    uint32_t end_slot;
+    uint32_t start_slot;
+    uint32_t counter;
+    uint32_t limit;
+    uint32_t increment;
+};
+
+struct FragmentState {
+    const RSXFragmentProgram& program;
+    RSXFragmentBatch& batch;
+    const uint32_t* constants;
+    float cc[2][4][RSX_FP_BATCH_SIZE];
+};
+
+bool condition_passes(const RSXFragmentInstruction& instr, const FragmentState& state,
+                      uint32_t c, uint32_t lane) {
+    if (instr.exec_always()) {
+        return true;
+    }
+    float value = state.cc[instr.cond_reg()][instr.cond_swizzle(c)][lane];
+    return (instr.exec_if_lt() && value < 0.0f) || (instr.exec_if_eq() && value == 0.0f) ||
+           (instr.exec_if_gt() && value > 0.0f);
+}
+
+// Lanes for which any swizzled condition component passes (branches, KIL)
+uint32_t condition_mask(const RSXFragmentInstruction& instr, const FragmentState& state, uint32_t mask) {
+    uint32_t result = 0;
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        if (!(mask & (1u << lane))) {
+            continue;
+        }
+        for (uint32_t c = 0; c < 4; c++) {
+            if (condition_passes(instr, state, c, lane)) {
+                result |= 1u << lane;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+void broadcast(Planes r, uint32_t lane, float value) {
+    for (uint32_t c = 0; c < 4; c++) {
+        r[c][lane] = value;
+    }
+}
+
+void sample(const FragmentState& state, uint32_t opcode, uint32_t unit, const Planes a, Planes r) {
+    float io[4][RSX_FP_BATCH_SIZE];
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        io[0][lane] = a[0][lane];
+        io[1][lane] = a[1][lane];
+        if (is_projective(opcode)) {
+            io[0][lane] = io[0][lane] / a[3][lane];
+            io[1][lane] = io[1][lane] / a[3][lane];
+        }
+    }
+
+    RSXSampleFn fn = state.program.samplers[unit];
+    if (fn && state.batch.samplers) {
+        fn(&state.batch.samplers[unit], io);
+    } else {
+        for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+            io[0][lane] = io[1][lane] = io[2][lane] = 0.0f;
+            io[3][lane] = 1.0f;
+        }
+    }
+    std::memcpy(r, io, sizeof(io));
+}
+
+uint32_t pack_snorm8(float value) {
+    float clamped = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<uint32_t>(static_cast<int32_t>(std::nearbyint(clamped * 127.0f))) & 0xFF;
+}
+
+uint32_t pack_unorm8(float value) {
+    return static_cast<uint32_t>(std::nearbyint(saturate(value) * 255.0f));
+}
+
+uint32_t pack_snorm16(float value) {
+    float clamped = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<uint32_t>(static_cast<int32_t>(std::nearbyint(clamped * 32767.0f))) & 0xFFFF;
+}
+
+float bits_to_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint32_t float_to_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Compute an instruction's result for every lane; returns false for ops
+// that do not write a register
+bool compute(const FragmentState& state, uint32_t slot, Planes r) {
+    const RSXFragmentInstruction& instr = state.program.instructions[slot];
+    uint32_t opcode = instr.opcode();
+
+    Planes a, b, c3;
+    read_source(state.program, state.batch, state.constants, slot, 0, a);
+    read_source(state.program, state.batch, state.constants, slot, 1, b);
+    read_source(state.program, state.batch, state.constants, slot, 2, c3);
+
+    if (is_texture_op(opcode)) {
+        sample(state, opcode, instr.tex_num(), a, r);
+        return true;
+    }
+
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        // Quad-relative lanes for derivatives
+        uint32_t quad = lane & ~3u;
+        uint32_t pos = lane & 3u;
+
+        switch (opcode) {
+            case RSX_FP_OP_MOV:
+            case RSX_FP_OP_BEM:
+            case RSX_FP_OP_BEMLUM:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane];
+                break;
+            case RSX_FP_OP_MUL:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] * b[c][lane];
+                break;
+            case RSX_FP_OP_ADD:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] + b[c][lane];
+                break;
+            case RSX_FP_OP_MAD:
+                for (uint32_t c = 0; c < 4; c++) {
+                    float product = a[c][lane] * b[c][lane];
+                    r[c][lane] = product + c3[c][lane];
+                }
+                break;
+            case RSX_FP_OP_DP2:
+            case RSX_FP_OP_DP3:
+            case RSX_FP_OP_DP4: {
+                uint32_t terms = opcode == RSX_FP_OP_DP2 ? 2 : (opcode == RSX_FP_OP_DP3 ? 3 : 4);
+                float dot = a[0][lane] * b[0][lane];
+                for (uint32_t k = 1; k < terms; k++) {
+                    float product = a[k][lane] * b[k][lane];
+                    dot = dot + product;
+                }
+                broadcast(r, lane, dot);
+                break;
+            }
+            case RSX_FP_OP_DP2A: {
+                float dot = a[0][lane] * b[0][lane];
+                float product = a[1][lane] * b[1][lane];
+                broadcast(r, lane, (dot + product) + c3[0][lane]);
+                break;
+            }
+            case RSX_FP_OP_DST:
+                r[0][lane] = 1.0f;
+                r[1][lane] = a[1][lane] * b[1][lane];
+                r[2][lane] = a[2][lane];
+                r[3][lane] = b[3][lane];
+                break;
+            case RSX_FP_OP_MIN:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = min_ps(a[c][lane], b[c][lane]);
+                break;
+            case RSX_FP_OP_MAX:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = max_ps(a[c][lane], b[c][lane]);
+                break;
+            case RSX_FP_OP_SLT:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] < b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_SGE:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] >= b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_SLE:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] <= b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_SGT:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] > b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_SNE:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] != b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_SEQ:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] == b[c][lane] ? 1.0f : 0.0f;
+                break;
+            case RSX_FP_OP_FRC:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] - std::floor(a[c][lane]);
+                break;
+            case RSX_FP_OP_FLR:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = std::floor(a[c][lane]);
+                break;
+            case RSX_FP_OP_DDX:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][quad + (pos | 1)] - a[c][quad + (pos & ~1u)];
+                break;
+            case RSX_FP_OP_DDY:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][quad + (pos | 2)] - a[c][quad + (pos & ~2u)];
+                break;
+            case RSX_FP_OP_RCP:
+                broadcast(r, lane, 1.0f / a[0][lane]);
+                break;
+            case RSX_FP_OP_RSQ:
+                broadcast(r, lane, 1.0f / std::sqrt(std::fabs(a[0][lane])));
+                break;
+            case RSX_FP_OP_EX2:
+                broadcast(r, lane, std::exp2(a[0][lane]));
+                break;
+            case RSX_FP_OP_LG2:
+                broadcast(r, lane, std::log2(a[0][lane]));
+                break;
+            case RSX_FP_OP_COS:
+                broadcast(r, lane, std::cos(a[0][lane]));
+                break;
+            case RSX_FP_OP_SIN:
+                broadcast(r, lane, std::sin(a[0][lane]));
+                break;
+            case RSX_FP_OP_POW:
+                broadcast(r, lane, std::pow(a[0][lane], b[0][lane]));
+                break;
+            case RSX_FP_OP_LIT: {
+                float diffuse = std::max(a[0][lane], 0.0f);
+                float exponent = std::max(-128.0f, std::min(128.0f, a[3][lane]));
+                r[0][lane] = 1.0f;
+                r[1][lane] = diffuse;
+                r[2][lane] = a[0][lane] > 0.0f ? std::pow(std::max(a[1][lane], 0.0f), exponent) : 0.0f;
+                r[3][lane] = 1.0f;
+                break;
+            }
+            case RSX_FP_OP_LIF:
+                r[0][lane] = 1.0f;
+                r[1][lane] = a[1][lane];
+                r[2][lane] = a[1][lane] > 0.0f ? std::exp2(a[3][lane]) : 0.0f;
+                r[3][lane] = 1.0f;
+                break;
+            case RSX_FP_OP_LRP:
+                for (uint32_t c = 0; c < 4; c++) {
+                    float delta = b[c][lane] - c3[c][lane];
+                    float product = a[c][lane] * delta;
+                    r[c][lane] = c3[c][lane] + product;
+                }
+                break;
+            case RSX_FP_OP_STR:
+                broadcast(r, lane, 1.0f);
+                break;
+            case RSX_FP_OP_SFL:
+                broadcast(r, lane, 0.0f);
+                break;
+            case RSX_FP_OP_DIV:
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] / b[0][lane];
+                break;
+            case RSX_FP_OP_DIVSQ: {
+                float divisor = std::sqrt(b[0][lane]);
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] / divisor;
+                break;
+            }
+            case RSX_FP_OP_NRM: {
+                float dot = a[0][lane] * a[0][lane];
+                for (uint32_t k = 1; k < 3; k++) {
+                    float product = a[k][lane] * a[k][lane];
+                    dot = dot + product;
+                }
+                float inv = 1.0f / std::sqrt(dot);
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] * inv;
+                break;
+            }
+            case RSX_FP_OP_REFL: {
+                float dot = (a[0][lane] * b[0][lane] + a[1][lane] * b[1][lane]) + a[2][lane] * b[2][lane];
+                for (uint32_t c = 0; c < 4; c++) r[c][lane] = a[c][lane] - 2.0f * dot * b[c][lane];
+                break;
+            }
+            case RSX_FP_OP_PK4:
+                broadcast(r, lane, bits_to_float(pack_snorm8(a[0][lane]) | (pack_snorm8(a[1][lane]) << 8) |
+                                                 (pack_snorm8(a[2][lane]) << 16) | (pack_snorm8(a[3][lane]) << 24)));
+                break;
+            case RSX_FP_OP_PKB:
+            case RSX_FP_OP_PKG:
+                broadcast(r, lane, bits_to_float(pack_unorm8(a[0][lane]) | (pack_unorm8(a[1][lane]) << 8) |
+                                                 (pack_unorm8(a[2][lane]) << 16) | (pack_unorm8(a[3][lane]) << 24)));
+                break;
+            case RSX_FP_OP_PK2:
+                broadcast(r, lane, bits_to_float(float_to_half(a[0][lane]) |
+                                                 (static_cast<uint32_t>(float_to_half(a[1][lane])) << 16)));
+                break;
+            case RSX_FP_OP_PK16:
+                broadcast(r, lane, bits_to_float(pack_snorm16(a[0][lane]) | (pack_snorm16(a[1][lane]) << 16)));
+                break;
+            case RSX_FP_OP_UP4: {
+                uint32_t bits = float_to_bits(a[0][lane]);
+                for (uint32_t c = 0; c < 4; c++) {
+                    float value = static_cast<float>(static_cast<int8_t>(bits >> (c * 8))) / 127.0f;
+                    r[c][lane] = std::max(value, -1.0f);
+                }
+                break;
+            }
+            case RSX_FP_OP_UPB:
+            case RSX_FP_OP_UPG: {
+                uint32_t bits = float_to_bits(a[0][lane]);
+                for (uint32_t c = 0; c < 4; c++) {
+                    r[c][lane] = static_cast<float>((bits >> (c * 8)) & 0xFF) / 255.0f;
+                }
+                break;
+            }
+            case RSX_FP_OP_UP2: {
+                uint32_t bits = float_to_bits(a[0][lane]);
+                r[0][lane] = r[2][lane] = half_to_float(static_cast<uint16_t>(bits));
+                r[1][lane] = r[3][lane] = half_to_float(static_cast<uint16_t>(bits >> 16));
+                break;
+            }
+            case RSX_FP_OP_UP16: {
+                uint32_t bits = float_to_bits(a[0][lane]);
+                float lo = static_cast<float>(static_cast<int16_t>(bits)) / 32767.0f;
+                float hi = static_cast<float>(static_cast<int16_t>(bits >> 16)) / 32767.0f;
+                r[0][lane] = r[2][lane] = std::max(lo, -1.0f);
+                r[1][lane] = r[3][lane] = std::max(hi, -1.0f);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void write_result(FragmentState& state, uint32_t slot, Planes r, uint32_t mask) {
+    const RSXFragmentInstruction& instr = state.program.instructions[slot];
+
+    uint32_t scale = scale_literal(instr.scale());
+    float (*dst)[RSX_FP_BATCH_SIZE] = register_planes(state.batch, instr.dst_half(), instr.dst_reg());
+
+    for (uint32_t c = 0; c < 4; c++) {
+        if (!instr.mask_has(c)) {
+            continue;
+        }
+        for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+            if (!(mask & (1u << lane)) || !condition_passes(instr, state, c, lane)) {
+                continue;
+            }
+            float value = r[c][lane];
+            if (scale) {
+                value = value * rsx_fp_scale_factors[scale - RSX_FP_LIT_SCALE];
+            }
+            if (instr.saturate()) {
+                value = saturate(value);
+            }
+            if (instr.set_cond()) {
+                state.cc[instr.cond_mod_reg()][c][lane] = value;
+            }
+            if (!instr.no_dest()) {
+                dst[c][lane] = value;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void RSXFragmentProgramInterpreter::execute(const RSXFragmentProgram& program, RSXFragmentBatch& batch,
+                                            const uint32_t* constants) {
+    FragmentState state{ program, batch, constants, {} };
+
+    FlowFrame stack[RSX_FP_FLOW_DEPTH];
+    uint32_t depth = 0;
+    uint32_t mask = RSX_FP_ALL_LANES;
+    uint32_t pc = 0;
+    uint32_t size = static_cast<uint32_t>(program.instructions.size());
+    Planes result;
+
+    for (uint32_t steps = 0; pc < size && steps < RSX_FP_MAX_STEPS; steps++) {
+        // Close or switch the innermost blocks that end at this slot
+        bool redirected = false;
+        while (depth > 0) {
+            FlowFrame& frame = stack[depth - 1];
+            if (!frame.loop && !frame.in_else && pc == frame.else_slot && frame.else_slot != frame.end_slot) {
+                frame.in_else = true;
+                mask = frame.saved_mask & ~frame.taken_mask;
+                if (mask == 0) {
+                    pc = frame.end_slot;
+                    redirected = true;
+                }
+                break;
+            }
+            if (pc != frame.end_slot) {
+                break;
+            }
+            if (frame.loop) {
+                frame.counter += frame.increment;
+                if (frame.counter < frame.limit && frame.taken_mask != 0) {
+                    mask = frame.taken_mask;
+                    pc = frame.start_slot;
+                    redirected = true;
+                    break;
+                }
+            }
+            mask = frame.saved_mask;
+            depth--;
+        }
+        if (redirected) {
+            continue;
+        }
+
+        const RSXFragmentInstruction& instr = program.instructions[pc];
+        uint32_t opcode = instr.opcode();
+        uint32_t next = pc + (instr.has_constant() ? 2 : 1);
+
+        switch (opcode) {
+            case RSX_FP_OP_IFE: {
+                if (depth == RSX_FP_FLOW_DEPTH) {
+                    break;
+                }
+                uint32_t taken = condition_mask(instr, state, mask);
+                stack[depth++] = FlowFrame{ false, false, mask, taken, instr.else_slot(), instr.end_slot(), 0, 0, 0, 0 };
+                mask = taken;
+                if (mask == 0) {
+                    next = instr.else_slot();
+                }
+                break;
+            }
+            case RSX_FP_OP_LOOP:
+            case RSX_FP_OP_REP: {
+                uint32_t taken = (instr.exec_if_lt() || instr.exec_if_eq() || instr.exec_if_gt())
+                    ? condition_mask(instr, state, mask) : 0;
+                if (taken == 0 || instr.loop_init() >= instr.loop_end() || depth == RSX_FP_FLOW_DEPTH) {
+                    next = instr.end_slot();
+                    break;
+                }
+                stack[depth++] = FlowFrame{ true, false, mask, taken, 0, instr.end_slot(), pc + 1,
+                                            instr.loop_init(), instr.loop_end(),
+                                            std::max<uint32_t>(instr.loop_increment(), 1) };
+                mask = taken;
+                break;
+            }
+            case RSX_FP_OP_BRK: {
+                uint32_t broken = condition_mask(instr, state, mask);
+                uint32_t loop = depth;
+                while (loop > 0 && !stack[loop - 1].loop) {
+                    loop--;
+                }
+                if (loop == 0 || broken == 0) {
+                    break;
+                }
+                // Broken lanes stay off until the loop exits
+                for (uint32_t i = loop - 1; i < depth; i++) {
+                    stack[i].taken_mask &= ~broken;
+                    if (i >= loop) {
+                        stack[i].saved_mask &= ~broken;
+                    }
+                }
+                mask &= ~broken;
+                if (mask == 0) {
+                    depth = loop;
+                    next = stack[loop - 1].end_slot;
+                }
+                break;
+            }
+            case RSX_FP_OP_CAL:
+            case RSX_FP_OP_RET:
+            case RSX_FP_OP_NOP:
+            case RSX_FP_OP_FENCT:
+            case RSX_FP_OP_FENCB:
+                break;
+            case RSX_FP_OP_KIL: {
+                uint32_t kill = condition_mask(instr, state, mask);
+                for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+                    if (kill & (1u << lane)) {
+                        batch.killed[lane] = 0xFFFFFFFF;
+                    }
+                }
+                break;
+            }
+            default:
+                if (compute(state, pc, result)) {
+                    write_result(state, pc, result, mask);
+                }
+                break;
+        }
+
+        if (instr.end() && depth == 0) {
+            break;
+        }
+        pc = next;
+    }
+
+    if (program.pack) {
+        program.pack(&batch, program.output_half ? batch.half_temps[0] : batch.temps[0]);
+    }
+}
+
+// JIT
+
+namespace {
+
+using Core::X64Emitter;
+using Core::X64Reg;
+
+constexpr int32_t BATCH_PLANE_SIZE = RSX_FP_BATCH_SIZE * sizeof(float);
+
+constexpr int32_t input_offset(uint32_t reg, uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXFragmentBatch, inputs) + (reg * 4 + c) * BATCH_PLANE_SIZE);
+}
+constexpr int32_t temp_offset(bool half, uint32_t reg, uint32_t c) {
+    return static_cast<int32_t>((half ? offsetof(RSXFragmentBatch, half_temps) : offsetof(RSXFragmentBatch, temps)) +
+                                (reg * 4 + c) * BATCH_PLANE_SIZE);
+}
+constexpr int32_t scratch_offset(uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXFragmentBatch, scratch) + c * BATCH_PLANE_SIZE);
+}
+constexpr int32_t literal_offset(uint32_t literal) {
+    return static_cast<int32_t>(offsetof(RSXFragmentBatch, literals) + literal * BATCH_PLANE_SIZE);
+}
+
+// In-lane selectors over quad lanes (0,0) (1,0) (0,1) (1,1)
+constexpr uint8_t QUAD_RIGHT = 0xF5;   // 1 1 3 3
+constexpr uint8_t QUAD_LEFT = 0xA0;    // 0 0 2 2
+constexpr uint8_t QUAD_BOTTOM = 0xEE;  // 2 3 2 3
+constexpr uint8_t QUAD_TOP = 0x44;     // 0 1 0 1
+
+// ymm0-2 sources, ymm3 result, ymm4 scratch, ymm5 per-instruction
+// broadcast value. The batch and constant pointers live in callee-saved
+// RBX/R12 because texture sampling and colour packing call out.
+enum JitRegister : int { Y_SRC0 = 0, Y_SRC1 = 1, Y_SRC2 = 2, Y_RESULT = 3, Y_TMP = 4, Y_HELD = 5 };
+
+// Win64 callers reserve 32 bytes of home space for callees
+#ifdef _WIN32
+constexpr int32_t CALL_FRAME_SIZE = 32;
+#else
+constexpr int32_t CALL_FRAME_SIZE = 0;
+#endif
+
+class FragmentProgramEmitter {
+public:
+    explicit FragmentProgramEmitter(const RSXFragmentProgram& program)
+        : program(program)
+        , batch(X64Reg::RBX)
+        , constants(X64Reg::R12) {}
+
+    void prologue();
+    void emit_instruction(uint32_t slot);
+    void epilogue();
+    const std::vector<uint8_t>& get_code() const { return e.get_code(); }
+
+private:
+    const RSXFragmentProgram& program;
+    X64Emitter e;
+    X64Reg batch;
+    X64Reg constants;
+
+    void load_source(int reg, uint32_t slot, uint32_t n, uint32_t component);
+    void load_literal(int reg, uint32_t literal) { e.vmovups_load(reg, batch, literal_offset(literal)); }
+    void finish_value(const RSXFragmentInstruction& instr, int reg);
+    void emit_component(uint32_t slot, uint32_t c);
+    void emit_broadcast(uint32_t slot);
+    void emit_texture(uint32_t slot);
+    void call(const void* target);
+};
+
+void FragmentProgramEmitter::prologue() {
+    // Three pushes realign the stack to 16 bytes for the calls below
+    e.push(X64Reg::RBX);
+    e.push(X64Reg::R12);
+    e.push(X64Reg::R13);
+    if (CALL_FRAME_SIZE) {
+        e.sub_imm32(X64Reg::RSP, CALL_FRAME_SIZE);
+    }
+    e.mov(batch, X64Emitter::arg_reg(0));
+    e.mov(constants, X64Emitter::arg_reg(1));
+}
+
+void FragmentProgramEmitter::epilogue() {
+    if (program.pack) {
+        e.mov(X64Emitter::arg_reg(0), batch);
+        e.lea(X64Emitter::arg_reg(1), batch, temp_offset(program.output_half, 0, 0));
+        call(reinterpret_cast<const void*>(program.pack));
+    }
+    if (CALL_FRAME_SIZE) {
+        e.add_imm32(X64Reg::RSP, CALL_FRAME_SIZE);
+    }
+    e.pop(X64Reg::R13);
+    e.pop(X64Reg::R12);
+    e.pop(X64Reg::RBX);
+    e.vzeroupper();
+    e.ret();
+}
+
+void FragmentProgramEmitter::call(const void* target) {
+    e.vzeroupper();
+    e.call(target);
+}
+
+void FragmentProgramEmitter::load_source(int reg, uint32_t slot, uint32_t n, uint32_t component) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+    uint32_t src = instr.src(n);
+    uint32_t swizzled = RSXFragmentInstruction::src_swizzle(src, component);
+
+    switch (RSXFragmentInstruction::src_reg_type(src)) {
+        case RSX_FP_REG_TEMP:
+            e.vmovups_load(reg, batch, temp_offset(RSXFragmentInstruction::src_half(src),
+                                                   RSXFragmentInstruction::src_tmp(src), swizzled));
+            break;
+        case RSX_FP_REG_INPUT:
+            e.vmovups_load(reg, batch, input_offset(instr.input_attr(), swizzled));
+            break;
+        case RSX_FP_REG_CONSTANT:
+            e.vbroadcastss(reg, constants, static_cast<int32_t>(((slot + 1) * 4 + swizzled) * sizeof(uint32_t)));
+            break;
+        default:
+            e.vxorps(reg, reg, reg);
+            break;
+    }
+
+    if (instr.src_abs(n)) {
+        e.vandps(reg, reg, batch, literal_offset(RSX_FP_LIT_ABS));
+    }
+    if (RSXFragmentInstruction::src_neg(src)) {
+        e.vxorps(reg, reg, batch, literal_offset(RSX_FP_LIT_SIGN));
+    }
+}
+
+// Output scale, then saturate
+void FragmentProgramEmitter::finish_value(const RSXFragmentInstruction& instr, int reg) {
+    uint32_t scale = scale_literal(instr.scale());
+    if (scale) {
+        e.vmulps(reg, reg, batch, literal_offset(scale));
+    }
+    if (instr.saturate()) {
+        e.vmaxps(reg, reg, batch, literal_offset(RSX_FP_LIT_ZERO));
+        e.vminps(reg, reg, batch, literal_offset(RSX_FP_LIT_ONE));
+    }
+}
+
+// Result for ops whose value is the same in every component, into Y_HELD.
+// NRM leaves its reciprocal length there instead.
+void FragmentProgramEmitter::emit_broadcast(uint32_t slot) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+    uint32_t opcode = instr.opcode();
+
+    switch (opcode) {
+        case RSX_FP_OP_DP2:
+        case RSX_FP_OP_DP3:
+        case RSX_FP_OP_DP4:
+        case RSX_FP_OP_NRM: {
+            uint32_t terms = opcode == RSX_FP_OP_DP2 ? 2 : (opcode == RSX_FP_OP_DP4 ? 4 : 3);
+            uint32_t second = opcode == RSX_FP_OP_NRM ? 0 : 1;
+            for (uint32_t k = 0; k < terms; k++) {
+                load_source(Y_SRC0, slot, 0, k);
+                load_source(Y_SRC1, slot, second, k);
+                if (k == 0) {
+                    e.vmulps(Y_HELD, Y_SRC0, Y_SRC1);
+                } else {
+                    e.vmulps(Y_SRC0, Y_SRC0, Y_SRC1);
+                    e.vaddps(Y_HELD, Y_HELD, Y_SRC0);
+                }
+            }
+            if (opcode == RSX_FP_OP_NRM) {
+                e.vsqrtps(Y_HELD, Y_HELD);
+                load_literal(Y_TMP, RSX_FP_LIT_ONE);
+                e.vdivps(Y_HELD, Y_TMP, Y_HELD);
+            }
+            break;
+        }
+        case RSX_FP_OP_RCP:
+            load_source(Y_HELD, slot, 0, 0);
+            load_literal(Y_TMP, RSX_FP_LIT_ONE);
+            e.vdivps(Y_HELD, Y_TMP, Y_HELD);
+            break;
+        case RSX_FP_OP_RSQ:
+            load_source(Y_HELD, slot, 0, 0);
+            e.vandps(Y_HELD, Y_HELD, batch, literal_offset(RSX_FP_LIT_ABS));
+            e.vsqrtps(Y_HELD, Y_HELD);
+            load_literal(Y_TMP, RSX_FP_LIT_ONE);
+            e.vdivps(Y_HELD, Y_TMP, Y_HELD);
+            break;
+        case RSX_FP_OP_DIV:
+            load_source(Y_HELD, slot, 1, 0);
+            break;
+        case RSX_FP_OP_STR:
+            load_literal(Y_HELD, RSX_FP_LIT_ONE);
+            break;
+        case RSX_FP_OP_SFL:
+            e.vxorps(Y_HELD, Y_HELD, Y_HELD);
+            break;
+        default:
+            break;
+    }
+}
+
+void FragmentProgramEmitter::emit_component(uint32_t slot, uint32_t c) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+
+    auto compare = [&](uint8_t predicate) {
+        load_source(Y_SRC0, slot, 0, c);
+        load_source(Y_SRC1, slot, 1, c);
+        e.vcmpps(Y_RESULT, Y_SRC0, Y_SRC1, predicate);
+        e.vandps(Y_RESULT, Y_RESULT, batch, literal_offset(RSX_FP_LIT_ONE));
+    };
+    auto derivative = [&](uint8_t high, uint8_t low) {
+        load_source(Y_SRC0, slot, 0, c);
+        e.vpermilps(Y_SRC1, Y_SRC0, high);
+        e.vpermilps(Y_SRC2, Y_SRC0, low);
+        e.vsubps(Y_RESULT, Y_SRC1, Y_SRC2);
+    };
+
+    switch (instr.opcode()) {
+        case RSX_FP_OP_MOV:
+            load_source(Y_RESULT, slot, 0, c);
+            break;
+        case RSX_FP_OP_MUL:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_FP_OP_ADD:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            e.vaddps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_FP_OP_MAD:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            load_source(Y_SRC2, slot, 2, c);
+            e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            e.vaddps(Y_RESULT, Y_RESULT, Y_SRC2);
+            break;
+        case RSX_FP_OP_DST:
+            if (c == 0) {
+                load_literal(Y_RESULT, RSX_FP_LIT_ONE);
+            } else if (c == 1) {
+                load_source(Y_SRC0, slot, 0, 1);
+                load_source(Y_SRC1, slot, 1, 1);
+                e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            } else if (c == 2) {
+                load_source(Y_RESULT, slot, 0, 2);
+            } else {
+                load_source(Y_RESULT, slot, 1, 3);
+            }
+            break;
+        case RSX_FP_OP_MIN:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            e.vminps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_FP_OP_MAX:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            e.vmaxps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_FP_OP_SLT: compare(Core::X64_CMP_LT_OQ); break;
+        case RSX_FP_OP_SGE: compare(Core::X64_CMP_GE_OQ); break;
+        case RSX_FP_OP_SLE: compare(Core::X64_CMP_LE_OQ); break;
+        case RSX_FP_OP_SGT: compare(Core::X64_CMP_GT_OQ); break;
+        case RSX_FP_OP_SNE: compare(Core::X64_CMP_NEQ_UQ); break;
+        case RSX_FP_OP_SEQ: compare(Core::X64_CMP_EQ_OQ); break;
+        case RSX_FP_OP_FRC:
+            load_source(Y_SRC0, slot, 0, c);
+            e.vroundps(Y_SRC1, Y_SRC0, Core::X64_ROUND_FLOOR);
+            e.vsubps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_FP_OP_FLR:
+            load_source(Y_SRC0, slot, 0, c);
+            e.vroundps(Y_RESULT, Y_SRC0, Core::X64_ROUND_FLOOR);
+            break;
+        case RSX_FP_OP_DDX:
+            derivative(QUAD_RIGHT, QUAD_LEFT);
+            break;
+        case RSX_FP_OP_DDY:
+            derivative(QUAD_BOTTOM, QUAD_TOP);
+            break;
+        case RSX_FP_OP_LRP:
+            load_source(Y_SRC0, slot, 0, c);
+            load_source(Y_SRC1, slot, 1, c);
+            load_source(Y_SRC2, slot, 2, c);
+            e.vsubps(Y_SRC1, Y_SRC1, Y_SRC2);
+            e.vmulps(Y_SRC0, Y_SRC0, Y_SRC1);
+            e.vaddps(Y_RESULT, Y_SRC2, Y_SRC0);
+            break;
+        case RSX_FP_OP_DIV:
+            load_source(Y_SRC0, slot, 0, c);
+            e.vdivps(Y_RESULT, Y_SRC0, Y_HELD);
+            break;
+        case RSX_FP_OP_NRM:
+            load_source(Y_SRC0, slot, 0, c);
+            e.vmulps(Y_RESULT, Y_SRC0, Y_HELD);
+            break;
+        default:
+            // Broadcast ops: every component is the held value
+            e.vmovaps(Y_RESULT, Y_HELD);
+            break;
+    }
+}
+
+void FragmentProgramEmitter::emit_texture(uint32_t slot) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+    uint32_t unit = instr.tex_num();
+
+    // Coordinates to scratch, sample in place
+    load_source(Y_SRC0, slot, 0, 0);
+    load_source(Y_SRC1, slot, 0, 1);
+    if (is_projective(instr.opcode())) {
+        load_source(Y_SRC2, slot, 0, 3);
+        e.vdivps(Y_SRC0, Y_SRC0, Y_SRC2);
+        e.vdivps(Y_SRC1, Y_SRC1, Y_SRC2);
+    }
+    e.vmovups_store(batch, scratch_offset(0), Y_SRC0);
+    e.vmovups_store(batch, scratch_offset(1), Y_SRC1);
+
+    e.mov(X64Emitter::arg_reg(0), batch, static_cast<int32_t>(offsetof(RSXFragmentBatch, samplers)));
+    if (unit) {
+        e.add_imm32(X64Emitter::arg_reg(0), static_cast<int32_t>(unit * sizeof(RSXSamplerState)));
+    }
+    e.lea(X64Emitter::arg_reg(1), batch, scratch_offset(0));
+    call(reinterpret_cast<const void*>(program.samplers[unit]));
+
+    for (uint32_t c = 0; c < 4; c++) {
+        if (!instr.mask_has(c)) {
+            continue;
+        }
+        e.vmovups_load(Y_RESULT, batch, scratch_offset(c));
+        finish_value(instr, Y_RESULT);
+        e.vmovups_store(batch, temp_offset(instr.dst_half(), instr.dst_reg(), c), Y_RESULT);
+    }
+}
+
+bool is_held_op(uint32_t opcode) {
+    switch (opcode) {
+        case RSX_FP_OP_DP2:
+        case RSX_FP_OP_DP3:
+        case RSX_FP_OP_DP4:
+        case RSX_FP_OP_RCP:
+        case RSX_FP_OP_RSQ:
+        case RSX_FP_OP_STR:
+        case RSX_FP_OP_SFL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void FragmentProgramEmitter::emit_instruction(uint32_t slot) {
+    const RSXFragmentInstruction& instr = program.instructions[slot];
+    uint32_t opcode = instr.opcode();
+
+    if (opcode == RSX_FP_OP_NOP || opcode == RSX_FP_OP_FENCT || opcode == RSX_FP_OP_FENCB) {
+        return;
+    }
+    if (opcode == RSX_FP_OP_KIL) {
+        // Unconditional: discard every pixel
+        e.vcmpps(Y_RESULT, Y_RESULT, Y_RESULT, Core::X64_CMP_TRUE_UQ);
+        e.vmovups_store(batch, static_cast<int32_t>(offsetof(RSXFragmentBatch, killed)), Y_RESULT);
+        return;
+    }
+    if (instr.no_dest()) {
+        return;
+    }
+    if (is_texture_op(opcode)) {
+        emit_texture(slot);
+        return;
+    }
+
+    emit_broadcast(slot);
+
+    if (is_held_op(opcode)) {
+        finish_value(instr, Y_HELD);
+        for (uint32_t c = 0; c < 4; c++) {
+            if (instr.mask_has(c)) {
+                e.vmovups_store(batch, temp_offset(instr.dst_half(), instr.dst_reg(), c), Y_HELD);
+            }
+        }
+        return;
+    }
+
+    // Stage through scratch when the destination is also a source, so a
+    // swizzle such as R0.xy = R0.yx reads the old value for every component
+    bool staged = false;
+    for (uint32_t n = 0; n < 3; n++) {
+        uint32_t src = instr.src(n);
+        if (RSXFragmentInstruction::src_reg_type(src) == RSX_FP_REG_TEMP &&
+            RSXFragmentInstruction::src_half(src) == instr.dst_half() &&
+            RSXFragmentInstruction::src_tmp(src) == instr.dst_reg()) {
+            staged = true;
+        }
+    }
+
+    for (uint32_t c = 0; c < 4; c++) {
+        if (!instr.mask_has(c)) {
+            continue;
+        }
+        emit_component(slot, c);
+        finish_value(instr, Y_RESULT);
+        e.vmovups_store(batch, staged ? scratch_offset(c) : temp_offset(instr.dst_half(), instr.dst_reg(), c),
+                        Y_RESULT);
+    }
+
+    if (staged) {
+        for (uint32_t c = 0; c < 4; c++) {
+            if (instr.mask_has(c)) {
+                e.vmovups_load(Y_RESULT, batch, scratch_offset(c));
+                e.vmovups_store(batch, temp_offset(instr.dst_half(), instr.dst_reg(), c), Y_RESULT);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool RSXFragmentProgramCompiler::can_compile(const RSXFragmentProgram& program) {
+    for (size_t slot = 0; slot < program.instructions.size(); slot++) {
+        const RSXFragmentInstruction& instr = program.instructions[slot];
+        if (instr.set_cond() || !instr.exec_always()) {
+            return false;
+        }
+
+        uint32_t opcode = instr.opcode();
+        switch (opcode) {
+            case RSX_FP_OP_NOP:
+            case RSX_FP_OP_MOV:
+            case RSX_FP_OP_MUL:
+            case RSX_FP_OP_ADD:
+            case RSX_FP_OP_MAD:
+            case RSX_FP_OP_DP2:
+            case RSX_FP_OP_DP3:
+            case RSX_FP_OP_DP4:
+            case RSX_FP_OP_DST:
+            case RSX_FP_OP_MIN:
+            case RSX_FP_OP_MAX:
+            case RSX_FP_OP_SLT:
+            case RSX_FP_OP_SGE:
+            case RSX_FP_OP_SLE:
+            case RSX_FP_OP_SGT:
+            case RSX_FP_OP_SNE:
+            case RSX_FP_OP_SEQ:
+            case RSX_FP_OP_FRC:
+            case RSX_FP_OP_FLR:
+            case RSX_FP_OP_KIL:
+            case RSX_FP_OP_DDX:
+            case RSX_FP_OP_DDY:
+            case RSX_FP_OP_RCP:
+            case RSX_FP_OP_RSQ:
+            case RSX_FP_OP_LRP:
+            case RSX_FP_OP_STR:
+            case RSX_FP_OP_SFL:
+            case RSX_FP_OP_DIV:
+            case RSX_FP_OP_NRM:
+            case RSX_FP_OP_FENCT:
+            case RSX_FP_OP_FENCB:
+                break;
+            default:
+                if (!is_texture_op(opcode) || !program.samplers[instr.tex_num()]) {
+                    return false;
+                }
+                break;
+        }
+
+        // Out-of-range inputs have interpreter-defined behaviour only
+        for (uint32_t n = 0; n < 3; n++) {
+            if (RSXFragmentInstruction::src_reg_type(instr.src(n)) == RSX_FP_REG_INPUT &&
+                instr.input_attr() >= RSX_FP_INPUTS) {
+                return false;
+            }
+        }
+
+        if (instr.end()) {
+            break;
+        }
+        if (instr.has_constant()) {
+            slot++;
+        }
+    }
+    return true;
+}
+
+bool RSXFragmentProgramCompiler::compile(RSXFragmentProgram& program) {
+    if (!can_compile(program)) {
+        return false;
+    }
+
+    FragmentProgramEmitter emitter(program);
+    emitter.prologue();
+    for (uint32_t slot = 0; slot < program.instructions.size(); slot++) {
+        const RSXFragmentInstruction& instr = program.instructions[slot];
+        emitter.emit_instruction(slot);
+        if (instr.end()) {
+            break;
+        }
+        if (instr.has_constant()) {
+            slot++;
+        }
+    }
+    emitter.epilogue();
+
+    if (!program.jit_code.assign(emitter.get_code())) {
+        return false;
+    }
+    program.jit_entry = program.jit_code.as<RSXFragmentProgram::JitEntry>();
+    return true;
+}
+
+// RSXFragmentProgramCache Implementation
+
+RSXFragmentProgramCache::RSXFragmentProgramCache()
+    : disk_cache(nullptr)
+    , jit_available(Core::get_host_cpu_features().avx2)
+    , jit_enabled(Core::get_host_cpu_features().avx2)
+    , hits(0)
+    , misses(0) {
+}
+
+void RSXFragmentProgramCache::set_jit_enabled(bool enabled) {
+    jit_enabled = enabled && jit_available;
+}
+
+void RSXFragmentProgramCache::clear() {
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    programs.clear();
+}
+
+size_t RSXFragmentProgramCache::size() const {
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    return programs.size();
+}
+
+bool RSXFragmentProgramCache::load_microcode(const uint8_t* src, size_t available, std::vector<uint32_t>& words) {
+    words.clear();
+    if (!src) {
+        return false;
+    }
+
+    size_t slots = std::min<size_t>(available / 16, RSX_FP_MAX_INSTRUCTIONS);
+    for (size_t slot = 0; slot < slots; slot++) {
+        // Big-endian words with their 16-bit halves swapped
+        for (uint32_t i = 0; i < 4; i++) {
+            const uint8_t* p = src + slot * 16 + i * 4;
+            words.push_back((static_cast<uint32_t>(p[2]) << 24) | (static_cast<uint32_t>(p[3]) << 16) |
+                            (static_cast<uint32_t>(p[0]) << 8) | static_cast<uint32_t>(p[1]));
+        }
+
+        const uint32_t* w = words.data() + slot * 4;
+        RSXFragmentInstruction instr{ w[0], w[1], w[2], w[3] };
+        if (instr.has_constant()) {
+            if (slot + 1 >= slots) {
+                return false;
+            }
+            slot++;
+            for (uint32_t i = 0; i < 4; i++) {
+                const uint8_t* p = src + slot * 16 + i * 4;
+                words.push_back((static_cast<uint32_t>(p[2]) << 24) | (static_cast<uint32_t>(p[3]) << 16) |
+                                (static_cast<uint32_t>(p[0]) << 8) | static_cast<uint32_t>(p[1]));
+            }
+        }
+        if (instr.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const RSXFragmentProgram* RSXFragmentProgramCache::get(const std::vector<uint32_t>& words,
+                                                       const uint32_t* texture_formats, uint32_t surface_format) {
+    return lookup(words.data(), words.size(), texture_formats, surface_format, true);
+}
+
+bool RSXFragmentProgramCache::preload(const uint32_t* words, size_t count, const uint32_t* texture_formats,
+                                      uint32_t surface_format) {
+    if (count % 4 != 0 || count / 4 > RSX_FP_MAX_INSTRUCTIONS) {
+        return false;
+    }
+    return lookup(words, count, texture_formats, surface_format, false) != nullptr;
+}
+
+const RSXFragmentProgram* RSXFragmentProgramCache::lookup(const uint32_t* words, size_t count,
+                                                          const uint32_t* texture_formats, uint32_t surface_format,
+                                                          bool from_draw) {
+    size_t slots = count / 4;
+    if (slots == 0) {
+        return nullptr;
+    }
+
+    // Only the units the program samples take part in the key, and only the
+    // instruction slots: inline constants are read per draw
+    uint64_t hash = RSX_HASH_SEED;
+    uint32_t texture_mask = 0;
+    bool writes_r0 = false;
+    for (size_t slot = 0; slot < slots; slot++) {
+        RSXFragmentInstruction instr{ words[slot * 4], words[slot * 4 + 1], words[slot * 4 + 2], words[slot * 4 + 3] };
+        hash = rsx_hash_words(words + slot * 4, 4, hash);
+        if (!instr.is_branch() && is_texture_op(instr.opcode())) {
+            texture_mask |= 1u << instr.tex_num();
+        }
+        if (!instr.is_branch() && !instr.no_dest() && !instr.dst_half() && instr.dst_reg() == 0) {
+            writes_r0 = true;
+        }
+        if (instr.has_constant()) {
+            slot++;
+        }
+    }
+
+    uint32_t formats[RSX_FP_MAX_TEXTURES] = {};
+    for (uint32_t unit = 0; unit < RSX_FP_MAX_TEXTURES; unit++) {
+        if (texture_mask & (1u << unit)) {
+            formats[unit] = texture_formats[unit];
+        }
+    }
+
+    hash = rsx_hash_words(formats, RSX_FP_MAX_TEXTURES, hash);
+    hash = rsx_hash_words(&surface_format, 1, hash);
+
+    auto matches = [&](const RSXFragmentProgram& program) {
+        if (program.instructions.size() != slots || program.surface_format != surface_format ||
+            std::memcmp(program.texture_formats, formats, sizeof(formats)) != 0) {
+            return false;
+        }
+        for (size_t slot = 0; slot < slots; slot++) {
+            if (std::memcmp(&program.instructions[slot], words + slot * 4, 16) != 0) {
+                return false;
+            }
+            if (program.instructions[slot].has_constant()) {
+                slot++;
+            }
+        }
+        return true;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(programs_mutex);
+        auto it = programs.find(hash);
+        if (it != programs.end() && matches(*it->second)) {
+            if (from_draw) {
+                hits++;
+            }
+            return it->second.get();
+        }
+    }
+
+    // Decode and compile outside the lock so warm-up workers run in parallel
+    auto program = std::make_unique<RSXFragmentProgram>();
+    program->hash = hash;
+    program->instructions.resize(slots);
+    std::memcpy(program->instructions.data(), words, slots * 16);
+    for (size_t slot = 0; slot + 1 < slots; slot++) {
+        if (program->instructions[slot].has_constant()) {
+            program->instructions[++slot] = RSXFragmentInstruction{};
+        }
+    }
+    program->texture_mask = texture_mask;
+    std::memcpy(program->texture_formats, formats, sizeof(formats));
+    program->surface_format = surface_format;
+    for (uint32_t unit = 0; unit < RSX_FP_MAX_TEXTURES; unit++) {
+        if (texture_mask & (1u << unit)) {
+            program->samplers[unit] = RSXTextureSampler::get_sample_function(formats[unit]);
+        }
+    }
+    program->pack = get_pack_function(surface_format);
+    program->output_half = !writes_r0;
+
+    if (jit_available) {
+        RSXFragmentProgramCompiler::compile(*program);
+    }
+
+    if (from_draw) {
+        misses++;
+        if (disk_cache) {
+            disk_cache->store_fragment_program(hash, surface_format, formats, words, slots * 4);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    std::unique_ptr<RSXFragmentProgram>& entry = programs[hash];
+    if (entry && matches(*entry)) {
+        return entry.get();  // Built concurrently by another thread
+    }
+    if (entry && !from_draw) {
+        return nullptr;      // Hash collision: keep the program in use
+    }
+    entry = std::move(program);
+    return entry.get();
+}
+
+void RSXFragmentProgramCache::execute(const RSXFragmentProgram& program, RSXFragmentBatch& batch,
+                                      const uint32_t* constants) const {
+    // Compiled sampling reads the batch's sampler states unchecked
+    if (jit_enabled && program.jit_entry && (batch.samplers || !program.texture_mask)) {
+        program.jit_entry(&batch, constants);
+    } else {
+        RSXFragmentProgramInterpreter::execute(program, batch, constants);
+    }
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,318 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Fragment Program Header
+ *
+ * NV40 fragment program microcode: decoding, a reference interpreter and
+ * an AVX2 JIT that shades two 2x2 quads (8 pixels) per instruction.
+ */
+
+#ifndef GSCX_MODULES_RSX_FRAGMENT_PROGRAM_H
+#define GSCX_MODULES_RSX_FRAGMENT_PROGRAM_H
+
+#include "rsx_texture_sampler.h"
+#include "../../../core/include/exec_memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+class RSXShaderDiskCache;
+
+// Fragment program limits
+static constexpr uint32_t RSX_FP_MAX_INSTRUCTIONS = 4096;
+static constexpr uint32_t RSX_FP_INPUTS = 15;
+static constexpr uint32_t RSX_FP_TEMPS = 64;
+static constexpr uint32_t RSX_FP_MAX_TEXTURES = 16;
+static constexpr uint32_t RSX_FP_LITERALS = 10;
+static constexpr uint32_t RSX_FP_BATCH_SIZE = RSX_SAMPLER_LANES;
+
+// Input attribute registers
+enum RSXFPInput {
+    RSX_FP_INPUT_WPOS = 0,
+    RSX_FP_INPUT_COL0 = 1,
+    RSX_FP_INPUT_COL1 = 2,
+    RSX_FP_INPUT_FOGC = 3,
+    RSX_FP_INPUT_TEX0 = 4,   // TEX0-TEX9 follow
+    RSX_FP_INPUT_SSA = 14    // Facing
+};
+
+/**
+ * RSX Fragment Batch
+ *
+ * Register file for 8 pixels in SoA layout: [register][component][lane].
+ * Lanes 0-3 and 4-7 are two 2x2 quads ordered (0,0) (1,0) (0,1) (1,1),
+ * which DDX/DDY rely on. The rasterizer fills `inputs` and
+ * `color_targets`; the program writes colour through the bound packer.
+ */
+struct alignas(32) RSXFragmentBatch {
+    float inputs[RSX_FP_INPUTS][4][RSX_FP_BATCH_SIZE];
+    float temps[RSX_FP_TEMPS][4][RSX_FP_BATCH_SIZE];       // R registers (fp32)
+    float half_temps[RSX_FP_TEMPS][4][RSX_FP_BATCH_SIZE];  // H registers, kept at fp32 precision
+    float scratch[4][RSX_FP_BATCH_SIZE];                   // JIT staging and texture sample I/O
+    float literals[RSX_FP_LITERALS][RSX_FP_BATCH_SIZE];    // Sign, abs, 1, 0, then output scales
+    uint32_t killed[RSX_FP_BATCH_SIZE];                    // All-ones for discarded pixels
+    uint8_t* color_targets[RSX_FP_BATCH_SIZE];             // Destination pixel, null if not covered
+    const RSXSamplerState* samplers;                       // RSX_FP_MAX_TEXTURES units
+
+    RSXFragmentBatch();
+
+    // Clear per-batch state before the rasterizer fills the next 8 pixels
+    void reset_coverage();
+};
+
+// Writes the output colour planes of covered, live pixels to their targets
+using RSXFragmentPackFn = void (*)(RSXFragmentBatch* batch, const float (*color)[RSX_FP_BATCH_SIZE]);
+
+/**
+ * RSX Fragment Instruction
+ *
+ * One 128-bit instruction slot. Words are stored halfword-swapped in
+ * memory; these accessors expect them already converted. A slot following
+ * an instruction with a constant operand holds that constant instead.
+ */
+struct RSXFragmentInstruction {
+    uint32_t d0, d1, d2, d3;
+
+    // OPDEST
+    bool end() const { return d0 & 1; }
+    uint32_t dst_reg() const { return (d0 >> 1) & 0x3F; }
+    bool dst_half() const { return (d0 >> 7) & 1; }
+    bool set_cond() const { return (d0 >> 8) & 1; }
+    bool mask_has(uint32_t c) const { return (d0 >> (9 + c)) & 1; }
+    uint32_t input_attr() const { return (d0 >> 13) & 0xF; }
+    uint32_t tex_num() const { return (d0 >> 17) & 0xF; }
+    uint32_t opcode() const { return ((d0 >> 24) & 0x3F) | ((d2 >> 31) << 6); }
+    bool no_dest() const { return (d0 >> 30) & 1; }
+    bool saturate() const { return (d0 >> 31) & 1; }
+
+    // SRC0 condition fields
+    bool exec_if_lt() const { return (d1 >> 18) & 1; }
+    bool exec_if_eq() const { return (d1 >> 19) & 1; }
+    bool exec_if_gt() const { return (d1 >> 20) & 1; }
+    bool exec_always() const { return exec_if_lt() && exec_if_eq() && exec_if_gt(); }
+    uint32_t cond_swizzle(uint32_t c) const { return (d1 >> (21 + 2 * c)) & 0x3; }
+    uint32_t cond_mod_reg() const { return (d1 >> 30) & 1; }
+    uint32_t cond_reg() const { return d1 >> 31; }
+
+    // SRC1
+    uint32_t scale() const { return (d2 >> 28) & 0x7; }
+
+    // Flow control (branch opcodes reuse the source words)
+    uint32_t else_slot() const { return (d2 & 0x7FFFFFFF) / 4; }
+    uint32_t end_slot() const { return (d3 & 0x7FFFFFFF) / 4; }
+    uint32_t loop_end() const { return (d2 >> 2) & 0xFF; }
+    uint32_t loop_init() const { return (d2 >> 10) & 0xFF; }
+    uint32_t loop_increment() const { return (d2 >> 19) & 0xFF; }
+
+    // Source operands
+    uint32_t src(uint32_t n) const { return n == 0 ? d1 : (n == 1 ? d2 : d3); }
+    bool src_abs(uint32_t n) const { return n == 0 ? (d1 >> 29) & 1 : (src(n) >> 18) & 1; }
+
+    static uint32_t src_reg_type(uint32_t src) { return src & 0x3; }
+    static uint32_t src_tmp(uint32_t src) { return (src >> 2) & 0x3F; }
+    static bool src_half(uint32_t src) { return (src >> 8) & 1; }
+    static uint32_t src_swizzle(uint32_t src, uint32_t c) { return (src >> (9 + 2 * c)) & 0x3; }
+    static bool src_neg(uint32_t src) { return (src >> 17) & 1; }
+
+    bool is_branch() const { return (d2 >> 31) & 1; }
+    bool has_constant() const;
+};
+
+// Source register types
+enum RSXFPRegisterType {
+    RSX_FP_REG_TEMP = 0,
+    RSX_FP_REG_INPUT = 1,
+    RSX_FP_REG_CONSTANT = 2
+};
+
+// Opcodes; branch opcodes carry bit 6 from SRC1
+enum RSXFPOpcode {
+    RSX_FP_OP_NOP = 0x00,
+    RSX_FP_OP_MOV = 0x01,
+    RSX_FP_OP_MUL = 0x02,
+    RSX_FP_OP_ADD = 0x03,
+    RSX_FP_OP_MAD = 0x04,
+    RSX_FP_OP_DP3 = 0x05,
+    RSX_FP_OP_DP4 = 0x06,
+    RSX_FP_OP_DST = 0x07,
+    RSX_FP_OP_MIN = 0x08,
+    RSX_FP_OP_MAX = 0x09,
+    RSX_FP_OP_SLT = 0x0A,
+    RSX_FP_OP_SGE = 0x0B,
+    RSX_FP_OP_SLE = 0x0C,
+    RSX_FP_OP_SGT = 0x0D,
+    RSX_FP_OP_SNE = 0x0E,
+    RSX_FP_OP_SEQ = 0x0F,
+    RSX_FP_OP_FRC = 0x10,
+    RSX_FP_OP_FLR = 0x11,
+    RSX_FP_OP_KIL = 0x12,
+    RSX_FP_OP_PK4 = 0x13,
+    RSX_FP_OP_UP4 = 0x14,
+    RSX_FP_OP_DDX = 0x15,
+    RSX_FP_OP_DDY = 0x16,
+    RSX_FP_OP_TEX = 0x17,
+    RSX_FP_OP_TXP = 0x18,
+    RSX_FP_OP_TXD = 0x19,
+    RSX_FP_OP_RCP = 0x1A,
+    RSX_FP_OP_RSQ = 0x1B,
+    RSX_FP_OP_EX2 = 0x1C,
+    RSX_FP_OP_LG2 = 0x1D,
+    RSX_FP_OP_LIT = 0x1E,
+    RSX_FP_OP_LRP = 0x1F,
+    RSX_FP_OP_STR = 0x20,
+    RSX_FP_OP_SFL = 0x21,
+    RSX_FP_OP_COS = 0x22,
+    RSX_FP_OP_SIN = 0x23,
+    RSX_FP_OP_PK2 = 0x24,
+    RSX_FP_OP_UP2 = 0x25,
+    RSX_FP_OP_POW = 0x26,
+    RSX_FP_OP_PKB = 0x27,
+    RSX_FP_OP_UPB = 0x28,
+    RSX_FP_OP_PK16 = 0x29,
+    RSX_FP_OP_UP16 = 0x2A,
+    RSX_FP_OP_BEM = 0x2B,
+    RSX_FP_OP_PKG = 0x2C,
+    RSX_FP_OP_UPG = 0x2D,
+    RSX_FP_OP_DP2A = 0x2E,
+    RSX_FP_OP_TXL = 0x2F,
+    RSX_FP_OP_TXB = 0x31,
+    RSX_FP_OP_TEXBEM = 0x33,
+    RSX_FP_OP_TXPBEM = 0x34,
+    RSX_FP_OP_BEMLUM = 0x35,
+    RSX_FP_OP_REFL = 0x36,
+    RSX_FP_OP_TIMESWTEX = 0x37,
+    RSX_FP_OP_DP2 = 0x38,
+    RSX_FP_OP_NRM = 0x39,
+    RSX_FP_OP_DIV = 0x3A,
+    RSX_FP_OP_DIVSQ = 0x3B,
+    RSX_FP_OP_LIF = 0x3C,
+    RSX_FP_OP_FENCT = 0x3D,
+    RSX_FP_OP_FENCB = 0x3E,
+    RSX_FP_OP_BRK = 0x40,
+    RSX_FP_OP_CAL = 0x41,
+    RSX_FP_OP_IFE = 0x42,
+    RSX_FP_OP_LOOP = 0x43,
+    RSX_FP_OP_REP = 0x44,
+    RSX_FP_OP_RET = 0x45
+};
+
+/**
+ * RSX Fragment Program
+ *
+ * A decoded program specialized for the texture formats it samples and
+ * the render-target format it writes: sampling and colour packing are
+ * bound to per-format functions at build time, and the JIT calls them
+ * directly.
+ *
+ * Inline constant slots are zeroed here. Programs patch them in place, so
+ * each run reads them from the draw's microcode (`constants`, indexed like
+ * `instructions` in 32-bit words).
+ */
+struct RSXFragmentProgram {
+    using JitEntry = void (*)(RSXFragmentBatch* batch, const uint32_t* constants);
+
+    uint64_t hash;                        // Microcode (less constants) and specialization key
+    std::vector<RSXFragmentInstruction> instructions;
+    uint32_t texture_mask;                // Units sampled by the program
+    uint32_t texture_formats[RSX_FP_MAX_TEXTURES];
+    uint32_t surface_format;
+    RSXSampleFn samplers[RSX_FP_MAX_TEXTURES];
+    RSXFragmentPackFn pack;
+    bool output_half;                     // Colour comes from H0 rather than R0
+    Core::ExecutableBlock jit_code;
+    JitEntry jit_entry;
+
+    RSXFragmentProgram();
+};
+
+/**
+ * RSX Fragment Program Interpreter
+ *
+ * Reference implementation. Runs each instruction across all 8 pixels
+ * under an execution mask, covering condition codes, IFE/LOOP/REP/BRK
+ * flow control, KIL and derivatives. CAL/RET execute as no-ops.
+ */
+class RSXFragmentProgramInterpreter {
+public:
+    static void execute(const RSXFragmentProgram& program, RSXFragmentBatch& batch, const uint32_t* constants);
+};
+
+/**
+ * RSX Fragment Program JIT
+ *
+ * Compiles straight-line programs to AVX2 code over the SoA batch, one
+ * ymm register per component of 8 pixels. DDX/DDY become in-lane
+ * permutes within each quad. Programs using flow control, condition codes,
+ * conditional KIL, pack/unpack or transcendental ops stay on the
+ * interpreter.
+ */
+class RSXFragmentProgramCompiler {
+public:
+    static bool can_compile(const RSXFragmentProgram& program);
+    static bool compile(RSXFragmentProgram& program);
+};
+
+/**
+ * RSX Fragment Program Cache
+ *
+ * Programs keyed by microcode hash combined with the formats of the
+ * textures the program samples and the render-target format. Inline
+ * constant slots are left out of the key, so patching a constant reuses
+ * the compiled program.
+ */
+class RSXFragmentProgramCache {
+public:
+    RSXFragmentProgramCache();
+
+    // Convert microcode as stored in memory up to the end instruction.
+    // Returns false if no end instruction is found within `available`.
+    static bool load_microcode(const uint8_t* src, size_t available, std::vector<uint32_t>& words);
+
+    // `texture_formats` holds the base format of every unit (0 if unbound)
+    const RSXFragmentProgram* get(const std::vector<uint32_t>& words, const uint32_t* texture_formats,
+                                  uint32_t surface_format);
+
+    // Build a program ahead of use from converted microcode (`count` words).
+    // Safe to call from worker threads while the RSX thread uses get().
+    bool preload(const uint32_t* words, size_t count, const uint32_t* texture_formats, uint32_t surface_format);
+
+    // `constants` is the draw's converted microcode, as passed to get()
+    void execute(const RSXFragmentProgram& program, RSXFragmentBatch& batch, const uint32_t* constants) const;
+
+    void clear();
+    size_t size() const;
+    bool is_jit_enabled() const { return jit_enabled; }
+    void set_jit_enabled(bool enabled);
+
+    // Programs first seen by get() are reported here for persistence
+    void set_disk_cache(RSXShaderDiskCache* cache) { disk_cache = cache; }
+
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_misses() const { return misses; }
+
+    static RSXFragmentPackFn get_pack_function(uint32_t surface_format);
+
+private:
+    std::unordered_map<uint64_t, std::unique_ptr<RSXFragmentProgram>> programs;
+    mutable std::mutex programs_mutex;
+    RSXShaderDiskCache* disk_cache;
+    bool jit_available;
+    bool jit_enabled;
+    uint64_t hits;
+    uint64_t misses;
+
+    const RSXFragmentProgram* lookup(const uint32_t* words, size_t count, const uint32_t* texture_formats,
+                                     uint32_t surface_format, bool from_draw);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_FRAGMENT_PROGRAM_H
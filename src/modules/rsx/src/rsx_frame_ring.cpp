@@ -0,0 +1,209 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Frame Ring Implementation
+ */
+
+#include "rsx_frame_ring.h"
+#include "rsx_core.h"
+#include "rsx_surface_format.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint64_t FRAME_RING_SLOT_ALIGN = 4096;
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static std::atomic_ref<uint64_t> shared_word(uint64_t& word) {
+    return std::atomic_ref<uint64_t>(word);
+}
+
+RSXFrameRing::RSXFrameRing()
+    : header(nullptr)
+    , sequence(0) {
+}
+
+bool RSXFrameRing::create(const std::string& name, uint32_t max_width, uint32_t max_height) {
+    close();
+    if (max_width == 0 || max_height == 0) {
+        return false;
+    }
+
+    uint64_t capacity = align_up(static_cast<uint64_t>(max_width) * max_height * 4, FRAME_RING_SLOT_ALIGN);
+    uint64_t slot_offset = align_up(sizeof(GSCXFrameRingHeader), FRAME_RING_SLOT_ALIGN);
+    if (!region.create(name, static_cast<size_t>(slot_offset + capacity * GSCX_FRAME_RING_SLOTS))) {
+        return false;
+    }
+
+    header = new (region.data()) GSCXFrameRingHeader{};
+    header->magic = GSCX_FRAME_RING_MAGIC;
+    header->version = GSCX_FRAME_RING_VERSION;
+    header->slot_count = GSCX_FRAME_RING_SLOTS;
+    header->header_size = sizeof(GSCXFrameRingHeader);
+    header->slot_offset = slot_offset;
+    header->slot_stride = capacity;
+    header->slot_capacity = capacity;
+    sequence = 0;
+    return true;
+}
+
+void RSXFrameRing::close() {
+    region.release();
+    header = nullptr;
+    sequence = 0;
+}
+
+bool RSXFrameRing::publish(const uint8_t* surface, uint32_t width, uint32_t height,
+                           uint32_t pitch, uint32_t surface_format) {
+    uint64_t frame = stage(surface, width, height, pitch, surface_format);
+    if (frame == 0) {
+        return false;
+    }
+    commit(frame);
+    return true;
+}
+
+uint64_t RSXFrameRing::stage(const uint8_t* surface, uint32_t width, uint32_t height,
+                             uint32_t pitch, uint32_t surface_format) {
+    if (!header || !surface) {
+        return 0;
+    }
+
+    // Color surfaces are converted to BGRA during the copy; the copy is
+    // needed anyway since VRAM is private to this process
+    uint32_t bpp = rsx_get_format_bytes_per_pixel(surface_format);
+    uint32_t format = bpp != 0 ? GSCX_FRAME_FORMAT_BGRA8 : GSCX_FRAME_FORMAT_RAW;
+    uint32_t dst_pitch = format == GSCX_FRAME_FORMAT_BGRA8 ? width * 4 : pitch;
+    uint64_t size = static_cast<uint64_t>(dst_pitch) * height;
+    if (format == GSCX_FRAME_FORMAT_BGRA8 && pitch < static_cast<uint64_t>(width) * bpp) {
+        return 0;
+    }
+    if (size > header->slot_capacity) {
+        return 0;
+    }
+
+    uint64_t frame = sequence + 1;
+    uint32_t index = static_cast<uint32_t>(frame % GSCX_FRAME_RING_SLOTS);
+    GSCXFrameSlot& slot = header->slots[index];
+    uint8_t* dst = region.data() + header->slot_offset + index * header->slot_stride;
+
+    // Mark the slot busy before any pixel store becomes visible
+    shared_word(slot.sequence).store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (format == GSCX_FRAME_FORMAT_BGRA8) {
+        rsx_convert_surface(surface, pitch, surface_format, dst, dst_pitch, RSX_SURFACE_FORMAT_B8G8R8A8,
+                            width, height);
+    } else {
+        std::memcpy(dst, surface, static_cast<size_t>(size));
+    }
+
+    slot.width = width;
+    slot.height = height;
+    slot.pitch = dst_pitch;
+    slot.format = format;
+    slot.source_format = surface_format;
+    slot.size = size;
+
+    // Readers only look at the slot once latest_sequence names it
+    shared_word(slot.sequence).store(frame, std::memory_order_release);
+    sequence = frame;
+    return frame;
+}
+
+void RSXFrameRing::commit(uint64_t frame) {
+    if (!header || frame == 0) {
+        return;
+    }
+    GSCXFrameSlot& slot = header->slots[frame % GSCX_FRAME_RING_SLOTS];
+    slot.present_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    shared_word(header->latest_sequence).store(frame, std::memory_order_release);
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+// Consumer C API
+
+struct GSCXFrameRing {
+    GSCX::Core::SharedMemoryRegion region;
+    GSCXFrameRingHeader* header;
+};
+
+GSCXFrameRing* GSCX_CALL gscx_frame_ring_open(const char* name) {
+    if (!name) {
+        return nullptr;
+    }
+
+    auto* ring = new (std::nothrow) GSCXFrameRing();
+    if (!ring) {
+        return nullptr;
+    }
+    if (!ring->region.open(name, false) || ring->region.size() < sizeof(GSCXFrameRingHeader)) {
+        delete ring;
+        return nullptr;
+    }
+
+    ring->header = reinterpret_cast<GSCXFrameRingHeader*>(ring->region.data());
+    const GSCXFrameRingHeader& header = *ring->header;
+    if (header.magic != GSCX_FRAME_RING_MAGIC || header.version != GSCX_FRAME_RING_VERSION ||
+        header.slot_count != GSCX_FRAME_RING_SLOTS ||
+        header.slot_offset + header.slot_stride * GSCX_FRAME_RING_SLOTS > ring->region.size()) {
+        delete ring;
+        return nullptr;
+    }
+    return ring;
+}
+
+void GSCX_CALL gscx_frame_ring_close(GSCXFrameRing* ring) {
+    delete ring;
+}
+
+int GSCX_CALL gscx_frame_ring_acquire(GSCXFrameRing* ring, uint64_t after_sequence, GSCXFrameView* view) {
+    if (!ring || !view) {
+        return 0;
+    }
+
+    GSCXFrameRingHeader& header = *ring->header;
+    uint64_t frame = std::atomic_ref<uint64_t>(header.latest_sequence).load(std::memory_order_acquire);
+    if (frame == 0 || frame <= after_sequence) {
+        return 0;
+    }
+
+    uint32_t index = static_cast<uint32_t>(frame % GSCX_FRAME_RING_SLOTS);
+    GSCXFrameSlot& slot = header.slots[index];
+    if (std::atomic_ref<uint64_t>(slot.sequence).load(std::memory_order_acquire) != frame) {
+        return 0;
+    }
+
+    view->pixels = ring->region.data() + header.slot_offset + index * header.slot_stride;
+    view->sequence = frame;
+    view->width = slot.width;
+    view->height = slot.height;
+    view->pitch = slot.pitch;
+    view->format = slot.format;
+    view->size = std::min(slot.size, header.slot_capacity);
+    return gscx_frame_ring_validate(ring, view);
+}
+
+int GSCX_CALL gscx_frame_ring_validate(GSCXFrameRing* ring, const GSCXFrameView* view) {
+    if (!ring || !view || view->sequence == 0) {
+        return 0;
+    }
+
+    // Order the caller's pixel reads before the re-check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t index = static_cast<uint32_t>(view->sequence % GSCX_FRAME_RING_SLOTS);
+    return std::atomic_ref<uint64_t>(ring->header->slots[index].sequence).load(std::memory_order_relaxed) ==
+           view->sequence;
+}
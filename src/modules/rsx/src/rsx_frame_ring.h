@@ -0,0 +1,62 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Frame Ring Header
+ *
+ * Producer side of the shared-memory frame ring described in
+ * rsx_frame_ring_c.h.
+ */
+
+#ifndef GSCX_MODULES_RSX_FRAME_RING_H
+#define GSCX_MODULES_RSX_FRAME_RING_H
+
+#include <cstdint>
+#include <string>
+#include "rsx_frame_ring_c.h"
+#include "../../../core/include/shared_memory.h"
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+/**
+ * RSX Frame Ring
+ *
+ * Triple-buffered frame output: each publish converts one surface into
+ * the next slot and then makes it the latest frame. Readers map the same
+ * object and use the pixels in place.
+ *
+ * Flips split the two steps: stage() fills the next slot at swap time and
+ * commit() shows it on a later vblank, possibly from another thread. At
+ * most two frames may be staged ahead of the latest one.
+ */
+class RSXFrameRing {
+public:
+    RSXFrameRing();
+
+    // Slots are sized for `max_width` x `max_height` 32-bit pixels
+    bool create(const std::string& name, uint32_t max_width, uint32_t max_height);
+    void close();
+
+    // `surface` is a display buffer in VRAM layout
+    bool publish(const uint8_t* surface, uint32_t width, uint32_t height,
+                 uint32_t pitch, uint32_t surface_format);
+    // Returns the staged frame number, 0 if the frame does not fit
+    uint64_t stage(const uint8_t* surface, uint32_t width, uint32_t height,
+                   uint32_t pitch, uint32_t surface_format);
+    void commit(uint64_t frame);
+
+    bool is_open() const { return region.valid(); }
+    const std::string& get_name() const { return region.name(); }
+    uint64_t get_sequence() const { return sequence; }
+
+private:
+    Core::SharedMemoryRegion region;
+    GSCXFrameRingHeader* header;
+    uint64_t sequence;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_FRAME_RING_H
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * Shared-memory frame ring written by RSXManager on every present.
+ *
+ * The object holds a header followed by three frame slots. Frame N
+ * (N >= 1) is written to slot N % 3, and latest_sequence is advanced once
+ * it is complete, so the newest frame is never overwritten until two more
+ * have been presented. A slot's sequence reads 0 while it is being
+ * written; a reader that sees the same non-zero sequence before and after
+ * using the pixels has an untorn frame.
+ *
+ * All fields are in host byte order.
+ */
+
+#include <stdint.h>
+#include "../../../core/include/host_services_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GSCX_FRAME_RING_MAGIC 0x52465347u   /* "GSFR" */
+#define GSCX_FRAME_RING_VERSION 1u
+#define GSCX_FRAME_RING_SLOTS 3u
+
+/* Pixel layout of a slot */
+#define GSCX_FRAME_FORMAT_RAW 0u            /* surface bytes as stored in VRAM */
+#define GSCX_FRAME_FORMAT_BGRA8 1u          /* B, G, R, A bytes (QImage::Format_ARGB32 on little endian) */
+
+typedef struct GSCXFrameSlot {
+    uint64_t sequence;                      /* frame number, 0 while being written */
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;                         /* bytes per row */
+    uint32_t format;                        /* GSCX_FRAME_FORMAT_* */
+    uint32_t source_format;                 /* RSXSurfaceFormat of the display buffer */
+    uint32_t reserved;
+    uint64_t size;                          /* valid bytes in the slot */
+    uint64_t present_time_ns;               /* steady clock when the frame was flipped */
+} GSCXFrameSlot;
+
+typedef struct GSCXFrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t header_size;
+    uint64_t slot_offset;                   /* offset of slot 0 pixels from the header */
+    uint64_t slot_stride;
+    uint64_t slot_capacity;
+    uint64_t latest_sequence;               /* newest complete frame, 0 if none */
+    GSCXFrameSlot slots[GSCX_FRAME_RING_SLOTS];
+} GSCXFrameRingHeader;
+
+/* Consumer API: maps the ring read-only in the calling process */
+typedef struct GSCXFrameRing GSCXFrameRing;
+
+typedef struct GSCXFrameView {
+    const uint8_t* pixels;                  /* points into the shared mapping */
+    uint64_t sequence;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+    uint32_t format;
+    uint64_t size;
+} GSCXFrameView;
+
+GSCXFrameRing* GSCX_CALL gscx_frame_ring_open(const char* name);
+void GSCX_CALL gscx_frame_ring_close(GSCXFrameRing* ring);
+
+/* Newest frame newer than `after_sequence`; returns 0 if there is none */
+int GSCX_CALL gscx_frame_ring_acquire(GSCXFrameRing* ring, uint64_t after_sequence, GSCXFrameView* view);
+/* Whether the pixels of an acquired view were left intact; call after blitting */
+int GSCX_CALL gscx_frame_ring_validate(GSCXFrameRing* ring, const GSCXFrameView* view);
+
+#ifdef __cplusplus
+}
+#endif
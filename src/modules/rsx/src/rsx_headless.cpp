@@ -0,0 +1,283 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Headless Recorder Implementation
+ */
+
+#include "rsx_headless.h"
+#include "rsx_core.h"
+#include "rsx_program_hash.h"
+#include "rsx_surface_format.h"
+#include "../../../core/include/logger.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+namespace {
+
+// PNG uses big-endian lengths and a CRC over type + data
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size) {
+    static uint32_t table[256];
+    static bool table_ready = false;
+    if (!table_ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put_be32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+    put_be32(out, static_cast<uint32_t>(data.size()));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_be32(out, crc32_update(0, out.data() + start, out.size() - start));
+}
+
+// Uncompressed (stored) deflate: frames are compared by hash, so file size
+// matters less than keeping the dump off the frame's critical path
+std::vector<uint8_t> encode_png(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, width);
+    put_be32(ihdr, height);
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });    // 8-bit RGBA, no interlace
+    put_chunk(out, "IHDR", ihdr);
+
+    size_t row_bytes = static_cast<size_t>(width) * 4;
+    size_t raw_size = (row_bytes + 1) * height;
+    std::vector<uint8_t> raw(raw_size);
+    for (uint32_t y = 0; y < height; y++) {
+        raw[y * (row_bytes + 1)] = 0;               // filter: none
+        std::memcpy(&raw[y * (row_bytes + 1) + 1], rgba + y * row_bytes, row_bytes);
+    }
+
+    std::vector<uint8_t> idat = { 0x78, 0x01 };
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t offset = 0; offset < raw_size; ) {
+        size_t block = std::min<size_t>(raw_size - offset, 0xFFFF);
+        bool final = offset + block == raw_size;
+        idat.push_back(final ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(block));
+        idat.push_back(static_cast<uint8_t>(block >> 8));
+        idat.push_back(static_cast<uint8_t>(~block));
+        idat.push_back(static_cast<uint8_t>(~block >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + block);
+        for (size_t i = offset; i < offset + block; i++) {
+            adler_a = (adler_a + raw[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        offset += block;
+    }
+    put_be32(idat, (adler_b << 16) | adler_a);
+    put_chunk(out, "IDAT", idat);
+    put_chunk(out, "IEND", {});
+    return out;
+}
+
+std::string escape_json(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+RSXHeadlessRecorder::RSXHeadlessRecorder()
+    : logger(std::make_unique<Core::Logger>("RSXHeadless"))
+    , active(false)
+    , frame_index(0)
+    , last_draw_calls(0)
+    , last_triangles(0) {
+}
+
+RSXHeadlessRecorder::~RSXHeadlessRecorder() {
+    finish();
+}
+
+bool RSXHeadlessRecorder::begin(const RSXHeadlessConfig& settings) {
+    finish();
+    if (settings.first_frame > settings.last_frame || settings.output_dir.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(settings.output_dir, ec);
+    if (ec) {
+        logger->error("Cannot create headless output directory {}: {}", settings.output_dir, ec.message());
+        return false;
+    }
+
+    config = settings;
+    if (config.report_path.empty()) {
+        config.report_path = (std::filesystem::path(config.output_dir) / "report.json").string();
+    }
+    active = true;
+    frame_index = 0;
+    last_draw_calls = 0;
+    last_triangles = 0;
+    last_present = std::chrono::steady_clock::now();
+    records.clear();
+    logger->info("Headless capture: frames {}-{} into {}", config.first_frame, config.last_frame, config.output_dir);
+    return true;
+}
+
+bool RSXHeadlessRecorder::finish() {
+    if (!active) {
+        return true;
+    }
+    active = false;
+    bool written = write_report();
+    if (!written) {
+        logger->error("Failed to write headless report {}", config.report_path);
+    }
+    return written;
+}
+
+void RSXHeadlessRecorder::on_present(const uint8_t* surface, uint32_t width, uint32_t height, uint32_t pitch,
+                                     uint32_t surface_format, uint64_t draw_calls, uint64_t triangles) {
+    if (!active) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double time_ms = std::chrono::duration<double, std::milli>(now - last_present).count();
+    last_present = now;
+
+    uint64_t frame_draws = draw_calls - last_draw_calls;
+    uint64_t frame_triangles = triangles - last_triangles;
+    last_draw_calls = draw_calls;
+    last_triangles = triangles;
+
+    uint32_t frame = frame_index++;
+    if (frame < config.first_frame || frame > config.last_frame) {
+        return;
+    }
+
+    FrameRecord record = { frame, time_ms, frame_draws, frame_triangles, 0, std::string() };
+    if (surface && width && height) {
+        // Hash packed rows so padding in the pitch never affects the result
+        uint32_t bpp = get_surface_bytes_per_pixel(surface_format);
+        size_t row_bytes = static_cast<size_t>(width) * bpp;
+        scratch.resize(row_bytes * height);
+        for (uint32_t y = 0; y < height; y++) {
+            std::memcpy(scratch.data() + y * row_bytes, surface + static_cast<size_t>(y) * pitch, row_bytes);
+        }
+        record.hash = rsx_hash_bytes(scratch.data(), scratch.size());
+        if (config.dump_format != RSXFrameDumpFormat::HASH) {
+            record.file = write_frame(frame, scratch.data(), width, height, bpp, surface_format);
+        }
+    }
+    records.push_back(std::move(record));
+}
+
+std::string RSXHeadlessRecorder::write_frame(uint32_t frame, const uint8_t* packed, uint32_t width, uint32_t height,
+                                             uint32_t bytes_per_pixel, uint32_t surface_format) {
+    char name[64];
+    std::vector<uint8_t> encoded;
+    const uint8_t* data = packed;
+    size_t size = static_cast<size_t>(width) * height * bytes_per_pixel;
+
+    std::vector<uint8_t> rgba;
+    if (config.dump_format == RSXFrameDumpFormat::PNG) {
+        rgba.resize(static_cast<size_t>(width) * height * 4);
+    }
+    if (!rgba.empty() && rsx_convert_surface(packed, width * bytes_per_pixel, surface_format, rgba.data(), width * 4,
+                                             RSX_CANONICAL_FORMAT_RGBA8, width, height)) {
+        encoded = encode_png(rgba.data(), width, height);
+        data = encoded.data();
+        size = encoded.size();
+        std::snprintf(name, sizeof(name), "frame_%06u.png", frame);
+    } else {
+        std::snprintf(name, sizeof(name), "frame_%06u_%ux%u_fmt%02X.raw", frame, width, height, surface_format);
+    }
+
+    std::filesystem::path path = std::filesystem::path(config.output_dir) / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out) {
+        logger->error("Failed to write frame {}", path.string());
+        return std::string();
+    }
+    return name;
+}
+
+bool RSXHeadlessRecorder::write_report() const {
+    std::ofstream out(config.report_path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    double total_ms = 0.0, max_ms = 0.0;
+    uint64_t total_draws = 0, total_triangles = 0;
+    std::vector<double> times;
+    for (const FrameRecord& record : records) {
+        total_ms += record.time_ms;
+        max_ms = std::max(max_ms, record.time_ms);
+        total_draws += record.draw_calls;
+        total_triangles += record.triangles;
+        times.push_back(record.time_ms);
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) {
+        return times.empty() ? 0.0 : times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+    };
+
+    char line[256];
+    out << "{\n  \"frames\": [";
+    for (size_t i = 0; i < records.size(); i++) {
+        const FrameRecord& record = records[i];
+        std::snprintf(line, sizeof(line),
+                      "%s\n    {\"frame\": %u, \"time_ms\": %.3f, \"draw_calls\": %" PRIu64
+                      ", \"triangles\": %" PRIu64 ", \"hash\": \"%016" PRIx64 "\"",
+                      i ? "," : "", record.frame, record.time_ms, record.draw_calls, record.triangles, record.hash);
+        out << line;
+        if (!record.file.empty()) {
+            out << ", \"file\": \"" << escape_json(record.file) << "\"";
+        }
+        out << "}";
+    }
+    std::snprintf(line, sizeof(line),
+                  "\n  ],\n  \"summary\": {\"frames\": %zu, \"mean_ms\": %.3f, \"median_ms\": %.3f"
+                  ", \"p99_ms\": %.3f, \"max_ms\": %.3f",
+                  records.size(), records.empty() ? 0.0 : total_ms / records.size(),
+                  percentile(0.5), percentile(0.99), max_ms);
+    out << line;
+    std::snprintf(line, sizeof(line), ", \"draw_calls\": %" PRIu64 ", \"triangles\": %" PRIu64 "}\n}\n",
+                  total_draws, total_triangles);
+    out << line;
+    return static_cast<bool>(out);
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
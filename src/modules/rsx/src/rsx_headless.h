@@ -0,0 +1,97 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Headless Recorder Header
+ *
+ * Frame capture for runs without a display: selected frames are hashed
+ * and optionally written to disk, and per-frame timing and draw
+ * statistics are reported as JSON for automated regression checks.
+ */
+
+#ifndef GSCX_MODULES_RSX_HEADLESS_H
+#define GSCX_MODULES_RSX_HEADLESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GSCX {
+namespace Core {
+    class Logger;
+}
+
+namespace Modules {
+namespace RSX {
+
+enum class RSXFrameDumpFormat : uint32_t {
+    HASH = 0,       // hash only, nothing written
+    RAW = 1,        // packed surface rows as stored in VRAM
+    PNG = 2         // converted to 8-bit RGBA; unknown surface formats fall back to RAW
+};
+
+struct RSXHeadlessConfig {
+    std::string output_dir;         // frame files; created if missing
+    std::string report_path;        // JSON report; empty for output_dir/report.json
+    uint32_t first_frame;           // frames are numbered from 0 at enable time
+    uint32_t last_frame;            // inclusive
+    RSXFrameDumpFormat dump_format;
+
+    RSXHeadlessConfig() : first_frame(0), last_frame(UINT32_MAX), dump_format(RSXFrameDumpFormat::HASH) {}
+};
+
+/**
+ * RSX Headless Recorder
+ *
+ * Fed once per present. Frame time is measured present to present, so it
+ * covers everything the emulator did for that frame. Draw calls and
+ * triangles are the change in the core's counters since the previous
+ * present.
+ */
+class RSXHeadlessRecorder {
+public:
+    RSXHeadlessRecorder();
+    ~RSXHeadlessRecorder();
+
+    bool begin(const RSXHeadlessConfig& config);
+    // Write the report; returns false if it could not be written
+    bool finish();
+
+    void on_present(const uint8_t* surface, uint32_t width, uint32_t height, uint32_t pitch,
+                    uint32_t surface_format, uint64_t draw_calls, uint64_t triangles);
+
+    bool is_active() const { return active; }
+    // Every selected frame has been recorded
+    bool is_complete() const { return active && frame_index > config.last_frame; }
+    uint32_t get_frame_index() const { return frame_index; }
+
+private:
+    struct FrameRecord {
+        uint32_t frame;
+        double time_ms;
+        uint64_t draw_calls;
+        uint64_t triangles;
+        uint64_t hash;
+        std::string file;
+    };
+
+    std::unique_ptr<Core::Logger> logger;
+    RSXHeadlessConfig config;
+    bool active;
+    uint32_t frame_index;
+    uint64_t last_draw_calls;
+    uint64_t last_triangles;
+    std::chrono::steady_clock::time_point last_present;
+    std::vector<FrameRecord> records;
+    std::vector<uint8_t> scratch;
+
+    std::string write_frame(uint32_t frame, const uint8_t* packed, uint32_t width, uint32_t height,
+                            uint32_t bytes_per_pixel, uint32_t surface_format);
+    bool write_report() const;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_HEADLESS_H
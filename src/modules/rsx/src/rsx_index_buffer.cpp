@@ -0,0 +1,241 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Index Buffer Implementation
+ */
+
+#include "rsx_index_buffer.h"
+#include "rsx_core.h"
+#include "../../../core/include/simd_support.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Scalar conversion
+
+template <typename T>
+static void fetch_indices_scalar(const uint8_t* src, uint32_t count, bool restart_enabled,
+                                 uint32_t restart_index, uint32_t* out, RSXIndexRange& range) {
+    uint32_t min_index = range.min_index;
+    uint32_t max_index = range.max_index;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* p = src + static_cast<size_t>(i) * sizeof(T);
+        uint32_t index = sizeof(T) == 2
+            ? static_cast<uint32_t>((p[0] << 8) | p[1])
+            : (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+              (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+
+        if (restart_enabled && index == restart_index) {
+            out[i] = RSX_INDEX_RESTART;
+            continue;
+        }
+
+        out[i] = index;
+        min_index = std::min(min_index, index);
+        max_index = std::max(max_index, index);
+    }
+
+    range.min_index = min_index;
+    range.max_index = max_index;
+}
+
+// SIMD conversion: restart lanes are forced to all-ones, which drops them
+// out of the min scan and is the restart marker itself; the max scan
+// uses the lanes with restart cleared.
+
+GSCX_TARGET_SSE41 static inline void scan_indices(__m128i indices, __m128i restart_mask,
+                                                  __m128i& vmin, __m128i& vmax, uint32_t* out) {
+    __m128i marked = _mm_or_si128(indices, restart_mask);
+    vmin = _mm_min_epu32(vmin, marked);
+    vmax = _mm_max_epu32(vmax, _mm_andnot_si128(restart_mask, indices));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), marked);
+}
+
+GSCX_TARGET_SSE41 static inline uint32_t reduce_min_epu32(__m128i v) {
+    v = _mm_min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+GSCX_TARGET_SSE41 static inline uint32_t reduce_max_epu32(__m128i v) {
+    v = _mm_max_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_epu32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+GSCX_TARGET_SSE41 static void fetch_indices16_simd(const uint8_t* src, uint32_t count, bool restart_enabled,
+                                                   uint32_t restart_index, uint32_t* out, RSXIndexRange& range) {
+    const __m128i bswap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m128i zero = _mm_setzero_si128();
+    // A 32-bit restart index can never match a 16-bit index
+    const bool restart_active = restart_enabled && restart_index <= 0xFFFF;
+    const __m128i restart = _mm_set1_epi16(static_cast<int16_t>(restart_index & 0xFFFF));
+
+    __m128i vmin = _mm_set1_epi32(-1);
+    __m128i vmax = zero;
+    uint32_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        __m128i indices = _mm_shuffle_epi8(raw, bswap16);
+        __m128i mask = restart_active ? _mm_cmpeq_epi16(indices, restart) : zero;
+
+        scan_indices(_mm_unpacklo_epi16(indices, zero), _mm_unpacklo_epi16(mask, mask), vmin, vmax, out + i);
+        scan_indices(_mm_unpackhi_epi16(indices, zero), _mm_unpackhi_epi16(mask, mask), vmin, vmax, out + i + 4);
+    }
+
+    range.min_index = std::min(range.min_index, reduce_min_epu32(vmin));
+    range.max_index = std::max(range.max_index, reduce_max_epu32(vmax));
+
+    fetch_indices_scalar<uint16_t>(src + i * 2, count - i, restart_active, restart_index, out + i, range);
+}
+
+GSCX_TARGET_SSE41 static void fetch_indices32_simd(const uint8_t* src, uint32_t count, bool restart_enabled,
+                                                   uint32_t restart_index, uint32_t* out, RSXIndexRange& range) {
+    const __m128i bswap32 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i restart = _mm_set1_epi32(static_cast<int32_t>(restart_index));
+
+    __m128i vmin = _mm_set1_epi32(-1);
+    __m128i vmax = zero;
+    uint32_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)), bswap32);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16)), bswap32);
+        __m128i mask_a = restart_enabled ? _mm_cmpeq_epi32(a, restart) : zero;
+        __m128i mask_b = restart_enabled ? _mm_cmpeq_epi32(b, restart) : zero;
+
+        scan_indices(a, mask_a, vmin, vmax, out + i);
+        scan_indices(b, mask_b, vmin, vmax, out + i + 4);
+    }
+
+    range.min_index = std::min(range.min_index, reduce_min_epu32(vmin));
+    range.max_index = std::max(range.max_index, reduce_max_epu32(vmax));
+
+    fetch_indices_scalar<uint32_t>(src + i * 4, count - i, restart_enabled, restart_index, out + i, range);
+}
+
+// RSXIndexFetcher Implementation
+
+RSXIndexFetcher::RSXIndexFetcher()
+    : use_simd(Core::get_host_cpu_features().sse41) {
+}
+
+uint32_t RSXIndexFetcher::get_index_size(uint32_t type) {
+    switch (type) {
+        case RSX_INDEX_TYPE_32:
+            return 4;
+        case RSX_INDEX_TYPE_16:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+bool RSXIndexFetcher::fetch(const uint8_t* src, size_t available, uint32_t count, uint32_t type,
+                            bool restart_enabled, uint32_t restart_index,
+                            std::vector<uint32_t>& out, RSXIndexRange& range) const {
+    range = RSXIndexRange();
+    uint32_t index_size = get_index_size(type);
+    if (!src || index_size == 0 || static_cast<size_t>(count) * index_size > available) {
+        return false;
+    }
+
+    out.resize(count);
+    if (count == 0) {
+        return true;
+    }
+
+    if (type == RSX_INDEX_TYPE_16) {
+        if (use_simd) {
+            fetch_indices16_simd(src, count, restart_enabled, restart_index, out.data(), range);
+        } else {
+            fetch_indices_scalar<uint16_t>(src, count, restart_enabled && restart_index <= 0xFFFF,
+                                           restart_index, out.data(), range);
+        }
+    } else {
+        if (use_simd) {
+            fetch_indices32_simd(src, count, restart_enabled, restart_index, out.data(), range);
+        } else {
+            fetch_indices_scalar<uint32_t>(src, count, restart_enabled, restart_index, out.data(), range);
+        }
+    }
+
+    return true;
+}
+
+// RSXVertexCache Implementation
+
+RSXVertexCache::RSXVertexCache()
+    : hits(0)
+    , misses(0) {
+}
+
+void RSXVertexCache::build(const std::vector<uint32_t>& indices, const RSXIndexRange& range) {
+    unique_vertices.clear();
+    remapped_indices.resize(indices.size());
+
+    if (!range.valid()) {
+        std::fill(remapped_indices.begin(), remapped_indices.end(), RSX_INDEX_RESTART);
+        return;
+    }
+
+    uint32_t span = range.vertex_count();
+    size_t exact_limit = std::max<size_t>(EXACT_TABLE_MIN_SPAN, indices.size() * 4);
+
+    if (span != 0 && span <= exact_limit) {
+        // Exact: one table entry per vertex in range, every vertex transformed once
+        slot_table.assign(span, RSX_INDEX_RESTART);
+
+        for (size_t i = 0; i < indices.size(); i++) {
+            uint32_t index = indices[i];
+            if (index == RSX_INDEX_RESTART) {
+                remapped_indices[i] = RSX_INDEX_RESTART;
+                continue;
+            }
+
+            uint32_t& slot = slot_table[index - range.min_index];
+            if (slot == RSX_INDEX_RESTART) {
+                slot = static_cast<uint32_t>(unique_vertices.size());
+                unique_vertices.push_back(index - range.min_index);
+                misses++;
+            } else {
+                hits++;
+            }
+            remapped_indices[i] = slot;
+        }
+        return;
+    }
+
+    // Sparse: direct-mapped cache, a conflict only costs a duplicate transform
+    slot_table.assign(DIRECT_MAPPED_ENTRIES, 0);
+    tag_table.assign(DIRECT_MAPPED_ENTRIES, RSX_INDEX_RESTART);
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t index = indices[i];
+        if (index == RSX_INDEX_RESTART) {
+            remapped_indices[i] = RSX_INDEX_RESTART;
+            continue;
+        }
+
+        uint32_t line = (index ^ (index >> 12)) & (DIRECT_MAPPED_ENTRIES - 1);
+        if (tag_table[line] == index) {
+            hits++;
+        } else {
+            tag_table[line] = index;
+            slot_table[line] = static_cast<uint32_t>(unique_vertices.size());
+            unique_vertices.push_back(index - range.min_index);
+            misses++;
+        }
+        remapped_indices[i] = slot_table[line];
+    }
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,100 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Index Buffer Header
+ *
+ * Index fetch for indexed draws: big-endian 16/32-bit index conversion,
+ * bounds scan for vertex fetch, primitive restart and post-transform
+ * vertex reuse.
+ */
+
+#ifndef GSCX_MODULES_RSX_INDEX_BUFFER_H
+#define GSCX_MODULES_RSX_INDEX_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Marker left in converted index lists where primitive restart occurred
+static constexpr uint32_t RSX_INDEX_RESTART = 0xFFFFFFFF;
+
+/**
+ * RSX Index Range
+ *
+ * Smallest and largest vertex index referenced by a draw, restart
+ * indices excluded. Invalid when the draw references no vertex.
+ */
+struct RSXIndexRange {
+    uint32_t min_index;
+    uint32_t max_index;
+
+    RSXIndexRange() : min_index(0xFFFFFFFF), max_index(0) {}
+
+    bool valid() const { return min_index <= max_index; }
+    uint32_t vertex_count() const { return valid() ? max_index - min_index + 1 : 0; }
+};
+
+/**
+ * RSX Index Fetcher
+ *
+ * Byte-swaps indices to host order and scans their bounds in the same
+ * pass. Uses SSE4.1 (unsigned 32-bit min/max) when the host has it.
+ */
+class RSXIndexFetcher {
+public:
+    RSXIndexFetcher();
+
+    // Convert `count` indices of `type` (RSXIndexType) from `src` into `out`.
+    // Restart indices become RSX_INDEX_RESTART and do not affect `range`.
+    bool fetch(const uint8_t* src, size_t available, uint32_t count, uint32_t type,
+               bool restart_enabled, uint32_t restart_index,
+               std::vector<uint32_t>& out, RSXIndexRange& range) const;
+
+    static uint32_t get_index_size(uint32_t type);
+
+private:
+    bool use_simd;
+};
+
+/**
+ * RSX Post-Transform Vertex Cache
+ *
+ * Assigns every distinct vertex index of a draw one output slot so each
+ * vertex is transformed once. Draws with a compact index range use an
+ * exact lookup table; sparse ones fall back to a direct-mapped cache.
+ */
+class RSXVertexCache {
+public:
+    RSXVertexCache();
+
+    void build(const std::vector<uint32_t>& indices, const RSXIndexRange& range);
+
+    // Vertex index (relative to range.min_index) to transform for each slot
+    const std::vector<uint32_t>& get_unique_vertices() const { return unique_vertices; }
+    // Draw indices rewritten to slots; restart markers are preserved
+    const std::vector<uint32_t>& get_remapped_indices() const { return remapped_indices; }
+
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_misses() const { return misses; }
+
+private:
+    static constexpr uint32_t DIRECT_MAPPED_ENTRIES = 4096;
+    static constexpr uint32_t EXACT_TABLE_MIN_SPAN = 65536;
+
+    std::vector<uint32_t> slot_table;   // Exact table or direct-mapped slots
+    std::vector<uint32_t> tag_table;    // Direct-mapped tags
+    std::vector<uint32_t> unique_vertices;
+    std::vector<uint32_t> remapped_indices;
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_INDEX_BUFFER_H
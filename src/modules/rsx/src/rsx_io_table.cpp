@@ -0,0 +1,170 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX IO Translation Table Implementation
+ */
+
+#include "rsx_io_table.h"
+#include <thread>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+RSXIOTable::RSXIOTable()
+    : mapped_pages(0)
+    , reader_epoch(0) {
+    for (auto& entry : entries) {
+        entry.store(0, std::memory_order_relaxed);
+    }
+    active_readers[0].store(0, std::memory_order_relaxed);
+    active_readers[1].store(0, std::memory_order_relaxed);
+}
+
+RSXIOTable::ReadSection::ReadSection(const RSXIOTable& table)
+    : table(table)
+    , epoch(table.reader_epoch.load(std::memory_order_seq_cst)) {
+    // Sequentially consistent with the writer's epoch flip: if the epoch
+    // is unchanged after counting in, a writer flipping later sees this
+    // reader. If it moved, the slot may already have been drained by a
+    // writer that missed us, so count into the new epoch instead.
+    for (;;) {
+        table.active_readers[epoch & 1].fetch_add(1, std::memory_order_seq_cst);
+        uint32_t current = table.reader_epoch.load(std::memory_order_seq_cst);
+        if (current == epoch) {
+            break;
+        }
+        table.active_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+        epoch = current;
+    }
+}
+
+RSXIOTable::ReadSection::~ReadSection() {
+    table.active_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+}
+
+void RSXIOTable::Pin::acquire(const ReadSection& section) {
+    release();
+    table = &section.table;
+    epoch = section.epoch;
+    table->active_readers[epoch & 1].fetch_add(1, std::memory_order_seq_cst);
+}
+
+void RSXIOTable::Pin::release() {
+    if (table) {
+        table->active_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+        table = nullptr;
+    }
+}
+
+bool RSXIOTable::check_range(uint64_t io_offset, uint64_t size) {
+    return size != 0 &&
+           (io_offset & (RSX_IO_PAGE_SIZE - 1)) == 0 &&
+           (size & (RSX_IO_PAGE_SIZE - 1)) == 0 &&
+           io_offset <= RSX_IO_SPACE_SIZE &&
+           size <= RSX_IO_SPACE_SIZE - io_offset;
+}
+
+bool RSXIOTable::map(uint64_t io_offset, uint64_t ea, uint64_t size) {
+    if (!check_range(io_offset, size) || (ea & (RSX_IO_PAGE_SIZE - 1)) != 0 ||
+        ea > RSX_IO_EA_LIMIT || size > RSX_IO_EA_LIMIT - ea) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex);
+
+    uint32_t first = static_cast<uint32_t>(io_offset >> RSX_IO_PAGE_SHIFT);
+    uint32_t count = static_cast<uint32_t>(size >> RSX_IO_PAGE_SHIFT);
+    for (uint32_t i = 0; i < count; i++) {
+        if (entries[first + i].load(std::memory_order_relaxed) & ENTRY_VALID) {
+            return false;
+        }
+    }
+
+    // New pages are published before predecessors are extended into them
+    uint32_t ea_page = static_cast<uint32_t>(ea >> RSX_IO_PAGE_SHIFT);
+    for (uint32_t i = 0; i < count; i++) {
+        entries[first + i].store(ENTRY_VALID | (1u << ENTRY_RUN_SHIFT) | (ea_page + i),
+                                 std::memory_order_release);
+    }
+    relink(first, first + count - 1);
+
+    mapped_pages.fetch_add(count, std::memory_order_relaxed);
+    return true;
+}
+
+bool RSXIOTable::unmap(uint64_t io_offset, uint64_t size) {
+    if (!check_range(io_offset, size)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(write_mutex);
+
+        uint32_t first = static_cast<uint32_t>(io_offset >> RSX_IO_PAGE_SHIFT);
+        uint32_t count = static_cast<uint32_t>(size >> RSX_IO_PAGE_SHIFT);
+        for (uint32_t i = 0; i < count; i++) {
+            if (!(entries[first + i].load(std::memory_order_relaxed) & ENTRY_VALID)) {
+                return false;
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            entries[first + i].store(0, std::memory_order_release);
+        }
+        relink(first, first + count - 1);
+
+        mapped_pages.fetch_sub(count, std::memory_order_relaxed);
+        synchronize();
+    }
+    return true;
+}
+
+void RSXIOTable::clear() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    for (auto& entry : entries) {
+        entry.store(0, std::memory_order_release);
+    }
+    mapped_pages.store(0, std::memory_order_relaxed);
+    synchronize();
+}
+
+void RSXIOTable::relink(uint32_t first, uint32_t last) {
+    // Runs only depend on the following page, so walk backwards from the
+    // changed range and stop at the first unaffected predecessor
+    for (int64_t page = last; page >= 0; page--) {
+        uint32_t entry = entries[page].load(std::memory_order_relaxed);
+        if (!(entry & ENTRY_VALID)) {
+            if (static_cast<uint32_t>(page) < first) {
+                break;
+            }
+            continue;
+        }
+
+        uint32_t run = 1;
+        if (static_cast<uint32_t>(page) + 1 < RSX_IO_PAGE_COUNT) {
+            uint32_t next = entries[page + 1].load(std::memory_order_relaxed);
+            if ((next & ENTRY_VALID) && (next & ENTRY_EA_MASK) == (entry & ENTRY_EA_MASK) + 1) {
+                run += (next >> ENTRY_RUN_SHIFT) & ENTRY_RUN_MASK;
+            }
+        }
+
+        uint32_t updated = (entry & ~(ENTRY_RUN_MASK << ENTRY_RUN_SHIFT)) | (run << ENTRY_RUN_SHIFT);
+        if (updated == entry && static_cast<uint32_t>(page) < first) {
+            break;
+        }
+        entries[page].store(updated, std::memory_order_release);
+    }
+}
+
+void RSXIOTable::synchronize() {
+    // Readers that loaded the old epoch may still hold old translations;
+    // later readers observe the entries stored before the flip
+    uint32_t previous = reader_epoch.fetch_add(1, std::memory_order_seq_cst);
+    while (active_readers[previous & 1].load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
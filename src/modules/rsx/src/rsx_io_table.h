@@ -0,0 +1,139 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX IO Translation Table Header
+ *
+ * Flat IOIF offset table mapping the RSX IO address space onto main
+ * memory in 1MB pages, the granularity of the real IO offset table.
+ */
+
+#ifndef GSCX_MODULES_RSX_IO_TABLE_H
+#define GSCX_MODULES_RSX_IO_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint32_t RSX_IO_PAGE_SHIFT = 20;
+static constexpr uint64_t RSX_IO_PAGE_SIZE = 1ull << RSX_IO_PAGE_SHIFT;
+static constexpr uint32_t RSX_IO_PAGE_COUNT = 512;                     // 512MB IO space
+static constexpr uint64_t RSX_IO_SPACE_SIZE = RSX_IO_PAGE_SIZE * RSX_IO_PAGE_COUNT;
+static constexpr uint64_t RSX_IO_EA_LIMIT = 1ull << 32;               // main memory EAs are 32-bit
+
+/**
+ * RSX IO Translation Table
+ *
+ * One atomic word per IO page holds the effective address page it maps
+ * and how many pages from it onward are contiguous in main memory, so a
+ * lookup is a single load that also bounds the readable span.
+ *
+ * Readers never lock. They bracket their use of translated pointers with
+ * a ReadSection; unmap() returns only after every section that might
+ * still see the old mapping has ended, so callers may recycle the memory
+ * immediately afterwards (RCU-style grace period). Work handed to another
+ * thread with translated pointers takes a Pin from the section it
+ * resolved them in, which holds unmap() back until the Pin is released.
+ */
+class RSXIOTable {
+public:
+    RSXIOTable();
+
+    RSXIOTable(const RSXIOTable&) = delete;
+    RSXIOTable& operator=(const RSXIOTable&) = delete;
+
+    class Pin;
+
+    // Scope in which translated pointers stay valid; sections may nest
+    class ReadSection {
+    public:
+        explicit ReadSection(const RSXIOTable& table);
+        ~ReadSection();
+
+        ReadSection(const ReadSection&) = delete;
+        ReadSection& operator=(const ReadSection&) = delete;
+
+    private:
+        friend class Pin;
+
+        const RSXIOTable& table;
+        uint32_t epoch;
+    };
+
+    // Extends a section's grace period past its scope, possibly onto
+    // another thread; empty until acquired
+    class Pin {
+    public:
+        Pin() : table(nullptr), epoch(0) {}
+        ~Pin() { release(); }
+
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+        // `section` must be live, so its epoch cannot have been drained yet
+        void acquire(const ReadSection& section);
+        void release();
+
+    private:
+        const RSXIOTable* table;
+        uint32_t epoch;
+    };
+
+    // Offsets and sizes must be 1MB aligned; fails if any page is already mapped
+    bool map(uint64_t io_offset, uint64_t ea, uint64_t size);
+    // Fails if any page in the range is unmapped; waits out current readers
+    bool unmap(uint64_t io_offset, uint64_t size);
+    void clear();
+
+    // Effective address of `io_offset`; `contiguous` receives the bytes
+    // readable from it without crossing into an unmapped or discontiguous page
+    bool translate(uint64_t io_offset, uint64_t& ea, uint64_t* contiguous) const {
+        if (io_offset >= RSX_IO_SPACE_SIZE) {
+            return false;
+        }
+        uint32_t entry = entries[io_offset >> RSX_IO_PAGE_SHIFT].load(std::memory_order_acquire);
+        if (!(entry & ENTRY_VALID)) {
+            return false;
+        }
+        uint64_t page_offset = io_offset & (RSX_IO_PAGE_SIZE - 1);
+        ea = (static_cast<uint64_t>(entry & ENTRY_EA_MASK) << RSX_IO_PAGE_SHIFT) + page_offset;
+        if (contiguous) {
+            uint64_t run = (entry >> ENTRY_RUN_SHIFT) & ENTRY_RUN_MASK;
+            *contiguous = (run << RSX_IO_PAGE_SHIFT) - page_offset;
+        }
+        return true;
+    }
+
+    uint32_t get_mapped_pages() const { return mapped_pages.load(std::memory_order_relaxed); }
+
+private:
+    // [11:0] EA page, [21:12] contiguous pages from here (1-512), [31] valid
+    static constexpr uint32_t ENTRY_EA_MASK = 0xFFF;
+    static constexpr uint32_t ENTRY_RUN_SHIFT = 12;
+    static constexpr uint32_t ENTRY_RUN_MASK = 0x3FF;
+    static constexpr uint32_t ENTRY_VALID = 0x80000000u;
+
+    std::atomic<uint32_t> entries[RSX_IO_PAGE_COUNT];
+    std::atomic<uint32_t> mapped_pages;
+
+    // Readers count themselves into the current epoch's slot; a writer
+    // flips the epoch and drains the previous slot
+    mutable std::atomic<uint32_t> reader_epoch;
+    mutable std::atomic<uint32_t> active_readers[2];
+
+    // Serializes writers
+    std::mutex write_mutex;
+
+    static bool check_range(uint64_t io_offset, uint64_t size);
+    void relink(uint32_t first, uint32_t last);
+    void synchronize();
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_IO_TABLE_H
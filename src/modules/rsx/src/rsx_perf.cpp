@@ -0,0 +1,244 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Performance Counters Implementation
+ */
+
+#include "rsx_perf.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static const char* const COUNTER_NAMES[RSX_PERF_COUNTER_COUNT] = {
+    "methods", "fifo_bytes", "draws", "vertices", "fragments", "texture_hits", "texture_misses",
+    "parse_ns", "state_ns", "raster_ns"
+};
+
+static const char* const STAGE_NAMES[RSX_PERF_STAGE_COUNT] = { "parse", "state", "raster" };
+
+// Trace track of the frame spans; stages follow it
+static constexpr uint32_t TRACE_FRAME_TID = 0;
+
+const char* rsx_get_perf_counter_name(RSXPerfCounter counter) {
+    return counter < RSX_PERF_COUNTER_COUNT ? COUNTER_NAMES[counter] : "unknown";
+}
+
+RSXPerfMonitor::RSXPerfMonitor()
+    : frame_base()
+    , frame_start_ns(now_ns())
+    , frame_number(0)
+    , tracing(false)
+    , trace_start_ns(0) {
+    for (auto& total : totals) {
+        total.store(0, std::memory_order_relaxed);
+    }
+    for (auto& trace : stage_traces) {
+        trace.dropped = 0;
+    }
+}
+
+uint64_t RSXPerfMonitor::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void RSXPerfMonitor::end_span(RSXPerfStage stage, const char* name, uint64_t start_ns,
+                              const char* arg_name, uint64_t arg) {
+    uint64_t duration = now_ns() - start_ns;
+    add(static_cast<RSXPerfCounter>(static_cast<uint32_t>(RSX_PERF_PARSE_NS) + stage), duration);
+    if (!tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    StageTrace& trace = stage_traces[stage];
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (trace.spans.size() < RSX_TRACE_MAX_SPANS) {
+        trace.spans.push_back({ start_ns, duration, name, arg_name, arg });
+    } else {
+        trace.dropped++;
+    }
+}
+
+void RSXPerfMonitor::end_frame() {
+    RSXFrameCounters counters;
+    counters.end_ns = now_ns();
+
+    std::lock_guard<std::mutex> lock(history_mutex);
+    counters.frame = ++frame_number;
+    counters.start_ns = frame_start_ns;
+    for (uint32_t i = 0; i < RSX_PERF_COUNTER_COUNT; i++) {
+        uint64_t total = totals[i].load(std::memory_order_relaxed);
+        counters.values[i] = total - frame_base[i];
+        frame_base[i] = total;
+    }
+    frame_start_ns = counters.end_ns;
+
+    history.push_back(counters);
+    if (history.size() > RSX_PERF_HISTORY) {
+        history.pop_front();
+    }
+    if (tracing.load(std::memory_order_relaxed)) {
+        trace_frames.push_back(counters);
+    }
+}
+
+void RSXPerfMonitor::reset() {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    for (uint32_t i = 0; i < RSX_PERF_COUNTER_COUNT; i++) {
+        frame_base[i] = totals[i].load(std::memory_order_relaxed);
+    }
+    frame_start_ns = now_ns();
+    frame_number = 0;
+    history.clear();
+}
+
+RSXFrameCounters RSXPerfMonitor::get_last_frame() const {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    return history.empty() ? RSXFrameCounters{} : history.back();
+}
+
+std::vector<RSXFrameCounters> RSXPerfMonitor::get_history() const {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    return std::vector<RSXFrameCounters>(history.begin(), history.end());
+}
+
+RSXFrameCounters RSXPerfMonitor::get_average(size_t frames) const {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    RSXFrameCounters average = {};
+    size_t count = std::min(frames, history.size());
+    if (count == 0) {
+        return average;
+    }
+
+    auto first = history.end() - static_cast<std::ptrdiff_t>(count);
+    average.frame = history.back().frame;
+    average.start_ns = first->start_ns;
+    average.end_ns = history.back().end_ns;
+    for (auto it = first; it != history.end(); ++it) {
+        for (uint32_t i = 0; i < RSX_PERF_COUNTER_COUNT; i++) {
+            average.values[i] += it->values[i];
+        }
+    }
+    for (uint64_t& value : average.values) {
+        value = (value + count / 2) / count;
+    }
+    return average;
+}
+
+void RSXPerfMonitor::start_trace() {
+    for (auto& trace : stage_traces) {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.spans.clear();
+        trace.dropped = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        trace_frames.clear();
+    }
+    trace_start_ns = now_ns();
+    tracing.store(true, std::memory_order_release);
+}
+
+bool RSXPerfMonitor::stop_trace(const std::string& path) {
+    if (!tracing.exchange(false, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    std::vector<Span> spans[RSX_PERF_STAGE_COUNT];
+    uint64_t dropped = 0;
+    for (uint32_t stage = 0; stage < RSX_PERF_STAGE_COUNT; stage++) {
+        std::lock_guard<std::mutex> lock(stage_traces[stage].mutex);
+        spans[stage].swap(stage_traces[stage].spans);
+        dropped += stage_traces[stage].dropped;
+    }
+    std::vector<RSXFrameCounters> frames;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        frames.swap(trace_frames);
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    // Chrome trace timestamps are microseconds; spans before the trace
+    // started (a frame already under way) are clamped to its start
+    auto micros = [&](uint64_t ns) { return (ns > trace_start_ns ? ns - trace_start_ns : 0) / 1000.0; };
+    char line[512];
+    bool first = true;
+    auto begin_event = [&] {
+        out << (first ? "\n    " : ",\n    ");
+        first = false;
+    };
+
+    out << "{\n  \"traceEvents\": [";
+    begin_event();
+    std::snprintf(line, sizeof(line),
+                  "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"frames\"}}",
+                  TRACE_FRAME_TID);
+    out << line;
+    for (uint32_t stage = 0; stage < RSX_PERF_STAGE_COUNT; stage++) {
+        begin_event();
+        std::snprintf(line, sizeof(line),
+                      "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                      TRACE_FRAME_TID + 1 + stage, STAGE_NAMES[stage]);
+        out << line;
+    }
+
+    for (const RSXFrameCounters& frame : frames) {
+        begin_event();
+        std::snprintf(line, sizeof(line),
+                      "{\"name\": \"frame %" PRIu64 "\", \"cat\": \"frame\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f"
+                      ", \"pid\": 1, \"tid\": %u, \"args\": {",
+                      frame.frame, micros(frame.start_ns), micros(frame.end_ns) - micros(frame.start_ns),
+                      TRACE_FRAME_TID);
+        out << line;
+        for (uint32_t i = 0; i < RSX_PERF_COUNTER_COUNT; i++) {
+            std::snprintf(line, sizeof(line), "%s\"%s\": %" PRIu64, i ? ", " : "", COUNTER_NAMES[i], frame.values[i]);
+            out << line;
+        }
+        out << "}}";
+
+        // Counter tracks: one per work counter, sampled at the frame end
+        for (uint32_t i = 0; i < RSX_PERF_PARSE_NS; i++) {
+            begin_event();
+            std::snprintf(line, sizeof(line),
+                          "{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"value\": %" PRIu64 "}}",
+                          COUNTER_NAMES[i], micros(frame.end_ns), frame.values[i]);
+            out << line;
+        }
+    }
+
+    for (uint32_t stage = 0; stage < RSX_PERF_STAGE_COUNT; stage++) {
+        for (const Span& span : spans[stage]) {
+            begin_event();
+            std::snprintf(line, sizeof(line),
+                          "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f"
+                          ", \"pid\": 1, \"tid\": %u",
+                          span.name, STAGE_NAMES[stage], micros(span.start_ns), span.duration_ns / 1000.0,
+                          TRACE_FRAME_TID + 1 + stage);
+            out << line;
+            if (span.arg_name) {
+                std::snprintf(line, sizeof(line), ", \"args\": {\"%s\": %" PRIu64 "}", span.arg_name, span.arg);
+                out << line;
+            }
+            out << "}";
+        }
+    }
+
+    std::snprintf(line, sizeof(line),
+                  "\n  ],\n  \"displayTimeUnit\": \"ms\",\n  \"otherData\": {\"dropped_spans\": %" PRIu64 "}\n}\n",
+                  dropped);
+    out << line;
+    return static_cast<bool>(out);
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
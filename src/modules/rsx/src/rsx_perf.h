@@ -0,0 +1,142 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Performance Counters Header
+ *
+ * Per-frame work and time counters for the RSX pipeline, kept for a
+ * rolling window of frames, and an optional timeline of stage spans
+ * written as Chrome trace JSON (chrome://tracing, Perfetto).
+ */
+
+#ifndef GSCX_MODULES_RSX_PERF_H
+#define GSCX_MODULES_RSX_PERF_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Frames kept by the rolling history
+static constexpr size_t RSX_PERF_HISTORY = 240;
+// Spans kept per trace; later ones are dropped and counted
+static constexpr size_t RSX_TRACE_MAX_SPANS = 1 << 20;
+
+enum RSXPerfStage : uint32_t {
+    RSX_PERF_STAGE_PARSE = 0,       // FIFO parse
+    RSX_PERF_STAGE_STATE = 1,       // method execution and draw packet build
+    RSX_PERF_STAGE_RASTER = 2,      // rasterization and back-end packets
+    RSX_PERF_STAGE_COUNT
+};
+
+enum RSXPerfCounter : uint32_t {
+    RSX_PERF_METHODS = 0,           // methods executed
+    RSX_PERF_FIFO_BYTES,            // command buffer bytes consumed, jumps included
+    RSX_PERF_DRAWS,
+    RSX_PERF_VERTICES,              // vertices fetched (index range for indexed draws)
+    RSX_PERF_FRAGMENTS,             // pixels shaded
+    RSX_PERF_TEXTURE_HITS,          // bound textures read from a cached render target
+    RSX_PERF_TEXTURE_MISSES,        // bound textures read from VRAM or main memory
+    RSX_PERF_PARSE_NS,              // busy time per stage, stalls on a full queue included
+    RSX_PERF_STATE_NS,
+    RSX_PERF_RASTER_NS,
+    RSX_PERF_COUNTER_COUNT
+};
+
+const char* rsx_get_perf_counter_name(RSXPerfCounter counter);
+
+struct RSXFrameCounters {
+    uint64_t frame;                 // numbered from 1 since the last reset
+    uint64_t start_ns;              // steady clock
+    uint64_t end_ns;
+    uint64_t values[RSX_PERF_COUNTER_COUNT];
+
+    uint64_t get(RSXPerfCounter counter) const { return values[counter]; }
+    double get_ms(RSXPerfStage stage) const { return values[static_cast<uint32_t>(RSX_PERF_PARSE_NS) + stage] / 1e6; }
+};
+
+/**
+ * RSX Perf Monitor
+ *
+ * Counters are running totals with one writer each: a counter belongs to
+ * the stage that updates it, or to callers holding the state mutex, so
+ * updates are plain loads and stores. end_frame() runs with the pipeline
+ * idle and turns the totals into per-frame deltas.
+ *
+ * While a trace is open every stage also records a span per unit of work:
+ * a FIFO parse pass, a batch of methods, a draw or back-end packet.
+ */
+class RSXPerfMonitor {
+public:
+    RSXPerfMonitor();
+
+    RSXPerfMonitor(const RSXPerfMonitor&) = delete;
+    RSXPerfMonitor& operator=(const RSXPerfMonitor&) = delete;
+
+    void add(RSXPerfCounter counter, uint64_t amount) {
+        std::atomic<uint64_t>& total = totals[counter];
+        total.store(total.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Timestamp for begin/end pairs
+    static uint64_t now_ns();
+    // Adds the time since `start_ns` to the stage and records a span if
+    // tracing; `arg_name` may be null
+    void end_span(RSXPerfStage stage, const char* name, uint64_t start_ns,
+                  const char* arg_name = nullptr, uint64_t arg = 0);
+
+    void end_frame();
+    void reset();
+
+    // Rolling metrics
+    RSXFrameCounters get_last_frame() const;
+    // Oldest first, at most RSX_PERF_HISTORY frames
+    std::vector<RSXFrameCounters> get_history() const;
+    // Per-frame mean over the newest `frames` frames of the history
+    RSXFrameCounters get_average(size_t frames = RSX_PERF_HISTORY) const;
+
+    // Timeline
+    void start_trace();
+    // Writes everything since start_trace; false if no trace is open or the
+    // file cannot be written
+    bool stop_trace(const std::string& path);
+    bool is_tracing() const { return tracing.load(std::memory_order_relaxed); }
+
+private:
+    struct Span {
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        const char* name;
+        const char* arg_name;
+        uint64_t arg;
+    };
+
+    struct StageTrace {
+        std::mutex mutex;
+        std::vector<Span> spans;
+        uint64_t dropped;
+    };
+
+    std::atomic<uint64_t> totals[RSX_PERF_COUNTER_COUNT];
+    uint64_t frame_base[RSX_PERF_COUNTER_COUNT];
+    uint64_t frame_start_ns;
+    uint64_t frame_number;
+
+    mutable std::mutex history_mutex;
+    std::deque<RSXFrameCounters> history;
+
+    std::atomic<bool> tracing;
+    uint64_t trace_start_ns;
+    StageTrace stage_traces[RSX_PERF_STAGE_COUNT];
+    std::vector<RSXFrameCounters> trace_frames;     // Guarded by history_mutex
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_PERF_H
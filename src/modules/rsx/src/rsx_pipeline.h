@@ -0,0 +1,199 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Pipeline Header
+ *
+ * Work items and queues between the stages of the RSX front end:
+ * FIFO parse -> state resolve / draw packet build -> rasterization.
+ * Each stage runs on its own thread, so parsing and building the next
+ * draw overlaps rasterizing the previous one.
+ */
+
+#ifndef GSCX_MODULES_RSX_PIPELINE_H
+#define GSCX_MODULES_RSX_PIPELINE_H
+
+#include "rsx_vertex_fetch.h"
+#include "rsx_fragment_program.h"
+#include "rsx_io_table.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+struct RSXSurface;
+
+// Queue depths; both are powers of two
+static constexpr size_t RSX_METHOD_QUEUE_SIZE = 4096;
+static constexpr size_t RSX_DRAW_QUEUE_SIZE = 4;
+
+// Method word that tells the state stage to exit
+static constexpr uint32_t RSX_PIPELINE_STOP = 0xFFFFFFFF;
+
+/**
+ * RSX Ring Queue
+ *
+ * Bounded single-producer single-consumer queue. The producer owns
+ * `tail`, the consumer owns `head`; each keeps a cached copy of the
+ * other's index so the shared line is only read when the cache says the
+ * queue is full or empty. Blocking calls sleep on the index they wait
+ * for (futex-backed std::atomic wait) rather than spinning.
+ */
+template <typename T, size_t Capacity>
+class RSXRingQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    RSXRingQueue() : head(0), tail(0), cached_head(0), cached_tail(0) {}
+
+    RSXRingQueue(const RSXRingQueue&) = delete;
+    RSXRingQueue& operator=(const RSXRingQueue&) = delete;
+
+    bool try_push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head >= Capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head >= Capacity) {
+                return false;
+            }
+        }
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    void push(const T& value) {
+        while (!try_push(value)) {
+            size_t h = cached_head;
+            head.wait(h, std::memory_order_acquire);
+        }
+    }
+
+    bool try_pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                return false;
+            }
+        }
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    T pop() {
+        T value;
+        while (!try_pop(value)) {
+            size_t t = cached_tail;
+            tail.wait(t, std::memory_order_acquire);
+        }
+        return value;
+    }
+
+    // Pop up to `max` items, blocking only until the first is available
+    size_t pop_batch(T* out, size_t max) {
+        out[0] = pop();
+        size_t count = 1;
+        while (count < max && try_pop(out[count])) {
+            count++;
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t LINE = 64;
+
+    alignas(LINE) std::atomic<size_t> head;
+    alignas(LINE) std::atomic<size_t> tail;
+    alignas(LINE) size_t cached_head;      // Producer's view of head
+    alignas(LINE) size_t cached_tail;      // Consumer's view of tail
+    alignas(LINE) T slots[Capacity];
+};
+
+/**
+ * RSX Method Packet
+ *
+ * One method write decoded from the FIFO.
+ */
+struct RSXMethodPacket {
+    uint32_t method;
+    uint32_t arg;
+};
+
+/**
+ * Draw packet types
+ *
+ * Besides draws, the raster stage applies the back-end operations that
+ * must see every earlier draw finished: semaphore releases, reports and
+ * notifies.
+ */
+enum class RSXPacketType : uint32_t {
+    DRAW,
+    RELEASE,            // label = index, value
+    REPORT,             // label = RSXReportType, report = destination
+    CLEAR_REPORT,       // label = RSXReportType
+    NOTIFY
+};
+
+/**
+ * RSX Draw Packet
+ *
+ * Everything the rasterizer needs for one draw, resolved by the state
+ * stage: transformed vertices, the primitive topology, the bound fragment
+ * program with its samplers and the color surface. Packets are pooled and
+ * recycled, so their vectors keep their capacity between draws.
+ */
+struct RSXDrawPacket {
+    RSXPacketType type;
+    bool count_zpass;                           // Pixels count towards ZPASS reports
+
+    // Back-end operations
+    uint32_t label;
+    uint32_t value;
+    uint32_t report_dma;                        // Report context DMA when the report was requested
+    uint32_t report_offset;                     // Translated by the raster stage when it writes
+
+    uint32_t mode;                              // RSXPrimitiveType
+    uint32_t vertex_count;
+    std::vector<RSXVertexStream> outputs;       // Vertex program outputs (RSX_VP_OUTPUTS)
+    std::vector<uint32_t> indices;              // Output slots with restarts; empty for sequential
+
+    const RSXFragmentProgram* fragment_program;
+    std::vector<uint32_t> fragment_constants;   // Draw's microcode; the program reads its inline constants here
+    RSXSamplerState samplers[RSX_FP_MAX_TEXTURES];
+    RSXIOTable::Pin io_pin;                     // Held while samplers point into main memory
+
+    // Color surface: the surface cache's host copy, marked dirty once drawn
+    RSXSurface* surface;
+    uint8_t* color;
+    uint32_t color_pitch;
+    uint32_t color_bpp;
+    uint32_t surface_width;
+    uint32_t surface_height;
+
+    // Viewport transform
+    float viewport_x, viewport_y;
+    float viewport_width, viewport_height;
+    float depth_near, depth_far;
+
+    RSXDrawPacket()
+        : type(RSXPacketType::DRAW), count_zpass(false), label(0), value(0), report_dma(0), report_offset(0)
+        , mode(0), vertex_count(0), fragment_program(nullptr), surface(nullptr), color(nullptr), color_pitch(0)
+        , color_bpp(4), surface_width(0), surface_height(0), viewport_x(0.0f), viewport_y(0.0f)
+        , viewport_width(0.0f), viewport_height(0.0f), depth_near(0.0f), depth_far(1.0f) {}
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_PIPELINE_H
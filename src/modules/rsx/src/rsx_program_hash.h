@@ -0,0 +1,37 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Program Hash Header
+ *
+ * 64-bit FNV-1a used to key shader microcode and program state.
+ */
+
+#ifndef GSCX_MODULES_RSX_PROGRAM_HASH_H
+#define GSCX_MODULES_RSX_PROGRAM_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint64_t RSX_HASH_SEED = 0xCBF29CE484222325ULL;
+
+inline uint64_t rsx_hash_bytes(const void* data, size_t size, uint64_t hash = RSX_HASH_SEED) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+inline uint64_t rsx_hash_words(const uint32_t* words, size_t count, uint64_t hash = RSX_HASH_SEED) {
+    return rsx_hash_bytes(words, count * sizeof(uint32_t), hash);
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_PROGRAM_HASH_H
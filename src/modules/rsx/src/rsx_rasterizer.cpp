@@ -0,0 +1,300 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Rasterizer Implementation
+ */
+
+#include "rsx_rasterizer.h"
+#include "rsx_core.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+namespace {
+
+// Fragment inputs interpolated from vertex outputs, excluding WPOS and SSA
+struct AttributeRoute {
+    uint32_t fp_input;
+    uint32_t vp_output;
+};
+
+static constexpr AttributeRoute ATTRIBUTE_ROUTES[] = {
+    { RSX_FP_INPUT_COL0, RSX_VP_OUTPUT_COL0 },
+    { RSX_FP_INPUT_COL1, RSX_VP_OUTPUT_COL1 },
+    { RSX_FP_INPUT_FOGC, RSX_VP_OUTPUT_FOGC },
+    { RSX_FP_INPUT_TEX0 + 0, RSX_VP_OUTPUT_TEX0 + 0 },
+    { RSX_FP_INPUT_TEX0 + 1, RSX_VP_OUTPUT_TEX0 + 1 },
+    { RSX_FP_INPUT_TEX0 + 2, RSX_VP_OUTPUT_TEX0 + 2 },
+    { RSX_FP_INPUT_TEX0 + 3, RSX_VP_OUTPUT_TEX0 + 3 },
+    { RSX_FP_INPUT_TEX0 + 4, RSX_VP_OUTPUT_TEX0 + 4 },
+    { RSX_FP_INPUT_TEX0 + 5, RSX_VP_OUTPUT_TEX0 + 5 },
+    { RSX_FP_INPUT_TEX0 + 6, RSX_VP_OUTPUT_TEX0 + 6 },
+    { RSX_FP_INPUT_TEX0 + 7, RSX_VP_OUTPUT_TEX0 + 7 },
+    { RSX_FP_INPUT_TEX0 + 8, RSX_VP_OUTPUT_TEX8 }
+};
+
+static constexpr uint32_t ATTRIBUTE_COUNT = sizeof(ATTRIBUTE_ROUTES) / sizeof(ATTRIBUTE_ROUTES[0]);
+
+// e(x, y) = a*x + b*y + c, positive inside a triangle of positive window-space area
+struct Edge {
+    float a, b, c;
+    bool inclusive;     // Top-left rule: pixels exactly on the edge belong to this triangle
+
+    bool inside(float x, float y, float& value) const {
+        value = a * x + b * y + c;
+        return value > 0.0f || (value == 0.0f && inclusive);
+    }
+};
+
+Edge make_edge(float px, float py, float qx, float qy) {
+    Edge edge;
+    edge.a = py - qy;
+    edge.b = qx - px;
+    edge.c = px * qy - py * qx;
+    // A shared edge appears once in each direction, so exactly one side takes it
+    edge.inclusive = edge.a > 0.0f || (edge.a == 0.0f && edge.b < 0.0f);
+    return edge;
+}
+
+} // namespace
+
+RSXRasterizer::RSXRasterizer()
+    : batch(std::make_unique<RSXFragmentBatch>())
+    , batch_quads(0)
+    , triangles(0)
+    , pixels(0) {
+}
+
+RSXRasterizer::~RSXRasterizer() = default;
+
+void RSXRasterizer::draw(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache) {
+    if (!packet.fragment_program || !packet.color || packet.vertex_count == 0 ||
+        packet.outputs.size() < RSX_VP_OUTPUTS) {
+        return;
+    }
+
+    batch_quads = 0;
+    batch->reset_coverage();
+
+    if (packet.indices.empty()) {
+        size_t filled = sequence.size();
+        if (filled < packet.vertex_count) {
+            sequence.resize(packet.vertex_count);
+            std::iota(sequence.begin() + filled, sequence.end(), static_cast<uint32_t>(filled));
+        }
+        assemble(packet, cache, sequence.data(), packet.vertex_count);
+    } else {
+        // Restart markers split the list into independent primitives
+        const uint32_t* run = packet.indices.data();
+        const uint32_t* end = run + packet.indices.size();
+        for (const uint32_t* p = run; p <= end; p++) {
+            if (p == end || *p == RSX_INDEX_RESTART) {
+                assemble(packet, cache, run, static_cast<uint32_t>(p - run));
+                run = p + 1;
+            }
+        }
+    }
+
+    flush(packet, cache);
+}
+
+void RSXRasterizer::assemble(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache,
+                             const uint32_t* s, uint32_t count) {
+    switch (packet.mode) {
+        case RSX_PRIMITIVE_TRIANGLES:
+            for (uint32_t i = 0; i + 2 < count; i += 3) {
+                draw_triangle(packet, cache, s[i], s[i + 1], s[i + 2]);
+            }
+            break;
+        case RSX_PRIMITIVE_TRIANGLE_STRIP:
+            // Odd triangles swap their first two vertices to keep the winding
+            for (uint32_t i = 2; i < count; i++) {
+                if (i & 1) {
+                    draw_triangle(packet, cache, s[i - 1], s[i - 2], s[i]);
+                } else {
+                    draw_triangle(packet, cache, s[i - 2], s[i - 1], s[i]);
+                }
+            }
+            break;
+        case RSX_PRIMITIVE_TRIANGLE_FAN:
+        case RSX_PRIMITIVE_POLYGON:
+            for (uint32_t i = 2; i < count; i++) {
+                draw_triangle(packet, cache, s[0], s[i - 1], s[i]);
+            }
+            break;
+        case RSX_PRIMITIVE_QUADS:
+            for (uint32_t i = 0; i + 3 < count; i += 4) {
+                draw_triangle(packet, cache, s[i], s[i + 1], s[i + 2]);
+                draw_triangle(packet, cache, s[i], s[i + 2], s[i + 3]);
+            }
+            break;
+        case RSX_PRIMITIVE_QUAD_STRIP:
+            for (uint32_t i = 0; i + 3 < count; i += 2) {
+                draw_triangle(packet, cache, s[i], s[i + 1], s[i + 3]);
+                draw_triangle(packet, cache, s[i], s[i + 3], s[i + 2]);
+            }
+            break;
+        default:
+            // Points and lines
+            break;
+    }
+}
+
+bool RSXRasterizer::setup_vertex(const RSXDrawPacket& packet, uint32_t slot, SetupVertex& vertex) const {
+    const RSXVertexStream& position = packet.outputs[RSX_VP_OUTPUT_HPOS];
+    if (slot >= position.count) {
+        return false;
+    }
+
+    float w = position.components[3][slot];
+    if (!(w > 0.0f)) {
+        return false;
+    }
+    float inv_w = 1.0f / w;
+    float x = position.components[0][slot] * inv_w;
+    float y = position.components[1][slot] * inv_w;
+    float z = position.components[2][slot] * inv_w;
+
+    // Window origin is the top-left corner of the surface
+    vertex.x = packet.viewport_x + (x * 0.5f + 0.5f) * packet.viewport_width;
+    vertex.y = packet.viewport_y + (0.5f - y * 0.5f) * packet.viewport_height;
+    vertex.z = packet.depth_near + (z * 0.5f + 0.5f) * (packet.depth_far - packet.depth_near);
+    vertex.inv_w = inv_w;
+    vertex.slot = slot;
+    return true;
+}
+
+void RSXRasterizer::draw_triangle(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache,
+                                  uint32_t s0, uint32_t s1, uint32_t s2) {
+    SetupVertex v[3];
+    if (!setup_vertex(packet, s0, v[0]) || !setup_vertex(packet, s1, v[1]) || !setup_vertex(packet, s2, v[2])) {
+        return;
+    }
+
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (!(std::fabs(area) > 1e-8f)) {
+        return;
+    }
+    // Window y points down: a positive area is counter-clockwise in clip space, the front face
+    float facing = area > 0.0f ? 1.0f : -1.0f;
+    if (area < 0.0f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    // Edge i is opposite vertex i; e_i / area is vertex i's barycentric weight
+    const Edge edges[3] = {
+        make_edge(v[1].x, v[1].y, v[2].x, v[2].y),
+        make_edge(v[2].x, v[2].y, v[0].x, v[0].y),
+        make_edge(v[0].x, v[0].y, v[1].x, v[1].y)
+    };
+
+    float width = static_cast<float>(packet.surface_width);
+    float height = static_cast<float>(packet.surface_height);
+    float min_xf = std::clamp(std::floor(std::min({ v[0].x, v[1].x, v[2].x })), 0.0f, width);
+    float max_xf = std::clamp(std::ceil(std::max({ v[0].x, v[1].x, v[2].x })), 0.0f, width);
+    float min_yf = std::clamp(std::floor(std::min({ v[0].y, v[1].y, v[2].y })), 0.0f, height);
+    float max_yf = std::clamp(std::ceil(std::max({ v[0].y, v[1].y, v[2].y })), 0.0f, height);
+    // Quads start on even coordinates so DDX/DDY pair the same pixels everywhere
+    uint32_t min_x = static_cast<uint32_t>(min_xf) & ~1u;
+    uint32_t min_y = static_cast<uint32_t>(min_yf) & ~1u;
+    uint32_t max_x = static_cast<uint32_t>(max_xf);
+    uint32_t max_y = static_cast<uint32_t>(max_yf);
+    if (min_x >= max_x || min_y >= max_y) {
+        return;
+    }
+    triangles++;
+
+    // Per-vertex attribute values, gathered once per triangle
+    float attributes[ATTRIBUTE_COUNT][4][3];
+    for (uint32_t a = 0; a < ATTRIBUTE_COUNT; a++) {
+        const RSXVertexStream& stream = packet.outputs[ATTRIBUTE_ROUTES[a].vp_output];
+        for (uint32_t c = 0; c < 4; c++) {
+            for (uint32_t i = 0; i < 3; i++) {
+                attributes[a][c][i] = v[i].slot < stream.count ? stream.components[c][v[i].slot] : 0.0f;
+            }
+        }
+    }
+
+    float inv_area = 1.0f / area;
+    for (uint32_t y = min_y; y < max_y; y += 2) {
+        for (uint32_t x = min_x; x < max_x; x += 2) {
+            // Quad lane order: (0,0) (1,0) (0,1) (1,1)
+            float lx[4], ly[4], bary[3][4];
+            bool covered[4];
+            bool any = false;
+            for (uint32_t lane = 0; lane < 4; lane++) {
+                uint32_t px = x + (lane & 1);
+                uint32_t py = y + (lane >> 1);
+                lx[lane] = static_cast<float>(px) + 0.5f;
+                ly[lane] = static_cast<float>(py) + 0.5f;
+                bool inside = px < packet.surface_width && py < packet.surface_height;
+                for (uint32_t i = 0; i < 3; i++) {
+                    float value;
+                    inside &= edges[i].inside(lx[lane], ly[lane], value);
+                    bary[i][lane] = value * inv_area;
+                }
+                covered[lane] = inside;
+                any |= inside;
+            }
+            if (!any) {
+                continue;
+            }
+
+            uint32_t base = batch_quads * 4;
+            for (uint32_t lane = 0; lane < 4; lane++) {
+                uint32_t slot = base + lane;
+                float p0 = bary[0][lane] * v[0].inv_w;
+                float p1 = bary[1][lane] * v[1].inv_w;
+                float p2 = bary[2][lane] * v[2].inv_w;
+                float inv_sum = 1.0f / (p0 + p1 + p2);
+                p0 *= inv_sum;
+                p1 *= inv_sum;
+                p2 *= inv_sum;
+
+                float (*inputs)[4][RSX_FP_BATCH_SIZE] = batch->inputs;
+                inputs[RSX_FP_INPUT_WPOS][0][slot] = lx[lane];
+                inputs[RSX_FP_INPUT_WPOS][1][slot] = ly[lane];
+                inputs[RSX_FP_INPUT_WPOS][2][slot] = bary[0][lane] * v[0].z + bary[1][lane] * v[1].z + bary[2][lane] * v[2].z;
+                inputs[RSX_FP_INPUT_WPOS][3][slot] = bary[0][lane] * v[0].inv_w + bary[1][lane] * v[1].inv_w +
+                                                     bary[2][lane] * v[2].inv_w;
+                inputs[RSX_FP_INPUT_SSA][0][slot] = facing;
+                for (uint32_t a = 0; a < ATTRIBUTE_COUNT; a++) {
+                    for (uint32_t c = 0; c < 4; c++) {
+                        inputs[ATTRIBUTE_ROUTES[a].fp_input][c][slot] =
+                            p0 * attributes[a][c][0] + p1 * attributes[a][c][1] + p2 * attributes[a][c][2];
+                    }
+                }
+
+                if (covered[lane]) {
+                    uint32_t px = x + (lane & 1);
+                    uint32_t py = y + (lane >> 1);
+                    batch->color_targets[slot] = packet.color + static_cast<size_t>(py) * packet.color_pitch +
+                                                 static_cast<size_t>(px) * packet.color_bpp;
+                    pixels++;
+                }
+            }
+
+            if (++batch_quads == RSX_FP_BATCH_SIZE / 4) {
+                flush(packet, cache);
+            }
+        }
+    }
+}
+
+void RSXRasterizer::flush(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache) {
+    if (batch_quads == 0) {
+        return;
+    }
+    batch->samplers = packet.samplers;
+    cache.execute(*packet.fragment_program, *batch, packet.fragment_constants.data());
+    batch->reset_coverage();
+    batch_quads = 0;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,78 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Rasterizer Header
+ *
+ * Last stage of the RSX pipeline: primitive assembly, triangle setup and
+ * half-space rasterization into 2x2 quads that feed the fragment program.
+ */
+
+#ifndef GSCX_MODULES_RSX_RASTERIZER_H
+#define GSCX_MODULES_RSX_RASTERIZER_H
+
+#include "rsx_pipeline.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Vertex program output registers read by the rasterizer
+static constexpr uint32_t RSX_VP_OUTPUT_HPOS = 0;
+static constexpr uint32_t RSX_VP_OUTPUT_COL0 = 1;
+static constexpr uint32_t RSX_VP_OUTPUT_COL1 = 2;
+static constexpr uint32_t RSX_VP_OUTPUT_FOGC = 5;
+static constexpr uint32_t RSX_VP_OUTPUT_TEX0 = 7;   // TEX0-TEX7; TEX8 is output 15
+static constexpr uint32_t RSX_VP_OUTPUT_TEX8 = 15;
+
+/**
+ * RSX Rasterizer
+ *
+ * Triangles are set up in window space and walked over their bounding
+ * box two quads at a time, one fragment batch per pair. Attributes are
+ * interpolated perspective-correct; lanes of a partly covered quad are
+ * still interpolated so DDX/DDY see the whole quad, but only covered
+ * lanes get a color target. Points and lines are not rasterized, and
+ * triangles with a vertex at or behind the eye (w <= 0) are dropped
+ * rather than clipped. No depth or stencil test is applied yet.
+ */
+class RSXRasterizer {
+public:
+    RSXRasterizer();
+    ~RSXRasterizer();
+
+    RSXRasterizer(const RSXRasterizer&) = delete;
+    RSXRasterizer& operator=(const RSXRasterizer&) = delete;
+
+    void draw(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache);
+
+    uint64_t get_triangles() const { return triangles; }
+    uint64_t get_pixels() const { return pixels; }
+
+private:
+    struct SetupVertex {
+        float x, y, z;      // Window coordinates
+        float inv_w;
+        uint32_t slot;      // Index into the packet's output streams
+    };
+
+    std::unique_ptr<RSXFragmentBatch> batch;
+    uint32_t batch_quads;
+    std::vector<uint32_t> sequence;     // Slots 0..n-1 for non-indexed draws
+    uint64_t triangles;
+    uint64_t pixels;
+
+    void assemble(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache,
+                  const uint32_t* slots, uint32_t count);
+    void draw_triangle(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache,
+                       uint32_t s0, uint32_t s1, uint32_t s2);
+    bool setup_vertex(const RSXDrawPacket& packet, uint32_t slot, SetupVertex& vertex) const;
+    void flush(const RSXDrawPacket& packet, const RSXFragmentProgramCache& cache);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_RASTERIZER_H
@@ -0,0 +1,336 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Shader Disk Cache Implementation
+ *
+ * File layout (host byte order, the cache is not portable between hosts):
+ *   header: magic, version
+ *   record: kind, payload word count, key, checksum, payload words
+ * Vertex payload:   base address, instruction words
+ * Fragment payload: surface format, 16 texture formats, microcode words
+ */
+
+#include "rsx_shader_cache.h"
+#include "rsx_fragment_program.h"
+#include "rsx_program_hash.h"
+#include "rsx_vertex_program.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+namespace {
+
+// Largest payload a valid record can carry (fragment: 17 state words plus
+// 4096 instructions), used to reject corrupted size fields
+constexpr uint32_t MAX_PAYLOAD_WORDS = 1 + RSX_FP_MAX_TEXTURES + RSX_FP_MAX_INSTRUCTIONS * 4;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct RecordHeader {
+    uint32_t kind;
+    uint32_t payload_words;
+    uint64_t key;
+    uint64_t checksum;
+};
+
+uint64_t record_checksum(uint32_t kind, uint64_t key, const uint32_t* payload, size_t count) {
+    uint64_t hash = rsx_hash_bytes(&key, sizeof(key), rsx_hash_words(&kind, 1));
+    return rsx_hash_words(payload, count, hash);
+}
+
+bool read_exact(std::ifstream& in, void* data, size_t size) {
+    in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    return in.good();
+}
+
+bool write_exact(std::ofstream& out, const void* data, size_t size) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    return out.good();
+}
+
+} // namespace
+
+RSXShaderDiskCache::RSXShaderDiskCache()
+    : writer_running(false)
+    , writer_stop(false)
+    , warm_next(0)
+    , warm_pending(0)
+    , warm_loaded(0)
+    , warm_failed(0) {
+}
+
+RSXShaderDiskCache::~RSXShaderDiskCache() {
+    close();
+}
+
+bool RSXShaderDiskCache::open(const std::string& cache_path) {
+    close();
+    path = cache_path;
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    uint64_t valid_size = 0;
+    bool reuse = false;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in.is_open()) {
+            reuse = load_records(in, valid_size);
+        }
+    }
+
+    if (reuse) {
+        // Drop a torn tail so new records follow the last intact one
+        if (std::filesystem::file_size(path, ec) != valid_size && !ec) {
+            std::filesystem::resize_file(path, valid_size, ec);
+        }
+        file.open(path, std::ios::binary | std::ios::out | std::ios::app);
+    } else {
+        records.clear();
+        vertex_keys.clear();
+        fragment_keys.clear();
+        file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        FileHeader header{ RSX_SHADER_CACHE_MAGIC, RSX_SHADER_CACHE_VERSION };
+        if (file.is_open() && !write_exact(file, &header, sizeof(header))) {
+            file.close();
+        }
+        file.flush();
+    }
+    if (!file.is_open()) {
+        return false;
+    }
+
+    writer_stop = false;
+    writer_running = true;
+    writer = std::thread(&RSXShaderDiskCache::writer_loop, this);
+    return true;
+}
+
+void RSXShaderDiskCache::close() {
+    wait_for_warm_load();
+
+    // The writer drains what is queued before it exits
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        writer_stop = true;
+        writer_running = false;
+    }
+    pending_ready.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    if (file.is_open()) {
+        file.close();
+    }
+    pending.clear();
+    records.clear();
+    vertex_keys.clear();
+    fragment_keys.clear();
+}
+
+bool RSXShaderDiskCache::load_records(std::ifstream& in, uint64_t& valid_size) {
+    records.clear();
+    vertex_keys.clear();
+    fragment_keys.clear();
+
+    FileHeader header{};
+    if (!read_exact(in, &header, sizeof(header)) || header.magic != RSX_SHADER_CACHE_MAGIC ||
+        header.version != RSX_SHADER_CACHE_VERSION) {
+        return false;
+    }
+    valid_size = sizeof(header);
+
+    for (;;) {
+        RecordHeader rh{};
+        if (!read_exact(in, &rh, sizeof(rh))) {
+            break;
+        }
+        if ((rh.kind != static_cast<uint32_t>(RSXShaderKind::VERTEX) &&
+             rh.kind != static_cast<uint32_t>(RSXShaderKind::FRAGMENT)) ||
+            rh.payload_words == 0 || rh.payload_words > MAX_PAYLOAD_WORDS) {
+            break;
+        }
+
+        Record record;
+        record.kind = static_cast<RSXShaderKind>(rh.kind);
+        record.key = rh.key;
+        record.payload.resize(rh.payload_words);
+        if (!read_exact(in, record.payload.data(), record.payload.size() * sizeof(uint32_t)) ||
+            record_checksum(rh.kind, rh.key, record.payload.data(), record.payload.size()) != rh.checksum) {
+            break;
+        }
+
+        std::unordered_set<uint64_t>& keys =
+            record.kind == RSXShaderKind::VERTEX ? vertex_keys : fragment_keys;
+        if (keys.insert(record.key).second) {
+            records.push_back(std::move(record));
+        }
+        valid_size += sizeof(rh) + static_cast<uint64_t>(rh.payload_words) * sizeof(uint32_t);
+    }
+    return true;
+}
+
+void RSXShaderDiskCache::queue_record(RSXShaderKind kind, uint64_t key, std::vector<uint32_t> payload) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (!writer_running) {
+            return;
+        }
+
+        std::unordered_set<uint64_t>& keys = kind == RSXShaderKind::VERTEX ? vertex_keys : fragment_keys;
+        if (!keys.insert(key).second) {
+            return;
+        }
+        pending.push_back(Record{ kind, key, std::move(payload) });
+    }
+    pending_ready.notify_one();
+}
+
+bool RSXShaderDiskCache::append_record(const Record& record) {
+    RecordHeader rh{};
+    rh.kind = static_cast<uint32_t>(record.kind);
+    rh.payload_words = static_cast<uint32_t>(record.payload.size());
+    rh.key = record.key;
+    rh.checksum = record_checksum(rh.kind, record.key, record.payload.data(), record.payload.size());
+
+    return write_exact(file, &rh, sizeof(rh)) &&
+           write_exact(file, record.payload.data(), record.payload.size() * sizeof(uint32_t));
+}
+
+void RSXShaderDiskCache::writer_loop() {
+    std::deque<Record> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex);
+            pending_ready.wait(lock, [this]() { return writer_stop || !pending.empty(); });
+            if (pending.empty()) {
+                return;
+            }
+            batch.swap(pending);
+        }
+
+        if (!file.is_open()) {
+            batch.clear();
+            continue;
+        }
+        for (const Record& record : batch) {
+            if (!append_record(record)) {
+                file.close();
+                break;
+            }
+        }
+        batch.clear();
+
+        // Flushed per batch so a crash keeps everything compiled so far
+        if (file.is_open()) {
+            file.flush();
+        }
+    }
+}
+
+void RSXShaderDiskCache::store_vertex_program(uint64_t key, uint32_t base_address, const uint32_t* words, size_t count) {
+    if (count == 0 || count + 1 > MAX_PAYLOAD_WORDS) {
+        return;
+    }
+
+    std::vector<uint32_t> payload;
+    payload.reserve(count + 1);
+    payload.push_back(base_address);
+    payload.insert(payload.end(), words, words + count);
+    queue_record(RSXShaderKind::VERTEX, key, std::move(payload));
+}
+
+void RSXShaderDiskCache::store_fragment_program(uint64_t key, uint32_t surface_format, const uint32_t* texture_formats,
+                                                const uint32_t* words, size_t count) {
+    if (count == 0 || count + 1 + RSX_FP_MAX_TEXTURES > MAX_PAYLOAD_WORDS) {
+        return;
+    }
+
+    std::vector<uint32_t> payload;
+    payload.reserve(count + 1 + RSX_FP_MAX_TEXTURES);
+    payload.push_back(surface_format);
+    payload.insert(payload.end(), texture_formats, texture_formats + RSX_FP_MAX_TEXTURES);
+    payload.insert(payload.end(), words, words + count);
+    queue_record(RSXShaderKind::FRAGMENT, key, std::move(payload));
+}
+
+bool RSXShaderDiskCache::build_record(const Record& record, RSXVertexProgramCache& vertex_cache,
+                                      RSXFragmentProgramCache& fragment_cache) {
+    const std::vector<uint32_t>& payload = record.payload;
+
+    if (record.kind == RSXShaderKind::VERTEX) {
+        if (payload.size() < 5 || (payload.size() - 1) % 4 != 0) {
+            return false;
+        }
+        uint32_t length = static_cast<uint32_t>((payload.size() - 1) / 4);
+        return vertex_cache.preload(payload.data() + 1, length, payload[0]);
+    }
+
+    if (payload.size() < 1 + RSX_FP_MAX_TEXTURES + 4) {
+        return false;
+    }
+    const uint32_t* formats = payload.data() + 1;
+    const uint32_t* words = formats + RSX_FP_MAX_TEXTURES;
+    size_t count = payload.size() - 1 - RSX_FP_MAX_TEXTURES;
+    return fragment_cache.preload(words, count, formats, payload[0]);
+}
+
+void RSXShaderDiskCache::start_warm_load(RSXVertexProgramCache& vertex_cache, RSXFragmentProgramCache& fragment_cache,
+                                         uint32_t workers) {
+    wait_for_warm_load();
+    if (records.empty()) {
+        return;
+    }
+
+    if (workers == 0) {
+        // Leave one hardware thread for the emulated CPUs
+        uint32_t hardware = std::thread::hardware_concurrency();
+        workers = hardware > 1 ? hardware - 1 : 1;
+    }
+    workers = std::min<uint32_t>(workers, static_cast<uint32_t>(records.size()));
+
+    warm_next.store(0, std::memory_order_relaxed);
+    warm_loaded.store(0, std::memory_order_relaxed);
+    warm_failed.store(0, std::memory_order_relaxed);
+    warm_pending.store(workers, std::memory_order_release);
+
+    for (uint32_t i = 0; i < workers; i++) {
+        warm_workers.emplace_back([this, &vertex_cache, &fragment_cache]() {
+            for (;;) {
+                size_t index = warm_next.fetch_add(1, std::memory_order_relaxed);
+                if (index >= records.size()) {
+                    break;
+                }
+                if (build_record(records[index], vertex_cache, fragment_cache)) {
+                    warm_loaded.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    warm_failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            warm_pending.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+}
+
+void RSXShaderDiskCache::wait_for_warm_load() {
+    for (std::thread& worker : warm_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    warm_workers.clear();
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,121 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Shader Disk Cache Header
+ *
+ * Persists the vertex and fragment programs a title uses so they can be
+ * rebuilt by a worker pool at title start, before the first draw needs them.
+ */
+
+#ifndef GSCX_MODULES_RSX_SHADER_CACHE_H
+#define GSCX_MODULES_RSX_SHADER_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+class RSXVertexProgramCache;
+class RSXFragmentProgramCache;
+
+// File identification: "RSXS", bumped whenever decoding or keying changes
+static constexpr uint32_t RSX_SHADER_CACHE_MAGIC = 0x53585352;
+static constexpr uint32_t RSX_SHADER_CACHE_VERSION = 2;
+
+enum class RSXShaderKind : uint32_t {
+    VERTEX = 1,
+    FRAGMENT = 2
+};
+
+/**
+ * RSX Shader Disk Cache
+ *
+ * One file per title. Each record holds everything needed to rebuild a
+ * program: the microcode plus the state it is specialized on (base address
+ * for vertex programs; sampled texture formats and surface format for
+ * fragment programs). Host code is not stored, since it embeds addresses
+ * of this process; it is regenerated from the microcode during warm-up.
+ *
+ * Records are appended as programs are first seen and checksummed, so a
+ * file truncated by a crash loses only its tail. A writer thread does the
+ * file I/O; a miss on the draw path only queues its record.
+ */
+class RSXShaderDiskCache {
+public:
+    RSXShaderDiskCache();
+    ~RSXShaderDiskCache();
+
+    // Load the records of `path` and keep it open for appending. A missing
+    // file or one written by another version starts an empty cache.
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return writer_running; }
+
+    // Rebuild every loaded record into the program caches on `workers`
+    // threads. Returns immediately; draws keep working meanwhile and simply
+    // build the programs they need that are not ready yet.
+    void start_warm_load(RSXVertexProgramCache& vertex_cache, RSXFragmentProgramCache& fragment_cache,
+                         uint32_t workers = 0);
+    void wait_for_warm_load();
+    bool is_warm_loading() const { return warm_pending.load(std::memory_order_acquire) != 0; }
+
+    // Called by the program caches on a miss; duplicates are ignored.
+    // Queues the record for the writer thread and returns.
+    void store_vertex_program(uint64_t key, uint32_t base_address, const uint32_t* words, size_t count);
+    void store_fragment_program(uint64_t key, uint32_t surface_format, const uint32_t* texture_formats,
+                                const uint32_t* words, size_t count);
+
+    size_t get_record_count() const { return records.size(); }
+    uint32_t get_warm_loaded() const { return warm_loaded.load(std::memory_order_relaxed); }
+    uint32_t get_warm_failed() const { return warm_failed.load(std::memory_order_relaxed); }
+
+private:
+    struct Record {
+        RSXShaderKind kind;
+        uint64_t key;
+        std::vector<uint32_t> payload;
+    };
+
+    std::string path;
+    std::ofstream file;                 // Owned by the writer thread while it runs
+    std::vector<Record> records;
+
+    // Records waiting for the writer; keys cover loaded and queued records
+    std::mutex pending_mutex;
+    std::condition_variable pending_ready;
+    std::deque<Record> pending;
+    std::unordered_set<uint64_t> vertex_keys;
+    std::unordered_set<uint64_t> fragment_keys;
+    bool writer_running;
+    bool writer_stop;
+    std::thread writer;
+
+    std::vector<std::thread> warm_workers;
+    std::atomic<size_t> warm_next;
+    std::atomic<uint32_t> warm_pending;
+    std::atomic<uint32_t> warm_loaded;
+    std::atomic<uint32_t> warm_failed;
+
+    bool load_records(std::ifstream& in, uint64_t& valid_size);
+    void queue_record(RSXShaderKind kind, uint64_t key, std::vector<uint32_t> payload);
+    bool append_record(const Record& record);
+    void writer_loop();
+    static bool build_record(const Record& record, RSXVertexProgramCache& vertex_cache,
+                             RSXFragmentProgramCache& fragment_cache);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_SHADER_CACHE_H
@@ -0,0 +1,79 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Surface Cache Implementation
+ */
+
+#include "rsx_surface_cache.h"
+#include <algorithm>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+RSXSurfaceCache::RSXSurfaceCache()
+    : count(0)
+    , use_clock(0)
+    , stats() {
+}
+
+RSXSurface* RSXSurfaceCache::find(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t height) {
+    for (auto& surface : surfaces) {
+        if (surface->offset == offset && surface->pitch == pitch && surface->format == format &&
+            surface->height >= height) {
+            surface->last_used = ++use_clock;
+            return surface.get();
+        }
+    }
+    return nullptr;
+}
+
+RSXSurface* RSXSurfaceCache::create(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t bpp, uint32_t height) {
+    auto surface = std::make_unique<RSXSurface>();
+    surface->offset = offset;
+    surface->pitch = pitch;
+    surface->height = height;
+    surface->format = format;
+    surface->bpp = bpp;
+    surface->last_used = ++use_clock;
+    surface->data.resize(static_cast<size_t>(pitch) * height);
+    surfaces.push_back(std::move(surface));
+    count.store(surfaces.size(), std::memory_order_release);
+    stats.loads++;
+    return surfaces.back().get();
+}
+
+void RSXSurfaceCache::remove(RSXSurface* surface) {
+    auto it = std::find_if(surfaces.begin(), surfaces.end(),
+                           [&](const std::unique_ptr<RSXSurface>& entry) { return entry.get() == surface; });
+    if (it != surfaces.end()) {
+        surfaces.erase(it);
+        count.store(surfaces.size(), std::memory_order_release);
+    }
+}
+
+void RSXSurfaceCache::clear() {
+    surfaces.clear();
+    count.store(0, std::memory_order_release);
+}
+
+RSXSurface* RSXSurfaceCache::get_eviction_candidate() const {
+    if (surfaces.size() < RSX_MAX_SURFACES) {
+        return nullptr;
+    }
+    auto it = std::min_element(surfaces.begin(), surfaces.end(),
+                               [](const std::unique_ptr<RSXSurface>& a, const std::unique_ptr<RSXSurface>& b) {
+                                   return a->last_used < b->last_used;
+                               });
+    return it->get();
+}
+
+RSXSurfaceCacheStats RSXSurfaceCache::get_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    RSXSurfaceCacheStats result = stats;
+    result.surfaces = surfaces.size();
+    return result;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
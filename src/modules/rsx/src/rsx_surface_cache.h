@@ -0,0 +1,111 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Surface Cache Header
+ *
+ * Live render targets keyed by VRAM range and format. Draws render into
+ * a linear host copy of each surface; VRAM only receives the pixels when
+ * something outside the renderer reads it, and textures that alias a
+ * surface sample the host copy directly.
+ */
+
+#ifndef GSCX_MODULES_RSX_SURFACE_CACHE_H
+#define GSCX_MODULES_RSX_SURFACE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Live surfaces before the least recently drawn one is written back and dropped
+static constexpr size_t RSX_MAX_SURFACES = 32;
+
+/**
+ * RSX Surface
+ *
+ * `data` holds pitch * height bytes in the surface format, laid out as
+ * linear VRAM would be. `dirty` is set by the raster stage after each
+ * draw and cleared by whoever writes the surface back.
+ */
+struct RSXSurface {
+    uint32_t offset;        // VRAM offset
+    uint32_t pitch;
+    uint32_t height;
+    uint32_t format;        // RSXSurfaceFormat
+    uint32_t bpp;
+    uint64_t last_used;
+    std::vector<uint8_t> data;
+    std::atomic<bool> dirty;
+
+    RSXSurface() : offset(0), pitch(0), height(0), format(0), bpp(0), last_used(0), dirty(false) {}
+
+    uint32_t get_size() const { return pitch * height; }
+    bool overlaps(uint32_t start, uint32_t size) const {
+        return start < offset + get_size() && offset < start + size;
+    }
+};
+
+struct RSXSurfaceCacheStats {
+    uint64_t surfaces;          // Live now
+    uint64_t loads;             // Surfaces created from VRAM contents
+    uint64_t writebacks;        // Dirty surfaces copied to VRAM
+    uint64_t texture_aliases;   // Texture bindings served from a surface
+};
+
+/**
+ * RSX Surface Cache
+ *
+ * Bookkeeping only: RSXCore moves the pixels, since loads and writebacks
+ * go through its tile regions. Surfaces are created and dropped by the
+ * state stage with the rasterizer drained; other threads only write back
+ * or update surfaces under the cache mutex.
+ */
+class RSXSurfaceCache {
+public:
+    RSXSurfaceCache();
+
+    RSXSurfaceCache(const RSXSurfaceCache&) = delete;
+    RSXSurfaceCache& operator=(const RSXSurfaceCache&) = delete;
+
+    std::mutex& get_mutex() { return mutex; }
+    // Lock-free check for the common no-surface case
+    bool is_empty() const { return count.load(std::memory_order_acquire) == 0; }
+
+    // Caller holds the mutex for everything below
+    RSXSurface* find(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t height);
+    RSXSurface* create(uint32_t offset, uint32_t pitch, uint32_t format, uint32_t bpp, uint32_t height);
+    void remove(RSXSurface* surface);
+    void clear();
+    // Least recently used surface once the cache is full, else null
+    RSXSurface* get_eviction_candidate() const;
+
+    template <typename Fn>
+    void for_each_overlap(uint32_t offset, uint32_t size, Fn fn) {
+        for (auto& surface : surfaces) {
+            if (surface->overlaps(offset, size)) {
+                fn(*surface);
+            }
+        }
+    }
+
+    void count_writeback() { stats.writebacks++; }
+    void count_alias() { stats.texture_aliases++; }
+    RSXSurfaceCacheStats get_stats();
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<RSXSurface>> surfaces;
+    std::atomic<size_t> count;
+    uint64_t use_clock;
+    RSXSurfaceCacheStats stats;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_SURFACE_CACHE_H
@@ -0,0 +1,560 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Surface Format Implementation
+ *
+ * Each format pair gets its own converter. Pairs of 32-bit formats with
+ * 8-bit channels are a single byte shuffle; everything else decodes into
+ * a canonical format in cache-sized blocks and encodes from there. The
+ * intermediate is RGBA32F when either side is a float format, RGBA8
+ * otherwise. SIMD kernels produce the same bits as the scalar ones.
+ */
+
+#include "rsx_surface_format.h"
+#include "../../../core/include/simd_support.h"
+#include <immintrin.h>
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Table order of the formats with converters
+static constexpr uint32_t CONVERT_FORMATS[] = {
+    RSX_SURFACE_FORMAT_B8, RSX_SURFACE_FORMAT_G8B8, RSX_SURFACE_FORMAT_A8R8G8B8,
+    RSX_SURFACE_FORMAT_B8G8R8A8, RSX_SURFACE_FORMAT_R5G6B5, RSX_SURFACE_FORMAT_X8R8G8B8,
+    RSX_SURFACE_FORMAT_B8G8R8X8, RSX_SURFACE_FORMAT_X1R5G5B5, RSX_SURFACE_FORMAT_A1R5G5B5,
+    RSX_SURFACE_FORMAT_A4R4G4B4, RSX_SURFACE_FORMAT_R32_FLOAT, RSX_SURFACE_FORMAT_R16_FLOAT,
+    RSX_SURFACE_FORMAT_X8B8G8R8, RSX_SURFACE_FORMAT_A8B8G8R8, RSX_SURFACE_FORMAT_B8G8R8,
+    RSX_SURFACE_FORMAT_G8R8, RSX_SURFACE_FORMAT_R8,
+    RSX_CANONICAL_FORMAT_RGBA8, RSX_CANONICAL_FORMAT_RGBA32F
+};
+static constexpr size_t CONVERT_FORMAT_COUNT = sizeof(CONVERT_FORMATS) / sizeof(CONVERT_FORMATS[0]);
+
+// Pixels per block when a pair goes through the intermediate format
+static constexpr uint32_t CONVERT_BLOCK = 256;
+
+using ISA = RSXSurfaceConvertISA;
+
+template <uint32_t Format>
+static constexpr RSXSurfaceLayout layout_of = rsx_get_surface_layout(Format);
+
+// 32-bit formats whose channels are whole bytes: conversion between any
+// two of them is a byte shuffle plus opaque alpha
+template <uint32_t Format>
+static constexpr bool is_byte_shuffle = layout_of<Format>.bytes == 4 && !layout_of<Format>.is_float;
+
+template <uint32_t Format>
+static constexpr bool is_packed16 = layout_of<Format>.bytes == 2 && !layout_of<Format>.is_float;
+
+// Scalar channel math
+
+static inline uint32_t expand_unorm(uint32_t value, uint32_t bits) {
+    // Bit replication, written as the multiply-shift the SIMD kernels use
+    return bits == 1 ? value * 255 : (value * ((1u << bits) + 1)) >> (2 * bits - 8);
+}
+
+static inline uint32_t reduce_unorm(uint32_t value, uint32_t bits) {
+    // round(value * max / 255), exact for any 16-bit product
+    uint32_t t = value * ((1u << bits) - 1) + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Per-channel helpers, so every field is a compile-time shift and mask
+
+template <uint32_t Format, uint32_t C>
+static constexpr bool is_stored = layout_of<Format>.bits[C] != 0 && !(C == 3 && layout_of<Format>.forced_alpha);
+
+template <uint32_t Format, uint32_t C>
+static inline uint32_t get_field(uint32_t word) {
+    return (word >> layout_of<Format>.shift[C]) & ((1u << layout_of<Format>.bits[C]) - 1);
+}
+
+template <uint32_t Format, uint32_t C>
+static inline float unpack_float(uint32_t word) {
+    if constexpr (is_stored<Format, C>) {
+        constexpr float scale = 1.0f / static_cast<float>((1u << layout_of<Format>.bits[C]) - 1);
+        return static_cast<float>(get_field<Format, C>(word)) * scale;
+    } else {
+        return C == 3 ? 1.0f : 0.0f;
+    }
+}
+
+template <uint32_t Format, uint32_t C>
+static inline uint8_t unpack_unorm8(uint32_t word) {
+    if constexpr (is_stored<Format, C>) {
+        return static_cast<uint8_t>(expand_unorm(get_field<Format, C>(word), layout_of<Format>.bits[C]));
+    } else {
+        return C == 3 ? 0xFF : 0x00;
+    }
+}
+
+template <uint32_t Format, uint32_t C>
+static inline uint32_t pack_unorm8(uint8_t value) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+    if constexpr (layout.bits[C] == 0) {
+        return 0;
+    } else if constexpr (C == 3 && layout.forced_alpha) {
+        return ((1u << layout.bits[C]) - 1) << layout.shift[C];
+    } else {
+        return reduce_unorm(value, layout.bits[C]) << layout.shift[C];
+    }
+}
+
+template <uint32_t Format>
+static inline void decode_float(const uint8_t* src, float out[4]) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+
+    if constexpr (Format == RSX_CANONICAL_FORMAT_RGBA32F) {
+        std::memcpy(out, src, 4 * sizeof(float));
+    } else if constexpr (layout.is_float) {
+        if constexpr (Format == RSX_SURFACE_FORMAT_R32_FLOAT) {
+            uint32_t bits = rsx_load_surface_word(src, 4);
+            std::memcpy(&out[0], &bits, sizeof(float));
+        } else {
+            out[0] = half_to_float(static_cast<uint16_t>(rsx_load_surface_word(src, 2)));
+        }
+        out[1] = 0.0f;
+        out[2] = 0.0f;
+        out[3] = 1.0f;
+    } else {
+        uint32_t word = rsx_load_surface_word(src, layout.bytes);
+        out[0] = unpack_float<Format, 0>(word);
+        out[1] = unpack_float<Format, 1>(word);
+        out[2] = unpack_float<Format, 2>(word);
+        out[3] = unpack_float<Format, 3>(word);
+    }
+}
+
+template <uint32_t Format>
+static inline void decode_rgba8(const uint8_t* src, uint8_t out[4]) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+
+    if constexpr (layout.is_float) {
+        float rgba[4];
+        decode_float<Format>(src, rgba);
+        for (uint32_t c = 0; c < 4; c++) {
+            out[c] = static_cast<uint8_t>(rsx_to_unorm(rgba[c], 255));
+        }
+    } else {
+        uint32_t word = rsx_load_surface_word(src, layout.bytes);
+        out[0] = unpack_unorm8<Format, 0>(word);
+        out[1] = unpack_unorm8<Format, 1>(word);
+        out[2] = unpack_unorm8<Format, 2>(word);
+        out[3] = unpack_unorm8<Format, 3>(word);
+    }
+}
+
+template <uint32_t Format>
+static inline void encode_rgba8(const uint8_t in[4], uint8_t* dst) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+
+    if constexpr (layout.is_float) {
+        const float rgba[4] = {
+            in[0] * (1.0f / 255.0f), in[1] * (1.0f / 255.0f), in[2] * (1.0f / 255.0f), in[3] * (1.0f / 255.0f)
+        };
+        rsx_encode_surface_pixel<Format>(rgba, dst);
+    } else {
+        uint32_t word = pack_unorm8<Format, 0>(in[0]) | pack_unorm8<Format, 1>(in[1]) |
+                        pack_unorm8<Format, 2>(in[2]) | pack_unorm8<Format, 3>(in[3]);
+        rsx_store_surface_word(dst, word, layout.bytes);
+    }
+}
+
+// Byte shuffles between 32-bit formats
+
+struct ShuffleMask {
+    uint8_t index[4];   // Source byte per destination byte, 0x80 for none
+    uint8_t fill[4];    // ORed in afterwards
+};
+
+template <uint32_t Src, uint32_t Dst>
+static constexpr ShuffleMask make_shuffle_mask() {
+    constexpr RSXSurfaceLayout src = layout_of<Src>;
+    constexpr RSXSurfaceLayout dst = layout_of<Dst>;
+    ShuffleMask mask{};
+    for (uint32_t c = 0; c < 4; c++) {
+        uint32_t out = 3 - dst.shift[c] / 8;
+        bool opaque = c == 3 && (src.forced_alpha || dst.forced_alpha);
+        mask.index[out] = opaque ? 0x80 : static_cast<uint8_t>(3 - src.shift[c] / 8);
+        mask.fill[out] = opaque ? 0xFF : 0x00;
+    }
+    return mask;
+}
+
+// The mask repeated over a 256-bit register; PSHUFB indexes within 128-bit lanes
+template <uint32_t Src, uint32_t Dst>
+static constexpr std::array<uint8_t, 64> make_shuffle_vectors() {
+    constexpr ShuffleMask mask = make_shuffle_mask<Src, Dst>();
+    std::array<uint8_t, 64> bytes{};
+    for (uint32_t i = 0; i < 32; i++) {
+        uint8_t index = mask.index[i % 4];
+        bytes[i] = index & 0x80 ? 0x80 : static_cast<uint8_t>(index + (i % 16) / 4 * 4);
+        bytes[32 + i] = mask.fill[i % 4];
+    }
+    return bytes;
+}
+
+template <uint32_t Src, uint32_t Dst>
+static constexpr std::array<uint8_t, 64> shuffle_vectors = make_shuffle_vectors<Src, Dst>();
+
+template <uint32_t Src, uint32_t Dst>
+static void shuffle_scalar(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr ShuffleMask mask = make_shuffle_mask<Src, Dst>();
+    for (uint32_t i = 0; i < count; i++, src += 4, dst += 4) {
+        for (uint32_t b = 0; b < 4; b++) {
+            dst[b] = static_cast<uint8_t>((mask.index[b] & 0x80 ? 0 : src[mask.index[b]]) | mask.fill[b]);
+        }
+    }
+}
+
+template <uint32_t Src, uint32_t Dst>
+GSCX_TARGET_SSSE3 static void shuffle_ssse3(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle_vectors<Src, Dst>.data()));
+    const __m128i fill = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle_vectors<Src, Dst>.data() + 32));
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, index), fill));
+    }
+    shuffle_scalar<Src, Dst>(src + i * 4, dst + i * 4, count - i);
+}
+
+template <uint32_t Src, uint32_t Dst>
+GSCX_TARGET_AVX2 static void shuffle_avx2(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shuffle_vectors<Src, Dst>.data()));
+    const __m256i fill = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shuffle_vectors<Src, Dst>.data() + 32));
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4 + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(a, index), fill));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4 + 32),
+                            _mm256_or_si256(_mm256_shuffle_epi8(b, index), fill));
+    }
+    shuffle_ssse3<Src, Dst>(src + i * 4, dst + i * 4, count - i);
+}
+
+template <uint32_t Src, uint32_t Dst, ISA Isa>
+static void shuffle_row(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    if constexpr (Isa == ISA::AVX2) {
+        shuffle_avx2<Src, Dst>(src, dst, count);
+    } else if constexpr (Isa == ISA::SSSE3) {
+        shuffle_ssse3<Src, Dst>(src, dst, count);
+    } else {
+        shuffle_scalar<Src, Dst>(src, dst, count);
+    }
+}
+
+// 16-bit packed formats <-> any byte-shuffle format, eight pixels per register
+
+// Channel held by byte `index` of a byte-shuffle format
+template <uint32_t Format>
+static constexpr uint32_t get_byte_channel(uint32_t index) {
+    for (uint32_t c = 0; c < 3; c++) {
+        if (3u - layout_of<Format>.shift[c] / 8u == index) {
+            return c;
+        }
+    }
+    return 3;
+}
+
+template <uint32_t Format>
+static constexpr std::array<uint8_t, 16> make_planar_mask() {
+    // Gathers four pixels into R0-3 G0-3 B0-3 A0-3
+    std::array<uint8_t, 16> mask{};
+    for (uint32_t c = 0; c < 4; c++) {
+        for (uint32_t p = 0; p < 4; p++) {
+            mask[c * 4 + p] = static_cast<uint8_t>(p * 4 + 3 - layout_of<Format>.shift[c] / 8);
+        }
+    }
+    return mask;
+}
+
+template <uint32_t Format>
+static constexpr std::array<uint8_t, 16> planar_mask = make_planar_mask<Format>();
+
+template <uint32_t Format, uint32_t C, bool Opaque>
+GSCX_TARGET_SSSE3 static inline __m128i unpack_channel(__m128i word) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+    constexpr uint32_t bits = layout.bits[C];
+    if constexpr (C == 3 && Opaque) {
+        return _mm_set1_epi16(0xFF);
+    } else if constexpr (!is_stored<Format, C>) {
+        return _mm_set1_epi16(C == 3 ? 0xFF : 0x00);
+    } else {
+        __m128i field = _mm_and_si128(_mm_srli_epi16(word, layout.shift[C]), _mm_set1_epi16((1 << bits) - 1));
+        if constexpr (bits == 1) {
+            return _mm_mullo_epi16(field, _mm_set1_epi16(0xFF));
+        } else {
+            return _mm_srli_epi16(_mm_mullo_epi16(field, _mm_set1_epi16((1 << bits) + 1)), 2 * bits - 8);
+        }
+    }
+}
+
+template <uint32_t Format, uint32_t Dst>
+GSCX_TARGET_SSSE3 static void decode_packed16_ssse3(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr bool opaque = layout_of<Dst>.forced_alpha;
+    constexpr uint32_t c0 = get_byte_channel<Dst>(0), c1 = get_byte_channel<Dst>(1);
+    constexpr uint32_t c2 = get_byte_channel<Dst>(2), c3 = get_byte_channel<Dst>(3);
+    const __m128i bswap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i word = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)), bswap16);
+        __m128i lo = _mm_or_si128(unpack_channel<Format, c0, opaque>(word),
+                                  _mm_slli_epi16(unpack_channel<Format, c1, opaque>(word), 8));
+        __m128i hi = _mm_or_si128(unpack_channel<Format, c2, opaque>(word),
+                                  _mm_slli_epi16(unpack_channel<Format, c3, opaque>(word), 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(lo, hi));
+    }
+    for (; i < count; i++) {
+        uint8_t rgba[4];
+        decode_rgba8<Format>(src + i * 2, rgba);
+        shuffle_scalar<RSX_CANONICAL_FORMAT_RGBA8, Dst>(rgba, dst + i * 4, 1);
+    }
+}
+
+template <uint32_t Format, uint32_t C, bool Opaque>
+GSCX_TARGET_SSSE3 static inline __m128i pack_channel(__m128i value) {
+    constexpr RSXSurfaceLayout layout = layout_of<Format>;
+    constexpr uint32_t bits = layout.bits[C];
+    if constexpr (bits == 0) {
+        return _mm_setzero_si128();
+    } else if constexpr (C == 3 && (layout.forced_alpha || Opaque)) {
+        return _mm_set1_epi16(static_cast<short>(((1 << bits) - 1) << layout.shift[C]));
+    } else {
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(value, _mm_set1_epi16((1 << bits) - 1)), _mm_set1_epi16(128));
+        __m128i reduced = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        return _mm_slli_epi16(reduced, layout.shift[C]);
+    }
+}
+
+template <uint32_t Format, uint32_t Src>
+GSCX_TARGET_SSSE3 static void encode_packed16_ssse3(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr bool opaque = layout_of<Src>.forced_alpha;
+    const __m128i planar = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planar_mask<Src>.data()));
+    const __m128i bswap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)), planar);
+        __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16)), planar);
+        // R0-7 G0-7 and B0-7 A0-7
+        __m128i rg = _mm_unpacklo_epi32(lo, hi);
+        __m128i ba = _mm_unpackhi_epi32(lo, hi);
+        __m128i word = _mm_or_si128(
+            _mm_or_si128(pack_channel<Format, 0, opaque>(_mm_unpacklo_epi8(rg, zero)),
+                         pack_channel<Format, 1, opaque>(_mm_unpackhi_epi8(rg, zero))),
+            _mm_or_si128(pack_channel<Format, 2, opaque>(_mm_unpacklo_epi8(ba, zero)),
+                         pack_channel<Format, 3, opaque>(_mm_unpackhi_epi8(ba, zero))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_shuffle_epi8(word, bswap16));
+    }
+    for (; i < count; i++) {
+        uint8_t rgba[4];
+        shuffle_scalar<Src, RSX_CANONICAL_FORMAT_RGBA8>(src + i * 4, rgba, 1);
+        encode_rgba8<Format>(rgba, dst + i * 2);
+    }
+}
+
+// RGBA8 <-> RGBA32F, four pixels per iteration (SSE2)
+
+static void rgba8_to_float_sse2(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    float* out = reinterpret_cast<float*>(dst);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(out + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(out + i * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+        _mm_storeu_ps(out + i * 4 + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+        _mm_storeu_ps(out + i * 4 + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+    }
+    for (; i < count; i++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            out[i * 4 + c] = src[i * 4 + c] * (1.0f / 255.0f);
+        }
+    }
+}
+
+static inline __m128i float_to_unorm8_sse2(const float* src) {
+    // MAXPS returns the second operand for NaN, so NaN clamps to 0 like rsx_to_unorm
+    __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+static void float_to_rgba8_sse2(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    const float* in = reinterpret_cast<const float*>(src);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i ab = _mm_packs_epi32(float_to_unorm8_sse2(in + i * 4), float_to_unorm8_sse2(in + i * 4 + 4));
+        __m128i cd = _mm_packs_epi32(float_to_unorm8_sse2(in + i * 4 + 8), float_to_unorm8_sse2(in + i * 4 + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(ab, cd));
+    }
+    for (; i < count; i++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            dst[i * 4 + c] = static_cast<uint8_t>(rsx_to_unorm(in[i * 4 + c], 255));
+        }
+    }
+}
+
+// Rows into and out of a canonical format
+
+template <uint32_t Format, uint32_t Canonical, ISA Isa>
+static void decode_row(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr uint32_t bytes = layout_of<Format>.bytes;
+
+    if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8 && is_byte_shuffle<Format>) {
+        shuffle_row<Format, RSX_CANONICAL_FORMAT_RGBA8, Isa>(src, dst, count);
+    } else if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8 && is_packed16<Format> && Isa != ISA::SCALAR) {
+        decode_packed16_ssse3<Format, RSX_CANONICAL_FORMAT_RGBA8>(src, dst, count);
+    } else if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8) {
+        for (uint32_t i = 0; i < count; i++) {
+            decode_rgba8<Format>(src + i * bytes, dst + i * 4);
+        }
+    } else if constexpr (is_byte_shuffle<Format> && Isa != ISA::SCALAR) {
+        alignas(32) uint8_t block[CONVERT_BLOCK * 4];
+        for (uint32_t done = 0; done < count; done += CONVERT_BLOCK) {
+            uint32_t n = count - done < CONVERT_BLOCK ? count - done : CONVERT_BLOCK;
+            shuffle_row<Format, RSX_CANONICAL_FORMAT_RGBA8, Isa>(src + done * 4, block, n);
+            rgba8_to_float_sse2(block, dst + done * 16, n);
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            float rgba[4];
+            decode_float<Format>(src + i * bytes, rgba);
+            std::memcpy(dst + i * 16, rgba, sizeof(rgba));
+        }
+    }
+}
+
+template <uint32_t Format, uint32_t Canonical, ISA Isa>
+static void encode_row(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr uint32_t bytes = layout_of<Format>.bytes;
+
+    if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8 && is_byte_shuffle<Format>) {
+        shuffle_row<RSX_CANONICAL_FORMAT_RGBA8, Format, Isa>(src, dst, count);
+    } else if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8 && is_packed16<Format> && Isa != ISA::SCALAR) {
+        encode_packed16_ssse3<Format, RSX_CANONICAL_FORMAT_RGBA8>(src, dst, count);
+    } else if constexpr (Canonical == RSX_CANONICAL_FORMAT_RGBA8) {
+        for (uint32_t i = 0; i < count; i++) {
+            encode_rgba8<Format>(src + i * 4, dst + i * bytes);
+        }
+    } else if constexpr (is_byte_shuffle<Format> && Isa != ISA::SCALAR) {
+        alignas(32) uint8_t block[CONVERT_BLOCK * 4];
+        for (uint32_t done = 0; done < count; done += CONVERT_BLOCK) {
+            uint32_t n = count - done < CONVERT_BLOCK ? count - done : CONVERT_BLOCK;
+            float_to_rgba8_sse2(src + done * 16, block, n);
+            shuffle_row<RSX_CANONICAL_FORMAT_RGBA8, Format, Isa>(block, dst + done * 4, n);
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            float rgba[4];
+            std::memcpy(rgba, src + i * 16, sizeof(rgba));
+            rsx_encode_surface_pixel<Format>(rgba, dst + i * bytes);
+        }
+    }
+}
+
+template <uint32_t Src, uint32_t Dst, ISA Isa>
+static void convert_row(const uint8_t* src, uint8_t* dst, uint32_t count) {
+    constexpr bool use_float = layout_of<Src>.is_float || layout_of<Dst>.is_float;
+    constexpr uint32_t canonical = use_float ? RSX_CANONICAL_FORMAT_RGBA32F : RSX_CANONICAL_FORMAT_RGBA8;
+
+    if constexpr (Src == Dst) {
+        std::memcpy(dst, src, static_cast<size_t>(count) * layout_of<Src>.bytes);
+    } else if constexpr (is_byte_shuffle<Src> && is_byte_shuffle<Dst>) {
+        shuffle_row<Src, Dst, Isa>(src, dst, count);
+    } else if constexpr (is_packed16<Src> && is_byte_shuffle<Dst> && Isa != ISA::SCALAR) {
+        decode_packed16_ssse3<Src, Dst>(src, dst, count);
+    } else if constexpr (is_byte_shuffle<Src> && is_packed16<Dst> && Isa != ISA::SCALAR) {
+        encode_packed16_ssse3<Dst, Src>(src, dst, count);
+    } else if constexpr (Src == canonical) {
+        encode_row<Dst, canonical, Isa>(src, dst, count);
+    } else if constexpr (Dst == canonical) {
+        decode_row<Src, canonical, Isa>(src, dst, count);
+    } else {
+        constexpr uint32_t canonical_bytes = layout_of<canonical>.bytes;
+        alignas(32) uint8_t block[CONVERT_BLOCK * canonical_bytes];
+        for (uint32_t done = 0; done < count; done += CONVERT_BLOCK) {
+            uint32_t n = count - done < CONVERT_BLOCK ? count - done : CONVERT_BLOCK;
+            decode_row<Src, canonical, Isa>(src + static_cast<size_t>(done) * layout_of<Src>.bytes, block, n);
+            encode_row<Dst, canonical, Isa>(block, dst + static_cast<size_t>(done) * layout_of<Dst>.bytes, n);
+        }
+    }
+}
+
+// Converter tables, indexed by [src][dst] in CONVERT_FORMATS order
+
+using ConvertTable = std::array<RSXSurfaceConvertFn, CONVERT_FORMAT_COUNT * CONVERT_FORMAT_COUNT>;
+
+template <ISA Isa, size_t... Indices>
+static constexpr ConvertTable make_convert_table(std::index_sequence<Indices...>) {
+    return ConvertTable{
+        &convert_row<CONVERT_FORMATS[Indices / CONVERT_FORMAT_COUNT], CONVERT_FORMATS[Indices % CONVERT_FORMAT_COUNT], Isa>...
+    };
+}
+
+static constexpr ConvertTable convert_tables[] = {
+    make_convert_table<ISA::SCALAR>(std::make_index_sequence<CONVERT_FORMAT_COUNT * CONVERT_FORMAT_COUNT>{}),
+    make_convert_table<ISA::SSSE3>(std::make_index_sequence<CONVERT_FORMAT_COUNT * CONVERT_FORMAT_COUNT>{}),
+    make_convert_table<ISA::AVX2>(std::make_index_sequence<CONVERT_FORMAT_COUNT * CONVERT_FORMAT_COUNT>{}),
+};
+
+static int get_format_index(uint32_t format) {
+    for (size_t i = 0; i < CONVERT_FORMAT_COUNT; i++) {
+        if (CONVERT_FORMATS[i] == format) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+RSXSurfaceConvertISA rsx_get_surface_convert_isa() {
+    static const RSXSurfaceConvertISA isa = Core::get_host_cpu_features().avx2 ? ISA::AVX2
+                                          : Core::get_host_cpu_features().ssse3 ? ISA::SSSE3
+                                          : ISA::SCALAR;
+    return isa;
+}
+
+uint32_t rsx_get_format_bytes_per_pixel(uint32_t format) {
+    return rsx_get_surface_layout(format).bytes;
+}
+
+RSXSurfaceConvertFn rsx_get_surface_converter(uint32_t src_format, uint32_t dst_format, RSXSurfaceConvertISA isa) {
+    int src = get_format_index(src_format);
+    int dst = get_format_index(dst_format);
+    if (src < 0 || dst < 0) {
+        return nullptr;
+    }
+    return convert_tables[static_cast<size_t>(isa)][static_cast<size_t>(src) * CONVERT_FORMAT_COUNT + dst];
+}
+
+RSXSurfaceConvertFn rsx_get_surface_converter(uint32_t src_format, uint32_t dst_format) {
+    return rsx_get_surface_converter(src_format, dst_format, rsx_get_surface_convert_isa());
+}
+
+bool rsx_convert_surface(const uint8_t* src, uint32_t src_pitch, uint32_t src_format,
+                         uint8_t* dst, uint32_t dst_pitch, uint32_t dst_format,
+                         uint32_t width, uint32_t height) {
+    RSXSurfaceConvertFn convert = rsx_get_surface_converter(src_format, dst_format);
+    if (!convert || !src || !dst) {
+        return false;
+    }
+    if (static_cast<uint64_t>(width) * rsx_get_format_bytes_per_pixel(src_format) > src_pitch ||
+        static_cast<uint64_t>(width) * rsx_get_format_bytes_per_pixel(dst_format) > dst_pitch) {
+        return false;
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        convert(src + static_cast<size_t>(y) * src_pitch, dst + static_cast<size_t>(y) * dst_pitch, width);
+    }
+    return true;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,153 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Surface Format Header
+ *
+ * Conversions between the RSX color surface formats and two canonical host
+ * formats: RGBA8 (bytes R, G, B, A) and RGBA32F (four host floats). Surface
+ * pixels are big-endian words, as the RSX stores them, so A8R8G8B8 is the
+ * bytes A, R, G, B in memory. Every pair of formats has its own row
+ * converter, generated at compile time, with SSSE3/AVX2 kernels for the
+ * byte-shuffle and 16-bit packed formats.
+ */
+
+#ifndef GSCX_MODULES_RSX_SURFACE_FORMAT_H
+#define GSCX_MODULES_RSX_SURFACE_FORMAT_H
+
+#include "rsx_core.h"
+#include "rsx_float16.h"
+#include <cstdint>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Canonical formats, outside the NV4097 surface format range
+static constexpr uint32_t RSX_CANONICAL_FORMAT_RGBA8 = 0x100;
+static constexpr uint32_t RSX_CANONICAL_FORMAT_RGBA32F = 0x101;
+
+/**
+ * RSX Surface Layout
+ *
+ * Channel fields of a pixel word of `bytes` bytes. Fields are indexed
+ * R, G, B, A; a width of 0 means the channel is not stored and reads as
+ * 0 (alpha as 1). X formats store alpha bits as ones and read as opaque.
+ * Float formats hold red only (R16/R32) or all four channels (RGBA32F).
+ */
+struct RSXSurfaceLayout {
+    uint32_t bytes;
+    bool is_float;
+    bool forced_alpha;
+    uint8_t shift[4];
+    uint8_t bits[4];
+};
+
+constexpr RSXSurfaceLayout rsx_get_surface_layout(uint32_t format) {
+    switch (format) {
+        case RSX_SURFACE_FORMAT_B8: return { 1, false, false, { 0, 0, 0, 0 }, { 0, 0, 8, 0 } };
+        case RSX_SURFACE_FORMAT_G8B8: return { 2, false, false, { 0, 8, 0, 0 }, { 0, 8, 8, 0 } };
+        case RSX_SURFACE_FORMAT_A8R8G8B8: return { 4, false, false, { 16, 8, 0, 24 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_B8G8R8A8: return { 4, false, false, { 8, 16, 24, 0 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_R5G6B5: return { 2, false, false, { 11, 5, 0, 0 }, { 5, 6, 5, 0 } };
+        case RSX_SURFACE_FORMAT_X8R8G8B8: return { 4, false, true, { 16, 8, 0, 24 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_B8G8R8X8: return { 4, false, true, { 8, 16, 24, 0 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_X1R5G5B5: return { 2, false, true, { 10, 5, 0, 15 }, { 5, 5, 5, 1 } };
+        case RSX_SURFACE_FORMAT_A1R5G5B5: return { 2, false, false, { 10, 5, 0, 15 }, { 5, 5, 5, 1 } };
+        case RSX_SURFACE_FORMAT_A4R4G4B4: return { 2, false, false, { 8, 4, 0, 12 }, { 4, 4, 4, 4 } };
+        case RSX_SURFACE_FORMAT_R32_FLOAT: return { 4, true, false, { 0, 0, 0, 0 }, { 32, 0, 0, 0 } };
+        case RSX_SURFACE_FORMAT_R16_FLOAT: return { 2, true, false, { 0, 0, 0, 0 }, { 16, 0, 0, 0 } };
+        case RSX_SURFACE_FORMAT_X8B8G8R8: return { 4, false, true, { 0, 8, 16, 24 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_A8B8G8R8: return { 4, false, false, { 0, 8, 16, 24 }, { 8, 8, 8, 8 } };
+        case RSX_SURFACE_FORMAT_B8G8R8: return { 3, false, false, { 0, 8, 16, 0 }, { 8, 8, 8, 0 } };
+        case RSX_SURFACE_FORMAT_G8R8: return { 2, false, false, { 0, 8, 0, 0 }, { 8, 8, 0, 0 } };
+        case RSX_SURFACE_FORMAT_R8: return { 1, false, false, { 0, 0, 0, 0 }, { 8, 0, 0, 0 } };
+        case RSX_CANONICAL_FORMAT_RGBA8: return { 4, false, false, { 24, 16, 8, 0 }, { 8, 8, 8, 8 } };
+        case RSX_CANONICAL_FORMAT_RGBA32F: return { 16, true, false, { 0, 0, 0, 0 }, { 32, 32, 32, 32 } };
+        default: return { 0, false, false, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+    }
+}
+
+inline uint32_t rsx_load_surface_word(const uint8_t* src, uint32_t bytes) {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < bytes; i++) {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+inline void rsx_store_surface_word(uint8_t* dst, uint32_t value, uint32_t bytes) {
+    for (uint32_t i = 0; i < bytes; i++) {
+        dst[i] = static_cast<uint8_t>(value >> ((bytes - 1 - i) * 8));
+    }
+}
+
+inline uint32_t rsx_to_unorm(float value, uint32_t max) {
+    float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+    return static_cast<uint32_t>(clamped * static_cast<float>(max) + 0.5f);
+}
+
+// Field of channel C (R, G, B, A) packed from a float, 0 if not stored
+template <uint32_t Format, uint32_t C>
+inline uint32_t rsx_pack_surface_channel(float value) {
+    constexpr RSXSurfaceLayout layout = rsx_get_surface_layout(Format);
+    constexpr uint32_t max = (1u << layout.bits[C]) - 1;
+    if constexpr (layout.bits[C] == 0) {
+        return 0;
+    } else if constexpr (C == 3 && layout.forced_alpha) {
+        return max << layout.shift[C];
+    } else {
+        return rsx_to_unorm(value, max) << layout.shift[C];
+    }
+}
+
+// One pixel from float RGBA; used by the fragment output packer, and the
+// reference every RGBA32F row converter matches bit for bit
+template <uint32_t Format>
+inline void rsx_encode_surface_pixel(const float rgba[4], uint8_t* dst) {
+    constexpr RSXSurfaceLayout layout = rsx_get_surface_layout(Format);
+    static_assert(layout.bytes != 0, "unknown surface format");
+
+    if constexpr (Format == RSX_CANONICAL_FORMAT_RGBA32F) {
+        std::memcpy(dst, rgba, 4 * sizeof(float));
+    } else if constexpr (Format == RSX_SURFACE_FORMAT_R32_FLOAT) {
+        uint32_t bits;
+        std::memcpy(&bits, &rgba[0], sizeof(bits));
+        rsx_store_surface_word(dst, bits, 4);
+    } else if constexpr (Format == RSX_SURFACE_FORMAT_R16_FLOAT) {
+        rsx_store_surface_word(dst, float_to_half(rgba[0]), 2);
+    } else {
+        uint32_t word = rsx_pack_surface_channel<Format, 0>(rgba[0]) | rsx_pack_surface_channel<Format, 1>(rgba[1]) |
+                        rsx_pack_surface_channel<Format, 2>(rgba[2]) | rsx_pack_surface_channel<Format, 3>(rgba[3]);
+        rsx_store_surface_word(dst, word, layout.bytes);
+    }
+}
+
+// Converts `count` pixels; source and destination must not overlap
+using RSXSurfaceConvertFn = void (*)(const uint8_t* src, uint8_t* dst, uint32_t count);
+
+enum class RSXSurfaceConvertISA {
+    SCALAR,
+    SSSE3,
+    AVX2
+};
+
+// Best kernel set the host supports, detected once
+RSXSurfaceConvertISA rsx_get_surface_convert_isa();
+
+// Bytes per pixel of a surface or canonical format, 0 if unknown
+uint32_t rsx_get_format_bytes_per_pixel(uint32_t format);
+
+// Row converter between any two surface/canonical formats, null if either
+// is unknown. The explicit ISA form is for benchmarks and cross-checks.
+RSXSurfaceConvertFn rsx_get_surface_converter(uint32_t src_format, uint32_t dst_format);
+RSXSurfaceConvertFn rsx_get_surface_converter(uint32_t src_format, uint32_t dst_format, RSXSurfaceConvertISA isa);
+
+bool rsx_convert_surface(const uint8_t* src, uint32_t src_pitch, uint32_t src_format,
+                         uint8_t* dst, uint32_t dst_pitch, uint32_t dst_format,
+                         uint32_t width, uint32_t height);
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_SURFACE_FORMAT_H
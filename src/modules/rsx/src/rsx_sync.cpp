@@ -0,0 +1,144 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Sync Implementation
+ */
+
+#include "rsx_sync.h"
+#include <chrono>
+#include <thread>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Yields before sleeping: a release usually lands within a few microseconds
+// of the acquire that waits for it, and a futex round trip costs more
+static constexpr int RSX_SYNC_SPIN = 32;
+
+static uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+RSXSyncUnit::RSXSyncUnit()
+    : reference(0)
+    , notify_timestamp(0)
+    , notify_sequence(0)
+    , notify_status(0)
+    , event(0)
+    , aborted(false)
+    , clock_origin(steady_ns()) {
+    for (auto& label : labels) {
+        label.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename Ready>
+bool RSXSyncUnit::wait_until(Ready ready, uint64_t timeout_ns) {
+    for (int i = 0; i < RSX_SYNC_SPIN; i++) {
+        if (ready()) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+
+    uint64_t start = timeout_ns == Core::FUTEX_INFINITE ? 0 : steady_ns();
+    for (;;) {
+        // Read the event before the condition: a write between the two
+        // changes the event and the futex wait returns at once
+        uint32_t seen = event.load(std::memory_order_acquire);
+        if (ready()) {
+            return true;
+        }
+        if (aborted.load(std::memory_order_acquire)) {
+            return false;
+        }
+        uint64_t remaining = Core::FUTEX_INFINITE;
+        if (timeout_ns != Core::FUTEX_INFINITE) {
+            uint64_t elapsed = steady_ns() - start;
+            if (elapsed >= timeout_ns) {
+                return false;
+            }
+            remaining = timeout_ns - elapsed;
+        }
+        Core::futex_wait(event, seen, remaining);
+    }
+}
+
+uint32_t RSXSyncUnit::read_label(uint32_t index) const {
+    return labels[index % RSX_LABEL_COUNT].load(std::memory_order_acquire);
+}
+
+void RSXSyncUnit::write_label(uint32_t index, uint32_t value) {
+    labels[index % RSX_LABEL_COUNT].store(value, std::memory_order_release);
+    signal();
+}
+
+bool RSXSyncUnit::wait_label(uint32_t index, uint32_t value, uint64_t timeout_ns) {
+    const std::atomic<uint32_t>& label = labels[index % RSX_LABEL_COUNT];
+    return wait_until([&] { return label.load(std::memory_order_acquire) == value; }, timeout_ns);
+}
+
+void RSXSyncUnit::set_reference(uint32_t value) {
+    reference.store(value, std::memory_order_release);
+    signal();
+}
+
+bool RSXSyncUnit::wait_reference(uint32_t value, uint64_t timeout_ns) {
+    return wait_until([&] { return reference.load(std::memory_order_acquire) == value; }, timeout_ns);
+}
+
+void RSXSyncUnit::notify(uint32_t status) {
+    notify_timestamp.store(get_timestamp(), std::memory_order_relaxed);
+    notify_status.store(status, std::memory_order_relaxed);
+    notify_sequence.fetch_add(1, std::memory_order_release);
+    signal();
+}
+
+RSXNotifier RSXSyncUnit::get_notifier() const {
+    RSXNotifier notifier;
+    notifier.sequence = notify_sequence.load(std::memory_order_acquire);
+    notifier.timestamp = notify_timestamp.load(std::memory_order_relaxed);
+    notifier.status = notify_status.load(std::memory_order_relaxed);
+    return notifier;
+}
+
+bool RSXSyncUnit::wait_notify(uint32_t sequence, uint64_t timeout_ns) {
+    return wait_until([&] { return notify_sequence.load(std::memory_order_acquire) != sequence; }, timeout_ns);
+}
+
+void RSXSyncUnit::signal() {
+    event.fetch_add(1, std::memory_order_release);
+    Core::futex_wake_all(event);
+}
+
+bool RSXSyncUnit::wait_event(uint32_t seen, uint64_t timeout_ns) {
+    return wait_until([&] { return event.load(std::memory_order_acquire) != seen; }, timeout_ns);
+}
+
+void RSXSyncUnit::abort_waits() {
+    aborted.store(true, std::memory_order_release);
+    signal();
+}
+
+void RSXSyncUnit::resume() {
+    aborted.store(false, std::memory_order_release);
+}
+
+void RSXSyncUnit::reset() {
+    for (auto& label : labels) {
+        label.store(0, std::memory_order_relaxed);
+    }
+    reference.store(0, std::memory_order_relaxed);
+    notify_timestamp.store(0, std::memory_order_relaxed);
+    notify_status.store(0, std::memory_order_relaxed);
+    signal();
+}
+
+uint64_t RSXSyncUnit::get_timestamp() const {
+    return steady_ns() - clock_origin;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,117 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Sync Header
+ *
+ * Semaphore labels, the reference register and the notifier shared by
+ * the PPU and the RSX pipeline. Every write bumps one event word and
+ * wakes its futex, so waiters on either side sleep instead of polling.
+ */
+
+#ifndef GSCX_MODULES_RSX_SYNC_H
+#define GSCX_MODULES_RSX_SYNC_H
+
+#include "../../../core/include/futex.h"
+#include <atomic>
+#include <cstdint>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Label area: 256 semaphores, 16 bytes apart in the guest's view
+static constexpr uint32_t RSX_LABEL_COUNT = 256;
+static constexpr uint32_t RSX_LABEL_STRIDE = 16;
+
+// Local report area reserved at the top of VRAM: 16-byte report records
+static constexpr uint32_t RSX_REPORT_AREA_SIZE = 1024 * 1024;
+static constexpr uint32_t RSX_REPORT_SIZE = 16;
+
+// Context DMA handles
+static constexpr uint32_t RSX_CONTEXT_DMA_SEMAPHORE_RW = 0x66606660;
+static constexpr uint32_t RSX_CONTEXT_DMA_SEMAPHORE_R = 0x66616661;
+static constexpr uint32_t RSX_CONTEXT_DMA_REPORT_LOCATION_LOCAL = 0x66626660;
+static constexpr uint32_t RSX_CONTEXT_DMA_REPORT_LOCATION_MAIN = 0xBAD68000;
+static constexpr uint32_t RSX_CONTEXT_DMA_NOTIFY_MAIN_0 = 0x6660420F;
+
+// GET_REPORT types
+enum RSXReportType {
+    RSX_REPORT_ZPASS_PIXEL_CNT = 1,
+    RSX_REPORT_ZCULL_STATS = 2,
+    RSX_REPORT_ZCULL_STATS1 = 3,
+    RSX_REPORT_ZCULL_STATS2 = 4,
+    RSX_REPORT_ZCULL_STATS3 = 5
+};
+
+/**
+ * RSX Notifier
+ *
+ * Last NOTIFY written by the RSX; `sequence` counts notifies so a waiter
+ * can tell a new one from the one it already saw.
+ */
+struct RSXNotifier {
+    uint64_t timestamp;     // ns, same clock as reports
+    uint32_t sequence;
+    uint32_t status;        // 0 = done
+};
+
+/**
+ * RSX Sync Unit
+ *
+ * Waits take a timeout in ns (Core::FUTEX_INFINITE for none) and return
+ * false on timeout or when abort_waits() is called, which the pipeline
+ * uses so a stalled semaphore acquire cannot block shutdown.
+ */
+class RSXSyncUnit {
+public:
+    RSXSyncUnit();
+
+    RSXSyncUnit(const RSXSyncUnit&) = delete;
+    RSXSyncUnit& operator=(const RSXSyncUnit&) = delete;
+
+    // Labels
+    uint32_t read_label(uint32_t index) const;
+    void write_label(uint32_t index, uint32_t value);
+    bool wait_label(uint32_t index, uint32_t value, uint64_t timeout_ns = Core::FUTEX_INFINITE);
+
+    // Reference register (NV406E SET_REFERENCE)
+    uint32_t get_reference() const { return reference.load(std::memory_order_acquire); }
+    void set_reference(uint32_t value);
+    bool wait_reference(uint32_t value, uint64_t timeout_ns = Core::FUTEX_INFINITE);
+
+    // Notifier
+    void notify(uint32_t status);
+    RSXNotifier get_notifier() const;
+    // Wait for a notify after the one numbered `sequence`
+    bool wait_notify(uint32_t sequence, uint64_t timeout_ns = Core::FUTEX_INFINITE);
+
+    // Generic event: reports and anything else the RSX writes to memory
+    uint32_t get_event() const { return event.load(std::memory_order_acquire); }
+    void signal();
+    bool wait_event(uint32_t seen, uint64_t timeout_ns = Core::FUTEX_INFINITE);
+
+    void abort_waits();
+    void resume();
+    void reset();
+
+    // Report/notifier timestamp clock
+    uint64_t get_timestamp() const;
+
+private:
+    std::atomic<uint32_t> labels[RSX_LABEL_COUNT];
+    std::atomic<uint32_t> reference;
+    std::atomic<uint64_t> notify_timestamp;
+    std::atomic<uint32_t> notify_sequence;
+    std::atomic<uint32_t> notify_status;
+    std::atomic<uint32_t> event;
+    std::atomic<bool> aborted;
+    uint64_t clock_origin;
+
+    template <typename Ready>
+    bool wait_until(Ready ready, uint64_t timeout_ns);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_SYNC_H
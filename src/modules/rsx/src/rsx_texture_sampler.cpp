@@ -0,0 +1,343 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Texture Sampler Implementation
+ *
+ * Uncompressed texel data is big-endian; DXT blocks use the little-endian
+ * layout of the PC formats they share.
+ */
+
+#include "rsx_texture_sampler.h"
+#include "rsx_core.h"
+#include "rsx_float16.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Texel decoding
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static inline uint16_t load_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static inline uint16_t load_le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static inline float unorm(uint32_t value, uint32_t max) {
+    return static_cast<float>(value) / static_cast<float>(max);
+}
+
+static inline float load_be_float(const uint8_t* p) {
+    uint32_t bits = load_be32(p);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline void set_rgba(float out[4], float r, float g, float b, float a) {
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+    out[3] = a;
+}
+
+// RGB565 endpoint of a DXT block
+static inline void unpack_565(uint16_t c, float out[3]) {
+    out[0] = unorm((c >> 11) & 0x1F, 31);
+    out[1] = unorm((c >> 5) & 0x3F, 63);
+    out[2] = unorm(c & 0x1F, 31);
+}
+
+// Colour part shared by DXT1/3/5; `opaque` forces four-colour mode
+static void decode_dxt_color(const uint8_t* block, uint32_t x, uint32_t y, bool opaque, float out[4]) {
+    uint16_t c0 = load_le16(block);
+    uint16_t c1 = load_le16(block + 2);
+    uint32_t code = (block[4 + y] >> (x * 2)) & 0x3;
+
+    float e0[3], e1[3];
+    unpack_565(c0, e0);
+    unpack_565(c1, e1);
+
+    out[3] = 1.0f;
+    for (uint32_t c = 0; c < 3; c++) {
+        if (code == 0) {
+            out[c] = e0[c];
+        } else if (code == 1) {
+            out[c] = e1[c];
+        } else if (opaque || c0 > c1) {
+            out[c] = code == 2 ? (2.0f * e0[c] + e1[c]) / 3.0f : (e0[c] + 2.0f * e1[c]) / 3.0f;
+        } else {
+            out[c] = code == 2 ? (e0[c] + e1[c]) * 0.5f : 0.0f;
+        }
+    }
+    if (!opaque && c0 <= c1 && code == 3) {
+        out[3] = 0.0f;
+    }
+}
+
+template <uint32_t Format>
+static void decode_texel(const uint8_t* p, uint32_t x, uint32_t y, float out[4]) {
+    (void)x;
+    (void)y;
+
+    if constexpr (Format == RSX_TEXTURE_FORMAT_B8) {
+        float b = unorm(p[0], 255);
+        set_rgba(out, b, b, b, b);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_A1R5G5B5 || Format == RSX_TEXTURE_FORMAT_D1R5G5B5) {
+        uint16_t v = load_be16(p);
+        float a = Format == RSX_TEXTURE_FORMAT_D1R5G5B5 ? 1.0f : static_cast<float>(v >> 15);
+        set_rgba(out, unorm((v >> 10) & 0x1F, 31), unorm((v >> 5) & 0x1F, 31), unorm(v & 0x1F, 31), a);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_R5G5B5A1) {
+        uint16_t v = load_be16(p);
+        set_rgba(out, unorm(v >> 11, 31), unorm((v >> 6) & 0x1F, 31), unorm((v >> 1) & 0x1F, 31),
+                 static_cast<float>(v & 1));
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_A4R4G4B4) {
+        uint16_t v = load_be16(p);
+        set_rgba(out, unorm((v >> 8) & 0xF, 15), unorm((v >> 4) & 0xF, 15), unorm(v & 0xF, 15), unorm(v >> 12, 15));
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_R5G6B5) {
+        uint16_t v = load_be16(p);
+        set_rgba(out, unorm(v >> 11, 31), unorm((v >> 5) & 0x3F, 63), unorm(v & 0x1F, 31), 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_R6G5B5) {
+        uint16_t v = load_be16(p);
+        set_rgba(out, unorm(v >> 10, 63), unorm((v >> 5) & 0x1F, 31), unorm(v & 0x1F, 31), 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_A8R8G8B8 || Format == RSX_TEXTURE_FORMAT_D8R8G8B8) {
+        float a = Format == RSX_TEXTURE_FORMAT_D8R8G8B8 ? 1.0f : unorm(p[0], 255);
+        set_rgba(out, unorm(p[1], 255), unorm(p[2], 255), unorm(p[3], 255), a);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_G8B8) {
+        set_rgba(out, unorm(p[0], 255), unorm(p[1], 255), 0.0f, 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_X16) {
+        set_rgba(out, unorm(load_be16(p), 65535), 0.0f, 0.0f, 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_Y16_X16) {
+        set_rgba(out, unorm(load_be16(p + 2), 65535), unorm(load_be16(p), 65535), 0.0f, 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_Y16_X16_FLOAT) {
+        set_rgba(out, half_to_float(load_be16(p + 2)), half_to_float(load_be16(p)), 0.0f, 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_X32_FLOAT) {
+        set_rgba(out, load_be_float(p), 0.0f, 0.0f, 1.0f);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_W16_Z16_Y16_X16_FLOAT) {
+        set_rgba(out, half_to_float(load_be16(p)), half_to_float(load_be16(p + 2)),
+                 half_to_float(load_be16(p + 4)), half_to_float(load_be16(p + 6)));
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_W32_Z32_Y32_X32_FLOAT) {
+        set_rgba(out, load_be_float(p), load_be_float(p + 4), load_be_float(p + 8), load_be_float(p + 12));
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DEPTH24_D8) {
+        float d = unorm(load_be32(p) >> 8, 0xFFFFFF);
+        set_rgba(out, d, d, d, d);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DEPTH24_D8_FLOAT) {
+        // 24-bit float depth: 8-bit exponent, 16-bit mantissa
+        uint32_t bits = (load_be32(p) >> 8) << 7;
+        float d;
+        std::memcpy(&d, &bits, sizeof(d));
+        set_rgba(out, d, d, d, d);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DEPTH16) {
+        float d = unorm(load_be16(p), 65535);
+        set_rgba(out, d, d, d, d);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DEPTH16_FLOAT) {
+        float d = half_to_float(load_be16(p));
+        set_rgba(out, d, d, d, d);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DXT1) {
+        decode_dxt_color(p, x & 3, y & 3, false, out);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DXT3) {
+        decode_dxt_color(p + 8, x & 3, y & 3, true, out);
+        uint32_t texel = (y & 3) * 4 + (x & 3);
+        out[3] = unorm((p[texel / 2] >> ((texel & 1) * 4)) & 0xF, 15);
+    } else if constexpr (Format == RSX_TEXTURE_FORMAT_DXT5) {
+        decode_dxt_color(p + 8, x & 3, y & 3, true, out);
+        uint32_t texel = (y & 3) * 4 + (x & 3);
+        uint64_t codes = 0;
+        for (uint32_t i = 0; i < 6; i++) {
+            codes |= static_cast<uint64_t>(p[2 + i]) << (i * 8);
+        }
+        uint32_t code = static_cast<uint32_t>(codes >> (texel * 3)) & 0x7;
+        float a0 = unorm(p[0], 255);
+        float a1 = unorm(p[1], 255);
+        if (code == 0) {
+            out[3] = a0;
+        } else if (code == 1) {
+            out[3] = a1;
+        } else if (p[0] > p[1]) {
+            out[3] = (static_cast<float>(8 - code) * a0 + static_cast<float>(code - 1) * a1) / 7.0f;
+        } else if (code < 6) {
+            out[3] = (static_cast<float>(6 - code) * a0 + static_cast<float>(code - 1) * a1) / 5.0f;
+        } else {
+            out[3] = code == 6 ? 0.0f : 1.0f;
+        }
+    } else {
+        set_rgba(out, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+static constexpr uint32_t texel_size(uint32_t format) {
+    switch (format) {
+        case RSX_TEXTURE_FORMAT_B8:
+            return 1;
+        case RSX_TEXTURE_FORMAT_A1R5G5B5:
+        case RSX_TEXTURE_FORMAT_A4R4G4B4:
+        case RSX_TEXTURE_FORMAT_R5G6B5:
+        case RSX_TEXTURE_FORMAT_G8B8:
+        case RSX_TEXTURE_FORMAT_R6G5B5:
+        case RSX_TEXTURE_FORMAT_DEPTH16:
+        case RSX_TEXTURE_FORMAT_DEPTH16_FLOAT:
+        case RSX_TEXTURE_FORMAT_X16:
+        case RSX_TEXTURE_FORMAT_R5G5B5A1:
+        case RSX_TEXTURE_FORMAT_D1R5G5B5:
+            return 2;
+        case RSX_TEXTURE_FORMAT_A8R8G8B8:
+        case RSX_TEXTURE_FORMAT_DEPTH24_D8:
+        case RSX_TEXTURE_FORMAT_DEPTH24_D8_FLOAT:
+        case RSX_TEXTURE_FORMAT_Y16_X16:
+        case RSX_TEXTURE_FORMAT_X32_FLOAT:
+        case RSX_TEXTURE_FORMAT_D8R8G8B8:
+        case RSX_TEXTURE_FORMAT_Y16_X16_FLOAT:
+            return 4;
+        case RSX_TEXTURE_FORMAT_DXT1:
+        case RSX_TEXTURE_FORMAT_W16_Z16_Y16_X16_FLOAT:
+            return 8;
+        case RSX_TEXTURE_FORMAT_DXT3:
+        case RSX_TEXTURE_FORMAT_DXT5:
+        case RSX_TEXTURE_FORMAT_W32_Z32_Y32_X32_FLOAT:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// Addressing
+
+// Interleave x and y bits up to the smaller dimension; the remaining
+// high bits of the larger dimension follow unchanged
+static inline uint32_t swizzle_offset(uint32_t x, uint32_t y, uint32_t log2_width, uint32_t log2_height) {
+    uint32_t offset = 0;
+    uint32_t shift = 0;
+    uint32_t common = std::min(log2_width, log2_height);
+
+    for (uint32_t bit = 0; bit < common; bit++) {
+        offset |= ((x >> bit) & 1) << shift++;
+        offset |= ((y >> bit) & 1) << shift++;
+    }
+    if (log2_width > common) {
+        offset |= (x >> common) << shift;
+    } else {
+        offset |= (y >> common) << shift;
+    }
+    return offset;
+}
+
+static inline uint32_t log2_exact(uint32_t value) {
+    uint32_t log2 = 0;
+    while ((1u << log2) < value) {
+        log2++;
+    }
+    return (1u << log2) == value ? log2 : 0xFFFFFFFF;
+}
+
+// Wrap a coordinate into [0, size); NaN maps to 0
+static inline uint32_t wrap_coordinate(float coord, uint32_t size) {
+    float texel = std::floor(coord);
+    if (!(texel == texel)) {
+        return 0;
+    }
+    texel = std::max(std::min(texel, 1073741824.0f), -1073741824.0f);
+    int64_t wrapped = static_cast<int64_t>(texel) % static_cast<int64_t>(size);
+    return static_cast<uint32_t>(wrapped < 0 ? wrapped + size : wrapped);
+}
+
+template <uint32_t Format>
+static void sample_texture(const RSXSamplerState* state, float (*io)[RSX_SAMPLER_LANES]) {
+    constexpr uint32_t size = texel_size(Format);
+    constexpr bool compressed = Format == RSX_TEXTURE_FORMAT_DXT1 || Format == RSX_TEXTURE_FORMAT_DXT3 ||
+                                Format == RSX_TEXTURE_FORMAT_DXT5;
+
+    if (!state->data || state->width == 0 || state->height == 0) {
+        for (uint32_t lane = 0; lane < RSX_SAMPLER_LANES; lane++) {
+            io[0][lane] = io[1][lane] = io[2][lane] = 0.0f;
+            io[3][lane] = 1.0f;
+        }
+        return;
+    }
+
+    float scale_u = state->unnormalized ? 1.0f : static_cast<float>(state->width);
+    float scale_v = state->unnormalized ? 1.0f : static_cast<float>(state->height);
+    uint32_t log2_width = log2_exact(state->width);
+    uint32_t log2_height = log2_exact(state->height);
+    bool swizzled = !compressed && !state->linear && log2_width != 0xFFFFFFFF && log2_height != 0xFFFFFFFF;
+    uint32_t pitch = state->pitch;
+    if (pitch == 0) {
+        pitch = compressed ? ((state->width + 3) / 4) * size : state->width * size;
+    }
+
+    for (uint32_t lane = 0; lane < RSX_SAMPLER_LANES; lane++) {
+        uint32_t x = wrap_coordinate(io[0][lane] * scale_u, state->width);
+        uint32_t y = wrap_coordinate(io[1][lane] * scale_v, state->height);
+
+        size_t offset;
+        if (compressed) {
+            offset = static_cast<size_t>(y / 4) * pitch + static_cast<size_t>(x / 4) * size;
+        } else if (swizzled) {
+            offset = static_cast<size_t>(swizzle_offset(x, y, log2_width, log2_height)) * size;
+        } else {
+            offset = static_cast<size_t>(y) * pitch + static_cast<size_t>(x) * size;
+        }
+
+        float texel[4];
+        if (offset + size <= state->available) {
+            decode_texel<Format>(state->data + offset, x, y, texel);
+        } else {
+            set_rgba(texel, 0.0f, 0.0f, 0.0f, 0.0f);
+        }
+        for (uint32_t c = 0; c < 4; c++) {
+            io[c][lane] = texel[c];
+        }
+    }
+}
+
+// RSXTextureSampler Implementation
+
+RSXSampleFn RSXTextureSampler::get_sample_function(uint32_t base_format) {
+    switch (base_format) {
+        case RSX_TEXTURE_FORMAT_B8: return &sample_texture<RSX_TEXTURE_FORMAT_B8>;
+        case RSX_TEXTURE_FORMAT_A1R5G5B5: return &sample_texture<RSX_TEXTURE_FORMAT_A1R5G5B5>;
+        case RSX_TEXTURE_FORMAT_A4R4G4B4: return &sample_texture<RSX_TEXTURE_FORMAT_A4R4G4B4>;
+        case RSX_TEXTURE_FORMAT_R5G6B5: return &sample_texture<RSX_TEXTURE_FORMAT_R5G6B5>;
+        case RSX_TEXTURE_FORMAT_A8R8G8B8: return &sample_texture<RSX_TEXTURE_FORMAT_A8R8G8B8>;
+        case RSX_TEXTURE_FORMAT_DXT1: return &sample_texture<RSX_TEXTURE_FORMAT_DXT1>;
+        case RSX_TEXTURE_FORMAT_DXT3: return &sample_texture<RSX_TEXTURE_FORMAT_DXT3>;
+        case RSX_TEXTURE_FORMAT_DXT5: return &sample_texture<RSX_TEXTURE_FORMAT_DXT5>;
+        case RSX_TEXTURE_FORMAT_G8B8: return &sample_texture<RSX_TEXTURE_FORMAT_G8B8>;
+        case RSX_TEXTURE_FORMAT_R6G5B5: return &sample_texture<RSX_TEXTURE_FORMAT_R6G5B5>;
+        case RSX_TEXTURE_FORMAT_DEPTH24_D8: return &sample_texture<RSX_TEXTURE_FORMAT_DEPTH24_D8>;
+        case RSX_TEXTURE_FORMAT_DEPTH24_D8_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_DEPTH24_D8_FLOAT>;
+        case RSX_TEXTURE_FORMAT_DEPTH16: return &sample_texture<RSX_TEXTURE_FORMAT_DEPTH16>;
+        case RSX_TEXTURE_FORMAT_DEPTH16_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_DEPTH16_FLOAT>;
+        case RSX_TEXTURE_FORMAT_X16: return &sample_texture<RSX_TEXTURE_FORMAT_X16>;
+        case RSX_TEXTURE_FORMAT_Y16_X16: return &sample_texture<RSX_TEXTURE_FORMAT_Y16_X16>;
+        case RSX_TEXTURE_FORMAT_R5G5B5A1: return &sample_texture<RSX_TEXTURE_FORMAT_R5G5B5A1>;
+        case RSX_TEXTURE_FORMAT_W16_Z16_Y16_X16_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_W16_Z16_Y16_X16_FLOAT>;
+        case RSX_TEXTURE_FORMAT_W32_Z32_Y32_X32_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_W32_Z32_Y32_X32_FLOAT>;
+        case RSX_TEXTURE_FORMAT_X32_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_X32_FLOAT>;
+        case RSX_TEXTURE_FORMAT_D1R5G5B5: return &sample_texture<RSX_TEXTURE_FORMAT_D1R5G5B5>;
+        case RSX_TEXTURE_FORMAT_D8R8G8B8: return &sample_texture<RSX_TEXTURE_FORMAT_D8R8G8B8>;
+        case RSX_TEXTURE_FORMAT_Y16_X16_FLOAT: return &sample_texture<RSX_TEXTURE_FORMAT_Y16_X16_FLOAT>;
+        default: return &sample_texture<0>;
+    }
+}
+
+uint32_t RSXTextureSampler::get_texel_size(uint32_t base_format) {
+    return texel_size(base_format);
+}
+
+bool RSXTextureSampler::is_compressed(uint32_t base_format) {
+    return base_format == RSX_TEXTURE_FORMAT_DXT1 || base_format == RSX_TEXTURE_FORMAT_DXT3 ||
+           base_format == RSX_TEXTURE_FORMAT_DXT5;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
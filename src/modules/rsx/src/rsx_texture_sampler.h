@@ -0,0 +1,77 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Texture Sampler Header
+ *
+ * Point sampling of RSX textures for the software fragment path, with one
+ * sampling function specialized per texture format.
+ */
+
+#ifndef GSCX_MODULES_RSX_TEXTURE_SAMPLER_H
+#define GSCX_MODULES_RSX_TEXTURE_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Pixels sampled per call, matching the fragment batch
+static constexpr uint32_t RSX_SAMPLER_LANES = 8;
+
+// Format modifier bits carried in the texture format byte
+static constexpr uint32_t RSX_TEXTURE_FORMAT_LN = 0x20;  // Linear (pitch) layout, else swizzled
+static constexpr uint32_t RSX_TEXTURE_FORMAT_UN = 0x40;  // Unnormalized coordinates
+
+/**
+ * RSX Sampler State
+ *
+ * One texture unit resolved for the current draw.
+ */
+struct RSXSamplerState {
+    const uint8_t* data;     // Texel data, null when the unit is unbound
+    size_t available;        // Readable bytes from `data`
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;          // Row pitch in bytes (linear layout)
+    bool linear;             // Pitch layout; otherwise Morton-swizzled
+    bool unnormalized;       // Coordinates are in texels
+
+    RSXSamplerState() : data(nullptr), available(0), width(0), height(0),
+                        pitch(0), linear(true), unnormalized(false) {}
+};
+
+/**
+ * Sample function
+ *
+ * `io` holds one plane per component: u and v are read from planes 0 and
+ * 1, and the sampled RGBA is written back to planes 0-3.
+ */
+using RSXSampleFn = void (*)(const RSXSamplerState* state, float (*io)[RSX_SAMPLER_LANES]);
+
+/**
+ * RSX Texture Sampler
+ *
+ * Nearest filtering with repeat wrapping. Texels are decoded by a
+ * function instantiated per format, so the fragment JIT can bind the
+ * decoder directly; unknown formats sample as (0, 0, 0, 1).
+ */
+class RSXTextureSampler {
+public:
+    // Strip layout/coordinate modifiers from a texture format byte
+    static uint32_t get_base_format(uint32_t format) {
+        return format & ~(RSX_TEXTURE_FORMAT_LN | RSX_TEXTURE_FORMAT_UN);
+    }
+
+    static RSXSampleFn get_sample_function(uint32_t base_format);
+
+    // Bytes per texel, or per 4x4 block for compressed formats
+    static uint32_t get_texel_size(uint32_t base_format);
+    static bool is_compressed(uint32_t base_format);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_TEXTURE_SAMPLER_H
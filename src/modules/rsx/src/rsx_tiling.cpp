@@ -0,0 +1,117 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Tiling Implementation
+ */
+
+#include "rsx_tiling.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+bool RSXTileRegion::is_valid() const {
+    return pitch != 0 && pitch % RSX_TILE_WIDTH == 0 && size != 0 &&
+           offset % RSX_TILE_ALIGNMENT == 0 && size % RSX_TILE_ALIGNMENT == 0 && bank < 4;
+}
+
+// One granule, two unaligned SSE2 moves (x86-64 baseline)
+static inline void copy_granule(uint8_t* dst, const uint8_t* src) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), hi);
+}
+
+template <bool ToTiled>
+static void copy_rows(const RSXTileRegion& region, uint8_t* tiled, uint8_t* linear, uint32_t linear_pitch,
+                      uint32_t x, uint32_t row, uint32_t width, uint32_t rows) {
+    const uint32_t tiled_rows = region.get_tiled_rows();
+    const uint32_t tiles_per_row = region.pitch / RSX_TILE_WIDTH;
+
+    for (uint32_t r = 0; r < rows; r++, linear += linear_pitch) {
+        uint32_t y = row + r;
+        if (y >= tiled_rows) {
+            // Past the last whole tile row the region is linear
+            uint8_t* t = tiled + static_cast<size_t>(y) * region.pitch + x;
+            ToTiled ? std::memcpy(t, linear, width) : std::memcpy(linear, t, width);
+            continue;
+        }
+
+        // Per-row part of the granule address; granules then only differ
+        // by tile and (swizzled) column
+        uint32_t tile_row = y / RSX_TILE_HEIGHT;
+        uint32_t line = y & (RSX_TILE_HEIGHT - 1);
+        uint8_t* row_base = tiled + static_cast<size_t>(tile_row) * tiles_per_row * RSX_TILE_BYTES +
+                            ((line >> 3) << 11) + ((line & 7) << 5);
+        uint32_t swizzle = (tile_row + region.bank) & 7;
+
+        uint32_t done = 0;
+        while (done < width) {
+            uint32_t bx = x + done;
+            uint32_t granule = bx / RSX_TILE_GRANULE;
+            uint32_t skip = bx & (RSX_TILE_GRANULE - 1);
+            uint32_t chunk = std::min(RSX_TILE_GRANULE - skip, width - done);
+            uint8_t* t = row_base + static_cast<size_t>(granule >> 3) * RSX_TILE_BYTES +
+                         (((granule & 7) ^ swizzle) << 8) + skip;
+            uint8_t* l = linear + done;
+            if (chunk == RSX_TILE_GRANULE) {
+                ToTiled ? copy_granule(t, l) : copy_granule(l, t);
+            } else {
+                ToTiled ? std::memcpy(t, l, chunk) : std::memcpy(l, t, chunk);
+            }
+            done += chunk;
+        }
+    }
+}
+
+void rsx_detile(const RSXTileRegion& region, const uint8_t* tiled, uint8_t* dst, uint32_t dst_pitch,
+                uint32_t x, uint32_t row, uint32_t width, uint32_t rows) {
+    copy_rows<false>(region, const_cast<uint8_t*>(tiled), dst, dst_pitch, x, row, width, rows);
+}
+
+void rsx_tile(const RSXTileRegion& region, uint8_t* tiled, const uint8_t* src, uint32_t src_pitch,
+              uint32_t x, uint32_t row, uint32_t width, uint32_t rows) {
+    copy_rows<true>(region, tiled, const_cast<uint8_t*>(src), src_pitch, x, row, width, rows);
+}
+
+// Split a linear range into a leading partial row, whole rows and a
+// trailing partial row, so the whole rows go through one bulk call
+template <bool ToTiled>
+static void copy_range(const RSXTileRegion& region, uint8_t* tiled, uint32_t linear, uint8_t* buffer, uint32_t size) {
+    const uint32_t pitch = region.pitch;
+    uint32_t row = linear / pitch;
+    uint32_t x = linear - row * pitch;
+
+    if (x != 0 && size != 0) {
+        uint32_t width = std::min(pitch - x, size);
+        copy_rows<ToTiled>(region, tiled, buffer, pitch, x, row, width, 1);
+        buffer += width;
+        size -= width;
+        row++;
+    }
+    if (size >= pitch) {
+        uint32_t rows = size / pitch;
+        copy_rows<ToTiled>(region, tiled, buffer, pitch, 0, row, pitch, rows);
+        buffer += static_cast<size_t>(rows) * pitch;
+        size -= rows * pitch;
+        row += rows;
+    }
+    if (size != 0) {
+        copy_rows<ToTiled>(region, tiled, buffer, pitch, 0, row, size, 1);
+    }
+}
+
+void rsx_detile_range(const RSXTileRegion& region, const uint8_t* tiled, uint32_t linear, uint8_t* dst, uint32_t size) {
+    copy_range<false>(region, const_cast<uint8_t*>(tiled), linear, dst, size);
+}
+
+void rsx_tile_range(const RSXTileRegion& region, uint8_t* tiled, uint32_t linear, const uint8_t* src, uint32_t size) {
+    copy_range<true>(region, tiled, linear, const_cast<uint8_t*>(src), size);
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,89 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Tiling Header
+ *
+ * Tiled VRAM regions. Surfaces inside a tile region are stored in tile
+ * order; the rasterizer addresses them through the tile mapping and CPU
+ * reads, writes and presents go through bulk tile/detile copies.
+ */
+
+#ifndef GSCX_MODULES_RSX_TILING_H
+#define GSCX_MODULES_RSX_TILING_H
+
+#include <cstdint>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint32_t RSX_MAX_TILES = 15;
+
+// A tile is 256 bytes by 64 rows. Inside it, rows are grouped by eight;
+// each group holds eight 32-byte-wide columns of eight rows, so a 32-byte
+// granule of one row is the largest run that stays contiguous.
+static constexpr uint32_t RSX_TILE_WIDTH = 256;
+static constexpr uint32_t RSX_TILE_HEIGHT = 64;
+static constexpr uint32_t RSX_TILE_BYTES = RSX_TILE_WIDTH * RSX_TILE_HEIGHT;
+static constexpr uint32_t RSX_TILE_GRANULE = 32;
+static constexpr uint32_t RSX_TILE_ALIGNMENT = 64 * 1024;
+
+/**
+ * RSX Tile Region
+ *
+ * Offsets are VRAM offsets. Only whole rows of tiles are tiled; rows in a
+ * last partial tile row stay linear. The bank rotates granule columns per
+ * tile row, as the hardware does to spread rows over DRAM banks.
+ */
+struct RSXTileRegion {
+    uint32_t offset;         // Start, RSX_TILE_ALIGNMENT aligned
+    uint32_t size;           // Bytes, RSX_TILE_ALIGNMENT multiple
+    uint32_t pitch;          // Bytes per row, RSX_TILE_WIDTH multiple
+    uint32_t bank;           // 0-3
+    uint32_t comp;           // Compression mode; stored, not emulated
+    bool enabled;
+
+    RSXTileRegion() : offset(0), size(0), pitch(0), bank(0), comp(0), enabled(false) {}
+
+    bool is_valid() const;
+    bool contains(uint32_t vram_offset) const {
+        return enabled && vram_offset >= offset && vram_offset - offset < size;
+    }
+    uint32_t get_tiled_rows() const {
+        return size / (pitch * RSX_TILE_HEIGHT) * RSX_TILE_HEIGHT;
+    }
+
+    // Tiled offset of linear byte `linear` (both relative to the region)
+    uint32_t to_tiled(uint32_t linear) const {
+        uint32_t row = linear / pitch;
+        if (row >= get_tiled_rows()) {
+            return linear;
+        }
+        uint32_t x = linear - row * pitch;
+        return get_granule(row, x) + (x & (RSX_TILE_GRANULE - 1));
+    }
+
+    // Tiled offset of the granule holding byte `x` of `row`
+    uint32_t get_granule(uint32_t row, uint32_t x) const {
+        uint32_t tile = (row / RSX_TILE_HEIGHT) * (pitch / RSX_TILE_WIDTH) + x / RSX_TILE_WIDTH;
+        uint32_t column = ((x / RSX_TILE_GRANULE) ^ (row / RSX_TILE_HEIGHT + bank)) & 7;
+        uint32_t y = row & (RSX_TILE_HEIGHT - 1);
+        return tile * RSX_TILE_BYTES + ((y >> 3) << 11) + (column << 8) + ((y & 7) << 5);
+    }
+};
+
+// Copy `rows` rows of `width` bytes starting at byte `x` of `row` between
+// a tile region (`tiled` points at its first byte) and a linear buffer
+void rsx_detile(const RSXTileRegion& region, const uint8_t* tiled, uint8_t* dst, uint32_t dst_pitch,
+                uint32_t x, uint32_t row, uint32_t width, uint32_t rows);
+void rsx_tile(const RSXTileRegion& region, uint8_t* tiled, const uint8_t* src, uint32_t src_pitch,
+              uint32_t x, uint32_t row, uint32_t width, uint32_t rows);
+
+// Linear byte range [linear, linear + size) of the region
+void rsx_detile_range(const RSXTileRegion& region, const uint8_t* tiled, uint32_t linear, uint8_t* dst, uint32_t size);
+void rsx_tile_range(const RSXTileRegion& region, uint8_t* tiled, uint32_t linear, const uint8_t* src, uint32_t size);
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_TILING_H
@@ -0,0 +1,259 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX VBlank Implementation
+ */
+
+#include "rsx_vblank.h"
+#include <algorithm>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// One refresh period as num/den ns: 1001/60000 s and 1/50 s
+static constexpr uint64_t NTSC_PERIOD_NUM = 100100000;
+static constexpr uint64_t NTSC_PERIOD_DEN = 6;
+static constexpr uint64_t PAL_PERIOD_NS = 20000000;
+
+std::chrono::nanoseconds rsx_get_vblank_duration(RSXRefreshRate rate, uint64_t vblanks) {
+    uint64_t ns = rate == RSXRefreshRate::HZ_50 ? vblanks * PAL_PERIOD_NS
+                                                 : vblanks * NTSC_PERIOD_NUM / NTSC_PERIOD_DEN;
+    return std::chrono::nanoseconds(static_cast<int64_t>(ns));
+}
+
+// Whole periods in `elapsed`
+static uint64_t get_vblanks_in(RSXRefreshRate rate, std::chrono::nanoseconds elapsed) {
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+    return rate == RSXRefreshRate::HZ_50 ? ns / PAL_PERIOD_NS : ns * NTSC_PERIOD_DEN / NTSC_PERIOD_NUM;
+}
+
+RSXVBlankClock::RSXVBlankClock()
+    : running(false)
+    , completed_flips(0)
+    , last_flip_vblank(0)
+    , origin(Clock::now())
+    , origin_vblank(0)
+    , vblank_count(0)
+    , late_vblanks(0)
+    , has_last_flip(false)
+    , stats_flips(0)
+    , frame_time_next(0) {
+}
+
+RSXVBlankClock::~RSXVBlankClock() {
+    stop();
+}
+
+void RSXVBlankClock::start(const RSXFramePacingConfig& new_config) {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    config = RSXFramePacingConfig();
+    set_config(new_config);
+    origin = Clock::now();
+    origin_vblank = vblank_count;
+    last_flip_vblank = vblank_count;
+    running = true;
+    thread = std::thread(&RSXVBlankClock::run, this);
+}
+
+void RSXVBlankClock::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        while (!flips.empty()) {
+            complete_flip(Clock::now());
+        }
+        running = false;
+    }
+    wake.notify_all();
+    tick.notify_all();
+    thread.join();
+}
+
+bool RSXVBlankClock::is_running() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+void RSXVBlankClock::configure(const RSXFramePacingConfig& new_config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        set_config(new_config);
+        if (config.mode == RSXFramePacing::UNCAPPED) {
+            while (!flips.empty()) {
+                complete_flip(Clock::now());
+            }
+        }
+    }
+    wake.notify_all();
+    tick.notify_all();
+}
+
+void RSXVBlankClock::set_config(const RSXFramePacingConfig& new_config) {
+    if (new_config.refresh_rate != config.refresh_rate) {
+        origin = Clock::now();
+        origin_vblank = vblank_count;
+    }
+    config = new_config;
+    config.swap_interval = std::max(config.swap_interval, 1u);
+    config.max_queued_flips = std::clamp(config.max_queued_flips, 1u, RSX_MAX_QUEUED_FLIPS);
+}
+
+RSXFramePacingConfig RSXVBlankClock::get_config() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return config;
+}
+
+void RSXVBlankClock::set_flip_handler(FlipHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flip_handler = std::move(handler);
+}
+
+uint64_t RSXVBlankClock::get_vblank_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return vblank_count;
+}
+
+bool RSXVBlankClock::wait_vblank(uint64_t count, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto passed = [&] { return vblank_count > count || !running; };
+    if (timeout == std::chrono::nanoseconds::max()) {
+        tick.wait(lock, passed);
+    } else {
+        tick.wait_for(lock, timeout, passed);
+    }
+    return vblank_count > count;
+}
+
+void RSXVBlankClock::wait_flip_slot() {
+    std::unique_lock<std::mutex> lock(mutex);
+    tick.wait(lock, [&] {
+        return !running || config.mode == RSXFramePacing::UNCAPPED || flips.size() < config.max_queued_flips;
+    });
+}
+
+void RSXVBlankClock::queue_flip(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flips.push_back(id);
+    if (!running || config.mode == RSXFramePacing::UNCAPPED) {
+        complete_flip(Clock::now());
+    }
+}
+
+void RSXVBlankClock::flush_flips() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!flips.empty()) {
+            complete_flip(Clock::now());
+        }
+    }
+    tick.notify_all();
+}
+
+uint32_t RSXVBlankClock::get_queued_flips() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint32_t>(flips.size());
+}
+
+uint64_t RSXVBlankClock::get_completed_flips() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed_flips;
+}
+
+RSXVBlankClock::Clock::time_point RSXVBlankClock::get_deadline(uint64_t vblank) const {
+    return origin + std::chrono::duration_cast<Clock::duration>(
+        rsx_get_vblank_duration(config.refresh_rate, vblank - origin_vblank));
+}
+
+void RSXVBlankClock::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        // Re-evaluated after every wake: configure() may move the deadline
+        Clock::time_point deadline = get_deadline(vblank_count + 1);
+        Clock::time_point now = Clock::now();
+        if (now < deadline) {
+            wake.wait_until(lock, deadline);
+            continue;
+        }
+
+        // The deadline is rounded down to whole ns, so `due` can be one short
+        uint64_t due = std::max(vblank_count + 1, origin_vblank + get_vblanks_in(config.refresh_rate, now - origin));
+        late_vblanks += due - (vblank_count + 1);
+        vblank_count = due;
+        if (!flips.empty() && vblank_count >= last_flip_vblank + config.swap_interval) {
+            complete_flip(now);
+        }
+        tick.notify_all();
+    }
+}
+
+void RSXVBlankClock::complete_flip(Clock::time_point now) {
+    uint64_t id = flips.front();
+    flips.pop_front();
+    completed_flips++;
+    last_flip_vblank = vblank_count;
+
+    if (has_last_flip) {
+        double time_ms = std::chrono::duration<double, std::milli>(now - last_flip_time).count();
+        if (frame_times.size() < RSX_FRAME_TIME_WINDOW) {
+            frame_times.push_back(time_ms);
+        } else {
+            frame_times[frame_time_next] = time_ms;
+        }
+        frame_time_next = (frame_time_next + 1) % RSX_FRAME_TIME_WINDOW;
+    }
+    last_flip_time = now;
+    has_last_flip = true;
+    stats_flips++;
+
+    if (flip_handler) {
+        flip_handler(id);
+    }
+    tick.notify_all();
+}
+
+RSXFrameStats RSXVBlankClock::get_stats() const {
+    std::vector<double> times;
+    RSXFrameStats stats = {};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        times = frame_times;
+        stats.flips = stats_flips;
+        stats.vblanks = vblank_count;
+        stats.late_vblanks = late_vblanks;
+    }
+    if (times.empty()) {
+        return stats;
+    }
+
+    double total_ms = 0.0;
+    for (double ms : times) {
+        total_ms += ms;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) {
+        return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+    };
+    stats.mean_ms = total_ms / times.size();
+    stats.fps = total_ms > 0.0 ? times.size() * 1000.0 / total_ms : 0.0;
+    stats.p50_ms = percentile(0.5);
+    stats.p95_ms = percentile(0.95);
+    stats.p99_ms = percentile(0.99);
+    stats.max_ms = times.back();
+    return stats;
+}
+
+void RSXVBlankClock::reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    frame_times.clear();
+    frame_time_next = 0;
+    has_last_flip = false;
+    stats_flips = 0;
+    late_vblanks = 0;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
@@ -0,0 +1,165 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX VBlank Header
+ *
+ * Virtual display timing: a vblank counter driven by the host steady
+ * clock at the video mode's refresh rate, and a flip queue whose flips
+ * take effect on vblanks, as cellGcmSetFlip's do. The clock also keeps
+ * flip-to-flip frame times for pacing and benchmark reports.
+ */
+
+#ifndef GSCX_MODULES_RSX_VBLANK_H
+#define GSCX_MODULES_RSX_VBLANK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Flips waiting for a vblank: the frame ring has three slots, one of
+// which is always on screen
+static constexpr uint32_t RSX_MAX_QUEUED_FLIPS = 2;
+
+// Frame times kept for the percentiles
+static constexpr size_t RSX_FRAME_TIME_WINDOW = 1024;
+
+enum class RSXRefreshRate : uint32_t {
+    HZ_59_94 = 0,   // NTSC modes, 60000/1001
+    HZ_50 = 1       // PAL modes
+};
+
+enum class RSXFramePacing : uint32_t {
+    VSYNC = 0,      // flips complete on vblanks; swaps block when the queue is full
+    UNCAPPED = 1    // flips complete at once; for measuring raw throughput
+};
+
+struct RSXFramePacingConfig {
+    RSXRefreshRate refresh_rate;
+    RSXFramePacing mode;
+    uint32_t swap_interval;     // vblanks each frame stays on screen: 1 = full rate, 2 = half
+    uint32_t max_queued_flips;  // 1..RSX_MAX_QUEUED_FLIPS; 1 is lowest latency, 2 absorbs spikes
+
+    RSXFramePacingConfig()
+        : refresh_rate(RSXRefreshRate::HZ_59_94)
+        , mode(RSXFramePacing::VSYNC)
+        , swap_interval(1)
+        , max_queued_flips(RSX_MAX_QUEUED_FLIPS) {}
+};
+
+/**
+ * RSX Frame Stats
+ *
+ * Frame times are flip to flip over the last RSX_FRAME_TIME_WINDOW
+ * flips, so in VSYNC mode they show the cadence the user sees and in
+ * UNCAPPED mode the rate the emulator produces frames at.
+ */
+struct RSXFrameStats {
+    uint64_t flips;             // since the last reset
+    uint64_t vblanks;           // counter value, never reset
+    uint64_t late_vblanks;      // vblanks the clock thread woke up too late for
+    double fps;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+/**
+ * RSX VBlank Clock
+ *
+ * Runs one thread that ticks the vblank counter. Each tick completes at
+ * most one queued flip, and only once `swap_interval` vblanks have passed
+ * since the previous flip; the flip handler runs on the clock thread with
+ * the queue locked, so it must be short. Ticks missed while the host was
+ * busy are still counted, as a real counter would, but flips never
+ * complete more than one per tick.
+ */
+class RSXVBlankClock {
+public:
+    using FlipHandler = std::function<void(uint64_t id)>;
+
+    RSXVBlankClock();
+    ~RSXVBlankClock();
+
+    RSXVBlankClock(const RSXVBlankClock&) = delete;
+    RSXVBlankClock& operator=(const RSXVBlankClock&) = delete;
+
+    void start(const RSXFramePacingConfig& config);
+    // Completes the queued flips at once, then stops the thread
+    void stop();
+    bool is_running() const;
+
+    // Takes effect on the next vblank; queued flips are kept
+    void configure(const RSXFramePacingConfig& config);
+    RSXFramePacingConfig get_config() const;
+    void set_flip_handler(FlipHandler handler);
+
+    uint64_t get_vblank_count() const;
+    // Wait for the counter to pass `count`; false on timeout or stop
+    bool wait_vblank(uint64_t count, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max());
+
+    // Block until another flip can be queued; the caller does this before
+    // reusing the buffer the oldest queued flip will release
+    void wait_flip_slot();
+    // Queue flip `id`; in UNCAPPED mode, or when stopped, it completes here
+    void queue_flip(uint64_t id);
+    // Complete every queued flip now
+    void flush_flips();
+    uint32_t get_queued_flips() const;
+    uint64_t get_completed_flips() const;
+
+    RSXFrameStats get_stats() const;
+    void reset_stats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex mutex;
+    std::condition_variable tick;       // vblank passed, flip completed or stop
+    std::condition_variable wake;       // wakes the clock thread early
+    std::thread thread;
+    bool running;
+
+    RSXFramePacingConfig config;
+    FlipHandler flip_handler;
+    std::deque<uint64_t> flips;
+    uint64_t completed_flips;
+    uint64_t last_flip_vblank;
+
+    // Tick n is due at origin + n periods, so rounding never accumulates;
+    // the origin moves when the refresh rate changes
+    Clock::time_point origin;
+    uint64_t origin_vblank;
+    uint64_t vblank_count;
+    uint64_t late_vblanks;
+
+    Clock::time_point last_flip_time;
+    bool has_last_flip;
+    uint64_t stats_flips;
+    std::vector<double> frame_times;    // ring of RSX_FRAME_TIME_WINDOW
+    size_t frame_time_next;
+
+    void run();
+    Clock::time_point get_deadline(uint64_t vblank) const;
+    // Caller holds the mutex
+    void complete_flip(Clock::time_point now);
+    void set_config(const RSXFramePacingConfig& new_config);
+};
+
+// Duration of `vblanks` refresh periods, exact for both rates
+std::chrono::nanoseconds rsx_get_vblank_duration(RSXRefreshRate rate, uint64_t vblanks);
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_VBLANK_H
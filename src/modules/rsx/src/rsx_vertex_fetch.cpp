@@ -0,0 +1,301 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Vertex Fetch Implementation
+ *
+ * Attribute data on the RSX is big-endian. Each kernel loads one vertex
+ * per 128-bit register, byte-swaps with PSHUFB, converts to float and
+ * transposes groups of four vertices into the SoA output planes.
+ */
+
+#include "rsx_vertex_fetch.h"
+#include "rsx_core.h"
+#include "rsx_float16.h"
+#include "../../../core/include/simd_support.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint32_t RSX_VERTEX_TYPE_FIRST = RSX_VERTEX_ATTR_TYPE_FLOAT;
+static constexpr uint32_t RSX_VERTEX_TYPE_COUNT = 5;
+static constexpr uint32_t RSX_VERTEX_STREAM_PADDING = 8;
+
+void RSXVertexStream::resize(uint32_t vertex_count) {
+    count = vertex_count;
+    uint32_t padded = (vertex_count + RSX_VERTEX_STREAM_PADDING - 1) & ~(RSX_VERTEX_STREAM_PADDING - 1);
+    for (auto& plane : components) {
+        plane.resize(padded);
+    }
+}
+
+// Scalar helpers
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static inline uint16_t load_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+template <uint32_t Type, bool Normalized>
+static inline float fetch_component(const uint8_t* src, uint32_t component) {
+    if constexpr (Type == RSX_VERTEX_ATTR_TYPE_FLOAT) {
+        uint32_t bits = load_be32(src + component * 4);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    } else if constexpr (Type == RSX_VERTEX_ATTR_TYPE_HALF_FLOAT) {
+        return half_to_float(load_be16(src + component * 2));
+    } else if constexpr (Type == RSX_VERTEX_ATTR_TYPE_UNSIGNED_BYTE) {
+        float value = static_cast<float>(src[component]);
+        return Normalized ? value * (1.0f / 255.0f) : value;
+    } else {
+        float value = static_cast<float>(static_cast<int16_t>(load_be16(src + component * 2)));
+        return Normalized ? std::max(value * (1.0f / 32767.0f), -1.0f) : value;
+    }
+}
+
+template <uint32_t Type, uint32_t Size, bool Normalized>
+static inline void fetch_vertex_scalar(const uint8_t* src, float* const out[4], uint32_t index) {
+    if constexpr (Type == RSX_VERTEX_ATTR_TYPE_COMPRESSED_NORMAL) {
+        // 11:11:10 signed normal packed in one word
+        int32_t word = static_cast<int32_t>(load_be32(src));
+        out[0][index] = static_cast<float>((word << 21) >> 21) * (1.0f / 1023.0f);
+        out[1][index] = static_cast<float>((word << 10) >> 21) * (1.0f / 1023.0f);
+        out[2][index] = static_cast<float>(word >> 22) * (1.0f / 511.0f);
+        out[3][index] = 1.0f;
+    } else {
+        for (uint32_t c = 0; c < 4; c++) {
+            out[c][index] = c < Size ? fetch_component<Type, Normalized>(src, c) : (c == 3 ? 1.0f : 0.0f);
+        }
+    }
+}
+
+template <uint32_t Type, uint32_t Size, bool Normalized>
+static void fetch_kernel_scalar(const uint8_t* src, uint32_t stride, uint32_t count,
+                                uint32_t, float* const out[4]) {
+    for (uint32_t i = 0; i < count; i++) {
+        fetch_vertex_scalar<Type, Size, Normalized>(src + static_cast<size_t>(i) * stride, out, i);
+    }
+}
+
+// SIMD helpers
+
+// Bytes read by one SIMD vertex load; may exceed the attribute size
+template <uint32_t Type>
+static constexpr uint32_t simd_load_width() {
+    if constexpr (Type == RSX_VERTEX_ATTR_TYPE_FLOAT) return 16;
+    else if constexpr (Type == RSX_VERTEX_ATTR_TYPE_HALF_FLOAT || Type == RSX_VERTEX_ATTR_TYPE_SHORT) return 8;
+    else return 4;
+}
+
+GSCX_TARGET_SSSE3 static inline __m128i bswap32_epi32(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+}
+
+GSCX_TARGET_SSSE3 static inline __m128i bswap16_epi16(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+}
+
+static inline __m128i load_u32_si128(const uint8_t* p) {
+    int32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return _mm_cvtsi32_si128(value);
+}
+
+// Half to float for four zero-extended halves in 32-bit lanes
+// (exponent rebias by multiply, so denormals come out right)
+static inline __m128 half4_to_float4(__m128i h) {
+    const __m128i mask_nosign = _mm_set1_epi32(0x7FFF);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128i was_infnan = _mm_set1_epi32(0x7BFF);
+    const __m128i exp_infnan = _mm_set1_epi32(255 << 23);
+
+    __m128i expmant = _mm_and_si128(mask_nosign, h);
+    __m128i justsign = _mm_xor_si128(h, expmant);
+    __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), magic);
+    __m128i infnan = _mm_and_si128(_mm_cmpgt_epi32(expmant, was_infnan), exp_infnan);
+    __m128i sign = _mm_slli_epi32(justsign, 16);
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infnan)));
+}
+
+template <uint32_t Type, bool Normalized>
+GSCX_TARGET_SSSE3 static inline __m128 load_vertex_simd(const uint8_t* src) {
+    if constexpr (Type == RSX_VERTEX_ATTR_TYPE_FLOAT) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        return _mm_castsi128_ps(bswap32_epi32(raw));
+    } else if constexpr (Type == RSX_VERTEX_ATTR_TYPE_HALF_FLOAT) {
+        __m128i raw = bswap16_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+        return half4_to_float4(_mm_unpacklo_epi16(raw, _mm_setzero_si128()));
+    } else if constexpr (Type == RSX_VERTEX_ATTR_TYPE_UNSIGNED_BYTE) {
+        __m128i raw = _mm_unpacklo_epi8(load_u32_si128(src), _mm_setzero_si128());
+        __m128 value = _mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, _mm_setzero_si128()));
+        return Normalized ? _mm_mul_ps(value, _mm_set1_ps(1.0f / 255.0f)) : value;
+    } else {
+        __m128i raw = bswap16_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+        __m128i wide = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+        __m128 value = _mm_cvtepi32_ps(wide);
+        if constexpr (Normalized) {
+            value = _mm_max_ps(_mm_mul_ps(value, _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+        }
+        return value;
+    }
+}
+
+template <uint32_t Type, uint32_t Size, bool Normalized>
+GSCX_TARGET_SSSE3 static void fetch_kernel_simd(const uint8_t* src, uint32_t stride, uint32_t count,
+                                                uint32_t simd_count, float* const out[4]) {
+    uint32_t i = 0;
+
+    if constexpr (Type == RSX_VERTEX_ATTR_TYPE_COMPRESSED_NORMAL) {
+        // One word per vertex: gather four words and unpack straight into planes
+        for (; i + 4 <= simd_count; i += 4) {
+            const uint8_t* p = src + static_cast<size_t>(i) * stride;
+            __m128i w01 = _mm_unpacklo_epi32(load_u32_si128(p), load_u32_si128(p + stride));
+            __m128i w23 = _mm_unpacklo_epi32(load_u32_si128(p + 2 * stride), load_u32_si128(p + 3 * stride));
+            __m128i words = bswap32_epi32(_mm_unpacklo_epi64(w01, w23));
+
+            __m128i x = _mm_srai_epi32(_mm_slli_epi32(words, 21), 21);
+            __m128i y = _mm_srai_epi32(_mm_slli_epi32(words, 10), 21);
+            __m128i z = _mm_srai_epi32(words, 22);
+
+            _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(1.0f / 1023.0f)));
+            _mm_storeu_ps(out[1] + i, _mm_mul_ps(_mm_cvtepi32_ps(y), _mm_set1_ps(1.0f / 1023.0f)));
+            _mm_storeu_ps(out[2] + i, _mm_mul_ps(_mm_cvtepi32_ps(z), _mm_set1_ps(1.0f / 511.0f)));
+            _mm_storeu_ps(out[3] + i, _mm_set1_ps(1.0f));
+        }
+    } else {
+        // Lanes past Size hold neighbouring data; replace them with (0, 0, 0, 1)
+        const __m128 keep = _mm_castsi128_ps(_mm_setr_epi32(
+            Size > 0 ? -1 : 0, Size > 1 ? -1 : 0, Size > 2 ? -1 : 0, Size > 3 ? -1 : 0));
+        const __m128 defaults = _mm_andnot_ps(keep, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+
+        for (; i + 4 <= simd_count; i += 4) {
+            const uint8_t* p = src + static_cast<size_t>(i) * stride;
+            __m128 v0 = _mm_or_ps(_mm_and_ps(load_vertex_simd<Type, Normalized>(p), keep), defaults);
+            __m128 v1 = _mm_or_ps(_mm_and_ps(load_vertex_simd<Type, Normalized>(p + stride), keep), defaults);
+            __m128 v2 = _mm_or_ps(_mm_and_ps(load_vertex_simd<Type, Normalized>(p + 2 * stride), keep), defaults);
+            __m128 v3 = _mm_or_ps(_mm_and_ps(load_vertex_simd<Type, Normalized>(p + 3 * stride), keep), defaults);
+
+            _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+
+            _mm_storeu_ps(out[0] + i, v0);
+            _mm_storeu_ps(out[1] + i, v1);
+            _mm_storeu_ps(out[2] + i, v2);
+            _mm_storeu_ps(out[3] + i, v3);
+        }
+    }
+
+    // Tail and vertices too close to the end of the source for a wide load
+    for (; i < count; i++) {
+        fetch_vertex_scalar<Type, Size, Normalized>(src + static_cast<size_t>(i) * stride, out, i);
+    }
+}
+
+// Kernel tables, indexed by [type - FLOAT][size - 1][normalized]
+
+using FetchKernel = RSXVertexFetcher::FetchKernel;
+using KernelTable = std::array<FetchKernel, RSX_VERTEX_TYPE_COUNT * 4 * 2>;
+
+template <bool Simd, size_t Index>
+static constexpr FetchKernel make_kernel() {
+    constexpr uint32_t type = RSX_VERTEX_TYPE_FIRST + static_cast<uint32_t>(Index / 8);
+    constexpr uint32_t size = static_cast<uint32_t>((Index / 2) % 4) + 1;
+    constexpr bool normalized = (Index % 2) != 0;
+    if constexpr (Simd) {
+        return &fetch_kernel_simd<type, size, normalized>;
+    } else {
+        return &fetch_kernel_scalar<type, size, normalized>;
+    }
+}
+
+template <bool Simd, size_t... Indices>
+static constexpr KernelTable make_kernel_table(std::index_sequence<Indices...>) {
+    return KernelTable{ make_kernel<Simd, Indices>()... };
+}
+
+static constexpr KernelTable simd_kernels =
+    make_kernel_table<true>(std::make_index_sequence<RSX_VERTEX_TYPE_COUNT * 4 * 2>{});
+static constexpr KernelTable scalar_kernels =
+    make_kernel_table<false>(std::make_index_sequence<RSX_VERTEX_TYPE_COUNT * 4 * 2>{});
+
+static constexpr uint32_t simd_load_widths[RSX_VERTEX_TYPE_COUNT] = {
+    simd_load_width<RSX_VERTEX_ATTR_TYPE_FLOAT>(),
+    simd_load_width<RSX_VERTEX_ATTR_TYPE_HALF_FLOAT>(),
+    simd_load_width<RSX_VERTEX_ATTR_TYPE_UNSIGNED_BYTE>(),
+    simd_load_width<RSX_VERTEX_ATTR_TYPE_SHORT>(),
+    simd_load_width<RSX_VERTEX_ATTR_TYPE_COMPRESSED_NORMAL>(),
+};
+
+RSXVertexFetcher::RSXVertexFetcher()
+    : use_simd(Core::get_host_cpu_features().ssse3) {
+}
+
+uint32_t RSXVertexFetcher::get_attribute_size(uint32_t type, uint32_t size) {
+    switch (type) {
+        case RSX_VERTEX_ATTR_TYPE_FLOAT:
+            return size * 4;
+        case RSX_VERTEX_ATTR_TYPE_HALF_FLOAT:
+        case RSX_VERTEX_ATTR_TYPE_SHORT:
+            return size * 2;
+        case RSX_VERTEX_ATTR_TYPE_UNSIGNED_BYTE:
+            return size;
+        case RSX_VERTEX_ATTR_TYPE_COMPRESSED_NORMAL:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+bool RSXVertexFetcher::fetch(const RSXVertexAttribute& attribute, const uint8_t* src, size_t available,
+                             uint32_t count, RSXVertexStream& out) const {
+    uint32_t type_index = attribute.type - RSX_VERTEX_TYPE_FIRST;
+    if (type_index >= RSX_VERTEX_TYPE_COUNT || attribute.size < 1 || attribute.size > 4 || !src) {
+        return false;
+    }
+
+    out.resize(count);
+    if (count == 0) {
+        return true;
+    }
+
+    // Every vertex must be readable at its exact size
+    size_t element_size = get_attribute_size(attribute.type, attribute.size);
+    size_t last_offset = static_cast<size_t>(count - 1) * attribute.stride;
+    if (last_offset + element_size > available) {
+        return false;
+    }
+
+    // Vertices whose wide load stays inside the source
+    uint32_t simd_count = 0;
+    size_t load_width = simd_load_widths[type_index];
+    if (use_simd && available >= load_width) {
+        if (attribute.stride == 0) {
+            simd_count = count;
+        } else {
+            size_t fits = (available - load_width) / attribute.stride + 1;
+            simd_count = static_cast<uint32_t>(std::min<size_t>(count, fits));
+        }
+    }
+
+    size_t index = (type_index * 4 + (attribute.size - 1)) * 2 + (attribute.normalized ? 1 : 0);
+    FetchKernel kernel = use_simd ? simd_kernels[index] : scalar_kernels[index];
+
+    float* const planes[4] = {
+        out.components[0].data(), out.components[1].data(),
+        out.components[2].data(), out.components[3].data()
+    };
+    kernel(src, attribute.stride, count, simd_count, planes);
+    return true;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
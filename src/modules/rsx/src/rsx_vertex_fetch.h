@@ -0,0 +1,68 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Vertex Fetch Header
+ *
+ * Reads big-endian vertex attributes from VRAM or mapped main memory
+ * and converts them into structure-of-arrays float streams.
+ */
+
+#ifndef GSCX_MODULES_RSX_VERTEX_FETCH_H
+#define GSCX_MODULES_RSX_VERTEX_FETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+struct RSXVertexAttribute;
+
+/**
+ * RSX Vertex Stream
+ *
+ * One fetched attribute in SoA layout: a float plane per component.
+ * Planes are padded to a multiple of 8 vertices so wide consumers
+ * can run without tail handling.
+ */
+struct RSXVertexStream {
+    std::vector<float> components[4];  // x, y, z, w planes
+    uint32_t count;                    // Number of valid vertices
+
+    RSXVertexStream() : count(0) {}
+
+    void resize(uint32_t vertex_count);
+};
+
+/**
+ * RSX Vertex Fetcher
+ *
+ * Converts attributes with SSSE3 kernels generated per
+ * (type, size, normalized) combination, falling back to scalar
+ * kernels on hosts without SSSE3. Missing components default to (0, 0, 0, 1).
+ */
+class RSXVertexFetcher {
+public:
+    RSXVertexFetcher();
+
+    // Fetch `count` vertices starting at `src`. `available` is the number of
+    // readable bytes from `src`; returns false if the attribute would overrun it.
+    bool fetch(const RSXVertexAttribute& attribute, const uint8_t* src, size_t available,
+               uint32_t count, RSXVertexStream& out) const;
+
+    // Size in bytes of one attribute element (all components)
+    static uint32_t get_attribute_size(uint32_t type, uint32_t size);
+
+    using FetchKernel = void (*)(const uint8_t* src, uint32_t stride, uint32_t count,
+                                 uint32_t simd_count, float* const out[4]);
+
+private:
+    bool use_simd;
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_VERTEX_FETCH_H
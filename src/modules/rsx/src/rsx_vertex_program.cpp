@@ -0,0 +1,890 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Vertex Program Implementation
+ *
+ * The interpreter defines the reference semantics; the JIT mirrors its
+ * operation order (no fused multiply-add, same min/max/saturate NaN
+ * behaviour) so both produce bit-identical results.
+ */
+
+#include "rsx_vertex_program.h"
+#include "rsx_program_hash.h"
+#include "rsx_shader_cache.h"
+#include "../../../core/include/simd_support.h"
+#include "../../../core/include/x64_emitter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+static constexpr uint32_t RSX_VP_NO_TEMP = 0x3F;
+static constexpr uint32_t RSX_VP_NO_OUTPUT = 0x1F;
+static constexpr uint32_t RSX_VP_CALL_DEPTH = 8;
+static constexpr uint32_t RSX_VP_MAX_STEPS = 65536;
+
+// Condition codes
+enum RSXVPCondition {
+    RSX_VP_COND_FL = 0,
+    RSX_VP_COND_LT = 1,
+    RSX_VP_COND_EQ = 2,
+    RSX_VP_COND_LE = 3,
+    RSX_VP_COND_GT = 4,
+    RSX_VP_COND_NE = 5,
+    RSX_VP_COND_GE = 6,
+    RSX_VP_COND_TR = 7
+};
+
+RSXVertexBatch::RSXVertexBatch() {
+    std::memset(inputs, 0, sizeof(inputs));
+    std::memset(temps, 0, sizeof(temps));
+    std::memset(outputs, 0, sizeof(outputs));
+    std::memset(scratch, 0, sizeof(scratch));
+
+    const uint32_t sign_mask = 0x80000000u;
+    const uint32_t abs_mask = 0x7FFFFFFFu;
+    for (uint32_t lane = 0; lane < RSX_VP_BATCH_SIZE; lane++) {
+        std::memcpy(&literals[0][lane], &sign_mask, sizeof(float));
+        std::memcpy(&literals[1][lane], &abs_mask, sizeof(float));
+        literals[2][lane] = 1.0f;
+        literals[3][lane] = 0.0f;
+    }
+}
+
+// Interpreter
+
+namespace {
+
+struct LaneState {
+    RSXVertexBatch& batch;
+    const float* constants;
+    uint32_t lane;
+    int32_t address[2][4];
+    float cc[2][4];
+};
+
+inline float saturate(float value) {
+    return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+}
+
+// Same operand order as MINPS/MAXPS
+inline float min_ps(float a, float b) { return a < b ? a : b; }
+inline float max_ps(float a, float b) { return a > b ? a : b; }
+
+inline bool test_condition(uint32_t cond, float value) {
+    switch (cond) {
+        case RSX_VP_COND_FL: return false;
+        case RSX_VP_COND_LT: return value < 0.0f;
+        case RSX_VP_COND_EQ: return value == 0.0f;
+        case RSX_VP_COND_LE: return value <= 0.0f;
+        case RSX_VP_COND_GT: return value > 0.0f;
+        case RSX_VP_COND_NE: return value != 0.0f;
+        case RSX_VP_COND_GE: return value >= 0.0f;
+        default: return true;
+    }
+}
+
+void read_source(const RSXVertexInstruction& instr, uint32_t n, const LaneState& state, float out[4]) {
+    uint32_t src = instr.src(n);
+    float value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    switch (RSXVertexInstruction::src_reg_type(src)) {
+        case RSX_VP_REG_TEMP: {
+            uint32_t reg = RSXVertexInstruction::src_tmp(src);
+            if (reg < RSX_VP_TEMPS) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    value[c] = state.batch.temps[reg][c][state.lane];
+                }
+            }
+            break;
+        }
+        case RSX_VP_REG_INPUT: {
+            uint32_t reg = instr.input_src();
+            if (instr.index_input()) {
+                reg += state.address[instr.addr_reg_sel()][instr.addr_swizzle()];
+            }
+            if (reg < RSX_VP_INPUTS) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    value[c] = state.batch.inputs[reg][c][state.lane];
+                }
+            }
+            break;
+        }
+        case RSX_VP_REG_CONSTANT: {
+            int32_t index = static_cast<int32_t>(instr.const_src());
+            if (instr.index_const()) {
+                index += state.address[instr.addr_reg_sel()][instr.addr_swizzle()];
+            }
+            if (index >= 0 && static_cast<uint32_t>(index) < RSX_VP_MAX_CONSTANTS) {
+                std::memcpy(value, state.constants + index * 4, sizeof(value));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    for (uint32_t c = 0; c < 4; c++) {
+        float v = value[RSXVertexInstruction::src_swizzle(src, c)];
+        if (instr.src_abs(n)) {
+            v = std::fabs(v);
+        }
+        if (RSXVertexInstruction::src_neg(src)) {
+            v = -v;
+        }
+        out[c] = v;
+    }
+}
+
+void write_result(const RSXVertexInstruction& instr, LaneState& state, const float value[4],
+                  uint32_t mask, uint32_t temp, bool to_output, bool update_cc) {
+    for (uint32_t c = 0; c < 4; c++) {
+        if (!RSXVertexInstruction::mask_has(mask, c)) {
+            continue;
+        }
+        if (instr.cond_test_enable() &&
+            !test_condition(instr.cond(), state.cc[instr.cond_reg_sel()][instr.cond_swizzle(c)])) {
+            continue;
+        }
+
+        float v = instr.saturate() ? saturate(value[c]) : value[c];
+        if (temp < RSX_VP_TEMPS) {
+            state.batch.temps[temp][c][state.lane] = v;
+        }
+        if (to_output && instr.dst() < RSX_VP_OUTPUTS) {
+            state.batch.outputs[instr.dst()][c][state.lane] = v;
+        }
+        if (update_cc) {
+            state.cc[instr.cond_reg_sel()][c] = v;
+        }
+    }
+}
+
+void execute_vector(const RSXVertexInstruction& instr, const float a[4], const float b[4],
+                    const float c2[4], float r[4]) {
+    switch (instr.vec_opcode()) {
+        case RSX_VP_VEC_MOV:
+            for (int c = 0; c < 4; c++) r[c] = a[c];
+            break;
+        case RSX_VP_VEC_MUL:
+            for (int c = 0; c < 4; c++) r[c] = a[c] * b[c];
+            break;
+        case RSX_VP_VEC_ADD:
+            for (int c = 0; c < 4; c++) r[c] = a[c] + c2[c];
+            break;
+        case RSX_VP_VEC_MAD:
+            for (int c = 0; c < 4; c++) r[c] = a[c] * b[c] + c2[c];
+            break;
+        case RSX_VP_VEC_DP3: {
+            float dp = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+            for (int c = 0; c < 4; c++) r[c] = dp;
+            break;
+        }
+        case RSX_VP_VEC_DPH: {
+            float dp = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + b[3];
+            for (int c = 0; c < 4; c++) r[c] = dp;
+            break;
+        }
+        case RSX_VP_VEC_DP4: {
+            float dp = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+            for (int c = 0; c < 4; c++) r[c] = dp;
+            break;
+        }
+        case RSX_VP_VEC_DST:
+            r[0] = 1.0f;
+            r[1] = a[1] * b[1];
+            r[2] = a[2];
+            r[3] = b[3];
+            break;
+        case RSX_VP_VEC_MIN:
+            for (int c = 0; c < 4; c++) r[c] = min_ps(a[c], b[c]);
+            break;
+        case RSX_VP_VEC_MAX:
+            for (int c = 0; c < 4; c++) r[c] = max_ps(a[c], b[c]);
+            break;
+        case RSX_VP_VEC_SLT:
+            for (int c = 0; c < 4; c++) r[c] = a[c] < b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_SGE:
+            for (int c = 0; c < 4; c++) r[c] = a[c] >= b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_FRC:
+            for (int c = 0; c < 4; c++) r[c] = a[c] - std::floor(a[c]);
+            break;
+        case RSX_VP_VEC_FLR:
+            for (int c = 0; c < 4; c++) r[c] = std::floor(a[c]);
+            break;
+        case RSX_VP_VEC_SEQ:
+            for (int c = 0; c < 4; c++) r[c] = a[c] == b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_SFL:
+            for (int c = 0; c < 4; c++) r[c] = 0.0f;
+            break;
+        case RSX_VP_VEC_SGT:
+            for (int c = 0; c < 4; c++) r[c] = a[c] > b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_SLE:
+            for (int c = 0; c < 4; c++) r[c] = a[c] <= b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_SNE:
+            for (int c = 0; c < 4; c++) r[c] = a[c] != b[c] ? 1.0f : 0.0f;
+            break;
+        case RSX_VP_VEC_STR:
+            for (int c = 0; c < 4; c++) r[c] = 1.0f;
+            break;
+        case RSX_VP_VEC_SSG:
+            for (int c = 0; c < 4; c++) r[c] = a[c] > 0.0f ? 1.0f : (a[c] < 0.0f ? -1.0f : 0.0f);
+            break;
+        default:
+            // TXL: vertex texture fetch is not wired up yet
+            for (int c = 0; c < 4; c++) r[c] = 0.0f;
+            break;
+    }
+}
+
+void execute_scalar(uint32_t opcode, const float c2[4], float r[4]) {
+    float s = c2[0];
+    float value = 0.0f;
+
+    switch (opcode) {
+        case RSX_VP_SCA_MOV:
+            value = s;
+            break;
+        case RSX_VP_SCA_RCP:
+            value = 1.0f / s;
+            break;
+        case RSX_VP_SCA_RCC: {
+            value = 1.0f / s;
+            float magnitude = std::fabs(value);
+            magnitude = magnitude < 5.42101e-20f ? 5.42101e-20f : (magnitude > 1.884467e19f ? 1.884467e19f : magnitude);
+            value = std::copysign(magnitude, value);
+            break;
+        }
+        case RSX_VP_SCA_RSQ:
+            value = 1.0f / std::sqrt(std::fabs(s));
+            break;
+        case RSX_VP_SCA_EXP: {
+            float fl = std::floor(s);
+            r[0] = std::exp2(fl);
+            r[1] = s - fl;
+            r[2] = std::exp2(s);
+            r[3] = 1.0f;
+            return;
+        }
+        case RSX_VP_SCA_LOG: {
+            float magnitude = std::fabs(s);
+            float exponent = std::floor(std::log2(magnitude));
+            r[0] = exponent;
+            r[1] = magnitude / std::exp2(exponent);
+            r[2] = std::log2(magnitude);
+            r[3] = 1.0f;
+            return;
+        }
+        case RSX_VP_SCA_LIT: {
+            float power = c2[3] < -128.0f ? -128.0f : (c2[3] > 128.0f ? 128.0f : c2[3]);
+            r[0] = 1.0f;
+            r[1] = c2[0] > 0.0f ? c2[0] : 0.0f;
+            r[2] = c2[0] > 0.0f ? std::pow(c2[1] > 0.0f ? c2[1] : 0.0f, power) : 0.0f;
+            r[3] = 1.0f;
+            return;
+        }
+        case RSX_VP_SCA_LG2:
+            value = std::log2(s);
+            break;
+        case RSX_VP_SCA_EX2:
+            value = std::exp2(s);
+            break;
+        case RSX_VP_SCA_SIN:
+            value = std::sin(s);
+            break;
+        case RSX_VP_SCA_COS:
+            value = std::cos(s);
+            break;
+        default:
+            break;
+    }
+
+    for (int c = 0; c < 4; c++) r[c] = value;
+}
+
+bool is_flow_control(uint32_t opcode) {
+    switch (opcode) {
+        case RSX_VP_SCA_BRA: case RSX_VP_SCA_BRI: case RSX_VP_SCA_CAL: case RSX_VP_SCA_CLI:
+        case RSX_VP_SCA_RET: case RSX_VP_SCA_BRB: case RSX_VP_SCA_CLB:
+        case RSX_VP_SCA_PSH: case RSX_VP_SCA_POP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+void RSXVertexProgramInterpreter::execute(const RSXVertexProgram& program, RSXVertexBatch& batch,
+                                          const float* constants, uint32_t branch_bits, uint32_t lanes) {
+    const size_t count = program.instructions.size();
+
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        LaneState state{ batch, constants, lane, {}, {} };
+        uint32_t call_stack[RSX_VP_CALL_DEPTH];
+        uint32_t call_depth = 0;
+        size_t pc = 0;
+
+        for (uint32_t steps = 0; pc < count && steps < RSX_VP_MAX_STEPS; steps++) {
+            const RSXVertexInstruction& instr = program.instructions[pc];
+            size_t next = pc + 1;
+
+            // Co-issued ops read all sources before either writes
+            float a[4], b[4], c2[4];
+            read_source(instr, 0, state, a);
+            read_source(instr, 1, state, b);
+            read_source(instr, 2, state, c2);
+
+            uint32_t vec_op = instr.vec_opcode();
+            uint32_t sca_op = instr.sca_opcode();
+
+            float vec_result[4] = {};
+            float sca_result[4] = {};
+            if (vec_op != RSX_VP_VEC_NOP && vec_op != RSX_VP_VEC_ARL) {
+                execute_vector(instr, a, b, c2, vec_result);
+            }
+            if (sca_op != RSX_VP_SCA_NOP && !is_flow_control(sca_op)) {
+                execute_scalar(sca_op, c2, sca_result);
+            }
+
+            if (vec_op == RSX_VP_VEC_ARL) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    if (RSXVertexInstruction::mask_has(instr.vec_mask(), c)) {
+                        state.address[instr.addr_reg_sel()][c] = static_cast<int32_t>(std::floor(a[c]));
+                    }
+                }
+            } else if (vec_op != RSX_VP_VEC_NOP) {
+                write_result(instr, state, vec_result, instr.vec_mask(), instr.dst_tmp(),
+                             instr.vec_result(), instr.cond_update_vector());
+            }
+
+            if (sca_op != RSX_VP_SCA_NOP && !is_flow_control(sca_op)) {
+                uint32_t temp = instr.sca_dst_tmp();
+                write_result(instr, state, sca_result, instr.sca_mask(), temp,
+                             temp == RSX_VP_NO_TEMP && instr.dst() != RSX_VP_NO_OUTPUT,
+                             instr.cond_update_scalar());
+            }
+
+            // Branch targets are absolute program memory slots
+            bool cond_pass = test_condition(instr.cond(), state.cc[instr.cond_reg_sel()][instr.cond_swizzle(0)]);
+            bool bool_pass = (((branch_bits >> instr.branch_index()) & 1) != 0) == instr.branch_if_true();
+            uint32_t target_slot = instr.branch_target();
+            size_t target = target_slot >= program.base_address ? target_slot - program.base_address : count;
+
+            switch (sca_op) {
+                case RSX_VP_SCA_BRI:
+                    if (cond_pass) next = target;
+                    break;
+                case RSX_VP_SCA_BRB:
+                    if (bool_pass) next = target;
+                    break;
+                case RSX_VP_SCA_CAL:
+                case RSX_VP_SCA_CLI:
+                case RSX_VP_SCA_CLB: {
+                    bool taken = sca_op == RSX_VP_SCA_CLB ? bool_pass : (sca_op == RSX_VP_SCA_CAL || cond_pass);
+                    if (taken && call_depth < RSX_VP_CALL_DEPTH) {
+                        call_stack[call_depth++] = static_cast<uint32_t>(next);
+                        next = target;
+                    }
+                    break;
+                }
+                case RSX_VP_SCA_RET:
+                    if (call_depth == 0) {
+                        next = count;
+                    } else {
+                        next = call_stack[--call_depth];
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            if (instr.end() && next == pc + 1) {
+                break;
+            }
+            pc = next;
+        }
+    }
+}
+
+// JIT compiler
+
+namespace {
+
+using Core::X64Emitter;
+using Core::X64Reg;
+
+constexpr int32_t BATCH_PLANE_SIZE = RSX_VP_BATCH_SIZE * sizeof(float);
+
+constexpr int32_t input_offset(uint32_t reg, uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXVertexBatch, inputs) + (reg * 4 + c) * BATCH_PLANE_SIZE);
+}
+constexpr int32_t temp_offset(uint32_t reg, uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXVertexBatch, temps) + (reg * 4 + c) * BATCH_PLANE_SIZE);
+}
+constexpr int32_t output_offset(uint32_t reg, uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXVertexBatch, outputs) + (reg * 4 + c) * BATCH_PLANE_SIZE);
+}
+constexpr int32_t scratch_offset(uint32_t c) {
+    return static_cast<int32_t>(offsetof(RSXVertexBatch, scratch) + c * BATCH_PLANE_SIZE);
+}
+
+enum Literal : uint32_t { LIT_SIGN = 0, LIT_ABS = 1, LIT_ONE = 2, LIT_ZERO = 3 };
+
+constexpr int32_t literal_offset(Literal literal) {
+    return static_cast<int32_t>(offsetof(RSXVertexBatch, literals) + literal * BATCH_PLANE_SIZE);
+}
+
+// ymm0-2 sources, ymm3 result, ymm4 scratch, ymm5 scalar result.
+// All are volatile on both SysV and Win64, so no prologue is needed.
+enum JitRegister : int { Y_SRC0 = 0, Y_SRC1 = 1, Y_SRC2 = 2, Y_RESULT = 3, Y_TMP = 4, Y_SCALAR = 5 };
+
+class VertexProgramEmitter {
+public:
+    VertexProgramEmitter()
+        : batch(X64Emitter::arg_reg(0))
+        , constants(X64Emitter::arg_reg(1)) {}
+
+    void emit_instruction(const RSXVertexInstruction& instr);
+    void finish() {
+        e.vzeroupper();
+        e.ret();
+    }
+    const std::vector<uint8_t>& get_code() const { return e.get_code(); }
+
+private:
+    X64Emitter e;
+    X64Reg batch;
+    X64Reg constants;
+
+    void load_source(int reg, const RSXVertexInstruction& instr, uint32_t n, uint32_t component);
+    void load_literal(int reg, Literal literal) { e.vmovups_load(reg, batch, literal_offset(literal)); }
+    void emit_vector_component(const RSXVertexInstruction& instr, uint32_t c);
+    void emit_dot(const RSXVertexInstruction& instr);
+    void store_result(const RSXVertexInstruction& instr, int reg, uint32_t c, uint32_t temp, bool to_output);
+};
+
+void VertexProgramEmitter::load_source(int reg, const RSXVertexInstruction& instr, uint32_t n, uint32_t component) {
+    uint32_t src = instr.src(n);
+    uint32_t swizzled = RSXVertexInstruction::src_swizzle(src, component);
+
+    switch (RSXVertexInstruction::src_reg_type(src)) {
+        case RSX_VP_REG_TEMP:
+            e.vmovups_load(reg, batch, temp_offset(RSXVertexInstruction::src_tmp(src), swizzled));
+            break;
+        case RSX_VP_REG_INPUT:
+            e.vmovups_load(reg, batch, input_offset(instr.input_src(), swizzled));
+            break;
+        case RSX_VP_REG_CONSTANT:
+            e.vbroadcastss(reg, constants, static_cast<int32_t>((instr.const_src() * 4 + swizzled) * sizeof(float)));
+            break;
+        default:
+            e.vxorps(reg, reg, reg);
+            break;
+    }
+
+    if (instr.src_abs(n)) {
+        e.vandps(reg, reg, batch, literal_offset(LIT_ABS));
+    }
+    if (RSXVertexInstruction::src_neg(src)) {
+        e.vxorps(reg, reg, batch, literal_offset(LIT_SIGN));
+    }
+}
+
+void VertexProgramEmitter::store_result(const RSXVertexInstruction& instr, int reg, uint32_t c,
+                                        uint32_t temp, bool to_output) {
+    if (temp < RSX_VP_TEMPS) {
+        e.vmovups_store(batch, temp_offset(temp, c), reg);
+    }
+    if (to_output && instr.dst() < RSX_VP_OUTPUTS) {
+        e.vmovups_store(batch, output_offset(instr.dst(), c), reg);
+    }
+}
+
+void VertexProgramEmitter::emit_dot(const RSXVertexInstruction& instr) {
+    uint32_t terms = instr.vec_opcode() == RSX_VP_VEC_DP4 ? 4 : 3;
+    for (uint32_t k = 0; k < terms; k++) {
+        load_source(Y_SRC0, instr, 0, k);
+        load_source(Y_SRC1, instr, 1, k);
+        if (k == 0) {
+            e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+        } else {
+            e.vmulps(Y_SRC0, Y_SRC0, Y_SRC1);
+            e.vaddps(Y_RESULT, Y_RESULT, Y_SRC0);
+        }
+    }
+    if (instr.vec_opcode() == RSX_VP_VEC_DPH) {
+        load_source(Y_SRC1, instr, 1, 3);
+        e.vaddps(Y_RESULT, Y_RESULT, Y_SRC1);
+    }
+}
+
+void VertexProgramEmitter::emit_vector_component(const RSXVertexInstruction& instr, uint32_t c) {
+    auto compare = [&](uint8_t predicate) {
+        load_source(Y_SRC0, instr, 0, c);
+        load_source(Y_SRC1, instr, 1, c);
+        e.vcmpps(Y_RESULT, Y_SRC0, Y_SRC1, predicate);
+        e.vandps(Y_RESULT, Y_RESULT, batch, literal_offset(LIT_ONE));
+    };
+
+    switch (instr.vec_opcode()) {
+        case RSX_VP_VEC_MOV:
+            load_source(Y_RESULT, instr, 0, c);
+            break;
+        case RSX_VP_VEC_MUL:
+            load_source(Y_SRC0, instr, 0, c);
+            load_source(Y_SRC1, instr, 1, c);
+            e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_VP_VEC_ADD:
+            load_source(Y_SRC0, instr, 0, c);
+            load_source(Y_SRC2, instr, 2, c);
+            e.vaddps(Y_RESULT, Y_SRC0, Y_SRC2);
+            break;
+        case RSX_VP_VEC_MAD:
+            load_source(Y_SRC0, instr, 0, c);
+            load_source(Y_SRC1, instr, 1, c);
+            load_source(Y_SRC2, instr, 2, c);
+            e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            e.vaddps(Y_RESULT, Y_RESULT, Y_SRC2);
+            break;
+        case RSX_VP_VEC_DST:
+            if (c == 0) {
+                load_literal(Y_RESULT, LIT_ONE);
+            } else if (c == 1) {
+                load_source(Y_SRC0, instr, 0, 1);
+                load_source(Y_SRC1, instr, 1, 1);
+                e.vmulps(Y_RESULT, Y_SRC0, Y_SRC1);
+            } else if (c == 2) {
+                load_source(Y_RESULT, instr, 0, 2);
+            } else {
+                load_source(Y_RESULT, instr, 1, 3);
+            }
+            break;
+        case RSX_VP_VEC_MIN:
+            load_source(Y_SRC0, instr, 0, c);
+            load_source(Y_SRC1, instr, 1, c);
+            e.vminps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_VP_VEC_MAX:
+            load_source(Y_SRC0, instr, 0, c);
+            load_source(Y_SRC1, instr, 1, c);
+            e.vmaxps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_VP_VEC_SLT: compare(Core::X64_CMP_LT_OQ); break;
+        case RSX_VP_VEC_SGE: compare(Core::X64_CMP_GE_OQ); break;
+        case RSX_VP_VEC_SEQ: compare(Core::X64_CMP_EQ_OQ); break;
+        case RSX_VP_VEC_SGT: compare(Core::X64_CMP_GT_OQ); break;
+        case RSX_VP_VEC_SLE: compare(Core::X64_CMP_LE_OQ); break;
+        case RSX_VP_VEC_SNE: compare(Core::X64_CMP_NEQ_UQ); break;
+        case RSX_VP_VEC_SFL:
+            e.vxorps(Y_RESULT, Y_RESULT, Y_RESULT);
+            break;
+        case RSX_VP_VEC_STR:
+            load_literal(Y_RESULT, LIT_ONE);
+            break;
+        case RSX_VP_VEC_FRC:
+            load_source(Y_SRC0, instr, 0, c);
+            e.vroundps(Y_SRC1, Y_SRC0, Core::X64_ROUND_FLOOR);
+            e.vsubps(Y_RESULT, Y_SRC0, Y_SRC1);
+            break;
+        case RSX_VP_VEC_FLR:
+            load_source(Y_SRC0, instr, 0, c);
+            e.vroundps(Y_RESULT, Y_SRC0, Core::X64_ROUND_FLOOR);
+            break;
+        default:
+            break;
+    }
+}
+
+bool is_dot_product(uint32_t opcode) {
+    return opcode == RSX_VP_VEC_DP3 || opcode == RSX_VP_VEC_DPH || opcode == RSX_VP_VEC_DP4;
+}
+
+void VertexProgramEmitter::emit_instruction(const RSXVertexInstruction& instr) {
+    uint32_t vec_op = instr.vec_opcode();
+    uint32_t sca_op = instr.sca_opcode();
+
+    // Scalar result first, into a register, so vector writes cannot clobber its source
+    if (sca_op != RSX_VP_SCA_NOP) {
+        load_source(Y_SCALAR, instr, 2, 0);
+        switch (sca_op) {
+            case RSX_VP_SCA_RCP:
+                load_literal(Y_TMP, LIT_ONE);
+                e.vdivps(Y_SCALAR, Y_TMP, Y_SCALAR);
+                break;
+            case RSX_VP_SCA_RSQ:
+                e.vandps(Y_SCALAR, Y_SCALAR, batch, literal_offset(LIT_ABS));
+                e.vsqrtps(Y_SCALAR, Y_SCALAR);
+                load_literal(Y_TMP, LIT_ONE);
+                e.vdivps(Y_SCALAR, Y_TMP, Y_SCALAR);
+                break;
+            default:
+                break;
+        }
+        if (instr.saturate()) {
+            e.vmaxps(Y_SCALAR, Y_SCALAR, batch, literal_offset(LIT_ZERO));
+            e.vminps(Y_SCALAR, Y_SCALAR, batch, literal_offset(LIT_ONE));
+        }
+    }
+
+    if (vec_op != RSX_VP_VEC_NOP) {
+        uint32_t mask = instr.vec_mask();
+        uint32_t temp = instr.dst_tmp();
+
+        // Stage through scratch when the destination is also a source, so a
+        // swizzle such as R0.xy = R0.yx reads the old value for every component
+        bool staged = false;
+        if (temp < RSX_VP_TEMPS) {
+            for (uint32_t n = 0; n < 3; n++) {
+                uint32_t src = instr.src(n);
+                if (RSXVertexInstruction::src_reg_type(src) == RSX_VP_REG_TEMP &&
+                    RSXVertexInstruction::src_tmp(src) == temp) {
+                    staged = true;
+                }
+            }
+        }
+
+        bool dot = is_dot_product(vec_op);
+        if (dot) {
+            emit_dot(instr);
+            if (instr.saturate()) {
+                e.vmaxps(Y_RESULT, Y_RESULT, batch, literal_offset(LIT_ZERO));
+                e.vminps(Y_RESULT, Y_RESULT, batch, literal_offset(LIT_ONE));
+            }
+        }
+
+        for (uint32_t c = 0; c < 4; c++) {
+            if (!RSXVertexInstruction::mask_has(mask, c)) {
+                continue;
+            }
+            if (!dot) {
+                emit_vector_component(instr, c);
+                if (instr.saturate()) {
+                    e.vmaxps(Y_RESULT, Y_RESULT, batch, literal_offset(LIT_ZERO));
+                    e.vminps(Y_RESULT, Y_RESULT, batch, literal_offset(LIT_ONE));
+                }
+            }
+            if (staged && !dot) {
+                e.vmovups_store(batch, scratch_offset(c), Y_RESULT);
+            } else {
+                store_result(instr, Y_RESULT, c, temp, instr.vec_result());
+            }
+        }
+
+        if (staged && !dot) {
+            for (uint32_t c = 0; c < 4; c++) {
+                if (RSXVertexInstruction::mask_has(mask, c)) {
+                    e.vmovups_load(Y_RESULT, batch, scratch_offset(c));
+                    store_result(instr, Y_RESULT, c, temp, instr.vec_result());
+                }
+            }
+        }
+    }
+
+    if (sca_op != RSX_VP_SCA_NOP) {
+        uint32_t temp = instr.sca_dst_tmp();
+        bool to_output = temp == RSX_VP_NO_TEMP && instr.dst() != RSX_VP_NO_OUTPUT;
+        for (uint32_t c = 0; c < 4; c++) {
+            if (RSXVertexInstruction::mask_has(instr.sca_mask(), c)) {
+                store_result(instr, Y_SCALAR, c, temp, to_output);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool RSXVertexProgramCompiler::can_compile(const RSXVertexProgram& program) {
+    for (const RSXVertexInstruction& instr : program.instructions) {
+        if (instr.cond_test_enable() || instr.cond_update_vector() || instr.cond_update_scalar() ||
+            instr.index_const() || instr.index_input()) {
+            return false;
+        }
+
+        switch (instr.vec_opcode()) {
+            case RSX_VP_VEC_ARL:
+            case RSX_VP_VEC_SSG:
+            case RSX_VP_VEC_TXL:
+                return false;
+            default:
+                if (instr.vec_opcode() > RSX_VP_VEC_STR) {
+                    return false;
+                }
+                break;
+        }
+
+        switch (instr.sca_opcode()) {
+            case RSX_VP_SCA_NOP:
+            case RSX_VP_SCA_MOV:
+            case RSX_VP_SCA_RCP:
+            case RSX_VP_SCA_RSQ:
+                break;
+            default:
+                return false;
+        }
+
+        // Out-of-range registers have interpreter-defined behaviour only
+        for (uint32_t n = 0; n < 3; n++) {
+            uint32_t src = instr.src(n);
+            if (RSXVertexInstruction::src_reg_type(src) == RSX_VP_REG_TEMP &&
+                RSXVertexInstruction::src_tmp(src) >= RSX_VP_TEMPS) {
+                return false;
+            }
+            if (RSXVertexInstruction::src_reg_type(src) == RSX_VP_REG_CONSTANT &&
+                instr.const_src() >= RSX_VP_MAX_CONSTANTS) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool RSXVertexProgramCompiler::compile(RSXVertexProgram& program) {
+    if (!can_compile(program)) {
+        return false;
+    }
+
+    VertexProgramEmitter emitter;
+    for (const RSXVertexInstruction& instr : program.instructions) {
+        emitter.emit_instruction(instr);
+        if (instr.end()) {
+            break;
+        }
+    }
+    emitter.finish();
+
+    if (!program.jit_code.assign(emitter.get_code())) {
+        return false;
+    }
+    program.jit_entry = program.jit_code.as<RSXVertexProgram::JitEntry>();
+    return true;
+}
+
+// RSXVertexProgramCache Implementation
+
+RSXVertexProgramCache::RSXVertexProgramCache()
+    : disk_cache(nullptr)
+    , jit_available(Core::get_host_cpu_features().avx2)
+    , jit_enabled(Core::get_host_cpu_features().avx2)
+    , hits(0)
+    , misses(0) {
+}
+
+void RSXVertexProgramCache::set_jit_enabled(bool enabled) {
+    jit_enabled = enabled && jit_available;
+}
+
+void RSXVertexProgramCache::clear() {
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    programs.clear();
+}
+
+size_t RSXVertexProgramCache::size() const {
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    return programs.size();
+}
+
+const RSXVertexProgram* RSXVertexProgramCache::get(const uint32_t* program_memory, uint32_t base_address) {
+    if (base_address >= RSX_VP_MAX_INSTRUCTIONS) {
+        return nullptr;
+    }
+
+    // Length: up to the end bit, extended over any branch target past it
+    uint32_t length = 0;
+    uint32_t last_target = base_address;
+    for (uint32_t slot = base_address; slot < RSX_VP_MAX_INSTRUCTIONS; slot++) {
+        const uint32_t* words = program_memory + slot * 4;
+        RSXVertexInstruction instr{ words[0], words[1], words[2], words[3] };
+        length++;
+
+        uint32_t op = instr.sca_opcode();
+        if (op == RSX_VP_SCA_BRI || op == RSX_VP_SCA_CAL || op == RSX_VP_SCA_CLI ||
+            op == RSX_VP_SCA_BRB || op == RSX_VP_SCA_CLB) {
+            last_target = std::max(last_target, instr.branch_target());
+        }
+        if (instr.end() && slot >= last_target) {
+            break;
+        }
+    }
+
+    return lookup(program_memory + base_address * 4, length, base_address, true);
+}
+
+bool RSXVertexProgramCache::preload(const uint32_t* words, uint32_t length, uint32_t base_address) {
+    if (length == 0 || base_address >= RSX_VP_MAX_INSTRUCTIONS || length > RSX_VP_MAX_INSTRUCTIONS - base_address) {
+        return false;
+    }
+    return lookup(words, length, base_address, false) != nullptr;
+}
+
+const RSXVertexProgram* RSXVertexProgramCache::lookup(const uint32_t* words, uint32_t length,
+                                                      uint32_t base_address, bool from_draw) {
+    uint64_t hash = rsx_hash_words(words, length * 4, rsx_hash_words(&base_address, 1));
+
+    auto matches = [&](const RSXVertexProgram& program) {
+        return program.base_address == base_address && program.instructions.size() == length &&
+               std::memcmp(program.instructions.data(), words, length * 16) == 0;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(programs_mutex);
+        auto it = programs.find(hash);
+        if (it != programs.end() && matches(*it->second)) {
+            if (from_draw) {
+                hits++;
+            }
+            return it->second.get();
+        }
+    }
+
+    // Decode and compile outside the lock so warm-up workers run in parallel
+    auto program = std::make_unique<RSXVertexProgram>();
+    program->hash = hash;
+    program->base_address = base_address;
+    program->instructions.resize(length);
+    std::memcpy(program->instructions.data(), words, length * 16);
+
+    if (jit_available) {
+        RSXVertexProgramCompiler::compile(*program);
+    }
+
+    if (from_draw) {
+        misses++;
+        if (disk_cache) {
+            disk_cache->store_vertex_program(hash, base_address, words, length * 4);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(programs_mutex);
+    std::unique_ptr<RSXVertexProgram>& entry = programs[hash];
+    if (entry && matches(*entry)) {
+        return entry.get();  // Built concurrently by another thread
+    }
+    if (entry && !from_draw) {
+        return nullptr;      // Hash collision: keep the program in use
+    }
+    entry = std::move(program);
+    return entry.get();
+}
+
+void RSXVertexProgramCache::execute(const RSXVertexProgram& program, RSXVertexBatch& batch,
+                                    const float* constants, uint32_t branch_bits, uint32_t lanes) const {
+    if (jit_enabled && program.jit_entry) {
+        program.jit_entry(&batch, constants);
+    } else {
+        RSXVertexProgramInterpreter::execute(program, batch, constants, branch_bits, lanes);
+    }
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
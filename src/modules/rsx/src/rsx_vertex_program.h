@@ -0,0 +1,258 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX Vertex Program Header
+ *
+ * NV40 vertex program microcode: decoding, a reference interpreter and
+ * an AVX2 JIT that runs one instruction across 8 vertices at a time.
+ */
+
+#ifndef GSCX_MODULES_RSX_VERTEX_PROGRAM_H
+#define GSCX_MODULES_RSX_VERTEX_PROGRAM_H
+
+#include "../../../core/include/exec_memory.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+class RSXShaderDiskCache;
+
+// Vertex program limits
+static constexpr uint32_t RSX_VP_MAX_INSTRUCTIONS = 512;
+static constexpr uint32_t RSX_VP_MAX_CONSTANTS = 468;
+static constexpr uint32_t RSX_VP_INPUTS = 16;
+static constexpr uint32_t RSX_VP_OUTPUTS = 16;
+static constexpr uint32_t RSX_VP_TEMPS = 32;
+static constexpr uint32_t RSX_VP_BATCH_SIZE = 8;
+
+/**
+ * RSX Vertex Batch
+ *
+ * Register file for 8 vertices in SoA layout: [register][component][lane].
+ * Shared by the interpreter and the JIT so both run on the same data.
+ */
+struct alignas(32) RSXVertexBatch {
+    float inputs[RSX_VP_INPUTS][4][RSX_VP_BATCH_SIZE];
+    float temps[RSX_VP_TEMPS][4][RSX_VP_BATCH_SIZE];
+    float outputs[RSX_VP_OUTPUTS][4][RSX_VP_BATCH_SIZE];
+    float scratch[4][RSX_VP_BATCH_SIZE];   // JIT staging for aliased writes
+    float literals[4][RSX_VP_BATCH_SIZE];  // Sign mask, abs mask, 1.0, 0.0
+
+    RSXVertexBatch();
+};
+
+/**
+ * RSX Vertex Instruction
+ *
+ * One 128-bit microcode instruction with field accessors. Every
+ * instruction co-issues a vector op and a scalar op.
+ */
+struct RSXVertexInstruction {
+    uint32_t d0, d1, d2, d3;
+
+    // D0
+    uint32_t cond_swizzle(uint32_t c) const { return (d0 >> (8 - 2 * c)) & 0x3; }
+    uint32_t addr_swizzle() const { return d0 & 0x3; }
+    uint32_t cond() const { return (d0 >> 10) & 0x7; }
+    bool cond_test_enable() const { return (d0 >> 13) & 1; }
+    bool cond_update_vector() const { return (d0 >> 14) & 1; }
+    uint32_t dst_tmp() const { return (d0 >> 15) & 0x3F; }
+    bool src_abs(uint32_t n) const { return (d0 >> (21 + n)) & 1; }
+    uint32_t addr_reg_sel() const { return (d0 >> 24) & 1; }
+    uint32_t cond_reg_sel() const { return (d0 >> 25) & 1; }
+    bool saturate() const { return (d0 >> 26) & 1; }
+    bool index_input() const { return (d0 >> 27) & 1; }
+    bool cond_update_scalar() const { return (d0 >> 29) & 1; }
+    bool vec_result() const { return (d0 >> 30) & 1; }
+
+    // D1
+    uint32_t input_src() const { return (d1 >> 8) & 0xF; }
+    uint32_t const_src() const { return (d1 >> 12) & 0x3FF; }
+    uint32_t vec_opcode() const { return (d1 >> 22) & 0x1F; }
+    uint32_t sca_opcode() const { return (d1 >> 27) & 0x1F; }
+
+    // D3
+    bool end() const { return d3 & 1; }
+    bool index_const() const { return (d3 >> 1) & 1; }
+    uint32_t dst() const { return (d3 >> 2) & 0x1F; }
+    uint32_t sca_dst_tmp() const { return (d3 >> 7) & 0x3F; }
+    uint32_t vec_mask() const { return (d3 >> 13) & 0xF; }  // bit 3 = x ... bit 0 = w
+    uint32_t sca_mask() const { return (d3 >> 17) & 0xF; }
+    uint32_t branch_index() const { return (d3 >> 23) & 0x1F; }
+    bool branch_if_true() const { return (d3 >> 28) & 1; }
+    uint32_t branch_target() const { return ((d2 & 0x3F) << 3) | (d3 >> 29); }
+
+    // 17-bit source operands
+    uint32_t src(uint32_t n) const {
+        switch (n) {
+            case 0: return ((d1 & 0xFF) << 9) | (d2 >> 23);
+            case 1: return (d2 >> 6) & 0x1FFFF;
+            default: return ((d2 & 0x3F) << 11) | (d3 >> 21);
+        }
+    }
+
+    static uint32_t src_reg_type(uint32_t src) { return src & 0x3; }
+    static uint32_t src_tmp(uint32_t src) { return (src >> 2) & 0x3F; }
+    static uint32_t src_swizzle(uint32_t src, uint32_t c) { return (src >> (14 - 2 * c)) & 0x3; }
+    static bool src_neg(uint32_t src) { return (src >> 16) & 1; }
+
+    // Write mask bit for component c (x = 0)
+    static bool mask_has(uint32_t mask, uint32_t c) { return (mask >> (3 - c)) & 1; }
+};
+
+// Source register types
+enum RSXVPRegisterType {
+    RSX_VP_REG_TEMP = 1,
+    RSX_VP_REG_INPUT = 2,
+    RSX_VP_REG_CONSTANT = 3
+};
+
+// Vector opcodes
+enum RSXVPVectorOpcode {
+    RSX_VP_VEC_NOP = 0x00,
+    RSX_VP_VEC_MOV = 0x01,
+    RSX_VP_VEC_MUL = 0x02,
+    RSX_VP_VEC_ADD = 0x03,
+    RSX_VP_VEC_MAD = 0x04,
+    RSX_VP_VEC_DP3 = 0x05,
+    RSX_VP_VEC_DPH = 0x06,
+    RSX_VP_VEC_DP4 = 0x07,
+    RSX_VP_VEC_DST = 0x08,
+    RSX_VP_VEC_MIN = 0x09,
+    RSX_VP_VEC_MAX = 0x0A,
+    RSX_VP_VEC_SLT = 0x0B,
+    RSX_VP_VEC_SGE = 0x0C,
+    RSX_VP_VEC_ARL = 0x0D,
+    RSX_VP_VEC_FRC = 0x0E,
+    RSX_VP_VEC_FLR = 0x0F,
+    RSX_VP_VEC_SEQ = 0x10,
+    RSX_VP_VEC_SFL = 0x11,
+    RSX_VP_VEC_SGT = 0x12,
+    RSX_VP_VEC_SLE = 0x13,
+    RSX_VP_VEC_SNE = 0x14,
+    RSX_VP_VEC_STR = 0x15,
+    RSX_VP_VEC_SSG = 0x16,
+    RSX_VP_VEC_TXL = 0x19
+};
+
+// Scalar opcodes
+enum RSXVPScalarOpcode {
+    RSX_VP_SCA_NOP = 0x00,
+    RSX_VP_SCA_MOV = 0x01,
+    RSX_VP_SCA_RCP = 0x02,
+    RSX_VP_SCA_RCC = 0x03,
+    RSX_VP_SCA_RSQ = 0x04,
+    RSX_VP_SCA_EXP = 0x05,
+    RSX_VP_SCA_LOG = 0x06,
+    RSX_VP_SCA_LIT = 0x07,
+    RSX_VP_SCA_BRA = 0x08,
+    RSX_VP_SCA_BRI = 0x09,
+    RSX_VP_SCA_CAL = 0x0A,
+    RSX_VP_SCA_CLI = 0x0B,
+    RSX_VP_SCA_RET = 0x0C,
+    RSX_VP_SCA_LG2 = 0x0D,
+    RSX_VP_SCA_EX2 = 0x0E,
+    RSX_VP_SCA_SIN = 0x0F,
+    RSX_VP_SCA_COS = 0x10,
+    RSX_VP_SCA_BRB = 0x11,
+    RSX_VP_SCA_CLB = 0x12,
+    RSX_VP_SCA_PSH = 0x13,
+    RSX_VP_SCA_POP = 0x14
+};
+
+/**
+ * RSX Vertex Program
+ *
+ * A decoded program plus its JIT code when the program is JIT-able.
+ */
+struct RSXVertexProgram {
+    using JitEntry = void (*)(RSXVertexBatch* batch, const float* constants);
+
+    uint64_t hash;
+    uint32_t base_address;  // Program memory slot of the first instruction
+    std::vector<RSXVertexInstruction> instructions;
+    Core::ExecutableBlock jit_code;
+    JitEntry jit_entry;
+
+    RSXVertexProgram() : hash(0), base_address(0), jit_entry(nullptr) {}
+};
+
+/**
+ * RSX Vertex Program Interpreter
+ *
+ * Reference implementation covering the full instruction set including
+ * flow control, condition codes and address-relative constants.
+ */
+class RSXVertexProgramInterpreter {
+public:
+    static void execute(const RSXVertexProgram& program, RSXVertexBatch& batch,
+                        const float* constants, uint32_t branch_bits, uint32_t lanes);
+};
+
+/**
+ * RSX Vertex Program JIT
+ *
+ * Compiles straight-line programs to AVX2 code over the SoA batch: one
+ * ymm register holds one component of 8 vertices, so swizzles and write
+ * masks cost nothing. Programs using flow control, condition codes,
+ * indexed addressing or transcendental ops stay on the interpreter.
+ */
+class RSXVertexProgramCompiler {
+public:
+    static bool can_compile(const RSXVertexProgram& program);
+    static bool compile(RSXVertexProgram& program);
+};
+
+/**
+ * RSX Vertex Program Cache
+ *
+ * Decoded (and compiled) programs keyed by microcode hash.
+ */
+class RSXVertexProgramCache {
+public:
+    RSXVertexProgramCache();
+
+    // Decode program memory from `base_address` up to the end bit (or the
+    // last branch target past it), returning the cached program
+    const RSXVertexProgram* get(const uint32_t* program_memory, uint32_t base_address);
+
+    // Build a program ahead of use (`length` instructions at `words`).
+    // Safe to call from worker threads while the RSX thread uses get().
+    bool preload(const uint32_t* words, uint32_t length, uint32_t base_address);
+
+    void execute(const RSXVertexProgram& program, RSXVertexBatch& batch,
+                 const float* constants, uint32_t branch_bits, uint32_t lanes) const;
+
+    void clear();
+    size_t size() const;
+    bool is_jit_enabled() const { return jit_enabled; }
+    void set_jit_enabled(bool enabled);
+
+    // Programs first seen by get() are reported here for persistence
+    void set_disk_cache(RSXShaderDiskCache* cache) { disk_cache = cache; }
+
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_misses() const { return misses; }
+
+private:
+    std::unordered_map<uint64_t, std::unique_ptr<RSXVertexProgram>> programs;
+    mutable std::mutex programs_mutex;
+    RSXShaderDiskCache* disk_cache;
+    bool jit_available;
+    bool jit_enabled;
+    uint64_t hits;
+    uint64_t misses;
+
+    const RSXVertexProgram* lookup(const uint32_t* words, uint32_t length, uint32_t base_address, bool from_draw);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_VERTEX_PROGRAM_H
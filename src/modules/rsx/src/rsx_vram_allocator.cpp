@@ -0,0 +1,256 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX VRAM Allocator Implementation
+ */
+
+#include "rsx_vram_allocator.h"
+#include <bit>
+#include <cstring>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+RSXVRAMAllocator::RSXVRAMAllocator()
+    : fl_bitmap(0)
+    , total_bytes(0)
+    , used_bytes(0)
+    , peak_used_bytes(0)
+    , free_block_count(0) {
+    std::memset(sl_bitmap, 0, sizeof(sl_bitmap));
+    std::memset(free_lists, 0, sizeof(free_lists));
+}
+
+void RSXVRAMAllocator::reset(uint64_t size) {
+    block_storage.clear();
+    spare_blocks.clear();
+    allocations.clear();
+    fl_bitmap = 0;
+    std::memset(sl_bitmap, 0, sizeof(sl_bitmap));
+    std::memset(free_lists, 0, sizeof(free_lists));
+
+    total_bytes = size & ~(RSX_VRAM_GRANULE - 1);
+    used_bytes = 0;
+    peak_used_bytes = 0;
+    free_block_count = 0;
+
+    if (total_bytes != 0) {
+        insert_free(new_block(0, total_bytes));
+    }
+}
+
+RSXVRAMAllocator::Block* RSXVRAMAllocator::new_block(uint64_t offset, uint64_t size) {
+    Block* block;
+    if (!spare_blocks.empty()) {
+        block = spare_blocks.back();
+        spare_blocks.pop_back();
+    } else {
+        block = &block_storage.emplace_back();
+    }
+    *block = Block{ offset, size, nullptr, nullptr, nullptr, nullptr, false };
+    return block;
+}
+
+void RSXVRAMAllocator::recycle_block(Block* block) {
+    spare_blocks.push_back(block);
+}
+
+void RSXVRAMAllocator::mapping_insert(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    uint64_t units = size / RSX_VRAM_GRANULE;
+    if (units < SL_COUNT) {
+        fl = 0;
+        sl = static_cast<uint32_t>(units);
+        return;
+    }
+    uint32_t msb = static_cast<uint32_t>(std::bit_width(units)) - 1;
+    fl = msb - SL_BITS + 1;
+    sl = static_cast<uint32_t>(units >> (msb - SL_BITS)) - SL_COUNT;
+}
+
+void RSXVRAMAllocator::mapping_search(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    // Round up to the next size class so any block found there fits
+    uint64_t units = size / RSX_VRAM_GRANULE;
+    if (units >= SL_COUNT) {
+        uint32_t msb = static_cast<uint32_t>(std::bit_width(units)) - 1;
+        units += (uint64_t(1) << (msb - SL_BITS)) - 1;
+    }
+    mapping_insert(units * RSX_VRAM_GRANULE, fl, sl);
+}
+
+RSXVRAMAllocator::Block* RSXVRAMAllocator::find_free_block(uint64_t size) {
+    uint32_t fl, sl;
+    mapping_search(size, fl, sl);
+    if (fl >= FL_COUNT) {
+        return nullptr;
+    }
+
+    uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint64_t fl_map = fl + 1 < 64 ? fl_bitmap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (!fl_map) {
+            return nullptr;
+        }
+        fl = static_cast<uint32_t>(std::countr_zero(fl_map));
+        sl_map = sl_bitmap[fl];
+    }
+    sl = static_cast<uint32_t>(std::countr_zero(sl_map));
+    return free_lists[fl][sl];
+}
+
+void RSXVRAMAllocator::insert_free(Block* block) {
+    uint32_t fl, sl;
+    mapping_insert(block->size, fl, sl);
+
+    block->free = true;
+    block->prev_free = nullptr;
+    block->next_free = free_lists[fl][sl];
+    if (block->next_free) {
+        block->next_free->prev_free = block;
+    }
+    free_lists[fl][sl] = block;
+    fl_bitmap |= uint64_t(1) << fl;
+    sl_bitmap[fl] |= 1u << sl;
+    free_block_count++;
+}
+
+void RSXVRAMAllocator::remove_free(Block* block) {
+    uint32_t fl, sl;
+    mapping_insert(block->size, fl, sl);
+
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        free_lists[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            sl_bitmap[fl] &= ~(1u << sl);
+            if (!sl_bitmap[fl]) {
+                fl_bitmap &= ~(uint64_t(1) << fl);
+            }
+        }
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    block->free = false;
+    block->prev_free = nullptr;
+    block->next_free = nullptr;
+    free_block_count--;
+}
+
+bool RSXVRAMAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& offset) {
+    if (size == 0 || size > total_bytes || (alignment & (alignment - 1)) != 0) {
+        return false;
+    }
+    size = (size + RSX_VRAM_GRANULE - 1) & ~(RSX_VRAM_GRANULE - 1);
+    alignment = alignment < RSX_VRAM_GRANULE ? RSX_VRAM_GRANULE : alignment;
+
+    // Over-ask by the worst-case padding so the aligned start always fits
+    uint64_t padding = alignment - RSX_VRAM_GRANULE;
+    Block* block = find_free_block(size + padding);
+    if (!block) {
+        return false;
+    }
+    remove_free(block);
+
+    // Split off the alignment gap as its own free block
+    uint64_t aligned = (block->offset + alignment - 1) & ~(alignment - 1);
+    if (aligned != block->offset) {
+        Block* gap = new_block(block->offset, aligned - block->offset);
+        gap->prev_phys = block->prev_phys;
+        gap->next_phys = block;
+        if (gap->prev_phys) {
+            gap->prev_phys->next_phys = gap;
+        }
+        block->prev_phys = gap;
+        block->offset = aligned;
+        block->size -= gap->size;
+        insert_free(gap);
+    }
+
+    // Return the unused tail
+    if (block->size > size) {
+        Block* tail = new_block(block->offset + size, block->size - size);
+        tail->prev_phys = block;
+        tail->next_phys = block->next_phys;
+        if (tail->next_phys) {
+            tail->next_phys->prev_phys = tail;
+        }
+        block->next_phys = tail;
+        block->size = size;
+        insert_free(tail);
+    }
+
+    allocations[block->offset] = block;
+    used_bytes += block->size;
+    peak_used_bytes = used_bytes > peak_used_bytes ? used_bytes : peak_used_bytes;
+    offset = block->offset;
+    return true;
+}
+
+bool RSXVRAMAllocator::free(uint64_t offset) {
+    auto it = allocations.find(offset);
+    if (it == allocations.end()) {
+        return false;
+    }
+    Block* block = it->second;
+    allocations.erase(it);
+    used_bytes -= block->size;
+
+    // Coalesce with free physical neighbours
+    if (block->prev_phys && block->prev_phys->free) {
+        Block* prev = block->prev_phys;
+        remove_free(prev);
+        prev->size += block->size;
+        prev->next_phys = block->next_phys;
+        if (prev->next_phys) {
+            prev->next_phys->prev_phys = prev;
+        }
+        recycle_block(block);
+        block = prev;
+    }
+    if (block->next_phys && block->next_phys->free) {
+        Block* next = block->next_phys;
+        remove_free(next);
+        block->size += next->size;
+        block->next_phys = next->next_phys;
+        if (block->next_phys) {
+            block->next_phys->prev_phys = block;
+        }
+        recycle_block(next);
+    }
+
+    insert_free(block);
+    return true;
+}
+
+uint64_t RSXVRAMAllocator::get_allocation_size(uint64_t offset) const {
+    auto it = allocations.find(offset);
+    return it != allocations.end() ? it->second->size : 0;
+}
+
+RSXVRAMStats RSXVRAMAllocator::get_stats() const {
+    RSXVRAMStats stats{};
+    stats.total_bytes = total_bytes;
+    stats.used_bytes = used_bytes;
+    stats.free_bytes = total_bytes - used_bytes;
+    stats.peak_used_bytes = peak_used_bytes;
+    stats.allocation_count = static_cast<uint32_t>(allocations.size());
+    stats.free_block_count = free_block_count;
+
+    // The largest free block sits in the highest non-empty bin
+    if (fl_bitmap) {
+        uint32_t fl = 63 - static_cast<uint32_t>(std::countl_zero(fl_bitmap));
+        uint32_t sl = 31 - static_cast<uint32_t>(std::countl_zero(sl_bitmap[fl]));
+        for (const Block* block = free_lists[fl][sl]; block; block = block->next_free) {
+            stats.largest_free_block = block->size > stats.largest_free_block ? block->size : stats.largest_free_block;
+        }
+    }
+    stats.fragmentation = stats.free_bytes != 0
+        ? 1.0f - static_cast<float>(stats.largest_free_block) / static_cast<float>(stats.free_bytes)
+        : 0.0f;
+    return stats;
+}
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
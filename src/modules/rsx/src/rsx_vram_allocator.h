@@ -0,0 +1,113 @@
+/**
+ * GSCX - PlayStation 3 High-Level Emulator
+ * RSX VRAM Allocator Header
+ *
+ * Two-level segregated fit (TLSF) allocator for RSX local memory:
+ * constant-time allocate/free with immediate coalescing and aligned
+ * placement.
+ */
+
+#ifndef GSCX_MODULES_RSX_VRAM_ALLOCATOR_H
+#define GSCX_MODULES_RSX_VRAM_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace GSCX {
+namespace Modules {
+namespace RSX {
+
+// Allocation unit: every block size and offset is a multiple of this
+static constexpr uint64_t RSX_VRAM_GRANULE = 64;
+
+/**
+ * RSX VRAM Statistics
+ *
+ * Maintained on every allocate/free; only the largest free block is
+ * resolved when queried.
+ */
+struct RSXVRAMStats {
+    uint64_t total_bytes;
+    uint64_t used_bytes;
+    uint64_t free_bytes;
+    uint64_t peak_used_bytes;
+    uint64_t largest_free_block;
+    uint32_t allocation_count;
+    uint32_t free_block_count;
+    float fragmentation;       // 1 - largest_free_block / free_bytes
+};
+
+/**
+ * RSX VRAM Allocator
+ *
+ * Free blocks are binned by size class: the first level splits by power
+ * of two, the second linearly into 32 ranges. Two bitmaps locate the
+ * first non-empty bin fitting a request with bit scans, so neither
+ * operation depends on the number of blocks. Block headers are kept out
+ * of band so VRAM pages are never touched by bookkeeping.
+ */
+class RSXVRAMAllocator {
+public:
+    RSXVRAMAllocator();
+
+    // Manage [0, size); returns offsets relative to the region start
+    void reset(uint64_t size);
+
+    // `alignment` must be a power of two; smaller than a granule is rounded up
+    bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+    bool free(uint64_t offset);
+
+    // Size of the live allocation at `offset`, 0 if none
+    uint64_t get_allocation_size(uint64_t offset) const;
+
+    uint64_t get_total() const { return total_bytes; }
+    uint64_t get_used() const { return used_bytes; }
+    uint64_t get_free() const { return total_bytes - used_bytes; }
+    RSXVRAMStats get_stats() const;
+
+private:
+    static constexpr uint32_t SL_BITS = 5;
+    static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+    static constexpr uint32_t FL_COUNT = 64 - SL_BITS;
+
+    struct Block {
+        uint64_t offset;
+        uint64_t size;
+        Block* prev_phys;
+        Block* next_phys;
+        Block* prev_free;
+        Block* next_free;
+        bool free;
+    };
+
+    std::deque<Block> block_storage;
+    std::vector<Block*> spare_blocks;
+    std::unordered_map<uint64_t, Block*> allocations;
+
+    uint64_t fl_bitmap;
+    uint32_t sl_bitmap[FL_COUNT];
+    Block* free_lists[FL_COUNT][SL_COUNT];
+
+    uint64_t total_bytes;
+    uint64_t used_bytes;
+    uint64_t peak_used_bytes;
+    uint32_t free_block_count;
+
+    Block* new_block(uint64_t offset, uint64_t size);
+    void recycle_block(Block* block);
+
+    static void mapping_insert(uint64_t size, uint32_t& fl, uint32_t& sl);
+    static void mapping_search(uint64_t size, uint32_t& fl, uint32_t& sl);
+    Block* find_free_block(uint64_t size);
+    void insert_free(Block* block);
+    void remove_free(Block* block);
+};
+
+} // namespace RSX
+} // namespace Modules
+} // namespace GSCX
+
+#endif // GSCX_MODULES_RSX_VRAM_ALLOCATOR_H
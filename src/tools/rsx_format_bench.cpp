@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../modules/rsx/src/rsx_surface_format.h"
+
+// Mede a vazão das conversões de formato de superfície (escalar contra o
+// melhor conjunto SIMD do host) e compara com memcpy, que é o teto prático.
+// Também confere que os kernels SIMD produzem os mesmos bytes que os escalares.
+// Uso: rsx_format_bench [largura altura] [repeticoes]
+
+using namespace GSCX::Modules::RSX;
+using Clock = std::chrono::steady_clock;
+
+struct NamedFormat {
+    uint32_t format;
+    const char* name;
+};
+
+static const NamedFormat FORMATS[] = {
+    { RSX_SURFACE_FORMAT_B8, "B8" },
+    { RSX_SURFACE_FORMAT_G8B8, "G8B8" },
+    { RSX_SURFACE_FORMAT_A8R8G8B8, "A8R8G8B8" },
+    { RSX_SURFACE_FORMAT_B8G8R8A8, "B8G8R8A8" },
+    { RSX_SURFACE_FORMAT_R5G6B5, "R5G6B5" },
+    { RSX_SURFACE_FORMAT_X8R8G8B8, "X8R8G8B8" },
+    { RSX_SURFACE_FORMAT_B8G8R8X8, "B8G8R8X8" },
+    { RSX_SURFACE_FORMAT_X1R5G5B5, "X1R5G5B5" },
+    { RSX_SURFACE_FORMAT_A1R5G5B5, "A1R5G5B5" },
+    { RSX_SURFACE_FORMAT_A4R4G4B4, "A4R4G4B4" },
+    { RSX_SURFACE_FORMAT_R32_FLOAT, "R32F" },
+    { RSX_SURFACE_FORMAT_R16_FLOAT, "R16F" },
+    { RSX_SURFACE_FORMAT_X8B8G8R8, "X8B8G8R8" },
+    { RSX_SURFACE_FORMAT_A8B8G8R8, "A8B8G8R8" },
+    { RSX_SURFACE_FORMAT_B8G8R8, "B8G8R8" },
+    { RSX_SURFACE_FORMAT_G8R8, "G8R8" },
+    { RSX_SURFACE_FORMAT_R8, "R8" },
+    { RSX_CANONICAL_FORMAT_RGBA8, "RGBA8" },
+    { RSX_CANONICAL_FORMAT_RGBA32F, "RGBA32F" },
+};
+
+static const char* isa_name(RSXSurfaceConvertISA isa) {
+    switch (isa) {
+        case RSXSurfaceConvertISA::AVX2: return "avx2";
+        case RSXSurfaceConvertISA::SSSE3: return "ssse3";
+        default: return "escalar";
+    }
+}
+
+// Entrada válida para o formato: floats finitos em [0, 1], bytes quaisquer
+static void fill_source(std::vector<uint8_t>& data, uint32_t format, std::mt19937& rng) {
+    if (format == RSX_CANONICAL_FORMAT_RGBA32F) {
+        std::uniform_real_distribution<float> dist(-0.25f, 1.25f);
+        for (size_t i = 0; i + 4 <= data.size(); i += 4) {
+            float value = dist(rng);
+            std::memcpy(&data[i], &value, sizeof(value));
+        }
+    } else if (format == RSX_SURFACE_FORMAT_R32_FLOAT) {
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (size_t i = 0; i + 4 <= data.size(); i += 4) {
+            uint32_t bits;
+            float value = dist(rng);
+            std::memcpy(&bits, &value, sizeof(bits));
+            rsx_store_surface_word(&data[i], bits, 4);
+        }
+    } else if (format == RSX_SURFACE_FORMAT_R16_FLOAT) {
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (size_t i = 0; i + 2 <= data.size(); i += 2) {
+            rsx_store_surface_word(&data[i], float_to_half(dist(rng)), 2);
+        }
+    } else {
+        for (uint8_t& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+}
+
+// Melhor tempo de `loops` passadas, em ms
+template <typename Fn>
+static double best_ms(int loops, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < loops; i++) {
+        auto t0 = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    if (argc >= 3) {
+        width = static_cast<uint32_t>(std::max(1, std::atoi(argv[1])));
+        height = static_cast<uint32_t>(std::max(1, std::atoi(argv[2])));
+    }
+    int loops = argc > 3 ? std::max(1, std::atoi(argv[3])) : 20;
+
+    RSXSurfaceConvertISA isa = rsx_get_surface_convert_isa();
+    size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> src(pixels * 16), dst(pixels * 16), check(pixels * 16);
+    std::mt19937 rng(1234);
+
+    double copy_ms = best_ms(loops, [&] { std::memcpy(dst.data(), src.data(), pixels * 4); });
+    double copy_gbs = pixels * 4 * 2 / (copy_ms * 1e6);
+    std::printf("%ux%u, %d repeticoes, kernels %s\n", width, height, loops, isa_name(isa));
+    std::printf("memcpy 32 bpp: %.3f ms, %.2f GB/s (leitura + escrita)\n\n", copy_ms, copy_gbs);
+    std::printf("%-10s %-10s %10s %10s %10s %8s\n", "origem", "destino", "escalar_ms", "simd_ms", "GB/s", "memcpy%");
+
+    int mismatches = 0;
+    for (const NamedFormat& from : FORMATS) {
+        for (const NamedFormat& to : FORMATS) {
+            // Só os pares que importam: tudo de/para os canônicos e BGRA de apresentação
+            bool canonical = from.format >= RSX_CANONICAL_FORMAT_RGBA8 || to.format >= RSX_CANONICAL_FORMAT_RGBA8;
+            if (from.format == to.format || (!canonical && to.format != RSX_SURFACE_FORMAT_B8G8R8A8)) {
+                continue;
+            }
+            uint32_t src_bpp = rsx_get_format_bytes_per_pixel(from.format);
+            uint32_t dst_bpp = rsx_get_format_bytes_per_pixel(to.format);
+            fill_source(src, from.format, rng);
+
+            RSXSurfaceConvertFn scalar = rsx_get_surface_converter(from.format, to.format, RSXSurfaceConvertISA::SCALAR);
+            RSXSurfaceConvertFn simd = rsx_get_surface_converter(from.format, to.format, isa);
+            double scalar_ms = best_ms(loops, [&] { scalar(src.data(), check.data(), static_cast<uint32_t>(pixels)); });
+            double simd_ms = best_ms(loops, [&] { simd(src.data(), dst.data(), static_cast<uint32_t>(pixels)); });
+
+            if (std::memcmp(check.data(), dst.data(), pixels * dst_bpp) != 0) {
+                std::printf("divergencia entre escalar e %s: %s -> %s\n", isa_name(isa), from.name, to.name);
+                mismatches++;
+            }
+            double gbs = pixels * (src_bpp + dst_bpp) / (simd_ms * 1e6);
+            std::printf("%-10s %-10s %10.3f %10.3f %10.2f %7.0f%%\n", from.name, to.name, scalar_ms, simd_ms,
+                        gbs, gbs * 100.0 / copy_gbs);
+        }
+    }
+
+    if (mismatches != 0) {
+        std::cerr << mismatches << " pares divergentes" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../modules/rsx/src/rsx_core.h"
+#include "../modules/rsx/src/rsx_capture.h"
+#include "virtual_memory.h"
+
+// Reproduz uma captura do RSX (RSXCore::start_capture) sem emulação de CPU,
+// na velocidade máxima, com tempos por classe de método e por frame.
+// Uso: rsx_replay captura.rsxc [repeticoes]
+
+using namespace GSCX;
+using namespace GSCX::Modules::RSX;
+using Clock = std::chrono::steady_clock;
+
+enum MethodClass {
+    CLASS_STATE,
+    CLASS_TRANSFORM_UPLOAD,
+    CLASS_RESOURCE,
+    CLASS_MEMORY,
+    CLASS_DRAW_ARRAYS,
+    CLASS_DRAW_ELEMENTS,
+    CLASS_PRESENT,
+    CLASS_COUNT
+};
+
+static const char* CLASS_NAMES[CLASS_COUNT] = {
+    "state", "transform_upload", "resource", "memory", "draw_arrays", "draw_elements", "present"
+};
+
+// Faixas de métodos que transportam palavras de programa/constantes
+static constexpr uint32_t METHOD_TRANSFORM_PROGRAM = 0x0B80;
+static constexpr uint32_t METHOD_TRANSFORM_CONSTANT = 0x1F00;
+static constexpr uint32_t METHOD_BATCH_BYTES = 32 * 4;
+
+// Semáforo do front end: sem a CPU, ninguém libera o que o RSX espera
+static constexpr uint32_t METHOD_SEMAPHORE_OFFSET = 0x0064;
+static constexpr uint32_t METHOD_SEMAPHORE_ACQUIRE = 0x0068;
+
+static MethodClass classify(const RSXCaptureEntry& entry) {
+    switch (entry.type) {
+        case RSXCaptureRecord::METHOD: {
+            uint32_t method = entry.args[0];
+            bool upload = (method >= METHOD_TRANSFORM_PROGRAM && method < METHOD_TRANSFORM_PROGRAM + METHOD_BATCH_BYTES) ||
+                          (method >= METHOD_TRANSFORM_CONSTANT && method < METHOD_TRANSFORM_CONSTANT + METHOD_BATCH_BYTES);
+            return upload ? CLASS_TRANSFORM_UPLOAD : CLASS_STATE;
+        }
+        case RSXCaptureRecord::MEMORY: return CLASS_MEMORY;
+        case RSXCaptureRecord::DRAW_ARRAYS: return CLASS_DRAW_ARRAYS;
+        case RSXCaptureRecord::DRAW_ELEMENTS: return CLASS_DRAW_ELEMENTS;
+        case RSXCaptureRecord::PRESENT: return CLASS_PRESENT;
+        default: return CLASS_RESOURCE;
+    }
+}
+
+struct Replayer {
+    RSXCore core;
+    Core::VirtualMemoryRegion main_memory;
+    uint64_t vram_base = 0;
+    uint64_t ioif_base = 0;
+    uint32_t semaphore_offset = 0;
+
+    bool setup(uint64_t vram, uint64_t ioif) {
+        vram_base = vram;
+        ioif_base = ioif;
+        if (!core.initialize(vram, ioif) || !main_memory.allocate(RSX_IO_SPACE_SIZE)) {
+            return false;
+        }
+        // Memória principal identidade em todo o espaço de IO
+        core.set_main_memory(main_memory.data(), main_memory.size());
+        return core.get_io_table().map(0, 0, RSX_IO_SPACE_SIZE);
+    }
+
+    void write_memory(uint64_t address, const std::vector<uint8_t>& data) {
+        uint64_t size = data.size();
+        if (size == 0) {
+            return;
+        }
+        uint64_t offset = address - vram_base;
+        if (address >= vram_base && offset + size <= UINT32_MAX &&
+            core.get_vram_ptr(static_cast<uint32_t>(offset + size - 1))) {
+            core.write_vram(static_cast<uint32_t>(offset), data.data(), static_cast<uint32_t>(size));
+        } else if (address >= ioif_base && address - ioif_base + size <= main_memory.size()) {
+            std::memcpy(main_memory.data() + (address - ioif_base), data.data(), size);
+        }
+    }
+
+    void apply(const RSXCaptureEntry& entry) {
+        switch (entry.type) {
+            case RSXCaptureRecord::METHOD:
+                if (entry.args[0] == METHOD_SEMAPHORE_OFFSET) {
+                    semaphore_offset = entry.args[1];
+                } else if (entry.args[0] == METHOD_SEMAPHORE_ACQUIRE) {
+                    // Faz o papel da PPU: o valor esperado já está escrito
+                    core.get_sync().write_label(semaphore_offset / RSX_LABEL_STRIDE, entry.args[1]);
+                }
+                core.execute_method(entry.args[0], entry.args[1]);
+                break;
+            case RSXCaptureRecord::DRAW_ARRAYS:
+                core.draw_arrays(entry.args[0], entry.args[1], entry.args[2]);
+                break;
+            case RSXCaptureRecord::DRAW_ELEMENTS:
+                core.draw_elements(entry.args[0], entry.args[1], entry.args[2], entry.get_u64(3));
+                break;
+            case RSXCaptureRecord::TEXTURE:
+                core.set_texture(entry.args[0], RSXCaptureReader::decode_texture(entry));
+                break;
+            case RSXCaptureRecord::VERTEX_ATTRIBUTE:
+                core.set_vertex_attribute(entry.args[0], RSXCaptureReader::decode_vertex_attribute(entry));
+                break;
+            case RSXCaptureRecord::RENDER_TARGET:
+                core.set_render_target(entry.args[0], RSXCaptureReader::decode_render_target(entry));
+                break;
+            case RSXCaptureRecord::VERTEX_PROGRAM:
+                core.set_vertex_program(RSXCaptureReader::decode_program(entry));
+                break;
+            case RSXCaptureRecord::FRAGMENT_PROGRAM:
+                core.set_fragment_program(RSXCaptureReader::decode_program(entry));
+                break;
+            case RSXCaptureRecord::MEMORY:
+                write_memory(entry.get_u64(0), entry.data);
+                break;
+            case RSXCaptureRecord::PRESENT:
+                core.wait_for_idle();
+                break;
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Uso: rsx_replay captura.rsxc [repeticoes]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    int loops = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+
+    RSXCaptureReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Captura inválida: " << path << std::endl;
+        return 1;
+    }
+    // Carrega tudo antes: a reprodução mede só o RSX, não o disco
+    std::vector<RSXCaptureEntry> entries;
+    RSXCaptureEntry entry;
+    while (reader.next(entry)) {
+        entries.push_back(entry);
+    }
+    if (reader.is_truncated()) {
+        std::cerr << "Aviso: captura truncada após " << entries.size() << " registros" << std::endl;
+    }
+
+    Replayer replayer;
+    if (!replayer.setup(reader.get_vram_base(), reader.get_ioif_base())) {
+        std::cerr << "Falha ao inicializar o RSX" << std::endl;
+        return 1;
+    }
+
+    uint64_t counts[CLASS_COUNT] = {};
+    double totals[CLASS_COUNT] = {};
+    std::vector<double> frame_ms;
+
+    auto start = Clock::now();
+    for (int loop = 0; loop < loops; loop++) {
+        auto frame_start = Clock::now();
+        for (const RSXCaptureEntry& record : entries) {
+            auto t0 = Clock::now();
+            replayer.apply(record);
+            auto t1 = Clock::now();
+            MethodClass cls = classify(record);
+            counts[cls]++;
+            totals[cls] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            if (record.type == RSXCaptureRecord::PRESENT) {
+                frame_ms.push_back(std::chrono::duration<double, std::milli>(t1 - frame_start).count());
+                frame_start = t1;
+            }
+        }
+    }
+    double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    replayer.core.shutdown();
+
+    std::printf("%s: %zu registros x %d, %.3f ms\n", path.c_str(), entries.size(), loops, wall_ms);
+    std::printf("%-18s %12s %12s %12s\n", "classe", "chamadas", "total_ms", "media_us");
+    for (int i = 0; i < CLASS_COUNT; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        std::printf("%-18s %12llu %12.3f %12.3f\n", CLASS_NAMES[i], static_cast<unsigned long long>(counts[i]),
+                    totals[i], totals[i] * 1000.0 / counts[i]);
+    }
+    if (!frame_ms.empty()) {
+        std::vector<double> sorted = frame_ms;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double ms : sorted) {
+            sum += ms;
+        }
+        std::printf("frames: %zu, media %.3f ms, mediana %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                    sorted.size(), sum / sorted.size(), sorted[sorted.size() / 2],
+                    sorted[std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * 0.99))], sorted.back());
+    }
+    std::printf("draw calls: %llu, triangulos: %llu\n",
+                static_cast<unsigned long long>(replayer.core.get_draw_calls()),
+                static_cast<unsigned long long>(replayer.core.get_triangles_rendered()));
+    return 0;
+}
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../src/modules/recovery/src/ee_engine.h"
+
+// Confere as instruções paralelas (MMI) do EE contra uma referência escalar,
+// no interpretador (execute_parallel) e no recompilador (emit_parallel).
+// Cada caso carrega operandos aleatórios e de borda em r1-r3, HI/LO e SA,
+// executa uma instrução com rs/rt/rd sorteados entre r0-r3 (logo muitas
+// vezes o mesmo registrador) e compara r1-r3, HI e LO com o esperado.
+// Uso: ee_mmi_test [casos por codificacao]
+
+using namespace gscx::recovery;
+
+namespace {
+
+union Quad {
+    uint64_t d[2];
+    uint32_t w[4];
+    uint16_t h[8];
+    uint8_t b[16];
+    int64_t sd[2];
+    int32_t sw[4];
+    int16_t sh[8];
+    int8_t sb[16];
+};
+
+// Operandos como a instrução os vê; rd chega com o valor anterior do registrador
+struct MMIState {
+    Quad rs, rt, rd, hi, lo;
+    uint32_t sa;
+};
+
+using Reference = void (*)(MMIState& s, uint32_t field);
+
+struct MMIOp {
+    const char* name;
+    uint32_t funct;
+    uint32_t field;     // bits 10-6: subfunção, formato do PMFHL ou deslocamento
+    Reference reference;
+    bool writes_rd;
+};
+
+int32_t sat32(int64_t v) { return static_cast<int32_t>(std::clamp<int64_t>(v, INT32_MIN, INT32_MAX)); }
+int16_t sat16(int32_t v) { return static_cast<int16_t>(std::clamp<int32_t>(v, INT16_MIN, INT16_MAX)); }
+int8_t sat8(int32_t v) { return static_cast<int8_t>(std::clamp<int32_t>(v, INT8_MIN, INT8_MAX)); }
+uint64_t sext32(uint32_t v) { return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))); }
+
+void div32(int32_t n, int32_t d, int32_t& q, int32_t& r) {
+    if (d == 0) {
+        q = n < 0 ? 1 : -1;
+        r = n;
+    } else if (n == INT32_MIN && d == -1) {
+        q = INT32_MIN;
+        r = 0;
+    } else {
+        q = n / d;
+        r = n % d;
+    }
+}
+
+// Produto 32x32 em HI:LO por palavra par, opcionalmente acumulado
+void multiply_words(MMIState& s, bool is_signed, int accumulate) {
+    for (int i = 0; i < 2; i++) {
+        uint64_t p = is_signed ? static_cast<uint64_t>(static_cast<int64_t>(s.rs.sw[2 * i]) * s.rt.sw[2 * i])
+                               : static_cast<uint64_t>(s.rs.w[2 * i]) * s.rt.w[2 * i];
+        uint64_t acc = (static_cast<uint64_t>(s.hi.w[2 * i]) << 32) | s.lo.w[2 * i];
+        if (accumulate > 0) {
+            p = acc + p;
+        } else if (accumulate < 0) {
+            p = acc - p;
+        }
+        s.lo.d[i] = sext32(static_cast<uint32_t>(p));
+        s.hi.d[i] = sext32(static_cast<uint32_t>(p >> 32));
+        s.rd.d[i] = p;
+    }
+}
+
+// Produtos 16x16: LO recebe as meias palavras 0,1,4,5 e HI as 2,3,6,7
+void multiply_halfwords(MMIState& s, int accumulate) {
+    static const int lo_lanes[4] = { 0, 1, 4, 5 };
+    static const int hi_lanes[4] = { 2, 3, 6, 7 };
+    for (int k = 0; k < 4; k++) {
+        int32_t lo = static_cast<int32_t>(s.rs.sh[lo_lanes[k]]) * s.rt.sh[lo_lanes[k]];
+        int32_t hi = static_cast<int32_t>(s.rs.sh[hi_lanes[k]]) * s.rt.sh[hi_lanes[k]];
+        if (accumulate == 0) {
+            s.lo.w[k] = lo;
+            s.hi.w[k] = hi;
+        } else {
+            s.lo.w[k] += accumulate > 0 ? lo : -static_cast<uint32_t>(lo);
+            s.hi.w[k] += accumulate > 0 ? hi : -static_cast<uint32_t>(hi);
+        }
+    }
+    s.rd.w[0] = s.lo.w[0];
+    s.rd.w[1] = s.hi.w[0];
+    s.rd.w[2] = s.lo.w[2];
+    s.rd.w[3] = s.hi.w[2];
+}
+
+void horizontal_halfwords(MMIState& s, bool subtract) {
+    int32_t p[8];
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<int32_t>(s.rs.sh[i]) * s.rt.sh[i];
+    }
+    uint32_t q[4];
+    for (int k = 0; k < 4; k++) {
+        q[k] = subtract ? p[2 * k + 1] - p[2 * k] : p[2 * k + 1] + p[2 * k];
+        s.rd.w[k] = q[k];
+    }
+    s.lo.w[0] = q[0];
+    s.hi.w[0] = q[1];
+    s.lo.w[2] = q[2];
+    s.hi.w[2] = q[3];
+    s.lo.w[1] = subtract ? ~p[1] : p[1];
+    s.hi.w[1] = subtract ? ~p[3] : p[3];
+    s.lo.w[3] = subtract ? ~p[5] : p[5];
+    s.hi.w[3] = subtract ? ~p[7] : p[7];
+}
+
+// Referências curtas: a = rs, b = rt, `field` é o campo sa da codificação
+#define LANES(count, lane, ...) [](MMIState& s, uint32_t field) { \
+        const Quad &a = s.rs, &b = s.rt; (void)a; (void)b; (void)field; \
+        for (int i = 0; i < count; i++) s.rd.lane[i] = (__VA_ARGS__); }
+#define W4(...) LANES(4, w, __VA_ARGS__)
+#define H8(...) LANES(8, h, __VA_ARGS__)
+#define B16(...) LANES(16, b, __VA_ARGS__)
+#define QUAD(...) [](MMIState& s, uint32_t) { const Quad &a = s.rs, &b = s.rt; Quad r = b; (void)a; __VA_ARGS__; s.rd = r; }
+#define STATE(...) [](MMIState& s, uint32_t) { __VA_ARGS__; }
+
+std::vector<MMIOp> make_ops() {
+    std::vector<MMIOp> ops = {
+        // MMI0
+        { "PADDW", 0x08, 0x00, W4(a.w[i] + b.w[i]), true },
+        { "PSUBW", 0x08, 0x01, W4(a.w[i] - b.w[i]), true },
+        { "PCGTW", 0x08, 0x02, W4(a.sw[i] > b.sw[i] ? ~0u : 0u), true },
+        { "PMAXW", 0x08, 0x03, W4(std::max(a.sw[i], b.sw[i])), true },
+        { "PADDH", 0x08, 0x04, H8(a.h[i] + b.h[i]), true },
+        { "PSUBH", 0x08, 0x05, H8(a.h[i] - b.h[i]), true },
+        { "PCGTH", 0x08, 0x06, H8(a.sh[i] > b.sh[i] ? 0xFFFF : 0), true },
+        { "PMAXH", 0x08, 0x07, H8(std::max(a.sh[i], b.sh[i])), true },
+        { "PADDB", 0x08, 0x08, B16(a.b[i] + b.b[i]), true },
+        { "PSUBB", 0x08, 0x09, B16(a.b[i] - b.b[i]), true },
+        { "PCGTB", 0x08, 0x0A, B16(a.sb[i] > b.sb[i] ? 0xFF : 0), true },
+        { "PADDSW", 0x08, 0x10, W4(sat32(static_cast<int64_t>(a.sw[i]) + b.sw[i])), true },
+        { "PSUBSW", 0x08, 0x11, W4(sat32(static_cast<int64_t>(a.sw[i]) - b.sw[i])), true },
+        { "PEXTLW", 0x08, 0x12, QUAD(r.w[0] = b.w[0]; r.w[1] = a.w[0]; r.w[2] = b.w[1]; r.w[3] = a.w[1]), true },
+        { "PPACW", 0x08, 0x13, QUAD(r.w[0] = b.w[0]; r.w[1] = b.w[2]; r.w[2] = a.w[0]; r.w[3] = a.w[2]), true },
+        { "PADDSH", 0x08, 0x14, H8(sat16(a.sh[i] + b.sh[i])), true },
+        { "PSUBSH", 0x08, 0x15, H8(sat16(a.sh[i] - b.sh[i])), true },
+        { "PEXTLH", 0x08, 0x16, QUAD(for (int i = 0; i < 4; i++) { r.h[2 * i] = b.h[i]; r.h[2 * i + 1] = a.h[i]; }), true },
+        { "PPACH", 0x08, 0x17, QUAD(for (int i = 0; i < 4; i++) { r.h[i] = b.h[2 * i]; r.h[4 + i] = a.h[2 * i]; }), true },
+        { "PADDSB", 0x08, 0x18, B16(sat8(a.sb[i] + b.sb[i])), true },
+        { "PSUBSB", 0x08, 0x19, B16(sat8(a.sb[i] - b.sb[i])), true },
+        { "PEXTLB", 0x08, 0x1A, QUAD(for (int i = 0; i < 8; i++) { r.b[2 * i] = b.b[i]; r.b[2 * i + 1] = a.b[i]; }), true },
+        { "PPACB", 0x08, 0x1B, QUAD(for (int i = 0; i < 8; i++) { r.b[i] = b.b[2 * i]; r.b[8 + i] = a.b[2 * i]; }), true },
+        { "PEXT5", 0x08, 0x1E, W4(((b.w[i] & 0x1F) << 3) | ((b.w[i] & 0x3E0) << 6) | ((b.w[i] & 0x7C00) << 9) |
+                                 ((b.w[i] & 0x8000) << 16)), true },
+        { "PPAC5", 0x08, 0x1F, W4(((b.w[i] >> 3) & 0x1F) | ((b.w[i] >> 6) & 0x3E0) | ((b.w[i] >> 9) & 0x7C00) |
+                                 ((b.w[i] >> 16) & 0x8000)), true },
+        // MMI1
+        { "PABSW", 0x28, 0x01, W4(b.sw[i] == INT32_MIN ? 0x7FFFFFFFu : static_cast<uint32_t>(std::abs(b.sw[i]))), true },
+        { "PCEQW", 0x28, 0x02, W4(a.w[i] == b.w[i] ? ~0u : 0u), true },
+        { "PMINW", 0x28, 0x03, W4(std::min(a.sw[i], b.sw[i])), true },
+        { "PADSBH", 0x28, 0x04, H8(i < 4 ? a.h[i] - b.h[i] : a.h[i] + b.h[i]), true },
+        { "PABSH", 0x28, 0x05, H8(b.sh[i] == INT16_MIN ? 0x7FFF : std::abs(b.sh[i])), true },
+        { "PCEQH", 0x28, 0x06, H8(a.h[i] == b.h[i] ? 0xFFFF : 0), true },
+        { "PMINH", 0x28, 0x07, H8(std::min(a.sh[i], b.sh[i])), true },
+        { "PCEQB", 0x28, 0x0A, B16(a.b[i] == b.b[i] ? 0xFF : 0), true },
+        { "PADDUW", 0x28, 0x10, W4(static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(a.w[i]) + b.w[i],
+                                                                            0xFFFFFFFFu))), true },
+        { "PSUBUW", 0x28, 0x11, W4(a.w[i] > b.w[i] ? a.w[i] - b.w[i] : 0u), true },
+        { "PEXTUW", 0x28, 0x12, QUAD(r.w[0] = b.w[2]; r.w[1] = a.w[2]; r.w[2] = b.w[3]; r.w[3] = a.w[3]), true },
+        { "PADDUH", 0x28, 0x14, H8(std::min(a.h[i] + b.h[i], 0xFFFF)), true },
+        { "PSUBUH", 0x28, 0x15, H8(a.h[i] > b.h[i] ? a.h[i] - b.h[i] : 0), true },
+        { "PEXTUH", 0x28, 0x16, QUAD(for (int i = 0; i < 4; i++) { r.h[2 * i] = b.h[4 + i]; r.h[2 * i + 1] = a.h[4 + i]; }), true },
+        { "PADDUB", 0x28, 0x18, B16(std::min(a.b[i] + b.b[i], 0xFF)), true },
+        { "PSUBUB", 0x28, 0x19, B16(a.b[i] > b.b[i] ? a.b[i] - b.b[i] : 0), true },
+        { "PEXTUB", 0x28, 0x1A, QUAD(for (int i = 0; i < 8; i++) { r.b[2 * i] = b.b[8 + i]; r.b[2 * i + 1] = a.b[8 + i]; }), true },
+        { "QFSRV", 0x28, 0x1B, STATE(uint8_t bytes[32]; std::memcpy(bytes, s.rt.b, 16); std::memcpy(bytes + 16, s.rs.b, 16);
+                                     std::memcpy(s.rd.b, bytes + s.sa, 16)), true },
+        // MMI2
+        { "PMADDW", 0x09, 0x00, STATE(multiply_words(s, true, 1)), true },
+        { "PSLLVW", 0x09, 0x02, STATE(for (int i = 0; i < 2; i++) s.rd.d[i] = sext32(s.rt.w[2 * i] << (s.rs.w[2 * i] & 31))), true },
+        { "PSRLVW", 0x09, 0x03, STATE(for (int i = 0; i < 2; i++) s.rd.d[i] = sext32(s.rt.w[2 * i] >> (s.rs.w[2 * i] & 31))), true },
+        { "PMSUBW", 0x09, 0x04, STATE(multiply_words(s, true, -1)), true },
+        { "PMFHI", 0x09, 0x08, STATE(s.rd = s.hi), true },
+        { "PMFLO", 0x09, 0x09, STATE(s.rd = s.lo), true },
+        { "PINTH", 0x09, 0x0A, QUAD(for (int i = 0; i < 4; i++) { r.h[2 * i] = b.h[i]; r.h[2 * i + 1] = a.h[4 + i]; }), true },
+        { "PMULTW", 0x09, 0x0C, STATE(multiply_words(s, true, 0)), true },
+        { "PDIVW", 0x09, 0x0D, STATE(for (int i = 0; i < 2; i++) {
+                                         int32_t q, r;
+                                         div32(s.rs.sw[2 * i], s.rt.sw[2 * i], q, r);
+                                         s.lo.d[i] = sext32(q);
+                                         s.hi.d[i] = sext32(r);
+                                     }), false },
+        { "PCPYLD", 0x09, 0x0E, QUAD(r.d[0] = b.d[0]; r.d[1] = a.d[0]), true },
+        { "PMADDH", 0x09, 0x10, STATE(multiply_halfwords(s, 1)), true },
+        { "PHMADH", 0x09, 0x11, STATE(horizontal_halfwords(s, false)), true },
+        { "PAND", 0x09, 0x12, QUAD(r.d[0] = a.d[0] & b.d[0]; r.d[1] = a.d[1] & b.d[1]), true },
+        { "PXOR", 0x09, 0x13, QUAD(r.d[0] = a.d[0] ^ b.d[0]; r.d[1] = a.d[1] ^ b.d[1]), true },
+        { "PMSUBH", 0x09, 0x14, STATE(multiply_halfwords(s, -1)), true },
+        { "PHMSBH", 0x09, 0x15, STATE(horizontal_halfwords(s, true)), true },
+        { "PEXEH", 0x09, 0x1A, QUAD(r.h[0] = b.h[2]; r.h[2] = b.h[0]; r.h[4] = b.h[6]; r.h[6] = b.h[4]), true },
+        { "PREVH", 0x09, 0x1B, QUAD(for (int i = 0; i < 4; i++) { r.h[i] = b.h[3 - i]; r.h[4 + i] = b.h[7 - i]; }), true },
+        { "PMULTH", 0x09, 0x1C, STATE(multiply_halfwords(s, 0)), true },
+        { "PDIVBW", 0x09, 0x1D, STATE(for (int i = 0; i < 4; i++) {
+                                          int32_t q, r;
+                                          div32(s.rs.sw[i], s.rt.sh[0], q, r);
+                                          s.lo.w[i] = q;
+                                          s.hi.w[i] = r;
+                                      }), false },
+        { "PEXEW", 0x09, 0x1E, QUAD(r.w[0] = b.w[2]; r.w[2] = b.w[0]), true },
+        { "PROT3W", 0x09, 0x1F, QUAD(r.w[0] = b.w[1]; r.w[1] = b.w[2]; r.w[2] = b.w[0]), true },
+        // MMI3
+        { "PMADDUW", 0x29, 0x00, STATE(multiply_words(s, false, 1)), true },
+        { "PSRAVW", 0x29, 0x03, STATE(for (int i = 0; i < 2; i++) {
+                                          s.rd.d[i] = sext32(static_cast<uint32_t>(s.rt.sw[2 * i] >> (s.rs.w[2 * i] & 31)));
+                                      }), true },
+        { "PMTHI", 0x29, 0x08, STATE(s.hi = s.rs), false },
+        { "PMTLO", 0x29, 0x09, STATE(s.lo = s.rs), false },
+        { "PINTEH", 0x29, 0x0A, W4((b.w[i] & 0xFFFF) | (a.w[i] << 16)), true },
+        { "PMULTUW", 0x29, 0x0C, STATE(multiply_words(s, false, 0)), true },
+        { "PDIVUW", 0x29, 0x0D, STATE(for (int i = 0; i < 2; i++) {
+                                          uint32_t n = s.rs.w[2 * i], d = s.rt.w[2 * i];
+                                          s.lo.d[i] = sext32(d ? n / d : 0xFFFFFFFFu);
+                                          s.hi.d[i] = sext32(d ? n % d : n);
+                                      }), false },
+        { "PCPYUD", 0x29, 0x0E, QUAD(r.d[0] = a.d[1]; r.d[1] = b.d[1]), true },
+        { "POR", 0x29, 0x12, QUAD(r.d[0] = a.d[0] | b.d[0]; r.d[1] = a.d[1] | b.d[1]), true },
+        { "PNOR", 0x29, 0x13, QUAD(r.d[0] = ~(a.d[0] | b.d[0]); r.d[1] = ~(a.d[1] | b.d[1])), true },
+        { "PEXCH", 0x29, 0x1A, QUAD(r.h[1] = b.h[2]; r.h[2] = b.h[1]; r.h[5] = b.h[6]; r.h[6] = b.h[5]), true },
+        { "PCPYH", 0x29, 0x1B, QUAD(for (int i = 0; i < 4; i++) { r.h[i] = b.h[0]; r.h[4 + i] = b.h[4]; }), true },
+        { "PEXCW", 0x29, 0x1E, QUAD(r.w[1] = b.w[2]; r.w[2] = b.w[1]), true },
+        // Fora dos grupos: só as palavras baixas de rd são escritas
+        { "PLZCW", 0x04, 0x00, STATE(for (int i = 0; i < 2; i++) {
+                                         uint32_t v = s.rs.w[i];
+                                         uint32_t sign = v >> 31;
+                                         uint32_t count = 0;
+                                         for (int k = 30; k >= 0 && ((v >> k) & 1) == sign; k--) {
+                                             count++;
+                                         }
+                                         s.rd.w[i] = count;
+                                     }), true },
+        { "PMTHL", 0x31, 0x00, STATE(s.lo.w[0] = s.rs.w[0]; s.hi.w[0] = s.rs.w[1]; s.lo.w[2] = s.rs.w[2];
+                                     s.hi.w[2] = s.rs.w[3]), false },
+    };
+
+    // PMFHL: o campo escolhe o formato
+    Reference pmfhl = [](MMIState& s, uint32_t field) {
+        const Quad &L = s.lo, &H = s.hi;
+        Quad r;
+        switch (field) {
+            case 0:     // LW
+                r.w[0] = L.w[0]; r.w[1] = H.w[0]; r.w[2] = L.w[2]; r.w[3] = H.w[2];
+                break;
+            case 1:     // UW
+                r.w[0] = L.w[1]; r.w[1] = H.w[1]; r.w[2] = L.w[3]; r.w[3] = H.w[3];
+                break;
+            case 2:     // SLW
+                for (int i = 0; i < 2; i++) {
+                    r.sd[i] = sat32(static_cast<int64_t>((static_cast<uint64_t>(H.w[2 * i]) << 32) | L.w[2 * i]));
+                }
+                break;
+            case 3:     // LH
+                r.h[0] = L.h[0]; r.h[1] = L.h[2]; r.h[2] = H.h[0]; r.h[3] = H.h[2];
+                r.h[4] = L.h[4]; r.h[5] = L.h[6]; r.h[6] = H.h[4]; r.h[7] = H.h[6];
+                break;
+            default:    // SH
+                r.sh[0] = sat16(L.sw[0]); r.sh[1] = sat16(L.sw[1]); r.sh[2] = sat16(H.sw[0]); r.sh[3] = sat16(H.sw[1]);
+                r.sh[4] = sat16(L.sw[2]); r.sh[5] = sat16(L.sw[3]); r.sh[6] = sat16(H.sw[2]); r.sh[7] = sat16(H.sw[3]);
+                break;
+        }
+        s.rd = r;
+    };
+    for (uint32_t format = 0; format < 5; format++) {
+        ops.push_back({ "PMFHL", 0x30, format, pmfhl, true });
+    }
+
+    // Deslocamentos imediatos: todas as 32 quantidades codificáveis
+    for (uint32_t shift = 0; shift < 32; shift++) {
+        ops.push_back({ "PSLLH", 0x34, shift, H8(b.h[i] << (field & 15)), true });
+        ops.push_back({ "PSRLH", 0x36, shift, H8(b.h[i] >> (field & 15)), true });
+        ops.push_back({ "PSRAH", 0x37, shift, H8(b.sh[i] >> (field & 15)), true });
+        ops.push_back({ "PSLLW", 0x3C, shift, W4(b.w[i] << field), true });
+        ops.push_back({ "PSRLW", 0x3E, shift, W4(b.w[i] >> field), true });
+        ops.push_back({ "PSRAW", 0x3F, shift, W4(static_cast<uint32_t>(b.sw[i] >> field)), true });
+    }
+    return ops;
+}
+
+#undef LANES
+#undef W4
+#undef H8
+#undef B16
+#undef QUAD
+#undef STATE
+
+// Valores aleatórios, às vezes com todas as pistas tiradas de valores de borda
+void random_quad(Quad& q, std::mt19937_64& rng) {
+    static const uint16_t HALF_EDGES[] = { 0, 0x8000, 0x7FFF, 0xFFFF, 1 };
+    static const uint32_t WORD_EDGES[] = { 0, 0x80000000u, 0x7FFFFFFFu, 0xFFFFFFFFu, 1, 0xFFFF8000u };
+    static const uint8_t BYTE_EDGES[] = { 0, 0x80, 0x7F, 0xFF, 1 };
+    q.d[0] = rng();
+    q.d[1] = rng();
+    switch (rng() % 6) {
+        case 0:
+            for (uint16_t& h : q.h) h = HALF_EDGES[rng() % 5];
+            break;
+        case 1:
+            for (uint32_t& w : q.w) w = WORD_EDGES[rng() % 6];
+            break;
+        case 2:
+            for (uint8_t& b : q.b) b = BYTE_EDGES[rng() % 5];
+            break;
+        default:
+            break;
+    }
+}
+
+// Endereços do programa de teste e da área de dados (base em r20)
+constexpr uint32_t CODE_ADDRESS = 0x00100000;
+constexpr uint32_t DATA_ADDRESS = 0x00200000;
+constexpr uint32_t IN_OFFSET = 0x00;    // r1-r3, HI, LO
+constexpr uint32_t OUT_OFFSET = 0x80;   // r1-r3, HI, LO depois da instrução
+
+uint32_t r_type(uint32_t op, uint32_t rs, uint32_t rt, uint32_t rd, uint32_t sa, uint32_t funct) {
+    return (op << 26) | (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | funct;
+}
+
+uint32_t i_type(uint32_t op, uint32_t rs, uint32_t rt, uint32_t immediate) {
+    return (op << 26) | (rs << 21) | (rt << 16) | (immediate & 0xFFFF);
+}
+
+uint32_t mmi(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t field, uint32_t funct) {
+    return r_type(0x1C, rs, rt, rd, field, funct);
+}
+
+// Carrega o estado, executa `instruction` e guarda o resultado; HI/LO
+// passam por r8/r9 e SA por r10
+std::vector<uint32_t> build_program(uint32_t instruction, uint32_t sa) {
+    const uint32_t LQ = 0x1E, SQ = 0x1F, LUI = 0x0F, ADDIU = 0x09;
+    return {
+        i_type(LUI, 0, 20, DATA_ADDRESS >> 16),
+        i_type(LQ, 20, 8, IN_OFFSET + 0x30),
+        i_type(LQ, 20, 9, IN_OFFSET + 0x40),
+        mmi(8, 0, 0, 0x08, 0x29),               // PMTHI r8
+        mmi(9, 0, 0, 0x09, 0x29),               // PMTLO r9
+        i_type(ADDIU, 0, 10, sa),
+        r_type(0, 10, 0, 0, 0, 0x29),           // MTSA r10
+        i_type(LQ, 20, 1, IN_OFFSET + 0x00),
+        i_type(LQ, 20, 2, IN_OFFSET + 0x10),
+        i_type(LQ, 20, 3, IN_OFFSET + 0x20),
+        instruction,
+        mmi(0, 0, 8, 0x08, 0x09),               // PMFHI r8
+        mmi(0, 0, 9, 0x09, 0x09),               // PMFLO r9
+        i_type(SQ, 20, 1, OUT_OFFSET + 0x00),
+        i_type(SQ, 20, 2, OUT_OFFSET + 0x10),
+        i_type(SQ, 20, 3, OUT_OFFSET + 0x20),
+        i_type(SQ, 20, 8, OUT_OFFSET + 0x30),
+        i_type(SQ, 20, 9, OUT_OFFSET + 0x40),
+        i_type(0x04, 0, 0, 0xFFFF),             // BEQ r0, r0, -1: fica parado aqui
+        0,
+    };
+}
+
+void GSCX_CALL log_quiet(const char*) {}
+
+void GSCX_CALL log_error(const char* message) {
+    std::printf("erro: %s\n", message);
+}
+
+void print_quad(const char* label, const Quad& got, const Quad& expected) {
+    std::printf("    %-3s %016llx%016llx esperado %016llx%016llx\n", label,
+                static_cast<unsigned long long>(got.d[1]), static_cast<unsigned long long>(got.d[0]),
+                static_cast<unsigned long long>(expected.d[1]), static_cast<unsigned long long>(expected.d[0]));
+}
+
+// Retorna o número de casos que divergiram da referência
+int run_mode(EEExecutionMode mode, const char* mode_name, const std::vector<MMIOp>& ops, int cases) {
+    HostServicesC host = { log_quiet, log_quiet, log_error };
+    EmotionEngine ee(&host);
+    ee.initialize();
+    if (!ee.set_execution_mode(mode)) {
+        std::printf("%s: indisponível neste host, ignorado\n", mode_name);
+        return 0;
+    }
+
+    std::mt19937_64 rng(1);
+    int failures = 0;
+    size_t total = 0;
+    for (const MMIOp& op : ops) {
+        for (int n = 0; n < cases; n++) {
+            // r1-r3 com valores novos; rs/rt/rd sorteados entre eles (e r0)
+            Quad regs[4];
+            regs[0].d[0] = regs[0].d[1] = 0;
+            for (int i = 1; i < 4; i++) {
+                random_quad(regs[i], rng);
+            }
+            Quad hi, lo;
+            random_quad(hi, rng);
+            random_quad(lo, rng);
+            uint32_t sa = static_cast<uint32_t>(rng() % 16);
+            uint32_t rs = 1 + rng() % 3;
+            uint32_t rt = 1 + rng() % 3;
+            uint32_t rd = rng() % 8 == 0 ? 0 : 1 + rng() % 3;
+
+            MMIState state = { regs[rs], regs[rt], regs[rd], hi, lo, sa };
+            op.reference(state, op.field);
+            Quad expected[4] = { regs[0], regs[1], regs[2], regs[3] };
+            if (op.writes_rd && rd != 0) {
+                expected[rd] = state.rd;
+            }
+
+            for (int i = 1; i < 4; i++) {
+                ee.write_memory128(DATA_ADDRESS + IN_OFFSET + (i - 1) * 16, regs[i].d);
+            }
+            ee.write_memory128(DATA_ADDRESS + IN_OFFSET + 0x30, hi.d);
+            ee.write_memory128(DATA_ADDRESS + IN_OFFSET + 0x40, lo.d);
+            std::vector<uint32_t> program = build_program(mmi(rs, rt, rd, op.field, op.funct), sa);
+            for (size_t i = 0; i < program.size(); i++) {
+                ee.write_memory32(CODE_ADDRESS + static_cast<uint32_t>(i * 4), program[i]);
+            }
+            ee.set_pc(CODE_ADDRESS);
+            ee.start();
+            ee.execute(program.size() + 8);
+
+            Quad got[5];
+            for (int i = 0; i < 5; i++) {
+                ee.read_memory128(DATA_ADDRESS + OUT_OFFSET + i * 16, got[i].d);
+            }
+            bool ok = std::memcmp(&got[3], &state.hi, 16) == 0 && std::memcmp(&got[4], &state.lo, 16) == 0;
+            for (int i = 1; i < 4; i++) {
+                ok &= std::memcmp(&got[i - 1], &expected[i], 16) == 0;
+            }
+            total++;
+            if (!ok && failures++ < 20) {
+                std::printf("%s: %s campo=%u rs=r%u rt=r%u rd=r%u sa=%u\n", mode_name, op.name, op.field, rs, rt, rd, sa);
+                print_quad("r1", got[0], expected[1]);
+                print_quad("r2", got[1], expected[2]);
+                print_quad("r3", got[2], expected[3]);
+                print_quad("hi", got[3], state.hi);
+                print_quad("lo", got[4], state.lo);
+            }
+        }
+    }
+    std::printf("%s: %zu casos, %d divergências\n", mode_name, total, failures);
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int cases = argc > 1 ? std::max(1, std::atoi(argv[1])) : 256;
+    std::vector<MMIOp> ops = make_ops();
+    std::printf("%zu codificações, %d casos cada\n", ops.size(), cases);
+
+    int failures = run_mode(EEExecutionMode::INTERPRETER, "interpretador", ops, cases);
+    failures += run_mode(EEExecutionMode::RECOMPILER, "recompilador", ops, cases);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../src/modules/rsx/src/rsx_fragment_program.h"
+#include "../src/modules/rsx/src/rsx_surface_format.h"
+
+// Confere que o cache de fragment programs ignora as constantes inline:
+// o mesmo programa com a constante alterada no lugar (como os jogos fazem)
+// reaproveita a entrada já compilada, e a saída acompanha a constante nova,
+// tanto no interpretador quanto no JIT.
+
+using namespace GSCX::Modules::RSX;
+
+namespace {
+
+uint32_t bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// MOV R0, c[0] com END; o slot seguinte guarda a constante
+std::vector<uint32_t> mov_constant(float r, float g, float b, float a) {
+    const uint32_t swizzle_xyzw = (0u << 9) | (1u << 11) | (2u << 13) | (3u << 15);
+    const uint32_t d0 = 1u | (0xFu << 9) | (RSX_FP_OP_MOV << 24);
+    const uint32_t d1 = RSX_FP_REG_CONSTANT | swizzle_xyzw | (7u << 18) |
+                        (0u << 21) | (1u << 23) | (2u << 25) | (3u << 27);
+    return { d0, d1, 0, 0, bits(r), bits(g), bits(b), bits(a) };
+}
+
+// Executa o programa num lote de 8 pixels e devolve o primeiro pixel (A8R8G8B8)
+uint32_t shade(const RSXFragmentProgramCache& cache, const RSXFragmentProgram& program,
+               const std::vector<uint32_t>& words) {
+    uint8_t pixels[RSX_FP_BATCH_SIZE][4] = {};
+    RSXFragmentBatch batch;
+    for (uint32_t lane = 0; lane < RSX_FP_BATCH_SIZE; lane++) {
+        batch.color_targets[lane] = pixels[lane];
+    }
+    cache.execute(program, batch, words.data());
+    return (uint32_t(pixels[0][0]) << 24) | (uint32_t(pixels[0][1]) << 16) |
+           (uint32_t(pixels[0][2]) << 8) | pixels[0][3];
+}
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FALHA: %s\n", what);
+        failures++;
+    }
+}
+
+void run(bool jit) {
+    RSXFragmentProgramCache cache;
+    cache.set_jit_enabled(jit);
+    std::printf("%s: %s\n", jit ? "jit" : "interpretador", cache.is_jit_enabled() == jit ? "ativo" : "indisponível");
+    if (cache.is_jit_enabled() != jit) {
+        return;
+    }
+
+    const uint32_t formats[RSX_FP_MAX_TEXTURES] = {};
+    std::vector<uint32_t> red = mov_constant(1.0f, 0.0f, 0.0f, 1.0f);
+    std::vector<uint32_t> green = mov_constant(0.0f, 1.0f, 0.0f, 1.0f);
+
+    const RSXFragmentProgram* first = cache.get(red, formats, RSX_SURFACE_FORMAT_A8R8G8B8);
+    const RSXFragmentProgram* second = cache.get(green, formats, RSX_SURFACE_FORMAT_A8R8G8B8);
+    check(first && second, "programa não montado");
+    if (!first || !second) {
+        return;
+    }
+    check(first == second, "constante alterada gerou outro programa");
+    check(cache.size() == 1, "cache cresceu com a constante alterada");
+    check(cache.get_misses() == 1 && cache.get_hits() == 1, "contagem de acertos/faltas");
+    check(!jit || first->jit_entry, "programa não compilado pelo JIT");
+
+    // Big-endian: A, R, G, B
+    uint32_t out_red = shade(cache, *first, red);
+    uint32_t out_green = shade(cache, *second, green);
+    check(out_red == 0xFFFF0000u, "saída com a primeira constante");
+    check(out_green == 0xFF00FF00u, "saída com a constante alterada");
+    std::printf("  tamanho %zu, saídas %08X %08X\n", cache.size(), out_red, out_green);
+}
+
+} // namespace
+
+int main() {
+    run(false);
+    run(true);
+    std::printf("%s\n", failures ? "FALHOU" : "OK");
+    return failures ? 1 : 0;
+}